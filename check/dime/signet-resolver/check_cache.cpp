@@ -0,0 +1,431 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include "dime_check_params.h"
+#include "dime/signet-resolver/cache.h"
+}
+#include "gtest/gtest.h"
+
+/// The number of cached strings destroyed by the store, so the tests can tell exactly when an object was freed.
+static unsigned int check_cache_destroyed = 0;
+
+/// The callbacks which belonged to the store before the tests replaced them.
+static struct {
+    void (*destructor)(void *);
+    void * (*serialize)(void *, size_t *);
+    void * (*deserialize)(void *, size_t);
+    void (*dump)(FILE *, void *, int);
+    void * (*clone)(void *);
+} check_cache_saved;
+
+static void check_cache_destroy_cb(void *record) {
+
+    __sync_add_and_fetch(&check_cache_destroyed, 1);
+    free(record);
+}
+
+static void *check_cache_serialize_cb(void *record, size_t *outlen) {
+
+    *outlen = strlen((const char *)record);
+    return strndup((const char *)record, *outlen);
+}
+
+static void *check_cache_deserialize_cb(void *data, size_t len) {
+
+    return strndup((const char *)data, len);
+}
+
+static void check_cache_dump_cb(FILE *fp, void *record, int brief) {
+
+    (void)brief;
+    fprintf(fp, "%s\n", (const char *)record);
+}
+
+static void *check_cache_clone_cb(void *record) {
+
+    return strdup((const char *)record);
+}
+
+/// Point the DIME management record store at callbacks which hold plain strings, so the tests don't need real records.
+static cached_store_t *check_cache_store_open(void) {
+
+    cached_store_t *store = &(cached_stores[cached_data_drec]);
+
+    _lock_cache_store(store);
+    check_cache_saved.destructor = store->destructor;
+    check_cache_saved.serialize = store->serialize;
+    check_cache_saved.deserialize = store->deserialize;
+    check_cache_saved.dump = store->dump;
+    check_cache_saved.clone = store->clone;
+    store->destructor = &check_cache_destroy_cb;
+    store->serialize = &check_cache_serialize_cb;
+    store->deserialize = &check_cache_deserialize_cb;
+    store->dump = &check_cache_dump_cb;
+    store->clone = &check_cache_clone_cb;
+    _unlock_cache_store(store);
+
+    return store;
+}
+
+/// Drop every object from the store without journaling the removals, which is all a crash leaves behind.
+static void check_cache_store_clear(cached_store_t *store) {
+
+    _lock_cache_store(store);
+
+    while (store->head) {
+        _unlink_object(store->head, 1, 0);
+    }
+
+    _unlock_cache_store(store);
+}
+
+/// Empty the store, and give it back its original callbacks.
+static void check_cache_store_close(cached_store_t *store) {
+
+    check_cache_store_clear(store);
+    _lock_cache_store(store);
+
+    store->destructor = check_cache_saved.destructor;
+    store->serialize = check_cache_saved.serialize;
+    store->deserialize = check_cache_saved.deserialize;
+    store->dump = check_cache_saved.dump;
+    store->clone = check_cache_saved.clone;
+    _unlock_cache_store(store);
+}
+
+/// Move the cache file and its journal into the check output directory, and return the previous location.
+static char *check_cache_location_open(void) {
+
+    char cwd[PATH_MAX], path[PATH_MAX + 64], *previous, *jfile;
+
+    previous = _get_cache_location();
+
+    EXPECT_TRUE(getcwd(cwd, sizeof(cwd)) != NULL);
+    mkdir(DIME_CHECK_OUTPUT_PATH, S_IRWXU);
+    snprintf(path, sizeof(path), "%s/%scheck_cache.%d", cwd, DIME_CHECK_OUTPUT_PATH, getpid());
+    EXPECT_EQ(0, _set_cache_location(path));
+
+    unlink(path);
+
+    if ((jfile = _get_cache_journal_location())) {
+        unlink(jfile);
+        free(jfile);
+    }
+
+    return previous;
+}
+
+/// Remove the cache file and its journal, and go back to the previous location.
+static void check_cache_location_close(char *previous) {
+
+    char *cfile = _get_cache_location(), *jfile = _get_cache_journal_location();
+
+    if (previous) {
+        _set_cache_location(previous);
+        free(previous);
+    }
+
+    if (cfile) {
+        unlink(cfile);
+        free(cfile);
+    }
+
+    if (jfile) {
+        unlink(jfile);
+        free(jfile);
+    }
+}
+
+/// Return the size of the cache journal, or -1 if it doesn't exist.
+static off_t check_cache_journal_size(void) {
+
+    struct stat sb;
+    char *jfile;
+    off_t result = -1;
+
+    if ((jfile = _get_cache_journal_location())) {
+        result = stat(jfile, &sb) ? -1 : sb.st_size;
+        free(jfile);
+    }
+
+    return result;
+}
+
+/// Add a persistent string to the store, which also appends it to the journal.
+static bool check_cache_journal_add(cached_store_t *store, const char *id, const char *value) {
+
+    cached_object_t *added;
+
+    if (!(added = _add_cached_object(id, store, 0, 0, strdup(value), 1, 0))) {
+        return false;
+    }
+
+    _destroy_cache_entry(added);
+
+    return true;
+}
+
+TEST(DIME, cache_acquire_shared) {
+
+    cached_store_t *store = check_cache_store_open();
+    cached_object_t *added, *first, *second, *clone;
+    unsigned int destroyed;
+
+    ASSERT_TRUE((added = _add_cached_object("shared.cache.test", store, 0, 0, strdup("shared"), 0, 0)) != NULL);
+    _destroy_cache_entry(added);
+
+    // Every reader is handed the object held by the store, rather than a copy.
+    destroyed = check_cache_destroyed;
+    ASSERT_TRUE((first = _acquire_cached_object("shared.cache.test", store)) != NULL);
+    ASSERT_TRUE((second = _acquire_cached_object("shared.cache.test", store)) != NULL);
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->data, second->data);
+    EXPECT_EQ(3U, first->refs);
+    EXPECT_STREQ("shared", (const char *)first->data);
+
+    // A lookup through the public interface still returns a private copy.
+    ASSERT_TRUE((clone = _find_cached_object("shared.cache.test", store)) != NULL);
+    EXPECT_NE(first, clone);
+    EXPECT_NE(first->data, clone->data);
+    EXPECT_EQ(3U, first->refs);
+    _destroy_cache_entry(clone);
+    EXPECT_EQ(destroyed + 1, check_cache_destroyed);
+
+    // Releasing the readers leaves the object in the store.
+    _release_cached_object(second);
+    _release_cached_object(first);
+    EXPECT_EQ(1U, first->refs);
+    EXPECT_EQ(destroyed + 1, check_cache_destroyed);
+
+    check_cache_store_close(store);
+    EXPECT_EQ(destroyed + 2, check_cache_destroyed);
+}
+
+TEST(DIME, cache_evict_while_held) {
+
+    cached_store_t *store = check_cache_store_open();
+    cached_object_t *added, *held;
+    unsigned int destroyed;
+
+    ASSERT_TRUE((added = _add_cached_object("evicted.cache.test", store, 60, 0, strdup("evicted"), 0, 0)) != NULL);
+    _destroy_cache_entry(added);
+
+    destroyed = check_cache_destroyed;
+    ASSERT_TRUE((held = _acquire_cached_object("evicted.cache.test", store)) != NULL);
+
+    // Age the object past its ttl, so the sweep evicts it while the reader still holds it.
+    _lock_cache_store(store);
+    held->timestamp -= 120;
+    _unlock_cache_store(store);
+
+    EXPECT_EQ(1, _evict_stale_objects(store));
+    EXPECT_TRUE(_acquire_cached_object("evicted.cache.test", store) == NULL);
+    EXPECT_TRUE(store->head == NULL);
+
+    // The store has dropped its reference, but the object and its data must survive until the reader is done.
+    EXPECT_EQ(1U, held->refs);
+    EXPECT_EQ(destroyed, check_cache_destroyed);
+    EXPECT_STREQ("evicted", (const char *)held->data);
+
+    _release_cached_object(held);
+    EXPECT_EQ(destroyed + 1, check_cache_destroyed);
+
+    check_cache_store_close(store);
+}
+
+static void *check_cache_reader_run(void *arg) {
+
+    cached_object_t *object;
+    intptr_t failures = 0;
+
+    for (size_t i = 0; i < 10000; i++) {
+
+        if (!(object = _acquire_cached_object((const char *)arg, cached_stores + cached_data_drec)) ||
+            strcmp("concurrent", (const char *)object->data)) {
+            failures++;
+        }
+
+        _release_cached_object(object);
+    }
+
+    return (void *)failures;
+}
+
+TEST(DIME, cache_concurrent_readers) {
+
+    cached_store_t *store = check_cache_store_open();
+    cached_object_t *added, *object;
+    pthread_t threads[8];
+    unsigned int destroyed;
+    void *failures;
+
+    ASSERT_TRUE((added = _add_cached_object("concurrent.cache.test", store, 0, 0, strdup("concurrent"), 0, 0)) != NULL);
+    _destroy_cache_entry(added);
+
+    destroyed = check_cache_destroyed;
+
+    for (size_t i = 0; i < 8; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, &check_cache_reader_run, (void *)"concurrent.cache.test"));
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        pthread_join(threads[i], &failures);
+        EXPECT_EQ(0, (intptr_t)failures);
+    }
+
+    // Every reference taken by the readers was given back, and nothing was freed or copied along the way.
+    ASSERT_TRUE((object = _acquire_cached_object("concurrent.cache.test", store)) != NULL);
+    EXPECT_EQ(2U, object->refs);
+    _release_cached_object(object);
+    EXPECT_EQ(destroyed, check_cache_destroyed);
+
+    check_cache_store_close(store);
+}
+
+TEST(DIME, cache_journal_replay) {
+
+    cached_store_t *store = check_cache_store_open();
+    char *previous = check_cache_location_open();
+    cached_object_t *object;
+
+    ASSERT_TRUE(check_cache_journal_add(store, "journal.cache.test", "journaled"));
+    EXPECT_GT(check_cache_journal_size(), 0);
+
+    // The object was never written to a snapshot, so after a crash the journal is the only place it survives.
+    check_cache_store_clear(store);
+    EXPECT_TRUE(_acquire_cached_object("journal.cache.test", store) == NULL);
+
+    EXPECT_EQ(1, _replay_cache_journal());
+
+    ASSERT_TRUE((object = _acquire_cached_object("journal.cache.test", store)) != NULL);
+    EXPECT_STREQ("journaled", (const char *)object->data);
+    EXPECT_EQ(1, object->persists);
+    EXPECT_TRUE(object->snapshot == NULL);
+    _release_cached_object(object);
+
+    check_cache_location_close(previous);
+    check_cache_store_close(store);
+}
+
+TEST(DIME, cache_journal_removal) {
+
+    cached_store_t *store = check_cache_store_open();
+    char *previous = check_cache_location_open();
+    cached_object_t *object;
+
+    ASSERT_TRUE(check_cache_journal_add(store, "removed.cache.test", "removed"));
+    ASSERT_TRUE(check_cache_journal_add(store, "kept.cache.test", "kept"));
+
+    // Both objects end up in the snapshot, and only the removal is left in the journal.
+    EXPECT_EQ(0, _save_cache_contents());
+    EXPECT_EQ(0, check_cache_journal_size());
+
+    EXPECT_EQ(1, _remove_cached_object("removed.cache.test", store));
+    EXPECT_GT(check_cache_journal_size(), 0);
+
+    // Replaying the removal on top of the snapshot must not bring the object back.
+    check_cache_store_clear(store);
+    EXPECT_EQ(1, _load_cache_contents());
+
+    EXPECT_TRUE(_acquire_cached_object("removed.cache.test", store) == NULL);
+    ASSERT_TRUE((object = _acquire_cached_object("kept.cache.test", store)) != NULL);
+    EXPECT_STREQ("kept", (const char *)object->data);
+    _release_cached_object(object);
+
+    check_cache_location_close(previous);
+    check_cache_store_close(store);
+}
+
+TEST(DIME, cache_journal_torn) {
+
+    cached_store_t *store = check_cache_store_open();
+    char *previous = check_cache_location_open();
+    cached_object_t *object;
+    unsigned char torn[sizeof(uint32_t) + 16];
+    uint32_t rlen = CACHE_HEADER_SIZE + 64;
+    off_t good;
+    char *jfile;
+    int fd;
+
+    ASSERT_TRUE(check_cache_journal_add(store, "whole.cache.test", "whole"));
+    ASSERT_GT((good = check_cache_journal_size()), 0);
+
+    // Append a record which claims more data than was written, like an append interrupted by a crash.
+    memset(torn, 0xa5, sizeof(torn));
+    memcpy(torn, &rlen, sizeof(rlen));
+
+    ASSERT_TRUE((jfile = _get_cache_journal_location()) != NULL);
+    ASSERT_GE((fd = open(jfile, O_WRONLY | O_APPEND)), 0);
+    EXPECT_EQ((ssize_t)sizeof(torn), write(fd, torn, sizeof(torn)));
+    close(fd);
+    free(jfile);
+
+    EXPECT_EQ(good + (off_t)sizeof(torn), check_cache_journal_size());
+
+    // The whole record is replayed, and the torn one is cut off the end of the journal.
+    check_cache_store_clear(store);
+    EXPECT_EQ(1, _replay_cache_journal());
+    EXPECT_EQ(good, check_cache_journal_size());
+
+    ASSERT_TRUE((object = _acquire_cached_object("whole.cache.test", store)) != NULL);
+    EXPECT_STREQ("whole", (const char *)object->data);
+    _release_cached_object(object);
+
+    // Later records are appended after the last good one, so they replay as well.
+    ASSERT_TRUE(check_cache_journal_add(store, "after.cache.test", "after"));
+    check_cache_store_clear(store);
+    EXPECT_EQ(2, _replay_cache_journal());
+
+    ASSERT_TRUE((object = _acquire_cached_object("after.cache.test", store)) != NULL);
+    EXPECT_STREQ("after", (const char *)object->data);
+    _release_cached_object(object);
+
+    check_cache_location_close(previous);
+    check_cache_store_close(store);
+}
+
+TEST(DIME, cache_snapshot_lazy) {
+
+    cached_store_t *store = check_cache_store_open();
+    char *previous = check_cache_location_open();
+    cached_object_t *mapped, *object;
+    char *cfile;
+
+    ASSERT_TRUE(check_cache_journal_add(store, "snapshot.cache.test", "snapshot"));
+    EXPECT_EQ(0, _save_cache_contents());
+    EXPECT_EQ(0, check_cache_journal_size());
+
+    ASSERT_TRUE((cfile = _get_cache_location()) != NULL);
+    EXPECT_EQ(0, _sync_cache_directory(cfile));
+    free(cfile);
+
+    // Loading only links the object into the store, leaving its data in the snapshot mapping.
+    check_cache_store_clear(store);
+    EXPECT_EQ(1, _load_cache_contents());
+
+    _read_lock_cache_store(store);
+    mapped = store->head;
+    _unlock_cache_store(store);
+
+    ASSERT_TRUE(mapped != NULL);
+    EXPECT_TRUE(mapped->next == NULL);
+    EXPECT_TRUE(mapped->snapshot != NULL);
+    EXPECT_TRUE(mapped->data == NULL);
+    EXPECT_EQ(1U, store->pending);
+
+    // The first reader deserializes it in place.
+    ASSERT_TRUE((object = _acquire_cached_object("snapshot.cache.test", store)) != NULL);
+    EXPECT_EQ(mapped, object);
+    EXPECT_TRUE(object->snapshot == NULL);
+    EXPECT_TRUE(object->image == NULL);
+    EXPECT_STREQ("snapshot", (const char *)object->data);
+    EXPECT_EQ(0U, store->pending);
+    EXPECT_EQ(2U, object->refs);
+    _release_cached_object(object);
+
+    check_cache_location_close(previous);
+    check_cache_store_close(store);
+}
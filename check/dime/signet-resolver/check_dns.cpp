@@ -0,0 +1,329 @@
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include "dime_check_params.h"
+#include "dime/signet-resolver/dns.h"
+#include "dime/signet-resolver/cache.h"
+}
+#include "gtest/gtest.h"
+
+/// An answer served by the stub server. Each record's owner is a pointer back to the name in the question.
+typedef struct {
+    const char *name;
+    int type;
+    const unsigned char *answer;
+    size_t len;
+    unsigned char count;
+} stub_rrset_t;
+
+/// A stub authoritative server on the loopback interface, which answers TXT queries and counts every query it receives.
+typedef struct {
+    int fd;
+    int stop;
+    unsigned int delay;
+    unsigned int queries;
+    const stub_rrset_t *zone;
+    pthread_t thread;
+    struct sockaddr_in addr;
+} stub_server_t;
+
+/// The root key which anchors the signed zone, in the format of the resolver's root key file.
+static const char *stub_zone_anchor = ". initial-key 257 3 8 \"AwEAAdvNKUJnHesxpk9SZcSmBQd6JQs/eycthg/WK1wiujWyCTPSWndraJZtTW6Zavf1OSxJGIHx/u2hP7SKJR/ENEcHAUipLL7ZRRWbio+xzuKLBZLDfSuSjLlwnLIvzciltiSJwjr7jWprVWvTfyH8UbuRfDqIZbCnrdcg9cDnZwJd\";\n";
+
+/// The "stubtest" zone, signed offline with signatures valid until 2100: a TXT record and the zone key, both signed by the zone key,
+/// and the zone's DS record, signed by the root key above.
+static const unsigned char stub_zone_txt[] = {
+    0xc0, 0x0c, 0x00, 0x10, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x07, 0x06, 0x73, 0x69, 0x67,
+    0x6e, 0x65, 0x64, 0xc0, 0x0c, 0x00, 0x2e, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x9c, 0x00,
+    0x10, 0x08, 0x02, 0x00, 0x00, 0x00, 0x3c, 0xf4, 0x86, 0x57, 0x00, 0x5e, 0x0b, 0xe1, 0x00, 0x06,
+    0xd1, 0x08, 0x73, 0x74, 0x75, 0x62, 0x74, 0x65, 0x73, 0x74, 0x00, 0xaa, 0x60, 0xea, 0xe3, 0x37,
+    0xfe, 0x5b, 0xb7, 0x4b, 0x97, 0x64, 0xd5, 0x21, 0x9f, 0x9b, 0x85, 0xbf, 0x83, 0xd3, 0xfd, 0x06,
+    0x6b, 0xc7, 0xad, 0xfc, 0x6a, 0xeb, 0xa2, 0x6c, 0x3e, 0x9c, 0x4f, 0x78, 0xc7, 0xdd, 0xe0, 0x55,
+    0xf8, 0xf3, 0x12, 0x48, 0xeb, 0x48, 0x2e, 0x96, 0x34, 0x11, 0x7d, 0xd1, 0xcf, 0x8a, 0x60, 0x17,
+    0x3a, 0xfe, 0x69, 0x1d, 0x51, 0xb8, 0x19, 0x1a, 0x1b, 0xac, 0x50, 0xa3, 0x76, 0x46, 0x00, 0x19,
+    0x81, 0x95, 0x47, 0x03, 0x4d, 0x3d, 0x5e, 0x38, 0x59, 0x18, 0xb9, 0xf2, 0x18, 0x3e, 0x99, 0x8e,
+    0xf2, 0x85, 0x86, 0x6d, 0x24, 0x13, 0xbc, 0x0f, 0x3c, 0xb4, 0x3e, 0x37, 0xd5, 0xce, 0x75, 0x4d,
+    0x82, 0xe0, 0xb1, 0x53, 0x36, 0x34, 0x0b, 0x70, 0xdd, 0x99, 0x2a, 0x47, 0xba, 0xaa, 0x55, 0xe4,
+    0x9a, 0x7f, 0x11, 0x37, 0xb6, 0xb7, 0x07, 0x59, 0x57, 0xd0, 0x6b
+};
+
+static const unsigned char stub_zone_dnskey[] = {
+    0xc0, 0x0c, 0x00, 0x30, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x88, 0x01, 0x01, 0x03, 0x08,
+    0x03, 0x01, 0x00, 0x01, 0xdc, 0x8c, 0x46, 0x3f, 0xe7, 0x5e, 0x2d, 0x01, 0x7c, 0x4a, 0x05, 0x8b,
+    0x4d, 0x0c, 0x4e, 0x78, 0xa7, 0x7d, 0x07, 0x23, 0xc3, 0x84, 0x38, 0xaf, 0xd1, 0x8b, 0x29, 0x9c,
+    0xaa, 0x33, 0x5c, 0x09, 0x3b, 0xba, 0x8e, 0xe0, 0xc0, 0x62, 0xf4, 0xf8, 0x87, 0x98, 0x2b, 0x2a,
+    0x46, 0x56, 0x9b, 0xde, 0xe4, 0x16, 0x1a, 0x84, 0xc8, 0xe1, 0x02, 0x4e, 0x12, 0xb9, 0x58, 0x35,
+    0xf1, 0x02, 0xfe, 0x2f, 0x4b, 0x6e, 0xb9, 0xb1, 0x84, 0x8a, 0x57, 0xf4, 0xd3, 0x85, 0xec, 0x61,
+    0xd3, 0x3f, 0x95, 0xa8, 0x4d, 0x53, 0x61, 0xe4, 0x42, 0xe7, 0xb0, 0x7a, 0xf7, 0x48, 0x72, 0xb1,
+    0xab, 0x59, 0x38, 0x66, 0xc3, 0xd4, 0xec, 0x75, 0xb3, 0x8f, 0xae, 0xb8, 0x25, 0xfc, 0xfa, 0xbc,
+    0x35, 0x31, 0xb8, 0xf5, 0xf8, 0x65, 0x30, 0x8c, 0xc4, 0xcf, 0x46, 0xe1, 0x39, 0x45, 0x23, 0x4a,
+    0x77, 0xa7, 0xa1, 0x1b, 0xc0, 0x0c, 0x00, 0x2e, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x9c,
+    0x00, 0x30, 0x08, 0x01, 0x00, 0x00, 0x00, 0x3c, 0xf4, 0x86, 0x57, 0x00, 0x5e, 0x0b, 0xe1, 0x00,
+    0x06, 0xd1, 0x08, 0x73, 0x74, 0x75, 0x62, 0x74, 0x65, 0x73, 0x74, 0x00, 0x29, 0x3e, 0x53, 0x2f,
+    0x86, 0x52, 0xa9, 0x4a, 0xda, 0xc4, 0x3a, 0xa4, 0x33, 0xad, 0x3c, 0x3f, 0x4b, 0x9e, 0x96, 0x96,
+    0x53, 0xf8, 0x68, 0x80, 0xd2, 0x62, 0x40, 0xb2, 0x35, 0x4c, 0xe2, 0x5c, 0x79, 0x9c, 0x9a, 0xd9,
+    0x4e, 0x61, 0x1f, 0xea, 0x26, 0x66, 0x01, 0x6b, 0xb1, 0xc5, 0x8a, 0xe5, 0x66, 0xf7, 0x78, 0x41,
+    0xf7, 0xa4, 0xec, 0x4a, 0x5c, 0x02, 0xea, 0xd5, 0x92, 0xd2, 0x06, 0x5d, 0x6e, 0xe9, 0xcc, 0x1d,
+    0x11, 0xe2, 0x35, 0xb3, 0xc6, 0x37, 0x19, 0x73, 0xf6, 0x91, 0xb6, 0x17, 0x8e, 0xf3, 0xb7, 0x10,
+    0xa8, 0x39, 0xe7, 0xad, 0x31, 0x6d, 0x00, 0x92, 0x2f, 0x78, 0x63, 0x96, 0x72, 0xa6, 0x4b, 0x35,
+    0x0c, 0x40, 0x49, 0x7e, 0x7d, 0x32, 0x04, 0x1e, 0x22, 0x9a, 0x70, 0x10, 0x5e, 0x66, 0xc1, 0x2e,
+    0x15, 0xbe, 0x89, 0x76, 0x2c, 0x79, 0x6d, 0x80, 0x48, 0xd2, 0x83, 0x9c
+};
+
+static const unsigned char stub_zone_ds[] = {
+    0xc0, 0x0c, 0x00, 0x2b, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x24, 0x06, 0xd1, 0x08, 0x02,
+    0x27, 0x72, 0xda, 0x80, 0xc7, 0x5e, 0x22, 0xd6, 0x05, 0x02, 0x36, 0x4a, 0x1a, 0x79, 0x00, 0xd9,
+    0x88, 0x5e, 0x27, 0xfc, 0x7b, 0x78, 0x90, 0x91, 0x62, 0xbf, 0xd7, 0xb6, 0x68, 0x3d, 0x45, 0x92,
+    0xc0, 0x0c, 0x00, 0x2e, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x93, 0x00, 0x2b, 0x08, 0x01,
+    0x00, 0x00, 0x00, 0x3c, 0xf4, 0x86, 0x57, 0x00, 0x5e, 0x0b, 0xe1, 0x00, 0x37, 0xba, 0x00, 0x0e,
+    0x88, 0x1e, 0x27, 0x79, 0x43, 0xc4, 0x72, 0xb8, 0xfd, 0x1e, 0x2d, 0x53, 0xfd, 0x95, 0x3f, 0xbe,
+    0xa1, 0x22, 0xd5, 0x62, 0x46, 0xa9, 0x03, 0xa7, 0xbb, 0xec, 0xdf, 0xce, 0x75, 0x03, 0x27, 0x78,
+    0xc8, 0x14, 0x09, 0x41, 0x78, 0x65, 0x16, 0x61, 0xb0, 0xec, 0xc1, 0xfd, 0x8b, 0xf1, 0xca, 0x7d,
+    0x9f, 0x82, 0xf5, 0x7e, 0x5d, 0xd5, 0xd6, 0x9a, 0x2a, 0xd9, 0x94, 0x83, 0x93, 0x6c, 0xf9, 0xbe,
+    0xf8, 0x89, 0x0e, 0xd0, 0x55, 0x53, 0x36, 0x06, 0xb1, 0x9d, 0x05, 0xeb, 0x6c, 0x85, 0x6a, 0xa1,
+    0xca, 0x8d, 0x18, 0x1c, 0xda, 0xaf, 0x75, 0xdf, 0xc1, 0xe6, 0x25, 0x96, 0x9a, 0xf8, 0x2d, 0xba,
+    0x8c, 0x7a, 0xf1, 0xb8, 0xe0, 0xab, 0x88, 0x54, 0xcd, 0x19, 0xcd, 0x88, 0x81, 0xca, 0x87, 0x88,
+    0x92, 0xdf, 0xf4, 0xbf, 0x5e, 0x8b, 0xa4, 0x5d, 0x9d, 0xc3, 0xd5, 0x1a, 0x4e, 0x20, 0x7e
+};
+
+static const stub_rrset_t stub_zone[] = {
+    { "signet.stubtest", ns_t_txt, stub_zone_txt, sizeof(stub_zone_txt), 2 },
+    { "forged.stubtest", ns_t_txt, stub_zone_txt, sizeof(stub_zone_txt), 2 },
+    { "stubtest", T_DNSKEY, stub_zone_dnskey, sizeof(stub_zone_dnskey), 2 },
+    { "stubtest", T_DS, stub_zone_ds, sizeof(stub_zone_ds), 2 },
+    { NULL, 0, NULL, 0, 0 }
+};
+
+static void *stub_server_run(void *arg) {
+
+    stub_server_t *server = (stub_server_t *)arg;
+    static const unsigned char txt[] = { 0xc0, 0x0c, 0x00, 0x10, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x06, 0x05, 'h', 'e', 'l', 'l', 'o' };
+    unsigned char query[512], reply[1024];
+    const stub_rrset_t *rrset;
+    char name[MAXDNAME];
+    struct sockaddr_in from;
+    socklen_t fromlen;
+    ssize_t nread;
+    size_t qlen, rlen;
+    int type;
+
+    while (!__sync_add_and_fetch(&(server->stop), 0)) {
+        fromlen = sizeof(from);
+
+        if ((nread = recvfrom(server->fd, query, sizeof(query), 0, (struct sockaddr *)&from, &fromlen)) < 12) {
+            continue;
+        }
+
+        __sync_add_and_fetch(&(server->queries), 1);
+
+        // Echo the question back, followed by a single TXT answer. Every other record type gets an empty answer.
+        for (qlen = 12; qlen < (size_t)nread && query[qlen]; qlen += query[qlen] + 1);
+
+        if ((qlen += 5) > (size_t)nread || dn_expand(query, query + nread, query + 12, name, sizeof(name)) < 0) {
+            continue;
+        }
+
+        memcpy(reply, query, qlen);
+        reply[2] = 0x84;
+        reply[3] = 0x00;
+        memset(reply + 6, 0, 6);
+        rlen = qlen;
+        type = (query[qlen - 4] << 8) | query[qlen - 3];
+
+        // Names under servfail and nxdomain get the matching error, and a zone, if there is one, replaces the default answer.
+        for (rrset = server->zone; rrset && rrset->name && (rrset->type != type || strcasecmp(rrset->name, name)); rrset++);
+
+        if (!strncasecmp(name, "servfail.", 9)) {
+            reply[3] = ns_r_servfail;
+        } else if (!strncasecmp(name, "nxdomain.", 9)) {
+            reply[3] = ns_r_nxdomain;
+        } else if (rrset && rrset->name) {
+            memcpy(reply + rlen, rrset->answer, rrset->len);
+            rlen += rrset->len;
+            reply[7] = rrset->count;
+        } else if (!server->zone && type == ns_t_txt) {
+            memcpy(reply + rlen, txt, sizeof(txt));
+            rlen += sizeof(txt);
+            reply[7] = 1;
+        }
+
+        usleep(server->delay * 1000);
+        sendto(server->fd, reply, rlen, 0, (struct sockaddr *)&from, fromlen);
+    }
+
+    return NULL;
+}
+
+static void stub_server_start(stub_server_t *server, unsigned int delay, const stub_rrset_t *zone = NULL) {
+
+    struct timeval timeout = { 0, 100000 };
+    socklen_t addrlen = sizeof(server->addr);
+
+    memset(server, 0, sizeof(stub_server_t));
+    server->delay = delay;
+    server->zone = zone;
+    server->addr.sin_family = AF_INET;
+    server->addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    ASSERT_LE(0, (server->fd = socket(AF_INET, SOCK_DGRAM, 0)));
+    ASSERT_EQ(0, bind(server->fd, (struct sockaddr *)&(server->addr), addrlen));
+    ASSERT_EQ(0, getsockname(server->fd, (struct sockaddr *)&(server->addr), &addrlen));
+    ASSERT_EQ(0, setsockopt(server->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    ASSERT_EQ(0, pthread_create(&(server->thread), NULL, &stub_server_run, server));
+
+    _set_resolver_nameserver(&(server->addr));
+}
+
+static void stub_server_stop(stub_server_t *server) {
+
+    __sync_add_and_fetch(&(server->stop), 1);
+    pthread_join(server->thread, NULL);
+    close(server->fd);
+
+    _set_resolver_nameserver(NULL);
+}
+
+static void *shared_query_run(void *arg) {
+
+    unsigned char answer[DNS_ANSWER_SIZE];
+
+    return (void *)(intptr_t)_dns_query((const char *)arg, ns_t_txt, answer, sizeof(answer));
+}
+
+TEST(DIME, dns_query_shared) {
+
+    stub_server_t server;
+    pthread_t threads[8];
+    void *result;
+
+    stub_server_start(&server, 200);
+
+    // Every thread asks the same question while the first query is still waiting on the server.
+    for (size_t i = 0; i < 8; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, &shared_query_run, (void *)"shared.stub.test"));
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        pthread_join(threads[i], &result);
+        EXPECT_LT(0, (intptr_t)result);
+    }
+
+    EXPECT_EQ(1U, server.queries);
+
+    stub_server_stop(&server);
+}
+
+TEST(DIME, dns_prefetch_chain) {
+
+    const char *names[] = { "_dime.prefetch.stub.test", "prefetch.stub.test", "stub.test", "test" };
+    unsigned char answer[DNS_ANSWER_SIZE];
+    stub_server_t server;
+
+    stub_server_start(&server, 0);
+
+    // The TXT record, plus the DNSKEY and DS records of each of the three zones above it. The _dime label isn't a zone.
+    ASSERT_EQ(7, _prefetch_dns_chain(names[0], ns_t_txt));
+    ASSERT_EQ(0, _prefetch_dns_chain(names[0], ns_t_txt));
+
+    EXPECT_LT(0, _dns_query(names[0], ns_t_txt, answer, sizeof(answer)));
+
+    // The chain queries get empty answers, but they must all be answered from the prefetch.
+    for (size_t i = 1; i < sizeof(names) / sizeof(names[0]); i++) {
+        EXPECT_GT(0, _dns_query(names[i], T_DNSKEY, answer, sizeof(answer)));
+        EXPECT_GT(0, _dns_query(names[i], T_DS, answer, sizeof(answer)));
+        EXPECT_EQ(NO_DATA, h_errno);
+    }
+
+    EXPECT_EQ(7U, server.queries);
+
+    stub_server_stop(&server);
+}
+
+TEST(DIME, dns_query_failures) {
+
+    unsigned char answer[DNS_ANSWER_SIZE];
+    stub_server_t server;
+    unsigned int sent;
+
+    stub_server_start(&server, 0);
+
+    // An authoritative denial is held, so asking again doesn't reach the server.
+    EXPECT_GT(0, _dns_query("nxdomain.stub.test", ns_t_txt, answer, sizeof(answer)));
+    EXPECT_EQ(HOST_NOT_FOUND, h_errno);
+    sent = server.queries;
+    EXPECT_GT(0, _dns_query("nxdomain.stub.test", ns_t_txt, answer, sizeof(answer)));
+    EXPECT_EQ(sent, server.queries);
+
+    // But a server failure is dropped once it's been reported, so the next attempt sends a fresh query.
+    EXPECT_GT(0, _dns_query("servfail.stub.test", ns_t_txt, answer, sizeof(answer)));
+    EXPECT_EQ(TRY_AGAIN, h_errno);
+    sent = server.queries;
+    EXPECT_GT(0, _dns_query("servfail.stub.test", ns_t_txt, answer, sizeof(answer)));
+    EXPECT_LT(sent, server.queries);
+
+    stub_server_stop(&server);
+}
+
+/// Query a TXT record from the stub zone, and validate its signature the same way _get_txt_record() does.
+static int stub_zone_validate(const char *label, int *validated) {
+
+    ns_msg handle;
+    ns_rr rr;
+    cached_object_t *signing_key;
+    unsigned char answer[DNS_ANSWER_SIZE];
+    int nread, result = -1;
+
+    *validated = 0;
+
+    if ((nread = _dns_query(label, ns_t_txt, answer, sizeof(answer))) < 0 || ns_initparse(answer, nread, &handle) < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < ns_msg_count(handle, ns_s_an); i++) {
+
+        if (ns_parserr(&handle, ns_s_an, i, &rr) < 0 || ns_rr_type(rr) != T_RRSIG) {
+            continue;
+        }
+
+        signing_key = NULL;
+
+        if ((result = _validate_rrsig_rr(ns_rr_name(rr), &handle, ns_t_txt, ns_rr_rdata(rr), ns_rr_rdlen(rr), &signing_key)) > 0) {
+            *validated = _is_validated_key((dnskey_t *)_get_cache_obj_data(signing_key));
+        }
+
+        _release_cached_object(signing_key);
+    }
+
+    _clear_error_stack();
+
+    return result;
+}
+
+TEST(DIME, dns_signed_chain) {
+
+    const char *path = DIME_CHECK_OUTPUT_PATH "root-anchor.key";
+    stub_server_t server;
+    int validated;
+    FILE *fp;
+
+    // Install the zone's root key as the trust anchor, just as the resolver would load the real one.
+    mkdir(DIME_CHECK_OUTPUT_PATH, S_IRWXU);
+    ASSERT_TRUE((fp = fopen(path, "w")) != NULL);
+    ASSERT_LT(0, fputs(stub_zone_anchor, fp));
+    ASSERT_EQ(0, fclose(fp));
+    ASSERT_EQ(0, _load_dnskey_file(path));
+    unlink(path);
+
+    stub_server_start(&server, 0, stub_zone);
+
+    // The TXT signature is checked against the zone key, which is signed by itself and linked by a DS record signed by the root.
+    EXPECT_EQ(1, stub_zone_validate("signet.stubtest", &validated));
+    EXPECT_EQ(1, validated);
+
+    // The same signature over a record with a different owner must not verify.
+    EXPECT_EQ(0, stub_zone_validate("forged.stubtest", &validated));
+    EXPECT_EQ(0, validated);
+
+    stub_server_stop(&server);
+}
@@ -955,6 +955,158 @@ START_TEST (check_secmem) {
 }
 END_TEST
 
+START_TEST (check_secmem_classes_s) {
+
+	log_disable();
+	uchr_t *blocks[256];
+	stringer_t *errmsg = NULL;
+	size_t total, bytes, items, available, largest, slots, reserved;
+
+	mm_wipe(blocks, sizeof(blocks));
+
+	if (status() && mm_sec_usage(&available, &largest, &slots, &reserved)) {
+
+		// Fill blocks of every small size, so neighbouring slots would be corrupted if the classes overlapped.
+		for (size_t i = 0; i < 256 && !errmsg; i++) {
+			if (!(blocks[i] = mm_sec_alloc((i * 4) + 1)) || !mm_sec_secured(blocks[i])) {
+				errmsg = NULLER("Secure size class allocation failed.");
+			}
+			else {
+				mm_set(blocks[i], i, (i * 4) + 1);
+			}
+		}
+
+		for (size_t i = 0; i < 256 && !errmsg; i++) {
+			for (size_t j = 0; j < (i * 4) + 1 && !errmsg; j++) {
+				if (blocks[i][j] != (uchr_t)i) errmsg = NULLER("Secure size class allocations overlap.");
+			}
+		}
+
+		// Growing a block must move it into a larger class without losing the contents.
+		if (!errmsg && (!(blocks[100] = mm_sec_realloc(blocks[100], 4096)) || blocks[100][400] != 100)) {
+			errmsg = NULLER("Secure size class reallocation failed.");
+		}
+
+		for (size_t i = 0; i < 256; i++) {
+			mm_sec_cleanup(blocks[i]);
+		}
+
+		if (!errmsg && (!mm_sec_stats(&total, &bytes, &items) || !mm_sec_usage(&available, &largest, &slots, &reserved) ||
+			reserved > slots || largest > available)) {
+			errmsg = NULLER("Secure memory usage statistics are inconsistent.");
+		}
+	}
+
+	log_test("CORE / MEMORY / SECURE SIZE CLASSES / SINGLE THREADED:", errmsg);
+	ck_assert_msg(!errmsg, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_arena_s) {
+
+	log_disable();
+	mm_arena_t *arena;
+	stringer_t *errmsg = NULL, *strings[64], *copy = NULL;
+
+	mm_wipe(strings, sizeof(strings));
+
+	if (status() && !(arena = mm_arena_create(0))) {
+		errmsg = NULLER("Arena creation failed.");
+	}
+	else if (status()) {
+
+		mm_arena_attach(arena);
+
+		// Allocate enough strings to overflow the first block, and make sure the buffers don't overlap.
+		for (size_t i = 0; i < 64 && !errmsg; i++) {
+			if (!(strings[i] = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "%zu.%0*zu", i, (int)i, i)) ||
+				!(st_opt_get(strings[i]) & ARENA)) {
+				errmsg = NULLER("Arena string allocation failed.");
+			}
+		}
+
+		for (size_t i = 0; i < 64 && !errmsg; i++) {
+			if (st_length_get(strings[i]) != ns_length_get(st_char_get(strings[i])) ||
+				(size_t)strtoul(st_char_get(strings[i]), NULL, 10) != i) {
+				errmsg = NULLER("Arena string allocations overlap.");
+			}
+		}
+
+		if (!errmsg && (arena->counts.allocations != 64 || arena->counts.blocks < 2 || arena->counts.heap)) {
+			errmsg = NULLER("Arena allocation counters are inconsistent.");
+		}
+
+		// Duplicates of arena strings should be allocated off the heap, so they outlive the arena.
+		if (!errmsg && (!(copy = st_dupe(strings[10])) || (st_opt_get(copy) & ARENA) || !(st_opt_get(copy) & HEAP) ||
+			st_cmp_cs_eq(copy, strings[10]) || arena->counts.heap != 1)) {
+			errmsg = NULLER("Arena string duplication failed.");
+		}
+
+		for (size_t i = 0; i < 64; i++) {
+			st_cleanup(strings[i]);
+		}
+
+		mm_arena_reset(arena);
+
+		if (!errmsg && (arena->counts.allocations || !arena->blocks || arena->blocks->next || arena->blocks->used)) {
+			errmsg = NULLER("Arena reset failed.");
+		}
+
+		// Without an attached arena, the allocation should fall back to the heap.
+		if (!errmsg && mm_arena_attach(NULL) != arena) {
+			errmsg = NULLER("Arena attachment failed.");
+		}
+		else if (!errmsg && (!(strings[0] = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "%s", "heap")) ||
+			(st_opt_get(strings[0]) & ARENA) || arena->counts.allocations)) {
+			errmsg = NULLER("Arena fallback allocation failed.");
+		}
+
+		st_cleanup(strings[0], copy);
+		mm_arena_attach(NULL);
+		mm_arena_destroy(arena);
+	}
+
+	log_test("CORE / MEMORY / ARENA / SINGLE THREADED:", errmsg);
+	ck_assert_msg(!errmsg, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_pool_s) {
+
+	log_disable();
+	stringer_t *errmsg = NULL;
+
+	if (status() && !check_pool_sthread()) errmsg = NULLER("The single-threaded object pool test failed.");
+
+	log_test("CORE / BUCKETS / POOL / SINGLE THREADED:", errmsg);
+	ck_assert_msg(!errmsg, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_pool_m) {
+
+	log_disable();
+	stringer_t *errmsg = NULL;
+
+	if (status() && !check_pool_mthread()) errmsg = NULLER("The multi-threaded object pool test failed.");
+
+	log_test("CORE / BUCKETS / POOL / MULTI THREADED:", errmsg);
+	ck_assert_msg(!errmsg, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_slotted_s) {
+
+	log_disable();
+	stringer_t *errmsg = NULL;
+
+	if (status() && !check_slotted_sthread()) errmsg = NULLER("The single-threaded fixed slot table test failed.");
+
+	log_test("CORE / BUCKETS / SLOTTED / SINGLE THREADED:", errmsg);
+	ck_assert_msg(!errmsg, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_signames_s) {
 
 	log_disable();
@@ -1091,6 +1243,12 @@ Suite * suite_check_core(void) {
 
 	suite_check_testcase(s, "CORE", "Memory / Checksum", check_checksum);
 	suite_check_testcase(s, "CORE", "Memory / Secure Address Range", check_secmem);
+	suite_check_testcase(s, "CORE", "Memory / Secure Size Classes / S", check_secmem_classes_s);
+	suite_check_testcase(s, "CORE", "Memory / Arena / S", check_arena_s);
+
+	suite_check_testcase(s, "CORE", "Buckets / Pool / S", check_pool_s);
+	suite_check_testcase(s, "CORE", "Buckets / Pool / M", check_pool_m);
+	suite_check_testcase(s, "CORE", "Buckets / Slotted / S", check_slotted_s);
 
 	suite_check_testcase(s, "CORE", "Host / System / Signal Names", check_signames_s);
 	suite_check_testcase(s, "CORE", "Host / System / Error Names", check_errnames_s);
@@ -13,6 +13,11 @@ typedef struct {
 	uint64_t type;
 } check_inx_opt_t;
 
+typedef struct {
+	uint64_t key;
+	stringer_t *value;
+} check_slotted_slot_t;
+
 struct check_mi_t {
 	int nr;
 	char *name;
@@ -39,6 +44,15 @@ bool_t   check_string_realloc(uint32_t check);
 /// qp_check.c
 bool_t   check_encoding_qp(void);
 
+/// pool_check.c
+bool_t   check_pool_mthread(void);
+void     check_pool_mthread_cnv(pool_t *pool);
+bool_t   check_pool_sthread(void);
+
+/// slotted_check.c
+void     check_slotted_clear(check_slotted_slot_t *slot);
+bool_t   check_slotted_sthread(void);
+
 /// inx_check.c
 bool_t    check_inx_cursor_mthread(check_inx_opt_t *opts);
 void		  check_inx_cursor_mthread_cnv(check_inx_opt_t *opts);
@@ -0,0 +1,139 @@
+
+/**
+ * @file /check/magma/core/pool_check.c
+ *
+ * @brief Object pool checks.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Check that a pool hands out each item once, refuses duplicate releases, and honors its timeout.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_pool_sthread(void) {
+
+	pool_t *pool;
+	time_t start;
+	uint32_t items[4], extra;
+
+	if (!(pool = pool_alloc(4, 1))) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 4; i++) {
+		pool_set_obj(pool, i, pool);
+		if (pool_pull(pool, &items[i]) != PL_RESERVED || items[i] >= 4 || pool_get_status(pool, items[i]) != PL_RESERVED) {
+			pool_free(pool);
+			return false;
+		}
+		for (uint32_t j = 0; j < i; j++) {
+			if (items[i] == items[j]) {
+				pool_free(pool);
+				return false;
+			}
+		}
+	}
+
+	// The pool is empty, so the next request should fail once the one second timeout expires.
+	start = time(NULL);
+	if (pool_pull(pool, &extra) != PL_ERROR || time(NULL) == start || pool_get_failures(pool) != 1) {
+		pool_free(pool);
+		return false;
+	}
+
+	// Releasing an item twice must not make it available twice.
+	pool_release(pool, items[2]);
+	pool_release(pool, items[2]);
+
+	if (pool_pull(pool, &extra) != PL_RESERVED || extra != items[2] || pool_pull(pool, &extra) != PL_ERROR) {
+		pool_free(pool);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 4; i++) {
+		pool_release(pool, items[i]);
+	}
+
+	if (pool_get_waits(pool, 0) != 5) {
+		pool_free(pool);
+		return false;
+	}
+
+	pool_free(pool);
+	return true;
+}
+
+void check_pool_mthread_cnv(pool_t *pool) {
+
+	bool_t *result;
+	uint32_t item;
+
+	if (!thread_start() || !(result = mm_alloc(sizeof(bool_t)))) {
+		log_error("Unable to setup the thread context.");
+		pthread_exit(NULL);
+		return;
+	}
+
+	*result = true;
+
+	// Each item holds a counter which would be corrupted if two threads were ever handed the same item.
+	for (uint64_t i = 0; i < POOL_CHECK_ROUNDS && *result && status(); i++) {
+		if (pool_pull(pool, &item) != PL_RESERVED || __sync_add_and_fetch((uint64_t *)pool_get_obj(pool, item), 1) != 1) {
+			*result = false;
+		}
+		else {
+			__sync_sub_and_fetch((uint64_t *)pool_get_obj(pool, item), 1);
+			pool_release(pool, item);
+		}
+	}
+
+	thread_stop();
+	pthread_exit(result);
+	return;
+}
+
+/**
+ * @brief	Check that a pool never hands the same item to more than one thread.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_pool_mthread(void) {
+
+	pool_t *pool;
+	bool_t result = true;
+	void *outcome = NULL;
+	pthread_t threads[POOL_CHECK_MTHREADS];
+	uint64_t counters[POOL_CHECK_MTHREADS / 2];
+
+	mm_wipe(counters, sizeof(counters));
+
+	if (!(pool = pool_alloc(POOL_CHECK_MTHREADS / 2, 0))) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < POOL_CHECK_MTHREADS / 2; i++) {
+		pool_set_obj(pool, i, &counters[i]);
+	}
+
+	for (uint64_t counter = 0; counter < POOL_CHECK_MTHREADS; counter++) {
+		if (thread_launch(threads + counter, &check_pool_mthread_cnv, pool)) {
+			result = false;
+		}
+	}
+
+	for (uint64_t counter = 0; counter < POOL_CHECK_MTHREADS; counter++) {
+		if (thread_result(*(threads + counter), &outcome) || !outcome || !*(bool_t *)outcome) {
+			result = false;
+		}
+		if (outcome) {
+			mm_free(outcome);
+		}
+	}
+
+	if (pool_get_failures(pool)) {
+		result = false;
+	}
+
+	pool_free(pool);
+	return result;
+}
@@ -0,0 +1,104 @@
+
+/**
+ * @file /check/magma/core/slotted_check.c
+ *
+ * @brief Fixed slot table checks.
+ */
+
+#include "magma_check.h"
+
+static uint32_t check_slotted_cleared = 0;
+
+/**
+ * @brief	The clear function used by the slot table checks, which releases the value and counts the slots it was called for.
+ * @param	slot	the slot being cleared.
+ * @return	This function returns no value.
+ */
+void check_slotted_clear(check_slotted_slot_t *slot) {
+
+	if (slot->value) {
+		st_free(slot->value);
+		check_slotted_cleared++;
+	}
+
+	return;
+}
+
+/**
+ * @brief	Check that hashes map to the expected slots, storing a key replaces the previous occupant, and the clear function is called
+ * 			for every occupied slot when a slot is cleared, and when the table is freed.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_slotted_sthread(void) {
+
+	slotted_t *table;
+	check_slotted_slot_t *slot, *other;
+
+	check_slotted_cleared = 0;
+
+	if (slotted_alloc(0, sizeof(check_slotted_slot_t), false, NULL) || !(table = slotted_alloc(8, sizeof(check_slotted_slot_t), false,
+		&check_slotted_clear)) || slotted_count(table) != 8) {
+		return false;
+	}
+
+	// Every slot starts out empty.
+	for (uint64_t i = 0; i < 8; i++) {
+		slot = slotted_lock(table, i);
+		if (slot->key || slot->value) {
+			slotted_unlock(table, i);
+			slotted_free(table);
+			return false;
+		}
+		slot->key = i + 1;
+		slot->value = st_import("value", 5);
+		slotted_unlock(table, i);
+	}
+
+	// Hashes which are equal modulo the number of slots share a slot.
+	slot = slotted_lock(table, 3);
+	slotted_unlock(table, 3);
+	other = slotted_lock(table, 11);
+
+	if (slot != other || other->key != 4) {
+		slotted_unlock(table, 11);
+		slotted_free(table);
+		return false;
+	}
+
+	// Clearing a slot releases its contents, and wipes it.
+	slotted_clear(table, other);
+	slotted_unlock(table, 11);
+
+	if (check_slotted_cleared != 1 || slot->key || slot->value) {
+		slotted_free(table);
+		return false;
+	}
+
+	// Freeing the table releases the seven slots which are still occupied.
+	slotted_free(table);
+
+	if (check_slotted_cleared != 8) {
+		return false;
+	}
+
+	// Secure tables behave the same way, but without a clear function.
+	if (!(table = slotted_alloc(4, sizeof(check_slotted_slot_t), true, NULL))) {
+		return !magma.secure.memory.enable;
+	}
+
+	slot = slotted_lock(table, 6);
+	slot->key = 6;
+	slotted_unlock(table, 6);
+	slot = slotted_lock(table, 2);
+
+	if (slot->key != 6) {
+		slotted_unlock(table, 2);
+		slotted_free(table);
+		return false;
+	}
+
+	slotted_unlock(table, 2);
+	slotted_free(table);
+
+	return true;
+}
@@ -59,6 +59,9 @@ void suite_check_testcase_timeout(Suite *s, const char *tags, const char *name,
 #define INX_CHECK_MTHREADS 2
 #define INX_CHECK_OBJECTS 1024
 
+#define POOL_CHECK_MTHREADS 4
+#define POOL_CHECK_ROUNDS 16384
+
 #define IP_CHECK_ROUNDS 10
 
 #define TREE_INSERTS_CHECK 128
@@ -123,6 +126,9 @@ void suite_check_testcase_timeout(Suite *s, const char *tags, const char *name,
 #define PRIME_CHECK_ITERATIONS 16
 #define PRIME_CHECK_SPANNING_CHUNK_SIZE (1024 * 1024 * 20) // 20 megabytes
 
+#define STACIE_CHECK_SPEED_ROUNDS 1024 // The number of hash rounds used by each derivation in the multi-lane throughput check.
+#define STACIE_CHECK_SPEED_DERIVATIONS (STACIE_LANES * 4) // The number of derivations timed by the multi-lane throughput check.
+
 #define DKIM_CHECK_MTHREADS 8 // The number of DKIM signing threads to spawn.
 
 #define OBJECT_CHECK_ITERATIONS 16 // The number of threads spawn by the multi-threaded object test cases.
@@ -141,6 +147,9 @@ void suite_check_testcase_timeout(Suite *s, const char *tags, const char *name,
 #define INX_CHECK_MTHREADS 8
 #define INX_CHECK_OBJECTS 8192
 
+#define POOL_CHECK_MTHREADS 16
+#define POOL_CHECK_ROUNDS 1048576
+
 #define TREE_INSERTS_CHECK 8192
 #define TREE_CURSORS_CHECK 8192
 #define LINKED_INSERTS_CHECK 8192
@@ -195,6 +204,9 @@ void suite_check_testcase_timeout(Suite *s, const char *tags, const char *name,
 #define PRIME_CHECK_SIZE_MAX (1 * 1024 * 1024) // 1 megabyte
 #define PRIME_CHECK_SPANNING_CHUNK_SIZE (1024 * 1024 * 256) // 256 megabytes
 
+#define STACIE_CHECK_SPEED_ROUNDS 65536 // The number of hash rounds used by each derivation in the multi-lane throughput check.
+#define STACIE_CHECK_SPEED_DERIVATIONS (STACIE_LANES * 32) // The number of derivations timed by the multi-lane throughput check.
+
 #define SCRAMBLE_CHECK_ITERATIONS 256
 #define SCRAMBLE_CHECK_SIZE_MIN 1024 // 1 kilobyte
 #define SCRAMBLE_CHECK_SIZE_MAX (16 * 1024)
@@ -0,0 +1,166 @@
+/**
+ * @file /check/magma/objects/flags_check.c
+ *
+ * @brief Batched message flag update test functions.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Remove every test message in a collection.
+ * @param	usernum		the numerical id of the user that owns the messages.
+ * @param	messages	the collection of messages to be removed, which is freed by this function.
+ * @return	This function returns no value.
+ */
+void check_objects_flags_cleanup(uint64_t usernum, inx_t *messages) {
+
+	inx_cursor_t *cursor;
+	meta_message_t *active;
+
+	if (messages && (cursor = inx_cursor_alloc(messages))) {
+		while ((active = inx_cursor_value_next(cursor))) {
+			mail_remove_message(usernum, active->messagenum, active->size, NULL);
+		}
+		inx_cursor_free(cursor);
+	}
+
+	inx_cleanup(messages);
+	return;
+}
+
+/**
+ * @brief	Add a flag to a collection of messages using a single call to meta_data_flags_batch().
+ * @note	The statement parameters are bound the same way meta_data_flags_add() binds them.
+ * @param	messages	the collection of messages to be updated.
+ * @param	usernum		the numerical id of the user that owns the messages.
+ * @param	foldernum	the numerical id of the folder holding the messages.
+ * @param	flags		the flags to be added.
+ * @param	modseq		a pointer which will receive the modification sequence allocated for the update.
+ * @return	true on success or false on failure.
+ */
+bool_t check_objects_flags_add(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, uint64_t *modseq) {
+
+	uint64_t limit = UINT64_MAX;
+	MYSQL_BIND parameters[6 + META_FLAGS_BATCH_SIZE];
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Flag to Add
+	parameters[0].buffer_type = MYSQL_TYPE_LONG;
+	parameters[0].buffer_length = sizeof(uint32_t);
+	parameters[0].buffer = &flags;
+	parameters[0].is_unsigned = true;
+
+	// Modification Sequence
+	parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[1].buffer_length = sizeof(uint64_t);
+	parameters[1].buffer = modseq;
+	parameters[1].is_unsigned = true;
+
+	// Flag to Add
+	parameters[2].buffer_type = MYSQL_TYPE_LONG;
+	parameters[2].buffer_length = sizeof(uint32_t);
+	parameters[2].buffer = &flags;
+	parameters[2].is_unsigned = true;
+
+	// Usernum
+	parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[3].buffer_length = sizeof(uint64_t);
+	parameters[3].buffer = &usernum;
+	parameters[3].is_unsigned = true;
+
+	// Foldernum
+	parameters[4].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[4].buffer_length = sizeof(uint64_t);
+	parameters[4].buffer = &foldernum;
+	parameters[4].is_unsigned = true;
+
+	// Unchanged Since
+	parameters[5].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[5].buffer_length = sizeof(uint64_t);
+	parameters[5].buffer = &limit;
+	parameters[5].is_unsigned = true;
+
+	return meta_data_flags_batch(stmts.update_message_flags_add, parameters, 6, messages, usernum, foldernum, modseq, NULL);
+}
+
+/**
+ * @brief	Update collections which are smaller than, equal to, and larger than a single batch, and make sure every message is updated
+ * 			exactly once, while the messages outside the collection, including those near the padded placeholders, are left alone.
+ */
+bool_t check_objects_flags_batch_sthread(stringer_t *errmsg) {
+
+	int64_t rows;
+	inx_cursor_t *cursor;
+	meta_message_t *active;
+	inx_t *messages = NULL, *outside = NULL;
+	uint64_t usernum = 0, foldernum = 0, before, modseq;
+	size_t sizes[] = { 1, META_FLAGS_BATCH_SIZE - 1, META_FLAGS_BATCH_SIZE, META_FLAGS_BATCH_SIZE + 1, (META_FLAGS_BATCH_SIZE * 2) + 1 };
+
+	for (size_t i = 0; i < (sizeof(sizes) / sizeof(size_t)); i++) {
+
+		modseq = 0;
+
+		// The message stored after the collection has a larger number than the last one, which is the number used for the padding.
+		if (!(messages = inx_alloc(M_INX_LINKED, &meta_message_free)) || !(outside = inx_alloc(M_INX_LINKED, &meta_message_free))) {
+			st_sprint(errmsg, "Unable to allocate an index for the test messages.");
+			inx_cleanup(messages);
+			return false;
+		}
+		else if (!check_objects_remove_store(messages, sizes[i], 0, &usernum, &foldernum, errmsg) ||
+			!check_objects_remove_store(outside, 1, 0, &usernum, &foldernum, errmsg)) {
+			check_objects_flags_cleanup(usernum, messages);
+			check_objects_flags_cleanup(usernum, outside);
+			return false;
+		}
+
+		before = meta_data_fetch_modseq(usernum);
+
+		if (!check_objects_flags_add(messages, usernum, foldernum, MAIL_STATUS_FLAGGED, &modseq) || !modseq) {
+			st_sprint(errmsg, "The batched flag update failed. { messages = %zu }", sizes[i]);
+			check_objects_flags_cleanup(usernum, messages);
+			check_objects_flags_cleanup(usernum, outside);
+			return false;
+		}
+
+		// A single modification sequence should be allocated for the entire collection, no matter how many batches it needs.
+		else if (modseq != before + 1 || meta_data_fetch_modseq(usernum) != modseq) {
+			st_sprint(errmsg, "The batched flag update allocated the wrong modification sequence. { messages = %zu / before = %lu / " \
+				"modseq = %lu / current = %lu }", sizes[i], before, modseq, meta_data_fetch_modseq(usernum));
+			check_objects_flags_cleanup(usernum, messages);
+			check_objects_flags_cleanup(usernum, outside);
+			return false;
+		}
+
+		// Every message in the collection, and nothing else, should have the flag and the new modification sequence.
+		else if ((rows = sql_num_rows(st_quick(MANAGEDBUF(1024), "SELECT messagenum FROM Messages WHERE usernum = %lu AND modseq = %lu " \
+			"AND (status & %u) = %u;", usernum, modseq, MAIL_STATUS_FLAGGED, MAIL_STATUS_FLAGGED))) != (int64_t)sizes[i]) {
+			st_sprint(errmsg, "The batched flag update changed the wrong number of messages. { messages = %zu / updated = %li }",
+				sizes[i], rows);
+			check_objects_flags_cleanup(usernum, messages);
+			check_objects_flags_cleanup(usernum, outside);
+			return false;
+		}
+
+		if ((cursor = inx_cursor_alloc(outside))) {
+
+			if ((active = inx_cursor_value_next(cursor)) && sql_num_rows(st_quick(MANAGEDBUF(1024), "SELECT messagenum FROM Messages " \
+				"WHERE usernum = %lu AND messagenum = %lu AND (status & %u) = 0;", usernum, active->messagenum, MAIL_STATUS_FLAGGED)) != 1) {
+				st_sprint(errmsg, "The batched flag update changed a message which wasn't in the collection. { messages = %zu / outside = %lu }",
+					sizes[i], active->messagenum);
+				inx_cursor_free(cursor);
+				check_objects_flags_cleanup(usernum, messages);
+				check_objects_flags_cleanup(usernum, outside);
+				return false;
+			}
+
+			inx_cursor_free(cursor);
+		}
+
+		check_objects_flags_cleanup(usernum, messages);
+		check_objects_flags_cleanup(usernum, outside);
+		messages = outside = NULL;
+	}
+
+	return true;
+}
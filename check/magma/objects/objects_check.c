@@ -117,12 +117,119 @@ START_TEST (check_warehouse_domains_s) {
 }
 END_TEST
 
+START_TEST (check_object_expire_s) {
+
+	log_disable();
+	bool_t result = true;
+	meta_user_t *user = NULL;
+	stringer_t *errmsg = NULL;
+	uint64_t usernum, latency = 0;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	// Use a user number which won't collide with a real account.
+	key.val.u64 = usernum = (rand_get_uint64() % 1000000000) + 1000000000;
+
+	if (status() && !(user = meta_inx_find(usernum, META_PROTOCOL_GENERIC))) {
+		errmsg = NULLER("Unable to add a user object to the cache.");
+		result = false;
+	}
+	else if (status()) {
+
+		// Releasing the last reference should move the object to the end of the idle queue.
+		meta_inx_remove(usernum, META_PROTOCOL_GENERIC);
+
+		mutex_lock(&(objects.idle.meta.lock));
+		result = (objects.idle.meta.tail == &(user->idle) && user->idle.linked && user->idle.key == usernum);
+		mutex_unlock(&(objects.idle.meta.lock));
+
+		if (!result) {
+			errmsg = NULLER("The idle user object wasn't queued for expiration.");
+		}
+		else if (!obj_cache_expire(objects.meta, &(objects.idle.meta), (void *)&meta_user_ref_total, (void *)&meta_user_ref_stamp, -1, &latency)) {
+			errmsg = NULLER("The idle user object wasn't expired.");
+			result = false;
+		}
+		else {
+
+			inx_lock_read(objects.meta);
+			user = inx_find(objects.meta, key);
+			inx_unlock(objects.meta);
+
+			if (user) {
+				errmsg = NULLER("The expired user object was still in the cache.");
+				result = false;
+			}
+		}
+	}
+
+	log_test("OBJECTS / CACHE / EXPIRE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_object_flags_batch_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_objects_flags_batch_sthread(errmsg);
+
+	log_test("OBJECTS / FLAGS / BATCH / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_object_remove_bulk_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_objects_remove_bulk_sthread(errmsg);
+
+	log_test("OBJECTS / REMOVE / BULK / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_object_remove_fallback_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_objects_remove_fallback_sthread(errmsg);
+
+	log_test("OBJECTS / REMOVE / FALLBACK / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_object_remove_reclaim_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_objects_remove_reclaim_sthread(errmsg);
+
+	log_test("OBJECTS / REMOVE / RECLAIM / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 Suite * suite_check_objects(void) {
 
 	Suite *s = suite_create("\tObjects");
 
 	suite_check_testcase(s, "OBJECTS", "Object Serials/S", check_object_serials_s);
 	suite_check_testcase(s, "OBJECTS", "Object Warehouse Domains/S", check_warehouse_domains_s);
+	suite_check_testcase(s, "OBJECTS", "Object Cache Expiration/S", check_object_expire_s);
+	suite_check_testcase(s, "OBJECTS", "Object Flags Batch/S", check_object_flags_batch_s);
+	suite_check_testcase(s, "OBJECTS", "Object Remove Bulk/S", check_object_remove_bulk_s);
+	suite_check_testcase(s, "OBJECTS", "Object Remove Fallback/S", check_object_remove_fallback_s);
+	suite_check_testcase(s, "OBJECTS", "Object Remove Reclaim/S", check_object_remove_reclaim_s);
 
 	return s;
 }
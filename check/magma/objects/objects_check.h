@@ -10,5 +10,17 @@
 
 Suite * suite_check_objects(void);
 
+/// flags_check.c
+bool_t   check_objects_flags_add(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, uint64_t *modseq);
+bool_t   check_objects_flags_batch_sthread(stringer_t *errmsg);
+void     check_objects_flags_cleanup(uint64_t usernum, inx_t *messages);
+
+/// remove_check.c
+bool_t   check_objects_remove_bulk_sthread(stringer_t *errmsg);
+bool_t   check_objects_remove_fallback_sthread(stringer_t *errmsg);
+bool_t   check_objects_remove_gone(uint64_t usernum, uint64_t messagenum);
+bool_t   check_objects_remove_reclaim_sthread(stringer_t *errmsg);
+bool_t   check_objects_remove_store(inx_t *messages, size_t count, uint32_t status, uint64_t *usernum, uint64_t *foldernum, stringer_t *errmsg);
+
 #endif
 
@@ -0,0 +1,301 @@
+/**
+ * @file /check/magma/objects/remove_check.c
+ *
+ * @brief Bulk message removal test functions.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Store a series of test messages in the Inbox of ladar@lavabit.com, and describe each of them using a meta message object.
+ * @param	messages	the index which will receive the meta message objects, keyed by message number.
+ * @param	count		the number of messages to store.
+ * @param	status		the status flags assigned to each message.
+ * @param	usernum		a pointer which will receive the numerical id of the user that owns the messages.
+ * @param	foldernum	a pointer which will receive the numerical id of the folder holding the messages.
+ * @param	errmsg		a managed string which will receive the error message, if the messages can't be stored.
+ * @return	true if every message was stored, otherwise false.
+ */
+bool_t check_objects_remove_store(inx_t *messages, size_t count, uint32_t status, uint64_t *usernum, uint64_t *foldernum, stringer_t *errmsg) {
+
+	int_t state;
+	uint32_t flags;
+	meta_message_t *message;
+	smtp_inbound_prefs_t *prefs = NULL;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+	stringer_t *data = NULLER("Subject: Bulk Removal\r\n\r\nThis message was stored so it could be removed.\r\n");
+
+	if ((state = smtp_fetch_inbound(PLACER("ladar@lavabit.com", 17), &prefs)) != 0 || !prefs) {
+		st_sprint(errmsg, "Unable to fetch the inbound preferences for the test user. { state = %i }", state);
+		if (prefs) smtp_free_inbound(prefs);
+		return false;
+	}
+
+	*usernum = prefs->usernum;
+	*foldernum = prefs->inbox;
+	smtp_free_inbound(prefs);
+
+	for (size_t i = 0; i < count; i++) {
+
+		flags = status;
+
+		if (!(key.val.u64 = mail_store_message(*usernum, NULL, *foldernum, &flags, 0, 0, data))) {
+			st_sprint(errmsg, "Failed to store a test message. { message = %zu }", i);
+			return false;
+		}
+		else if (!(message = mm_alloc(sizeof(meta_message_t)))) {
+			st_sprint(errmsg, "Failed to allocate a meta message object. { message = %zu }", i);
+			mail_remove_message(*usernum, key.val.u64, st_length_int(data), NULL);
+			return false;
+		}
+
+		message->status = flags;
+		message->size = st_length_get(data);
+		message->sequencenum = inx_count(messages) + 1;
+		message->messagenum = key.val.u64;
+		message->foldernum = *foldernum;
+		snprintf(message->server, sizeof(message->server), "%.*s", st_length_int(magma.storage.active), st_char_get(magma.storage.active));
+
+		if (!inx_insert(messages, key, message)) {
+			st_sprint(errmsg, "Failed to add a test message to the index. { message = %zu }", i);
+			mail_remove_message(*usernum, key.val.u64, st_length_int(data), NULL);
+			meta_message_free(message);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Determine whether a message has been removed from both the database and storage.
+ * @note	The database is probed by trying to delete the message record inside a transaction which is always rolled back.
+ * @param	usernum		the numerical id of the user that owned the message.
+ * @param	messagenum	the numerical id of the message.
+ * @return	true if neither the database record nor the message file exist, otherwise false.
+ */
+bool_t check_objects_remove_gone(uint64_t usernum, uint64_t messagenum) {
+
+	chr_t *path;
+	bool_t found;
+	int64_t transaction;
+
+	if (!(path = mail_message_path(messagenum, NULL))) {
+		return false;
+	}
+
+	found = !access(path, F_OK);
+	ns_free(path);
+
+	if (found || (transaction = tran_start()) < 0) {
+		return false;
+	}
+
+	found = mail_db_delete_message(usernum, messagenum, 0, transaction);
+	tran_rollback(transaction);
+
+	return !found;
+}
+
+/**
+ * @brief	Expunge the deleted messages in a folder using a single bulk removal.
+ */
+bool_t check_objects_remove_bulk_sthread(stringer_t *errmsg) {
+
+	int64_t expunged = 0;
+	inx_t *messages = NULL;
+	bool_t result = true;
+	inx_cursor_t *cursor = NULL;
+	meta_message_t *kept = NULL, *active;
+	uint64_t usernum = 0, foldernum = 0, survivor = 0, *sequences = NULL, *uids = NULL;
+
+	if (!(messages = inx_alloc(M_INX_LINKED, &meta_message_free))) {
+		st_sprint(errmsg, "Unable to allocate an index for the test messages.");
+		return false;
+	}
+
+	// Store a message which should survive, followed by three deleted messages.
+	else if (!check_objects_remove_store(messages, 1, 0, &usernum, &foldernum, errmsg) || !(cursor = inx_cursor_alloc(messages)) ||
+		!(kept = inx_cursor_value_next(cursor)) || !check_objects_remove_store(messages, 3, MAIL_STATUS_DELETED, &usernum, &foldernum, errmsg)) {
+		if (!st_populated(errmsg)) st_sprint(errmsg, "Unable to locate the test message which should survive the expunge.");
+		result = false;
+	}
+	else if (!(survivor = kept->messagenum) ||
+		(expunged = imap_message_expunge_bulk(usernum, messages, foldernum, MAIL_STATUS_DELETED, &sequences, &uids)) != 3) {
+		st_sprint(errmsg, "The bulk expunge removed the wrong number of messages. { expunged = %li / expected = 3 }", expunged);
+		result = false;
+	}
+	else if (inx_count(messages) != 1 || !(kept = meta_message_by_number(messages, survivor)) || (kept->status & MAIL_STATUS_DELETED)) {
+		st_sprint(errmsg, "The bulk expunge didn't leave the message without the deleted flag in the index.");
+		result = false;
+	}
+
+	// The sequence numbers and UIDs should be returned in ascending order, and the removed messages can't be found in the database.
+	for (int64_t i = 0; result && i < 3; i++) {
+		if (sequences[i] != (uint64_t)i + 2 || (i && uids[i] <= uids[i - 1])) {
+			st_sprint(errmsg, "The bulk expunge returned an invalid sequence number or UID. { index = %li / sequence = %lu / uid = %lu }",
+				i, sequences[i], uids[i]);
+			result = false;
+		}
+		else if (meta_message_by_number(messages, uids[i])) {
+			st_sprint(errmsg, "An expunged message was left in the index. { uid = %lu }", uids[i]);
+			result = false;
+		}
+	}
+
+	if (cursor) {
+		inx_cursor_free(cursor);
+	}
+
+	// Cleanup whatever is left of the test messages.
+	if ((cursor = inx_cursor_alloc(messages))) {
+		while ((active = inx_cursor_value_next(cursor))) {
+			mail_remove_message(usernum, active->messagenum, active->size, NULL);
+		}
+		inx_cursor_free(cursor);
+	}
+
+	mm_cleanup(sequences, uids);
+	inx_free(messages);
+
+	return result;
+}
+
+/**
+ * @brief	Expunge a collection of messages which includes a record that doesn't exist, so the bulk removal fails and every message is
+ * 			removed individually.
+ */
+bool_t check_objects_remove_fallback_sthread(stringer_t *errmsg) {
+
+	int64_t expunged = 0;
+	bool_t result = true;
+	inx_t *messages = NULL;
+	inx_cursor_t *cursor = NULL;
+	meta_message_t *missing = NULL, *active;
+	uint64_t usernum = 0, foldernum = 0, *uids = NULL;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = UINT64_MAX };
+
+	if (!(messages = inx_alloc(M_INX_LINKED, &meta_message_free))) {
+		st_sprint(errmsg, "Unable to allocate an index for the test messages.");
+		return false;
+	}
+	else if (!check_objects_remove_store(messages, 2, MAIL_STATUS_DELETED, &usernum, &foldernum, errmsg)) {
+		inx_free(messages);
+		return false;
+	}
+	else if (!(missing = mm_alloc(sizeof(meta_message_t)))) {
+		st_sprint(errmsg, "Failed to allocate a meta message object.");
+		result = false;
+	}
+	else {
+
+		// The final message doesn't have a database record, so it will cause the bulk removal to fail.
+		missing->messagenum = UINT64_MAX;
+		missing->foldernum = foldernum;
+		missing->status = MAIL_STATUS_DELETED;
+		missing->sequencenum = 3;
+
+		if (!inx_insert(messages, key, missing)) {
+			st_sprint(errmsg, "Failed to add the missing message to the index.");
+			meta_message_free(missing);
+			result = false;
+		}
+	}
+
+	if (result && (expunged = imap_message_expunge_bulk(usernum, messages, foldernum, MAIL_STATUS_DELETED, NULL, &uids)) != 2) {
+		st_sprint(errmsg, "The fallback expunge removed the wrong number of messages. { expunged = %li / expected = 2 }", expunged);
+		result = false;
+	}
+	else if (result && (inx_count(messages) != 1 || !meta_message_by_number(messages, UINT64_MAX))) {
+		st_sprint(errmsg, "The fallback expunge didn't leave the missing message in the index.");
+		result = false;
+	}
+
+	// The individual removals unlink the files immediately, so there's nothing to wait for.
+	for (int_t i = 0; result && i < 2; i++) {
+		if (!check_objects_remove_gone(usernum, uids[i])) {
+			st_sprint(errmsg, "A message removed individually was still present. { uid = %lu }", uids[i]);
+			result = false;
+		}
+	}
+
+	// Cleanup any test messages which weren't removed.
+	if (!result && (cursor = inx_cursor_alloc(messages))) {
+		while ((active = inx_cursor_value_next(cursor))) {
+			if (active->messagenum != UINT64_MAX) mail_remove_message(usernum, active->messagenum, active->size, NULL);
+		}
+		inx_cursor_free(cursor);
+	}
+
+	mm_cleanup(uids);
+	inx_free(messages);
+
+	return result;
+}
+
+/**
+ * @brief	Remove a collection of messages, and wait for the worker threads to reclaim the message files in the background.
+ */
+bool_t check_objects_remove_reclaim_sthread(stringer_t *errmsg) {
+
+	bool_t result = true;
+	inx_t *messages = NULL;
+	inx_cursor_t *cursor = NULL;
+	meta_message_t *active, *targets[4];
+	uint64_t usernum = 0, foldernum = 0, pending;
+	size_t count = 0, remaining = 4;
+
+	if (!(messages = inx_alloc(M_INX_LINKED, &meta_message_free))) {
+		st_sprint(errmsg, "Unable to allocate an index for the test messages.");
+		return false;
+	}
+	else if (!check_objects_remove_store(messages, 4, MAIL_STATUS_DELETED, &usernum, &foldernum, errmsg)) {
+		result = false;
+	}
+	else if ((cursor = inx_cursor_alloc(messages))) {
+		while (count < 4 && (active = inx_cursor_value_next(cursor))) {
+			targets[count++] = active;
+		}
+		inx_cursor_free(cursor);
+	}
+
+	pending = stats_get_value_by_name("objects.mail.reclaim.pending");
+
+	if (result && (count != 4 || !mail_remove_messages(usernum, targets, count))) {
+		st_sprint(errmsg, "The bulk message removal failed. { count = %zu }", count);
+		result = false;
+	}
+
+	// The worker threads should unlink the files, and return the pending counter to where it started, within a few seconds.
+	for (int_t wait = 0; result && wait < 500; wait++) {
+
+		remaining = 0;
+
+		for (size_t i = 0; i < count; i++) {
+			if (!check_objects_remove_gone(usernum, targets[i]->messagenum)) remaining++;
+		}
+
+		if (!remaining && stats_get_value_by_name("objects.mail.reclaim.pending") <= pending) {
+			break;
+		}
+
+		usleep(10000);
+	}
+
+	if (result && (remaining || stats_get_value_by_name("objects.mail.reclaim.pending") > pending)) {
+		st_sprint(errmsg, "The removed message files weren't reclaimed in the background. { remaining = %zu / pending = %lu }",
+			remaining, stats_get_value_by_name("objects.mail.reclaim.pending"));
+		result = false;
+	}
+
+	// If the bulk removal failed, the test messages are still around.
+	if (!result) {
+		for (size_t i = 0; i < count; i++) {
+			mail_remove_message(usernum, targets[i]->messagenum, targets[i]->size, NULL);
+		}
+	}
+
+	inx_free(messages);
+
+	return result;
+}
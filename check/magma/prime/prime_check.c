@@ -29,12 +29,28 @@ START_TEST (check_stacie_s) {
 	else if (status() && result && !(result = check_stacie_bitflip())) {
 		st_sprint(errmsg, "The STACIE encryption scheme failed to detect tampering of an encrypted buffer.");
 	}
+	else if (status() && result && !(result = check_stacie_lanes())) {
+		st_sprint(errmsg, "The multi-lane STACIE functions failed to produce the same values as the serial functions.");
+	}
 
 	log_test("PRIME / STACIE / SINGLE THREADED:", errmsg);
 	ck_assert_msg(result, st_char_get(errmsg));
 }
 END_TEST
 
+START_TEST (check_stacie_speed_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_stacie_lanes_speed(errmsg);
+
+	log_test("PRIME / STACIE / SPEED / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 //! PRIME Tests
 START_TEST (check_prime_ed25519_s) {
 
@@ -629,6 +645,7 @@ Suite * suite_check_prime(void) {
 	Suite *s = suite_create("\tPRIME");
 
 	suite_check_testcase(s, "PRIME", "STACIE/S", check_stacie_s);
+	suite_check_testcase(s, "PRIME", "STACIE Speed/S", check_stacie_speed_s);
 
 	suite_check_testcase(s, "PRIME", "PRIME ed25519/S", check_prime_ed25519_s);
 	suite_check_testcase(s, "PRIME", "PRIME secp256k1/S", check_prime_secp256k1_s);
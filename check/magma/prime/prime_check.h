@@ -35,11 +35,15 @@ bool_t   check_prime_secp256k1_keys_sthread(stringer_t *errmsg);
 bool_t   check_prime_secp256k1_parameters_sthread(stringer_t *errmsg);
 
 /// stacie_check.c
-bool_t   check_stacie_bitflip(void);
-bool_t   check_stacie_determinism(void);
-bool_t   check_stacie_parameters(void);
-bool_t   check_stacie_rounds(void);
-bool_t   check_stacie_simple(void);
+bool_t          check_stacie_bitflip(void);
+bool_t          check_stacie_determinism(void);
+bool_t          check_stacie_lanes(void);
+bool_t          check_stacie_lanes_speed(stringer_t *errmsg);
+void            check_stacie_lanes_done(stacie_job_t *job, void *opaque);
+stacie_job_t *  check_stacie_lanes_next(void *opaque);
+bool_t          check_stacie_parameters(void);
+bool_t          check_stacie_rounds(void);
+bool_t          check_stacie_simple(void);
 
 /// prime_check.c
 Suite *  suite_check_prime(void);
@@ -518,3 +518,190 @@ bool_t check_stacie_bitflip(void) {
 	st_cleanup(decrypted_buffer, encrypted_buffer);
 	return true;
 }
+
+/**
+ * @brief	Hand the multi-lane STACIE functions the next derivation from a linked list.
+ * @param	opaque	a pointer to the head of the list.
+ * @return	the next derivation, or NULL once the list is empty.
+ */
+stacie_job_t * check_stacie_lanes_next(void *opaque) {
+
+	stacie_job_t **list = opaque, *job;
+
+	if ((job = *list)) {
+		*list = job->next;
+	}
+
+	return job;
+}
+
+/**
+ * @brief	Record the completion of a derivation processed by the multi-lane STACIE functions.
+ * @param	job		the completed derivation.
+ * @param	opaque	unused.
+ * @return	This function returns no value.
+ */
+void check_stacie_lanes_done(stacie_job_t *job, void *opaque) {
+
+	job->done = true;
+	return;
+}
+
+/**
+ * @brief	Check that the multi-lane STACIE functions produce the same seed, master key, and password key values as the serial
+ * 			functions, using more derivations than there are lanes, and a variety of password lengths and round counts.
+ * @return	True if passes, false if fails.
+*/
+bool_t check_stacie_lanes(void) {
+
+	bool_t result = true;
+	stacie_job_t jobs[STACIE_LANES * 3], *list = NULL;
+	stringer_t *seed = NULL, *master = NULL, *key = NULL;
+	uint_t count = sizeof(jobs) / sizeof(stacie_job_t);
+
+	mm_wipe(jobs, sizeof(jobs));
+
+	for (uint_t i = 0; i < count && result; i++) {
+
+		// The password lengths cross the block boundaries, and the number of rounds is kept small so the check runs quickly.
+		jobs[i].rounds = STACIE_KEY_ROUNDS_MIN + (rand_get_uint32() % 64);
+
+		if (!(jobs[i].username = st_alloc((rand_get_uint32() % 64) + 1)) || !rand_write(jobs[i].username) ||
+			!(jobs[i].password = st_alloc((i * 7) + 1)) || !rand_write(jobs[i].password) ||
+			!(jobs[i].salt = st_alloc(STACIE_SALT_LENGTH)) || rand_write(jobs[i].salt) != STACIE_SALT_LENGTH) {
+			result = false;
+		}
+
+		jobs[i].next = (i + 1 < count ? &jobs[i + 1] : NULL);
+	}
+
+	// The final derivation has an invalid number of rounds, and should be marked as failed.
+	jobs[count - 1].rounds = STACIE_KEY_ROUNDS_MIN - 1;
+	list = &jobs[0];
+
+	if (result && !stacie_lanes_derive(&check_stacie_lanes_next, &check_stacie_lanes_done, &list)) {
+		result = false;
+	}
+
+	for (uint_t i = 0; i < count && result; i++) {
+
+		if (!jobs[i].done || jobs[i].failed != (i == count - 1)) {
+			result = false;
+		}
+		else if (!jobs[i].failed && (!(seed = stacie_derive_seed(jobs[i].rounds, jobs[i].password, jobs[i].salt)) ||
+			!(master = stacie_derive_key(seed, jobs[i].rounds, jobs[i].username, jobs[i].password, jobs[i].salt)) ||
+			!(key = stacie_derive_key(master, jobs[i].rounds, jobs[i].username, jobs[i].password, jobs[i].salt)) ||
+			memcmp(st_data_get(seed), jobs[i].seed, STACIE_KEY_LENGTH) || memcmp(st_data_get(master), jobs[i].master, STACIE_KEY_LENGTH) ||
+			memcmp(st_data_get(key), jobs[i].key, STACIE_KEY_LENGTH))) {
+			result = false;
+		}
+
+		st_cleanup(seed, master, key);
+		seed = master = key = NULL;
+	}
+
+	for (uint_t i = 0; i < count; i++) {
+		st_cleanup(jobs[i].username, jobs[i].password, jobs[i].salt);
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Compare the throughput of the multi-lane STACIE functions with the serial functions, using the same set of derivations.
+ * @note	Each derivation produces a seed, master key, and password key, the same as a login. The measured rates are logged, but
+ * 			since wall-clock time depends on the machine and its load, the check only fails if a multi-lane derivation doesn't
+ * 			match the serial result.
+ * @param	errmsg	a managed string which will receive an error message.
+ * @return	True if passes, false if fails.
+ */
+bool_t check_stacie_lanes_speed(stringer_t *errmsg) {
+
+	bool_t result = true;
+	double serial = 0, lanes = 0;
+	struct timespec start, finish;
+	stacie_job_t jobs[STACIE_CHECK_SPEED_DERIVATIONS], *list = NULL;
+	stringer_t *seed = NULL, *master = NULL, *key = NULL;
+	uint_t count = sizeof(jobs) / sizeof(stacie_job_t);
+	uchr_t serial_keys[STACIE_CHECK_SPEED_DERIVATIONS][3][STACIE_KEY_LENGTH];
+
+	mm_wipe(jobs, sizeof(jobs));
+	mm_wipe(serial_keys, sizeof(serial_keys));
+
+	for (uint_t i = 0; i < count && result; i++) {
+
+		jobs[i].rounds = STACIE_CHECK_SPEED_ROUNDS;
+
+		if (!(jobs[i].username = st_alloc((rand_get_uint32() % 64) + 1)) || !rand_write(jobs[i].username) ||
+			!(jobs[i].password = st_alloc((rand_get_uint32() % 64) + 1)) || !rand_write(jobs[i].password) ||
+			!(jobs[i].salt = st_alloc(STACIE_SALT_LENGTH)) || rand_write(jobs[i].salt) != STACIE_SALT_LENGTH) {
+			st_sprint(errmsg, "Unable to generate the STACIE throughput inputs.");
+			result = false;
+		}
+
+		jobs[i].next = (i + 1 < count ? &jobs[i + 1] : NULL);
+	}
+
+	// Time the serial functions.
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (uint_t i = 0; i < count && result; i++) {
+
+		if (!(seed = stacie_derive_seed(jobs[i].rounds, jobs[i].password, jobs[i].salt)) ||
+			!(master = stacie_derive_key(seed, jobs[i].rounds, jobs[i].username, jobs[i].password, jobs[i].salt)) ||
+			!(key = stacie_derive_key(master, jobs[i].rounds, jobs[i].username, jobs[i].password, jobs[i].salt))) {
+			st_sprint(errmsg, "The serial STACIE functions failed during the throughput check.");
+			result = false;
+		}
+		else {
+			mm_copy(serial_keys[i][0], st_data_get(seed), STACIE_KEY_LENGTH);
+			mm_copy(serial_keys[i][1], st_data_get(master), STACIE_KEY_LENGTH);
+			mm_copy(serial_keys[i][2], st_data_get(key), STACIE_KEY_LENGTH);
+		}
+
+		st_cleanup(seed, master, key);
+		seed = master = key = NULL;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	serial = (finish.tv_sec - start.tv_sec) + ((finish.tv_nsec - start.tv_nsec) / 1000000000.0);
+
+	// Time the multi-lane functions.
+	list = &jobs[0];
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if (result && !stacie_lanes_derive(&check_stacie_lanes_next, &check_stacie_lanes_done, &list)) {
+		st_sprint(errmsg, "The multi-lane STACIE functions failed during the throughput check.");
+		result = false;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	lanes = (finish.tv_sec - start.tv_sec) + ((finish.tv_nsec - start.tv_nsec) / 1000000000.0);
+
+	for (uint_t i = 0; i < count && result; i++) {
+		if (!jobs[i].done || jobs[i].failed) {
+			st_sprint(errmsg, "The multi-lane STACIE functions failed to complete a derivation during the throughput check.");
+			result = false;
+		}
+		else if (memcmp(jobs[i].seed, serial_keys[i][0], STACIE_KEY_LENGTH) || memcmp(jobs[i].master, serial_keys[i][1], STACIE_KEY_LENGTH) ||
+			memcmp(jobs[i].key, serial_keys[i][2], STACIE_KEY_LENGTH)) {
+			st_sprint(errmsg, "The multi-lane STACIE functions derived different keys than the serial functions. { derivation = %u }", i);
+			result = false;
+		}
+	}
+
+	// The rates are only informational, since a loaded or throttled machine can make either set of functions look slow.
+	if (result) {
+		log_unit("STACIE throughput. { serial = %.1f/s / lanes = %.1f/s }\n", serial > 0 ? count / serial : 0, lanes > 0 ? count / lanes : 0);
+	}
+
+	mm_wipe(serial_keys, sizeof(serial_keys));
+
+	for (uint_t i = 0; i < count; i++) {
+		st_cleanup(jobs[i].username, jobs[i].password, jobs[i].salt);
+	}
+
+	mm_wipe(jobs, sizeof(jobs));
+
+	return result;
+}
@@ -0,0 +1,139 @@
+
+/**
+ * @file /check/magma/providers/cache_check.c
+ *
+ * @brief Check the distributed cache interface, along with the near cache which sits in front of it.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Make sure values are served by the near cache, and that local changes are never hidden by a stale copy.
+ * @param	errmsg	a managed string which will receive a description of the first failure.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_cache_near_sthread(stringer_t *errmsg) {
+
+	uint64_t hits, serial, token;
+	stringer_t *key = MANAGEDBUF(64), *counter = MANAGEDBUF(64), *value = NULL;
+
+	st_sprint(key, "magma.check.near.%lu", rand_get_uint64());
+	st_sprint(counter, "magma.check.near.counter.%lu", rand_get_uint64());
+
+	if (cache_set(key, PLACER("first", 5), 60) != 1 || !(value = cache_get(key)) || st_cmp_cs_eq(value, PLACER("first", 5))) {
+		st_sprint(errmsg, "Unable to store and retrieve a value using the cache.");
+		st_cleanup(value);
+		return false;
+	}
+
+	st_free(value);
+	hits = stats_get_value_by_name("provider.cache.near.hits");
+
+	// The second request should be answered by the near cache, if it's enabled.
+	if (!(value = cache_get(key)) || st_cmp_cs_eq(value, PLACER("first", 5)) ||
+		(cache_near_enabled() && stats_get_value_by_name("provider.cache.near.hits") == hits)) {
+		st_sprint(errmsg, "The near cache failed to return the cached value.");
+		st_cleanup(value);
+		cache_delete(key);
+		return false;
+	}
+
+	st_free(value);
+
+	// Changing the value locally must invalidate the near cache immediately.
+	if (cache_set(key, PLACER("second", 6), 60) != 1 || !(value = cache_get(key)) || st_cmp_cs_eq(value, PLACER("second", 6))) {
+		st_sprint(errmsg, "The near cache returned a stale value after the key was updated.");
+		st_cleanup(value);
+		cache_delete(key);
+		return false;
+	}
+
+	st_free(value);
+
+	if (cache_delete(key) != 1 || (value = cache_get(key))) {
+		st_sprint(errmsg, "The near cache returned a value after the key was deleted.");
+		st_cleanup(value);
+		return false;
+	}
+
+	// A fill which started before an invalidation must be refused, otherwise a reader could store a value it fetched before a write.
+	if (cache_near_enabled()) {
+
+		token = cache_near_token();
+		cache_near_delete(key);
+		cache_near_set(key, PLACER("stale", 5), token);
+
+		if ((value = cache_near_get(key))) {
+			st_sprint(errmsg, "The near cache accepted a fill which started before the key was invalidated.");
+			st_free(value);
+			cache_near_delete(key);
+			return false;
+		}
+
+		token = cache_near_token();
+		cache_near_set(key, PLACER("fresh", 5), token);
+
+		if (!(value = cache_near_get(key)) || st_cmp_cs_eq(value, PLACER("fresh", 5))) {
+			st_sprint(errmsg, "The near cache refused a fill which started after the key was invalidated.");
+			st_cleanup(value);
+			cache_near_delete(key);
+			return false;
+		}
+
+		st_free(value);
+		cache_near_delete(key);
+	}
+
+	// Counters are read using an offset of zero, which should always reflect the most recent local increment.
+	if (!(serial = cache_increment(counter, 1, 1, 60)) || cache_increment(counter, 0, 0, 60) != serial ||
+		cache_increment(counter, 1, 1, 60) != serial + 1 || cache_increment(counter, 0, 0, 60) != serial + 1) {
+		st_sprint(errmsg, "The near cache returned a stale counter value.");
+		cache_delete(counter);
+		return false;
+	}
+
+	cache_delete(counter);
+
+	return true;
+}
+
+/**
+ * @brief	Retrieve several keys using a single request, with one of the keys missing.
+ * @param	errmsg	a managed string which will receive a description of the first failure.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_cache_multi_sthread(stringer_t *errmsg) {
+
+	bool_t result = true;
+	uint64_t unique = rand_get_uint64();
+	stringer_t *keys[8], *values[8];
+
+	mm_wipe(keys, sizeof(keys));
+	mm_wipe(values, sizeof(values));
+
+	for (int_t i = 0; i < 8; i++) {
+		if (!(keys[i] = st_aprint("magma.check.multi.%lu.%i", unique, i)) || (i != 5 && cache_set(keys[i], keys[i], 60) != 1)) {
+			st_sprint(errmsg, "Unable to store the keys used by the multiple key check.");
+			result = false;
+		}
+	}
+
+	if (result && cache_get_multi(8, keys, values) != 7) {
+		st_sprint(errmsg, "The wrong number of keys were returned by a multiple key request.");
+		result = false;
+	}
+
+	for (int_t i = 0; result && i < 8; i++) {
+		if ((i == 5 && values[i]) || (i != 5 && (!values[i] || st_cmp_cs_eq(values[i], keys[i])))) {
+			st_sprint(errmsg, "The wrong value was returned by a multiple key request. { key = %i }", i);
+			result = false;
+		}
+	}
+
+	for (int_t i = 0; i < 8; i++) {
+		if (keys[i] && i != 5) cache_delete(keys[i]);
+		st_cleanup(keys[i], values[i]);
+	}
+
+	return result;
+}
@@ -0,0 +1,138 @@
+
+/**
+ * @file /check/magma/providers/database_check.c
+ *
+ * @brief Check the prepared statement cursors, and the read replica statement classifier.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Make sure only plain SELECT statements are treated as safe to run against a read replica.
+ * @param	errmsg	a managed string which will receive a description of the first failure.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_database_classify_sthread(stringer_t *errmsg) {
+
+	struct {
+		chr_t *query;
+		bool_t read;
+	} queries[] = {
+		{ SELECT_DOMAINS, true },
+		{ SELECT_MESSAGES, true },
+		{ "  select foldernum FROM Folders", true },
+		{ "SELECT foldernum FROM Folders WHERE usernum = ? FOR UPDATE", false },
+		{ "SELECT foldernum FROM Folders WHERE usernum = ? LOCK IN SHARE MODE", false },
+		{ "INSERT INTO Folders (usernum) SELECT usernum FROM Users", false },
+		{ "UPDATE Folders SET `order` = ?", false },
+		{ "SELEC", false },
+		{ "", false }
+	};
+
+	for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+		if (sql_replica_classify(queries[i].query) != queries[i].read) {
+			st_sprint(errmsg, "The query was classified incorrectly. { query = %s }", queries[i].query);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Stream the configured domains using a cursor, and compare the rows with the same query stored in a result table. Then make
+ * 			sure oversized values are refused, and that cursors which are closed early release their connections.
+ * @param	errmsg	a managed string which will receive a description of the first failure.
+ * @return	true if all checks pass, otherwise false.
+ */
+bool_t check_database_stream_sthread(stringer_t *errmsg) {
+
+	int_t ret;
+	row_t *row;
+	table_t *table;
+	stmt_cursor_t stream;
+	MYSQL_BIND results[1];
+	chr_t domain[MAGMA_HOSTNAME_MAX + 1];
+	unsigned long length = 0;
+
+	mm_wipe(results, sizeof(results));
+
+	results[0].buffer_type = MYSQL_TYPE_STRING;
+	results[0].buffer_length = sizeof(domain) - 1;
+	results[0].buffer = domain;
+	results[0].length = &length;
+
+	if (!(table = stmt_get_result(stmts.select_domains, NULL))) {
+		st_sprint(errmsg, "Unable to fetch the domains using a result table.");
+		return false;
+	}
+	else if (!stmt_stream(&stream, stmts.select_domains, NULL, results)) {
+		st_sprint(errmsg, "Unable to open a cursor for the domains.");
+		res_table_free(table);
+		return false;
+	}
+
+	while ((ret = stmt_fetch_next(&stream)) == 1) {
+		if (!(row = res_row_next(table)) || res_field_length(row, 0) != length || mm_cmp_cs_eq(res_field_block(row, 0), domain, length)) {
+			st_sprint(errmsg, "The streamed row didn't match the stored row. { row = %lu }", stream.rows);
+			stmt_stream_close(&stream);
+			res_table_free(table);
+			return false;
+		}
+	}
+
+	if (ret || stream.rows != res_row_count(table)) {
+		st_sprint(errmsg, "The cursor returned the wrong number of rows. { streamed = %lu / stored = %lu }", stream.rows,
+			res_row_count(table));
+		stmt_stream_close(&stream);
+		res_table_free(table);
+		return false;
+	}
+
+	stmt_stream_close(&stream);
+	res_table_free(table);
+
+	// Closing the cursor should discard any unread rows, and leave the statement ready to use again.
+	if (!stmt_stream(&stream, stmts.select_domains, NULL, results) || stmt_fetch_next(&stream) < 0) {
+		st_sprint(errmsg, "Unable to reuse the domain statement after the cursor was closed.");
+		stmt_stream_close(&stream);
+		return false;
+	}
+
+	stmt_stream_close(&stream);
+
+	// A value which doesn't fit inside its buffer should be reported as an error, instead of being silently truncated.
+	results[0].buffer_length = 1;
+
+	if (!stmt_stream(&stream, stmts.select_domains, NULL, results) || stmt_fetch_next(&stream) != -1 || stream.rows) {
+		st_sprint(errmsg, "A streamed value which was larger than its buffer wasn't reported as an error.");
+		stmt_stream_close(&stream);
+		return false;
+	}
+
+	stmt_stream_close(&stream);
+	results[0].buffer_length = sizeof(domain) - 1;
+
+	// Closing a cursor after a single row must return the connection to its pool, so opening more cursors than there are
+	// connections would stall, and eventually fail, if the early close leaked them.
+	for (uint64_t i = 0; i <= (uint64_t)magma.iface.database.pool.connections + magma.iface.database.replica.connections; i++) {
+		if (!stmt_stream(&stream, stmts.select_domains, NULL, results) || stmt_fetch_next(&stream) != 1 || stream.rows != 1) {
+			st_sprint(errmsg, "Unable to fetch a row after closing the previous cursor early. { cursor = %lu }", i);
+			stmt_stream_close(&stream);
+			return false;
+		}
+
+		stmt_stream_close(&stream);
+	}
+
+	// The unread rows should have been discarded, so the complete result set is available once the statement is used again.
+	if (!(table = stmt_get_result(stmts.select_domains, NULL)) || !res_row_count(table)) {
+		st_sprint(errmsg, "Unable to fetch the domains using a result table after the cursors were closed early.");
+		if (table) res_table_free(table);
+		return false;
+	}
+
+	res_table_free(table);
+
+	return true;
+}
@@ -13,6 +13,14 @@
 #include "magma_check.h"
 
 extern DKIM_LIB *dkim_engine;
+extern dkim_signer_t dkim_signer;
+
+// The public key used to sign the test messages, which is published at bazinga._domainkey.magmadaemon.com.
+static chr_t *check_dkim_bazinga_key = "v=DKIM1; k=rsa; p=MIIBIjANBgkqhkiG9w0BAQEFAAOCAQ8AMIIBCgKCAQEAu0AH7Y9nzercUWi5Qqt"
+	"4UUvKg8iRx1WJnGVVCCLYBQ2F4GgbFhs8w1tqGE7\\Ouaea/IH2v6K3bzM54/GYTmPLBX41krRX6AhTnMN66Qyc3RJR"
+	"cmiHXB+DIrLbpja5inrlErt2PO4SWSsr0s2Az+rTr4AkXdE7+Lsbwg br48QCGwCLVikgrTR9GSqDtWbLRWks7HPiEx"
+	"ADpfpru4amaX0CWs5DaANbM/ujJvddXeZBAsV9zpGK+tLMoSrYzZ+TdHE5/2TuK9SlC+UAS1oUexrbt7d7hepVmmVoJ"
+	"4g/Me3x8AASGhNIK55TCG4u6/jEUVXIpAlTZTdTKM/i+BB/Z22+3wIDAQAB";
 
 bool_t check_dkim_verify_sthread(stringer_t *errmsg) {
 
@@ -60,11 +68,7 @@ bool_t check_dkim_verify_sthread(stringer_t *errmsg) {
 			// Push the following public key onto the stack for verification purposes. Note that the public key passed in
 			// must match the message being checked.
 			if (dkim_test_dns_put_d(context, C_IN, T_TXT, 0, (uchr_t *)"bazinga._domainkey.magmadaemon.com",
-				(uchr_t *)"v=DKIM1; k=rsa; p=MIIBIjANBgkqhkiG9w0BAQEFAAOCAQ8AMIIBCgKCAQEAu0AH7Y9nzercUWi5Qqt"
-				"4UUvKg8iRx1WJnGVVCCLYBQ2F4GgbFhs8w1tqGE7\\Ouaea/IH2v6K3bzM54/GYTmPLBX41krRX6AhTnMN66Qyc3RJR"
-				"cmiHXB+DIrLbpja5inrlErt2PO4SWSsr0s2Az+rTr4AkXdE7+Lsbwg br48QCGwCLVikgrTR9GSqDtWbLRWks7HPiEx"
-				"ADpfpru4amaX0CWs5DaANbM/ujJvddXeZBAsV9zpGK+tLMoSrYzZ+TdHE5/2TuK9SlC+UAS1oUexrbt7d7hepVmmVoJ"
-				"4g/Me3x8AASGhNIK55TCG4u6/jEUVXIpAlTZTdTKM/i+BB/Z22+3wIDAQAB") != DKIM_STAT_OK) {
+				(uchr_t *)check_dkim_bazinga_key) != DKIM_STAT_OK) {
 
 				st_sprint(errmsg, "Unable to push the DKIM public key onto the DNS resolver stack.");
 				dkim_free_d(context);
@@ -119,6 +123,74 @@ bool_t check_dkim_verify_sthread(stringer_t *errmsg) {
 	return true;
 }
 
+/**
+ * @brief	Verify the signed test messages twice, using the key record cache.
+ * @note	The test key is stored in the cache before the messages are verified, so the library never needs to query DNS,
+ * 			and every key lookup made by either pass should be a cache hit.
+ */
+bool_t check_dkim_cache_sthread(stringer_t *errmsg) {
+
+	stringer_t *id = NULL, *data = NULL;
+	chr_t name[] = "bazinga._domainkey.magmadaemon.com";
+	uint64_t hits, misses;
+	uint32_t checked = 0, max = check_message_max();
+	uchr_t key[CHECKERS_CACHE_KEY_LENGTH];
+
+	if (!dkim_cache_key(name, ns_length_get(name), key)) {
+		st_sprint(errmsg, "Unable to calculate the cache key for the DKIM test key record.");
+		return false;
+	}
+
+	dkim_cache_set(key, check_dkim_bazinga_key, ns_length_get(check_dkim_bazinga_key), magma.dkim.cache.timeout);
+
+	hits = stats_get_value_by_name("provider.dkim.cache.hits");
+	misses = stats_get_value_by_name("provider.dkim.cache.misses");
+
+	for (uint32_t pass = 0; pass < 2; pass++) {
+		for (uint32_t i = 0; i < max; i++) {
+
+			if (!check_message_dkim_verify(i)) {
+				continue;
+			}
+			else if (!(id = rand_choices("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789", 12, NULL))) {
+				st_sprint(errmsg, "Failed to generate the message id.");
+				return false;
+			}
+			else if (!(data = check_message_get(i))) {
+				st_sprint(errmsg, "Failed to get the message data. { message = %i }", i);
+				st_free(id);
+				return false;
+			}
+			else if (dkim_signature_verify(id, data) != 1) {
+				st_sprint(errmsg, "DKIM verification using the cached key record failed. { message = %i / pass = %u }", i, pass + 1);
+				st_free(data);
+				st_free(id);
+				return false;
+			}
+
+			st_free(data);
+			st_free(id);
+			checked++;
+		}
+	}
+
+	if (!checked) {
+		st_sprint(errmsg, "None of the test messages were suitable candidates for domain key verification.");
+		return false;
+	}
+	else if (stats_get_value_by_name("provider.dkim.cache.misses") != misses) {
+		st_sprint(errmsg, "The DKIM key record cache missed a key which was stored before the messages were verified.");
+		return false;
+	}
+	else if (stats_get_value_by_name("provider.dkim.cache.hits") < hits + checked) {
+		st_sprint(errmsg, "The DKIM key record cache wasn't used for every verification. { checked = %u / hits = %lu }", checked,
+			stats_get_value_by_name("provider.dkim.cache.hits") - hits);
+		return false;
+	}
+
+	return true;
+}
+
 bool_t check_dkim_sign_sthread(stringer_t *domain, stringer_t *errmsg) {
 
 	uint32_t checked = 0, max = check_message_max();
@@ -253,3 +325,113 @@ bool_t check_dkim_sign_mthread(stringer_t *errmsg) {
 	mm_free(threads);
 	return result;
 }
+
+/**
+ * @brief	Replace the contents of a DKIM private key file, and give it a new modification time so the change is noticed.
+ * @param	path		a managed string holding the location of the key file.
+ * @param	contents	the data which should be written to the file.
+ * @param	modified	the modification time which should be given to the file.
+ * @return	true on success, or false on failure.
+ */
+bool_t check_dkim_refresh_write(stringer_t *path, stringer_t *contents, time_t modified) {
+
+	int fd;
+	ssize_t written;
+	struct timeval times[2] = { { .tv_sec = modified, .tv_usec = 0 }, { .tv_sec = modified, .tv_usec = 0 } };
+
+	if ((fd = open(st_char_get(path), O_WRONLY | O_TRUNC)) < 0) {
+		return false;
+	}
+
+	written = write(fd, st_data_get(contents), st_length_get(contents));
+	close(fd);
+
+	if (written != st_length_get(contents) || utimes(st_char_get(path), times)) {
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Check that the DKIM signer reloads a replaced key file, and keeps using the current key if the replacement is invalid.
+ * @note	The signer is pointed at a private copy of the key file, so the configured key file is never modified.
+ * @param	errmsg	a managed string which will receive an error message on failure.
+ * @return	true if the check passes, otherwise false.
+ */
+bool_t check_dkim_refresh_sthread(stringer_t *errmsg) {
+
+	int fd;
+	int_t state;
+	bool_t result = true;
+	time_t modified, now = time(NULL);
+	stringer_t *path = NULL, *original = NULL, *contents = NULL, *signature = NULL, *current = NULL,
+		*message = NULLER("From: <sender@magmadaemon.com>\r\nTo: <recipient@magmadaemon.com>\r\nSubject: DKIM Refresh\r\n\r\n" \
+			"The signing key was reloaded.\r\n");
+
+	if (!dkim_signer.path) {
+		return true;
+	}
+	else if (!(contents = file_load(st_char_get(dkim_signer.path))) || (fd = file_temp_handle(NULL, &path)) < 0) {
+		st_sprint(errmsg, "Unable to copy the DKIM private key file.");
+		st_cleanup(contents);
+		return false;
+	}
+
+	close(fd);
+
+	// Point the signer at the copy.
+	original = dkim_signer.path;
+	modified = dkim_signer.modified;
+	dkim_signer.path = path;
+
+	// Rewriting the file with a valid key should cause it to be reloaded.
+	if (!check_dkim_refresh_write(path, contents, now + 1)) {
+		st_sprint(errmsg, "Unable to write the copy of the DKIM private key file.");
+		result = false;
+	}
+	else if ((state = dkim_signer_refresh()) != 1 || st_cmp_cs_eq(magma.dkim.key, contents)) {
+		st_sprint(errmsg, "The DKIM private key wasn't reloaded after the key file was rewritten. { result = %i }", state);
+		result = false;
+	}
+	else if (!(signature = dkim_signature_create(NULLER("refresh"), NULL, message))) {
+		st_sprint(errmsg, "Unable to sign a message using the reloaded DKIM private key.");
+		result = false;
+	}
+
+	st_cleanup(signature);
+	signature = NULL;
+	current = magma.dkim.key;
+
+	// A replacement which isn't a valid key should be refused, and the current key should remain in use.
+	if (result && !check_dkim_refresh_write(path, NULLER("This isn't a private key."), now + 2)) {
+		st_sprint(errmsg, "Unable to write the invalid DKIM private key file.");
+		result = false;
+	}
+	else if (result && ((state = dkim_signer_refresh()) != -1 || magma.dkim.key != current || st_cmp_cs_eq(magma.dkim.key, contents))) {
+		st_sprint(errmsg, "An invalid DKIM private key file replaced the current key. { result = %i }", state);
+		result = false;
+	}
+	else if (result && !(signature = dkim_signature_create(NULLER("refresh"), NULL, message))) {
+		st_sprint(errmsg, "Unable to sign a message after an invalid DKIM private key file was refused.");
+		result = false;
+	}
+
+	// The refused file shouldn't be loaded again until it's replaced.
+	else if (result && (state = dkim_signer_refresh()) != 0) {
+		st_sprint(errmsg, "The refused DKIM private key file was loaded again before it changed. { result = %i }", state);
+		result = false;
+	}
+
+	st_cleanup(signature);
+
+	// Point the signer back at the configured key file.
+	dkim_signer.path = original;
+	dkim_signer.modified = modified;
+
+	unlink(st_char_get(path));
+	st_free(contents);
+	st_free(path);
+
+	return result;
+}
@@ -62,6 +62,62 @@ bool_t check_hmac_simple(void) {
 	return true;
 }
 
+/**
+ * @brief	Expand a secret using the TLS 1.2 PRF used to derive the kernel TLS record keys, and compare the output with the published
+ * 			test vectors for the SHA256 and SHA384 variants.
+ * @return	True on successful comparisons, false if at least one failed.
+ */
+bool_t check_hmac_prf(void) {
+
+	uchr_t output[148];
+	stringer_t *secret, *seed, *expected, *hex;
+	struct {
+		const EVP_MD *(*md)(void);
+		chr_t *secret, *seed, *expected;
+	} vectors[] = {
+		{
+			EVP_sha256_d,
+			"9bbe436ba940f017b17652849a71db35",
+			"a0ba9f936cda311827a6f796ffd5198c",
+			"e3f229ba727be17b8d122620557cd453c2aab21d07c3d495329b52d4e61edb5a6b301791e90d35c9c9a46b4e14baf9af0fa022f7077def17abfd3797c0564bab4fbc91666e9def9b97fce34f796789baa48082d122ee42c5a72e5a5110fff70187347b66"
+		},
+		{
+			EVP_sha384_d,
+			"b80b733d6ceefcdc71566ea48e5567df",
+			"cd665cf6a8447dd6ff8b27555edb7465",
+			"7b0c18e9ced410ed1804f2cfa34a336a1c14dffb4900bb5fd7942107e81c83cde9ca0faa60be9fe34f82b1233c9146a0e534cb400fed2700884f9dc236f80edd8bfa961144c9e8d792eca722a7b32fc3d416d473ebc2c5fd4abfdad05d9184259b5bf8cd4d90fa0d31e2dec479e4f1a26066f2eea9a69236a3e52655c9e9aee691c8f3a26854308d5eaa3be85e0990703d73e56f"
+		}
+	};
+
+	for (uint64_t i = 0; status() && i < (sizeof(vectors) / sizeof(*vectors)); ++i) {
+
+		expected = NULLER(vectors[i].expected);
+		secret = hex_decode_st(NULLER(vectors[i].secret), NULL);
+		seed = hex_decode_st(NULLER(vectors[i].seed), NULL);
+
+		if (!secret || !seed || !ktls_prf(vectors[i].md(), st_data_get(secret), st_length_get(secret), "test label", st_data_get(seed),
+			st_length_get(seed), output, st_length_get(expected) / 2)) {
+			st_cleanup(secret, seed);
+			return false;
+		}
+
+		st_free(secret);
+		st_free(seed);
+
+		if (!(hex = hex_encode_st(PLACER(output, st_length_get(expected) / 2), NULL))) {
+			return false;
+		}
+		else if (st_cmp_cs_eq(hex, expected)) {
+			st_free(hex);
+			return false;
+		}
+
+		st_free(hex);
+	}
+
+	return true;
+}
+
 bool_t check_hmac_parameters(void) {
 
 	digest_t *temp_dig;
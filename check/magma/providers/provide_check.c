@@ -331,12 +331,14 @@ START_TEST (check_hmac_s) {
 	bool_t outcome = true;
 	bool_t (*checks[])(void) = {
 		&check_hmac_parameters,
-		&check_hmac_simple
+		&check_hmac_simple,
+		&check_hmac_prf
 	};
 	stringer_t *err = NULL;
 	stringer_t *errors[] = {
 		NULLER("check_hmac_parameters failed"),
-		NULLER("check_hmac_simple failed")
+		NULLER("check_hmac_simple failed"),
+		NULLER("check_hmac_prf failed")
 	};
 
 	for(uint_t i = 0; status() && !err && i < sizeof(checks)/sizeof((checks)[0]); ++i) {
@@ -436,6 +438,7 @@ END_TEST
 START_TEST (check_spf_s) {
 
 	log_disable();
+	uint64_t hits = 0;
 	chr_t *errmsg = NULL;
 	SPF_server_t *object;
 	SPF_dns_server_t *spf_dns_zone = NULL;
@@ -488,6 +491,21 @@ START_TEST (check_spf_s) {
 		if (!errmsg && spf_check(&ip[1], NULLER("mx.lavabit.com"), NULLER("support@fail.lavabit.com")) != 1) {
 			errmsg = "The localhost address matched a failure record instead of being whitelisted. { support@fail.lavabit.com / 127.0.0.1 }";
 		}
+
+		// Repeat the checks, which should be answered by the outcome cache when it's enabled.
+		hits = stats_get_value_by_name("provider.spf.cache.hits");
+
+		if (!errmsg && (spf_check(&ip[0], NULLER("mx.lavabit.com"), NULLER("support@pass.lavabit.com")) != 1 ||
+			spf_check(&ip[0], NULLER("mx.lavabit.com"), NULLER("support@fail.lavabit.com")) != -2 ||
+			spf_check(&ip[1], NULLER("mx.lavabit.com"), NULLER("support@fail.lavabit.com")) != 1)) {
+			errmsg = "A repeated SPF check returned a different outcome than the original check.";
+		}
+
+		// The pass and fail outcomes for the remote address were stored above, so both repeats should be cache hits.
+		if (!errmsg && magma.iface.spf.cache.entries && magma.iface.spf.cache.timeout &&
+			stats_get_value_by_name("provider.spf.cache.hits") < hits + 2) {
+			errmsg = "The repeated SPF checks weren't answered by the outcome cache.";
+		}
 	}
 
 	log_test("CHECKERS / SPF / SINGLE THREADED:", NULLER(errmsg));
@@ -511,6 +529,22 @@ START_TEST (check_virus_s) {
 }
 END_TEST
 
+START_TEST (check_virus_cache_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	// If the anti-virus engine, or the verdict cache, is disabled we skip this tests.
+	if (status() && magma.iface.virus.available && virus_cache_enabled()) result = check_virus_cache_sthread(errmsg);
+	if (status() && result && magma.iface.virus.available && virus_cache_enabled()) result = check_virus_cache_hit_sthread(errmsg);
+	if (status() && result && magma.iface.virus.available && virus_cache_enabled()) result = check_virus_cache_headers_sthread(errmsg);
+
+	log_test("CHECKERS / VIRUS / CACHE / SINGLE THREADED:", (magma.iface.virus.available && virus_cache_enabled() ? errmsg : NULLER("SKIPPED")));
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 //! Spam Checker Tests
 START_TEST (check_dspam_mail_s) {
 
@@ -544,6 +578,88 @@ START_TEST (check_dspam_bin_s) {
 }
 END_TEST
 
+//! Cache Tests
+START_TEST (check_cache_near_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_cache_near_sthread(errmsg);
+
+	log_test("PROVIDERS / CACHE / NEAR / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_database_classify_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_database_classify_sthread(errmsg);
+
+	log_test("PROVIDERS / DATABASE / CLASSIFY / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_database_stream_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_database_stream_sthread(errmsg);
+
+	log_test("PROVIDERS / DATABASE / STREAM / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_cache_multi_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) result = check_cache_multi_sthread(errmsg);
+
+	log_test("PROVIDERS / CACHE / MULTI / SINGLE THREADED:", errmsg);
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+//! TLS Session Ticket Tests
+START_TEST (check_tickets_resume_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	// If session tickets are disabled we skip these tests.
+	if (status() && tls_tickets_enabled()) result = check_tickets_resume_sthread(errmsg);
+
+	log_test("CRYPTOGRAPHY / TICKETS / RESUME / SINGLE THREADED:", (tls_tickets_enabled() ? errmsg : NULLER("SKIPPED")));
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_tickets_reload_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	// If session tickets are disabled we skip these tests.
+	if (status() && tls_tickets_enabled()) result = check_tickets_reload_sthread(errmsg);
+
+	log_test("CRYPTOGRAPHY / TICKETS / RELOAD / SINGLE THREADED:", (tls_tickets_enabled() ? errmsg : NULLER("SKIPPED")));
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 //! DKIM Tests
 START_TEST (check_dkim_verify_s) {
 
@@ -559,6 +675,20 @@ START_TEST (check_dkim_verify_s) {
 }
 END_TEST
 
+START_TEST (check_dkim_cache_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	// If the DKIM engine, or the key record cache, is disabled we skip these tests.
+	if (status() && magma.dkim.enabled && dkim_cache_enabled()) result = check_dkim_cache_sthread(errmsg);
+
+	log_test("CHECKERS / DKIM / CACHE / SINGLE THREADED:", (magma.dkim.enabled && dkim_cache_enabled() ? errmsg : NULLER("SKIPPED")));
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_dkim_sign_s) {
 
 	log_disable();
@@ -574,6 +704,20 @@ START_TEST (check_dkim_sign_s) {
 }
 END_TEST
 
+START_TEST (check_dkim_refresh_s) {
+
+	log_disable();
+	bool_t result = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	// If the DKIM engine is disabled we skip these tests.
+	if (status() && magma.dkim.enabled) result = check_dkim_refresh_sthread(errmsg);
+
+	log_test("CHECKERS / DKIM / REFRESH / SINGLE THREADED:", (magma.dkim.enabled ? errmsg : NULLER("SKIPPED")));
+	ck_assert_msg(result, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_dkim_sign_m) {
 
 	log_disable();
@@ -627,6 +771,13 @@ Suite * suite_check_provide(void) {
 	suite_check_testcase(s, "PROVIDERS", "Cryptography HMAC/S", check_hmac_s);
 	suite_check_testcase(s, "PROVIDERS", "Cryptography SYMMETRIC/S", check_symmetric_s);
 	suite_check_testcase(s, "PROVIDERS", "Cryptography SCRAMBLE/S", check_scramble_s);
+	suite_check_testcase(s, "PROVIDERS", "Cryptography TICKETS Resume/S", check_tickets_resume_s);
+	suite_check_testcase(s, "PROVIDERS", "Cryptography TICKETS Reload/S", check_tickets_reload_s);
+
+	suite_check_testcase(s, "PROVIDERS", "Cache Near/S", check_cache_near_s);
+	suite_check_testcase(s, "PROVIDERS", "Cache Multi/S", check_cache_multi_s);
+	suite_check_testcase(s, "PROVIDERS", "Database Classify/S", check_database_classify_s);
+	suite_check_testcase(s, "PROVIDERS", "Database Stream/S", check_database_stream_s);
 
 	// Tank functionality is temporarily disabled.
 	if (do_tank_check) {
@@ -650,6 +801,7 @@ Suite * suite_check_provide(void) {
 
 	if (do_virus_check) {
 		suite_check_testcase(s, "PROVIDERS", "Virus/S", check_virus_s);
+		suite_check_testcase(s, "PROVIDERS", "Virus Cache/S", check_virus_cache_s);
 	}
 	else {
 		log_unit("Skipping the virus scanning checks...\n");
@@ -657,8 +809,10 @@ Suite * suite_check_provide(void) {
 
 	if (do_dkim_check) {
 		suite_check_testcase(s, "PROVIDERS", "DKIM Verify/S", check_dkim_verify_s);
+		suite_check_testcase(s, "PROVIDERS", "DKIM Cache/S", check_dkim_cache_s);
 		suite_check_testcase(s, "PROVIDERS", "DKIM Signing/S", check_dkim_sign_s);
 		suite_check_testcase(s, "PROVIDERS", "DKIM Signing/M", check_dkim_sign_m);
+		suite_check_testcase(s, "PROVIDERS", "DKIM Refresh/S", check_dkim_refresh_s);
 	}
 	else {
 		log_unit("Skipping the DKIM checks...\n");
@@ -20,10 +20,34 @@ typedef struct {
 	uint64_t engine;
 } check_compress_opt_t;
 
+#define CHECK_TICKETS_STATE "The session state protected by a TLS session ticket."
+
+typedef struct {
+	int sealed_len;
+	uchr_t name[16], iv[16], sealed[64], mac[EVP_MAX_MD_SIZE];
+} check_tickets_ticket_t;
+
+/// cache_check.c
+bool_t   check_cache_multi_sthread(stringer_t *errmsg);
+bool_t   check_cache_near_sthread(stringer_t *errmsg);
+
+/// database_check.c
+bool_t   check_database_classify_sthread(stringer_t *errmsg);
+bool_t   check_database_stream_sthread(stringer_t *errmsg);
+
 /// dkim_check.c
 bool_t   check_dkim_sign_sthread(stringer_t *domain, stringer_t *errmsg);
 bool_t   check_dkim_verify_sthread(stringer_t *errmsg);
+bool_t   check_dkim_cache_sthread(stringer_t *errmsg);
 bool_t   check_dkim_sign_mthread(stringer_t *errmsg);
+bool_t   check_dkim_refresh_sthread(stringer_t *errmsg);
+bool_t   check_dkim_refresh_write(stringer_t *path, stringer_t *contents, time_t modified);
+
+/// tickets_check.c
+bool_t   check_tickets_issue(check_tickets_ticket_t *ticket);
+int_t    check_tickets_present(check_tickets_ticket_t *ticket);
+bool_t   check_tickets_reload_sthread(stringer_t *errmsg);
+bool_t   check_tickets_resume_sthread(stringer_t *errmsg);
 
 /// symmetric_check.c
 bool_t   check_symmetric_sthread(chr_t *name);
@@ -53,6 +77,10 @@ bool_t   check_dspam_mail_sthread(void);
 Suite *      suite_check_provide(void);
 
 /// virus_check.c
+bool_t check_virus_cache_headers_sthread(stringer_t *errmsg);
+bool_t check_virus_cache_hit_sthread(stringer_t *errmsg);
+stringer_t * check_virus_cache_message(uint64_t token, chr_t *type, chr_t *encoding, stringer_t *attachment);
+bool_t check_virus_cache_sthread(stringer_t *errmsg);
 bool_t check_virus_sthread(stringer_t *errmsg);
 
 /// ecies_check.c
@@ -66,6 +94,7 @@ bool_t   check_hash_sthread(chr_t *name);
 /// hmac_check.c
 bool_t   check_hmac_simple(void);
 bool_t   check_hmac_parameters(void);
+bool_t   check_hmac_prf(void);
 
 /// compress_check.c
 bool_t   check_compress_mthread(check_compress_opt_t *opts);
@@ -0,0 +1,215 @@
+/**
+ * @file /check/magma/providers/tickets_check.c
+ *
+ * @brief The logic used to test the TLS session ticket keys.
+ */
+
+#include "magma_check.h"
+
+/**
+ * @brief	Issue a session ticket the way OpenSSL does, by encrypting and authenticating a block of session state using the keys
+ * 			provided by the ticket callback.
+ * @param	ticket	the ticket which will receive the key name, initialization vector, encrypted state and HMAC.
+ * @return	true on success, or false on failure.
+ */
+bool_t check_tickets_issue(check_tickets_ticket_t *ticket) {
+
+	int length = 0;
+	HMAC_CTX hmac;
+	bool_t result = false;
+	EVP_CIPHER_CTX cipher;
+	uint_t mac_len = 0;
+
+	HMAC_CTX_init_d(&hmac);
+	EVP_CIPHER_CTX_init_d(&cipher);
+
+	if (tls_tickets_callback(NULL, ticket->name, ticket->iv, &cipher, &hmac, 1) == 1 &&
+		EVP_EncryptUpdate_d(&cipher, ticket->sealed, &length, (uchr_t *)CHECK_TICKETS_STATE, sizeof(CHECK_TICKETS_STATE)) == 1 &&
+		EVP_EncryptFinal_ex_d(&cipher, ticket->sealed + length, &(ticket->sealed_len)) == 1 &&
+		HMAC_Update_d(&hmac, ticket->name, sizeof(ticket->name)) == 1 && HMAC_Update_d(&hmac, ticket->iv, sizeof(ticket->iv)) == 1 &&
+		HMAC_Update_d(&hmac, ticket->sealed, (ticket->sealed_len += length)) == 1 && HMAC_Final_d(&hmac, ticket->mac, &mac_len) == 1) {
+		result = true;
+	}
+
+	EVP_CIPHER_CTX_cleanup_d(&cipher);
+	HMAC_CTX_cleanup_d(&hmac);
+
+	return result;
+}
+
+/**
+ * @brief	Present a session ticket the way a resuming client would, and make sure the ticket can be authenticated and decrypted.
+ * @param	ticket	the ticket which was issued by check_tickets_issue().
+ * @return	the value returned by the ticket callback, which is 1 if the ticket was accepted, 2 if the ticket was accepted but should be
+ * 			replaced, 0 if the key which issued the ticket is unknown, or -1 if the ticket couldn't be authenticated and decrypted.
+ */
+int_t check_tickets_present(check_tickets_ticket_t *ticket) {
+
+	HMAC_CTX hmac;
+	int_t result;
+	EVP_CIPHER_CTX cipher;
+	uint_t mac_len = 0;
+	int length = 0, final = 0;
+	uchr_t mac[EVP_MAX_MD_SIZE], state[sizeof(ticket->sealed)];
+
+	HMAC_CTX_init_d(&hmac);
+	EVP_CIPHER_CTX_init_d(&cipher);
+
+	if ((result = tls_tickets_callback(NULL, ticket->name, ticket->iv, &cipher, &hmac, 0)) > 0 &&
+		(HMAC_Update_d(&hmac, ticket->name, sizeof(ticket->name)) != 1 || HMAC_Update_d(&hmac, ticket->iv, sizeof(ticket->iv)) != 1 ||
+		HMAC_Update_d(&hmac, ticket->sealed, ticket->sealed_len) != 1 || HMAC_Final_d(&hmac, mac, &mac_len) != 1 ||
+		memcmp(mac, ticket->mac, mac_len) || EVP_DecryptUpdate_d(&cipher, state, &length, ticket->sealed, ticket->sealed_len) != 1 ||
+		EVP_DecryptFinal_ex_d(&cipher, state + length, &final) != 1 || length + final != sizeof(CHECK_TICKETS_STATE) ||
+		memcmp(state, CHECK_TICKETS_STATE, sizeof(CHECK_TICKETS_STATE)))) {
+		result = -1;
+	}
+
+	EVP_CIPHER_CTX_cleanup_d(&cipher);
+	HMAC_CTX_cleanup_d(&hmac);
+
+	return result;
+}
+
+/**
+ * @brief	Check that a session ticket can be resumed using the current key, and after the keys have been rotated, until the key which
+ * 			issued the ticket is discarded.
+ * @note	The key rotations are performed directly, so this check must run while the servers are idle.
+ * @param	errmsg	a managed string which will receive an error message on failure.
+ * @return	true if the check passes, otherwise false.
+ */
+bool_t check_tickets_resume_sthread(stringer_t *errmsg) {
+
+	int_t state;
+	check_tickets_ticket_t ticket;
+
+	mm_wipe(&ticket, sizeof(check_tickets_ticket_t));
+
+	if (!check_tickets_issue(&ticket)) {
+		st_sprint(errmsg, "Unable to issue a session ticket.");
+		return false;
+	}
+	else if ((state = check_tickets_present(&ticket)) != 1) {
+		st_sprint(errmsg, "A session ticket issued using the current key couldn't be resumed. { result = %i }", state);
+		return false;
+	}
+
+	// Once the keys are rotated, the ticket should still be accepted, but the client should be given a replacement.
+	if (!tls_tickets_rotate()) {
+		st_sprint(errmsg, "Unable to rotate the session ticket keys.");
+		return false;
+	}
+	else if ((state = check_tickets_present(&ticket)) != 2) {
+		st_sprint(errmsg, "A session ticket issued using the previous key wasn't resumed and renewed. { result = %i }", state);
+		return false;
+	}
+
+	// After the issuing key has been rotated out, the ticket must be refused, so the client falls back to a full handshake.
+	for (uint_t i = 1; i < TLS_TICKET_KEYS; i++) {
+		if (!tls_tickets_rotate()) {
+			st_sprint(errmsg, "Unable to rotate the session ticket keys.");
+			return false;
+		}
+	}
+
+	if ((state = check_tickets_present(&ticket)) != 0) {
+		st_sprint(errmsg, "A session ticket issued using a discarded key was resumed. { result = %i }", state);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Check that the session ticket keys are reloaded when the key file changes, and that invalid key files are refused.
+ * @note	The keys are loaded from a private temporary file, so the configured key file is never modified.
+ * @param	errmsg	a managed string which will receive an error message on failure.
+ * @return	true if the check passes, otherwise false.
+ */
+bool_t check_tickets_reload_sthread(stringer_t *errmsg) {
+
+	int fd;
+	int_t state;
+	bool_t result = true;
+	uint64_t rotated;
+	time_t now = time(NULL);
+	stringer_t *path = NULL;
+	check_tickets_ticket_t before, first;
+	tls_ticket_key_t keys[2], swapped[2];
+
+	mm_wipe(&first, sizeof(check_tickets_ticket_t));
+	mm_wipe(&before, sizeof(check_tickets_ticket_t));
+
+	if (RAND_bytes_d((uchr_t *)keys, sizeof(keys)) != 1) {
+		st_sprint(errmsg, "Unable to generate the session ticket keys.");
+		return false;
+	}
+	else if ((fd = file_temp_handle(NULL, &path)) < 0) {
+		st_sprint(errmsg, "Unable to create a temporary session ticket key file.");
+		return false;
+	}
+
+	close(fd);
+
+	swapped[0] = keys[1];
+	swapped[1] = keys[0];
+
+	// A ticket issued using the generated keys shouldn't be recognized once the key file is loaded. Issuing the ticket also performs
+	// any refresh which is due, so the callback won't replace the keys from the temporary file while the check is running.
+	if (!check_tickets_issue(&before)) {
+		st_sprint(errmsg, "Unable to issue a session ticket.");
+		result = false;
+	}
+	else if (!check_dkim_refresh_write(path, PLACER(keys, sizeof(keys)), now + 1) || !tls_tickets_load(st_char_get(path))) {
+		st_sprint(errmsg, "Unable to load the session ticket key file.");
+		result = false;
+	}
+	else if (!check_tickets_issue(&first) || memcmp(first.name, keys[0].name, sizeof(first.name))) {
+		st_sprint(errmsg, "The first key in the session ticket key file wasn't used to issue a new ticket.");
+		result = false;
+	}
+	else if ((state = check_tickets_present(&before)) != 0) {
+		st_sprint(errmsg, "A session ticket issued before the key file was loaded was resumed. { result = %i }", state);
+		result = false;
+	}
+
+	// Loading the file again, without changing it, shouldn't replace the keys.
+	else if (!(rotated = stats_get_value_by_name("provider.tls.tickets.rotated")) || !tls_tickets_load(st_char_get(path)) ||
+		stats_get_value_by_name("provider.tls.tickets.rotated") != rotated) {
+		st_sprint(errmsg, "The session ticket key file was reloaded even though it didn't change.");
+		result = false;
+	}
+
+	// Promoting the second key should change the key used for new tickets, while tickets issued using the old first key are renewed.
+	else if (!check_dkim_refresh_write(path, PLACER(swapped, sizeof(swapped)), now + 2) || !tls_tickets_load(st_char_get(path)) ||
+		!check_tickets_issue(&before) || memcmp(before.name, keys[1].name, sizeof(before.name))) {
+		st_sprint(errmsg, "The session ticket keys weren't reloaded after the key file was rewritten.");
+		result = false;
+	}
+	else if ((state = check_tickets_present(&first)) != 2) {
+		st_sprint(errmsg, "A session ticket issued using a demoted key wasn't resumed and renewed. { result = %i }", state);
+		result = false;
+	}
+
+	// A file which doesn't hold a whole number of keys should be refused, and the current keys should remain in use.
+	else if (!check_dkim_refresh_write(path, PLACER(keys, sizeof(tls_ticket_key_t) + 1), now + 3) || tls_tickets_load(st_char_get(path))) {
+		st_sprint(errmsg, "An invalid session ticket key file was accepted.");
+		result = false;
+	}
+	else if ((state = check_tickets_present(&before)) != 1) {
+		st_sprint(errmsg, "An invalid session ticket key file replaced the current keys. { result = %i }", state);
+		result = false;
+	}
+
+	// Replace the keys from the temporary file, so they aren't used after the check.
+	for (uint_t i = 0; i < TLS_TICKET_KEYS; i++) {
+		tls_tickets_rotate();
+	}
+
+	mm_wipe(keys, sizeof(keys));
+	mm_wipe(swapped, sizeof(swapped));
+
+	unlink(st_char_get(path));
+	st_free(path);
+
+	return result;
+}
@@ -30,3 +30,159 @@
 
 	return true;
 }
+
+bool_t check_virus_cache_sthread(stringer_t *errmsg) {
+
+	int first, second;
+	stringer_t *data = NULL;
+	uint32_t max = check_message_max();
+
+	if (!virus_cache_enabled()) {
+		return true;
+	}
+
+	// Scanning each message twice should produce the same verdict, whether or not the second scan is answered by the cache.
+	for (uint32_t i = 0; i < max && status(); i++) {
+
+		if (!(data = check_message_get(i))) {
+			st_sprint(errmsg, "Failed to get the message data. { message = %i }", i);
+			return false;
+		}
+		else if ((first = virus_check(data)) == -1 || (second = virus_check(data)) != first) {
+			st_sprint(errmsg, "The cached virus verdict didn't match the original scan. { message = %i }", i);
+			st_free(data);
+			return false;
+		}
+
+		st_free(data);
+	}
+
+	// Once the cache is flushed, the message parts should be scanned again.
+	virus_cache_flush();
+
+	if ((data = check_message_get(0)) && virus_check(data) == -1) {
+		st_sprint(errmsg, "The virus checker returned an error after the verdict cache was flushed.");
+		st_free(data);
+		return false;
+	}
+
+	st_cleanup(data);
+
+	return true;
+}
+
+/**
+ * @brief	Build a two part message for the verdict cache checks.
+ * @param	token		a unique value placed in the text part, so the message isn't answered by verdicts cached during earlier runs.
+ * @param	type		the Content-Type used by the attachment.
+ * @param	encoding	the Content-Transfer-Encoding used by the attachment.
+ * @param	attachment	the encoded body of the attachment.
+ * @return	a managed string holding the message, or NULL on failure.
+ */
+stringer_t * check_virus_cache_message(uint64_t token, chr_t *type, chr_t *encoding, stringer_t *attachment) {
+
+	return st_aprint("From: <sender@example.com>\r\nTo: <recipient@example.com>\r\nSubject: Verdict Cache %lu\r\nMIME-Version: 1.0\r\n" \
+		"Content-Type: multipart/mixed; boundary=\"verdicts\"\r\n\r\n--verdicts\r\nContent-Type: text/plain\r\n\r\nThe attachment " \
+		"is identified by %lu.\r\n--verdicts\r\nContent-Type: %s\r\nContent-Transfer-Encoding: %s\r\n\r\n%.*s\r\n--verdicts--\r\n",
+		token, token, type, encoding, st_length_int(attachment), st_char_get(attachment));
+}
+
+/**
+ * @brief	Check that a message whose parts were all found clean is answered by the verdict cache the next time it's scanned.
+ * @param	errmsg	a managed string which will receive an error message on failure.
+ * @return	true if the check passes, otherwise false.
+ */
+bool_t check_virus_cache_hit_sthread(stringer_t *errmsg) {
+
+	bool_t result = true;
+	uint64_t token = rand_get_uint64(), hits, misses;
+	stringer_t *raw = NULL, *attachment = NULL, *data = NULL;
+
+	if (!(raw = st_alloc(96)) || rand_write(raw) != 96 || !(attachment = base64_encode(raw, NULL)) ||
+		!(data = check_virus_cache_message(token, "application/octet-stream", "base64", attachment))) {
+		st_sprint(errmsg, "Unable to build the verdict cache message.");
+		result = false;
+	}
+	else if (virus_check(data) != 1) {
+		st_sprint(errmsg, "The verdict cache message wasn't found clean.");
+		result = false;
+	}
+	else {
+
+		hits = stats_get_value_by_name("provider.virus.cache.hits");
+		misses = stats_get_value_by_name("provider.virus.cache.misses");
+
+		// Both leaf parts should be answered by the cache, while the headers and structure are still scanned.
+		if (virus_check(data) != 1) {
+			st_sprint(errmsg, "The verdict cache message wasn't found clean when it was scanned again.");
+			result = false;
+		}
+		else if (stats_get_value_by_name("provider.virus.cache.hits") != hits + 2 ||
+			stats_get_value_by_name("provider.virus.cache.misses") != misses) {
+			st_sprint(errmsg, "The verdict cache didn't answer a message it had already found clean. { hits = %lu / misses = %lu }",
+				stats_get_value_by_name("provider.virus.cache.hits") - hits, stats_get_value_by_name("provider.virus.cache.misses") - misses);
+			result = false;
+		}
+	}
+
+	st_cleanup(raw, attachment, data);
+
+	return result;
+}
+
+/**
+ * @brief	Check that an attachment body is only answered by the verdict cache when its Content-Type and Content-Transfer-Encoding
+ * 			headers match the part which was originally scanned.
+ * @param	errmsg	a managed string which will receive an error message on failure.
+ * @return	true if the check passes, otherwise false.
+ */
+bool_t check_virus_cache_headers_sthread(stringer_t *errmsg) {
+
+	bool_t result = true;
+	uint64_t token = rand_get_uint64(), hits, misses;
+	stringer_t *raw = NULL, *attachment = NULL, *data = NULL;
+	struct {
+		chr_t *type, *encoding;
+	} labels[] = {
+		{ "application/x-msdownload", "base64" },
+		{ "application/octet-stream", "7bit" }
+	};
+
+	if (!(raw = st_alloc(96)) || rand_write(raw) != 96 || !(attachment = base64_encode(raw, NULL)) ||
+		!(data = check_virus_cache_message(token, "application/octet-stream", "base64", attachment))) {
+		st_sprint(errmsg, "Unable to build the verdict cache message.");
+		result = false;
+	}
+	else if (virus_check(data) != 1) {
+		st_sprint(errmsg, "The verdict cache message wasn't found clean.");
+		result = false;
+	}
+
+	// The same attachment body with a different label must be scanned again, while the unchanged text part is still a hit.
+	for (size_t i = 0; result && i < (sizeof(labels) / sizeof(*labels)); i++) {
+
+		st_cleanup(data);
+		hits = stats_get_value_by_name("provider.virus.cache.hits");
+		misses = stats_get_value_by_name("provider.virus.cache.misses");
+
+		if (!(data = check_virus_cache_message(token, labels[i].type, labels[i].encoding, attachment))) {
+			st_sprint(errmsg, "Unable to build the relabeled verdict cache message.");
+			result = false;
+		}
+		else if (virus_check(data) != 1) {
+			st_sprint(errmsg, "The relabeled verdict cache message wasn't found clean. { type = %s / encoding = %s }", labels[i].type,
+				labels[i].encoding);
+			result = false;
+		}
+		else if (stats_get_value_by_name("provider.virus.cache.hits") != hits + 1 ||
+			stats_get_value_by_name("provider.virus.cache.misses") != misses + 1) {
+			st_sprint(errmsg, "The verdict cache answered an attachment using the verdict for a part with different headers. " \
+				"{ type = %s / encoding = %s }", labels[i].type, labels[i].encoding);
+			result = false;
+		}
+	}
+
+	st_cleanup(raw, attachment, data);
+
+	return result;
+}
@@ -86,6 +86,26 @@ START_TEST (check_imap_network_fetch_s) {
 }
 END_TEST
 
+START_TEST (check_imap_network_idle_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(IMAP, false))) {
+		st_sprint(errmsg, "No IMAP servers were configured to support TCP connections.");
+		outcome = false;
+	}
+	else if (status() && !check_imap_network_idle_sthread(errmsg, server->network.port, false)) {
+		outcome = false;
+	}
+
+	log_test("IMAP / NETWORK / IDLE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 START_TEST (check_imap_network_starttls_s) {
 
 	log_disable();
@@ -108,6 +128,201 @@ START_TEST (check_imap_network_starttls_s) {
 }
 END_TEST
 
+START_TEST (check_imap_network_compress_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(IMAP, false))) {
+		st_sprint(errmsg, "No IMAP servers were configured to support TCP connections.");
+		outcome = false;
+	}
+	else if (status() && !check_imap_network_compress_sthread(errmsg, server->network.port, false)) {
+		outcome = false;
+	}
+
+	log_test("IMAP / NETWORK / COMPRESS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_imap_network_ktls_s) {
+
+	log_disable();
+	bool_t outcome = true, ktls = magma.iface.cryptography.ktls;
+	server_t *server = NULL;
+	uint64_t offloaded = 0, fallback = 0;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(IMAP, true))) {
+		st_sprint(errmsg, "No IMAP servers were configured to support TLS connections.");
+		outcome = false;
+	}
+	else if (status()) {
+
+		// With the option disabled, the server shouldn't even attempt the offload.
+		magma.iface.cryptography.ktls = false;
+		offloaded = stats_get_value_by_name("provider.tls.kernel.offloaded");
+		fallback = stats_get_value_by_name("provider.tls.kernel.fallback");
+
+		if (!check_imap_network_basic_sthread(errmsg, server->network.port, true)) {
+			outcome = false;
+		}
+		else if (stats_get_value_by_name("provider.tls.kernel.offloaded") != offloaded ||
+			stats_get_value_by_name("provider.tls.kernel.fallback") != fallback) {
+			st_sprint(errmsg, "The kernel TLS offload was attempted while it was disabled.");
+			outcome = false;
+		}
+
+		// The session must work the same way whether the kernel accepts the offload, or the connection falls back to OpenSSL,
+		// but it has to take exactly one of those paths. The server updates the counters before sending its greeting.
+		magma.iface.cryptography.ktls = true;
+		offloaded = stats_get_value_by_name("provider.tls.kernel.offloaded");
+		fallback = stats_get_value_by_name("provider.tls.kernel.fallback");
+
+		if (outcome && !check_imap_network_basic_sthread(errmsg, server->network.port, true)) {
+			outcome = false;
+		}
+		else if (outcome && (stats_get_value_by_name("provider.tls.kernel.offloaded") - offloaded) +
+			(stats_get_value_by_name("provider.tls.kernel.fallback") - fallback) != 1) {
+			st_sprint(errmsg, "The connection didn't take exactly one of the kernel TLS offload, or fallback, paths. "
+				"{ offloaded = %lu / fallback = %lu }", stats_get_value_by_name("provider.tls.kernel.offloaded") - offloaded,
+				stats_get_value_by_name("provider.tls.kernel.fallback") - fallback);
+			outcome = false;
+		}
+
+		// When the kernel provides TLS, the server prefers AES-GCM cipher suites, so the connection should have been offloaded.
+		else if (outcome && ktls_available() && stats_get_value_by_name("provider.tls.kernel.offloaded") - offloaded != 1) {
+			st_sprint(errmsg, "The connection fell back to OpenSSL even though kernel TLS is available.");
+			outcome = false;
+		}
+	}
+
+	magma.iface.cryptography.ktls = ktls;
+
+	log_test("IMAP / NETWORK / KERNEL TLS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_imap_range_build_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *range = NULL, *errmsg = MANAGEDBUF(1024);
+	uint64_t single[] = { 7 }, runs[] = { 1, 2, 3, 5, 7, 8, 10 }, gaps[] = { 2, 4, 6 }, large[] = { 4294967295UL, 4294967296UL, 4294967297UL };
+	struct {
+		size_t length;
+		uint64_t *numbers;
+		chr_t *expected;
+	} cases[] = {
+		{ 1, single, "7" },
+		{ sizeof(runs) / sizeof(uint64_t), runs, "1:3,5,7:8,10" },
+		{ sizeof(gaps) / sizeof(uint64_t), gaps, "2,4,6" },
+		{ sizeof(large) / sizeof(uint64_t), large, "4294967295:4294967297" }
+	};
+
+	if (status() && imap_range_build(0, runs)) {
+		st_sprint(errmsg, "An empty set of numbers produced a range.");
+		outcome = false;
+	}
+
+	for (size_t i = 0; status() && outcome && i < sizeof(cases) / sizeof(cases[0]); i++) {
+		if (!(range = imap_range_build(cases[i].length, cases[i].numbers)) || st_cmp_cs_eq(range, NULLER(cases[i].expected))) {
+			st_sprint(errmsg, "The range builder returned the wrong output. { expected = %s / output = %.*s }", cases[i].expected,
+				st_length_int(range), st_char_get(range));
+			outcome = false;
+		}
+		st_cleanup(range);
+		range = NULL;
+	}
+
+	log_test("IMAP / RANGE / BUILD / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_imap_range_vanished_s) {
+
+	log_disable();
+	inx_t *messages = NULL;
+	bool_t outcome = true;
+	meta_message_t holder[6];
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+	stringer_t *vanished = NULL, *errmsg = MANAGEDBUF(1024);
+	uint64_t numbers[] = { 1, 2, 5, 6, 9, 10 }, folders[] = { 1, 1, 1, 1, 1, 2 };
+	struct {
+		chr_t *range;
+		chr_t *expected;
+	} cases[] = {
+		{ NULL, "3:4,7:8,10" },
+		{ "2:6", "3:4" },
+		{ "6:*", "7:8,10" },
+		{ "8:3", "3:4,7:8" },
+		{ "4,7,20", "4,7" },
+		{ "1:2,5", NULL }
+	};
+
+	mm_wipe(holder, sizeof(holder));
+
+	// The first folder holds every message except the last one, which belongs to a different folder.
+	if (!(messages = inx_alloc(M_INX_LINKED, NULL))) {
+		st_sprint(errmsg, "Unable to allocate the message index.");
+		outcome = false;
+	}
+
+	for (size_t i = 0; outcome && i < sizeof(numbers) / sizeof(uint64_t); i++) {
+		holder[i].messagenum = key.val.u64 = numbers[i];
+		holder[i].foldernum = folders[i];
+		if (!inx_append(messages, key, &(holder[i]))) {
+			st_sprint(errmsg, "Unable to append a message to the index.");
+			outcome = false;
+		}
+	}
+
+	for (size_t i = 0; status() && outcome && i < sizeof(cases) / sizeof(cases[0]); i++) {
+
+		vanished = imap_range_vanished(messages, 1, cases[i].range ? NULLER(cases[i].range) : NULL);
+
+		if ((!cases[i].expected && vanished) || (cases[i].expected && st_cmp_cs_eq(vanished, NULLER(cases[i].expected)))) {
+			st_sprint(errmsg, "The vanished UID set was wrong. { range = %s / expected = %s / output = %.*s }", cases[i].range ? cases[i].range : "NULL",
+				cases[i].expected ? cases[i].expected : "NULL", st_length_int(vanished), st_char_get(vanished));
+			outcome = false;
+		}
+
+		st_cleanup(vanished);
+		vanished = NULL;
+	}
+
+	inx_cleanup(messages);
+
+	log_test("IMAP / RANGE / VANISHED / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
+START_TEST (check_imap_network_condstore_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(IMAP, false))) {
+		st_sprint(errmsg, "No IMAP servers were configured to support TCP connections.");
+		outcome = false;
+	}
+	else if (status() && !check_imap_network_condstore_sthread(errmsg, server->network.port, false)) {
+		outcome = false;
+	}
+
+	log_test("IMAP / NETWORK / CONDSTORE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+}
+END_TEST
+
 Suite * suite_check_imap(void) {
 
 	Suite *s = suite_create("\tIMAP");
@@ -117,6 +332,12 @@ Suite * suite_check_imap(void) {
 	suite_check_testcase(s, "IMAP", "IMAP Network Search/S", check_imap_network_search_s);
 	suite_check_testcase(s, "IMAP", "IMAP Network Fetch/S", check_imap_network_fetch_s);
 	suite_check_testcase(s, "IMAP", "IMAP Network STARTTLS/S", check_imap_network_starttls_s);
+	suite_check_testcase(s, "IMAP", "IMAP Network IDLE/S", check_imap_network_idle_s);
+	suite_check_testcase(s, "IMAP", "IMAP Network COMPRESS/S", check_imap_network_compress_s);
+	suite_check_testcase(s, "IMAP", "IMAP Network Kernel TLS/S", check_imap_network_ktls_s);
+	suite_check_testcase(s, "IMAP", "IMAP Range Build/S", check_imap_range_build_s);
+	suite_check_testcase(s, "IMAP", "IMAP Range Vanished/S", check_imap_range_vanished_s);
+	suite_check_testcase(s, "IMAP", "IMAP Network CONDSTORE/S", check_imap_network_condstore_s);
 
 	return s;
 }
@@ -9,8 +9,14 @@
 
 /// imap_check_network.c
 bool_t check_imap_client_read_end(client_t *client, chr_t *tag);
+bool_t check_imap_client_read_tag(client_t *client, chr_t *tag);
+bool_t check_imap_client_number(stringer_t *line, chr_t *label, uint64_t *number);
+bool_t check_imap_client_read_untagged(client_t *client, chr_t *tag, chr_t *prefix, stringer_t *found);
 bool_t check_imap_network_basic_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
+bool_t check_imap_network_compress_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
+bool_t check_imap_network_condstore_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_imap_network_fetch_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
+bool_t check_imap_network_idle_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_imap_network_search_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_imap_client_close_logout(client_t *client, uint32_t tag_num, stringer_t *errmsg);
 bool_t check_imap_client_select(client_t *client, chr_t *folder, chr_t *tag, stringer_t *errmsg);
@@ -445,3 +445,365 @@ bool_t check_imap_network_starttls_sthread(stringer_t *errmsg, uint32_t tcp_port
 	client_close(client);
 	return true;
 }
+
+bool_t check_imap_network_idle_sthread(stringer_t *errmsg, uint32_t port, bool_t secure) {
+
+	size_t location = 0;
+	client_t *client = NULL;
+
+	// Check the initial response.
+	if (!(client = client_connect("localhost", port)) || (secure && (client_secure(client) == -1)) ||
+		!net_set_timeout(client->sockd, 20, 20) || client_read_line(client) <= 0 || (client->status != 1) ||
+		st_cmp_cs_starts(&(client->line), NULLER("* OK"))) {
+
+		st_sprint(errmsg, "Failed to connect with the IMAP server.");
+		client_close(client);
+		return false;
+	}
+	// Check for IDLE in the capabilities.
+	else if (client_write(client, PLACER("A0 CAPABILITY\r\n", 15)) != 15 || client_read_line(client) <= 0 ||
+		!st_search_cs(&(client->line), PLACER(" IDLE", 5), &location) || !check_imap_client_read_end(client, "A0")) {
+
+		st_sprint(errmsg, "Failed to find IDLE advertised in the IMAP CAPABILITY response.");
+		client_close(client);
+		return false;
+	}
+	// Login and select the inbox.
+	else if (!check_imap_client_login(client, "princess", "password", "A1", errmsg) ||
+		!check_imap_client_select(client, "Inbox", "A2", errmsg)) {
+
+		client_close(client);
+		return false;
+	}
+	// Start idling and wait for the continuation.
+	else if (client_print(client, "A3 IDLE\r\n") != 9 || client_read_line(client) <= 0 ||
+		st_cmp_cs_starts(&(client->line), NULLER("+ "))) {
+
+		st_sprint(errmsg, "Failed to receive a continuation after IDLE.");
+		client_close(client);
+		return false;
+	}
+	// End the idle session. The server should still respond once the session has been suspended.
+	else if (client_print(client, "DONE\r\n") != 6 || !check_imap_client_read_end(client, "A3") || client_status(client) != 1 ||
+		st_cmp_cs_starts(&(client->line), NULLER("A3 OK"))) {
+
+		st_sprint(errmsg, "Failed to return a successful state after DONE.");
+		client_close(client);
+		return false;
+	}
+	// Make sure the session is still usable after idling.
+	else if (client_print(client, "A4 NOOP\r\n") != 9 || !check_imap_client_read_end(client, "A4") || client_status(client) != 1 ||
+		st_cmp_cs_starts(&(client->line), NULLER("A4 OK"))) {
+
+		st_sprint(errmsg, "Failed to return a successful state after NOOP.");
+		client_close(client);
+		return false;
+	}
+	// Close the client.
+	else if (!check_imap_client_close_logout(client, 5, errmsg)) {
+		client_close(client);
+		return false;
+	}
+
+	client_close(client);
+	return true;
+}
+
+bool_t check_imap_network_compress_sthread(stringer_t *errmsg, uint32_t port, bool_t secure) {
+
+	int64_t bytes;
+	bool_t found = false;
+	z_stream deflate, inflate;
+	size_t location = 0, length = 0;
+	client_t *client = NULL;
+	uchr_t compressed[1024], output[1024];
+
+	mm_wipe(&deflate, sizeof(z_stream));
+	mm_wipe(&inflate, sizeof(z_stream));
+
+	// Check the initial response.
+	if (!(client = client_connect("localhost", port)) || (secure && (client_secure(client) == -1)) ||
+		!net_set_timeout(client->sockd, 20, 20) || client_read_line(client) <= 0 || (client->status != 1) ||
+		st_cmp_cs_starts(&(client->line), NULLER("* OK"))) {
+
+		st_sprint(errmsg, "Failed to connect with the IMAP server.");
+		client_close(client);
+		return false;
+	}
+	// Check for COMPRESS=DEFLATE in the capabilities.
+	else if (client_write(client, PLACER("A0 CAPABILITY\r\n", 15)) != 15 || client_read_line(client) <= 0 ||
+		!st_search_cs(&(client->line), PLACER(" COMPRESS=DEFLATE", 17), &location) || !check_imap_client_read_end(client, "A0")) {
+
+		st_sprint(errmsg, "Failed to find COMPRESS=DEFLATE advertised in the IMAP CAPABILITY response.");
+		client_close(client);
+		return false;
+	}
+	// Login and enable compression. The tagged response is sent before compression starts.
+	else if (!check_imap_client_login(client, "princess", "password", "A1", errmsg) ||
+		client_print(client, "A2 COMPRESS DEFLATE\r\n") != 21 || !check_imap_client_read_end(client, "A2") ||
+		st_cmp_cs_starts(&(client->line), NULLER("A2 OK"))) {
+
+		if (st_empty(errmsg)) st_sprint(errmsg, "Failed to enable compression using the COMPRESS command.");
+		client_close(client);
+		return false;
+	}
+	else if (deflateInit2__d(&deflate, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY, ZLIB_VERSION, sizeof(z_stream)) != Z_OK ||
+		inflateInit2__d(&inflate, -15, ZLIB_VERSION, sizeof(z_stream)) != Z_OK) {
+
+		st_sprint(errmsg, "Failed to initialize the compression streams.");
+		client_close(client);
+		return false;
+	}
+
+	// Send a compressed NOOP command.
+	deflate.next_in = (uchr_t *)"A3 NOOP\r\n";
+	deflate.avail_in = 9;
+	deflate.next_out = compressed;
+	deflate.avail_out = sizeof(compressed);
+
+	if (deflate_d(&deflate, Z_SYNC_FLUSH) != Z_OK || client_write(client, PLACER(compressed, sizeof(compressed) - deflate.avail_out)) <= 0) {
+		st_sprint(errmsg, "Failed to send a compressed command.");
+		deflateEnd_d(&deflate);
+		inflateEnd_d(&inflate);
+		client_close(client);
+		return false;
+	}
+
+	// Read and decompress the response until we have the complete tagged line.
+	inflate.next_out = output;
+	inflate.avail_out = sizeof(output);
+
+	while (!found && (bytes = client_read(client)) > 0) {
+
+		inflate.next_in = (uchr_t *)st_char_get(client->buffer);
+		inflate.avail_in = bytes;
+
+		if (inflate_d(&inflate, Z_SYNC_FLUSH) != Z_OK) {
+			break;
+		}
+
+		length = sizeof(output) - inflate.avail_out;
+		st_length_set(client->buffer, 0);
+		found = st_search_cs(PLACER(output, length), PLACER("A3 OK", 5), &location);
+	}
+
+	deflateEnd_d(&deflate);
+	inflateEnd_d(&inflate);
+
+	if (!found) {
+		st_sprint(errmsg, "Failed to receive a compressed response to the NOOP command.");
+		client_close(client);
+		return false;
+	}
+
+	client_close(client);
+	return true;
+}
+
+/**
+ * @brief	Read the response to a command until the tagged line is found, regardless of the status it reports.
+ *
+ * @param	client	The client to read from (which should be connected to an IMAP server).
+ * @param	tag		The tag that identifies the command being answered.
+ *
+ * @return	True if the tagged line was found, otherwise false.
+ */
+bool_t check_imap_client_read_tag(client_t *client, chr_t *tag) {
+
+	stringer_t *prefix = st_quick(MANAGEDBUF(64), "%s ", tag);
+
+	while (client_read_line(client) > 0) {
+		if (!st_cmp_cs_starts(&(client->line), prefix)) return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief	Read the response to a command, and look for an untagged line which starts with the provided prefix.
+ *
+ * @param	client	The client to read from (which should be connected to an IMAP server).
+ * @param	tag		The tag that identifies the command being answered.
+ * @param	prefix	The prefix of the untagged line being searched for.
+ * @param	found	A stringer_t* which receives a copy of the first matching line, or NULL if the line isn't needed.
+ *
+ * @return	True if the command completed successfully and a matching line was found, otherwise false.
+ */
+bool_t check_imap_client_read_untagged(client_t *client, chr_t *tag, chr_t *prefix, stringer_t *found) {
+
+	bool_t matched = false;
+
+	while (client_read_line(client) > 0 && st_cmp_cs_starts(&(client->line), NULLER(tag))) {
+		if (!matched && !st_cmp_cs_starts(&(client->line), NULLER(prefix))) {
+			matched = !found || st_copy_in(found, st_data_get(&(client->line)), st_length_get(&(client->line)));
+		}
+	}
+
+	return matched && client_status(client) == 1 && !st_cmp_cs_starts(&(client->line), st_quick(MANAGEDBUF(64), "%s OK", tag));
+}
+
+/**
+ * @brief	Parse the number which follows a label inside a response line, like the value of a MODSEQ data item.
+ *
+ * @param	line	The response line to be searched.
+ * @param	label	The text which immediately precedes the number.
+ * @param	number	A pointer to the uint64_t which will receive the number.
+ *
+ * @return	True if the label was found and followed by a valid number, otherwise false.
+ */
+bool_t check_imap_client_number(stringer_t *line, chr_t *label, uint64_t *number) {
+
+	chr_t *start;
+	size_t location = 0, length = 0;
+
+	if (!st_search_cs(line, NULLER(label), &location)) {
+		return false;
+	}
+
+	start = st_char_get(line) + location + ns_length_get(label);
+
+	while (start + length < st_char_get(line) + st_length_get(line) && chr_numeric(*(start + length))) {
+		length++;
+	}
+
+	return length && uint64_conv_bl(start, length, number);
+}
+
+bool_t check_imap_network_condstore_sthread(stringer_t *errmsg, uint32_t port, bool_t secure) {
+
+	size_t location = 0;
+	client_t *client = NULL;
+	stringer_t *line = MANAGEDBUF(1024);
+	uint64_t highest = 0, modseq = 0, resync = 0, uidvalidity = 0;
+
+	// Check the initial response.
+	if (!(client = client_connect("localhost", port)) || (secure && (client_secure(client) == -1)) ||
+		!net_set_timeout(client->sockd, 20, 20) || client_read_line(client) <= 0 || (client->status != 1) ||
+		st_cmp_cs_starts(&(client->line), NULLER("* OK"))) {
+
+		st_sprint(errmsg, "Failed to connect with the IMAP server.");
+		client_close(client);
+		return false;
+	}
+	// Both extensions should be advertised.
+	else if (client_write(client, PLACER("A0 CAPABILITY\r\n", 15)) != 15 || client_read_line(client) <= 0 ||
+		!st_search_cs(&(client->line), PLACER(" CONDSTORE", 10), &location) || !st_search_cs(&(client->line), PLACER(" QRESYNC", 8), &location) ||
+		!check_imap_client_read_end(client, "A0")) {
+
+		st_sprint(errmsg, "Failed to find CONDSTORE and QRESYNC advertised in the IMAP CAPABILITY response.");
+		client_close(client);
+		return false;
+	}
+	else if (!check_imap_client_login(client, "princess", "password", "A1", errmsg)) {
+		client_close(client);
+		return false;
+	}
+	// Enabling QRESYNC implies CONDSTORE, and unknown extensions should be silently left out of the response.
+	else if (client_print(client, "A2 ENABLE CONDSTORE QRESYNC UNKNOWN\r\n") <= 0 ||
+		!check_imap_client_read_untagged(client, "A2", "* ENABLED CONDSTORE QRESYNC\r\n", NULL)) {
+
+		st_sprint(errmsg, "Failed to enable the CONDSTORE and QRESYNC extensions.");
+		client_close(client);
+		return false;
+	}
+	// Selecting with the CONDSTORE parameter should report the highest modification sequence.
+	else if (client_print(client, "A3 SELECT Inbox (CONDSTORE)\r\n") <= 0 ||
+		!check_imap_client_read_untagged(client, "A3", "* OK [HIGHESTMODSEQ ", line) ||
+		!check_imap_client_number(line, "[HIGHESTMODSEQ ", &highest) || !highest) {
+
+		st_sprint(errmsg, "Failed to find a valid HIGHESTMODSEQ response code after SELECT.");
+		client_close(client);
+		return false;
+	}
+	// The CHANGEDSINCE modifier implies the MODSEQ data item.
+	else if (client_print(client, "A4 FETCH 1:* (FLAGS) (CHANGEDSINCE 0)\r\n") <= 0 ||
+		!check_imap_client_read_untagged(client, "A4", "* 1 FETCH (", line) || !check_imap_client_number(line, "MODSEQ (", &modseq) ||
+		modseq > highest) {
+
+		st_sprint(errmsg, "Failed to find a valid MODSEQ data item after FETCH with the CHANGEDSINCE modifier.");
+		client_close(client);
+		return false;
+	}
+	// Nothing can have changed since the highest modification sequence.
+	else if (client_print(client, "A5 FETCH 1:* (FLAGS) (CHANGEDSINCE %lu)\r\n", highest) <= 0 ||
+		check_imap_client_read_untagged(client, "A5", "* 1 FETCH (", NULL) || st_cmp_cs_starts(&(client->line), NULLER("A5 OK"))) {
+
+		st_sprint(errmsg, "A message was returned by FETCH even though nothing changed since the highest modification sequence.");
+		client_close(client);
+		return false;
+	}
+	// The VANISHED modifier may only be used with a UID FETCH.
+	else if (client_print(client, "A6 FETCH 1:* (FLAGS) (CHANGEDSINCE 0 VANISHED)\r\n") <= 0 || !check_imap_client_read_tag(client, "A6") ||
+		st_cmp_cs_starts(&(client->line), NULLER("A6 BAD"))) {
+
+		st_sprint(errmsg, "The VANISHED modifier was accepted by a FETCH command.");
+		client_close(client);
+		return false;
+	}
+	else if (client_print(client, "A7 UID FETCH 1:* (FLAGS) (CHANGEDSINCE 0 VANISHED)\r\n") <= 0 ||
+		!check_imap_client_read_untagged(client, "A7", "* 1 FETCH (", line) || !st_search_cs(line, PLACER("UID ", 4), &location)) {
+
+		st_sprint(errmsg, "Failed to return a successful state after UID FETCH with the VANISHED modifier.");
+		client_close(client);
+		return false;
+	}
+	// A store conditioned on the current modification sequence should succeed, and report the new modification sequence.
+	else if (client_print(client, "A8 STORE 1 (UNCHANGEDSINCE %lu) +FLAGS.SILENT (\\Flagged)\r\n", highest) <= 0 ||
+		!check_imap_client_read_untagged(client, "A8", "* 1 FETCH (", line) || !check_imap_client_number(line, "MODSEQ (", &modseq) ||
+		modseq <= highest || st_search_cs(&(client->line), PLACER("[MODIFIED", 9), &location)) {
+
+		st_sprint(errmsg, "Failed to update a message using the UNCHANGEDSINCE modifier.");
+		client_close(client);
+		return false;
+	}
+	// The message has been modified since the original sequence, so the same store should now be refused.
+	else if (client_print(client, "A9 STORE 1 (UNCHANGEDSINCE %lu) -FLAGS.SILENT (\\Flagged)\r\n", highest) <= 0 || !check_imap_client_read_end(client, "A9") ||
+		st_cmp_cs_starts(&(client->line), NULLER("A9 OK [MODIFIED 1]"))) {
+
+		st_sprint(errmsg, "Failed to refuse a store using the UNCHANGEDSINCE modifier for a message which was modified.");
+		client_close(client);
+		return false;
+	}
+	// The refused store should have left the flag alone, and a search by modification sequence should find the message.
+	else if (client_print(client, "A10 SEARCH FLAGGED MODSEQ %lu\r\n", modseq) <= 0 ||
+		!check_imap_client_read_untagged(client, "A10", "* SEARCH 1", line) ||
+		!st_search_cs(line, st_quick(MANAGEDBUF(64), " (MODSEQ %lu)\r\n", modseq), &location)) {
+
+		st_sprint(errmsg, "Failed to find the modified message using the MODSEQ search criterion.");
+		client_close(client);
+		return false;
+	}
+	// Nothing should match a modification sequence which hasn't been assigned yet.
+	else if (client_print(client, "A11 SEARCH MODSEQ %lu\r\n", modseq + 1) <= 0 ||
+		!check_imap_client_read_untagged(client, "A11", "* SEARCH\r\n", NULL)) {
+
+		st_sprint(errmsg, "Messages were returned by the MODSEQ search criterion for a modification sequence which hasn't been assigned.");
+		client_close(client);
+		return false;
+	}
+	// Restore the original flags, and record the folder's unique identifier.
+	else if (client_print(client, "A12 STORE 1 -FLAGS.SILENT (\\Flagged)\r\n") <= 0 || !check_imap_client_read_end(client, "A12") ||
+		client_print(client, "A13 SELECT Inbox\r\n") <= 0 || !check_imap_client_read_untagged(client, "A13", "* OK [UIDVALIDITY ", line) ||
+		!check_imap_client_number(line, "[UIDVALIDITY ", &uidvalidity)) {
+
+		st_sprint(errmsg, "Failed to restore the message flags and reselect the folder.");
+		client_close(client);
+		return false;
+	}
+	// Resynchronizing from the original sequence should report the changes made to the first message.
+	else if (client_print(client, "A14 SELECT Inbox (QRESYNC (%lu %lu))\r\n", uidvalidity, highest) <= 0 ||
+		!check_imap_client_read_untagged(client, "A14", "* 1 FETCH (", line) || !check_imap_client_number(line, "MODSEQ (", &resync) ||
+		resync <= modseq) {
+
+		st_sprint(errmsg, "Failed to resynchronize the folder using the QRESYNC parameter.");
+		client_close(client);
+		return false;
+	}
+	else if (!check_imap_client_close_logout(client, 15, errmsg)) {
+		client_close(client);
+		return false;
+	}
+
+	client_close(client);
+	return true;
+}
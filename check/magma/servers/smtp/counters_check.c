@@ -0,0 +1,43 @@
+/**
+ * @file /check/magma/servers/smtp/counters_check.c
+ *
+ * @brief SMTP message counter test functions.
+ */
+
+#include "magma_check.h"
+
+bool_t check_smtp_counters_sthread(stringer_t *errmsg) {
+
+	uint64_t usernum, before = 0, after = 0;
+	stringer_t *subnet = MANAGEDBUF(64);
+
+	if (!smtp_counters_enabled()) {
+		return true;
+	}
+
+	// A random user and subnet are used, and no rows are queued, so the database is never written.
+	usernum = (rand_get_uint64() % 1000000000) + 1000000000;
+	st_sprint(subnet, "10.%hhu.%hhu", rand_get_uint8(), rand_get_uint8());
+
+	if (!smtp_counter_get(SMTP_COUNTER_RECEIVED, usernum, subnet, &before) || before) {
+		st_sprint(errmsg, "The message counter for an unused subnet wasn't empty. { usernum = %lu / total = %lu }", usernum, before);
+		return false;
+	}
+	else if (!smtp_counter_add(SMTP_COUNTER_RECEIVED, usernum, subnet, 3, 0, 0, 0) ||
+		!smtp_counter_get(SMTP_COUNTER_RECEIVED, usernum, subnet, &after) || after != before + 3) {
+		st_sprint(errmsg, "The message counter didn't reflect the messages added. { usernum = %lu / before = %lu / after = %lu }",
+			usernum, before, after);
+		return false;
+	}
+
+	// Once flushed, the total is reloaded from the cache servers, and must still include the messages we added.
+	smtp_counters_flush();
+
+	if (!smtp_counter_get(SMTP_COUNTER_RECEIVED, usernum, subnet, &after) || after < before + 3) {
+		st_sprint(errmsg, "The message counter lost messages during a flush. { usernum = %lu / before = %lu / after = %lu }",
+			usernum, before, after);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file /check/magma/servers/smtp/inbound_check.c
+ *
+ * @brief SMTP inbound preferences cache test functions.
+ */
+
+#include "magma_check.h"
+
+bool_t check_smtp_inbound_cache_sthread(stringer_t *errmsg) {
+
+	int_t state = 0;
+	uint64_t hits, misses, rejected;
+	smtp_inbound_prefs_t *first = NULL, *second = NULL;
+	stringer_t *address = PLACER("ladar@lavabit.com", 17), *unknown = MANAGEDBUF(128);
+
+	if (!smtp_inbound_cache_enabled()) {
+		return true;
+	}
+
+	st_sprint(unknown, "magma.check.%lu@lavabit.com", rand_get_uint64());
+	smtp_inbound_cache_delete(address);
+
+	// The first lookup should be answered by the database, and the second by the cache.
+	if ((state = smtp_fetch_inbound(address, &first)) != 0 || !first) {
+		st_sprint(errmsg, "Unable to fetch the inbound preferences for a valid recipient. { state = %i }", state);
+		if (first) smtp_free_inbound(first);
+		return false;
+	}
+
+	hits = stats_get_value_by_name("smtp.inbound.cache.hits");
+
+	if ((state = smtp_fetch_inbound(address, &second)) != 0 || !second || second == first || second->usernum != first->usernum ||
+		st_cmp_cs_eq(second->rcptto, first->rcptto) || second->inbox != first->inbox || second->quota != first->quota ||
+		stats_get_value_by_name("smtp.inbound.cache.hits") != hits + 1) {
+		st_sprint(errmsg, "The inbound preferences cache failed to return a copy of the cached preferences. { state = %i }", state);
+		if (second) smtp_free_inbound(second);
+		smtp_free_inbound(first);
+		return false;
+	}
+
+	smtp_free_inbound(second);
+	second = NULL;
+
+	// Changing the user's config must force the preferences to be reloaded.
+	serial_increment(OBJECT_CONFIG, first->usernum);
+	misses = stats_get_value_by_name("smtp.inbound.cache.misses");
+
+	if ((state = smtp_fetch_inbound(address, &second)) != 0 || !second || second->usernum != first->usernum ||
+		stats_get_value_by_name("smtp.inbound.cache.misses") == misses) {
+		st_sprint(errmsg, "The inbound preferences cache returned stale preferences after the config serial changed. { state = %i }", state);
+		if (second) smtp_free_inbound(second);
+		smtp_free_inbound(first);
+		return false;
+	}
+
+	smtp_free_inbound(second);
+	smtp_free_inbound(first);
+	second = first = NULL;
+
+	// Unknown recipients should be remembered, so the second attempt is rejected without a query.
+	if ((state = smtp_fetch_inbound(unknown, &first)) != -1 || first) {
+		st_sprint(errmsg, "The inbound preferences lookup accepted an unknown recipient. { state = %i }", state);
+		if (first) smtp_free_inbound(first);
+		return false;
+	}
+
+	rejected = stats_get_value_by_name("smtp.inbound.cache.rejected");
+
+	if ((state = smtp_fetch_inbound(unknown, &first)) != -1 || first ||
+		(magma.smtp.inbound_cache.negative && stats_get_value_by_name("smtp.inbound.cache.rejected") != rejected + 1)) {
+		st_sprint(errmsg, "The inbound preferences cache failed to remember an unknown recipient. { state = %i }", state);
+		if (first) smtp_free_inbound(first);
+		smtp_inbound_cache_delete(unknown);
+		return false;
+	}
+
+	smtp_inbound_cache_delete(unknown);
+	smtp_inbound_cache_delete(address);
+
+	return true;
+}
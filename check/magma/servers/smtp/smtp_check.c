@@ -103,6 +103,32 @@ START_TEST (check_smtp_checkers_rbl_s) {
 
 } END_TEST
 
+START_TEST (check_smtp_counters_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_counters_sthread(errmsg);
+
+	log_test("SMTP / COUNTERS / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+
+} END_TEST
+
+START_TEST (check_smtp_inbound_cache_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (status()) outcome = check_smtp_inbound_cache_sthread(errmsg);
+
+	log_test("SMTP / INBOUND / CACHE / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+
+} END_TEST
+
 START_TEST (check_smtp_network_auth_plain_s) {
 
 	log_disable();
@@ -309,6 +335,26 @@ START_TEST (check_smtp_network_starttls_s) {
 
 } END_TEST
 
+START_TEST (check_smtp_network_fanout_s) {
+
+	log_disable();
+	bool_t outcome = true;
+	server_t *server = NULL;
+	stringer_t *errmsg = MANAGEDBUF(1024);
+
+	if (!(server = servers_get_by_protocol(SMTP, false))) {
+		st_sprint(errmsg, "No SMTP servers were configured to support TCP connections.");
+		outcome = false;
+	}
+	else if (status() && !check_smtp_network_fanout_sthread(errmsg, server->network.port)) {
+		outcome = false;
+	}
+
+	log_test("SMTP / NETWORK / FANOUT / SINGLE THREADED:", errmsg);
+	ck_assert_msg(outcome, st_char_get(errmsg));
+
+} END_TEST
+
 Suite * suite_check_smtp(void) {
 
 	Suite *s = suite_create("\tSMTP");
@@ -318,10 +364,13 @@ Suite * suite_check_smtp(void) {
 	suite_check_testcase(s, "SMTP", "SMTP Checkers RBL", check_smtp_checkers_rbl_s);
 	suite_check_testcase(s, "SMTP", "SMTP Checkers Filters/S", check_smtp_checkers_filters_s);
 	suite_check_testcase(s, "SMTP", "SMTP Checkers Greylist/S", check_smtp_checkers_greylist_s);
+	suite_check_testcase(s, "SMTP", "SMTP Inbound Cache/S", check_smtp_inbound_cache_s);
+	suite_check_testcase(s, "SMTP", "SMTP Counters/S", check_smtp_counters_s);
 
 	suite_check_testcase(s, "SMTP", "SMTP Network Basic/ TCP/S", check_smtp_network_basic_tcp_s);
 	suite_check_testcase(s, "SMTP", "SMTP Network Basic/ TLS/S", check_smtp_network_basic_tls_s);
 	suite_check_testcase(s, "SMTP", "SMTP Network STARTTLS/S", check_smtp_network_starttls_s);
+	suite_check_testcase(s, "SMTP", "SMTP Network Fanout/S", check_smtp_network_fanout_s);
 
 	suite_check_testcase(s, "SMTP", "SMTP Network Auth Plain/S", check_smtp_network_auth_plain_s);
 	suite_check_testcase(s, "SMTP", "SMTP Network Auth Login/S", check_smtp_network_auth_login_s);
@@ -16,12 +16,19 @@ bool_t check_smtp_checkers_regex_sthread(stringer_t *errmsg);
 bool_t check_smtp_checkers_greylist_sthread(stringer_t *errmsg);
 bool_t check_smtp_checkers_filters_sthread(stringer_t *errmsg, int_t action, int_t expected);
 
+/// counters_check.c
+bool_t check_smtp_counters_sthread(stringer_t *errmsg);
+
+/// inbound_check.c
+bool_t check_smtp_inbound_cache_sthread(stringer_t *errmsg);
+
 /// smtp_check_network.c
 bool_t check_smtp_client_read_end(client_t *client);
 bool_t check_smtp_client_quit(client_t *client, stringer_t *errmsg);
 bool_t check_smtp_client_auth_plain(client_t *client, stringer_t *auth);
 bool_t check_smtp_network_auth_sthread(stringer_t *errmsg, uint32_t port, bool_t login);
 bool_t check_smtp_client_auth_login(client_t *client, stringer_t *user, stringer_t *pass);
+bool_t check_smtp_network_fanout_sthread(stringer_t *errmsg, uint32_t port);
 bool_t check_smtp_network_basic_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_smtp_network_outbound_quota_sthread(stringer_t *errmsg, uint32_t port, bool_t secure);
 bool_t check_smtp_network_starttls_sthread(stringer_t *errmsg, uint32_t tcp_port, uint32_t tls_port);
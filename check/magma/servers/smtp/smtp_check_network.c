@@ -582,3 +582,111 @@ bool_t check_smtp_network_starttls_sthread(stringer_t *errmsg, uint32_t tcp_port
     client_close(client);
     return true;
 }
+
+/**
+ * @brief	Deliver a single message to several local recipients with the fan-out enabled.
+ * @note	Every recipient must end up with its own copy of the message, while the virus scan and the DKIM verification, which
+ * 			are shared by every recipient, must only be performed once, before the deliveries are spread across threads.
+ * @param	errmsg	a managed string that will have the error message printed to it in the event of an error.
+ * @param	port	the port of the SMTP server being tested.
+ * @return	true if no errors were encountered, false otherwise.
+ */
+bool_t check_smtp_network_fanout_sthread(stringer_t *errmsg, uint32_t port) {
+
+    bool_t outcome = true;
+    client_t *client = NULL;
+    uint32_t fanout = magma.smtp.fanout;
+    uint64_t usernums[] = { 2, 1, 3 }, checkpoints[3], messages, scans, dkim, delivered;
+    chr_t *recipients[] = { "princess@example.com", "magma@example.com", "ladar@example.com" }, *line_to = "RCPT TO: <%s>\r\n";
+    chr_t *message = "To: princess@example.com, magma@example.com, ladar@example.com\r\nFrom: fanout@example.com\r\n" \
+        "Subject: Fan-out Test\r\n\r\nThis message is delivered to several recipients at once.\r\n.\r\n";
+
+    for (size_t i = 0; i < (sizeof(usernums) / sizeof(uint64_t)); i++) {
+        checkpoints[i] = serial_get(OBJECT_MESSAGES, usernums[i]);
+    }
+
+    magma.smtp.fanout = 4;
+    messages = stats_get_value_by_name("smtp.fanout.messages");
+    scans = stats_get_value_by_name("provider.virus.scan.total") + stats_get_value_by_name("provider.virus.error");
+    dkim = stats_get_value_by_name("provider.dkim.checked");
+
+    // Connect and hand the server the recipients, which are all local, so they're all delivered by the same DATA command.
+    if (!(client = client_connect("localhost", port)) || !net_set_timeout(client->sockd, 20, 20) || client_read_line(client) <= 0 ||
+        client_status(client) != 1 || st_cmp_cs_starts(&(client->line), NULLER("220"))) {
+
+        st_sprint(errmsg, "Failed to connect with the SMTP server.");
+        outcome = false;
+    }
+    else if (client_write(client, PLACER("EHLO localhost\r\n", 16)) != 16 || !check_smtp_client_read_end(client) ||
+        client_status(client) != 1 || st_cmp_cs_starts(&(client->line), NULLER("250"))) {
+
+        st_sprint(errmsg, "Failed to return successful status after EHLO.");
+        outcome = false;
+    }
+    else if (client_write(client, PLACER("MAIL FROM: <fanout@example.com>\r\n", 33)) != 33 || !check_smtp_client_read_end(client) ||
+        client_status(client) != 1 || st_cmp_cs_starts(&(client->line), NULLER("250"))) {
+
+        st_sprint(errmsg, "Failed to return successful status after MAIL.");
+        outcome = false;
+    }
+
+    for (size_t i = 0; outcome && i < (sizeof(recipients) / sizeof(chr_t *)); i++) {
+        if (client_print(client, line_to, recipients[i]) != ns_length_get(line_to) + ns_length_get(recipients[i]) - 2 ||
+            !check_smtp_client_read_end(client) || client_status(client) != 1 || st_cmp_cs_starts(&(client->line), NULLER("250"))) {
+
+            st_sprint(errmsg, "Failed to return successful status after RCPT. { recipient = %s }", recipients[i]);
+            outcome = false;
+        }
+    }
+
+    if (outcome && (client_write(client, PLACER("DATA\r\n", 6)) != 6 || !check_smtp_client_read_end(client) ||
+        client_status(client) != 1 || st_cmp_cs_starts(&(client->line), NULLER("354")))) {
+
+        st_sprint(errmsg, "Failed to return a proceed status code after DATA.");
+        outcome = false;
+    }
+    else if (outcome && (client_write(client, PLACER(message, ns_length_get(message))) != ns_length_get(message) ||
+        !check_smtp_client_read_end(client) || client_status(client) != 1 || st_cmp_cs_starts(&(client->line), NULLER("250")))) {
+
+        st_sprint(errmsg, "Failed to get a successful status code after the message was submitted to several recipients.");
+        outcome = false;
+    }
+    else if (outcome && !check_smtp_client_quit(client, errmsg)) {
+        outcome = false;
+    }
+
+    client_close(client);
+    magma.smtp.fanout = fanout;
+
+    if (!outcome) {
+        return false;
+    }
+
+    // The message must have been handed to the helpers, rather than delivered to each recipient in turn.
+    if ((delivered = stats_get_value_by_name("smtp.fanout.messages") - messages) != 1) {
+        st_sprint(errmsg, "The message wasn't delivered using the fan-out. { messages = %lu }", delivered);
+        return false;
+    }
+
+    // Each recipient must have received exactly one copy.
+    for (size_t i = 0; i < (sizeof(usernums) / sizeof(uint64_t)); i++) {
+        if ((delivered = serial_get(OBJECT_MESSAGES, usernums[i]) - checkpoints[i]) != 1) {
+            st_sprint(errmsg, "The fan-out delivered the wrong number of copies to a recipient. { recipient = %s / copies = %lu }",
+                recipients[i], delivered);
+            return false;
+        }
+    }
+
+    // The shared checks must only run once for the whole message, no matter how many threads delivered it.
+    if (magma.iface.virus.available && (delivered = stats_get_value_by_name("provider.virus.scan.total") +
+        stats_get_value_by_name("provider.virus.error") - scans) != 1) {
+        st_sprint(errmsg, "The fan-out didn't scan the message for viruses exactly once. { scans = %lu }", delivered);
+        return false;
+    }
+    else if ((delivered = stats_get_value_by_name("provider.dkim.checked") - dkim) > 1) {
+        st_sprint(errmsg, "The fan-out verified the message signature more than once. { verifications = %lu }", delivered);
+        return false;
+    }
+
+    return true;
+}
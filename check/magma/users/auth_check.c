@@ -235,6 +235,189 @@ START_TEST (check_users_auth_login_s) {
 
 } END_TEST
 
+START_TEST (check_users_auth_cache_s) {
+
+	log_disable();
+	int_t result;
+	uint64_t hits, misses;
+	stringer_t *errmsg = NULL;
+	auth_t *first = NULL, *second = NULL;
+
+	if (!status() || !auth_cache_enabled()) {
+		log_test("USERS / AUTH / CACHE / SINGLE THREADED:", errmsg);
+		return;
+	}
+
+	// The first login primes the cache, so the second should be answered without deriving the keys.
+	if ((result = auth_login(NULLER("stacie"), NULLER("password"), &first)) || !first) {
+		errmsg = st_aprint("The credentials cache test failed to log into the test account. { result = %i }", result);
+	}
+	else {
+
+		hits = stats_get_value_by_name("objects.auth.cache.hits");
+
+		if ((result = auth_login(NULLER("stacie"), NULLER("password"), &second)) || !second) {
+			errmsg = st_aprint("The credentials cache test failed to repeat the login. { result = %i }", result);
+		}
+		else if (stats_get_value_by_name("objects.auth.cache.hits") != hits + 1 || st_cmp_cs_eq(first->keys.master, second->keys.master)) {
+			errmsg = st_aprint("The credentials cache failed to return the master key for a repeated login.");
+		}
+	}
+
+	if (second) {
+		auth_free(second);
+		second = NULL;
+	}
+
+	// An incorrect password must never be answered by the cache.
+	if (!errmsg && (result = auth_login(NULLER("stacie"), NULLER("incorrect"), &second)) != 1) {
+		errmsg = st_aprint("The credentials cache accepted an incorrect password. { result = %i }", result);
+	}
+
+	if (second) {
+		auth_free(second);
+		second = NULL;
+	}
+
+	// Once the user's credentials are invalidated, the next login has to derive the keys again.
+	if (!errmsg) {
+
+		auth_cache_invalidate(first->usernum);
+		misses = stats_get_value_by_name("objects.auth.cache.misses");
+
+		if ((result = auth_login(NULLER("stacie"), NULLER("password"), &second)) || !second ||
+			stats_get_value_by_name("objects.auth.cache.misses") != misses + 1) {
+			errmsg = st_aprint("The credentials cache returned credentials which were invalidated. { result = %i }", result);
+		}
+	}
+
+	if (second) auth_free(second);
+	if (first) auth_free(first);
+
+	log_test("USERS / AUTH / CACHE / SINGLE THREADED:", errmsg);
+	fail_unless(!errmsg, st_char_get(errmsg));
+	st_cleanup(errmsg);
+
+} END_TEST
+
+/**
+ * @brief	Derive a set of keys using the batched key derivation service, and compare them with the serial STACIE functions.
+ * @return	This function passes a managed string holding an error message to pthread_exit(), or NULL if the keys match.
+ */
+void check_users_auth_batch_wrap(void) {
+
+	uint32_t rounds = STACIE_KEY_ROUNDS_MIN + (rand_get_uint32() % 64);
+	stringer_t *username = NULL, *password = NULL, *salt = NULL, *master = NULL, *key = NULL, *seed = NULL,
+		*expected_master = NULL, *expected_key = NULL, *errmsg = NULL;
+
+	if (!thread_start()) {
+		log_unit("Unable to setup the thread context.");
+		pthread_exit(st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, NULLER("Thread startup error.")));
+		return;
+	}
+
+	if (!(username = st_alloc((rand_get_uint32() % 64) + 1)) || !rand_write(username) ||
+		!(password = st_alloc((rand_get_uint32() % 256) + 1)) || !rand_write(password) ||
+		!(salt = st_alloc(STACIE_SALT_LENGTH)) || rand_write(salt) != STACIE_SALT_LENGTH) {
+		errmsg = st_aprint("Unable to generate the batched key derivation inputs.");
+	}
+	else if (!auth_batch_derive(rounds, username, password, salt, &master, &key)) {
+		errmsg = st_aprint("The batched key derivation request failed. { rounds = %u }", rounds);
+	}
+	else if (!(seed = stacie_derive_seed(rounds, password, salt)) ||
+		!(expected_master = stacie_derive_key(seed, rounds, username, password, salt)) ||
+		!(expected_key = stacie_derive_key(expected_master, rounds, username, password, salt))) {
+		errmsg = st_aprint("The serial key derivation failed. { rounds = %u }", rounds);
+	}
+	else if (st_cmp_cs_eq(master, expected_master) || st_cmp_cs_eq(key, expected_key)) {
+		errmsg = st_aprint("The batched key derivation produced different keys than the serial functions. { rounds = %u }", rounds);
+	}
+
+	st_cleanup(username, password, salt, master, key, seed, expected_master, expected_key);
+
+	thread_stop();
+	pthread_exit(errmsg);
+	return;
+}
+
+START_TEST (check_users_auth_batch_m) {
+
+	log_disable();
+	void *outcome = NULL;
+	bool_t started = false;
+	stringer_t *errmsg = NULL, *master = NULL, *key = NULL;
+	uint32_t configured, launched = 0;
+	uint64_t jobs, runs;
+	pthread_t threads[STACIE_LANES * 2];
+
+	if (!status() || !magma.secure.memory.enable) {
+		log_test("USERS / AUTH / BATCH / MULTI THREADED:", errmsg);
+		return;
+	}
+
+	// If the configuration left the service disabled, it's started for the duration of the check.
+	if (!auth_batch_enabled()) {
+		configured = magma.secure.derivation.threads;
+		magma.secure.derivation.threads = 2;
+		started = auth_batch_start();
+		magma.secure.derivation.threads = configured;
+
+		if (!started || !auth_batch_enabled()) {
+			errmsg = st_aprint("Unable to start the batched key derivation service.");
+		}
+	}
+
+	jobs = stats_get_value_by_name("objects.auth.batch.jobs");
+	runs = stats_get_value_by_name("objects.auth.batch.runs");
+
+	// Submit more concurrent requests than there are lanes, so at least one batch is refilled while it runs.
+	for (uint32_t i = 0; !errmsg && i < (sizeof(threads) / sizeof(pthread_t)); i++) {
+		if (thread_launch(threads + i, &check_users_auth_batch_wrap, NULL)) {
+			errmsg = st_aprint("Unable to launch the batched key derivation threads. { launched = %u }", launched);
+		}
+		else {
+			launched++;
+		}
+	}
+
+	for (uint32_t i = 0; i < launched; i++) {
+		if (thread_result(threads[i], &outcome)) {
+			if (!errmsg) errmsg = st_aprint("Unable to join the batched key derivation threads.");
+		}
+		else if (outcome) {
+			if (!errmsg) errmsg = outcome;
+			else st_free(outcome);
+		}
+		outcome = NULL;
+	}
+
+	if (!errmsg && (stats_get_value_by_name("objects.auth.batch.jobs") < jobs + launched ||
+		stats_get_value_by_name("objects.auth.batch.runs") == runs)) {
+		errmsg = st_aprint("The batched key derivation statistics weren't updated. { jobs = %lu / runs = %lu }",
+			stats_get_value_by_name("objects.auth.batch.jobs") - jobs, stats_get_value_by_name("objects.auth.batch.runs") - runs);
+	}
+
+	// Once the service is stopped, requests must be refused so the caller falls back to deriving the keys itself.
+	if (started) {
+
+		auth_batch_stop();
+
+		if (!errmsg && auth_batch_enabled()) {
+			errmsg = st_aprint("The batched key derivation service was still enabled after being stopped.");
+		}
+		else if (!errmsg && auth_batch_derive(STACIE_KEY_ROUNDS_MIN, NULLER("batch"), NULLER("password"), NULLER("salt"), &master,
+			&key)) {
+			errmsg = st_aprint("The batched key derivation service accepted a request after being stopped.");
+			st_cleanup(master, key);
+		}
+	}
+
+	log_test("USERS / AUTH / BATCH / MULTI THREADED:", errmsg);
+	fail_unless(!errmsg, st_char_get(errmsg));
+	st_cleanup(errmsg);
+
+} END_TEST
+
 START_TEST (check_users_auth_locked_s) {
 
 	log_disable();
@@ -309,6 +309,8 @@ Suite * suite_check_users(void) {
 	suite_check_testcase(s, "USERS", "Auth Challenge/S", check_users_auth_challenge_s);
 	suite_check_testcase(s, "USERS", "Auth Response/S", check_users_auth_response_s);
 	suite_check_testcase(s, "USERS", "Auth Login/S", check_users_auth_login_s);
+	suite_check_testcase(s, "USERS", "Auth Cache/S", check_users_auth_cache_s);
+	suite_check_testcase(s, "USERS", "Auth Batch/M", check_users_auth_batch_m);
 
 	suite_check_testcase(s, "USERS", "Auth Locked/S", check_users_auth_locked_s);
 	suite_check_testcase(s, "USERS", "Auth Inactivity/S", check_users_auth_inactivity_s);
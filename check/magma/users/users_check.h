@@ -15,10 +15,14 @@ void check_users_auth_stacie_s(int);
 void check_users_auth_challenge_s(int);
 void check_users_auth_response_s(int);
 void check_users_auth_login_s(int);
+void check_users_auth_cache_s(int);
+void check_users_auth_batch_m(int);
 void check_users_auth_locked_s(int);
 void check_users_auth_username_s(int);
 void check_users_auth_address_s(int);
 void check_users_auth_inactivity_s(int);
 
+void check_users_auth_batch_wrap(void);
+
 #endif
 
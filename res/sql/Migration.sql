@@ -103,3 +103,7 @@ CREATE TABLE `Requests` (
 /* Start the migration to Unicode. */
 ALTER TABLE `Payments` CHANGE COLUMN `name` `name` VARCHAR(30) CHARACTER SET 'utf8' COLLATE 'utf8_unicode_ci' NOT NULL DEFAULT '' ;
 
+/* Track modification sequences so IMAP clients can resynchronize using CONDSTORE and QRESYNC. */
+ALTER TABLE `Users` ADD COLUMN `modseq` bigint(20) unsigned NOT NULL DEFAULT '1' AFTER `overquota`;
+ALTER TABLE `Messages` ADD COLUMN `modseq` bigint(20) unsigned NOT NULL DEFAULT '1' AFTER `visible`;
+
@@ -348,6 +348,7 @@ CREATE TABLE `Messages` (
   `signum` bigint(20) unsigned DEFAULT '0',
   `sigkey` bigint(20) unsigned DEFAULT '0',
   `visible` tinyint(1) NOT NULL DEFAULT '1',
+  `modseq` bigint(20) unsigned NOT NULL DEFAULT '1',
   `created` datetime NOT NULL DEFAULT '0000-00-00 00:00:00',
   PRIMARY KEY (`messagenum`),
   KEY `IX_USERNUM` (`usernum`),
@@ -487,6 +488,7 @@ CREATE TABLE `Users` (
   `size` bigint(20) unsigned NOT NULL DEFAULT '0',
   `quota` bigint(20) unsigned NOT NULL DEFAULT '1073741824',
   `overquota` tinyint(1) NOT NULL DEFAULT '0',
+  `modseq` bigint(20) unsigned NOT NULL DEFAULT '1',
   `plan_expiration` date DEFAULT '0000-00-00',
   `lock_expiration` date DEFAULT '0000-00-00',
   PRIMARY KEY (`usernum`),
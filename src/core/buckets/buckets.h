@@ -22,6 +22,18 @@
  */
 #define MAGMA_CORE_POOL_TIMEOUT_LIMIT 86400
 
+/**
+ *  The number of buckets in a pool's wait time histogram. The first bucket counts the requests which were satisfied immediately,
+ *  the following buckets count requests which waited less than 10 microseconds, 100 microseconds, 1 millisecond, 10 milliseconds,
+ *  100 milliseconds, 1 second, and the final bucket counts the requests which waited longer.
+ */
+#define MAGMA_CORE_POOL_WAIT_BUCKETS 8
+
+/**
+ *  The number of locks protecting the slots of a fixed slot table. Slot n is protected by lock n % MAGMA_CORE_SLOTTED_LOCKS.
+ */
+#define MAGMA_CORE_SLOTTED_LOCKS 64
+
 // Defines for the array type.
 #define ARRAY_MAX_ELEMENTS 16384
 #define ARRAY_TYPE_EMPTY 0
@@ -55,22 +67,36 @@ typedef struct __attribute__ ((packed)) {
 	void (*free_function)(void *data);
 } stacker_t;
 
+// The fields updated using atomic operations are kept on naturally aligned offsets.
 typedef struct __attribute__ ((packed)) {
 	uint32_t count; /* Number of objects allocated. */
 	uint32_t timeout; /* How long to wait for an object before timing out. Zero is forever. */
 	uint64_t failures; /* Tracks the number of times a thread was forced to return empty handed. */
 	sem_t available; /* Semaphore holding the number of objects currently available. */
-	pthread_mutex_t lock; /* Mutex for locking coordinating updates between threads. */
+	uint64_t head; /* The top of the free list, with the item number plus one in the low half, and an ABA tag in the high half. */
 	status_t *status; /* Array of booleans to indicate object availability. */
 	void **objects; /* Array of objects. */
+	uint32_t *next; /* Array linking each available item to the next available item, using the item number plus one. */
+	uint64_t waits[MAGMA_CORE_POOL_WAIT_BUCKETS]; /* A histogram of how long successful requests waited for an object. */
 } pool_t;
 
+// A fixed size table, where each key maps to a single slot, and storing a key replaces whatever was held in its slot.
+typedef struct {
+	uint32_t count; /* The number of slots in the table. */
+	size_t size; /* The size of each slot, in bytes. */
+	bool_t secure; /* Set if the table is held in secure memory. */
+	void (*clear_function)(void *slot); /* Releases anything a slot points to, before the slot is wiped. */
+	void *slots;
+	pthread_mutex_t locks[MAGMA_CORE_SLOTTED_LOCKS];
+} slotted_t;
+
 // Pool interface
 void pool_free(pool_t *pool);
 uint32_t pool_get_count(pool_t *pool);
 uint32_t pool_get_timeout(pool_t *pool);
 uint64_t pool_get_failures(pool_t *pool);
 uint32_t pool_get_available(pool_t *pool);
+uint64_t pool_get_waits(pool_t *pool, uint32_t bucket);
 pool_t * pool_alloc(uint32_t count, uint32_t timeout);
 
 // Status interface
@@ -81,6 +107,8 @@ status_t pool_set_status(pool_t *pool, uint32_t item, status_t status);
 void pool_release(pool_t *pool, uint32_t item);
 void * pool_get_obj(pool_t *pool, uint32_t item);
 status_t pool_pull(pool_t *pool, uint32_t *item);
+uint32_t pool_pop(pool_t *pool);
+void pool_push(pool_t *pool, uint32_t item);
 void * pool_swap_obj(pool_t *pool, uint32_t item, void *object);
 void * pool_set_obj(pool_t *pool, uint32_t item, void *object);
 
@@ -99,6 +127,14 @@ void          ar_free(array_t *array);
 size_t        ar_length_get(array_t *array);
 void          ar_length_set(array_t *array, size_t used);
 
+/// slotted.c
+slotted_t *     slotted_alloc(uint32_t count, size_t size, bool_t secure, void *clear_function);
+void          slotted_clear(slotted_t *table, void *slot);
+uint32_t      slotted_count(slotted_t *table);
+void          slotted_free(slotted_t *table);
+void *        slotted_lock(slotted_t *table, uint64_t hash);
+void          slotted_unlock(slotted_t *table, uint64_t hash);
+
 /// stacked.c
 int_t stacker_push(stacker_t *stack, void *data);
 stacker_t * stacker_alloc(void *free_function);
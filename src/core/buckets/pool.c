@@ -3,6 +3,11 @@
  * @file /magma/core/buckets/pool.c
  *
  * @brief	A collection of functions used to create, maintain and safely utilize collections of object pointers that are accessed by multiple threads.
+ *
+ * @note	The available objects are tracked using a lock free stack, so pulling and releasing an object takes constant time. The
+ * 			stack head carries a tag which is incremented by every update, which prevents a thread from mistaking a head which was
+ * 			popped and pushed back in the meantime for an unchanged head. The semaphore guarantees a thread will only try to pop an
+ * 			object when one is available, and provides the timeout semantics.
  */
 
 #include "magma.h"
@@ -18,7 +23,6 @@ void pool_free(pool_t *pool) {
 	if (!pool)
 		return;
 
-	mutex_destroy(&(pool->lock));
 	sem_destroy(&(pool->available));
 	mm_free(pool);
 	return;
@@ -33,7 +37,7 @@ void pool_free(pool_t *pool) {
 pool_t * pool_alloc(uint32_t count, uint32_t timeout) {
 
 	pool_t *pool;
-	size_t pool_size = sizeof(pool_t) + (sizeof(status_t) * count) + (sizeof(void *) * count);
+	size_t pool_size = sizeof(pool_t) + (sizeof(status_t) * count) + (sizeof(void *) * count) + (sizeof(uint32_t) * count);
 
 	if (count > MAGMA_CORE_POOL_OBJECTS_LIMIT) {
 		log_info("%u exceeds the maximum number of pool objects allowed.", count);
@@ -45,7 +49,7 @@ pool_t * pool_alloc(uint32_t count, uint32_t timeout) {
 		return NULL;
 	}
 
-	// Allocate enough memory for the pool structure, plus the boolean list and object array.
+	// Allocate enough memory for the pool structure, plus the boolean list, object array and free list links.
 	if (!(pool = mm_alloc(pool_size))) {
 		log_info("Unable to allocate %zu bytes for a pool structure.", pool_size);
 		return NULL;
@@ -55,18 +59,19 @@ pool_t * pool_alloc(uint32_t count, uint32_t timeout) {
 	pool->count = count;
 	pool->timeout = timeout;
 
-	pool->status = (status_t *)((char *)pool + sizeof(pool_t));
-	pool->objects = (void *)((char *)pool + sizeof(pool_t) + ((sizeof(status_t) * count)));
+	pool->objects = (void *)((char *)pool + sizeof(pool_t));
+	pool->status = (status_t *)((char *)pool + sizeof(pool_t) + (sizeof(void *) * count));
+	pool->next = (uint32_t *)((char *)pool + sizeof(pool_t) + (sizeof(void *) * count) + (sizeof(status_t) * count));
 
-	if (sem_init(&(pool->available), 0, count)) {
-		log_info("Unable to initialize the pool semaphore.");
-		mm_free(pool);
-		return NULL;
+	// Every item starts out on the free list, with the first item on top.
+	for (uint32_t i = 0; i < count; i++) {
+		pool->next[i] = i + 1 < count ? i + 2 : 0;
 	}
 
-	if (mutex_init(&(pool->lock), NULL)) {
-		log_info("Unable to initialize the pool mutex.");
-		sem_destroy(&(pool->available));
+	pool->head = count ? 1 : 0;
+
+	if (sem_init(&(pool->available), 0, count)) {
+		log_info("Unable to initialize the pool semaphore.");
 		mm_free(pool);
 		return NULL;
 	}
@@ -118,15 +123,25 @@ uint32_t pool_get_timeout(pool_t *pool) {
  */
 uint64_t pool_get_failures(pool_t *pool) {
 
-	uint64_t result;
 	if (!pool)
 		return 0;
 
-	mutex_lock(&(pool->lock));
-	result = pool->failures;
-	mutex_unlock(&(pool->lock));
+	return __sync_fetch_and_add(&(pool->failures), 0);
+}
+
+/**
+ * @brief	Get the number of successful requests for a pool which fell into a wait time histogram bucket.
+ * @see		MAGMA_CORE_POOL_WAIT_BUCKETS
+ * @param	pool	a pointer to the pool to be examined.
+ * @param	bucket	the zero-based index of the histogram bucket.
+ * @return	the number of requests in the specified bucket, or 0 on failure.
+ */
+uint64_t pool_get_waits(pool_t *pool, uint32_t bucket) {
+
+	if (!pool || bucket >= MAGMA_CORE_POOL_WAIT_BUCKETS)
+		return 0;
 
-	return result;
+	return __sync_fetch_and_add(&(pool->waits[bucket]), 0);
 }
 
 /**
@@ -168,53 +183,105 @@ status_t pool_set_status(pool_t *pool, uint32_t item, status_t status) {
 	return *(pool->status + item) = status;
 }
 
+/**
+ * @brief	Pop an item off the free list of a pool, and mark it reserved.
+ * @note	The caller must have already acquired the pool semaphore, which guarantees the free list holds an item for it.
+ * @param	pool	the pool being modified.
+ * @return	the zero-based index of the reserved item.
+ */
+uint32_t pool_pop(pool_t *pool) {
+
+	uint32_t item;
+	uint64_t head;
+
+	do {
+		// Another thread may have acquired the semaphore, but not yet pushed its item, so if the list is empty we wait our turn.
+		while (!((head = pool->head) & 0xFFFFFFFF)) {
+			sched_yield();
+		}
+
+		item = (head & 0xFFFFFFFF) - 1;
+
+	} while (!__sync_bool_compare_and_swap(&(pool->head), head, (((head >> 32) + 1) << 32) | pool->next[item]));
+
+	// The item could be briefly held by pool_swap_obj(), which marks items reserved while it updates them.
+	while (!__sync_bool_compare_and_swap(pool->status + item, PL_AVAILABLE, PL_RESERVED)) {
+		sched_yield();
+	}
+
+	return item;
+}
+
+/**
+ * @brief	Push an item back onto the free list of a pool.
+ * @param	pool	the pool being modified.
+ * @param	item	the zero-based index of the item being returned.
+ * @return	This function returns no value.
+ */
+void pool_push(pool_t *pool, uint32_t item) {
+
+	uint64_t head;
+
+	do {
+		head = pool->head;
+		pool->next[item] = head & 0xFFFFFFFF;
+	} while (!__sync_bool_compare_and_swap(&(pool->head), head, (((head >> 32) + 1) << 32) | (item + 1)));
+
+	return;
+}
+
 /**
  * @brief	Return the first available object in a pool.
  * @note	If no object can be returned immediately, wait for the pool's configured timeout value, in seconds, for
- * 			an object to become available. If the timeout is zero, wait indefinitely.
+ * 			an object to become available. If the timeout is zero, wait indefinitely. The time spent waiting is recorded
+ * 			in the pool's wait time histogram.
  * @param	item	A pointer to a number that will store the zero-based indexed of the first available item in the pool.
  * @return	PL_RESERVED on success or PL_ERROR if an object couldn't be reserved.
  */
 status_t pool_pull(pool_t *pool, uint32_t *item) {
 
-	status_t result = PL_ERROR;
-	struct timespec timeout;
+	uint32_t bucket = 0;
+	uint64_t waited, limit = 10;
+	struct timespec timeout, start, finish;
 
 	if (!pool || !item)
 		return PL_ERROR;
 
-	if (pool->timeout != 0) {
+	// The common case is an object being available, which avoids reading the clock.
+	if (sem_trywait(&(pool->available))) {
 
-		if (clock_gettime(CLOCK_REALTIME, &timeout))
+		if (clock_gettime(CLOCK_MONOTONIC, &start))
 			return PL_ERROR;
 
-		timeout.tv_sec += pool->timeout;
+		if (pool->timeout != 0) {
 
-		if (sem_timedwait(&(pool->available), &timeout)) {
-			mutex_lock(&(pool->lock));
-			pool->failures++;
-			mutex_unlock(&(pool->lock));
-			return PL_ERROR;
+			if (clock_gettime(CLOCK_REALTIME, &timeout))
+				return PL_ERROR;
+
+			timeout.tv_sec += pool->timeout;
+
+			if (sem_timedwait(&(pool->available), &timeout)) {
+				__sync_fetch_and_add(&(pool->failures), 1);
+				return PL_ERROR;
+			}
+
+		} else {
+			sem_wait(&(pool->available));
 		}
 
-	} else {
-		sem_wait(&(pool->available));
-	}
+		clock_gettime(CLOCK_MONOTONIC, &finish);
+		waited = ((finish.tv_sec - start.tv_sec) * 1000000) + ((finish.tv_nsec - start.tv_nsec) / 1000);
 
-	mutex_lock(&(pool->lock));
-	for (uint32_t i = 0; result == PL_ERROR && i < pool->count; i++) {
-		if (pool_get_status(pool, i) == PL_AVAILABLE) {
-			result = pool_set_status(pool, i, PL_RESERVED);
-			*item = i;
+		// Find the first bucket whose upper bound, in microseconds, is larger than the time we waited.
+		for (bucket = 1; bucket < MAGMA_CORE_POOL_WAIT_BUCKETS - 1 && waited >= limit; bucket++) {
+			limit *= 10;
 		}
 	}
 
-	if (result == PL_ERROR)
-		pool->failures++;
+	__sync_fetch_and_add(&(pool->waits[bucket]), 1);
+	*item = pool_pop(pool);
 
-	mutex_unlock(&(pool->lock));
-
-	return result;
+	return PL_RESERVED;
 }
 
 /**
@@ -224,11 +291,17 @@ status_t pool_pull(pool_t *pool, uint32_t *item) {
  * @return	This function returns no value.
  */
 void pool_release(pool_t *pool, uint32_t item) {
+
 	if (!pool)
 		return;
-	mutex_lock(&(pool->lock));
-	pool_set_status(pool, item, PL_AVAILABLE);
-	mutex_unlock(&(pool->lock));
+
+	// Releasing an item twice would link it into the free list twice, so we refuse to do it.
+	if (item >= pool->count || !__sync_bool_compare_and_swap(pool->status + item, PL_RESERVED, PL_AVAILABLE)) {
+		log_pedantic("Attempted to release a pool item which wasn't reserved. { item = %u }", item);
+		return;
+	}
+
+	pool_push(pool, item);
 	sem_post(&(pool->available));
 }
 
@@ -245,13 +318,10 @@ void * pool_get_obj(pool_t *pool, uint32_t item) {
 	}
 
 #ifdef MAGMA_PEDANTIC
-	mutex_lock(&(pool->lock));
 	if (item >= pool_get_count(pool)) {
-		mutex_unlock(&(pool->lock));
 		log_pedantic("The item number provided (%u) is outside the valid range.", item);
 		return NULL;
 	}
-	mutex_unlock(&(pool->lock));
 #endif
 
 	return *(pool->objects + item);
@@ -271,13 +341,10 @@ void * pool_set_obj(pool_t *pool, uint32_t item, void *object) {
 	}
 
 #ifdef MAGMA_PEDANTIC
-	mutex_lock(&(pool->lock));
 	if (item >= pool_get_count(pool)) {
-		mutex_unlock(&(pool->lock));
 		log_pedantic("The item number provided (%u) is outside the valid range.", item);
 		return NULL;
 	}
-	mutex_unlock(&(pool->lock));
 #endif
 
 	return *(pool->objects + item) = object;
@@ -304,13 +371,14 @@ void * pool_swap_obj(pool_t *pool, uint32_t item, void *object) {
 	delay.tv_nsec = 10000000;
 
 	do {
-		mutex_lock(&(pool->lock));
-		if (pool_get_status(pool, item) == PL_AVAILABLE) {
+		// The item is marked reserved while it's updated, so a thread popping it off the free list waits for the swap to finish.
+		if (__sync_bool_compare_and_swap(pool->status + item, PL_AVAILABLE, PL_RESERVED)) {
 			current = pool_get_obj(pool, item);
 			pool_set_obj(pool, item, object);
+			__sync_synchronize();
+			pool_set_status(pool, item, PL_AVAILABLE);
 			loop = false;
 		}
-		mutex_unlock(&(pool->lock));
 
 		/// LOW: Currently the function loops until the requested object is available. A superior implementation would hook into the release function and detect when
 		/// the desired object is available and perform the swap at that point.
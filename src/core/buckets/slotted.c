@@ -0,0 +1,141 @@
+
+/**
+ * @file /magma/core/buckets/slotted.c
+ *
+ * @brief	A fixed size table of slots, used by the in-process caches which sit in front of the database, DNS and memcached lookups.
+ *
+ * @note	The caller hashes its key, and the hash selects a single slot, so storing a key replaces whatever was held in its slot and
+ * 			the table never grows. The slots are protected by a fixed number of striped locks, so threads only contend when their keys
+ * 			happen to share a lock. The caller defines the slot layout, and decides whether a slot holds the key it's looking for.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Allocate a fixed slot table.
+ * @param	count			the number of slots in the table.
+ * @param	size			the size of each slot, in bytes.
+ * @param	secure			if true, the table is allocated from secure memory.
+ * @param	clear_function	if not NULL, a function which releases anything a slot points to before the slot is wiped.
+ * @return	NULL on failure, or a pointer to the newly allocated table on success.
+ */
+slotted_t * slotted_alloc(uint32_t count, size_t size, bool_t secure, void *clear_function) {
+
+	slotted_t *table;
+	size_t table_size = sizeof(slotted_t) + (size * count);
+
+	if (!count || !size) {
+		log_pedantic("A slot table requires at least one slot.");
+		return NULL;
+	}
+	else if (!(table = (secure ? mm_sec_alloc(table_size) : mm_alloc(table_size)))) {
+		log_pedantic("Unable to allocate %zu bytes for a slot table.", table_size);
+		return NULL;
+	}
+
+	mm_wipe(table, table_size);
+
+	table->count = count;
+	table->size = size;
+	table->secure = secure;
+	table->clear_function = clear_function;
+	table->slots = (void *)((char *)table + sizeof(slotted_t));
+
+	for (int_t i = 0; i < MAGMA_CORE_SLOTTED_LOCKS; i++) {
+		mutex_init(&(table->locks[i]), NULL);
+	}
+
+	return table;
+}
+
+/**
+ * @brief	Free a fixed slot table, and anything its slots point to.
+ * @param	table	the slot table to be freed.
+ * @return	This function returns no value.
+ */
+void slotted_free(slotted_t *table) {
+
+	size_t table_size;
+
+	if (!table) {
+		return;
+	}
+
+	table_size = sizeof(slotted_t) + (table->size * table->count);
+
+	for (uint32_t i = 0; i < table->count; i++) {
+		slotted_clear(table, (char *)table->slots + (table->size * i));
+	}
+
+	for (int_t i = 0; i < MAGMA_CORE_SLOTTED_LOCKS; i++) {
+		mutex_destroy(&(table->locks[i]));
+	}
+
+	if (table->secure) {
+		mm_wipe(table, table_size);
+		mm_sec_free(table);
+	}
+	else {
+		mm_free(table);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Get the number of slots in a table.
+ * @param	table	the slot table.
+ * @return	the number of slots, or 0 if the table is NULL.
+ */
+uint32_t slotted_count(slotted_t *table) {
+
+	return table ? table->count : 0;
+}
+
+/**
+ * @brief	Lock the slot a hash maps to.
+ * @note	The slot must be unlocked using slotted_unlock() with the same hash. Since a hash smaller than the number of slots maps
+ * 			to the slot with that index, every slot can be visited by locking the hashes from 0 to slotted_count() - 1.
+ * @param	table	the slot table.
+ * @param	hash	the hash of the key being accessed.
+ * @return	a pointer to the locked slot.
+ */
+void * slotted_lock(slotted_t *table, uint64_t hash) {
+
+	uint64_t index = hash % table->count;
+
+	mutex_lock(&(table->locks[index % MAGMA_CORE_SLOTTED_LOCKS]));
+
+	return (char *)table->slots + (table->size * index);
+}
+
+/**
+ * @brief	Unlock the slot a hash maps to.
+ * @param	table	the slot table.
+ * @param	hash	the hash which was used to lock the slot.
+ * @return	This function returns no value.
+ */
+void slotted_unlock(slotted_t *table, uint64_t hash) {
+
+	mutex_unlock(&(table->locks[(hash % table->count) % MAGMA_CORE_SLOTTED_LOCKS]));
+
+	return;
+}
+
+/**
+ * @brief	Release the contents of a slot, and wipe it.
+ * @note	The caller must hold the lock protecting the slot.
+ * @param	table	the slot table.
+ * @param	slot	the slot being cleared.
+ * @return	This function returns no value.
+ */
+void slotted_clear(slotted_t *table, void *slot) {
+
+	if (table->clear_function) {
+		table->clear_function(slot);
+	}
+
+	mm_wipe(slot, table->size);
+
+	return;
+}
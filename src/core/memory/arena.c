@@ -0,0 +1,191 @@
+
+/**
+ * @file /magma/core/memory/arena.c
+ *
+ * @brief	A region allocator for short lived buffers which are all released together, such as the temporaries created while processing
+ * 			a single protocol command.
+ *
+ * @note	An arena is attached to the current thread, and any stringer allocated with the ARENA option while it's attached is carved
+ * 			out of the arena's blocks. Freeing an individual buffer does nothing, the memory is reclaimed when the arena is reset. If no
+ * 			arena is attached, requests for arena memory fall back to the heap.
+ */
+
+#include "magma.h"
+
+// The arena attached to the current thread, if any.
+static __thread mm_arena_t *current = NULL;
+
+/**
+ * @brief	Allocate an empty arena.
+ * @param	length	the length of the arena blocks, which determines how much memory is requested from the heap at a time.
+ * @return	NULL on failure, or a pointer to the new arena on success.
+ */
+mm_arena_t * mm_arena_create(size_t length) {
+
+	mm_arena_t *arena;
+
+	if (!(arena = mm_alloc(sizeof(mm_arena_t)))) {
+		log_pedantic("Unable to allocate memory for the arena.");
+		return NULL;
+	}
+
+	arena->length = length < MM_ARENA_BLOCK_MIN ? MM_ARENA_BLOCK_MIN : length;
+
+	return arena;
+}
+
+/**
+ * @brief	Release every block held by an arena, along with the arena itself.
+ * @note	If the arena is attached to the current thread, it is detached.
+ * @param	arena	the arena being destroyed.
+ * @return	This function returns no value.
+ */
+void mm_arena_destroy(mm_arena_t *arena) {
+
+	mm_arena_block_t *block;
+
+	if (!arena) {
+		return;
+	}
+
+	if (current == arena) {
+		current = NULL;
+	}
+
+	while ((block = arena->blocks)) {
+		arena->blocks = block->next;
+		mm_free(block);
+	}
+
+	mm_free(arena);
+	return;
+}
+
+/**
+ * @brief	Reclaim every buffer allocated from an arena, so the memory can be reused.
+ * @note	Only the first block is kept, unless the previous cycle needed more than one block, in which case the largest block is kept
+ * 			so the next cycle is less likely to need the heap. The allocation counters are also reset.
+ * @param	arena	the arena being reset.
+ * @return	This function returns no value.
+ */
+void mm_arena_reset(mm_arena_t *arena) {
+
+	mm_arena_block_t *block, *keep;
+
+	if (!arena || !(keep = arena->blocks)) {
+		return;
+	}
+
+	for (block = keep->next; block; block = block->next) {
+		if (block->length > keep->length) keep = block;
+	}
+
+	while ((block = arena->blocks)) {
+		arena->blocks = block->next;
+		if (block != keep) mm_free(block);
+	}
+
+	keep->next = NULL;
+	keep->used = 0;
+	arena->blocks = keep;
+
+	mm_wipe(&(arena->counts), sizeof(arena->counts));
+
+	return;
+}
+
+/**
+ * @brief	Attach an arena to the current thread.
+ * @param	arena	the arena which should serve arena allocations, or NULL to detach the current arena.
+ * @return	the arena which was previously attached, or NULL if there wasn't one.
+ */
+mm_arena_t * mm_arena_attach(mm_arena_t *arena) {
+
+	mm_arena_t *previous = current;
+
+	current = arena;
+
+	return previous;
+}
+
+/**
+ * @brief	Get the arena attached to the current thread.
+ * @return	NULL if no arena is attached, or a pointer to the attached arena.
+ */
+mm_arena_t * mm_arena_current(void) {
+
+	return current;
+}
+
+/**
+ * @brief	Count a heap allocation made while an arena is attached, so the number of allocations left on the heap can be measured.
+ * @return	This function returns no value.
+ */
+void mm_arena_heap(void) {
+
+	if (current) {
+		current->counts.heap++;
+	}
+
+	return;
+}
+
+/**
+ * @brief	Allocate a zeroed buffer from the arena attached to the current thread.
+ * @note	Buffers are aligned to 16 bytes. Requests which don't fit in the current block are served by a new block, which is sized to
+ * 			fit the request if it's larger than the arena block length.
+ * @param	len		the length, in bytes, of the buffer to be allocated.
+ * @return	NULL on failure, or if no arena is attached, or a pointer to the buffer on success.
+ */
+void * mm_arena_alloc(size_t len) {
+
+	void *result;
+	size_t length;
+	mm_arena_block_t *block;
+
+	if (!current || !len) {
+		log_pedantic("Unable to allocate memory from an arena. { attached = %s / len = %zu }", current ? "true" : "false", len);
+		return NULL;
+	}
+
+	len = align(16, len);
+
+	if (!(block = current->blocks) || (block->length - block->used) < len) {
+
+		length = len > current->length ? len : current->length;
+
+		// Allocating the block bypasses mm_alloc(), so the new block doesn't show up as a heap allocation made by the caller.
+		if (!(block = malloc(sizeof(mm_arena_block_t) + length))) {
+			log_pedantic("Unable to allocate a new arena block. { length = %zu }", length);
+			return NULL;
+		}
+
+		block->used = 0;
+		block->length = length;
+		block->next = current->blocks;
+		current->blocks = block;
+		current->counts.blocks++;
+	}
+
+	result = block->data + block->used;
+	block->used += len;
+
+	current->counts.allocations++;
+	current->counts.bytes += len;
+
+	mm_wipe(result, len);
+
+	return result;
+}
+
+/**
+ * @brief	Free a buffer allocated from an arena.
+ * @note	This function does nothing, since arena memory is only reclaimed when the arena is reset. It exists so arena buffers can be
+ * 			released using the same code paths as heap and secure buffers.
+ * @param	block	the buffer being released.
+ * @return	This function returns no value.
+ */
+void mm_arena_free(void *block) {
+
+	return;
+}
@@ -189,6 +189,7 @@ void * mm_alloc(size_t len) {
 	}
 	else if ((result = malloc(len))) {
 		mm_set(result, 0, len);
+		mm_arena_heap();
 	}
 	else {
 		log_pedantic("Unable to allocate a block of %zu bytes.", len);
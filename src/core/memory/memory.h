@@ -8,9 +8,40 @@
 #ifndef MAGMA_CORE_MEMORY_H
 #define MAGMA_CORE_MEMORY_H
 
+// The smallest block an arena will request from the heap.
+#define MM_ARENA_BLOCK_MIN 1024
+
+typedef struct mm_arena_block_t {
+	size_t length; /* The number of bytes in the data buffer. */
+	size_t used; /* The number of bytes already handed out. */
+	struct mm_arena_block_t *next;
+	chr_t data[] __attribute__ ((aligned (16)));
+} mm_arena_block_t;
+
+typedef struct {
+	size_t length; /* The default length of new blocks. */
+	mm_arena_block_t *blocks; /* The block list, with the block currently being carved up first. */
+	struct {
+		uint64_t allocations; /* The number of buffers handed out since the last reset. */
+		uint64_t bytes; /* The number of bytes handed out since the last reset. */
+		uint64_t blocks; /* The number of blocks requested from the heap since the last reset. */
+		uint64_t heap; /* The number of heap allocations made by the attached thread since the last reset. */
+	} counts;
+} mm_arena_t;
+
 /// align.c
 size_t align(size_t alignment, size_t len);
 
+/// arena.c
+void *         mm_arena_alloc(size_t len);
+mm_arena_t *   mm_arena_attach(mm_arena_t *arena);
+mm_arena_t *   mm_arena_create(size_t length);
+mm_arena_t *   mm_arena_current(void);
+void           mm_arena_destroy(mm_arena_t *arena);
+void           mm_arena_free(void *block);
+void           mm_arena_heap(void);
+void           mm_arena_reset(mm_arena_t *arena);
+
 /// bitwise.c
 uint_t bitwise_count(uint64_t value);
 uchr_t bitwise_or(uchr_t a, uchr_t b);
@@ -26,6 +57,7 @@ bool_t mm_sec_secured(void *block);
 void * mm_sec_alloc(size_t len);
 void * mm_sec_realloc(void *orig, size_t len);
 bool_t mm_sec_stats(size_t *total, size_t *bytes, size_t *items);
+bool_t mm_sec_usage(size_t *available, size_t *largest, size_t *slots, size_t *reserved);
 
 /// memory.c
 void *   mm_alloc(size_t len);
@@ -47,6 +79,17 @@ void *   mm_wipe(void *block, size_t len);
 // The minimum secure memory block length.
 #define MM_SEC_POOL_LENGTH_MIN 4096
 
+// Small secure allocations are served from size classes, starting at 32 bytes and doubling, with each class getting its own
+// guarded region of the secure slab. The classes share at most one eighth of the slab, so the number actually used depends on how
+// many guarded regions fit in that share.
+#define MM_SEC_CLASS_COUNT 6
+#define MM_SEC_CLASS_MIN 32
+#define MM_SEC_CLASS_SHARE 8
+
+// The number of free slots, per size class, each thread may hold onto, and how many are moved at a time to, or from, the shared class.
+#define MM_SEC_CACHE_SLOTS 16
+#define MM_SEC_CACHE_BATCH 8
+
 // Usage: void *buffer = MEMORYBUF(length);
 #define MEMORYBUF(l) (void *)&((chr_t []){ [ 0 ... l ] = 0 })
 
@@ -3,6 +3,11 @@
  * @file /magma/core/memory/secure.c
  *
  * @brief	Functions for allocating secure memory. Secure buffers should always be used to hold sensitive information.
+ *
+ * @note	The secure slab is split in two. Most of it is a first-fit heap, used for large requests. At most the top eighth is
+ * 			split into size class regions, separated by guard pages, and serves small requests in constant time. Each thread keeps a few free
+ * 			slots from every class, so most small allocations and frees never touch a lock. Blocks are wiped when they are freed, no
+ * 			matter where they came from.
  */
 
 #include "magma.h"
@@ -17,6 +22,25 @@ typedef struct __attribute__ ((packed)) {
 	size_t length;
 } secured_t;
 
+typedef struct {
+	chr_t *data; /* The first slot in the class region. */
+	size_t size; /* The length of each slot. */
+	size_t slots; /* The number of slots in the region. */
+	size_t carved; /* The number of slots handed out at least once. Slots beyond this point have never been used. */
+	size_t reserved; /* The number of slots which are either allocated, or sitting in a thread cache. */
+	void *available; /* A list of free slots, linked through the first word of each slot. */
+	pthread_mutex_t lock;
+} mm_sec_class_t;
+
+// Slots cached by the current thread. The generation is used to discard cached slots which belonged to a previous secure slab.
+static __thread struct {
+	uint64_t generation;
+	uint32_t count[MM_SEC_CLASS_COUNT];
+	void *slots[MM_SEC_CLASS_COUNT][MM_SEC_CACHE_SLOTS];
+} cache = {
+	.generation = 0
+};
+
 static struct {
 
 	struct {
@@ -24,9 +48,22 @@ static struct {
 		void *data;
 		size_t length;
 		size_t length_true;
+		size_t page; /* The length of the guard pages. */
+		size_t heap; /* The length of the first-fit heap, at the start of the slab. */
 		pthread_mutex_t lock;
 	} slab;
 
+	struct {
+		chr_t *data; /* The start of the class area, which begins with the guard page of the first class. */
+		size_t length;
+		size_t stride; /* The distance between classes, which includes the leading guard page. */
+		uint_t count; /* The number of size classes in use. */
+		mm_sec_class_t class[MM_SEC_CLASS_COUNT];
+	} classes;
+
+	uint64_t generation;
+	pthread_key_t key;
+
 	struct {
 		size_t items;
 		size_t bytes;
@@ -39,9 +76,18 @@ static struct {
 	.slab = {
 	.data = NULL,
 	.length = 0,
+	.heap = 0,
 	.lock = PTHREAD_MUTEX_INITIALIZER
 	},
 
+	.classes = {
+		.data = NULL,
+		.length = 0,
+		.count = 0
+	},
+
+	.generation = 0,
+
 	.allocated = {
 		.items = 0,
 		.bytes = 0
@@ -63,11 +109,9 @@ bool_t mm_sec_stats(size_t *total, size_t *bytes, size_t *items) {
 		return false;
 	}
 
-	mutex_lock(&secure.slab.lock);
 	*total = secure.slab.length;
-	*bytes = secure.allocated.bytes;
-	*items = secure.allocated.items;
-	mutex_unlock(&secure.slab.lock);
+	*bytes = __sync_add_and_fetch(&secure.allocated.bytes, 0);
+	*items = __sync_add_and_fetch(&secure.allocated.items, 0);
 
 	return true;
 }
@@ -94,17 +138,31 @@ bool_t mm_sec_secured(void *block) {
 	return input >= slab && input < (slab + secure.slab.length) ? true : false;
 }
 
+/**
+ * @brief	Determine whether the data pointer falls within the first-fit heap at the start of the secure memory slab.
+ * @param	block	the data pointer to be tested.
+ * @return	true if block points into the secure heap, or false otherwise.
+ */
+bool_t mm_sec_heap(void *block) {
+
+	if (!block || !secure.slab.data) {
+		return false;
+	}
+
+	return (chr_t *)block >= (chr_t *)secure.slab.data && (chr_t *)block < ((chr_t *)secure.slab.data + secure.slab.heap) ? true : false;
+}
+
 /**
  * @brief	Get the next chunk of secure memory.
  * @param	chunk	the input secure chunk.
- * @return	a pointer to the next chunk of secure memory, or NULL on failure or if the end of the slab is reached.
+ * @return	a pointer to the next chunk of secure memory, or NULL on failure or if the end of the heap is reached.
  */
 secured_t * mm_sec_chunk_next(secured_t *chunk) {
 
 	secured_t *next;
 
 	next = (secured_t *)((chr_t *)chunk + sizeof(secured_t) + chunk->length);
-	if (!mm_sec_secured(next)) next = NULL;
+	if (!mm_sec_heap(next)) next = NULL;
 
 	return next;
 }
@@ -160,7 +218,7 @@ secured_t * mm_sec_chunk_new(secured_t *block, size_t size) {
 	secured_t *chunk, *split;
 
 	chunk = block;
-	while(loop && mm_sec_secured(chunk)) {
+	while(loop && mm_sec_heap(chunk)) {
 
 		if (!(chunk->flags & MM_SEC_CHUNK_ALLOCATED) && chunk->length >= size) {
 
@@ -183,12 +241,206 @@ secured_t * mm_sec_chunk_new(secured_t *block, size_t size) {
 		}
 	}
 
-	// If we end up reaching the end of the secure address space, return NULL.
-	if (!mm_sec_secured(chunk))	chunk = NULL;
+	// If we end up reaching the end of the secure heap, return NULL.
+	if (!mm_sec_heap(chunk)) chunk = NULL;
 
 	return chunk;
 }
 
+/**
+ * @brief	Find the smallest size class able to hold a request.
+ * @param	len		the aligned length of the request.
+ * @return	the index of the size class, or -1 if the request is too large for any of the classes in use.
+ */
+int_t mm_sec_class_index(size_t len) {
+
+	for (uint_t i = 0; i < secure.classes.count; i++) {
+		if (len <= secure.classes.class[i].size) return i;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief	Find the size class which owns a block of secure memory.
+ * @param	block	the block being checked.
+ * @return	the index of the size class, or -1 if the block wasn't allocated from a size class.
+ */
+int_t mm_sec_class_owner(void *block) {
+
+	size_t offset, within;
+
+	if (!secure.classes.count || (chr_t *)block < secure.classes.data || (chr_t *)block >= secure.classes.data + secure.classes.length) {
+		return -1;
+	}
+
+	offset = (chr_t *)block - secure.classes.data;
+	within = offset % secure.classes.stride;
+
+	// Pointers into a guard page, or which don't point at the start of a slot, can't have come from mm_sec_alloc().
+	if (within < secure.slab.page || (within - secure.slab.page) % secure.classes.class[offset / secure.classes.stride].size) {
+		return -1;
+	}
+
+	return offset / secure.classes.stride;
+}
+
+/**
+ * @brief	Make sure the slots cached by the current thread belong to the current secure slab.
+ * @return	This function returns no value.
+ */
+void mm_sec_cache_check(void) {
+
+	if (cache.generation != secure.generation) {
+		mm_wipe(cache.count, sizeof(cache.count));
+		cache.generation = secure.generation;
+
+		// The key is only used so the destructor returns the cached slots when the thread exits.
+		pthread_setspecific(secure.key, &cache);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Return every slot cached by the current thread to the shared size classes.
+ * @note	This function is registered as a thread specific storage destructor, and is called when a thread exits.
+ * @param	data	ignored.
+ * @return	This function returns no value.
+ */
+void mm_sec_cache_flush(void *data) {
+
+	mm_sec_class_t *class;
+
+	if (cache.generation == secure.generation && secure.classes.count) {
+		for (uint_t i = 0; i < secure.classes.count; i++) {
+
+			class = &(secure.classes.class[i]);
+
+			mutex_lock(&(class->lock));
+			while (cache.count[i]) {
+				*(void **)cache.slots[i][--cache.count[i]] = class->available;
+				class->available = cache.slots[i][cache.count[i]];
+				class->reserved--;
+			}
+			mutex_unlock(&(class->lock));
+		}
+	}
+
+	mm_wipe(cache.count, sizeof(cache.count));
+	return;
+}
+
+/**
+ * @brief	Allocate a slot from a size class.
+ * @note	If the thread cache is empty, a batch of slots is moved from the shared class into the cache.
+ * @param	index	the size class index.
+ * @return	a pointer to the slot, or NULL if the class is exhausted.
+ */
+void * mm_sec_class_alloc(uint_t index) {
+
+	void *slot;
+	mm_sec_class_t *class = &(secure.classes.class[index]);
+
+	mm_sec_cache_check();
+
+	if (!cache.count[index]) {
+
+		mutex_lock(&(class->lock));
+
+		while (cache.count[index] < MM_SEC_CACHE_BATCH) {
+
+			if (class->available) {
+				slot = class->available;
+				class->available = *(void **)slot;
+			}
+			else if (class->carved < class->slots) {
+				slot = class->data + (class->carved++ * class->size);
+			}
+			else {
+				break;
+			}
+
+			class->reserved++;
+			cache.slots[index][cache.count[index]++] = slot;
+		}
+
+		mutex_unlock(&(class->lock));
+	}
+
+	return cache.count[index] ? cache.slots[index][--cache.count[index]] : NULL;
+}
+
+/**
+ * @brief	Return a wiped slot to its size class.
+ * @note	If the thread cache is full, a batch of slots is returned to the shared class.
+ * @param	index	the size class index.
+ * @param	block	the slot being freed.
+ * @return	This function returns no value.
+ */
+void mm_sec_class_free(uint_t index, void *block) {
+
+	mm_sec_class_t *class = &(secure.classes.class[index]);
+
+	mm_sec_cache_check();
+
+	if (cache.count[index] == MM_SEC_CACHE_SLOTS) {
+
+		mutex_lock(&(class->lock));
+
+		for (uint_t i = 0; i < MM_SEC_CACHE_BATCH; i++) {
+			*(void **)cache.slots[index][--cache.count[index]] = class->available;
+			class->available = cache.slots[index][cache.count[index]];
+			class->reserved--;
+		}
+
+		mutex_unlock(&(class->lock));
+	}
+
+	cache.slots[index][cache.count[index]++] = block;
+
+	return;
+}
+
+/**
+ * @brief	Get the usage and fragmentation statistics for the secure memory heap and size classes.
+ * @param	available	a pointer to a size_t variable that will store the number of free bytes in the heap.
+ * @param	largest		a pointer to a size_t variable that will store the length of the largest free heap chunk.
+ * @param	slots		a pointer to a size_t variable that will store the number of size class slots.
+ * @param	reserved	a pointer to a size_t variable that will store the number of size class slots allocated, or held by thread caches.
+ * @return	true on success or false on failure.
+ */
+bool_t mm_sec_usage(size_t *available, size_t *largest, size_t *slots, size_t *reserved) {
+
+	secured_t *chunk;
+
+	if (!secure.enabled || !secure.slab.data || !available || !largest || !slots || !reserved) {
+		return false;
+	}
+
+	*available = *largest = *slots = *reserved = 0;
+
+	mutex_lock(&secure.slab.lock);
+
+	for (chunk = (secured_t *)secure.slab.data; chunk; chunk = mm_sec_chunk_next(chunk)) {
+		if (!(chunk->flags & MM_SEC_CHUNK_ALLOCATED)) {
+			*available += chunk->length;
+			if (chunk->length > *largest) *largest = chunk->length;
+		}
+	}
+
+	mutex_unlock(&secure.slab.lock);
+
+	for (uint_t i = 0; i < secure.classes.count; i++) {
+		mutex_lock(&(secure.classes.class[i].lock));
+		*slots += secure.classes.class[i].slots;
+		*reserved += secure.classes.class[i].reserved;
+		mutex_unlock(&(secure.classes.class[i].lock));
+	}
+
+	return true;
+}
+
 /**
  * @brief	Free a secure memory block and perform a multi-pass wipe of its contents.
  * @return	This function returns no value.
@@ -196,6 +448,7 @@ secured_t * mm_sec_chunk_new(secured_t *block, size_t size) {
 void mm_sec_free(void *block) {
 
 	size_t len;
+	int_t index;
 	secured_t *chunk;
 
 #ifdef MAGMA_PEDANTIC
@@ -204,7 +457,20 @@ void mm_sec_free(void *block) {
 	}
 #endif
 
-	if (block && secure.enabled && mm_sec_secured(block)) {
+	if (block && secure.enabled && (index = mm_sec_class_owner(block)) >= 0) {
+		len = secure.classes.class[index].size;
+
+		// Wipe the data segment three times to ensure sensitive information isn't leaked.
+		mm_set(block, 255, len);
+		mm_set(block, 128, len);
+		mm_set(block, 0, len);
+
+		__sync_sub_and_fetch(&secure.allocated.items, 1);
+		__sync_sub_and_fetch(&secure.allocated.bytes, len);
+
+		mm_sec_class_free(index, block);
+	}
+	else if (block && secure.enabled && mm_sec_heap(block)) {
 		chunk = (secured_t *)((chr_t *)block - sizeof(secured_t));
 		len = chunk->length;
 
@@ -213,10 +479,10 @@ void mm_sec_free(void *block) {
 		mm_set(block, 128, len);
 		mm_set(block, 0, len);
 
-		mutex_lock(&secure.slab.lock);
+		__sync_sub_and_fetch(&secure.allocated.items, 1);
+		__sync_sub_and_fetch(&secure.allocated.bytes, len);
 
-		secure.allocated.items--;
-		secure.allocated.bytes -= len;
+		mutex_lock(&secure.slab.lock);
 
 		chunk->flags &= ~MM_SEC_CHUNK_ALLOCATED;
 		mm_sec_chunk_merge(chunk);
@@ -244,12 +510,15 @@ void mm_sec_cleanup(void *block) {
 
 /**
  * @brief	Allocate a chunk of memory from the secure memory slab
+ * @note	Small requests are served by the size classes, and fall back to the heap if their class is exhausted.
+ * @see		mm_sec_class_alloc()
  * @see		mm_sec_chunk_new()
  * @param	len		the length, in bytes, of the secure memory chunk to be allocated.
  * @return	NULL on failure, or a pointer to the freshly allocated chunk of secure memory on success.
  */
 void * mm_sec_alloc(size_t len) {
 
+	int_t index;
 	secured_t *chunk;
 	void *result = NULL;
 
@@ -260,16 +529,22 @@ void * mm_sec_alloc(size_t len) {
 	// Align allocations to a length of 12 bytes, which is the size of our secured_t structure.
 	len = align(16, len);
 
-	mutex_lock(&secure.slab.lock);
-
-	if ((chunk = mm_sec_chunk_new(secure.slab.data, len))) {
-		secure.allocated.items++;
-		secure.allocated.bytes += len;
+	if ((index = mm_sec_class_index(len)) >= 0 && (result = mm_sec_class_alloc(index))) {
+		len = secure.classes.class[index].size;
+		__sync_add_and_fetch(&secure.allocated.items, 1);
+		__sync_add_and_fetch(&secure.allocated.bytes, len);
+		mm_wipe(result, len);
+		return result;
 	}
 
+	mutex_lock(&secure.slab.lock);
+	chunk = mm_sec_chunk_new(secure.slab.data, len);
 	mutex_unlock(&secure.slab.lock);
 
+	// The chunk may be slightly longer than requested, if splitting off the remainder wasn't worthwhile.
 	if (chunk) {
+		__sync_add_and_fetch(&secure.allocated.items, 1);
+		__sync_add_and_fetch(&secure.allocated.bytes, chunk->length);
 		result = ((chr_t *)chunk + sizeof(secured_t));
 		mm_wipe(result, len);
 	}
@@ -296,8 +571,8 @@ void * mm_sec_alloc(size_t len) {
 void * mm_sec_realloc(void *orig, size_t len) {
 
 	size_t olen;
+	int_t index;
 	void *result;
-	secured_t *chunk;
 
 	if (!secure.enabled || !secure.slab.data || !orig || !len) {
 #ifdef MAGMA_PEDANTIC
@@ -306,8 +581,12 @@ void * mm_sec_realloc(void *orig, size_t len) {
 		return NULL;
 	}
 
-	chunk = (secured_t *)((chr_t *)orig - sizeof(secured_t));
-	olen = chunk->length;
+	if ((index = mm_sec_class_owner(orig)) >= 0) {
+		olen = secure.classes.class[index].size;
+	}
+	else {
+		olen = ((secured_t *)((chr_t *)orig - sizeof(secured_t)))->length;
+	}
 
 	// Requests that would shrink the chunk by less than 256 bytes probably aren't worth the overhead to process.
 	if (len <= olen && (olen - len) >= 256) {
@@ -329,6 +608,22 @@ void mm_sec_stop(void) {
 
 	if (secure.enabled && secure.slab.data) {
 
+		// The guard pages between the size classes must be writable before the slab can be wiped.
+		for (uint_t i = 0; i < secure.classes.count; i++) {
+			mprotect(secure.classes.data + (i * secure.classes.stride), secure.slab.page, PROT_READ | PROT_WRITE);
+			mutex_destroy(&(secure.classes.class[i].lock));
+		}
+
+		// Any slots still sitting in a thread cache are discarded the next time the thread touches its cache.
+		if (secure.classes.count) {
+			pthread_key_delete(secure.key);
+		}
+
+		secure.generation++;
+		secure.classes.count = 0;
+		secure.classes.data = NULL;
+		secure.classes.length = secure.classes.stride = 0;
+
 		mm_set(secure.slab.data, 255, secure.slab.length);
 		mm_set(secure.slab.data, 128, secure.slab.length);
 		mm_set(secure.slab.data, 64, secure.slab.length);
@@ -341,7 +636,7 @@ void mm_sec_stop(void) {
 		munmap(secure.slab.data_true, secure.slab.length_true);
 
 		secure.slab.data = secure.slab.data_true = NULL;
-		secure.slab.length = secure.slab.length_true = 0;
+		secure.slab.length = secure.slab.length_true = secure.slab.heap = 0;
 
 	}
 
@@ -357,8 +652,9 @@ void mm_sec_stop(void) {
 bool_t mm_sec_start(void) {
 
 	uchr_t *bndptr;
-	size_t alignment;
+	size_t alignment, region;
 	secured_t *chunk;
+	mm_sec_class_t *class;
 
 #ifdef  MAGMA_ENGINE_CONFIG_GLOBAL_H
 	if (!(secure.enabled = magma.secure.memory.enable)) {
@@ -458,8 +754,64 @@ bool_t mm_sec_start(void) {
 
 	mm_wipe(secure.slab.data, secure.slab.length);
 
+#ifdef  MAGMA_ENGINE_CONFIG_GLOBAL_H
+	secure.slab.page = magma.page_length;
+#else
+	secure.slab.page = CORE_PAGE_LENGTH;
+#endif
+
+	// The size classes get the top of the slab, but never more than their share of it, so the heap keeps enough room for the larger
+	// buffers. Each class needs at least one page, plus a guard page, so a small slab may only support a few classes, or none at all.
+	if ((secure.classes.count = (secure.slab.length / MM_SEC_CLASS_SHARE) / (secure.slab.page * 2)) > MM_SEC_CLASS_COUNT) {
+		secure.classes.count = MM_SEC_CLASS_COUNT;
+	}
+
+	if (secure.classes.count) {
+
+		region = (((secure.slab.length / MM_SEC_CLASS_SHARE) / secure.classes.count) - secure.slab.page) & ~(secure.slab.page - 1);
+		secure.classes.stride = region + secure.slab.page;
+		secure.classes.length = secure.classes.stride * secure.classes.count;
+		secure.classes.data = (chr_t *)secure.slab.data + secure.slab.length - secure.classes.length;
+
+		if (pthread_key_create(&(secure.key), &mm_sec_cache_flush)) {
+			log_pedantic("Unable to create the secure memory thread cache key.");
+			secure.classes.count = 0;
+		}
+	}
+
+	for (uint_t i = 0; i < secure.classes.count; i++) {
+
+		class = &(secure.classes.class[i]);
+		class->size = MM_SEC_CLASS_MIN << i;
+		class->data = secure.classes.data + (i * secure.classes.stride) + secure.slab.page;
+		class->slots = region / class->size;
+		class->carved = class->reserved = 0;
+		class->available = NULL;
+
+		if (mprotect(secure.classes.data + (i * secure.classes.stride), secure.slab.page, PROT_NONE) || mutex_init(&(class->lock), NULL)) {
+			log_pedantic("Unable to set up the secure memory size classes.");
+
+			// Classes which were already set up still hold a mutex, while the rest only need their guard page restored.
+			for (uint_t j = 0; j <= i; j++) {
+				mprotect(secure.classes.data + (j * secure.classes.stride), secure.slab.page, PROT_READ | PROT_WRITE);
+				if (j < i) mutex_destroy(&(secure.classes.class[j].lock));
+			}
+
+			pthread_key_delete(secure.key);
+			secure.classes.count = 0;
+		}
+	}
+
+	if (!secure.classes.count) {
+		secure.classes.data = NULL;
+		secure.classes.length = secure.classes.stride = 0;
+	}
+
+	secure.slab.heap = secure.slab.length - secure.classes.length;
+	secure.generation++;
+
 	chunk = (secured_t *)secure.slab.data;
-	chunk->length = secure.slab.length - sizeof(secured_t);
+	chunk->length = secure.slab.heap - sizeof(secured_t);
 	chunk->flags = 0;
 
 	return true;
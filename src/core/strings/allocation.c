@@ -29,7 +29,7 @@
 void st_free(stringer_t *s) {
 
 	uint32_t opts = *((uint32_t *)s);
-	void (*release)(void *buffer) = opts & SECURE ? &mm_sec_free : &mm_free;
+	void (*release)(void *buffer) = opts & SECURE ? &mm_sec_free : opts & ARENA ? &mm_arena_free : &mm_free;
 
 #ifdef MAGMA_PEDANTIC
 	if (!st_valid_free(opts)) {
@@ -386,7 +386,8 @@ stringer_t * st_dupe_opts(uint32_t opts, stringer_t *s) {
 /**
  * @brief	Duplicate a managed string.
  * @see		st_dupe_opts()
- * @note	The allocation options of the duplicated string will be the same as that of the source string.
+ * @note	The allocation options of the duplicated string will be the same as that of the source string, except that duplicates of
+ * 			arena strings are allocated off the heap, since a copy is usually made so the data can outlive the arena.
  * @param	s	the managed string to be duplicated.
  * @return	NULL on failure, or a copy of the input managed string on success.
  */
@@ -394,7 +395,7 @@ stringer_t * st_dupe(stringer_t *s) {
 
 	uint32_t opts = *((uint32_t *)s);
 
-	return st_dupe_opts(opts, s);
+	return st_dupe_opts(opts & ARENA ? (opts ^ ARENA) | HEAP : opts, s);
 }
 
 /**
@@ -501,12 +502,18 @@ stringer_t * st_alloc_opts(uint32_t opts, size_t len) {
 	int handle = -1;
 	size_t avail = 0;
 	stringer_t *result = NULL;
-	void (*release)(void *buffer) = opts & SECURE ? &mm_sec_free : &mm_free;
-	void * (*allocate)(size_t len) = opts & SECURE ? &mm_sec_alloc : &mm_alloc;
+	void (*release)(void *buffer);
+	void * (*allocate)(size_t len);
 
 	// The logic below allocates memory off the heap, so if were passed options calling for the stack we silently replace it with instructions to use the heap.
 	opts = (opts & STACK ? (opts ^ STACK) | HEAP : opts);
 
+	// Arena strings are only carved from an arena if one is attached to the current thread, otherwise they're treated like any other heap string.
+	opts = (opts & ARENA && !mm_arena_current() ? (opts ^ ARENA) | HEAP : opts);
+
+	release = opts & SECURE ? &mm_sec_free : opts & ARENA ? &mm_arena_free : &mm_free;
+	allocate = opts & SECURE ? &mm_sec_alloc : opts & ARENA ? &mm_arena_alloc : &mm_alloc;
+
 #ifdef MAGMA_PEDANTIC
 	if (!st_valid_opts(opts)) {
 		log_pedantic("Invalid string options. { opt = %u = %s }", opts, st_info_opts(opts, MEMORYBUF(128), 128));
@@ -659,8 +666,8 @@ stringer_t * st_realloc(stringer_t *s, size_t len) {
 	size_t original, avail;
 	stringer_t *result = NULL;
 	uint32_t opts = *((uint32_t *)s);
-	void (*release)(void *buffer) = opts & SECURE ? &mm_sec_free : &mm_free;
-	void * (*allocate)(size_t len) = opts & SECURE ? &mm_sec_alloc : &mm_alloc;
+	void (*release)(void *buffer) = opts & SECURE ? &mm_sec_free : opts & ARENA ? &mm_arena_free : &mm_free;
+	void * (*allocate)(size_t len) = opts & SECURE ? &mm_sec_alloc : opts & ARENA ? &mm_arena_alloc : &mm_alloc;
 
 #ifdef MAGMA_PEDANTIC
 	if (!st_valid_opts(opts)) {
@@ -94,7 +94,7 @@ void st_data_set(stringer_t *s, void *data) {
 	uint32_t opts;
 	void (*release)(void *buffer);
 
-	if (!s || !(opts = *((uint32_t *)s)) || !(release = opts & SECURE ? &mm_sec_free : &mm_free)) {
+	if (!s || !(opts = *((uint32_t *)s)) || !(release = opts & SECURE ? &mm_sec_free : opts & ARENA ? &mm_arena_free : &mm_free)) {
 		return;
 	}
 
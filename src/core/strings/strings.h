@@ -29,6 +29,7 @@ enum {
 	STACK = 256,				// More properly, data is not on the heap (stack or static initialization)
 	HEAP = 512,
 	SECURE = 1024,				// Must be on the heap
+	ARENA = 2048,				// Carved from the arena attached to the current thread, and released when the arena is reset
 
 	// Flags
 	FOREIGNDATA = 4096			// Do not free data upon deallocation - this is somebody else's job!
@@ -315,17 +315,20 @@ void config_output_help(void) {
  *			3. Make sure 10 <= magma.iface.cache.retry <= 86400
  *			4. Make sure 1 <= magma.iface.cache.timeout <= 3600
  *			5. Make sure magma.iface.cache.retry <= magma.iface.cache.timeout
- *			6. Make sure 40 <= magma.smtp.wrap_line_length <= 65535
- *			7. Make sure 8 <= magma.smtp.recipient_limit <= 32768
- *			8. Make sure 16 <= magma.smtp.relay_limit
- *			9. Make sure 16384 <= system_ulimit_max(RLIMIT_STACK)
- *			10. If magma.system.daemonize is set, make sure magma.output.file is not false
- *			11. If magma.output.file is enabled, magma.output.path must be set.
- *			12. If magma.dkim.enabled is set, then magma.dkim.domain, magma.dkim.selector, and magma.dkim.key must all be set.
- *			13. Validate all the configured magma servers, relay servers, and cache servers.
- *			14. Check all config key filenames and directories to ensure that they exist and are accessible.
- *			15. Make sure magma.admin.contact and point to valid email addresses, if they are specified.
- *			16. If magma.config.output_config is set, dump the current configuration.
+ *			6. Make sure 60 <= magma.iface.cryptography.sessions.timeout <= 86400, and magma.iface.cryptography.tickets.rotate is 0 or >= 60
+ *			7. Make sure 1 <= magma.imap.idle.interval <= 3600 and 1800 <= magma.imap.idle.timeout, 1 <= magma.imap.compress.level <= 9
+ *			   and 9 <= magma.imap.compress.window <= 15
+ *			8. Make sure 40 <= magma.smtp.wrap_line_length <= 65535
+ *			9. Make sure 8 <= magma.smtp.recipient_limit <= 32768
+ *			10. Make sure 16 <= magma.smtp.relay_limit
+ *			11. Make sure 16384 <= system_ulimit_max(RLIMIT_STACK)
+ *			12. If magma.system.daemonize is set, make sure magma.output.file is not false
+ *			13. If magma.output.file is enabled, magma.output.path must be set.
+ *			14. If magma.dkim.enabled is set, then magma.dkim.domain, magma.dkim.selector, and magma.dkim.key must all be set.
+ *			15. Validate all the configured magma servers, relay servers, and cache servers.
+ *			16. Check all config key filenames and directories to ensure that they exist and are accessible.
+ *			17. Make sure magma.admin.contact and point to valid email addresses, if they are specified.
+ *			18. If magma.config.output_config is set, dump the current configuration.
  */
 bool_t config_validate_settings(void) {
 
@@ -397,6 +400,44 @@ bool_t config_validate_settings(void) {
 		result = false;
 	}
 
+	// The IMAP idle serial check interval.
+	if (magma.imap.idle.interval < 1) {
+		log_critical("magma.imap.idle.interval is required to be 1 or larger.");
+		result = false;
+	}
+	else if (magma.imap.idle.interval > 3600) {
+		log_critical("magma.imap.idle.interval is required to be 3600 or smaller.");
+		result = false;
+	}
+
+	// The IMAP idle timeout. RFC 3501 requires an inactivity timer of at least 30 minutes.
+	if (magma.imap.idle.timeout < 1800) {
+		log_critical("magma.imap.idle.timeout is required to be 1800 or larger.");
+		result = false;
+	}
+
+	// The TLS session resumption settings.
+	if (magma.iface.cryptography.sessions.timeout < 60 || magma.iface.cryptography.sessions.timeout > 86400) {
+		log_critical("magma.iface.cryptography.sessions.timeout is required to be between 60 and 86400.");
+		result = false;
+	}
+
+	if (magma.iface.cryptography.tickets.rotate && magma.iface.cryptography.tickets.rotate < 60) {
+		log_critical("magma.iface.cryptography.tickets.rotate is required to be 0, or 60 and larger.");
+		result = false;
+	}
+
+	// The IMAP compression settings.
+	if (magma.imap.compress.level < 1 || magma.imap.compress.level > 9) {
+		log_critical("magma.imap.compress.level is required to be between 1 and 9.");
+		result = false;
+	}
+
+	if (magma.imap.compress.window < 9 || magma.imap.compress.window > 15) {
+		log_critical("magma.imap.compress.window is required to be between 9 and 15.");
+		result = false;
+	}
+
 	// Line wrapping range check.
 	if (magma.smtp.wrap_line_length < 40) {
 		log_critical("magma.smtp.wrap_line_length is required to be 40 or larger.");
@@ -480,6 +521,7 @@ bool_t config_validate_settings(void) {
 	if (magma.dkim.key) CONFIG_CHECK_FILE_READABLE(st_char_get(magma.dkim.key));
 	if (magma.dime.key) CONFIG_CHECK_FILE_READABLE(st_char_get(magma.dime.key));
 	if (magma.dime.signet) CONFIG_CHECK_FILE_READABLE(st_char_get(magma.dime.signet));
+	if (magma.iface.cryptography.tickets.file) CONFIG_CHECK_FILE_READABLE(magma.iface.cryptography.tickets.file);
 
 	// Validate read access to the directories provided.
 	CONFIG_CHECK_DIR_READABLE(magma.system.root_directory);
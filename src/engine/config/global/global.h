@@ -66,6 +66,16 @@ typedef struct {
 			uint64_t length; /* The size of the secure memory pool. The pool must fit within any memory locking limits. */
 		} memory;
 
+		struct {
+			uint32_t entries; /* The number of verified credentials held in the cache, or 0 to disable the cache. */
+			uint32_t timeout; /* The number of seconds a set of verified credentials is trusted. */
+		} auth_cache;
+
+		struct {
+			uint32_t threads; /* The number of threads deriving STACIE keys in batches, or 0 to disable batching. */
+			uint32_t delay; /* The number of milliseconds a derivation thread waits for more logins before starting a batch. */
+		} derivation;
+
 
 		uint32_t minimum_password_length; /* The minimum number of characters a valid password must contain. */
 		stringer_t *salt; /* The string added to hash operations to improve security. */
@@ -113,6 +123,19 @@ typedef struct {
 
 		stringer_t *bypass_addr; /* Bypass address/subnet string for smtp checks. This value used only by config. */
 		inx_t *bypass_subnets; /* Holder for all the address/subnets to be waived through for bypass */
+
+		struct {
+			uint32_t entries; /* The number of slots in the inbound preferences cache, or 0 to disable the cache. */
+			uint32_t timeout; /* The number of seconds the preferences for a valid recipient are trusted. */
+			uint32_t negative; /* The number of seconds an unknown, non-local or locked recipient is remembered. */
+		} inbound_cache;
+
+		struct {
+			uint32_t interval; /* How often, in seconds, the message counters are flushed, or 0 to query the database for every message. */
+			uint32_t idle; /* The number of seconds an unused message counter is kept in memory. */
+		} counters;
+
+		uint32_t fanout; /* The number of threads which may deliver an inbound message to its recipients in parallel. */
 	} smtp;
 
 	struct {
@@ -124,6 +147,17 @@ typedef struct {
 		uint32_t session_timeout; /* Number of seconds before a session cookie expires. */
 	} http;
 
+	struct {
+		struct {
+			uint32_t interval; /* How often idle sessions check the cached serial numbers for changes made by other cluster nodes. */
+			uint32_t timeout; /* Number of seconds a session may remain idle before being disconnected. */
+		} idle;
+		struct {
+			uint32_t level; /* The DEFLATE compression level used for sessions which issue the COMPRESS command. */
+			uint32_t window; /* The base two logarithm of the compression window size, which bounds the memory used by each session. */
+		} compress;
+	} imap;
+
 	struct {
 		relay_t *host[MAGMA_RELAY_INSTANCES];
 		struct {
@@ -151,6 +185,10 @@ typedef struct {
 		chr_t *domain;
 		chr_t *selector;
 		stringer_t *key; /* Location of the dkim private key at startup (replaced with contents later). */
+		struct {
+			uint32_t entries; /* The number of public key records to cache, or 0 to disable the cache. */
+			uint32_t timeout; /* The maximum number of seconds a public key record is cached. */
+		} cache;
 	} dkim;
 
 	struct {
@@ -164,6 +202,18 @@ typedef struct {
 			uint32_t seed_length; /* How much data should be used to seed the random number generator. */
 			bool_t dhparams_rotate; /* Should we generate new a DH prime parameter periodically. */
 			bool_t dhparams_large_keys; /* Should we use large DH session keys. */
+
+			struct {
+				uint32_t cache; /* The maximum number of TLS sessions cached by each server, or 0 to disable the session cache. */
+				uint32_t timeout; /* The number of seconds a TLS session, or session ticket, can be resumed. */
+			} sessions;
+
+			struct {
+				uint32_t rotate; /* The number of seconds between session ticket key rotations, or 0 to disable session tickets unless a key file is set. */
+				chr_t *file; /* An optional file holding the session ticket keys, so they can be shared across cluster nodes. */
+			} tickets;
+
+			bool_t ktls; /* Should the record layer of TLS connections be handed to the kernel, when supported. */
 		} cryptography;
 
 		struct {
@@ -178,11 +228,21 @@ typedef struct {
 				uint32_t timeout; /* The number of seconds to wait for a free database connection. */
 				uint32_t connections; /* The number of database connections in the pool. */
 			} pool;
+
+			struct {
+				chr_t *host; /* The read replica host name, or NULL if every query is sent to the primary database server. */
+				uint32_t port; /* The read replica server port. */
+				chr_t *socket_path; /* The read replica UNIX domain socket path. */
+				uint32_t connections; /* The number of read replica connections in the pool. */
+				uint32_t lag; /* The number of seconds a replica may fall behind before reads are sent to the primary. */
+				uint32_t window; /* The number of seconds after a write during which the affected reads are sent to the primary. */
+			} replica;
 		} database;
 
 		struct {
 			bool_t available; /* Is ClamAV loaded at runtime. */
 			char *signatures; /* The signatures directory. */
+			uint32_t cache; /* The number of clean message part verdicts to cache. */
 		} virus;
 
 		struct {
@@ -196,6 +256,11 @@ typedef struct {
 				uint32_t timeout; /* The number of seconds to wait for a free cache context. */
 				uint32_t connections; /* The number of cache client objects to hold in the pool. */
 			} pool;
+			struct {
+				uint32_t entries; /* The number of slots in the in-process near cache, or 0 to disable the near cache. */
+				uint32_t timeout; /* The number of seconds a value held by the near cache is trusted. */
+				bool_t broadcast; /* Should changes be announced to the near caches held by other processes. */
+			} near;
 			uint32_t retry; /* How often should dead caching servers be retried. */
 			uint32_t timeout; /* The TCP socket send/recv timeout. */
 		} cache;
@@ -205,6 +270,10 @@ typedef struct {
 				uint32_t timeout; /* The number of seconds to wait for a free SPF instance. */
 				uint32_t connections; /* The number of SPF instances in the pool. */
 			} pool;
+			struct {
+				uint32_t entries; /* The number of SPF outcomes to cache, or 0 to disable the cache. */
+				uint32_t timeout; /* The number of seconds an SPF outcome is cached. */
+			} cache;
 		} spf;
 
 	} iface;
@@ -220,6 +220,54 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.secure.auth_cache.entries),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 0,
+		.name = "magma.secure.auth_cache.entries",
+		.description = "The number of verified STACIE credentials held in secure memory, so clients which log in repeatedly don't force the key derivation to be repeated. The secure memory pool must be large enough to hold the cache. Use 0 to disable the cache.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.secure.auth_cache.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 300,
+		.name = "magma.secure.auth_cache.timeout",
+		.description = "The number of seconds a set of verified credentials is held in the cache.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.secure.derivation.threads),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 0,
+		.name = "magma.secure.derivation.threads",
+		.description = "The number of threads used to derive the STACIE keys for concurrent logins in batches, several at a time. The secure memory pool holds the pending requests. Use 0 to derive the keys for each login separately.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.secure.derivation.delay),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 2,
+		.name = "magma.secure.derivation.delay",
+		.description = "The number of milliseconds a key derivation thread waits for more logins to arrive before it starts a partially filled batch.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.iface.cryptography.seed_length),
 		.norm.type = M_TYPE_UINT32,
@@ -256,6 +304,66 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.iface.cryptography.sessions.cache),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 20480,
+		.name = "magma.iface.cryptography.sessions.cache",
+		.description = "The maximum number of TLS sessions each server will cache for resumption. Use 0 to disable the session cache.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.cryptography.sessions.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 3600,
+		.name = "magma.iface.cryptography.sessions.timeout",
+		.description = "The number of seconds a cached TLS session, or session ticket, may be resumed.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.cryptography.tickets.rotate),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 3600,
+		.name = "magma.iface.cryptography.tickets.rotate",
+		.description = "The number of seconds between TLS session ticket key rotations. Use 0 to disable session tickets, unless a ticket key file is configured, in which case this value is ignored.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.cryptography.tickets.file),
+		.norm.type = M_TYPE_NULLER,
+		.norm.val.ns = NULL,
+		.name = "magma.iface.cryptography.tickets.file",
+		.description = "A file holding the TLS session ticket keys, which allows the keys to be shared by every node in a cluster. The file should hold one or more 80 byte keys, with the first key used to issue new tickets.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.cryptography.ktls),
+		.norm.type = M_TYPE_BOOLEAN,
+		.norm.val.binary = false,
+		.name = "magma.iface.cryptography.ktls",
+		.description = "Hand the record layer of TLS 1.2 connections using AES-GCM to the kernel, once the handshake completes. Connections fall back to user space encryption if the kernel doesn't support it.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.secure.sessions),
 		.norm.type = M_TYPE_STRINGER,
@@ -364,6 +472,54 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.imap.idle.interval),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 60,
+		.name = "magma.imap.idle.interval",
+		.description = "The number of seconds between checks for changes made by other cluster nodes while an IMAP session is idle.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.imap.idle.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 1800,
+		.name = "magma.imap.idle.timeout",
+		.description = "The number of seconds an IMAP session may remain idle before the connection is closed.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.imap.compress.level),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 6,
+		.name = "magma.imap.compress.level",
+		.description = "The DEFLATE compression level, from 1 (fastest) to 9 (smallest), used by IMAP sessions which enable compression.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.imap.compress.window),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 13,
+		.name = "magma.imap.compress.window",
+		.description = "The base two logarithm of the compression window, from 9 to 15, which bounds the memory used by each compressed IMAP session.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.web.portal.indent),
 		.norm.type = M_TYPE_BOOLEAN,
@@ -664,6 +820,78 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.iface.database.replica.host),
+		.norm.type = M_TYPE_NULLER,
+		.norm.val.ns = NULL,
+		.name = "magma.iface.database.replica.host",
+		.description = "The IP or FQDN of a read replica database host. If set, read only queries will be sent to the replica when it's current.",
+		.file = true,
+		.database = false,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.database.replica.port),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 3306,
+		.name = "magma.iface.database.replica.port",
+		.description = "The port used by the read replica database server.",
+		.file = true,
+		.database = false,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.database.replica.socket_path),
+		.norm.type = M_TYPE_NULLER,
+		.norm.val.ns = NULL,
+		.name = "magma.iface.database.replica.socket_path",
+		.description = "The path of the UNIX socket to be used for local read replica sessions.",
+		.file = true,
+		.database = false,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.database.replica.connections),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4,
+		.name = "magma.iface.database.replica.connections",
+		.description = "The size of the read replica connection pool.",
+		.file = true,
+		.database = false,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.database.replica.lag),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 2,
+		.name = "magma.iface.database.replica.lag",
+		.description = "The number of seconds a read replica may fall behind the primary before reads are sent back to the primary.",
+		.file = true,
+		.database = false,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.database.replica.window),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 10,
+		.name = "magma.iface.database.replica.window",
+		.description = "The number of seconds after a user's data changes during which reads for that user are sent to the primary.",
+		.file = true,
+		.database = false,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.spool),
 		.norm.type = M_TYPE_NULLER,
@@ -700,6 +928,18 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.iface.virus.cache),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4096,
+		.name = "magma.iface.virus.cache",
+		.description = "The number of message parts the virus scanner found clean which are remembered, so they aren't scanned again. Set to zero to disable.",
+		.file = true,
+		.database = true,
+		.overwrite = false,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.system.enable_core_dumps),
 		.norm.type = M_TYPE_BOOLEAN,
@@ -832,6 +1072,78 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.smtp.inbound_cache.entries),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4096,
+		.name = "magma.smtp.inbound_cache.entries",
+		.description = "The number of recipients held by the in-process cache of inbound SMTP preferences. Use 0 to disable the cache.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.inbound_cache.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 60,
+		.name = "magma.smtp.inbound_cache.timeout",
+		.description = "The number of seconds the cached preferences of a valid recipient are trusted, provided the user and config serial numbers are unchanged.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.inbound_cache.negative),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 30,
+		.name = "magma.smtp.inbound_cache.negative",
+		.description = "The number of seconds an unknown, non-local or locked recipient address is remembered, so repeated attempts are rejected without a database query.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.counters.interval),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 5,
+		.name = "magma.smtp.counters.interval",
+		.description = "How often, in seconds, the in-memory message counters used for the daily send and receive limits are shared with the other cluster nodes and written to the database. Use 0 to query the database for every message.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.counters.idle),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 3600,
+		.name = "magma.smtp.counters.idle",
+		.description = "The number of seconds an unused message counter is held in memory.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.smtp.fanout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4,
+		.name = "magma.smtp.fanout",
+		.description = "The number of worker threads which may deliver an inbound message to its recipients in parallel. The thread which received the message always takes part, so a value of 1 delivers to each recipient in turn.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.dkim.enabled),
 		.norm.type = M_TYPE_BOOLEAN,
@@ -880,6 +1192,30 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.dkim.cache.entries),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 1024,
+		.name = "magma.dkim.cache.entries",
+		.description = "The number of DKIM public key records held in memory, so messages signed with the same key don't each require a DNS lookup. Set to zero to disable.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.dkim.cache.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 3600,
+		.name = "magma.dkim.cache.timeout",
+		.description = "The maximum number of seconds a DKIM public key record is cached. Records with a shorter TTL expire sooner.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.dime.key),
 		.norm.type = M_TYPE_STRINGER,
@@ -928,6 +1264,30 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.iface.spf.cache.entries),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4096,
+		.name = "magma.iface.spf.cache.entries",
+		.description = "The number of SPF outcomes held in memory, so repeat deliveries from the same sender aren't checked again. Set to zero to disable.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.spf.cache.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 900,
+		.name = "magma.iface.spf.cache.timeout",
+		.description = "The number of seconds an SPF outcome is cached.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.iface.cache.pool.connections),
 		.norm.type = M_TYPE_UINT32,
@@ -976,6 +1336,42 @@ magma_keys_t magma_keys[] = {
 		.set = false,
 		.required = false
 	},
+	{
+		.store = (void *)&(magma.iface.cache.near.entries),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 4096,
+		.name = "magma.iface.cache.near.entries",
+		.description = "The number of values held by the in-process cache which sits in front of the caching servers. Use 0 to disable the near cache.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.cache.near.timeout),
+		.norm.type = M_TYPE_UINT32,
+		.norm.val.u32 = 1,
+		.name = "magma.iface.cache.near.timeout",
+		.description = "The number of seconds a value held by the near cache is trusted before it must be fetched from the caching servers again.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
+	{
+		.store = (void *)&(magma.iface.cache.near.broadcast),
+		.norm.type = M_TYPE_BOOLEAN,
+		.norm.val.binary = false,
+		.name = "magma.iface.cache.near.broadcast",
+		.description = "Announce every change using a shared counter on the caching servers, so the other cluster nodes discard their near cache within a second. This allows the near cache timeout to be raised.",
+		.file = true,
+		.database = true,
+		.overwrite = true,
+		.set = false,
+		.required = false
+	},
 	{
 		.store = (void *)&(magma.relay.timeout),
 		.norm.type = M_TYPE_UINT32,
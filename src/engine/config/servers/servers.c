@@ -99,6 +99,12 @@ bool_t servers_network_start(void) {
  * @return	true on success or false on failure.
  */
 bool_t servers_encryption_start(void) {
+
+	// The session ticket keys are shared by every server, so they need to be ready before the server contexts are created.
+	if (!tls_tickets_start()) {
+		return false;
+	}
+
 	// Loop through and setup the transport security layer for all of the server instances that provided TLS certificates.
 	for (uint32_t i = 0; i < MAGMA_SERVER_INSTANCES; i++) {
 
@@ -135,6 +141,7 @@ void servers_encryption_stop(void) {
 			tls_server_destroy(magma.servers[i]);
 		}
 	}
+	tls_tickets_stop();
 	return;
 }
 
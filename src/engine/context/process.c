@@ -14,7 +14,7 @@ pthread_t *maint = NULL;
 /**
  * @brief	The entry point for the process maintenance thread, which runs in a continuous loop unless canceled.
  * @note	Execute once daily: rotate the log files, update the warehouse, and perform tank maintenance.
- * 			Execute every few (0-10) minutes: refresh the virus engine and prune the object cache.
+ * 			Execute every few (0-10) minutes: refresh the virus engine, reload a replaced DKIM key, and prune the object cache.
  * @return	This function returns no value.
  */
 void process_maint(void) {
@@ -37,6 +37,7 @@ void process_maint(void) {
 
 		// Execute these functions every few minutes.
 		virus_engine_refresh();
+		dkim_signer_refresh();
 		obj_cache_prune();
 
 		// If were close to midnight, sleep until midnight, otherwise sleep a random number of seconds up to ten minutes.
@@ -105,11 +106,16 @@ void process_stop(void) {
 
 		obj_cache_stop,
 		mail_cache_stop,
+		smtp_inbound_cache_stop,
+		smtp_counters_stop, /* Write any pending message counter updates to the database. */
+		auth_cache_stop,
+		auth_batch_stop, /* Fail any key derivation requests which are still queued. */
 		warehouse_stop,
 		http_content_stop,
 		NULL, /* Protocol handlers. */
 		servers_encryption_stop,
 		queue_shutdown, /* Shutdown the thread pool. */
+		imap_idle_stop, /* Stop the idle monitor before the thread pool, so the remaining idle sessions can be logged out. */
 		NULL /* Logging */
 	};
 
@@ -203,11 +209,16 @@ bool_t process_start(void) {
 
 		(void *)&obj_cache_start,
 		(void *)&mail_cache_start,
+		(void *)&smtp_inbound_cache_start,
+		(void *)&smtp_counters_start,
+		(void *)&auth_cache_start,
+		(void *)&auth_batch_start,
 		(void *)&warehouse_start,
 		(void *)&http_content_start,
 		(void *)&protocol_init,
 		(void *)&servers_encryption_start,
 		(void *)&queue_init,
+		(void *)&imap_idle_start,
 		(void *)&log_start
 	};
 
@@ -250,11 +261,16 @@ bool_t process_start(void) {
 
 		"Unable to initialize the local object cache. Exiting.",
 		"Unable to initialize the thread local mail cache. Exiting.",
+		"Unable to initialize the inbound recipient cache. Exiting.",
+		"Unable to initialize the message counters. Exiting.",
+		"Unable to initialize the verified credentials cache. Exiting.",
+		"Unable to initialize the batched key derivation threads. Exiting.",
 		"Unable to initialize the data warehouse engine. Exiting.",
 		"Unable to initialize the web content cache. Exiting.",
 		"Unable to initialize the protocol handlers. Exiting.",
 		"Unable to initialize the server encryption context. Exiting.",
 		"Unable to initialize the thread pool. Exiting.",
+		"Unable to initialize the IMAP idle monitor. Exiting.",
 		"Initialization of the log configuration failed. Exiting."
 	};
 
@@ -10,11 +10,11 @@
 
 /// queue.c
 void     dequeue(void);
-void     enqueue(void *function, void *data);
+bool_t   enqueue(void *function, void *data);
 bool_t   queue_init(void);
 void     queue_shutdown(void);
 void     queue_signal(void);
-void     requeue(void *function, void *requeue, void *data);
+bool_t   requeue(void *function, void *requeue, void *data);
 
 /// protocol.c
 bool_t protocol_init(void);
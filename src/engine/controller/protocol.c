@@ -187,6 +187,7 @@ void protocol_secure(connection_t *con) {
 		return;
 	}
 
+	con_offload(con);
 	protocol_enqueue(con);
 	return;
 }
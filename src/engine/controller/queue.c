@@ -28,15 +28,15 @@ struct {
  * @param	function	a pointer to a function to be executed by the next available worker thread.
  * @param	requeue		an optional pointer to a requeue function to be called after function is executed.
  * @param	data		a pointer to an arbitrary block of data to be passed to function and/or requeue upon execution.
- * @return	This function returns no value.
+ * @return	true if the work unit was queued, or false if it was lost.
  */
-void requeue(void *function, void *requeue, void *data) {
+bool_t requeue(void *function, void *requeue, void *data) {
 
 	queue_t *local, *work;
 
 	if (!(work = mm_alloc(sizeof(queue_t)))) {
 		log_critical("Failed to allocate a queue_t structure. Work request is lost forever!");
-		return;
+		return false;
 	}
 
 	work->function = function;
@@ -56,7 +56,7 @@ void requeue(void *function, void *requeue, void *data) {
 	mutex_unlock(&queue.lock);
 	sem_post(&queue.sema);
 
-	return;
+	return true;
 }
 
 /**
@@ -64,11 +64,10 @@ void requeue(void *function, void *requeue, void *data) {
  * @note	Warning: If this function fails to allocate a new queue_t object, the work unit is lost forever.
  * @param	function	a pointer to a function to be executed by the next available worker thread.
  * @param	data		a pointer to an arbitrary block of data to be passed to the specified function on execution.
- * @return	This function returns no value.
+ * @return	true if the work unit was queued, or false if it was lost.
  */
-void enqueue(void *function, void *data) {
-	requeue(function, NULL, data);
-	return;
+bool_t enqueue(void *function, void *data) {
+	return requeue(function, NULL, data);
 }
 
 /**
@@ -23,6 +23,14 @@ struct {
 			// SMTP Statistics
 			"smtp.connections.total",
 			"smtp.connections.secure",
+			"smtp.inbound.cache.hits",
+			"smtp.inbound.cache.misses",
+			"smtp.inbound.cache.rejected",
+			"smtp.counters.flushes",
+			"smtp.counters.rows",
+			"smtp.counters.errors",
+			"smtp.fanout.messages",
+			"smtp.fanout.helpers",
 
 			// DMTP Statistics
 			"dmtp.connections.total",
@@ -35,6 +43,19 @@ struct {
 			// IMAP Statistics
 			"imap.connections.total",
 			"imap.connections.secure",
+			"imap.idle.sessions",
+			"imap.idle.notified",
+
+			// Network Statistics
+			"network.deflate.streams",
+			"network.deflate.input.raw",
+			"network.deflate.input.compressed",
+			"network.deflate.output.raw",
+			"network.deflate.output.compressed",
+			"network.arena.commands",
+			"network.arena.allocations",
+			"network.arena.bytes",
+			"network.arena.heap",
 
 			// POP Statistics
 			"pop.connections.total",
@@ -53,6 +74,9 @@ struct {
 			"provider.virus.scan.phishing",
 			"provider.virus.signatures.total",
 			"provider.virus.signatures.loaded",
+			"provider.virus.cache.hits",
+			"provider.virus.cache.misses",
+			"provider.virus.cache.flushes",
 
 			"provider.spf.checked",
 			"provider.spf.missing",
@@ -60,6 +84,8 @@ struct {
 			"provider.spf.error",
 			"provider.spf.fail",
 			"provider.spf.pass",
+			"provider.spf.cache.hits",
+			"provider.spf.cache.misses",
 
 			"provider.dkim.signed",
 			"provider.dkim.checked",
@@ -68,12 +94,34 @@ struct {
 			"provider.dkim.error",
 			"provider.dkim.fail",
 			"provider.dkim.pass",
+			"provider.dkim.cache.hits",
+			"provider.dkim.cache.misses",
+			"provider.tls.kernel.fallback",
+			"provider.tls.kernel.offloaded",
+			"provider.tls.sessions.full",
+			"provider.tls.sessions.resumed",
+			"provider.tls.tickets.rotated",
+			"provider.cache.near.hits",
+			"provider.cache.near.misses",
+			"provider.cache.near.flushes",
+			"provider.cache.multi.requests",
+			"provider.cache.multi.keys",
+			"provider.database.replica.reads",
+			"provider.database.replica.primary",
+			"provider.database.replica.failovers",
 
 			// Objects
 			"objects.meta.total",
 			"objects.meta.expired",
+			"objects.meta.latency",
 			"objects.sessions.total",
 			"objects.sessions.expired",
+			"objects.sessions.latency",
+			"objects.auth.cache.hits",
+			"objects.auth.cache.misses",
+			"objects.auth.batch.jobs",
+			"objects.auth.batch.runs",
+			"objects.mail.reclaim.pending",
 
 			// Patterns
 			"objects.patterns.checked",
@@ -126,7 +174,21 @@ char *derived[] = {
 
 	// Error Statistics
 	"core.spool.errors",
-	"errors.total"
+	"errors.total",
+
+	// Network Statistics
+	"network.deflate.ratio",
+
+	// Secure Memory Statistics
+	"system.secure.fragmentation",
+	"system.secure.classes.slots",
+	"system.secure.classes.reserved",
+
+	// Pool Statistics
+	"system.pools.sql.waited",
+	"system.pools.sql.slow",
+	"system.pools.cache.waited",
+	"system.pools.cache.slow"
 };
 
 /**
@@ -208,7 +270,7 @@ char * stats_derived_name(uint64_t position) {
 uint64_t stats_derived_value(uint64_t position) {
 
 	uint64_t result = 0;
-	size_t total, bytes, items;
+	size_t total, bytes, items, available, largest, slots, reserved;
 
 	switch (position) {
 
@@ -233,6 +295,40 @@ uint64_t stats_derived_value(uint64_t position) {
 		result = stats_sum_errors();
 		break;
 
+	// The size of the compressed output as a percentage of the uncompressed output.
+	case (5):
+		if ((total = stats_get_value_by_name("network.deflate.output.raw"))) {
+			result = (stats_get_value_by_name("network.deflate.output.compressed") * 100) / total;
+		}
+		break;
+
+	// The percentage of free heap memory which isn't part of the largest free chunk.
+	case (6):
+		if (mm_sec_usage(&available, &largest, &slots, &reserved) && available) {
+			result = 100 - ((largest * 100) / available);
+		}
+		break;
+	case (7):
+		if (mm_sec_usage(&available, &largest, &slots, &reserved)) result = slots;
+		break;
+	case (8):
+		if (mm_sec_usage(&available, &largest, &slots, &reserved)) result = reserved;
+		break;
+
+	// The number of pool requests which had to wait for an object, and the number which waited for at least 10 milliseconds.
+	case (9):
+		for (uint32_t i = 1; i < MAGMA_CORE_POOL_WAIT_BUCKETS; i++) result += pool_get_waits(sql_pool, i);
+		break;
+	case (10):
+		for (uint32_t i = 5; i < MAGMA_CORE_POOL_WAIT_BUCKETS; i++) result += pool_get_waits(sql_pool, i);
+		break;
+	case (11):
+		for (uint32_t i = 1; i < MAGMA_CORE_POOL_WAIT_BUCKETS; i++) result += pool_get_waits(cache_pool, i);
+		break;
+	case (12):
+		for (uint32_t i = 5; i < MAGMA_CORE_POOL_WAIT_BUCKETS; i++) result += pool_get_waits(cache_pool, i);
+		break;
+
 	default:
 		log_pedantic("We don't know how to calculate the derived value requested! {position = %lu}", position);
 		break;
@@ -372,6 +468,28 @@ void stats_adjust_by_name(char *name, int32_t value) {
 	return;
 }
 
+/**
+ * @brief	Provided a statistic by name, increase its value by an unsigned 64 bit amount.
+ * @note	Use this instead of stats_adjust_by_name() for byte counters, which can easily exceed the range of a signed 32 bit integer.
+ * @param	name	a null-terminated string containing the name of the statistic to be increased.
+ * @param	value	the amount by which to increase the specified statistic.
+ * @return	This function returns no value.
+ */
+void stats_add_by_name(char *name, uint64_t value) {
+
+	uint64_t position;
+
+	if (!value || !(position = stats_get_name_pos(name))) {
+		return;
+	}
+
+	mutex_lock(&stats.locks[position][1]);
+	stats.values[position] += value;
+	mutex_unlock(&stats.locks[position][1]);
+
+	return;
+}
+
 /**
  * @brief	Provided a statistic by index, increment its value by a specified amount.
  * @param	position	the zero-based index of the statistic to be set.
@@ -9,6 +9,7 @@
 #define MAGMA_ENGINE_STATUS_H
 
 /// statistics.c
+void       stats_add_by_name(char *name, uint64_t value);
 void       stats_adjust_by_name(char *name, int32_t value);
 void       stats_adjust_by_num(uint64_t position, int32_t value);
 void       stats_decrement_by_name(char *name);
@@ -65,8 +65,9 @@ int_t con_status(connection_t *con) {
 
 	int_t result = -1;
 
-	// If the status is positive, and tls_status returns 0, we use the existing status state.
-	if (con && con->network.tls && con->network.status >= 0 && !tls_status(con->network.tls)) {
+	// If the status is positive, and tls_status returns 0, we use the existing status state. Once the kernel is handling incoming
+	// records, OpenSSL never sees the socket again, so its status is meaningless.
+	if (con && con->network.tls && !(con->network.ktls & KTLS_RX) && con->network.status >= 0 && !tls_status(con->network.tls)) {
 		result = con->network.status;
 	}
 	// If the status is positive, and tcp_status returns 0, we use the existing status state.
@@ -81,6 +82,73 @@ int_t con_status(connection_t *con) {
 	return result;
 }
 
+/**
+ * @brief	Get the arena used for a connection's per-command temporaries, creating it if necessary.
+ * @param	con		the client connection.
+ * @return	NULL on failure, or a pointer to the connection's arena on success.
+ */
+mm_arena_t * con_arena(connection_t *con) {
+
+	if (con && !con->arena && !(con->arena = mm_arena_create(CON_ARENA_BLOCK_LENGTH))) {
+		log_pedantic("Unable to create the connection arena.");
+	}
+
+	return con ? con->arena : NULL;
+}
+
+/**
+ * @brief	Reclaim the temporaries allocated while processing the previous command.
+ * @note	This function must be called before a new command is parsed, since the parsed arguments are allocated from the arena and
+ * 			remain in use until the command has finished executing. The arena counters are added to the statistics before being reset.
+ * @param	con		the client connection.
+ * @return	This function returns no value.
+ */
+void con_arena_reset(connection_t *con) {
+
+	if (!con || !con->arena || !con->arena->counts.allocations) {
+		return;
+	}
+
+	stats_increment_by_name("network.arena.commands");
+	stats_adjust_by_name("network.arena.allocations", con->arena->counts.allocations);
+	stats_adjust_by_name("network.arena.bytes", con->arena->counts.bytes);
+	stats_adjust_by_name("network.arena.heap", con->arena->counts.heap);
+
+	mm_arena_reset(con->arena);
+	return;
+}
+
+/**
+ * @brief	Execute the current protocol command with the connection arena attached to the worker thread.
+ * @param	con		the client connection with the command to be executed.
+ * @return	This function returns no value.
+ */
+void con_command(connection_t *con) {
+
+	mm_arena_t *previous = mm_arena_attach(con_arena(con));
+
+	((void (*)(connection_t *))con->command->function)(con);
+
+	mm_arena_attach(previous);
+	return;
+}
+
+/**
+ * @brief	Hand the record layer of a TLS connection to the kernel, if enabled.
+ * @note	This function must be called immediately after the TLS handshake completes, before any application data is exchanged.
+ * 			If the connection can't be offloaded, it continues to use OpenSSL.
+ * @param	con		the client connection which just completed a TLS handshake.
+ * @return	This function returns no value.
+ */
+void con_offload(connection_t *con) {
+
+	if (con && con->network.tls && !con->network.ktls && magma.iface.cryptography.ktls) {
+		con->network.ktls = ktls_enable(con->network.tls, con->network.sockd);
+	}
+
+	return;
+}
+
 /**
  * @brief Attempt to flush any buffered data associated with a network connection.
  * @param con the input client connection.
@@ -167,6 +235,17 @@ void con_destroy(connection_t *con) {
 				break;
 		}
 
+		// Release the stream filters before the transport layer is torn down.
+		con_filter_cleanup(con);
+
+		// The session may reference arena memory, so the arena is only released after the session has been destroyed.
+		con_arena_reset(con);
+		mm_arena_destroy(con->arena);
+
+		if (con->network.tls && con->network.ktls) {
+			ktls_close(con->network.tls, con->network.sockd, con->network.ktls);
+		}
+
 		if (con->network.tls) {
 			tls_free(con->network.tls);
 		}
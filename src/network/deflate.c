@@ -0,0 +1,238 @@
+
+/**
+ * @file /magma/network/deflate.c
+ *
+ * @brief	A stream filter which compresses the data flowing across a connection using the raw DEFLATE format (RFC 1951), as
+ * 			required by the IMAP COMPRESS extension (RFC 4978).
+ *
+ * @note	The amount of memory used by each connection is bounded by the window size, which controls the size of the compression
+ * 			history and hash table, plus the fixed size input and output buffers. The decompressor always uses a full 32KB window, since
+ * 			we can't control how the client compresses its data.
+ */
+
+#include "magma.h"
+
+// The size of the buffers used to hold compressed data on its way to, and from, the layer below.
+#define CON_DEFLATE_BUFFER_SIZE 8192
+
+// How much uncompressed output is accumulated before the statistics are updated.
+#define CON_DEFLATE_STATS_INTERVAL 1048576
+
+typedef struct {
+	con_filter_t filter;
+	z_stream deflate, inflate;
+	bool_t pending; /* Set if the last inflate call filled the output buffer, and may still be holding data. */
+	struct {
+		uint64_t raw, compressed;
+	} input, output; /* The number of bytes processed since the statistics were last updated. */
+	uchr_t incoming[CON_DEFLATE_BUFFER_SIZE], outgoing[CON_DEFLATE_BUFFER_SIZE];
+} con_deflate_t;
+
+/**
+ * @brief	Add the byte counts accumulated by a compression filter to the global statistics.
+ * @param	filter	the compression filter.
+ * @return	This function returns no value.
+ */
+void con_deflate_stats(con_filter_t *filter) {
+
+	con_deflate_t *deflate = filter->context;
+
+	stats_add_by_name("network.deflate.input.raw", deflate->input.raw);
+	stats_add_by_name("network.deflate.input.compressed", deflate->input.compressed);
+	stats_add_by_name("network.deflate.output.raw", deflate->output.raw);
+	stats_add_by_name("network.deflate.output.compressed", deflate->output.compressed);
+
+	deflate->input.raw = deflate->input.compressed = deflate->output.raw = deflate->output.compressed = 0;
+
+	return;
+}
+
+/**
+ * @brief	Read compressed data from the layer below and decompress it into the buffer provided.
+ * @return	-1 on error, 0 if no data was available, or the number of decompressed bytes stored in the buffer.
+ */
+int64_t con_deflate_read(connection_t *con, con_filter_t *filter, void *buffer, size_t length, bool_t block) {
+
+	int_t ret;
+	int64_t bytes;
+	size_t produced;
+	con_deflate_t *deflate = filter->context;
+
+	deflate->inflate.next_out = buffer;
+	deflate->inflate.avail_out = length;
+
+	do {
+
+		// Only go back to the network if the decompressor has consumed everything we gave it, and isn't holding any output.
+		if (!deflate->inflate.avail_in && !deflate->pending) {
+
+			if ((bytes = con_filter_read(con, filter->next, deflate->incoming, CON_DEFLATE_BUFFER_SIZE, block)) <= 0) {
+				return bytes;
+			}
+
+			deflate->inflate.next_in = deflate->incoming;
+			deflate->inflate.avail_in = bytes;
+			deflate->input.compressed += bytes;
+		}
+
+		// A Z_BUF_ERROR only indicates that no progress was possible, which is expected when the pending flag was set unnecessarily.
+		if ((ret = inflate_d(&(deflate->inflate), Z_SYNC_FLUSH)) != Z_OK && ret != Z_BUF_ERROR) {
+			log_pedantic("Unable to decompress the incoming network data. { inflate = %i / message = %s }", ret,
+				deflate->inflate.msg ? deflate->inflate.msg : "none");
+			return -1;
+		}
+
+		deflate->pending = (deflate->inflate.avail_out == 0);
+		produced = length - deflate->inflate.avail_out;
+
+	} while (!produced && status());
+
+	deflate->input.raw += produced;
+
+	return produced;
+}
+
+/**
+ * @brief	Compress the buffer provided and write the result to the layer below.
+ * @note	The compressor is flushed after every write, so the client receives complete protocol responses without waiting for more data.
+ * @return	-1 on error, or the number of uncompressed bytes consumed.
+ */
+int64_t con_deflate_write(connection_t *con, con_filter_t *filter, void *buffer, size_t length) {
+
+	int_t ret, counter;
+	int64_t bytes;
+	size_t produced, position;
+	con_deflate_t *deflate = filter->context;
+
+	deflate->deflate.next_in = buffer;
+	deflate->deflate.avail_in = length;
+
+	do {
+
+		deflate->deflate.next_out = deflate->outgoing;
+		deflate->deflate.avail_out = CON_DEFLATE_BUFFER_SIZE;
+
+		if ((ret = deflate_d(&(deflate->deflate), Z_SYNC_FLUSH)) != Z_OK && ret != Z_BUF_ERROR) {
+			log_pedantic("Unable to compress the outgoing network data. { deflate = %i }", ret);
+			return -1;
+		}
+
+		produced = CON_DEFLATE_BUFFER_SIZE - deflate->deflate.avail_out;
+		position = counter = 0;
+
+		// The compressed data must be written out completely, because the next block won't make sense without it.
+		while (position < produced && counter++ < 128 && status()) {
+
+			if ((bytes = con_filter_write(con, filter->next, deflate->outgoing + position, produced - position)) < 0) {
+				return -1;
+			}
+			else if (bytes == 0) {
+				usleep(1000);
+			}
+			else {
+				position += bytes;
+				counter = 0;
+			}
+		}
+
+		if (position != produced) {
+			return -1;
+		}
+
+		deflate->output.compressed += produced;
+
+	} while (!deflate->deflate.avail_out);
+
+	deflate->output.raw += length;
+
+	if (deflate->output.raw + deflate->input.raw > CON_DEFLATE_STATS_INTERVAL) {
+		con_deflate_stats(filter);
+	}
+
+	return length;
+}
+
+/**
+ * @brief	Determine how much data the compression filter can return without reading from the network.
+ * @return	the number of compressed bytes waiting to be decompressed, plus one if the decompressor may be holding output.
+ */
+size_t con_deflate_pending(con_filter_t *filter) {
+
+	con_deflate_t *deflate = filter->context;
+
+	return deflate->inflate.avail_in + (deflate->pending ? 1 : 0);
+}
+
+/**
+ * @brief	Release the compression streams and the filter.
+ * @return	This function returns no value.
+ */
+void con_deflate_free(con_filter_t *filter) {
+
+	con_deflate_t *deflate = filter->context;
+
+	deflateEnd_d(&(deflate->deflate));
+	inflateEnd_d(&(deflate->inflate));
+
+	con_deflate_stats(filter);
+	stats_decrement_by_name("network.deflate.streams");
+
+	mm_free(deflate);
+	return;
+}
+
+/**
+ * @brief	Start compressing the data sent and received over a connection.
+ * @note	Any data written after this function returns will be compressed, so the caller must send any response announcing
+ * 			that compression is active before calling this function.
+ * @param	con		the connection which should be compressed.
+ * @param	level	the compression level, from 1 (fastest) to 9 (smallest).
+ * @param	window	the base two logarithm of the compression window size, from 9 to 15, which bounds the memory used by the compressor.
+ * @return	true on success, or false on failure.
+ */
+bool_t con_deflate_start(connection_t *con, int_t level, int_t window) {
+
+	int_t ret;
+	con_deflate_t *deflate;
+
+	if (!con || level < 1 || level > 9 || window < 9 || window > 15) {
+		log_pedantic("Invalid parameters were passed to the connection compression filter.");
+		return false;
+	}
+	else if (!(deflate = mm_alloc(sizeof(con_deflate_t)))) {
+		log_pedantic("Unable to allocate memory for the connection compression filter.");
+		return false;
+	}
+
+	// Negative window sizes tell zlib to use the raw DEFLATE format, without a header or trailer. The memory level is scaled
+	// with the window size, so a smaller window also shrinks the hash table.
+	if ((ret = deflateInit2__d(&(deflate->deflate), level, Z_DEFLATED, -window, window - 7, Z_DEFAULT_STRATEGY, ZLIB_VERSION, sizeof(z_stream))) != Z_OK) {
+		log_pedantic("Unable to initialize the compression stream. { deflateInit2 = %i }", ret);
+		mm_free(deflate);
+		return false;
+	}
+	else if ((ret = inflateInit2__d(&(deflate->inflate), -15, ZLIB_VERSION, sizeof(z_stream))) != Z_OK) {
+		log_pedantic("Unable to initialize the decompression stream. { inflateInit2 = %i }", ret);
+		deflateEnd_d(&(deflate->deflate));
+		mm_free(deflate);
+		return false;
+	}
+
+	deflate->filter.name = "deflate";
+	deflate->filter.context = deflate;
+	deflate->filter.read = &con_deflate_read;
+	deflate->filter.write = &con_deflate_write;
+	deflate->filter.pending = &con_deflate_pending;
+	deflate->filter.free = &con_deflate_free;
+
+	if (!con_filter_push(con, &(deflate->filter))) {
+		deflateEnd_d(&(deflate->deflate));
+		inflateEnd_d(&(deflate->inflate));
+		mm_free(deflate);
+		return false;
+	}
+
+	stats_increment_by_name("network.deflate.streams");
+
+	return true;
+}
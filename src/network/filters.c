@@ -0,0 +1,117 @@
+
+/**
+ * @file /magma/network/filters.c
+ *
+ * @brief	Functions used to manage the stack of stream filters which sit between the protocol handlers and the transport layer.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Push a stream filter onto the top of a connection's filter stack.
+ * @note	Once pushed, the connection owns the filter, and will release it using the filter's free callback when the connection is destroyed.
+ * 			Any data already sitting in the connection buffer was received before the filter was applied, and is left as is.
+ * @param	con		the connection which the filter should be applied to.
+ * @param	filter	the filter being added to the connection.
+ * @return	true on success, or false on failure.
+ */
+bool_t con_filter_push(connection_t *con, con_filter_t *filter) {
+
+	if (!con || !filter || !filter->read || !filter->write || !filter->free) {
+		log_pedantic("Invalid parameters were passed to the connection filter stack.");
+		return false;
+	}
+
+	filter->next = con->network.filters;
+	con->network.filters = filter;
+
+	return true;
+}
+
+/**
+ * @brief	Release all of the stream filters applied to a connection.
+ * @param	con		the connection whose filters should be released.
+ * @return	This function returns no value.
+ */
+void con_filter_cleanup(connection_t *con) {
+
+	con_filter_t *filter;
+
+	if (!con) {
+		return;
+	}
+
+	while ((filter = con->network.filters)) {
+		con->network.filters = filter->next;
+		filter->free(filter);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Determine how much data the stream filters are holding which can be read without waiting on the network.
+ * @param	con		the connection whose filters should be checked.
+ * @return	the number of bytes pending inside the filter stack, or 0 if the connection has no filters.
+ */
+size_t con_filter_pending(connection_t *con) {
+
+	size_t result = 0;
+
+	if (!con) {
+		return 0;
+	}
+
+	for (con_filter_t *filter = con->network.filters; filter; filter = filter->next) {
+		if (filter->pending) result += filter->pending(filter);
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Read data through a connection's filter stack.
+ * @note	Filters use this function to read from the layer below them. If no filter is provided, the data is read directly from the
+ * 			transport layer, regardless of whether or not the connection is TLS enabled. If the kernel is handling the record layer,
+ * 			the socket is read directly.
+ * @param	con		the connection from which the data will be read.
+ * @param	filter	the filter to read from, or NULL to read from the transport layer.
+ * @param	buffer	a pointer to the buffer where the data will be stored.
+ * @param	length	the maximum number of bytes to read.
+ * @param	block	a boolean indicating whether the read operation should block.
+ * @return	-1 on error, 0 if no data was available, or the number of bytes read into the buffer.
+ */
+int64_t con_filter_read(connection_t *con, con_filter_t *filter, void *buffer, size_t length, bool_t block) {
+
+	if (filter) {
+		return filter->read(con, filter, buffer, length, block);
+	}
+	else if (con->network.tls && !(con->network.ktls & KTLS_RX)) {
+		return tls_read(con->network.tls, buffer, length, block);
+	}
+
+	return tcp_read(con->network.sockd, buffer, length, block);
+}
+
+/**
+ * @brief	Write data through a connection's filter stack.
+ * @note	Filters use this function to write to the layer below them. If no filter is provided, the data is written directly to the
+ * 			transport layer, regardless of whether or not the connection is TLS enabled. If the kernel is handling the record layer,
+ * 			the socket is written directly.
+ * @param	con		the connection across which the data will be written.
+ * @param	filter	the filter to write to, or NULL to write to the transport layer.
+ * @param	buffer	a pointer to the data being written.
+ * @param	length	the number of bytes to write.
+ * @return	-1 on error, or the number of bytes consumed, which may be less than the requested length.
+ */
+int64_t con_filter_write(connection_t *con, con_filter_t *filter, void *buffer, size_t length) {
+
+	if (filter) {
+		return filter->write(con, filter, buffer, length);
+	}
+	else if (con->network.tls && !(con->network.ktls & KTLS_TX)) {
+		return tls_write(con->network.tls, buffer, length, true);
+	}
+
+	return tcp_write(con->network.sockd, buffer, length, true);
+}
@@ -12,11 +12,12 @@ typedef array_t imap_arguments_t;
 
 // A structure containing the folder status information.
 typedef struct {
-	uint64_t foldernum, recent, unseen, uidnext, messages, first;
+	uint64_t foldernum, recent, unseen, uidnext, messages, first, highestmodseq;
 } imap_folder_status_t;
 
 typedef struct {
-	int_t uid, flags, internaldate, envelope, bodystructure, rfc822, rfc822_header, rfc822_size, rfc822_text, body;
+	int_t uid, flags, internaldate, envelope, bodystructure, rfc822, rfc822_header, rfc822_size, rfc822_text, body, modseq, vanished;
+	uint64_t changedsince;
 	array_t *peek, *peek_partial, *normal, *normal_partial;
 } imap_fetch_dataitems_t;
 
@@ -29,7 +30,7 @@ typedef struct __attribute__ ((packed)) {
 	meta_user_t *user;
 	imap_arguments_t *arguments;
 	stringer_t *tag, *command, *username;
-	int_t read_only, uid, session_state;
+	int_t read_only, uid, session_state, condstore, qresync, compressed;
 	uint64_t usernum, selected, user_checkpoint, messages_checkpoint, folders_checkpoint, messages_recent, messages_total;
 } imap_session_t;
 
@@ -82,7 +82,7 @@ typedef struct __attribute__ ((packed)) {
 	array_t *tags;
 	chr_t server[33];
 	uint32_t status, updated;
-	uint64_t messagenum, foldernum, sequencenum, signum, sigkey, created;
+	uint64_t messagenum, foldernum, sequencenum, signum, sigkey, created, modseq;
 } meta_message_t;
 
 typedef struct __attribute__ ((packed)) {
@@ -91,6 +91,14 @@ typedef struct __attribute__ ((packed)) {
 	uint64_t parent, foldernum;
 } meta_folder_t;
 
+// Links a cached user or session object into the queue of idle objects, in the order they became idle, so they can be expired.
+typedef struct object_idle_t {
+	bool_t linked; /* Whether the object is currently queued. */
+	uint64_t key; /* The key used to locate the object in the cache. */
+	void *object;
+	struct object_idle_t *prev, *next;
+} object_idle_t;
+
 // All of a user's information is stored using this structure.
 typedef struct __attribute__ ((packed)) {
 
@@ -100,6 +108,9 @@ typedef struct __attribute__ ((packed)) {
 	stringer_t *username, *verification;
 	inx_t *aliases, *messages, *message_folders, *folders, *contacts;
 
+	// The highest modification sequence assigned to the user's messages, as of the last refresh.
+	uint64_t modseq;
+
 	// The symmetric realm keys.
 	struct __attribute__ ((packed)) {
 		stringer_t *mail;
@@ -121,6 +132,9 @@ typedef struct __attribute__ ((packed)) {
 		pthread_mutex_t lock;
 	} refs;
 
+	// Queued while the object is unused, and protected by the idle queue lock.
+	object_idle_t idle;
+
 } meta_user_t;
 
 #endif
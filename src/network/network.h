@@ -23,6 +23,9 @@ enum {
 	REVERSE_COMPLETE = 2
 };
 
+// The length of the blocks requested from the heap by a connection arena.
+#define CON_ARENA_BLOCK_LENGTH 4096
+
 typedef struct __attribute__ ((packed)) {
 	char *string;
 	size_t length;
@@ -56,10 +59,12 @@ typedef struct __attribute__ ((packed)) {
 
 	struct __attribute__ ((packed)) {
 		void *tls; /* The TLS connection object. */
+		int ktls; /* The directions, if any, whose record layer has been offloaded to the kernel. */
 		int sockd; /* The socket connection. */
 		int status; /* Track whether the last network operation generated an error. */
 		placer_t line; /* The current line being processed. */
 		stringer_t *buffer; /* The connection buffer. */
+		struct con_filter_t *filters; /* The stream filters applied to the data, between the protocol and transport layers. */
 
 		struct __attribute__ ((packed)) {
 			ip_t *ip;
@@ -72,8 +77,21 @@ typedef struct __attribute__ ((packed)) {
 	pthread_mutex_t lock; /* The mutex used for locking during non-thread save operations. */
 	server_t *server; /* The server instance that accepted the connection. */
 	command_t *command; /* The command structure. */
+	mm_arena_t *arena; /* The arena holding temporaries allocated while processing the current command. */
 } connection_t;
 
+// A stream filter transforms the data passing through a connection. Filters are stacked, with the most recently pushed filter sitting
+// closest to the protocol layer, and each filter reads from, and writes to, the filter below it using con_filter_read() and con_filter_write().
+typedef struct con_filter_t {
+	chr_t *name; /* The name of the filter, used for logging. */
+	void *context; /* The filter specific state information. */
+	struct con_filter_t *next; /* The filter below this one, or NULL if the filter sits on top of the transport layer. */
+	int64_t (*read)(connection_t *con, struct con_filter_t *filter, void *buffer, size_t length, bool_t block); /* Fill the buffer with filtered data. */
+	int64_t (*write)(connection_t *con, struct con_filter_t *filter, void *buffer, size_t length); /* Filter the buffer and write out the result. */
+	size_t (*pending)(struct con_filter_t *filter); /* The amount of data buffered by the filter that can be read without touching the network. */
+	void (*free)(struct con_filter_t *filter); /* Release the filter context and the filter itself. */
+} con_filter_t;
+
 /// addresses.c
 ip_t *        con_addr(connection_t *con, ip_t *output);
 octet_t       con_addr_octet(connection_t *con, int_t position);
@@ -85,6 +103,9 @@ stringer_t *  con_addr_subnet(connection_t *con, stringer_t *output);
 uint32_t      con_addr_word(connection_t *con, int_t position);
 
 /// connections.c
+mm_arena_t *    con_arena(connection_t *con);
+void            con_arena_reset(connection_t *con);
+void            con_command(connection_t *con);
 uint64_t        con_decrement_refs(connection_t *con);
 void            con_destroy(connection_t *con);
 void            con_flush(connection_t *con);
@@ -92,10 +113,26 @@ uint64_t        con_increment_refs(connection_t *con);
 connection_t *  con_init(int cond, server_t *server);
 bool_t          con_init_network_buffer(connection_t *con);
 bool_t          con_localhost(connection_t *con);
+void            con_offload(connection_t *con);
 bool_t          con_private(connection_t *con);
 int_t           con_secure(connection_t *con);
 int_t           con_status(connection_t *con);
 
+/// deflate.c
+void      con_deflate_free(con_filter_t *filter);
+size_t    con_deflate_pending(con_filter_t *filter);
+int64_t   con_deflate_read(connection_t *con, con_filter_t *filter, void *buffer, size_t length, bool_t block);
+bool_t    con_deflate_start(connection_t *con, int_t level, int_t window);
+void      con_deflate_stats(con_filter_t *filter);
+int64_t   con_deflate_write(connection_t *con, con_filter_t *filter, void *buffer, size_t length);
+
+/// filters.c
+void      con_filter_cleanup(connection_t *con);
+size_t    con_filter_pending(connection_t *con);
+bool_t    con_filter_push(connection_t *con, con_filter_t *filter);
+int64_t   con_filter_read(connection_t *con, con_filter_t *filter, void *buffer, size_t length, bool_t block);
+int64_t   con_filter_write(connection_t *con, con_filter_t *filter, void *buffer, size_t length);
+
 /// clients.c
 void        client_close(client_t *client);
 client_t *  client_connect(chr_t *host, uint32_t port);
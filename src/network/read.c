@@ -9,7 +9,7 @@
 
 /**
  * @brief	Read a line of input from a network connection.
- * @note	This function handles reading data from both regular and ssl connections.
+ * @note	This function handles reading data from both regular and ssl connections, and passes the data through any stream filters.
  * 			This function continually attempts to read incoming data from the specified connection until a \n terminated line of input is received.
  * 			If a new line is read, the length of that line is returned to the caller, including the trailing \n.
  * 			If the read returns -1 and wasn't caused by a syscall interruption or blocking error, -1 is returned, and the connection status is set to -1.
@@ -63,14 +63,9 @@ int64_t con_read_line(connection_t *con, bool_t block) {
 //		blocking = st_length_get(con->network.buffer) ? false : true;
 		block = true;
 
-		if (con->network.tls) {
-			bytes = tls_read(con->network.tls, st_char_get(con->network.buffer) + st_length_get(con->network.buffer),
-				st_avail_get(con->network.buffer) - st_length_get(con->network.buffer), block);
-		}
-		else {
-			bytes = tcp_read(con->network.sockd, st_char_get(con->network.buffer) + st_length_get(con->network.buffer),
-				st_avail_get(con->network.buffer) - st_length_get(con->network.buffer), block);
-		}
+		// Read through the stream filters, which will fall through to the TLS or TCP transport layer directly if there aren't any.
+		bytes = con_filter_read(con, con->network.filters, st_char_get(con->network.buffer) + st_length_get(con->network.buffer),
+			st_avail_get(con->network.buffer) - st_length_get(con->network.buffer), block);
 
 		// We actually read in data, so we need to update the buffer to reflect the amount of unprocessed data it currently holds.
 		if (bytes > 0) {
@@ -151,14 +146,9 @@ int64_t con_read(connection_t *con) {
 //		blocking = st_length_get(con->network.buffer) ? false : true;
 		blocking = true;
 
-		if (con->network.tls) {
-			bytes = tls_read(con->network.tls, st_char_get(con->network.buffer) + st_length_get(con->network.buffer),
-				st_avail_get(con->network.buffer) - st_length_get(con->network.buffer), blocking);
-		}
-		else {
-			bytes = tcp_read(con->network.sockd, st_char_get(con->network.buffer) + st_length_get(con->network.buffer),
-				st_avail_get(con->network.buffer) - st_length_get(con->network.buffer), blocking);
-		}
+		// Read through the stream filters, which will fall through to the TLS or TCP transport layer directly if there aren't any.
+		bytes = con_filter_read(con, con->network.filters, st_char_get(con->network.buffer) + st_length_get(con->network.buffer),
+			st_avail_get(con->network.buffer) - st_length_get(con->network.buffer), blocking);
 
 		// We actually read in data, so we need to update the buffer to reflect the amount of unprocessed data it currently holds.
 		if (bytes > 0) {
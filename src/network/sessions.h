@@ -57,6 +57,9 @@ typedef struct __attribute__ ((packed)) {
 		uint64_t web;
 	} refs;
 
+	// Queued while the session is unused, and protected by the idle queue lock.
+	object_idle_t idle;
+
 	struct __attribute__ ((packed)) {
 		time_t stamp;
 		bool_t trigger;
@@ -92,6 +92,68 @@ typedef struct {
 	struct smtp_inbound_prefs_t *next;
 } smtp_inbound_prefs_t;
 
+// A slot in the process wide cache of inbound recipient preferences.
+typedef struct {
+	stringer_t *key; /* The normalized recipient address. */
+	int_t state; /* The value returned by smtp_fetch_inbound() for the address. */
+	time_t expiration; /* When the slot should stop being trusted. */
+	uint64_t user, config; /* The user and config serial numbers when the preferences were loaded. */
+	smtp_inbound_prefs_t *prefs; /* A pristine copy of the preferences, or NULL if the address was rejected. */
+} smtp_inbound_slot_t;
+
+// The number of locks protecting the message counters, the number of hourly buckets held by each counter, and the number of rows
+// written to the database by a single statement when the counters are flushed.
+#define SMTP_COUNTER_SHARDS 64
+#define SMTP_COUNTER_HOURS 24
+#define SMTP_COUNTER_BATCH 256
+
+enum {
+	SMTP_COUNTER_RECEIVED = 0,
+	SMTP_COUNTER_SENT = 1,
+
+	SMTP_COUNTER_TABLE_RECEIVING = 1,
+	SMTP_COUNTER_TABLE_TRANSMITTING = 2,
+	SMTP_COUNTER_TABLE_LOG_RECEIVED = 3,
+	SMTP_COUNTER_TABLE_LOG_SENT = 4
+};
+
+// An in-memory count of the messages received or sent by a user, and optionally from a specific subnet, over the last day.
+typedef struct {
+	int_t kind; /* Whether the counter tracks received or sent messages. */
+	uint64_t usernum; /* The user the counter belongs to. */
+	stringer_t *subnet; /* The sending subnet for received messages, or NULL if the counter tracks every message. */
+	stringer_t *key; /* The cache key prefix shared by the cluster nodes. */
+	time_t touched; /* When the counter was last used. */
+	time_t synced; /* When the counter was last reconciled with the cache servers. */
+	struct {
+		uint64_t hour; /* The number of hours since the epoch the bucket refers to. */
+		uint64_t count; /* The number of messages counted during that hour, across every cluster node. */
+	} hours[SMTP_COUNTER_HOURS];
+	struct {
+		uint64_t hour; /* The hour the unsynchronized increments were made during. */
+		uint64_t count; /* The local increments which haven't been added to the cache servers. */
+		uint64_t rows; /* The number of rows waiting to be written to the Receiving or Transmitting table. */
+		uint64_t messages, bounces; /* The Log table totals waiting to be written. */
+	} pending;
+} smtp_counter_t;
+
+// The changes detached from a counter while it's being flushed, so they can be restored if the flush fails.
+typedef struct {
+	smtp_counter_t *counter;
+	uint64_t hour, count, rows, messages, bounces;
+} smtp_counter_work_t;
+
+// Tracks the recipients of an inbound message while the deliveries are spread across the worker threads.
+typedef struct {
+	void *con; /* The connection the message was received on. */
+	smtp_inbound_prefs_t *cursor; /* The next recipient waiting to be delivered. */
+	uint32_t refs; /* The thread delivering the message, plus each queued helper. */
+	uint32_t active; /* The number of helpers currently delivering a recipient. */
+	bool_t closed; /* Set once every recipient has been claimed, and the delivering thread is waiting on the helpers. */
+	sem_t complete; /* Posted when the last active helper finishes, after the fan-out is closed. */
+	pthread_mutex_t lock;
+} smtp_fanout_t;
+
 // The structure for storing recipient preferences on outbound data.
 typedef struct {
 	uint64_t usernum;
@@ -123,6 +185,8 @@ typedef struct {
 		int_t virus;
 	} checked;
 
+	bool_t fanout; /* Set while the recipients are delivered in parallel, so the checked results are treated as read only. */
+
 	smtp_message_t *message;
 	smtp_inbound_prefs_t *in_prefs;
 	smtp_outbound_prefs_t *out_prefs;
@@ -14,7 +14,7 @@
 
 /**
  * @brief	Write data to a network connection.
- * @note	This function works regardless of whether or not the connection is ssl-enabled.
+ * @note	This function works regardless of whether or not the connection is ssl-enabled, and passes the data through any stream filters.
  * 			If the network write requires multiple system calls, then this code will loop until all the data has been transmitted.
  * @param	con		the connection across which the supplied data will be written.
  * @param	block	a pointer to a data buffer containing the data to be written to the connection's remote client.
@@ -37,12 +37,8 @@ int64_t con_write_bl(connection_t *con, char *block, size_t length) {
 	// Loop until all of the bytes have been sent to the client.
 	do {
 
-		if (con->network.tls) {
-			bytes = tls_write(con->network.tls, block + position, length, true);
-		}
-		else {
-			bytes = tcp_write(con->network.sockd, block + position, length, true);
-		}
+		// Write through the stream filters, which will fall through to the TLS or TCP transport layer directly if there aren't any.
+		bytes = con_filter_write(con, con->network.filters, block + position, length);
 
 		// Handle progress by advancing our position tracker.
 		if (bytes > 0) {
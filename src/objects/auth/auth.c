@@ -286,6 +286,22 @@ int_t auth_login(stringer_t *username, stringer_t *password, auth_t **output) {
 
 	/************************** END LEGACY AUTHENTICATION SUPPORT LOGIC **************************/
 
+	// If these credentials were verified recently, we can skip the key derivation.
+	else if (!auth->legacy.token && auth_cache_enabled() && (auth->keys.master = auth_cache_get(auth->usernum, auth->username, password,
+		auth->seasoning.salt, auth->seasoning.bonus, auth->tokens.verification))) {
+
+		// If valid login credentials are provided for an account with an inactivity lock, we remove the inactivity lock.
+		if (auth->status.locked == AUTH_LOCK_INACTIVITY) {
+			log_pedantic("Clearing an inactivity lock. { username = %.*s }", st_length_int(username), st_char_get(username));
+			auth_data_update_lock(auth->usernum, AUTH_LOCK_NONE);
+			auth->status.locked = AUTH_LOCK_NONE;
+		}
+
+		// Valid STACIE login!
+		*output = auth;
+		return 0;
+	}
+
 	// Generate the STACIE tokens based on the provided inputs.
 	else if (!auth->legacy.token && !(stacie = auth_stacie(auth->seasoning.bonus, auth->username, password, auth->seasoning.salt, NULL, NULL))) {
 		log_pedantic("Unable to calculate the STACIE verification tokens for comparison.");
@@ -314,6 +330,9 @@ int_t auth_login(stringer_t *username, stringer_t *password, auth_t **output) {
 			return -1;
 		}
 
+		auth_cache_set(auth->usernum, auth->username, password, auth->seasoning.salt, auth->seasoning.bonus, auth->tokens.verification,
+			auth->keys.master);
+
 		// If valid login credentials are provided for an account with an inactivity lock, we remove the inactivity lock.
 		if (auth->status.locked == AUTH_LOCK_INACTIVITY) {
 			log_pedantic("Clearing an inactivity lock. { username = %.*s }", st_length_int(username), st_char_get(username));
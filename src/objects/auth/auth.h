@@ -23,6 +23,20 @@ typedef enum {
 	 AUTH_LOCK_USER = 5                    /**< The account has been locked at the request of the user. */
 } auth_lock_status_t;
 
+typedef struct {
+	uint64_t usernum;
+	time_t expiration;
+	uchr_t key[STACIE_KEY_LENGTH]; /* The keyed hash of the username, password, salt and bonus rounds. */
+	uchr_t verification[STACIE_TOKEN_LENGTH];
+	uchr_t master[STACIE_KEY_LENGTH];
+} auth_cache_slot_t;
+
+// A key derivation request queued for the batched key derivation threads. The STACIE values must be the first member.
+typedef struct {
+	stacie_job_t job;
+	sem_t complete; /* Posted once the derivation completes, or fails. */
+} auth_batch_job_t;
+
 typedef struct {
 	stringer_t *key;
 	stringer_t *token;
@@ -84,6 +98,25 @@ void      auth_free(auth_t *auth);
 int_t     auth_login(stringer_t *username, stringer_t *password, auth_t **output);
 int_t     auth_response(auth_t *auth, stringer_t *ephemeral);
 
+/// batch.c
+bool_t          auth_batch_derive(uint32_t rounds, stringer_t *username, stringer_t *password, stringer_t *salt, stringer_t **master, stringer_t **key);
+void            auth_batch_done(stacie_job_t *job, void *opaque);
+bool_t          auth_batch_enabled(void);
+stacie_job_t *  auth_batch_next(void *opaque);
+stacie_job_t *  auth_batch_pop(void);
+bool_t          auth_batch_start(void);
+void            auth_batch_stop(void);
+void            auth_batch_thread(void);
+
+/// cache.c
+bool_t               auth_cache_enabled(void);
+stringer_t *         auth_cache_get(uint64_t usernum, stringer_t *username, stringer_t *password, stringer_t *salt, uint32_t bonus, stringer_t *verification);
+void                 auth_cache_invalidate(uint64_t usernum);
+bool_t               auth_cache_key(stringer_t *username, stringer_t *password, stringer_t *salt, uint32_t bonus, uchr_t *output);
+void                 auth_cache_set(uint64_t usernum, stringer_t *username, stringer_t *password, stringer_t *salt, uint32_t bonus, stringer_t *verification, stringer_t *master);
+bool_t               auth_cache_start(void);
+void                 auth_cache_stop(void);
+
 /// datatier.c
 int_t   auth_data_fetch(auth_t *auth);
 int_t   auth_data_update_legacy(uint64_t usernum, stringer_t *legacy, stringer_t *salt, stringer_t *verification, uint32_t bonus);
@@ -0,0 +1,309 @@
+
+/**
+ * @file /magma/objects/auth/batch.c
+ *
+ * @brief	Collect the STACIE key derivations requested by concurrent logins, and process them together using the multi-lane
+ * 			SHA-512 functions, so a burst of logins is handled several times faster than deriving each set of keys separately.
+ *
+ * @note	The service is opt-in, and disabled unless magma.secure.derivation.threads is set. Each derivation thread waits for a
+ * 			request, and when fewer requests are queued than there are lanes, waits magma.secure.derivation.delay milliseconds for
+ * 			more to arrive before it starts. Requests which arrive while a batch is running are placed in the first idle lane. The
+ * 			requests, and the derived keys, are held in secure memory.
+ */
+
+#include "magma.h"
+
+struct {
+	bool_t active; /* Set while new requests are being accepted. */
+	uint32_t count; /* The number of derivation threads. */
+	uint32_t queued;
+	sem_t pending;
+	pthread_t *threads;
+	pthread_mutex_t lock;
+	stacie_job_t *head, *tail;
+} derivations = {
+	.active = false,
+	.count = 0,
+	.queued = 0,
+	.threads = NULL,
+	.head = NULL,
+	.tail = NULL
+};
+
+/**
+ * @brief	Determine whether the batched key derivation service is active.
+ * @return	true if the service is enabled, or false if every login derives its own keys.
+ */
+bool_t auth_batch_enabled(void) {
+
+	return derivations.active;
+}
+
+/**
+ * @brief	Remove the oldest request from the queue.
+ * @return	the oldest pending request, or NULL if the queue is empty.
+ */
+stacie_job_t * auth_batch_pop(void) {
+
+	stacie_job_t *job;
+
+	mutex_lock(&(derivations.lock));
+
+	if ((job = derivations.head)) {
+		derivations.head = job->next;
+		derivations.queued--;
+		job->next = NULL;
+	}
+
+	if (!derivations.head) {
+		derivations.tail = NULL;
+	}
+
+	mutex_unlock(&(derivations.lock));
+
+	return job;
+}
+
+/**
+ * @brief	Hand the multi-lane derivation function the next pending request.
+ * @note	The request which woke the derivation thread is returned first. After that, a request is only removed from the queue
+ * 			if the thread can claim the semaphore count which was added for it.
+ * @param	opaque	a pointer to the request which woke the derivation thread.
+ * @return	the next pending request, or NULL if the queue is empty.
+ */
+stacie_job_t * auth_batch_next(void *opaque) {
+
+	stacie_job_t **first = opaque, *job;
+
+	if ((job = *first)) {
+		*first = NULL;
+		return job;
+	}
+	else if (sem_trywait(&(derivations.pending))) {
+		return NULL;
+	}
+
+	return auth_batch_pop();
+}
+
+/**
+ * @brief	Wake the login waiting on a completed, or failed, request.
+ * @note	The request is freed by the waiting thread, so it mustn't be used after the semaphore is posted.
+ * @param	job		the completed request.
+ * @param	opaque	unused.
+ * @return	This function returns no value.
+ */
+void auth_batch_done(stacie_job_t *job, void *opaque) {
+
+	job->done = true;
+	sem_post(&(((auth_batch_job_t *)job)->complete));
+
+	return;
+}
+
+/**
+ * @brief	The derivation thread entry point.
+ * @return	This function returns no value.
+ */
+void auth_batch_thread(void) {
+
+	stacie_job_t *first;
+
+	if (!thread_start()) {
+		log_error("Unable to setup the thread context.");
+		pthread_exit(NULL);
+	}
+
+	do {
+
+		// Wait until the semaphore indicates a request is queued.
+		if (sem_wait(&(derivations.pending)) || !(first = auth_batch_pop())) {
+			continue;
+		}
+
+		// The logins are still waiting during a shutdown, so any remaining requests are failed rather than abandoned.
+		if (!status()) {
+			first->failed = true;
+			auth_batch_done(first, NULL);
+			continue;
+		}
+
+		// Give concurrent logins a moment to arrive, so the lanes aren't mostly empty.
+		if (magma.secure.derivation.delay && derivations.queued < STACIE_LANES - 1) {
+			usleep(magma.secure.derivation.delay * 1000);
+		}
+
+		stats_increment_by_name("objects.auth.batch.runs");
+		stacie_lanes_derive(&auth_batch_next, &auth_batch_done, &first);
+
+	} while (derivations.active);
+
+	thread_stop();
+	pthread_exit(NULL);
+
+	return;
+}
+
+/**
+ * @brief	Launch the batched key derivation threads.
+ * @note	If magma.secure.derivation.threads is set to zero, the service is disabled and every login derives its own keys.
+ * @return	true on success or false on failure.
+ */
+bool_t auth_batch_start(void) {
+
+	if (!magma.secure.derivation.threads) {
+		return true;
+	}
+	else if (!magma.secure.memory.enable) {
+		log_critical("The batched key derivation service requires secure memory.");
+		return false;
+	}
+	else if (sem_init(&(derivations.pending), 0, 0)) {
+		log_critical("Unable to initialize the batched key derivation semaphore.");
+		return false;
+	}
+	else if (mutex_init(&(derivations.lock), NULL)) {
+		log_critical("Unable to initialize the batched key derivation lock.");
+		sem_destroy(&(derivations.pending));
+		return false;
+	}
+	else if (!(derivations.threads = mm_alloc(sizeof(pthread_t) * magma.secure.derivation.threads))) {
+		log_critical("Unable to allocate memory for the batched key derivation threads.");
+		mutex_destroy(&(derivations.lock));
+		sem_destroy(&(derivations.pending));
+		return false;
+	}
+
+	derivations.active = true;
+
+	for (uint32_t i = 0; i < magma.secure.derivation.threads; i++) {
+
+		if (thread_launch(derivations.threads + i, &auth_batch_thread, NULL)) {
+			log_critical("Unable to launch the configured number of key derivation threads. { threads = %u / configured = %u }", i,
+				magma.secure.derivation.threads);
+			auth_batch_stop();
+			return false;
+		}
+
+		derivations.count++;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Stop the batched key derivation threads, and fail any requests which are still queued.
+ * @return	This function returns no value.
+ */
+void auth_batch_stop(void) {
+
+	stacie_job_t *job;
+
+	if (!derivations.threads) {
+		return;
+	}
+
+	mutex_lock(&(derivations.lock));
+	derivations.active = false;
+	mutex_unlock(&(derivations.lock));
+
+	for (uint32_t i = 0; i < derivations.count; i++) {
+		sem_post(&(derivations.pending));
+	}
+
+	for (uint32_t i = 0; i < derivations.count; i++) {
+		thread_join(derivations.threads[i]);
+	}
+
+	while ((job = auth_batch_pop())) {
+		job->failed = true;
+		auth_batch_done(job, NULL);
+	}
+
+	mm_free(derivations.threads);
+	mutex_destroy(&(derivations.lock));
+	sem_destroy(&(derivations.pending));
+
+	derivations.threads = NULL;
+	derivations.count = 0;
+
+	return;
+}
+
+/**
+ * @brief	Derive the master key and password key for a login, using the batched key derivation service.
+ * @note	The values are identical to those produced by stacie_derive_seed() and stacie_derive_key(). If the service is disabled,
+ * 			or the request fails, the caller should derive the keys itself.
+ * @param	rounds		the number of hash rounds, as returned by stacie_derive_rounds().
+ * @param	username	a managed string holding the normalized username.
+ * @param	password	a managed string holding the plain text user password.
+ * @param	salt		a managed string with the salt value for the current user.
+ * @param	master		a pointer which will receive a secure managed string holding the master key.
+ * @param	key			a pointer which will receive a secure managed string holding the password key.
+ * @return	true on success, or false if an error occurs.
+ */
+bool_t auth_batch_derive(uint32_t rounds, stringer_t *username, stringer_t *password, stringer_t *salt, stringer_t **master, stringer_t **key) {
+
+	auth_batch_job_t *request;
+
+	if (!derivations.active || !master || !key) {
+		return false;
+	}
+	else if (!(request = mm_sec_alloc(sizeof(auth_batch_job_t)))) {
+		log_pedantic("Unable to allocate secure memory for a batched key derivation request.");
+		return false;
+	}
+	else if (sem_init(&(request->complete), 0, 0)) {
+		log_pedantic("Unable to initialize the batched key derivation request semaphore.");
+		mm_sec_free(request);
+		return false;
+	}
+
+	request->job.rounds = rounds;
+	request->job.username = username;
+	request->job.password = password;
+	request->job.salt = salt;
+
+	mutex_lock(&(derivations.lock));
+
+	// The service is checked again while holding the lock, so a request can't be queued after the queue has been drained.
+	if (!derivations.active) {
+		mutex_unlock(&(derivations.lock));
+		sem_destroy(&(request->complete));
+		mm_sec_free(request);
+		return false;
+	}
+
+	if (derivations.tail) {
+		derivations.tail->next = &(request->job);
+	}
+	else {
+		derivations.head = &(request->job);
+	}
+
+	derivations.tail = &(request->job);
+	derivations.queued++;
+
+	mutex_unlock(&(derivations.lock));
+	sem_post(&(derivations.pending));
+
+	while (sem_wait(&(request->complete)) && errno == EINTR);
+
+	*master = *key = NULL;
+
+	if (!request->job.done || request->job.failed ||
+		!(*master = st_dupe_opts(MANAGED_T | CONTIGUOUS | SECURE, PLACER(request->job.master, STACIE_KEY_LENGTH))) ||
+		!(*key = st_dupe_opts(MANAGED_T | CONTIGUOUS | SECURE, PLACER(request->job.key, STACIE_KEY_LENGTH)))) {
+		log_pedantic("The batched key derivation request failed.");
+		st_cleanup(*master);
+		*master = NULL;
+	}
+
+	stats_increment_by_name("objects.auth.batch.jobs");
+
+	sem_destroy(&(request->complete));
+	mm_wipe(request, sizeof(auth_batch_job_t));
+	mm_sec_free(request);
+
+	return *master ? true : false;
+}
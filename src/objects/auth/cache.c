@@ -0,0 +1,240 @@
+
+/**
+ * @file /magma/objects/auth/cache.c
+ *
+ * @brief	A short lived cache of verified STACIE credentials, so clients which reconnect and authenticate repeatedly don't
+ * 			force the server to repeat the key derivation for every login.
+ *
+ * @note	The cache is opt-in, and disabled unless magma.secure.auth_cache.entries is set. Entries are located using an HMAC of the
+ * 			username, password, salt and bonus rounds, keyed with a random value generated at startup, so the cache never holds the
+ * 			password, or a value which could be used to test guesses without the key. The table, and the key, are held in secure
+ * 			memory. An entry is only trusted if the verification token stored in the database still matches the token it was
+ * 			derived with, so a password change on any node invalidates it, and the account lock is always read from the database.
+ */
+
+#include "magma.h"
+
+struct {
+	stringer_t *secret; /* The random key used to hash the credentials. */
+	slotted_t *table; /* The slot table, or NULL if the cache is disabled. */
+} credentials = {
+	.secret = NULL,
+	.table = NULL
+};
+
+/**
+ * @brief	Allocate the verified credentials cache.
+ * @note	If magma.secure.auth_cache.entries is set to zero, the cache is disabled and every login derives the STACIE values.
+ * @return	true on success or false on failure.
+ */
+bool_t auth_cache_start(void) {
+
+	if (!magma.secure.auth_cache.entries || !magma.secure.auth_cache.timeout) {
+		return true;
+	}
+	else if (!magma.secure.memory.enable) {
+		log_critical("The verified credentials cache requires secure memory.");
+		return false;
+	}
+	else if (!(credentials.secret = st_alloc_opts(MANAGED_T | CONTIGUOUS | SECURE, STACIE_KEY_LENGTH)) ||
+		rand_write(credentials.secret) != STACIE_KEY_LENGTH) {
+		log_critical("Unable to generate the verified credentials cache key.");
+		st_cleanup(credentials.secret);
+		credentials.secret = NULL;
+		return false;
+	}
+	else if (!(credentials.table = slotted_alloc(magma.secure.auth_cache.entries, sizeof(auth_cache_slot_t), true, NULL))) {
+		log_critical("Could not allocate secure memory for the verified credentials cache. Increase magma.secure.memory.length, "
+			"or reduce magma.secure.auth_cache.entries. { entries = %u / required = %zu }", magma.secure.auth_cache.entries,
+			sizeof(auth_cache_slot_t) * magma.secure.auth_cache.entries);
+		st_free(credentials.secret);
+		credentials.secret = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Wipe and free the verified credentials cache.
+ * @return	This function returns no value.
+ */
+void auth_cache_stop(void) {
+
+	slotted_t *table = credentials.table;
+
+	if (!table) {
+		return;
+	}
+
+	// The slots are wiped before the table is released.
+	credentials.table = NULL;
+	slotted_free(table);
+
+	st_free(credentials.secret);
+	credentials.secret = NULL;
+
+	return;
+}
+
+/**
+ * @brief	Determine whether the verified credentials cache is active.
+ * @return	true if the cache is enabled, otherwise false.
+ */
+bool_t auth_cache_enabled(void) {
+
+	return credentials.table ? true : false;
+}
+
+/**
+ * @brief	Calculate the keyed hash used to locate a set of credentials in the cache.
+ * @param	username	a managed string holding the normalized username.
+ * @param	password	a managed string holding the plain text user password.
+ * @param	salt		a managed string with the salt value for the current user.
+ * @param	bonus		the number of bonus hash rounds applied for the user account.
+ * @param	output		a buffer of STACIE_KEY_LENGTH bytes which will receive the hash.
+ * @return	true on success, or false if an error occurs.
+ */
+bool_t auth_cache_key(stringer_t *username, stringer_t *password, stringer_t *salt, uint32_t bonus, uchr_t *output) {
+
+	HMAC_CTX ctx;
+	uchr_t separator = 0;
+	uint_t length = STACIE_KEY_LENGTH;
+	const EVP_MD *digest = EVP_sha512_d();
+
+	if (!digest || st_empty(username, password, salt)) {
+		return false;
+	}
+
+	HMAC_CTX_init_d(&ctx);
+
+	// The separators ensure a different split between the username and password can't produce the same input.
+	if (HMAC_Init_ex_d(&ctx, st_data_get(credentials.secret), st_length_get(credentials.secret), digest, NULL) != 1 ||
+		HMAC_Update_d(&ctx, st_data_get(username), st_length_get(username)) != 1 || HMAC_Update_d(&ctx, &separator, 1) != 1 ||
+		HMAC_Update_d(&ctx, st_data_get(password), st_length_get(password)) != 1 || HMAC_Update_d(&ctx, &separator, 1) != 1 ||
+		HMAC_Update_d(&ctx, st_data_get(salt), st_length_get(salt)) != 1 || HMAC_Update_d(&ctx, (uchr_t *)&bonus, sizeof(uint32_t)) != 1 ||
+		HMAC_Final_d(&ctx, output, &length) != 1 || length != STACIE_KEY_LENGTH) {
+		log_pedantic("Unable to hash the credentials for the verified credentials cache. {%s}", ssl_error_string(MEMORYBUF(256), 256));
+		HMAC_CTX_cleanup_d(&ctx);
+		return false;
+	}
+
+	HMAC_CTX_cleanup_d(&ctx);
+
+	return true;
+}
+
+/**
+ * @brief	Retrieve the master key for a set of credentials which were recently verified.
+ * @param	usernum			the numerical id of the user.
+ * @param	username		a managed string holding the normalized username.
+ * @param	password		a managed string holding the plain text user password.
+ * @param	salt			a managed string with the salt value for the current user.
+ * @param	bonus			the number of bonus hash rounds applied for the user account.
+ * @param	verification	a managed string with the verification token currently stored in the database.
+ * @return	a secure managed string holding the master key, or NULL if the credentials weren't found.
+ */
+stringer_t * auth_cache_get(uint64_t usernum, stringer_t *username, stringer_t *password, stringer_t *salt, uint32_t bonus, stringer_t *verification) {
+
+	auth_cache_slot_t *slot;
+	uint64_t hash;
+	stringer_t *master = NULL;
+	uchr_t key[STACIE_KEY_LENGTH];
+
+	if (!credentials.table || st_empty(verification) || st_length_get(verification) != STACIE_TOKEN_LENGTH) {
+		return NULL;
+	}
+	else if (!auth_cache_key(username, password, salt, bonus, key)) {
+		mm_wipe(key, STACIE_KEY_LENGTH);
+		return NULL;
+	}
+
+	hash = *((uint64_t *)key);
+	slot = slotted_lock(credentials.table, hash);
+
+	if (slot->usernum == usernum && slot->expiration > time(NULL) && !memcmp(slot->key, key, STACIE_KEY_LENGTH)) {
+
+		// If the verification token changed, the password was changed, and the entry is useless.
+		if (memcmp(slot->verification, st_data_get(verification), STACIE_TOKEN_LENGTH)) {
+			slotted_clear(credentials.table, slot);
+		}
+		else if (!(master = st_dupe_opts(MANAGED_T | CONTIGUOUS | SECURE, PLACER(slot->master, STACIE_KEY_LENGTH)))) {
+			log_pedantic("Unable to copy the cached master key into secure memory.");
+		}
+	}
+
+	slotted_unlock(credentials.table, hash);
+	mm_wipe(key, STACIE_KEY_LENGTH);
+
+	stats_increment_by_name(master ? "objects.auth.cache.hits" : "objects.auth.cache.misses");
+
+	return master;
+}
+
+/**
+ * @brief	Store the result of a successful STACIE login.
+ * @param	usernum			the numerical id of the user.
+ * @param	username		a managed string holding the normalized username.
+ * @param	password		a managed string holding the plain text user password.
+ * @param	salt			a managed string with the salt value for the current user.
+ * @param	bonus			the number of bonus hash rounds applied for the user account.
+ * @param	verification	a managed string with the verification token derived from the password.
+ * @param	master			a managed string with the master key derived from the password.
+ * @return	This function returns no value.
+ */
+void auth_cache_set(uint64_t usernum, stringer_t *username, stringer_t *password, stringer_t *salt, uint32_t bonus, stringer_t *verification, stringer_t *master) {
+
+	auth_cache_slot_t *slot;
+	uint64_t hash;
+	uchr_t key[STACIE_KEY_LENGTH];
+
+	if (!credentials.table || !usernum || st_empty(verification, master) || st_length_get(verification) != STACIE_TOKEN_LENGTH ||
+		st_length_get(master) != STACIE_KEY_LENGTH) {
+		return;
+	}
+	else if (!auth_cache_key(username, password, salt, bonus, key)) {
+		mm_wipe(key, STACIE_KEY_LENGTH);
+		return;
+	}
+
+	hash = *((uint64_t *)key);
+	slot = slotted_lock(credentials.table, hash);
+	slot->usernum = usernum;
+	slot->expiration = time(NULL) + magma.secure.auth_cache.timeout;
+	mm_copy(slot->key, key, STACIE_KEY_LENGTH);
+	mm_copy(slot->verification, st_data_get(verification), STACIE_TOKEN_LENGTH);
+	mm_copy(slot->master, st_data_get(master), STACIE_KEY_LENGTH);
+	slotted_unlock(credentials.table, hash);
+
+	mm_wipe(key, STACIE_KEY_LENGTH);
+
+	return;
+}
+
+/**
+ * @brief	Remove every cached set of credentials belonging to a user.
+ * @note	This is used when an account is locked, or its credentials are replaced.
+ * @param	usernum		the numerical id of the user.
+ * @return	This function returns no value.
+ */
+void auth_cache_invalidate(uint64_t usernum) {
+
+	auth_cache_slot_t *slot;
+
+	if (!credentials.table || !usernum) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < slotted_count(credentials.table); i++) {
+
+		slot = slotted_lock(credentials.table, i);
+
+		if (slot->usernum == usernum) {
+			slotted_clear(credentials.table, slot);
+		}
+
+		slotted_unlock(credentials.table, i);
+	}
+
+	return;
+}
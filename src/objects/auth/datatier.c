@@ -75,6 +75,8 @@ int_t auth_data_update_legacy(uint64_t usernum, stringer_t *legacy, stringer_t *
 		return -1;
 	}
 
+	auth_cache_invalidate(usernum);
+
 	return 0;
 }
 
@@ -118,6 +120,11 @@ void auth_data_update_lock(uint64_t usernum, auth_lock_status_t lock) {
 		log_pedantic("Unable to update the user lock. { usernum = %lu / lock = %hhu }", usernum, tiny);
 	}
 
+	// Locked accounts shouldn't keep verified credentials in memory.
+	if (lock != AUTH_LOCK_NONE) {
+		auth_cache_invalidate(usernum);
+	}
+
 	return;
 }
 
@@ -126,6 +126,10 @@ auth_stacie_t * auth_stacie(uint32_t bonus, stringer_t *username, stringer_t *pa
 			auth_stacie_free(stacie);
 			return NULL;
 		}
+		// Use the batched key derivation threads when they're available, and derive the keys here if the request fails.
+		else if (auth_batch_enabled() && auth_batch_derive(rounds, username, password, salt, &(stacie->keys.master), &(stacie->keys.password))) {
+			log_check(!stacie->keys.master || !stacie->keys.password);
+		}
 		else if (!(seed = stacie_derive_seed(rounds, password, salt))) {
 			log_pedantic("An error ocurred while trying to calculate the entropy seed value.");
 			auth_stacie_free(stacie);
@@ -141,7 +145,8 @@ auth_stacie_t * auth_stacie(uint32_t bonus, stringer_t *username, stringer_t *pa
 			auth_stacie_free(stacie);
 			return NULL;
 		}
-		else if (!(stacie->tokens.verification = stacie_derive_token(stacie->keys.password, username, salt, NULL))) {
+
+		if (!(stacie->tokens.verification = stacie_derive_token(stacie->keys.password, username, salt, NULL))) {
 			log_pedantic("An error ocurred while trying to calculate the verification token.");
 			auth_stacie_free(stacie);
 			return NULL;
@@ -338,14 +338,18 @@ int_t contact_details_fetch(contact_t *contact) {
  */
 int_t contacts_fetch(uint64_t usernum, contact_folder_t *folder) {
 
-	row_t *row;
-	table_t *result;
+	int_t ret;
+	chr_t name[1024];
 	contact_t *record;
 	inx_cursor_t *cursor;
-	MYSQL_BIND parameters[2];
+	stmt_cursor_t stream;
+	MYSQL_BIND parameters[2], results[2];
+	unsigned long name_length = 0;
+	uint64_t contactnum = 0;
 	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
 
 	mm_wipe(parameters, sizeof(parameters));
+	mm_wipe(results, sizeof(results));
 
 	if (!usernum || !folder || !folder->foldernum) {
 		log_pedantic("Invalid data passed for contact fetch.");
@@ -364,23 +368,41 @@ int_t contacts_fetch(uint64_t usernum, contact_folder_t *folder) {
 	parameters[1].buffer = &(folder->foldernum);
 	parameters[1].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_contacts, parameters))) {
+	// Contact Number
+	results[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[0].buffer_length = sizeof(uint64_t);
+	results[0].buffer = &contactnum;
+	results[0].is_unsigned = true;
+
+	// Name, which is limited to 255 characters, and thus 1020 bytes of UTF-8.
+	results[1].buffer_type = MYSQL_TYPE_STRING;
+	results[1].buffer_length = sizeof(name);
+	results[1].buffer = name;
+	results[1].length = &name_length;
+
+	if (!stmt_stream_user(&stream, stmts.select_contacts, parameters, results, usernum)) {
 		log_pedantic("Unable to fetch the folder contacts.");
 		return -1;
 	}
 
 	// Loop through each of the row and create a contact record. When were finished we'll fetch the contact details for each record found.
-	while ((row = res_row_next(result))) {
-		if (!(record = contact_alloc(res_field_uint64(row, 0), PLACER(res_field_block(row, 1), res_field_length(row, 1)))) ||
+	while ((ret = stmt_fetch_next(&stream)) == 1) {
+		if (!(record = contact_alloc(contactnum, PLACER(name, name_length))) ||
 			!(key.val.u64 = record->contactnum) || !inx_insert(folder->records, key, record)) {
-			log_info("The index refused to accept a contact record. { contact = %lu }", res_field_uint64(row, 0));
+			log_info("The index refused to accept a contact record. { contact = %lu }", contactnum);
 			if (record) contact_free(record);
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return -1;
 		}
 	}
 
-	res_table_free(result);
+	// The details are fetched after the cursor is closed, so the connection isn't held while the other queries run.
+	stmt_stream_close(&stream);
+
+	if (ret < 0) {
+		log_pedantic("Unable to fetch the folder contacts.");
+		return -1;
+	}
 
 	/// LOW: Should we bother with error checking?
 	if ((cursor = inx_cursor_alloc(folder->records))) {
@@ -15,16 +15,21 @@
  */
 inx_t * magma_folder_fetch(uint64_t usernum, uint_t type) {
 
-	row_t *row;
+	int_t ret;
 	inx_t *output;
-	table_t *result;
+	chr_t name[129];
+	stmt_cursor_t stream;
 	magma_folder_t *record;
-	MYSQL_BIND parameters[2];
+	MYSQL_BIND parameters[2], results[4];
+	unsigned long name_length = 0;
+	uint32_t order = 0;
+	uint64_t foldernum = 0, parent = 0;
 	void (*folder_free)(magma_folder_t *);
 	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
 	magma_folder_t * (*folder_alloc)(uint64_t, uint64_t, uint32_t, stringer_t *);
 
 	mm_wipe(parameters, sizeof(parameters));
+	mm_wipe(results, sizeof(results));
 
 	if (!usernum) {
 		log_pedantic("Invalid user number requested. { user = 0 }");
@@ -47,34 +52,60 @@ inx_t * magma_folder_fetch(uint64_t usernum, uint_t type) {
 	parameters[1].buffer = &type;
 	parameters[1].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_folders, parameters))) {
+	results[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[0].buffer_length = sizeof(uint64_t);
+	results[0].buffer = &foldernum;
+	results[0].is_unsigned = true;
+
+	results[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[1].buffer_length = sizeof(uint64_t);
+	results[1].buffer = &parent;
+	results[1].is_unsigned = true;
+
+	results[2].buffer_type = MYSQL_TYPE_LONG;
+	results[2].buffer_length = sizeof(uint32_t);
+	results[2].buffer = &order;
+	results[2].is_unsigned = true;
+
+	// Folder names are stored as modified UTF-7, so they can't be longer than the 128 bytes allowed by the column.
+	results[3].buffer_type = MYSQL_TYPE_STRING;
+	results[3].buffer_length = sizeof(name) - 1;
+	results[3].buffer = name;
+	results[3].length = &name_length;
+
+	if (!stmt_stream_user(&stream, stmts.select_folders, parameters, results, usernum)) {
 		log_pedantic("No incoming mail domains configured.");
 		return NULL;
 	}
 	else if (!(output = inx_alloc(M_INX_TREE, folder_free))) {
-		res_table_free(result);
+		stmt_stream_close(&stream);
 		return NULL;
 	}
 
 	// Loop through each of the row returned.
-	while ((row = res_row_next(result))) {
+	while ((ret = stmt_fetch_next(&stream)) == 1) {
 
 		// Pass the folder fields into the allocator.
-		if (!(record = folder_alloc(res_field_uint64(row, 0), res_field_uint64(row, 1), res_field_uint32(row, 2),
-			PLACER(res_field_block(row, 3), res_field_length(row, 3))))	|| !(key.val.u64 = record->foldernum) || !inx_insert(output, key, record)) {
-			log_info("The index refused to accept a folder record. { folder = %lu }", res_field_uint64(row, 0));
+		if (!(record = folder_alloc(foldernum, parent, order, PLACER(name, name_length))) || !(key.val.u64 = record->foldernum) ||
+			!inx_insert(output, key, record)) {
+			log_info("The index refused to accept a folder record. { folder = %lu }", foldernum);
 
 			if (record) {
 				folder_free(record);
 			}
 
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			inx_free(output);
 			return NULL;
 		}
 	}
 
-	res_table_free(result);
+	stmt_stream_close(&stream);
+
+	if (ret < 0) {
+		inx_free(output);
+		return NULL;
+	}
 
 	return output;
 }
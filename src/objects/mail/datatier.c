@@ -78,7 +78,7 @@ bool_t mail_db_delete_message(uint64_t usernum, uint64_t messagenum, uint32_t si
 	parameters[1].buffer = &usernum;
 	parameters[1].is_unsigned = true;
 
-	// Update the Users table.
+	// Update the Users table. The query also bumps the user's modification sequence, so the removal changes the HIGHESTMODSEQ value.
 	if ((affected = stmt_exec_affected_conn(stmts.update_user_quota_subtract, parameters, transaction)) == 0) {
 		log_error("Unable to update the Users table. The user number was %lu, the message number was %lu and the message size was %u.",
 				usernum, messagenum, size);
@@ -88,6 +88,88 @@ bool_t mail_db_delete_message(uint64_t usernum, uint64_t messagenum, uint32_t si
 	return true;
 }
 
+/**
+ * @brief	Delete a collection of mail messages from the mysql database and adjust the owner's quota once.
+ * @note	The message numbers are deleted in batches of MAIL_REMOVE_BATCH_SIZE. When the final batch is only partially filled, the unused
+ * 			placeholders repeat the last message number, which lets us reuse the prepared statement.
+ * @param	usernum		the user id to whom the target mail messages belong.
+ * @param	numbers		an array holding the message ids of the mail messages to be deleted.
+ * @param	count		the number of message ids in the array.
+ * @param	size		the combined storage size, in bytes, of the messages to be deleted.
+ * @param	transaction	the mysql connection id on which to execute the statements.
+ * @return	0 on failure or 1 on success.
+ */
+bool_t mail_db_delete_messages(uint64_t usernum, uint64_t *numbers, size_t count, uint64_t size, int_t transaction) {
+
+	int64_t affected;
+	size_t filled, deleted = 0;
+	uint64_t batch[MAIL_REMOVE_BATCH_SIZE];
+	MYSQL_BIND parameters[1 + MAIL_REMOVE_BATCH_SIZE];
+
+	if (!usernum || !numbers || !count || transaction < 0) {
+		log_pedantic("Invalid parameters were passed to the bulk message delete function.");
+		return false;
+	}
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Usernum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &usernum;
+	parameters[0].is_unsigned = true;
+
+	for (size_t i = 0; i < MAIL_REMOVE_BATCH_SIZE; i++) {
+
+		// Messagenum
+		parameters[i + 1].buffer_type = MYSQL_TYPE_LONGLONG;
+		parameters[i + 1].buffer_length = sizeof(uint64_t);
+		parameters[i + 1].buffer = &(batch[i]);
+		parameters[i + 1].is_unsigned = true;
+	}
+
+	for (size_t position = 0; position < count; position += filled) {
+
+		filled = (count - position) > MAIL_REMOVE_BATCH_SIZE ? MAIL_REMOVE_BATCH_SIZE : (count - position);
+
+		for (size_t i = 0; i < MAIL_REMOVE_BATCH_SIZE; i++) {
+			batch[i] = numbers[position + (i < filled ? i : filled - 1)];
+		}
+
+		// Every message in the batch must be removed, or the quota adjustment below would be wrong.
+		if ((affected = stmt_exec_affected_conn(stmts.delete_messages, parameters, transaction)) != (int64_t)filled) {
+			log_error("Unable to delete the messages from Messages table. The user number was %lu, and %li of %zu messages were deleted.",
+					usernum, affected, filled);
+			return false;
+		}
+
+		deleted += filled;
+	}
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Message Size
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &size;
+	parameters[0].is_unsigned = true;
+
+	// Usernum
+	parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[1].buffer_length = sizeof(uint64_t);
+	parameters[1].buffer = &usernum;
+	parameters[1].is_unsigned = true;
+
+	// Update the Users table. The query also bumps the user's modification sequence, so the removal changes the HIGHESTMODSEQ value.
+	if ((affected = stmt_exec_affected_conn(stmts.update_user_quota_subtract, parameters, transaction)) == 0) {
+		log_error("Unable to update the Users table. The user number was %lu, %zu messages were deleted and their combined size was %lu.",
+				usernum, deleted, size);
+		return false;
+	}
+
+	return true;
+}
+
 /**
  * @brief	Update a mail message's parent folder in the database.
  * @brief	usernum			the numerical id of the user to whom the mail message belongs.
@@ -99,14 +181,19 @@ bool_t mail_db_delete_message(uint64_t usernum, uint64_t messagenum, uint32_t si
  */
 int_t mail_db_update_message_folder(uint64_t usernum, uint64_t messagenum, uint64_t source, uint64_t target, int64_t transaction) {
 
-	uint64_t result;
-	MYSQL_BIND parameters[4];
+	uint64_t result, modseq;
+	MYSQL_BIND parameters[5];
 
 	if (!usernum || !messagenum || !source || !target || transaction < 0) {
 		log_pedantic("Passed an invalid message parameter.");
 		return -1;
 	}
 
+	// Moving a message counts as a modification, so it gets a new modification sequence.
+	else if (!(modseq = meta_data_update_modseq(usernum, transaction))) {
+		return -1;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Target Folder
@@ -115,24 +202,30 @@ int_t mail_db_update_message_folder(uint64_t usernum, uint64_t messagenum, uint6
 	parameters[0].buffer = &target;
 	parameters[0].is_unsigned = true;
 
-	// Messagenum
+	// Modification Sequence
 	parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
 	parameters[1].buffer_length = sizeof(uint64_t);
-	parameters[1].buffer = &messagenum;
+	parameters[1].buffer = &modseq;
 	parameters[1].is_unsigned = true;
 
-	// Usernum
+	// Messagenum
 	parameters[2].buffer_type = MYSQL_TYPE_LONGLONG;
 	parameters[2].buffer_length = sizeof(uint64_t);
-	parameters[2].buffer = &usernum;
+	parameters[2].buffer = &messagenum;
 	parameters[2].is_unsigned = true;
 
-	// Source Folder
+	// Usernum
 	parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
 	parameters[3].buffer_length = sizeof(uint64_t);
-	parameters[3].buffer = &source;
+	parameters[3].buffer = &usernum;
 	parameters[3].is_unsigned = true;
 
+	// Source Folder
+	parameters[4].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[4].buffer_length = sizeof(uint64_t);
+	parameters[4].buffer = &source;
+	parameters[4].is_unsigned = true;
+
 	// Since the result is unsigned, an error is indicated by a return value of -1.
 	if ((result = stmt_exec_affected_conn(stmts.update_message_folder, parameters, transaction)) != 1 && result == -1) {
 		log_pedantic("An error occurred while trying to move a message into a different folder. { user = %lu / message = %lu / source = %lu / "
@@ -171,14 +264,19 @@ int_t mail_db_update_message_folder(uint64_t usernum, uint64_t messagenum, uint6
  */
 uint64_t mail_db_insert_message(uint64_t usernum, uint64_t foldernum, uint32_t status, uint32_t size, uint64_t signum, uint64_t sigkey, int_t transaction) {
 
-	uint64_t result;
-	MYSQL_BIND parameters[7];
+	uint64_t result, modseq;
+	MYSQL_BIND parameters[8];
 
 	if (!usernum || !foldernum || !size || transaction < 0) {
 		log_pedantic("Passed an invalid message parameter.");
 		return 0;
 	}
 
+	// New messages are assigned a modification sequence, so clients synchronizing with CHANGEDSINCE will pick them up.
+	else if (!(modseq = meta_data_update_modseq(usernum, transaction))) {
+		return 0;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum
@@ -234,6 +332,12 @@ uint64_t mail_db_insert_message(uint64_t usernum, uint64_t foldernum, uint32_t s
 		parameters[6].is_null = ISNULL(true);
 	}
 
+	// Modification Sequence
+	parameters[7].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[7].buffer_length = sizeof(uint64_t);
+	parameters[7].buffer = &modseq;
+	parameters[7].is_unsigned = true;
+
 	// Execute the insert.
 	if (!(result = stmt_insert_conn(stmts.insert_message, parameters, transaction))) {
 
@@ -303,14 +407,19 @@ uint64_t mail_db_insert_message(uint64_t usernum, uint64_t foldernum, uint32_t s
  */
 uint64_t mail_db_insert_duplicate_message(uint64_t usernum, uint64_t foldernum, uint32_t status, uint32_t size, uint64_t signum, uint64_t sigkey, uint64_t created, int_t transaction) {
 
-	uint64_t result;
-	MYSQL_BIND parameters[8];
+	uint64_t result, modseq;
+	MYSQL_BIND parameters[9];
 
 	if (!usernum || !foldernum || !size || transaction < 0) {
 		log_pedantic("Passed an invalid message parameter.");
 		return 0;
 	}
 
+	// New messages are assigned a modification sequence, so clients synchronizing with CHANGEDSINCE will pick them up.
+	else if (!(modseq = meta_data_update_modseq(usernum, transaction))) {
+		return 0;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum
@@ -366,12 +475,18 @@ uint64_t mail_db_insert_duplicate_message(uint64_t usernum, uint64_t foldernum,
 		parameters[6].is_null = ISNULL(true);
 	}
 
-	// Created
+	// Modification Sequence
 	parameters[7].buffer_type = MYSQL_TYPE_LONGLONG;
 	parameters[7].buffer_length = sizeof(uint64_t);
-	parameters[7].buffer = &created;
+	parameters[7].buffer = &modseq;
 	parameters[7].is_unsigned = true;
 
+	// Created
+	parameters[8].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[8].buffer_length = sizeof(uint64_t);
+	parameters[8].buffer = &created;
+	parameters[8].is_unsigned = true;
+
 	// Execute the insert.
 	if (!(result = stmt_insert_conn(stmts.insert_message_duplicate, parameters, transaction))) {
 
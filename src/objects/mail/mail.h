@@ -11,6 +11,9 @@
 #define MAIL_MIME_RECURSION_LIMIT 16
 #define MAIL_SIGNATURES_RECURSION_LIMIT 16
 
+// The number of messages deleted by each of the bulk delete statements. This must match the number of placeholders in the query.
+#define MAIL_REMOVE_BATCH_SIZE 64
+
 typedef struct {
 	uint64_t messagenum;
 	stringer_t *text;
@@ -33,6 +36,11 @@ typedef struct {
 	size_t header_length;
 } mail_message_t;
 
+typedef struct {
+	size_t count;
+	chr_t **paths;
+} mail_reclaim_t;
+
 typedef struct {
 	chr_t *extension;
 	bool_t bin;
@@ -58,6 +66,7 @@ size_t        mail_header_end(stringer_t *message);
 
 /// datatier.c
 bool_t        mail_db_delete_message(uint64_t usernum, uint64_t messagenum, uint32_t size, int_t transaction);
+bool_t        mail_db_delete_messages(uint64_t usernum, uint64_t *numbers, size_t count, uint64_t size, int_t transaction);
 void          mail_db_hide_message(uint64_t messagenum);
 uint64_t      mail_db_insert_duplicate_message(uint64_t usernum, uint64_t foldernum, uint32_t status, uint32_t size, uint64_t signum, uint64_t sigkey, uint64_t created, int_t transaction);
 uint64_t      mail_db_insert_message(uint64_t usernum, uint64_t foldernum, uint32_t status, uint32_t size, uint64_t signum, uint64_t sigkey, int_t transaction);
@@ -89,6 +98,7 @@ uint32_t       mail_mime_count(placer_t body, stringer_t *boundary);
 int_t          mail_mime_encoding(placer_t header);
 void           mail_mime_free(mail_mime_t *mime);
 placer_t       mail_mime_header(stringer_t *part);
+bool_t         mail_mime_leaves(mail_mime_t *mime, mail_mime_t **leaves, size_t limit, size_t *count);
 mail_mime_t *  mail_mime_part(stringer_t *part, uint32_t recursion);
 array_t *      mail_mime_split(placer_t body, stringer_t *boundary);
 int_t          mail_mime_type(placer_t header);
@@ -120,6 +130,9 @@ int_t        mail_path_finder(chr_t *string);
 
 /// remove_message.c
 bool_t        mail_remove_message(uint64_t usernum, uint64_t messagenum, uint32_t size, chr_t *server);
+bool_t        mail_remove_messages(uint64_t usernum, meta_message_t **messages, size_t count);
+void          mail_remove_reclaim(mail_reclaim_t *reclaim);
+void          mail_remove_reclaim_free(mail_reclaim_t *reclaim);
 
 /// signatures.c
 stringer_t *  mail_build_signature(server_t *server, int_t content_type, int_t content_encoding, uint64_t signum, uint64_t sigkey, int_t disposition);
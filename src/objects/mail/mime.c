@@ -909,6 +909,41 @@ void mail_mime_free(mail_mime_t *mime) {
 	return;
 }
 
+/**
+ * @brief	Collect the leaf parts of a mail mime object, in the order they appear in the message.
+ * @note	The leaf parts belong to the mime object, so they're only valid until it's freed. Leaves without a body are skipped.
+ * @param	mime	a pointer to the mail mime object to be searched.
+ * @param	leaves	an array which will receive a pointer to each leaf part.
+ * @param	limit	the number of entries in the leaves array.
+ * @param	count	a pointer to the number of entries already stored in the leaves array, which will be updated.
+ * @return	true on success, or false if the message has more leaf parts than the array can hold.
+ */
+bool_t mail_mime_leaves(mail_mime_t *mime, mail_mime_t **leaves, size_t limit, size_t *count) {
+
+	size_t elements;
+
+	if (!mime) {
+		return true;
+	}
+	else if (mime->children && (elements = ar_length_get(mime->children))) {
+		for (size_t i = 0; i < elements; i++) {
+			if (!mail_mime_leaves((mail_mime_t *)ar_field_ptr(mime->children, i), leaves, limit, count)) {
+				return false;
+			}
+		}
+	}
+	else if (!pl_empty(mime->body)) {
+
+		if (*count >= limit) {
+			return false;
+		}
+
+		leaves[(*count)++] = mime;
+	}
+
+	return true;
+}
+
 /**
  * @brief	Parse a block of data into a mail mime object.
  * @note	By parsing the specified mime part, this function fills in the content type and encoding of the resulting mail mime object.
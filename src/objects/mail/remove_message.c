@@ -57,3 +57,134 @@ bool_t mail_remove_message(uint64_t usernum, uint64_t messagenum, uint32_t size,
 	ns_free(path);
 	return true;
 }
+
+/**
+ * @brief	Free a reclamation job without unlinking any of its files.
+ * @param	reclaim		the reclamation job to be freed.
+ * @return	This function returns no value.
+ */
+void mail_remove_reclaim_free(mail_reclaim_t *reclaim) {
+
+	if (!reclaim) {
+		return;
+	}
+
+	for (size_t i = 0; i < reclaim->count; i++) {
+		ns_free(reclaim->paths[i]);
+	}
+
+	mm_free(reclaim->paths);
+	mm_free(reclaim);
+	return;
+}
+
+/**
+ * @brief	Unlink the files belonging to a collection of mail messages which have already been removed from the database.
+ * @note	This function is executed by the worker thread pool, so the bulk expunge operations don't have to wait on the file system.
+ * 			Any unlink errors are logged, and leave behind an orphaned file that will someday need to be cleaned.
+ * @param	reclaim		the reclamation job, which is freed by this function.
+ * @return	This function returns no value.
+ */
+void mail_remove_reclaim(mail_reclaim_t *reclaim) {
+
+	int_t state;
+
+	if (!reclaim) {
+		return;
+	}
+
+	for (size_t i = 0; i < reclaim->count; i++) {
+
+		if ((state = unlink(reclaim->paths[i])) != 0) {
+			log_pedantic("Could not unlink the message %s. {unlink = %i}", reclaim->paths[i], state);
+		}
+
+		ns_free(reclaim->paths[i]);
+	}
+
+	stats_adjust_by_name("objects.mail.reclaim.pending", -((int32_t)reclaim->count));
+
+	mm_free(reclaim->paths);
+	mm_free(reclaim);
+	return;
+}
+
+/**
+ * @brief	Remove a collection of mail messages from both the database and storage.
+ * @note	The database records are deleted, and the user quota adjusted, using a single transaction. The message files are then handed
+ * 			off to a background worker for reclamation, so the caller can release its locks without waiting on the file system. If the
+ * 			function fails, none of the messages were removed.
+ * @param	usernum		the user id to whom the specified mail messages belong.
+ * @param	messages	an array of pointers to the meta message structures describing the messages to be removed.
+ * @param	count		the number of messages in the array.
+ * @return	true if the messages were removed or false on failure.
+ */
+bool_t mail_remove_messages(uint64_t usernum, meta_message_t **messages, size_t count) {
+
+	int_t state;
+	uint64_t size = 0;
+	int64_t transaction;
+	uint64_t *numbers = NULL;
+	mail_reclaim_t *reclaim = NULL;
+
+	if (!usernum || !messages || !count) {
+		log_pedantic("Invalid parameters were passed to the bulk message removal function.");
+		return false;
+	}
+	else if (!(numbers = mm_alloc(count * sizeof(uint64_t))) || !(reclaim = mm_alloc(sizeof(mail_reclaim_t))) ||
+		!(reclaim->paths = mm_alloc(count * sizeof(chr_t *)))) {
+		log_pedantic("Unable to allocate memory for the bulk message removal.");
+		mm_cleanup(numbers, reclaim);
+		return false;
+	}
+
+	// Build the message paths up front, so a failure doesn't leave us with database records removed, and files we can't locate.
+	for (size_t i = 0; i < count; i++) {
+
+		if (!(reclaim->paths[i] = mail_message_path(messages[i]->messagenum, messages[i]->server))) {
+			reclaim->count = i;
+			mail_remove_reclaim_free(reclaim);
+			mm_free(numbers);
+			return false;
+		}
+
+		numbers[i] = messages[i]->messagenum;
+		size += messages[i]->size;
+	}
+
+	reclaim->count = count;
+
+	// We want to delete the messages as part of a single transaction.
+	if ((transaction = tran_start()) < 0) {
+		mail_remove_reclaim_free(reclaim);
+		mm_free(numbers);
+		return false;
+	}
+
+	// Remove from the database.
+	if (!mail_db_delete_messages(usernum, numbers, count, size, transaction)) {
+		tran_rollback(transaction);
+		mail_remove_reclaim_free(reclaim);
+		mm_free(numbers);
+		return false;
+	}
+
+	mm_free(numbers);
+
+	// Commit the transaction.
+	if ((state = tran_commit(transaction))) {
+		log_pedantic("Could not commit the transaction. {tran_commit = %i}", state);
+		mail_remove_reclaim_free(reclaim);
+		return false;
+	}
+
+	// The records are gone, so from here on the removal has succeeded, even if the files linger for a while. If the job can't be
+	// queued, the files are unlinked here instead, which also returns the pending count to where it was.
+	stats_adjust_by_name("objects.mail.reclaim.pending", count);
+
+	if (!enqueue(&mail_remove_reclaim, reclaim)) {
+		mail_remove_reclaim(reclaim);
+	}
+
+	return true;
+}
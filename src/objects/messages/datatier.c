@@ -15,13 +15,18 @@
  */
 bool_t meta_data_fetch_folder_messages(uint64_t usernum, message_folder_t *folder) {
 
-	row_t *row;
-	table_t *result;
+	int_t ret;
 	message_t *record;
-	MYSQL_BIND parameters[2];
+	stmt_cursor_t stream;
+	MYSQL_BIND parameters[2], results[7];
+	chr_t server[33];
+	unsigned long server_length = 0;
+	uint32_t status = 0, size = 0;
+	uint64_t messagenum = 0, created = 0, signum = 0, sigkey = 0;
 	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
 
 	mm_wipe(parameters, sizeof(parameters));
+	mm_wipe(results, sizeof(results));
 
 	if (!usernum || !folder || !folder->foldernum) {
 		log_pedantic("Invalid data passed for message fetch.");
@@ -40,32 +45,65 @@ bool_t meta_data_fetch_folder_messages(uint64_t usernum, message_folder_t *folde
 	parameters[1].buffer = &(folder->foldernum);
 	parameters[1].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_message_folder, parameters))) {
+	results[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[0].buffer_length = sizeof(uint64_t);
+	results[0].buffer = &messagenum;
+	results[0].is_unsigned = true;
+
+	results[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[1].buffer_length = sizeof(uint64_t);
+	results[1].buffer = &created;
+	results[1].is_unsigned = true;
+
+	results[2].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[2].buffer_length = sizeof(uint64_t);
+	results[2].buffer = &signum;
+	results[2].is_unsigned = true;
+
+	results[3].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[3].buffer_length = sizeof(uint64_t);
+	results[3].buffer = &sigkey;
+	results[3].is_unsigned = true;
+
+	results[4].buffer_type = MYSQL_TYPE_LONG;
+	results[4].buffer_length = sizeof(uint32_t);
+	results[4].buffer = &status;
+	results[4].is_unsigned = true;
+
+	results[5].buffer_type = MYSQL_TYPE_STRING;
+	results[5].buffer_length = sizeof(server) - 1;
+	results[5].buffer = server;
+	results[5].length = &server_length;
+
+	results[6].buffer_type = MYSQL_TYPE_LONG;
+	results[6].buffer_length = sizeof(uint32_t);
+	results[6].buffer = &size;
+	results[6].is_unsigned = true;
+
+	if (!stmt_stream_user(&stream, stmts.select_message_folder, parameters, results, usernum)) {
 		log_pedantic("Unable to fetch the folder messages.");
 		return false;
 	}
 
 	// Loop through each of the row and create a message record.
-	while ((row = res_row_next(result))) {
+	while ((ret = stmt_fetch_next(&stream)) == 1) {
 
-		if (!(record = message_alloc(res_field_uint64(row, 0), res_field_uint64(row, 1), res_field_uint64(row, 2),
-			res_field_uint64(row, 3), res_field_uint32(row, 4), PLACER(res_field_block(row, 5),
-			res_field_length(row, 5)), res_field_uint32(row, 6))) || !(key.val.u64 = record->message.num) ||
-			!inx_append(folder->records, key, record)) {
+		if (!(record = message_alloc(messagenum, created, signum, sigkey, status, PLACER(server, server_length), size)) ||
+			!(key.val.u64 = record->message.num) || !inx_append(folder->records, key, record)) {
 
 			log_error("The messages index refused to accept a metadata record. { usernum = %lu / message = %lu }",
-				usernum, res_field_uint64(row, 0));
+				usernum, messagenum);
 
 			if (record) message_free(record);
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
 	}
 
-	res_table_free(result);
+	stmt_stream_close(&stream);
 
-	return true;
+	return ret == 0 ? true : false;
 }
 
 /**
@@ -114,12 +152,16 @@ void meta_data_fetch_message_tags(meta_message_t *message) {
  */
 bool_t meta_data_fetch_messages(meta_user_t *user) {
 
-	row_t *row;
+	int_t ret;
 	multi_t key;
-	table_t *result;
 	inx_cursor_t *cursor;
-	MYSQL_BIND parameters[1];
+	stmt_cursor_t stream;
 	meta_message_t *message;
+	MYSQL_BIND parameters[1], results[9];
+	chr_t server[33];
+	unsigned long server_length = 0;
+	uint32_t status = 0, size = 0;
+	uint64_t messagenum = 0, foldernum = 0, signum = 0, sigkey = 0, created = 0, modseq = 0;
 
 	// Sanity check.
 	if (!user || !user->usernum) {
@@ -138,7 +180,12 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 		return false;
 	}
 
+	// We read the modification sequence counter before the messages, so a change committed in between the two queries can't
+	// push the counter past the message state we actually loaded.
+	user->modseq = meta_data_fetch_modseq(user->usernum);
+
 	mm_wipe(parameters, sizeof(parameters));
+	mm_wipe(results, sizeof(results));
 
 	// Usernum.
 	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
@@ -146,43 +193,81 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 	parameters[0].buffer = &(user->usernum);
 	parameters[0].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_messages, parameters))) {
+	// The rows are streamed into these buffers, so a large mailbox doesn't need to be copied into a result table first.
+	results[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[0].buffer_length = sizeof(uint64_t);
+	results[0].buffer = &messagenum;
+	results[0].is_unsigned = true;
+
+	results[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[1].buffer_length = sizeof(uint64_t);
+	results[1].buffer = &foldernum;
+	results[1].is_unsigned = true;
+
+	// We are using a fixed server name buffer of 33 bytes, so the server name must be 32 bytes or less. Longer names
+	// are reported as truncated by the fetch.
+	results[2].buffer_type = MYSQL_TYPE_STRING;
+	results[2].buffer_length = sizeof(server) - 1;
+	results[2].buffer = server;
+	results[2].length = &server_length;
+
+	results[3].buffer_type = MYSQL_TYPE_LONG;
+	results[3].buffer_length = sizeof(uint32_t);
+	results[3].buffer = &status;
+	results[3].is_unsigned = true;
+
+	results[4].buffer_type = MYSQL_TYPE_LONG;
+	results[4].buffer_length = sizeof(uint32_t);
+	results[4].buffer = &size;
+	results[4].is_unsigned = true;
+
+	results[5].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[5].buffer_length = sizeof(uint64_t);
+	results[5].buffer = &signum;
+	results[5].is_unsigned = true;
+
+	results[6].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[6].buffer_length = sizeof(uint64_t);
+	results[6].buffer = &sigkey;
+	results[6].is_unsigned = true;
+
+	results[7].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[7].buffer_length = sizeof(uint64_t);
+	results[7].buffer = &created;
+	results[7].is_unsigned = true;
+
+	results[8].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[8].buffer_length = sizeof(uint64_t);
+	results[8].buffer = &modseq;
+	results[8].is_unsigned = true;
+
+	if (!stmt_stream_user(&stream, stmts.select_messages, parameters, results, user->usernum)) {
 		return false;
 	}
-	else if (!(row = res_row_next(result))) {
-		res_table_free(result);
-		return true;
-	}
-
-	while (row) {
 
-		// We are using a fixed server name buffer of 33 bytes, so make sure the server name is 32 bytes or less.
-		if (res_field_length(row, 2) > 32) {
-			log_error("The server name found in the database was longer than 32 bytes. {usernum = %lu}", user->usernum);
-			res_table_free(result);
-			return false;
-		}
+	while ((ret = stmt_fetch_next(&stream)) == 1) {
 
-		else if (!(message = mm_alloc(sizeof(meta_message_t)))) {
+		if (!(message = mm_alloc(sizeof(meta_message_t)))) {
 			log_pedantic("Could not allocate %zu bytes to hold the message meta information.", sizeof(meta_message_t));
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
 		// Store the data.
-		message->messagenum = res_field_uint64(row, 0);
-		message->foldernum = res_field_uint64(row, 1);
-		mm_copy(message->server, res_field_block(row, 2), res_field_length(row, 2));
-		message->status = res_field_uint32(row, 3);
-		message->size = res_field_uint32(row, 4);
-		message->signum = res_field_uint64(row, 5);
-		message->sigkey = res_field_uint64(row, 6);
-		message->created = res_field_uint64(row, 7);
+		message->messagenum = messagenum;
+		message->foldernum = foldernum;
+		mm_copy(message->server, server, server_length);
+		message->status = status;
+		message->size = size;
+		message->signum = signum;
+		message->sigkey = sigkey;
+		message->created = created;
+		message->modseq = modseq;
 
 		if (!message->messagenum || !message->foldernum || !message->size || *(message->server) == '\0') {
 			log_error("One of the critical message variables was zero or NULL. {usernum = %lu}", user->usernum);
 			mm_free(message);
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
@@ -193,14 +278,18 @@ bool_t meta_data_fetch_messages(meta_user_t *user) {
 		if (!inx_append(user->messages, key, message)) {
 			log_error("Could not append the message to the linked list.");
 			mm_free(message);
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
-		row = res_row_next(result);
 	}
 
-	res_table_free(result);
+	stmt_stream_close(&stream);
+
+	if (ret < 0) {
+		log_error("Unable to fetch the messages. {usernum = %lu}", user->usernum);
+		return false;
+	}
 
 	if ((cursor = inx_cursor_alloc(user->messages))) {
 
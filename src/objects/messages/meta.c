@@ -139,6 +139,9 @@ bool_t meta_messages_login_update(meta_user_t *user, META_LOCK_STATUS locked) {
 	// This function will check if there is only one POP session.
 	if (user->refs.pop <= 1 && user->messages && (checkpoint = serial_get(OBJECT_MESSAGES, user->usernum)) != user->serials.messages) {
 
+		// The messages changed recently, so read them from the primary in case the replicas haven't caught up.
+		sql_replica_stamp(user->usernum);
+
 		if (!(user->serials.messages = checkpoint)) {
 			user->serials.messages = serial_increment(OBJECT_MESSAGES, user->usernum);
 		}
@@ -193,6 +196,9 @@ int_t meta_messages_update(meta_user_t *user, META_LOCK_STATUS locked) {
 	// If there are no POP sessions, the checkpoint is more than 60 seconds old, and the memcache checkpoint is newer, refresh.
 	if (!user->refs.pop && user->messages && (checkpoint = serial_get(OBJECT_MESSAGES, user->usernum)) != user->serials.messages) {
 
+		// The messages changed recently, so read them from the primary in case the replicas haven't caught up.
+		sql_replica_stamp(user->usernum);
+
 		if ((user->serials.messages = checkpoint) == 0) {
 			user->serials.messages = serial_increment(OBJECT_MESSAGES, user->usernum);
 		}
@@ -275,6 +281,7 @@ bool_t meta_messages_copier(meta_user_t *user, meta_message_t *message, uint64_t
 	}
 
 	*outnum = new->messagenum = key.val.u64;
+	new->modseq = meta_data_fetch_modseq(user->usernum);
 	new->foldernum = target;
 
 	// Messages added to a folder should be distinguished by having the recent flag.
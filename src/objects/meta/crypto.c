@@ -222,7 +222,7 @@ int_t meta_crypto_keys_create(uint64_t usernum, stringer_t *username, stringer_t
 	}
 
 	// If we're encrypting, add the encrypted flag to the message
-	if (do_encrypt && !message_encrypted && !(meta_data_flags_add(mholder, user->usernum, message->foldernum, MAIL_STATUS_ENCRYPTED))) {
+	if (do_encrypt && !message_encrypted && !(meta_data_flags_add(mholder, user->usernum, message->foldernum, MAIL_STATUS_ENCRYPTED, NULL))) {
 		log_pedantic("Unable to set encryption flag for message in database.");
 		ns_free(msgpath);
 		unlink(st_char_get(ftmpname));
@@ -230,7 +230,7 @@ int_t meta_crypto_keys_create(uint64_t usernum, stringer_t *username, stringer_t
 		tran_rollback(transaction);
 		return false;
 	// or if we're decrypting, remove the encrypted flag from the message.
-	} else if (!do_encrypt && message_encrypted && !(meta_data_flags_remove(mholder, user->usernum, message->foldernum, MAIL_STATUS_ENCRYPTED))) {
+	} else if (!do_encrypt && message_encrypted && !(meta_data_flags_remove(mholder, user->usernum, message->foldernum, MAIL_STATUS_ENCRYPTED, NULL))) {
 		log_pedantic("Unable to clear encryption flag for message in database.");
 		ns_free(msgpath);
 		unlink(st_char_get(ftmpname));
@@ -57,12 +57,16 @@ void meta_data_update_log(meta_user_t *user, META_PROTOCOL prot) {
  */
 bool_t meta_data_fetch_folders(meta_user_t *user) {
 
-	row_t *row;
+	int_t ret;
 	multi_t key;
-	table_t *result;
+	chr_t name[128];
+	stmt_cursor_t stream;
 	meta_folder_t *folder;
-	MYSQL_BIND parameters[2];
+	MYSQL_BIND parameters[2], results[4];
 	uint_t type = M_FOLDER_MESSAGES;
+	unsigned long name_length = 0;
+	uint32_t order = 0;
+	uint64_t foldernum = 0, parent = 0;
 
 	// Sanity check.
 	if (!user || !user->usernum) {
@@ -71,6 +75,7 @@ bool_t meta_data_fetch_folders(meta_user_t *user) {
 	}
 
 	mm_wipe(parameters, sizeof(parameters));
+	mm_wipe(results, sizeof(results));
 
 	// Usernum
 	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
@@ -84,12 +89,34 @@ bool_t meta_data_fetch_folders(meta_user_t *user) {
 	parameters[1].buffer = &(type);
 	parameters[1].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_folders, parameters))) {
+	results[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[0].buffer_length = sizeof(uint64_t);
+	results[0].buffer = &foldernum;
+	results[0].is_unsigned = true;
+
+	results[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	results[1].buffer_length = sizeof(uint64_t);
+	results[1].buffer = &parent;
+	results[1].is_unsigned = true;
+
+	results[2].buffer_type = MYSQL_TYPE_LONG;
+	results[2].buffer_length = sizeof(uint32_t);
+	results[2].buffer = &order;
+	results[2].is_unsigned = true;
+
+	// We are using a fixed folder name buffer of 128 bytes, so the folder name must be 127 bytes or less. Longer names are reported
+	// as truncated by the fetch. We limit names to only 16 characters, but with modified UTF-7 escaping we can end up with longer strings.
+	results[3].buffer_type = MYSQL_TYPE_STRING;
+	results[3].buffer_length = sizeof(name) - 1;
+	results[3].buffer = name;
+	results[3].length = &name_length;
+
+	if (!stmt_stream_user(&stream, stmts.select_folders, parameters, results, user->usernum)) {
 		return false;
 	}
-	else if (!(row = res_row_next(result))) {
-		res_table_free(result);
-		return true;
+	else if ((ret = stmt_fetch_next(&stream)) != 1) {
+		stmt_stream_close(&stream);
+		return ret == 0 ? true : false;
 	}
 
 	// If were updating, free the existing list of folders.
@@ -97,36 +124,28 @@ bool_t meta_data_fetch_folders(meta_user_t *user) {
 
 	if (!(user->folders = inx_alloc(M_INX_LINKED, &mm_free))) {
 		log_error("Could not create a linked list for the folders.");
-		res_table_free(result);
+		stmt_stream_close(&stream);
 		return false;
 	}
 
-	while (row) {
+	while (ret == 1) {
 
-		// We are using a fixed folder name buffer of 128 bytes, so make sure the folder name is 127 bytes or less.
-		// We limit names to only 16 characters, but with modified UTF-7 escaping we can end up with longer strings.
-		if (res_field_length(row, 3) > 127) {
-			log_error("The folder name found in the database was longer than 127 bytes. {usernum = %lu}", user->usernum);
-			res_table_free(result);
-			return false;
-		}
-
-		else if ((folder = mm_alloc(sizeof(meta_folder_t))) == NULL) {
+		if ((folder = mm_alloc(sizeof(meta_folder_t))) == NULL) {
 			log_pedantic("Could not allocate %zu bytes to hold the message meta information.", sizeof(meta_folder_t));
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
 		// Store the data.
-		folder->foldernum = res_field_uint64(row, 0);
-		folder->parent = res_field_uint64(row, 1);
-		folder->order = res_field_uint32(row, 2);
-		mm_copy(folder->name, res_field_block(row, 3), res_field_length(row, 3));
+		folder->foldernum = foldernum;
+		folder->parent = parent;
+		folder->order = order;
+		mm_copy(folder->name, name, name_length);
 
 		if (!folder->foldernum || *(folder->name) == '\0') {
 			log_error("One of the critical message variables was zero or NULL. {usernum = %lu}", user->usernum);
 			mm_free(folder);
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
@@ -137,16 +156,16 @@ bool_t meta_data_fetch_folders(meta_user_t *user) {
 		if (!inx_insert(user->folders, key, folder)) {
 			log_error("Could not append the folder to the linked list.");
 			mm_free(folder);
-			res_table_free(result);
+			stmt_stream_close(&stream);
 			return false;
 		}
 
-		row = res_row_next(result);
+		ret = stmt_fetch_next(&stream);
 	}
 
-	res_table_free(result);
+	stmt_stream_close(&stream);
 
-	return true;
+	return ret == 0 ? true : false;
 }
 
 /**
@@ -178,7 +197,7 @@ int_t meta_data_fetch_mailbox_aliases(meta_user_t *user) {
 	parameters[0].buffer = &(user->usernum);
 	parameters[0].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_mailbox_aliases, parameters))) {
+	if (!(result = stmt_get_result_user(stmts.select_mailbox_aliases, parameters, user->usernum))) {
 		return false;
 	}
 
@@ -242,7 +261,7 @@ int_t meta_data_fetch_user(meta_user_t *user) {
 	parameters[0].buffer = &(user->usernum);
 	parameters[0].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.meta_fetch_user, parameters))) {
+	if (!(result = stmt_get_result_user(stmts.meta_fetch_user, parameters, user->usernum))) {
 		return -1;
 	}
 	else if (!(row = res_row_next(result))) {
@@ -669,7 +688,7 @@ inx_t * meta_data_fetch_alerts(uint64_t usernum) {
 	parameters[0].buffer = &usernum;
 	parameters[0].is_unsigned = true;
 
-	if (!(result = stmt_get_result(stmts.select_alerts, parameters))) {
+	if (!(result = stmt_get_result_user(stmts.select_alerts, parameters, usernum))) {
 		return NULL;
 	}
 
@@ -698,227 +717,508 @@ inx_t * meta_data_fetch_alerts(uint64_t usernum) {
 	return alerts;
 }
 
+/**
+ * @brief	Fetch the highest modification sequence assigned to any of a user's mail messages.
+ *
+ * @param	usernum		the numerical id of the user whose modification sequence counter should be retrieved.
+ *
+ * @return	0 on failure, or the current value of the user's modification sequence counter on success.
+ */
+uint64_t meta_data_fetch_modseq(uint64_t usernum) {
+
+	row_t *row;
+	table_t *result;
+	uint64_t modseq = 0;
+	MYSQL_BIND parameters[1];
+
+	if (!usernum) {
+		log_pedantic("Invalid parameters passed to the modification sequence fetch function.");
+		return 0;
+	}
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Usernum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &usernum;
+	parameters[0].is_unsigned = true;
+
+	if (!(result = stmt_get_result_user(stmts.select_user_modseq, parameters, usernum))) {
+		return 0;
+	}
+	else if ((row = res_row_next(result))) {
+		modseq = res_field_uint64(row, 0);
+	}
+
+	res_table_free(result);
+	return modseq;
+}
+
+/**
+ * @brief	Increment a user's modification sequence counter, and return the new value.
+ *
+ * @note	The modification sequence is a per-user counter used by IMAP CONDSTORE/QRESYNC clients to discover which messages have
+ * 			changed since they last synchronized. Every value returned by this function is unique, and larger than any value previously
+ * 			returned for the same user.
+ *
+ * @param	usernum		the numerical id of the user whose modification sequence counter should be incremented.
+ * @param	transaction	the mysql transaction id for the update, or -1 if the update should be executed using any available connection.
+ *
+ * @return	0 on failure, or the newly allocated modification sequence on success.
+ */
+uint64_t meta_data_update_modseq(uint64_t usernum, int64_t transaction) {
+
+	uint64_t modseq;
+	MYSQL_BIND parameters[1];
+
+	if (!usernum) {
+		log_pedantic("Invalid parameters passed to the modification sequence update function.");
+		return 0;
+	}
+
+	mm_wipe(parameters, sizeof(parameters));
+
+	// Usernum
+	parameters[0].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[0].buffer_length = sizeof(uint64_t);
+	parameters[0].buffer = &usernum;
+	parameters[0].is_unsigned = true;
+
+	// The query stores the new value using LAST_INSERT_ID(), so it's returned to us just like an auto increment value would be.
+	if (transaction < 0) {
+		modseq = stmt_insert(stmts.update_user_modseq, parameters);
+	}
+	else {
+		modseq = stmt_insert_conn(stmts.update_user_modseq, parameters, transaction);
+	}
+
+	if (!modseq) {
+		log_pedantic("Unable to allocate a new modification sequence. { user = %lu }", usernum);
+	}
+
+	return modseq;
+}
+
+/**
+ * @brief	Apply a batched flag update statement to every message in a collection which resides in the target folder.
+ *
+ * @note	The message numbers are bound to the trailing META_FLAGS_BATCH_SIZE placeholders of the statement, and every batch is
+ * 			executed inside a single transaction, so a large update costs a handful of round trips and one commit. When the final batch
+ * 			is only partially filled, the unused placeholders repeat the last message number, which lets us reuse the prepared statement.
+ *
+ * @param	group		the batched flag update statement to be executed.
+ * @param	parameters	an array holding the fixed statement parameters, followed by META_FLAGS_BATCH_SIZE empty slots for the message numbers.
+ * @param	fixed		the number of fixed parameters at the front of the array.
+ * @param	messages	an inx holder containing the collection of messages to be updated.
+ * @param	usernum		the numerical id of the user to whom the target messages belong.
+ * @param	foldernum	the numerical id of the folder containing the messages to be updated.
+ * @param	modseq		a pointer to the modification sequence bound to the statement, which will be allocated inside the transaction, or
+ * 						NULL if the update shouldn't consume a modification sequence.
+ * @param	condition	if not NULL, the messages modified after condition->unchangedsince are locked and recorded inside the transaction,
+ * 						and removed from the messages collection once the update commits. The statement is expected to skip the same
+ * 						messages, by binding unchangedsince to its modseq comparison.
+ *
+ * @return	true on success or false on failure.
+ */
+bool_t meta_data_flags_batch(MYSQL_STMT **group, MYSQL_BIND *parameters, size_t fixed, inx_t *messages, uint64_t usernum, uint64_t foldernum, uint64_t *modseq,
+	meta_condition_t *condition) {
+
+	row_t *row;
+	table_t *result;
+	int64_t transaction;
+	inx_cursor_t *cursor;
+	meta_message_t *active;
+	size_t filled = 0, total = 0;
+	uint64_t numbers[META_FLAGS_BATCH_SIZE];
+	MYSQL_BIND check[3 + META_FLAGS_BATCH_SIZE];
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	if (!(cursor = inx_cursor_alloc(messages))) {
+		log_pedantic("Unable to allocate a cursor for the message flag update.");
+		return false;
+	}
+	else if ((transaction = tran_start()) < 0) {
+		log_pedantic("Unable to start a transaction for the message flag update.");
+		inx_cursor_free(cursor);
+		return false;
+	}
+	else if (modseq && !(*modseq = meta_data_update_modseq(usernum, transaction))) {
+		tran_rollback(transaction);
+		inx_cursor_free(cursor);
+		return false;
+	}
+
+	mm_wipe(check, sizeof(check));
+
+	for (size_t i = 0; i < META_FLAGS_BATCH_SIZE; i++) {
+
+		// Message Numbers
+		parameters[fixed + i].buffer_type = MYSQL_TYPE_LONGLONG;
+		parameters[fixed + i].buffer_length = sizeof(uint64_t);
+		parameters[fixed + i].buffer = &(numbers[i]);
+		parameters[fixed + i].is_unsigned = true;
+
+		check[3 + i] = parameters[fixed + i];
+	}
+
+	if (condition) {
+
+		condition->count = 0;
+
+		// Usernum
+		check[0].buffer_type = MYSQL_TYPE_LONGLONG;
+		check[0].buffer_length = sizeof(uint64_t);
+		check[0].buffer = &usernum;
+		check[0].is_unsigned = true;
+
+		// Foldernum
+		check[1].buffer_type = MYSQL_TYPE_LONGLONG;
+		check[1].buffer_length = sizeof(uint64_t);
+		check[1].buffer = &foldernum;
+		check[1].is_unsigned = true;
+
+		// Unchanged Since
+		check[2].buffer_type = MYSQL_TYPE_LONGLONG;
+		check[2].buffer_length = sizeof(uint64_t);
+		check[2].buffer = &(condition->unchangedsince);
+		check[2].is_unsigned = true;
+	}
+
+	do {
+
+		if ((active = inx_cursor_value_next(cursor)) && active->foldernum == foldernum) {
+			numbers[filled++] = active->messagenum;
+			total++;
+		}
+
+		// Execute the statement whenever the batch is full, or we've reached the end of the collection.
+		if (filled && (filled == META_FLAGS_BATCH_SIZE || !active)) {
+
+			for (size_t i = filled; i < META_FLAGS_BATCH_SIZE; i++) {
+				numbers[i] = numbers[filled - 1];
+			}
+
+			// The modified rows are locked until the commit, so the list of refused messages matches what the update skipped.
+			if (condition) {
+
+				if (!(result = stmt_get_result_conn(stmts.select_messages_modified, check, transaction))) {
+					log_pedantic("Unable to check the message modification sequences. { user = %lu / folder = %lu / messages = %zu }", usernum, foldernum, total);
+					tran_rollback(transaction);
+					inx_cursor_free(cursor);
+					return false;
+				}
+
+				while ((row = res_row_next(result)) && condition->count < total) {
+					condition->modified[condition->count++] = res_field_uint64(row, 0);
+				}
+
+				res_table_free(result);
+			}
+
+			if (!stmt_exec_conn(group, parameters, transaction)) {
+				log_pedantic("Unable to update the message flags. { user = %lu / folder = %lu / messages = %zu }", usernum, foldernum, total);
+				tran_rollback(transaction);
+				inx_cursor_free(cursor);
+				return false;
+			}
+
+			filled = 0;
+		}
+
+	} while (active);
+
+	inx_cursor_free(cursor);
+
+	// If none of the messages were in the target folder, the modification sequence is released by rolling back the transaction.
+	if (!total) {
+		tran_rollback(transaction);
+		if (modseq) {
+			*modseq = 0;
+		}
+	}
+	else if (tran_commit(transaction)) {
+		log_pedantic("Unable to commit the message flag update. { user = %lu / folder = %lu / messages = %zu }", usernum, foldernum, total);
+		return false;
+	}
+
+	// The refused messages are dropped from the collection, so the caller only updates the status of the messages which changed.
+	for (size_t i = 0; condition && i < condition->count; i++) {
+		key.val.u64 = condition->modified[i];
+		inx_delete(messages, key);
+	}
+
+	return true;
+}
+
 /**
  * @brief	Remove all user (non-system) flags from a collection of mail messages, and set the specified flags mask for them.
  *
  * @note	The new mask can contain both user and system flags, but only user flags will be stripped from each message initially.
+ * 			Messages whose status is actually altered are assigned a new modification sequence.
  *
  * @param	messages	an inx holder containing the collection of messages to have their flags updated.
  * @param	usernum		the numerical of the user to whom the target messages belong, for validation purposes.
  * @param	foldernum	the numerical id of the parent folder containing the messages to be updated, for validation purposes.
  * @param	flags		a mask of all flags that are to be added to any matching messages in the collection.
+ * @param	condition	if not NULL, only messages which haven't been modified since condition->unchangedsince are updated.
  *
  * @return	true on success or false on failure.
  */
-bool_t meta_data_flags_replace(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags) {
+bool_t meta_data_flags_replace(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, meta_condition_t *condition) {
 
 	inx_cursor_t *cursor;
 	meta_message_t *active;
-	MYSQL_BIND parameters[6];
+	MYSQL_BIND parameters[10 + META_FLAGS_BATCH_SIZE];
+	uint64_t modseq = 0, limit = condition ? condition->unchangedsince : UINT64_MAX;
 	uint32_t complete = MAIL_STATUS_USER_FLAGS;
-	bool_t result = true;
 
 	// Sanity check.
 	if (!messages || !usernum || !foldernum) {
 		return false;
 	}
 
-	// Iterate through and see if any messages have the recent flag set. Store the range.
-	if ((cursor = inx_cursor_alloc(messages))) {
+	mm_wipe(parameters, sizeof(parameters));
 
-		while ((active = inx_cursor_value_next(cursor))) {
+	// The modification sequence is only updated if the status is altered, so we need to bind the status
+	// parameters twice. Once for the comparison, and once for the actual update.
+	for (int_t i = 0; i < 7; i += 4) {
+
+		// Complete
+		parameters[i].buffer_type = MYSQL_TYPE_LONG;
+		parameters[i].buffer_length = sizeof(uint32_t);
+		parameters[i].buffer = &complete;
+		parameters[i].is_unsigned = true;
+
+		// Complete
+		parameters[i + 1].buffer_type = MYSQL_TYPE_LONG;
+		parameters[i + 1].buffer_length = sizeof(uint32_t);
+		parameters[i + 1].buffer = &complete;
+		parameters[i + 1].is_unsigned = true;
+
+		// Replacement Flags
+		parameters[i + 2].buffer_type = MYSQL_TYPE_LONG;
+		parameters[i + 2].buffer_length = sizeof(uint32_t);
+		parameters[i + 2].buffer = &flags;
+		parameters[i + 2].is_unsigned = true;
+	}
 
-			if (active->foldernum == foldernum) {
-
-				mm_wipe(parameters, sizeof(parameters));
-
-				// Complete
-				parameters[0].buffer_type = MYSQL_TYPE_LONG;
-				parameters[0].buffer_length = sizeof(uint32_t);
-				parameters[0].buffer = &complete;
-				parameters[0].is_unsigned = true;
-
-				// Complete
-				parameters[1].buffer_type = MYSQL_TYPE_LONG;
-				parameters[1].buffer_length = sizeof(uint32_t);
-				parameters[1].buffer = &complete;
-				parameters[1].is_unsigned = true;
-
-				// Replacement Flags
-				parameters[2].buffer_type = MYSQL_TYPE_LONG;
-				parameters[2].buffer_length = sizeof(uint32_t);
-				parameters[2].buffer = &flags;
-				parameters[2].is_unsigned = true;
-
-				// Usernum
-				parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[3].buffer_length = sizeof(uint64_t);
-				parameters[3].buffer = &usernum;
-				parameters[3].is_unsigned = true;
-
-				// Foldernum
-				parameters[4].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[4].buffer_length = sizeof(uint64_t);
-				parameters[4].buffer = &foldernum;
-				parameters[4].is_unsigned = true;
-
-				// Message Numbers
-				parameters[5].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[5].buffer_length = sizeof(uint64_t);
-				parameters[5].buffer = &(active->messagenum);
-				parameters[5].is_unsigned = true;
-
-				if (!stmt_exec(stmts.update_message_flags_replace, parameters)) {
-					log_pedantic("Message flag replace failed. { user = %lu / message = %lu / flags = %u }", usernum, active->messagenum, flags);
-					result = false;
-				}
+	// Modification Sequence
+	parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[3].buffer_length = sizeof(uint64_t);
+	parameters[3].buffer = &modseq;
+	parameters[3].is_unsigned = true;
+
+	// Usernum
+	parameters[7].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[7].buffer_length = sizeof(uint64_t);
+	parameters[7].buffer = &usernum;
+	parameters[7].is_unsigned = true;
+
+	// Foldernum
+	parameters[8].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[8].buffer_length = sizeof(uint64_t);
+	parameters[8].buffer = &foldernum;
+	parameters[8].is_unsigned = true;
+
+	// Unchanged Since
+	parameters[9].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[9].buffer_length = sizeof(uint64_t);
+	parameters[9].buffer = &limit;
+	parameters[9].is_unsigned = true;
+
+	if (!meta_data_flags_batch(stmts.update_message_flags_replace, parameters, 10, messages, usernum, foldernum, &modseq, condition)) {
+		log_pedantic("Message flag replace failed. { user = %lu / folder = %lu / flags = %u }", usernum, foldernum, flags);
+		return false;
+	}
+
+	// Record the new modification sequence for any message whose status will be altered.
+	if (modseq && (cursor = inx_cursor_alloc(messages))) {
 
+		while ((active = inx_cursor_value_next(cursor))) {
+			if (active->foldernum == foldernum && active->status != (((active->status | complete) ^ complete) | flags)) {
+				active->modseq = modseq;
 			}
 		}
 
 		inx_cursor_free(cursor);
 	}
 
-	return result;
+	return true;
 }
 
 /**
  * @brief	Remove the specified flags mask from a collection of mail messages.
  *
+ * @note	Messages whose status is actually altered are assigned a new modification sequence, unless the recent flag is the only
+ * 			flag being removed, since clients are never notified about changes to the recent flag.
+ *
  * @param	messages	an inx holder containing the collection of messages to have their flags removed.
  * @param	usernum		the numerical id of the user to whom the target messages belong, for validation purposes.
  * @param	foldernum	the numerical id of the parent folder containing the messages to be updated, for validation purposes.
  * @param	flags		a mask of all flags that are to be stripped from any matching messages in the collection.
+ * @param	condition	if not NULL, only messages which haven't been modified since condition->unchangedsince are updated.
  *
  * @return	true on success or false on failure.
  */
-bool_t meta_data_flags_remove(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags) {
+bool_t meta_data_flags_remove(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, meta_condition_t *condition) {
 
 	inx_cursor_t *cursor;
 	meta_message_t *active;
-	MYSQL_BIND parameters[5];
-	bool_t result = true;
+	MYSQL_BIND parameters[8 + META_FLAGS_BATCH_SIZE];
+	uint64_t modseq = 0, limit = condition ? condition->unchangedsince : UINT64_MAX;
 
 	// Sanity check.
 	if (!messages || !usernum || !foldernum) {
 		return false;
 	}
 
-	// Iterate through and see if any messages have the recent flag set. Store the range.
-	if ((cursor = inx_cursor_alloc(messages))) {
+	mm_wipe(parameters, sizeof(parameters));
 
-		while ((active = inx_cursor_value_next(cursor))) {
-			if (active->foldernum == foldernum) {
-
-				mm_wipe(parameters, sizeof(parameters));
-
-				// Flag to Remove
-				parameters[0].buffer_type = MYSQL_TYPE_LONG;
-				parameters[0].buffer_length = sizeof(uint32_t);
-				parameters[0].buffer = &flags;
-				parameters[0].is_unsigned = true;
-
-				// Flag to Remove
-				parameters[1].buffer_type = MYSQL_TYPE_LONG;
-				parameters[1].buffer_length = sizeof(uint32_t);
-				parameters[1].buffer = &flags;
-				parameters[1].is_unsigned = true;
-
-				// Usernum
-				parameters[2].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[2].buffer_length = sizeof(uint64_t);
-				parameters[2].buffer = &usernum;
-				parameters[2].is_unsigned = true;
-
-				// Foldernum
-				parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[3].buffer_length = sizeof(uint64_t);
-				parameters[3].buffer = &foldernum;
-				parameters[3].is_unsigned = true;
-
-				// Message Numbers
-				parameters[4].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[4].buffer_length =  sizeof(uint64_t);
-				parameters[4].buffer = &(active->messagenum);
-				parameters[4].is_unsigned = true;
-
-				if (!stmt_exec(stmts.update_message_flags_remove, parameters)) {
-					log_pedantic("Message flag removal failed. { user = %lu / message = %lu / flags = %u }", usernum, active->messagenum, flags);
-					result = false;
-				}
+	// The modification sequence is only updated if the status is altered, so we need to bind the status
+	// parameters twice. Once for the comparison, and once for the actual update.
+	for (int_t i = 0; i < 4; i += 3) {
+
+		// Flag to Remove
+		parameters[i].buffer_type = MYSQL_TYPE_LONG;
+		parameters[i].buffer_length = sizeof(uint32_t);
+		parameters[i].buffer = &flags;
+		parameters[i].is_unsigned = true;
+
+		// Flag to Remove
+		parameters[i + 1].buffer_type = MYSQL_TYPE_LONG;
+		parameters[i + 1].buffer_length = sizeof(uint32_t);
+		parameters[i + 1].buffer = &flags;
+		parameters[i + 1].is_unsigned = true;
+	}
+
+	// Modification Sequence
+	parameters[2].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[2].buffer_length = sizeof(uint64_t);
+	parameters[2].buffer = &modseq;
+	parameters[2].is_unsigned = true;
 
+	// Usernum
+	parameters[5].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[5].buffer_length = sizeof(uint64_t);
+	parameters[5].buffer = &usernum;
+	parameters[5].is_unsigned = true;
+
+	// Foldernum
+	parameters[6].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[6].buffer_length = sizeof(uint64_t);
+	parameters[6].buffer = &foldernum;
+	parameters[6].is_unsigned = true;
+
+	// Unchanged Since
+	parameters[7].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[7].buffer_length = sizeof(uint64_t);
+	parameters[7].buffer = &limit;
+	parameters[7].is_unsigned = true;
+
+	// Removing the recent flag doesn't consume a modification sequence, because we don't want every SELECT command to invalidate a client's cache.
+	if (!meta_data_flags_batch(stmts.update_message_flags_remove, parameters, 8, messages, usernum, foldernum,
+		(flags | MAIL_STATUS_RECENT) != MAIL_STATUS_RECENT ? &modseq : NULL, condition)) {
+		log_pedantic("Message flag removal failed. { user = %lu / folder = %lu / flags = %u }", usernum, foldernum, flags);
+		return false;
+	}
+
+	// Record the new modification sequence for any message whose status will be altered.
+	if (modseq && (cursor = inx_cursor_alloc(messages))) {
+
+		while ((active = inx_cursor_value_next(cursor))) {
+			if (active->foldernum == foldernum && (active->status & flags) != 0) {
+				active->modseq = modseq;
 			}
 		}
 
 		inx_cursor_free(cursor);
 	}
 
-	return result;
+	return true;
 }
 
 /**
  * @brief	Add the specified flags mask to a collection of mail messages.
  *
+ * @note	Messages whose status is actually altered are assigned a new modification sequence.
+ *
  * @param	messages	an inx holder containing the collection of messages to have their flags updated.
  * @param	usernum		the numerical id of the user to whom the target messages belong, for validation purposes.
  * @param	foldernum	the numerical id of the parent folder containing the messages to be updated, for validation purposes.
  * @param	flags		a mask of all flags that are to be added to any matching messages in the collection.
+ * @param	condition	if not NULL, only messages which haven't been modified since condition->unchangedsince are updated.
  *
  * @return	true on success or false on failure.
  */
-bool_t meta_data_flags_add(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags) {
+bool_t meta_data_flags_add(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, meta_condition_t *condition) {
 
 	inx_cursor_t *cursor;
 	meta_message_t *active;
-	MYSQL_BIND parameters[4];
-	bool_t result = true;
+	MYSQL_BIND parameters[6 + META_FLAGS_BATCH_SIZE];
+	uint64_t modseq = 0, limit = condition ? condition->unchangedsince : UINT64_MAX;
 
 	// Sanity check.
 	if (!messages || !usernum || !foldernum) {
 		return false;
 	}
 
-	// Iterate through and see if any messages have the recent flag set. Store the range.
-	if ((cursor = inx_cursor_alloc(messages))) {
+	mm_wipe(parameters, sizeof(parameters));
 
-		while ((active = inx_cursor_value_next(cursor))) {
-				mm_wipe(parameters, sizeof(parameters));
-
-				// Flag to Add
-				parameters[0].buffer_type = MYSQL_TYPE_LONG;
-				parameters[0].buffer_length = sizeof(uint32_t);
-				parameters[0].buffer = &flags;
-				parameters[0].is_unsigned = true;
-
-				// Usernum
-				parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[1].buffer_length = sizeof(uint64_t);
-				parameters[1].buffer = &usernum;
-				parameters[1].is_unsigned = true;
-
-				// Foldernum
-				parameters[2].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[2].buffer_length = sizeof(uint64_t);
-				parameters[2].buffer = &foldernum;
-				parameters[2].is_unsigned = true;
-
-				// Message Numbers
-				parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
-				parameters[3].buffer_length = sizeof(uint64_t);
-				parameters[3].buffer = &(active->messagenum);
-				parameters[3].is_unsigned = true;
-
-				if (!stmt_exec(stmts.update_message_flags_add, parameters)) {
-					log_pedantic("Message flag addition failed. { user = %lu / message = %lu / flags = %u }", usernum, active->messagenum, flags);
-					result = false;
-				}
+	// Flag to Add
+	parameters[0].buffer_type = MYSQL_TYPE_LONG;
+	parameters[0].buffer_length = sizeof(uint32_t);
+	parameters[0].buffer = &flags;
+	parameters[0].is_unsigned = true;
 
+	// Modification Sequence
+	parameters[1].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[1].buffer_length = sizeof(uint64_t);
+	parameters[1].buffer = &modseq;
+	parameters[1].is_unsigned = true;
+
+	// Flag to Add
+	parameters[2].buffer_type = MYSQL_TYPE_LONG;
+	parameters[2].buffer_length = sizeof(uint32_t);
+	parameters[2].buffer = &flags;
+	parameters[2].is_unsigned = true;
+
+	// Usernum
+	parameters[3].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[3].buffer_length = sizeof(uint64_t);
+	parameters[3].buffer = &usernum;
+	parameters[3].is_unsigned = true;
+
+	// Foldernum
+	parameters[4].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[4].buffer_length = sizeof(uint64_t);
+	parameters[4].buffer = &foldernum;
+	parameters[4].is_unsigned = true;
+
+	// Unchanged Since
+	parameters[5].buffer_type = MYSQL_TYPE_LONGLONG;
+	parameters[5].buffer_length = sizeof(uint64_t);
+	parameters[5].buffer = &limit;
+	parameters[5].is_unsigned = true;
+
+	if (!meta_data_flags_batch(stmts.update_message_flags_add, parameters, 6, messages, usernum, foldernum, &modseq, condition)) {
+		log_pedantic("Message flag addition failed. { user = %lu / folder = %lu / flags = %u }", usernum, foldernum, flags);
+		return false;
+	}
+
+	// Record the new modification sequence for any message whose status will be altered.
+	if (modseq && (cursor = inx_cursor_alloc(messages))) {
+
+		while ((active = inx_cursor_value_next(cursor))) {
+			if (active->foldernum == foldernum && (active->status & flags) != flags) {
+				active->modseq = modseq;
 			}
+		}
 
 		inx_cursor_free(cursor);
 	}
 
-	return result;
+	return true;
 }
 
 /**
@@ -18,6 +18,8 @@ void meta_free(meta_user_t *user) {
 
 	if (user) {
 
+		obj_idle_remove(&(objects.idle.meta), &(user->idle));
+
 		prime_cleanup(user->prime.key);
 		prime_cleanup(user->prime.signet);
 
@@ -128,6 +130,9 @@ int_t meta_get(uint64_t usernum, stringer_t *username, stringer_t *salt, stringe
 
 	meta_user_wlock(user);
 
+	// Several serial numbers are about to be checked, so we load them with a single cache request.
+	serial_prefetch(usernum);
+
 	// Pull the user information.
 	if ((state = meta_update_user(user, META_LOCKED)) < 0) {
 		meta_user_unlock(user);
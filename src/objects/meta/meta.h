@@ -8,6 +8,9 @@
 #ifndef MAGMA_OBJECTS_META_H
 #define MAGMA_OBJECTS_META_H
 
+// The number of messages updated by each of the batched flag update statements. This must match the number of placeholders in the queries.
+#define META_FLAGS_BATCH_SIZE 64
+
 typedef struct {
 	stringer_t *public;
 	stringer_t *private;
@@ -18,6 +21,14 @@ typedef struct {
 	stringer_t *tag;
 } meta_stats_tag_t;
 
+// A conditional flag update only touches messages whose modification sequence hasn't moved past unchangedsince. The numbers of the
+// messages which were refused are written to the modified array, which must have room for every message in the update.
+typedef struct {
+	size_t count;
+	uint64_t *modified;
+	uint64_t unchangedsince;
+} meta_condition_t;
+
 /// alerts.c
 meta_alert_t * alert_alloc(uint64_t alertnum, stringer_t *type, stringer_t *message, uint64_t created);
 
@@ -64,11 +75,13 @@ inx_t *    meta_data_fetch_all_tags(uint64_t usernum);
 bool_t     meta_data_fetch_folders(meta_user_t *user);
 int_t      meta_data_fetch_keys(meta_user_t *user, key_pair_t *output, int64_t transaction);
 int_t      meta_data_fetch_mailbox_aliases(meta_user_t *user);
+uint64_t   meta_data_fetch_modseq(uint64_t usernum);
 int_t      meta_data_fetch_shard(uint64_t usernum, uint16_t serial, stringer_t *label, stringer_t *output, uint_t *rotated, int64_t transaction);
 int_t      meta_data_fetch_user(meta_user_t *user);
-bool_t     meta_data_flags_add(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags);
-bool_t     meta_data_flags_remove(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags);
-bool_t     meta_data_flags_replace(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags);
+bool_t     meta_data_flags_add(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, meta_condition_t *condition);
+bool_t     meta_data_flags_batch(MYSQL_STMT **group, MYSQL_BIND *parameters, size_t fixed, inx_t *messages, uint64_t usernum, uint64_t foldernum, uint64_t *modseq, meta_condition_t *condition);
+bool_t     meta_data_flags_remove(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, meta_condition_t *condition);
+bool_t     meta_data_flags_replace(inx_t *messages, uint64_t usernum, uint64_t foldernum, uint32_t flags, meta_condition_t *condition);
 uint64_t   meta_data_insert_folder(uint64_t usernum, stringer_t *name, uint64_t parent, uint32_t order);
 int_t      meta_data_insert_keys(uint64_t usernum, stringer_t *username, key_pair_t *input, int64_t transaction);
 int_t      meta_data_insert_shard(uint64_t usernum, uint16_t serial, stringer_t *label, stringer_t *shard, int64_t transaction);
@@ -77,6 +90,7 @@ int_t      meta_data_truncate_tags(meta_message_t *message);
 uint64_t   meta_data_update_folder_name(uint64_t usernum, uint64_t foldernum, stringer_t *name, uint64_t parent, uint32_t order);
 void       meta_data_update_lock(uint64_t usernum, uint8_t lock);
 void       meta_data_update_log(meta_user_t *user, META_PROTOCOL prot);
+uint64_t   meta_data_update_modseq(uint64_t usernum, int64_t transaction);
 
 /// locking.c
 void   meta_user_rlock(meta_user_t *user);
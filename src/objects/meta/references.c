@@ -59,6 +59,8 @@ void meta_user_ref_add(meta_user_t *user, META_PROTOCOL protocol) {
  */
 void meta_user_ref_dec(meta_user_t *user, META_PROTOCOL protocol) {
 
+	bool_t idle = false;
+
 	if (user) {
 
 		// Acquire the reference counter lock.
@@ -79,9 +81,16 @@ void meta_user_ref_dec(meta_user_t *user, META_PROTOCOL protocol) {
 		// Update the activity time stamp.
 		user->refs.stamp = time(NULL);
 
+		idle = !(user->refs.web + user->refs.imap + user->refs.pop + user->refs.smtp + user->refs.generic);
+
 		// Release the reference counter lock.
 		mutex_unlock(&(user->refs.lock));
 
+		// Once the last reference is released, queue the object so the prune function can find it.
+		if (idle) {
+			obj_idle_push(&(objects.idle.meta), &(user->idle), user, user->usernum);
+		}
+
 	}
 
 	return;
@@ -230,9 +230,14 @@ int_t meta_update_user(meta_user_t *user, META_LOCK_STATUS locked) {
 		if ((serial = serial_get(OBJECT_USER, user->usernum)) == meta_user_serial_get(user, OBJECT_USER)) {
 			result = 1;
 		}
-		// If the serial numbers don't match, then refresh the stored data and update the object serial number.
-		else if (!(result = meta_data_fetch_user(user))) {
-			meta_user_serial_set(user, OBJECT_USER, serial);
+		// If the serial numbers don't match, then refresh the stored data from the primary and update the object serial number.
+		else {
+
+			sql_replica_stamp(user->usernum);
+
+			if (!(result = meta_data_fetch_user(user))) {
+				meta_user_serial_set(user, OBJECT_USER, serial);
+			}
 		}
 
 	}
@@ -280,9 +285,14 @@ int_t meta_update_aliases(meta_user_t *user, META_LOCK_STATUS locked) {
 		if ((serial = serial_get(OBJECT_ALIASES, user->usernum)) == meta_user_serial_get(user, OBJECT_ALIASES)) {
 			result = 1;
 		}
-		// If the serial numbers don't match, then refresh the stored data and update the object serial number.
-		else if (!(result = meta_data_fetch_mailbox_aliases(user))) {
-			meta_user_serial_set(user, OBJECT_ALIASES, serial);
+		// If the serial numbers don't match, then refresh the stored data from the primary and update the object serial number.
+		else {
+
+			sql_replica_stamp(user->usernum);
+
+			if (!(result = meta_data_fetch_mailbox_aliases(user))) {
+				meta_user_serial_set(user, OBJECT_ALIASES, serial);
+			}
 		}
 
 	}
@@ -325,6 +335,9 @@ int_t meta_update_contacts(meta_user_t *user, META_LOCK_STATUS locked) {
 	// If there is a contacts already available, use the serial number to see if it needs updating.
 	if (user->contacts && (checkpoint = serial_get(OBJECT_CONTACTS, user->usernum)) != user->serials.contacts) {
 
+		// The contacts changed recently, so read them from the primary in case the replicas haven't caught up.
+		sql_replica_stamp(user->usernum);
+
 		if (!(user->serials.contacts = checkpoint)) {
 			user->serials.contacts = serial_increment(OBJECT_CONTACTS, user->usernum);
 		}
@@ -380,6 +393,9 @@ int_t meta_update_folders(meta_user_t *user, META_LOCK_STATUS locked) {
 
 	if (!user->refs.pop && user->folders && (checkpoint = serial_get(OBJECT_FOLDERS, user->usernum)) != user->serials.folders) {
 
+		// The folders changed recently, so read them from the primary in case the replicas haven't caught up.
+		sql_replica_stamp(user->usernum);
+
 		if ((user->serials.folders = checkpoint) == 0) {
 			user->serials.folders = serial_increment(OBJECT_FOLDERS, user->usernum);
 		}
@@ -434,6 +450,9 @@ int_t meta_update_message_folders(meta_user_t *user, META_LOCK_STATUS locked) {
 	// If there is a message folder index already available, use the serial number to see if it needs updating.
 	if (user->message_folders && (checkpoint = serial_get(OBJECT_FOLDERS, user->usernum)) != user->serials.folders) {
 
+		// The folders changed recently, so read them from the primary in case the replicas haven't caught up.
+		sql_replica_stamp(user->usernum);
+
 		if (!(user->serials.folders = checkpoint)) {
 			user->serials.folders = serial_increment(OBJECT_FOLDERS, user->usernum);
 		}
@@ -0,0 +1,129 @@
+
+/**
+ * @file /magma/objects/notify.c
+ *
+ * @brief	An in-process notification hub used to alert local listeners when the objects belonging to a user are modified.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Register a listener which will be called whenever a change is published for the specified user.
+ * @note	The callback is executed by the thread responsible for the modification, while the listener index is locked, so it
+ * 			must return quickly and must never block, or attempt to subscribe/unsubscribe another listener.
+ * @param	usernum		the numerical id of the user whose objects should be monitored.
+ * @param	callback	the function to be called with the listener data, user number and object type for every published change.
+ * @param	data		an opaque pointer which will be passed along to the callback.
+ * @return	NULL on failure, or a pointer to the new listener, which must be released using notify_unsubscribe().
+ */
+notify_listener_t * notify_subscribe(uint64_t usernum, void (*callback)(void *data, uint64_t usernum, uint64_t object), void *data) {
+
+	notify_listener_t *listener, *head;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = usernum };
+
+	if (!usernum || !callback || !objects.listeners) {
+		log_pedantic("Invalid parameters were passed to the notification hub.");
+		return NULL;
+	}
+	else if (!(listener = mm_alloc(sizeof(notify_listener_t)))) {
+		log_pedantic("Unable to allocate memory for a notification listener.");
+		return NULL;
+	}
+
+	listener->usernum = usernum;
+	listener->callback = callback;
+	listener->data = data;
+	listener->next = NULL;
+
+	inx_lock_write(objects.listeners);
+
+	// If the user already has listeners, we link the new listener in after the head of the chain so the index key can stay put.
+	if ((head = inx_find(objects.listeners, key))) {
+		listener->next = head->next;
+		head->next = (struct notify_listener_t *)listener;
+	}
+	else if (!inx_insert(objects.listeners, key, listener)) {
+		inx_unlock(objects.listeners);
+		log_pedantic("Unable to add the notification listener to the index. { usernum = %lu }", usernum);
+		mm_free(listener);
+		return NULL;
+	}
+
+	inx_unlock(objects.listeners);
+
+	return listener;
+}
+
+/**
+ * @brief	Remove a listener from the notification hub and free it.
+ * @note	Once this function returns the listener callback is guaranteed not to be running, and will never be called again.
+ * @param	listener	the listener returned by notify_subscribe().
+ * @return	This function returns no value.
+ */
+void notify_unsubscribe(notify_listener_t *listener) {
+
+	notify_listener_t *head, *active;
+	multi_t key = { .type = M_TYPE_UINT64 };
+
+	if (!listener || !objects.listeners) {
+		return;
+	}
+
+	key.val.u64 = listener->usernum;
+	inx_lock_write(objects.listeners);
+
+	if ((head = inx_find(objects.listeners, key)) == listener) {
+
+		// Promote the next listener in the chain, or remove the user from the index if this was the only listener.
+		if (listener->next) {
+			inx_replace(objects.listeners, key, listener->next);
+		}
+		else {
+			inx_delete(objects.listeners, key);
+		}
+
+	}
+	else if ((active = head)) {
+
+		while (active->next && (notify_listener_t *)active->next != listener) {
+			active = (notify_listener_t *)active->next;
+		}
+
+		if (active->next) {
+			active->next = listener->next;
+		}
+	}
+
+	inx_unlock(objects.listeners);
+	mm_free(listener);
+
+	return;
+}
+
+/**
+ * @brief	Alert any local listeners that an object belonging to the specified user has been modified.
+ * @note	This only reaches listeners inside the current process. Listeners interested in changes made by other cluster nodes
+ * 			must still check the cached serial numbers periodically.
+ * @param	usernum		the numerical id of the user who owns the modified object.
+ * @param	object		the type of object which was modified (OBJECT_USER, OBJECT_FOLDERS, OBJECT_MESSAGES, etc).
+ * @return	This function returns no value.
+ */
+void notify_publish(uint64_t usernum, uint64_t object) {
+
+	notify_listener_t *active;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = usernum };
+
+	if (!usernum || !objects.listeners) {
+		return;
+	}
+
+	inx_lock_read(objects.listeners);
+
+	for (active = inx_find(objects.listeners, key); active; active = (notify_listener_t *)active->next) {
+		active->callback(active->data, usernum, object);
+	}
+
+	inx_unlock(objects.listeners);
+
+	return;
+}
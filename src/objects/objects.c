@@ -9,11 +9,16 @@
 
 object_cache_t objects = {
 	.meta = NULL,
-	.sessions = NULL
+	.sessions = NULL,
+	.listeners = NULL,
+	.idle = {
+		.meta = { .head = NULL, .tail = NULL, .lock = PTHREAD_MUTEX_INITIALIZER },
+		.sessions = { .head = NULL, .tail = NULL, .lock = PTHREAD_MUTEX_INITIALIZER }
+	}
 };
 
 /**
- * @brief	Initialize the object cache for all active user objects and web sessions.
+ * @brief	Initialize the object cache for all active user objects and web sessions, along with the change notification listeners.
  * @return	true on success or false on failure.
  */
 bool_t obj_cache_start(void) {
@@ -28,6 +33,12 @@ bool_t obj_cache_start(void) {
 		return false;
 	}
 
+	// The listeners are owned by their subscribers, so the index doesn't free them.
+	if (!(objects.listeners = inx_alloc(M_INX_TREE | M_INX_LOCK_MANUAL, NULL))) {
+		log_critical("Unable to initialize the change notification listeners.");
+		return false;
+	}
+
 	return true;
 }
 
@@ -48,35 +59,175 @@ void obj_cache_stop(void) {
 		objects.meta = NULL;
 	}
 
+	if (objects.listeners) {
+		inx_free(objects.listeners);
+		objects.listeners = NULL;
+	}
+
+
+	return;
+}
+
+/**
+ * @brief	Remove an object from an idle queue.
+ * @note	The caller must hold the queue lock.
+ * @param	queue	the idle queue holding the object.
+ * @param	link	the idle queue link embedded in the object.
+ * @return	This function returns no value.
+ */
+void obj_idle_unlink(object_queue_t *queue, object_idle_t *link) {
+
+	if (!link->linked) {
+		return;
+	}
+
+	if (link->prev) link->prev->next = link->next;
+	else queue->head = link->next;
+
+	if (link->next) link->next->prev = link->prev;
+	else queue->tail = link->prev;
+
+	link->prev = link->next = NULL;
+	link->linked = false;
+
+	return;
+}
+
+/**
+ * @brief	Queue an object which has just become idle, moving it to the end of the queue if it was already queued.
+ * @note	This function is called after an object's last reference is released, and must not be called while holding the
+ * 			object's reference lock.
+ * @param	queue	the idle queue for the cache holding the object.
+ * @param	link	the idle queue link embedded in the object.
+ * @param	object	a pointer to the object.
+ * @param	key		the numeric key used to locate the object in the cache.
+ * @return	This function returns no value.
+ */
+void obj_idle_push(object_queue_t *queue, object_idle_t *link, void *object, uint64_t key) {
+
+	mutex_lock(&(queue->lock));
+
+	obj_idle_unlink(queue, link);
+
+	link->key = key;
+	link->object = object;
+	link->prev = queue->tail;
+	link->next = NULL;
+	link->linked = true;
+
+	if (queue->tail) queue->tail->next = link;
+	else queue->head = link;
+
+	queue->tail = link;
+
+	mutex_unlock(&(queue->lock));
 
 	return;
 }
 
 /**
- * @brief	The prune function runs every few minutes and scans the object cache and removes any stale objects it finds.
+ * @brief	Remove an object from an idle queue, so it can be freed.
+ * @param	queue	the idle queue for the cache holding the object.
+ * @param	link	the idle queue link embedded in the object.
+ * @return	This function returns no value.
+ */
+void obj_idle_remove(object_queue_t *queue, object_idle_t *link) {
+
+	mutex_lock(&(queue->lock));
+	obj_idle_unlink(queue, link);
+	mutex_unlock(&(queue->lock));
+
+	return;
+}
+
+/**
+ * @brief	Remove the stale objects from a cache index, using the queue of idle objects.
+ *
+ * @note	Objects are queued when their last reference is released, so the oldest idle object is always at the front of the
+ * 			queue, and the walk stops at the first object which was used within the gap. Objects which have been referenced again
+ * 			since they were queued are dropped from the queue, and queued again when they become idle. The write lock is only held
+ * 			while OBJECT_EXPIRE_SLICE objects are examined, so logins don't wait for the entire sweep.
+ *
+ * @param	index	the cache index holding the objects.
+ * @param	queue	the idle queue for the cache index.
+ * @param	total	the function used to get the number of references held on an object.
+ * @param	stamp	the function used to get the last time an object's references changed.
+ * @param	gap		the number of seconds an object must be unused before it's removed.
+ * @param	latency	a pointer which will receive the longest time, in microseconds, the write lock was held.
+ * @return	the number of objects removed from the cache.
+ */
+uint64_t obj_cache_expire(inx_t *index, object_queue_t *queue, uint64_t (*total)(void *object), time_t (*stamp)(void *object), double_t gap, uint64_t *latency) {
+
+	object_idle_t *link;
+	bool_t finished = false;
+	time_t now = time(NULL);
+	uint64_t expired = 0, elapsed;
+	struct timespec start, finish;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	*latency = 0;
+
+	while (!finished) {
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		inx_lock_write(index);
+
+		for (int_t i = 0; i < OBJECT_EXPIRE_SLICE && !finished; i++) {
+
+			mutex_lock(&(queue->lock));
+
+			if (!(link = queue->head)) {
+				finished = true;
+			}
+			else if (total(link->object)) {
+				obj_idle_unlink(queue, link);
+			}
+			else if (difftime(now, stamp(link->object)) <= gap) {
+				finished = true;
+			}
+			else {
+
+				// The object is unlinked before it's deleted, since the free function removes the object from the queue.
+				key.val.u64 = link->key;
+				obj_idle_unlink(queue, link);
+				mutex_unlock(&(queue->lock));
+
+				if (inx_delete(index, key)) {
+					expired++;
+				}
+
+				continue;
+			}
+
+			mutex_unlock(&(queue->lock));
+		}
+
+		inx_unlock(index);
+		clock_gettime(CLOCK_MONOTONIC, &finish);
+
+		if ((elapsed = ((finish.tv_sec - start.tv_sec) * 1000000) + ((finish.tv_nsec - start.tv_nsec) / 1000)) > *latency) {
+			*latency = elapsed;
+		}
+	}
+
+	return expired;
+}
+
+/**
+ * @brief	The prune function runs every few minutes and removes any stale objects from the object cache.
  *
  * @note	If the number of entries is over 4,096, then the prune function will remove entries candidates which have been unused more
  * 			then 5 minutes. If the index holds more than 2,048, entries older than 30 minutes are pruned, otherwise if the index holds
  * 			fewer than 2,048 entries, only those objects older than 1 hour are removed. Also, note that the precise interval between
  * 			scans is somewhat random, because the background thread responsible for running the prune function goes to sleep for a
- * 			random number of seconds.
+ * 			random number of seconds. Only the idle objects which have expired are visited, in small slices.
  */
 void obj_cache_prune(void) {
 
-	time_t now;
 	double_t gap;
-	session_t *sess;
-	inx_cursor_t *cursor;
-	meta_user_t *meta;
-	uint64_t count, expired;
+	uint64_t count, expired, latency;
 
-	if ((now = time(NULL)) == (time_t)(-1)) {
-		return;
-	}
-
-	if (objects.meta && (cursor = inx_cursor_alloc(objects.meta))) {
-
-		expired = 0;
+	if (objects.meta) {
 
 		inx_lock_read(objects.meta);
 
@@ -94,31 +245,20 @@ void obj_cache_prune(void) {
 		}
 
 		inx_unlock(objects.meta);
-		inx_lock_write(objects.meta);
 
-		meta = inx_cursor_value_next(cursor);
-
-		while (meta) {
-			if (difftime(now, meta_user_ref_stamp(meta)) > gap && !meta_user_ref_total(meta)) {
-				inx_delete(objects.meta, inx_cursor_key_active(cursor));
-				inx_cursor_reset(cursor);
-				expired++;
-			}
-			meta = inx_cursor_value_next(cursor);
-		}
+		expired = obj_cache_expire(objects.meta, &(objects.idle.meta), (void *)&meta_user_ref_total, (void *)&meta_user_ref_stamp, gap, &latency);
 
 		// Record the total so we can update the statistics variable.
+		inx_lock_read(objects.meta);
 		count = inx_count(objects.meta);
 		inx_unlock(objects.meta);
-		inx_cursor_free(cursor);
 
 		stats_set_by_name("objects.meta.total", count);
 		stats_adjust_by_name("objects.meta.expired", expired);
+		stats_set_by_name("objects.meta.latency", latency);
 	}
 
-	if (objects.sessions && (cursor = inx_cursor_alloc(objects.sessions))) {
-
-		expired = 0;
+	if (objects.sessions) {
 
 		inx_lock_read(objects.sessions);
 
@@ -136,29 +276,18 @@ void obj_cache_prune(void) {
 		}
 
 		inx_unlock(objects.sessions);
-		inx_lock_write(objects.sessions);
-
-		sess = inx_cursor_value_next(cursor);
 
-		while (sess) {
-			if (difftime(now, sess_ref_stamp(sess)) > gap && !sess_ref_total(sess)) {
-				inx_delete(objects.sessions, inx_cursor_key_active(cursor));
-				inx_cursor_reset(cursor);
-				expired++;
-			}
-			sess = inx_cursor_value_next(cursor);
-		}
+		expired = obj_cache_expire(objects.sessions, &(objects.idle.sessions), (void *)&sess_ref_total, (void *)&sess_ref_stamp, gap, &latency);
 
 		// Record the total so we can update the statistics variable.
+		inx_lock_read(objects.sessions);
 		count = inx_count(objects.sessions);
 		inx_unlock(objects.sessions);
-		inx_cursor_free(cursor);
 
 		stats_set_by_name("objects.sessions.total", count);
 		stats_adjust_by_name("objects.sessions.expired", expired);
+		stats_set_by_name("objects.sessions.latency", latency);
 	}
 
-
 	return;
 }
-
@@ -27,10 +27,28 @@ enum {
 	OBJECT_ALIASES
 };
 
+// The number of idle objects examined by the prune function each time it acquires the write lock for a cache index.
+#define OBJECT_EXPIRE_SLICE 64
+
+typedef struct {
+	object_idle_t *head, *tail;
+	pthread_mutex_t lock;
+} object_queue_t;
+
 typedef struct {
-	inx_t *meta, *sessions;
+	inx_t *meta, *sessions, *listeners;
+	struct {
+		object_queue_t meta, sessions;
+	} idle;
 } object_cache_t;
 
+typedef struct {
+	void *data;
+	uint64_t usernum;
+	void (*callback)(void *data, uint64_t usernum, uint64_t object);
+	struct notify_listener_t *next;
+} notify_listener_t;
+
 extern object_cache_t objects;
 
 /// locks.c
@@ -39,14 +57,24 @@ void    lock_release(stringer_t *key);
 int_t   user_lock(uint64_t usernum);
 void    user_unlock(uint64_t usernum);
 
+/// notify.c
+void                 notify_publish(uint64_t usernum, uint64_t object);
+notify_listener_t *  notify_subscribe(uint64_t usernum, void (*callback)(void *data, uint64_t usernum, uint64_t object), void *data);
+void                 notify_unsubscribe(notify_listener_t *listener);
+
 /// objects.c
-bool_t obj_cache_start(void);
-void obj_cache_prune(void);
-void obj_cache_stop(void);
+uint64_t obj_cache_expire(inx_t *index, object_queue_t *queue, uint64_t (*total)(void *object), time_t (*stamp)(void *object), double_t gap, uint64_t *latency);
+void     obj_cache_prune(void);
+bool_t   obj_cache_start(void);
+void     obj_cache_stop(void);
+void     obj_idle_push(object_queue_t *queue, object_idle_t *link, void *object, uint64_t key);
+void     obj_idle_remove(object_queue_t *queue, object_idle_t *link);
+void     obj_idle_unlink(object_queue_t *queue, object_idle_t *link);
 
 /// serials.c
 uint64_t serial_get(uint64_t type, uint64_t num);
 uint64_t serial_increment(uint64_t type, uint64_t num);
+size_t   serial_prefetch(uint64_t num);
 uint64_t serial_reset(uint64_t type, uint64_t num);
 
 #endif
@@ -65,7 +65,7 @@ uint64_t serial_get(uint64_t type, uint64_t num) {
 	stringer_t *key, *prefix;
 
 	// Build retrieval key.
-	if (!(prefix = serial_prefix(type)) || !(key = st_aprint("magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
+	if (!(prefix = serial_prefix(type)) || !(key = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
 		log_pedantic("Unable to build %.*s serial key.", st_length_int(prefix), st_char_get(prefix));
 		return 0;
 	}
@@ -77,8 +77,58 @@ uint64_t serial_get(uint64_t type, uint64_t num) {
 	return result;
 }
 
+/**
+ * @brief	Load every serial number belonging to a user into the near cache using a single memcached request.
+ * @note	This is only worthwhile when several serial numbers are about to be checked, since the following serial_get() calls can
+ * 			then be answered without contacting memcached. If the near cache is disabled this function does nothing.
+ * @param	num		the specific object identifier.
+ * @return	the number of serial numbers which were loaded into the near cache.
+ */
+size_t serial_prefetch(uint64_t num) {
+
+	uint64_t value, token = cache_near_token();
+	size_t result = 0, count = 0;
+	stringer_t *key, *keys[sizeof(serial_prefix_strings) / sizeof(stringer_t *)], *values[sizeof(serial_prefix_strings) / sizeof(stringer_t *)];
+
+	if (!cache_near_enabled()) {
+		return 0;
+	}
+
+	// Only the serial numbers which aren't already held by the near cache are requested.
+	for (size_t i = 0; i < sizeof(serial_prefix_strings) / sizeof(stringer_t *); i++) {
+		if (!(key = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "magma.%.*s.%lu", st_length_int(serial_prefix_strings[i]),
+			st_char_get(serial_prefix_strings[i]), num))) {
+			log_pedantic("Unable to build the %.*s serial key.", st_length_int(serial_prefix_strings[i]), st_char_get(serial_prefix_strings[i]));
+		}
+		else if (cache_near_get_u64(key, &value)) {
+			st_free(key);
+		}
+		else {
+			keys[count++] = key;
+		}
+	}
+
+	if (count) {
+		cache_get_multi(count, keys, values);
+	}
+
+	// Memcached stores counters as decimal strings, so the values are converted before being stored as counters.
+	for (size_t i = 0; i < count; i++) {
+		if (values[i] && uint64_conv_st(values[i], &value) && value) {
+			cache_near_set_u64(keys[i], value, token);
+			result++;
+		}
+
+		st_cleanup(values[i]);
+		st_free(keys[i]);
+	}
+
+	return result;
+}
+
 /**
  * @brief	Increment the serial number for an object in memcached.
+ * @note	Any local listeners registered with the notification hub are alerted after the serial number has been updated.
  * @param	type	the serial type to be queried (OBJECT_USER, OBJECT_CONFIG, OBJECT_FOLDERS, OBJECT_MESSAGES, or OBJECT_CONTACTS).
  * @param	num		the specific object identifier.
  * @return	0 on failure or the new serial number of the requested object.
@@ -89,7 +139,7 @@ uint64_t serial_increment(uint64_t type, uint64_t num) {
 	stringer_t *key, *prefix;
 
 	// Build retrieval key.
-	if (!(prefix = serial_prefix(type)) || !(key = st_aprint("magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
+	if (!(prefix = serial_prefix(type)) || !(key = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
 		log_pedantic("Unable to build %.*s serial key.", st_length_int(prefix), st_char_get(prefix));
 		return 0;
 	}
@@ -98,6 +148,15 @@ uint64_t serial_increment(uint64_t type, uint64_t num) {
 	result = cache_increment(key, 1, 1, 2592000);
 	st_free(key);
 
+	// The object is about to change, so reads of the user's data should be sent to the primary until the read replicas catch up.
+	sql_replica_stamp(num);
+
+	// Wake up any local sessions waiting on changes to this object. If the cache is unavailable, the listeners would be unable to
+	// detect what changed, so we skip the notification.
+	if (result) {
+		notify_publish(num, type);
+	}
+
 	return result;
 }
 
@@ -113,7 +172,7 @@ uint64_t serial_reset(uint64_t type, uint64_t num) {
 	stringer_t *key, *prefix;
 
 	// Build key.
-	if (!(prefix = serial_prefix(type)) || !(key = st_aprint("magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
+	if (!(prefix = serial_prefix(type)) || !(key = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "magma.%.*s.%lu", st_length_int(prefix), st_char_get(prefix), num))) {
 		log_pedantic("Unable to build %.*s serial key.", st_length_int(prefix), st_char_get(prefix));
 		return 0;
 	}
@@ -60,6 +60,8 @@ void sess_destroy(session_t *sess) {
 
 	if (sess) {
 
+		obj_idle_remove(&(objects.idle.sessions), &(sess->idle));
+
 		if (sess->user) {
 			meta_inx_remove(sess->user->usernum, META_PROTOCOL_WEB);
 		}
@@ -111,6 +113,8 @@ void sess_ref_add(session_t *sess) {
  */
 void sess_ref_dec(session_t *sess) {
 
+	bool_t idle = false;
+
 	if (sess) {
 
 		// Acquire the reference counter lock.
@@ -118,6 +122,7 @@ void sess_ref_dec(session_t *sess) {
 
 		// Decrement the web counter.
 		sess->refs.web--;
+		idle = !sess->refs.web;
 
 		// Update the activity time stamp.
 		sess->refs.stamp = time(NULL);
@@ -125,6 +130,11 @@ void sess_ref_dec(session_t *sess) {
 		// Release the reference counter lock.
 		mutex_unlock(&(sess->lock));
 
+		// Once the last reference is released, queue the session so the prune function can find it.
+		if (idle) {
+			obj_idle_push(&(objects.idle.sessions), &(sess->idle), sess, sess->warden.number);
+		}
+
 	}
 	return;
 }
@@ -405,13 +415,19 @@ session_t *sess_create(connection_t *con, stringer_t *path, stringer_t *applicat
 
 	sess_ref_add(output);
 
+	// The sessions object requires manual locking.
+	inx_lock_write(objects.sessions);
+
 	if (inx_insert(objects.sessions, key, output) != 1) {
+		inx_unlock(objects.sessions);
 		log_pedantic("Unable to insert the session into the global context.");
 		sess_ref_dec(output);
 		sess_destroy(output);
 		return NULL;
 	}
 
+	inx_unlock(objects.sessions);
+
 	return output;
 }
 
@@ -518,10 +534,14 @@ int_t sess_get(connection_t *con, stringer_t *application, stringer_t *path, str
 		sess_ref_dec(con->http.session);
 		con->http.session = NULL;
 
+		inx_lock_write(objects.sessions);
+
 		if (!inx_delete(objects.sessions, key)) {
 			log_pedantic("Unexpected error occurred attempting to delete the expired cookie. { key = %lu }", key.val.u64);
 		}
 
+		inx_unlock(objects.sessions);
+
 		result = -7;
 	}
 
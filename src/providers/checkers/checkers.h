@@ -13,6 +13,13 @@
 #define IP_RANDOMIZER_PUSH_MIN 4
 #define IP_RANDOMIZER_PUSH_MAX 16
 
+#define VIRUS_CACHE_PARTS 128
+#define VIRUS_CACHE_HASH_LENGTH 32
+
+#define DKIM_CACHE_RECORD_LENGTH 1024
+#define DKIM_CACHE_ANSWER_LENGTH 4096
+#define CHECKERS_CACHE_KEY_LENGTH 32
+
 enum {
 	UNALLOCATED = 0,
 	ALLOCATED = 1,
@@ -29,23 +36,62 @@ enum {
 	FOREIGN = 1
 };
 
+typedef struct {
+	uint64_t generation; /* The cache generation the part was scanned in. */
+	uint64_t signatures; /* The number of signatures which were loaded when the part was scanned. */
+	uchr_t key[VIRUS_CACHE_HASH_LENGTH];
+} virus_cache_slot_t;
+
+typedef struct {
+	int_t result; /* The value returned by spf_check(). */
+	chr_t *name; /* The statistic which was updated for the outcome. */
+	time_t expiration;
+	uchr_t key[CHECKERS_CACHE_KEY_LENGTH];
+} spf_cache_slot_t;
+
+typedef struct {
+	size_t length;
+	time_t expiration;
+	uchr_t key[CHECKERS_CACHE_KEY_LENGTH];
+	chr_t record[DKIM_CACHE_RECORD_LENGTH];
+} dkim_cache_slot_t;
+
+typedef struct {
+	time_t modified; /* The modification time of the private key file when it was loaded. */
+	stringer_t *path; /* The location of the private key file. */
+	pthread_rwlock_t lock; /* Protects magma.dkim.key while it's being replaced. */
+} dkim_signer_t;
+
 /// clamav.c
 bool_t lib_load_clamav(void);
 bool_t virus_start(void);
 const char * lib_version_clamav(void);
 int virus_engine_refresh(void);
 int virus_check(stringer_t *data);
+int virus_scan(stringer_t *data, bool_t *clean);
 struct cl_engine * virus_engine_create(uint64_t *signatures);
 uint64_t virus_sigs_loaded(void);
 uint64_t virus_sigs_total(void);
 void virus_engine_destroy(struct cl_engine **target);
 void virus_stop(void);
 
+/// verdicts.c
+bool_t                virus_cache_enabled(void);
+bool_t                virus_cache_get(uchr_t *key);
+bool_t                virus_cache_key(placer_t header, placer_t body, int_t encoding, uchr_t *output);
+bool_t                virus_cache_start(void);
+void                  virus_cache_flush(void);
+uint64_t              virus_cache_generation(void);
+void                  virus_cache_set(uchr_t *key, uint64_t generation);
+void                  virus_cache_stop(void);
+
 /// dkim.c
 int_t           dkim_signature_verify(stringer_t *id, stringer_t *message);
 stringer_t *    dkim_signature_create(stringer_t *id, stringer_t *domain, stringer_t *message);
 void *          dkim_memory_alloc(void *closure, size_t nbytes);
 void            dkim_memory_free(void *closure, void *ptr);
+stringer_t *    dkim_signer_load(stringer_t *path, time_t *modified);
+int_t           dkim_signer_refresh(void);
 bool_t          dkim_start(void);
 void            dkim_stop(void);
 bool_t          lib_load_dkim(void);
@@ -59,6 +105,20 @@ bool_t   dspam_train(uint64_t usernum, int_t disposition, stringer_t *signature)
 bool_t   lib_load_dspam(void);
 chr_t *  lib_version_dspam(void);
 
+/// records.c
+DKIM_STAT  dkim_cache_lookup(DKIM *dkim, DKIM_SIGINFO *sig, uchr_t *buf, size_t size);
+DKIM_STAT  dkim_cache_query(chr_t *name, uchr_t *buf, size_t size, uint32_t *ttl);
+bool_t     dkim_cache_enabled(void);
+bool_t     dkim_cache_key(chr_t *name, size_t length, uchr_t *output);
+void       dkim_cache_set(uchr_t *key, chr_t *record, size_t length, uint32_t ttl);
+bool_t     dkim_cache_start(void);
+void       dkim_cache_stop(void);
+bool_t     spf_cache_get(uchr_t *key, int_t *result);
+bool_t     spf_cache_key(ip_t *addr, stringer_t *helo, stringer_t *domain, uchr_t *output);
+void       spf_cache_set(uchr_t *key, int_t result, chr_t *name);
+bool_t     spf_cache_start(void);
+void       spf_cache_stop(void);
+
 /// spf.c
 bool_t lib_load_spf(void);
 const chr_t * lib_version_spf(void);
@@ -231,6 +231,12 @@ bool_t virus_start(void) {
 	// Record the number of signatures loaded.
 	virus_sigs = loaded;
 
+	if (!virus_cache_start()) {
+		log_critical("Failed to initialize the virus verdict cache.");
+		stats_increment_by_name("provider.virus.error");
+		return false;
+	}
+
 	// Update the ClamAV engine trackers.
 	stats_set_by_name("provider.virus.available", 1);
 	stats_set_by_name("provider.virus.signatures.loaded", loaded);
@@ -263,6 +269,9 @@ void virus_stop(void) {
 		virus_sigs = 0;
 	}
 
+	// Free the verdict cache.
+	virus_cache_stop();
+
 	// Free the memory associated with the virus scanning engine.
 	if (virus_spool) {
 		st_free(virus_spool);
@@ -317,6 +326,9 @@ int virus_engine_refresh(void) {
 		original = virus_engine;
 		virus_engine = new;
 		virus_sigs = loaded;
+
+		// Any verdicts reached using the old signatures are no longer trusted.
+		virus_cache_flush();
 		pthread_rwlock_unlock(&virus_lock);
 
 		// Free the old engine context.
@@ -354,45 +366,43 @@ int virus_engine_refresh(void) {
 }
 
 /**
- * @brief	Virus scan a block of data.
+ * @brief	Scan a block of data using the ClamAV engine.
+ * @note	The data is scanned from memory, and is only written to a temporary file if a memory map can't be created.
  * @param	data	a managed string containing the block of data to be scanned.
+ * @param	clean	a pointer which will be set to true if the scan completed and found nothing, otherwise it's set to false.
  * @return	1 if the message passed the scan, or < 0 on failure.
- *        -1: general failure, or the virus scanner was not enabled.
+ *        -1: general failure.
  *        -2: the data matches a worm, trojan, or virus.
  *        -3: the data matches a phishing attempt.
  */
-int virus_check(stringer_t *data) {
+int virus_scan(stringer_t *data, bool_t *clean) {
 
-	int fd, state;
+	int fd = -1, state;
 	char *virname;
+	cl_fmap_t *map;
 	ssize_t written;
 	unsigned long int scanned;
 	struct cl_scan_options options;
 
-	// If we are not supposed to be scanning messages.
-	if (!magma.iface.virus.available) {
-		return -1;
-	}
+	*clean = false;
 
-	// Lets make sure an actual message was passed..
-	if (!data || !st_length_get(data)) {
-		log_error("An invalid message pointer was passed in.");
-		return -1;
-	}
+	// Scan directly from memory when possible, which avoids writing every message to the spool.
+	if (!(map = cl_fmap_open_memory_d(st_data_get(data), st_length_get(data)))) {
 
-	// Create a temporary file to store the message being scanned.
-	if ((fd = spool_mktemp(MAGMA_SPOOL_SCAN, "virus")) < 0) {
-		log_pedantic("Unable to open a temporary file to hold the message being scanned.");
-		stats_increment_by_name("provider.virus.error");
-		return -1;
-	}
+		// Create a temporary file to store the message being scanned.
+		if ((fd = spool_mktemp(MAGMA_SPOOL_SCAN, "virus")) < 0) {
+			log_pedantic("Unable to open a temporary file to hold the message being scanned.");
+			stats_increment_by_name("provider.virus.error");
+			return -1;
+		}
 
-	// Stick the message in the file for ClamAV.
-	if ((written = write(fd, st_data_get(data), st_length_get(data))) != st_length_get(data)) {
-		log_error("Not all of the bytes were written to disk. Was %zi, but should have been %zu.", written, st_length_get(data));
-		stats_increment_by_name("provider.virus.error");
-		close(fd);
-		return -1;
+		// Stick the message in the file for ClamAV.
+		if ((written = write(fd, st_data_get(data), st_length_get(data))) != st_length_get(data)) {
+			log_error("Not all of the bytes were written to disk. Was %zi, but should have been %zu.", written, st_length_get(data));
+			stats_increment_by_name("provider.virus.error");
+			close(fd);
+			return -1;
+		}
 	}
 
 	// Scan the message.
@@ -402,7 +412,12 @@ int virus_check(stringer_t *data) {
 	mm_wipe(&options, sizeof(struct cl_scan_options));
 	options.parse |= ~0;
 
-	state = cl_scandesc_d(fd, NULL, (const char **)&virname, &scanned, virus_engine, &options);
+	if (map) {
+		state = cl_scanmap_callback_d(map, NULL, (const char **)&virname, &scanned, virus_engine, &options, NULL);
+	}
+	else {
+		state = cl_scandesc_d(fd, NULL, (const char **)&virname, &scanned, virus_engine, &options);
+	}
 
 	// If we found something, then spit it back.
 	// http://wiki.clamav.net/Main/MalwareNaming has naming conventions.
@@ -415,16 +430,19 @@ int virus_check(stringer_t *data) {
 			pthread_rwlock_unlock(&virus_lock);
 			stats_increment_by_name("provider.virus.scan.total");
 			stats_increment_by_name("provider.virus.scan.phishing");
-			close(fd);
+			if (map) cl_fmap_close_d(map);
+			else close(fd);
 			return -3;
 		}
-		// We ignore email that ClamAV thinks is a phishing based on scanner's internal heuristic checks.
+		// We ignore email that ClamAV thinks is a phishing based on scanner's internal heuristic checks. The message is still delivered,
+		// but since the scan did find something, the parts aren't recorded as clean in the verdict cache.
 		else if (!st_cmp_ci_starts(PLACER(virname, ns_length_get(virname)), CONSTANT("Phishing")) ||
 			!st_cmp_ci_starts(PLACER(virname, ns_length_get(virname)), CONSTANT("Joke"))) {
 			pthread_rwlock_unlock(&virus_lock);
 			stats_increment_by_name("provider.virus.scan.total");
 			stats_increment_by_name("provider.virus.scan.clean");
-			close(fd);
+			if (map) cl_fmap_close_d(map);
+			else close(fd);
 			return 1;
 		}
 		// Its probably a worm, trojan, virus or something similar.
@@ -432,26 +450,116 @@ int virus_check(stringer_t *data) {
 			pthread_rwlock_unlock(&virus_lock);
 			stats_increment_by_name("provider.virus.scan.total");
 			stats_increment_by_name("provider.virus.scan.infected");
-			close(fd);
+			if (map) cl_fmap_close_d(map);
+			else close(fd);
 			return -2;
 		}
 	}
 
 	pthread_rwlock_unlock(&virus_lock);
-	close(fd);
+
+	if (map) cl_fmap_close_d(map);
+	else close(fd);
 
 	// Track the number of clean messages. We can do the tracking after the mutex is released.
 	if (state == CL_CLEAN) {
 		stats_increment_by_name("provider.virus.scan.total");
 		stats_increment_by_name("provider.virus.scan.clean");
+		*clean = true;
 	} else {
-		log_error("An error occurred while scanning a message. {cl_scandesc = %i = %s}", state, cl_strerror_d(state));
+		log_error("An error occurred while scanning a message. {cl_scan = %i = %s}", state, cl_strerror_d(state));
 		stats_increment_by_name("provider.virus.error");
 	}
 
 	return 1;
 }
 
+/**
+ * @brief	Virus scan a block of data.
+ * @note	When the verdict cache is enabled, the message is split into its leaf MIME parts, and the bodies of the parts which are
+ * 			already known to be clean are left out of the data given to the scanner. The message headers, the part headers, and the
+ * 			structure of the message are always scanned, even if every body is known to be clean, so the mail and phishing
+ * 			heuristics still see them. If the scan finds nothing, every part is recorded as clean.
+ * @param	data	a managed string containing the block of data to be scanned.
+ * @return	1 if the message passed the scan, or < 0 on failure.
+ *        -1: general failure, or the virus scanner was not enabled.
+ *        -2: the data matches a worm, trojan, or virus.
+ *        -3: the data matches a phishing attempt.
+ */
+int virus_check(stringer_t *data) {
+
+	int state;
+	chr_t *position;
+	bool_t clean = false;
+	mail_mime_t *mime = NULL;
+	uint64_t generation = 0;
+	stringer_t *reduced = NULL;
+	size_t count = 0, known = 0, length = 0;
+	mail_mime_t *parts[VIRUS_CACHE_PARTS];
+	bool_t hashed[VIRUS_CACHE_PARTS], cached[VIRUS_CACHE_PARTS];
+	uchr_t keys[VIRUS_CACHE_PARTS][VIRUS_CACHE_HASH_LENGTH];
+
+	// If we are not supposed to be scanning messages.
+	if (!magma.iface.virus.available) {
+		return -1;
+	}
+
+	// Lets make sure an actual message was passed..
+	if (!data || !st_length_get(data)) {
+		log_error("An invalid message pointer was passed in.");
+		return -1;
+	}
+
+	// Without the verdict cache, or if the message can't be split into a reasonable number of parts, scan everything.
+	if (!virus_cache_enabled() || !(mime = mail_mime_part(data, 0)) || !mail_mime_leaves(mime, parts, VIRUS_CACHE_PARTS, &count) || !count) {
+		mail_mime_free(mime);
+		return virus_scan(data, &clean);
+	}
+
+	// The generation is read before the scan, so a verdict reached using signatures which are replaced during the scan isn't stored.
+	generation = virus_cache_generation();
+
+	for (size_t i = 0; i < count; i++) {
+		hashed[i] = virus_cache_key(parts[i]->header, parts[i]->body, parts[i]->encoding, keys[i]);
+		if ((cached[i] = (hashed[i] && virus_cache_get(keys[i])))) {
+			known++;
+		}
+	}
+
+	// Copy the message, leaving out the bodies of the parts which are already known to be clean. The parts are stored in the order
+	// they appear, so the copy is assembled from the gaps between them.
+	if (known && (reduced = st_alloc(st_length_get(data)))) {
+
+		position = st_char_get(data);
+
+		for (size_t i = 0; i < count; i++) {
+			if (cached[i] && pl_char_get(parts[i]->body) >= position) {
+				mm_copy(st_char_get(reduced) + length, position, pl_char_get(parts[i]->body) - position);
+				length += pl_char_get(parts[i]->body) - position;
+				position = pl_char_get(parts[i]->body) + pl_length_get(parts[i]->body);
+			}
+		}
+
+		mm_copy(st_char_get(reduced) + length, position, st_char_get(data) + st_length_get(data) - position);
+		st_length_set(reduced, length + (st_char_get(data) + st_length_get(data) - position));
+	}
+
+	state = virus_scan(reduced ? reduced : data, &clean);
+
+	if (clean) {
+		for (size_t i = 0; i < count; i++) {
+			if (hashed[i] && !cached[i]) {
+				virus_cache_set(keys[i], generation);
+			}
+		}
+	}
+
+	st_cleanup(reduced);
+	mail_mime_free(mime);
+
+	return state;
+}
+
 /**
  * Returns the version of ClamAV that was loaded at runtime.
  *
@@ -470,6 +578,7 @@ bool_t lib_load_clamav(void) {
 	symbol_t clamav[] = {
 		M_BIND(cl_countsigs), M_BIND(cl_engine_compile), M_BIND(cl_engine_free), M_BIND(cl_engine_new),	M_BIND(cl_engine_set_num),
 		M_BIND(cl_engine_set_str), M_BIND(cl_init),	M_BIND(cl_load), M_BIND(cl_retver),	M_BIND(cl_scandesc), M_BIND(cl_shutdown),
+		M_BIND(cl_fmap_open_memory), M_BIND(cl_fmap_close), M_BIND(cl_scanmap_callback),
 		M_BIND(cl_statchkdir), M_BIND(cl_statfree), M_BIND(cl_statinidir), M_BIND(cl_strerror),	M_BIND(lt_dlexit),
 	};
 
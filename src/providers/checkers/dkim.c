@@ -9,6 +9,13 @@
 
 chr_t dkim_version[8];
 DKIM_LIB *dkim_engine = NULL;
+DKIM_LIB *dkim_verifier = NULL;
+
+dkim_signer_t dkim_signer = {
+	.modified = 0,
+	.path = NULL,
+	.lock = PTHREAD_RWLOCK_INITIALIZER
+};
 
 #define DKIM_PROCESS_ALL -1L
 
@@ -32,6 +39,7 @@ bool_t lib_load_dkim(void) {
 		M_BIND(dkim_body), M_BIND(dkim_chunk), M_BIND(dkim_close), M_BIND(dkim_eoh), M_BIND(dkim_eom), M_BIND(dkim_free),
 		M_BIND(dkim_getresultstr), M_BIND(dkim_header),	M_BIND(dkim_init),	M_BIND(dkim_libversion),
 		M_BIND(dkim_sign), M_BIND(dkim_verify), M_BIND(dkim_geterror), M_BIND(dkim_test_dns_put), M_BIND(dkim_mfree),
+		M_BIND(dkim_set_key_lookup), M_BIND(dkim_sig_getdomain), M_BIND(dkim_sig_getselector),
 
 		// This value structure is setup manually to avoid singular anomaly in our naming convetntion.
 		{ .name = "dkim_getsighdr", .pointer = (void *)&dkim_getsighdrx_d },
@@ -76,10 +84,13 @@ void dkim_memory_free(void *closure, void *ptr) {
 
 /**
  * @brief	Start the dkim engine.
+ * @note	If the key record cache is enabled, a second library handle is created for verification, which retrieves the public
+ * 			keys through the cache. The default handle is left untouched, so keys supplied using dkim_test_dns_put() still work.
  * @return	false on failure or true on success.
  */
 bool_t dkim_start(void) {
 
+	DKIM_STAT status = DKIM_STAT_OK;
 	stringer_t *keyname = NULL;
 
 	if (!(dkim_engine = dkim_init_d(dkim_memory_alloc, dkim_memory_free))) {
@@ -87,43 +98,129 @@ bool_t dkim_start(void) {
 		return false;
 	}
 
+	if (!dkim_cache_start()) {
+		log_pedantic("DKIM key record cache failed to start.");
+		return false;
+	}
+	else if (dkim_cache_enabled() && (!(dkim_verifier = dkim_init_d(dkim_memory_alloc, dkim_memory_free)) ||
+		(status = dkim_set_key_lookup_d(dkim_verifier, &dkim_cache_lookup)) != DKIM_STAT_OK)) {
+		log_pedantic("DKIM verification engine failed to start. { %s }", dkim_verifier ? dkim_getresultstr_d(status) : "dkim_init = NULL");
+		return false;
+	}
+
 	// This must be done here because we have to wait for OpenSSL to be initialized first.
 	if (magma.dkim.enabled) {
 
 		keyname = magma.dkim.key;
 
-		if (file_world_accessible(st_char_get(keyname))) {
-			log_critical("The DKIM private key is accessible to the world! Please fix the file permissions. { chmod 600 %.*s }",
-				st_length_int(keyname), st_char_get(keyname));
-			return false;
-		}
-
-		if (!ssl_verify_privkey(st_char_get(keyname))) {
-			log_critical("Unable to validate DKIM private key. { path = %.*s }", st_length_int(keyname), st_char_get(keyname));
-			return false;
-		}
-		else if (!(magma.dkim.key = file_load(st_char_get(keyname)))) {
-			log_critical("Unable to load DKIM private key contents from file. { path = %.*s }", st_length_int(keyname), st_char_get(keyname));
+		if (!(magma.dkim.key = dkim_signer_load(keyname, &(dkim_signer.modified)))) {
+			magma.dkim.key = keyname;
 			return false;
 		}
 
-		st_free(keyname);
+		// The location is kept, so the key can be reloaded if the file is replaced.
+		dkim_signer.path = keyname;
 	}
 
 	return true;
 }
 
+/**
+ * @brief	Validate and load a DKIM private key file.
+ * @param	path		a managed string holding the location of the private key file.
+ * @param	modified	a pointer which will receive the modification time of the file.
+ * @return	NULL on failure, or a managed string holding the contents of the private key file.
+ */
+stringer_t * dkim_signer_load(stringer_t *path, time_t *modified) {
+
+	struct stat info;
+	stringer_t *key = NULL;
+
+	if (file_world_accessible(st_char_get(path))) {
+		log_critical("The DKIM private key is accessible to the world! Please fix the file permissions. { chmod 600 %.*s }",
+			st_length_int(path), st_char_get(path));
+		return NULL;
+	}
+	else if (stat(st_char_get(path), &info)) {
+		log_critical("Unable to access the DKIM private key. { path = %.*s / %s }", st_length_int(path), st_char_get(path),
+			strerror_r(errno, MEMORYBUF(1024), 1024));
+		return NULL;
+	}
+	else if (!ssl_verify_privkey(st_char_get(path))) {
+		log_critical("Unable to validate DKIM private key. { path = %.*s }", st_length_int(path), st_char_get(path));
+		return NULL;
+	}
+	else if (!(key = file_load(st_char_get(path)))) {
+		log_critical("Unable to load DKIM private key contents from file. { path = %.*s }", st_length_int(path), st_char_get(path));
+		return NULL;
+	}
+
+	*modified = info.st_mtime;
+
+	return key;
+}
+
+/**
+ * @brief	Reload the DKIM private key if the key file has been replaced.
+ * @note	This function is called periodically by the maintenance thread. If the new key can't be loaded, the current key is
+ * 			kept, so outbound messages continue to be signed.
+ * @return	1 if the key was reloaded, 0 if no reload was necessary, or -1 if an error occurred.
+ */
+int_t dkim_signer_refresh(void) {
+
+	time_t modified;
+	struct stat info;
+	stringer_t *key, *original;
+
+	if (!magma.dkim.enabled || !dkim_signer.path) {
+		return 0;
+	}
+	else if (stat(st_char_get(dkim_signer.path), &info) || info.st_mtime == dkim_signer.modified) {
+		return 0;
+	}
+	else if (!(key = dkim_signer_load(dkim_signer.path, &modified))) {
+		log_error("The DKIM private key file changed, but could not be loaded. The current key will continue to be used. { path = %.*s }",
+			st_length_int(dkim_signer.path), st_char_get(dkim_signer.path));
+		dkim_signer.modified = info.st_mtime;
+		return -1;
+	}
+
+	pthread_rwlock_wrlock(&(dkim_signer.lock));
+	original = magma.dkim.key;
+	magma.dkim.key = key;
+	dkim_signer.modified = modified;
+	pthread_rwlock_unlock(&(dkim_signer.lock));
+
+	st_free(original);
+
+	log_info("The DKIM private key was reloaded. { path = %.*s }", st_length_int(dkim_signer.path), st_char_get(dkim_signer.path));
+
+	return 1;
+}
+
 /**
  * @brief	Stop the dkim engine.
  * @return	This function returns no value.
  */
 void dkim_stop(void) {
 
+	if (dkim_verifier) {
+		dkim_close_d(dkim_verifier);
+		dkim_verifier = NULL;
+	}
+
+	dkim_cache_stop();
+
 	if (dkim_engine) {
 		dkim_close_d(dkim_engine);
 		dkim_engine = NULL;
 	}
 
+	if (dkim_signer.path) {
+		st_free(dkim_signer.path);
+		dkim_signer.path = NULL;
+	}
+
 	return;
 }
 
@@ -142,18 +239,25 @@ stringer_t * dkim_signature_create(stringer_t *id, stringer_t *domain, stringer_
 
 	DKIM *context;
 	DKIM_STAT status;
-	dkim_sigkey_t key;
+	chr_t name[NS_MAXDNAME];
 	uchr_t *local = NULL, *selector = NULL;
 	stringer_t *output = NULL, *signature = NULL;
 
-	// We need a key, and a selector to sign a message.
-	if (!magma.dkim.enabled || st_empty(magma.dkim.key) || ns_empty(magma.dkim.selector)) {
+	// We need a key, and a selector to sign a message. The key is checked while the signer lock is held, since it may be replaced.
+	if (!magma.dkim.enabled || ns_empty(magma.dkim.selector)) {
 		return NULL;
 	}
 
-	// If a domain parameter is provided, use that. NULL, we can use the system default domain.
+	// If a domain parameter is provided, use that. The domain may be a placer pointing into an address, so it's copied into a
+	// buffer to ensure the library is given a terminated string.
 	if (st_populated(domain)) {
-		local = st_uchar_get(domain);
+		if (st_length_get(domain) >= NS_MAXDNAME) {
+			log_pedantic("The DKIM signing domain is too long. { length = %zu }", st_length_get(domain));
+			return NULL;
+		}
+		mm_copy(name, st_data_get(domain), st_length_get(domain));
+		name[st_length_get(domain)] = '\0';
+		local = (uchr_t *)name;
 	}
 	// If the domain parameter is NULL, or empty, then we use the system default domain.
 	else if (ns_populated(magma.dkim.domain)) {
@@ -165,11 +269,21 @@ stringer_t * dkim_signature_create(stringer_t *id, stringer_t *domain, stringer_
 	}
 
 	selector = (uchr_t *)magma.dkim.selector;
-	key = st_uchar_get(magma.dkim.key);
 
-	// Create a new handle to sign the message.
-	if (!(context = dkim_sign_d(dkim_engine, st_data_get(id), NULL, key, selector, local,
-		DKIM_CANON_RELAXED,	DKIM_CANON_RELAXED, DKIM_SIGN_RSASHA256, DKIM_PROCESS_ALL, &status)) ||	status != DKIM_STAT_OK) {
+	// Create a new handle to sign the message. The library keeps its own copy of the key, so the lock is only held while the
+	// handle is created.
+	pthread_rwlock_rdlock(&(dkim_signer.lock));
+
+	if (st_empty(magma.dkim.key)) {
+		pthread_rwlock_unlock(&(dkim_signer.lock));
+		return NULL;
+	}
+
+	context = dkim_sign_d(dkim_engine, st_data_get(id), NULL, st_uchar_get(magma.dkim.key), selector, local, DKIM_CANON_RELAXED,
+		DKIM_CANON_RELAXED, DKIM_SIGN_RSASHA256, DKIM_PROCESS_ALL, &status);
+	pthread_rwlock_unlock(&(dkim_signer.lock));
+
+	if (!context || status != DKIM_STAT_OK) {
 		log_pedantic("Allocation of the DKIM signature context failed. { %sstatus = %s / error = %s }",
 			     context ? "" : "dkim_sign = NULL / ", dkim_getresultstr_d(status),
 			     context ? dkim_geterror_d(context) : "NULL");
@@ -211,7 +325,8 @@ stringer_t * dkim_signature_create(stringer_t *id, stringer_t *domain, stringer_
 
 /**
  * @brief	Perform dkim verification of a signed message.
- * @note	This function also updates the provider.dkim.* statistics.
+ * @note	This function also updates the provider.dkim.* statistics. When the key record cache is enabled, only the body hash
+ * 			and signature are checked for messages signed using a recently retrieved key.
  * @param	id			a managed string containing a printable string id for this message.
  * @param	message		a managed string containing the mail message data.
  * @return	1 if the dkim verification was successful, or < 0 otherwise.
@@ -226,7 +341,7 @@ int_t dkim_signature_verify(stringer_t *id, stringer_t *message) {
 	stats_adjust_by_name("provider.dkim.checked", 1);
 
 	// Create a new handle to verify the signed message.
-	if (!(context = dkim_verify_d(dkim_engine, st_data_get(id), NULL, &status)) || status != DKIM_STAT_OK) {
+	if (!(context = dkim_verify_d(dkim_verifier ? dkim_verifier : dkim_engine, st_data_get(id), NULL, &status)) || status != DKIM_STAT_OK) {
 		log_pedantic("Allocation of the DKIM verification context failed. { %sstatus = %s }", context ? "" : "dkim_verify = NULL / ",
 			dkim_getresultstr_d(status));
 		stats_adjust_by_name("provider.dkim.errors", 1);
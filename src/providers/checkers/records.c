@@ -0,0 +1,368 @@
+
+/**
+ * @file /magma/providers/checkers/records.c
+ *
+ * @brief	Short lived caches of the SPF outcomes, and DKIM public key records, retrieved using DNS, so the messages sent in bulk by
+ * 			the same sender don't each repeat the same lookups.
+ *
+ * @note	SPF outcomes are located using a hash of the connection address, the HELO value, and the MAIL FROM domain, and are trusted
+ * 			for magma.iface.spf.cache.timeout seconds. DKIM key records are located using a hash of the selector and signing domain,
+ * 			and are trusted until the record TTL, or magma.dkim.cache.timeout seconds, expires, whichever is sooner. Only the DNS work
+ * 			is cached; the body hash and signature of every message are still verified. Lookups which fail are never cached.
+ */
+
+#include "magma.h"
+
+struct {
+	slotted_t *table; /* The slot table, or NULL if the cache is disabled. */
+} outcomes = {
+	.table = NULL
+};
+
+struct {
+	slotted_t *table; /* The slot table, or NULL if the cache is disabled. */
+} records = {
+	.table = NULL
+};
+
+/**
+ * @brief	Allocate the SPF outcome cache.
+ * @note	If magma.iface.spf.cache.entries is set to zero, the cache is disabled and every message is checked.
+ * @return	true on success or false on failure.
+ */
+bool_t spf_cache_start(void) {
+
+	if (!magma.iface.spf.cache.entries || !magma.iface.spf.cache.timeout) {
+		return true;
+	}
+	else if (!(outcomes.table = slotted_alloc(magma.iface.spf.cache.entries, sizeof(spf_cache_slot_t), false, NULL))) {
+		log_critical("Could not allocate memory for the SPF outcome cache. { entries = %u }", magma.iface.spf.cache.entries);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Free the SPF outcome cache.
+ * @return	This function returns no value.
+ */
+void spf_cache_stop(void) {
+
+	slotted_t *table = outcomes.table;
+
+	if (!table) {
+		return;
+	}
+
+	outcomes.table = NULL;
+	slotted_free(table);
+
+	return;
+}
+
+/**
+ * @brief	Calculate the key used to locate an SPF outcome in the cache.
+ * @param	addr	the address of the connection being checked.
+ * @param	helo	a managed string containing the client supplied HELO value.
+ * @param	domain	a managed string containing the MAIL FROM domain.
+ * @param	output	a buffer of CHECKERS_CACHE_KEY_LENGTH bytes which will receive the key.
+ * @return	true on success, or false if the outcome can't be cached.
+ */
+bool_t spf_cache_key(ip_t *addr, stringer_t *helo, stringer_t *domain, uchr_t *output) {
+
+	EVP_MD_CTX ctx;
+	uchr_t separator = 0;
+	uint_t length = CHECKERS_CACHE_KEY_LENGTH;
+	const EVP_MD *digest = EVP_sha256_d();
+
+	if (!outcomes.table || !digest || (addr->family != AF_INET && addr->family != AF_INET6) || st_empty(helo, domain)) {
+		return false;
+	}
+
+	EVP_MD_CTX_init_d(&ctx);
+
+	// The separators ensure a different split between the HELO value and the domain can't produce the same input.
+	if (EVP_DigestInit_ex_d(&ctx, digest, NULL) != 1 || EVP_DigestUpdate_d(&ctx, &(addr->family), sizeof(sa_family_t)) != 1 ||
+		EVP_DigestUpdate_d(&ctx, addr->ip, (addr->family == AF_INET ? sizeof(struct in_addr) : sizeof(struct in6_addr))) != 1 ||
+		EVP_DigestUpdate_d(&ctx, st_data_get(helo), st_length_get(helo)) != 1 || EVP_DigestUpdate_d(&ctx, &separator, 1) != 1 ||
+		EVP_DigestUpdate_d(&ctx, st_data_get(domain), st_length_get(domain)) != 1 || EVP_DigestFinal_ex_d(&ctx, output, &length) != 1 ||
+		length != CHECKERS_CACHE_KEY_LENGTH) {
+		log_pedantic("Unable to hash the SPF request for the outcome cache. {%s}", ssl_error_string(MEMORYBUF(256), 256));
+		EVP_MD_CTX_cleanup_d(&ctx);
+		return false;
+	}
+
+	EVP_MD_CTX_cleanup_d(&ctx);
+
+	return true;
+}
+
+/**
+ * @brief	Retrieve a recent SPF outcome.
+ * @note	A hit also updates the provider.spf.* statistic which was updated when the outcome was determined.
+ * @param	key		the key calculated using spf_cache_key().
+ * @param	result	a pointer which will receive the value spf_check() returned for the request.
+ * @return	true if the outcome was found, otherwise false.
+ */
+bool_t spf_cache_get(uchr_t *key, int_t *result) {
+
+	chr_t *name = NULL;
+	spf_cache_slot_t *slot;
+	uint64_t hash = *((uint64_t *)key);
+
+	slot = slotted_lock(outcomes.table, hash);
+
+	if (slot->expiration > time(NULL) && !memcmp(slot->key, key, CHECKERS_CACHE_KEY_LENGTH)) {
+		*result = slot->result;
+		name = slot->name;
+	}
+
+	slotted_unlock(outcomes.table, hash);
+
+	if (name) {
+		stats_increment_by_name("provider.spf.cache.hits");
+		stats_increment_by_name(name);
+		return true;
+	}
+
+	stats_increment_by_name("provider.spf.cache.misses");
+	return false;
+}
+
+/**
+ * @brief	Store an SPF outcome.
+ * @param	key		the key calculated using spf_cache_key().
+ * @param	result	the value spf_check() returned for the request.
+ * @param	name	the name of the provider.spf.* statistic which was updated for the outcome.
+ * @return	This function returns no value.
+ */
+void spf_cache_set(uchr_t *key, int_t result, chr_t *name) {
+
+	spf_cache_slot_t *slot;
+	uint64_t hash = *((uint64_t *)key);
+
+	slot = slotted_lock(outcomes.table, hash);
+	slot->name = name;
+	slot->result = result;
+	slot->expiration = time(NULL) + magma.iface.spf.cache.timeout;
+	mm_copy(slot->key, key, CHECKERS_CACHE_KEY_LENGTH);
+	slotted_unlock(outcomes.table, hash);
+
+	return;
+}
+
+/**
+ * @brief	Allocate the DKIM key record cache.
+ * @note	If magma.dkim.cache.entries is set to zero, the cache is disabled and the DKIM library retrieves every key itself.
+ * @return	true on success or false on failure.
+ */
+bool_t dkim_cache_start(void) {
+
+	if (!magma.dkim.cache.entries || !magma.dkim.cache.timeout) {
+		return true;
+	}
+	else if (!(records.table = slotted_alloc(magma.dkim.cache.entries, sizeof(dkim_cache_slot_t), false, NULL))) {
+		log_critical("Could not allocate memory for the DKIM key record cache. { entries = %u }", magma.dkim.cache.entries);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Free the DKIM key record cache.
+ * @return	This function returns no value.
+ */
+void dkim_cache_stop(void) {
+
+	slotted_t *table = records.table;
+
+	if (!table) {
+		return;
+	}
+
+	records.table = NULL;
+	slotted_free(table);
+
+	return;
+}
+
+/**
+ * @brief	Determine whether the DKIM key record cache is active.
+ * @return	true if the cache is enabled, otherwise false.
+ */
+bool_t dkim_cache_enabled(void) {
+
+	return records.table ? true : false;
+}
+
+/**
+ * @brief	Retrieve a DKIM key record from DNS.
+ * @note	If more than one TXT record is returned, the first one is used, which matches the behavior of the DKIM library.
+ * @param	name	the fully qualified name of the key record.
+ * @param	buf		a buffer which will receive the NULL terminated key record.
+ * @param	size	the size of the buffer.
+ * @param	ttl		a pointer which will receive the time to live of the record.
+ * @return	DKIM_STAT_OK on success, DKIM_STAT_NOKEY if the record doesn't exist, or DKIM_STAT_KEYFAIL if the lookup failed.
+ */
+DKIM_STAT dkim_cache_query(chr_t *name, uchr_t *buf, size_t size, uint32_t *ttl) {
+
+	ns_rr rr;
+	ns_msg handle;
+	int_t received;
+	const uchr_t *rdata;
+	size_t length = 0, rdlength, chunk;
+	uchr_t answer[DKIM_CACHE_ANSWER_LENGTH];
+
+	if ((received = res_query(name, ns_c_in, ns_t_txt, answer, sizeof(answer))) < 0) {
+		return (h_errno == HOST_NOT_FOUND || h_errno == NO_DATA) ? DKIM_STAT_NOKEY : DKIM_STAT_KEYFAIL;
+	}
+	else if (ns_initparse(answer, received, &handle) < 0) {
+		log_pedantic("Unable to parse the DKIM key record response. { name = %s }", name);
+		return DKIM_STAT_KEYFAIL;
+	}
+
+	for (int_t i = 0; i < ns_msg_count(handle, ns_s_an); i++) {
+
+		if (ns_parserr(&handle, ns_s_an, i, &rr) < 0) {
+			log_pedantic("Unable to parse the DKIM key record response. { name = %s }", name);
+			return DKIM_STAT_KEYFAIL;
+		}
+		else if (ns_rr_type(rr) != ns_t_txt) {
+			continue;
+		}
+
+		rdata = ns_rr_rdata(rr);
+		rdlength = ns_rr_rdlen(rr);
+
+		// The record data is a series of length prefixed strings, which are joined together.
+		for (size_t offset = 0; offset < rdlength; offset += chunk + 1) {
+
+			if (offset + 1 + (chunk = rdata[offset]) > rdlength || length + chunk >= size) {
+				log_pedantic("The DKIM key record is invalid, or too large. { name = %s }", name);
+				return DKIM_STAT_KEYFAIL;
+			}
+
+			mm_copy(buf + length, rdata + offset + 1, chunk);
+			length += chunk;
+		}
+
+		buf[length] = '\0';
+		*ttl = ns_rr_ttl(rr);
+
+		return DKIM_STAT_OK;
+	}
+
+	return DKIM_STAT_NOKEY;
+}
+
+/**
+ * @brief	Calculate the key used to locate a DKIM key record in the cache.
+ * @note	Domain names aren't case sensitive, so the name is converted to lower case before it's hashed.
+ * @param	name	the fully qualified name of the key record, which will be converted to lower case.
+ * @param	length	the length of the name.
+ * @param	output	a buffer of CHECKERS_CACHE_KEY_LENGTH bytes which will receive the key.
+ * @return	true on success, or false if the key couldn't be calculated.
+ */
+bool_t dkim_cache_key(chr_t *name, size_t length, uchr_t *output) {
+
+	if (!records.table || !name || !length) {
+		return false;
+	}
+
+	lower_st(PLACER(name, length));
+
+	if (!EVP_Digest_d(name, length, output, NULL, EVP_sha256_d(), NULL)) {
+		log_pedantic("Unable to hash the DKIM key record name. {%s}", ssl_error_string(MEMORYBUF(256), 256));
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Store a DKIM key record.
+ * @note	Records which are too large to fit in a cache slot are silently ignored.
+ * @param	key		the key calculated using dkim_cache_key().
+ * @param	record	the key record.
+ * @param	length	the length of the key record.
+ * @param	ttl		the time to live of the record, which is capped at magma.dkim.cache.timeout seconds.
+ * @return	This function returns no value.
+ */
+void dkim_cache_set(uchr_t *key, chr_t *record, size_t length, uint32_t ttl) {
+
+	dkim_cache_slot_t *slot;
+	uint64_t hash = *((uint64_t *)key);
+
+	if (!ttl || length >= DKIM_CACHE_RECORD_LENGTH) {
+		return;
+	}
+
+	slot = slotted_lock(records.table, hash);
+	slot->length = length;
+	slot->expiration = time(NULL) + (ttl < magma.dkim.cache.timeout ? ttl : magma.dkim.cache.timeout);
+	mm_copy(slot->key, key, CHECKERS_CACHE_KEY_LENGTH);
+	mm_copy(slot->record, record, length);
+	slotted_unlock(records.table, hash);
+
+	return;
+}
+
+/**
+ * @brief	The key lookup callback given to the DKIM library, which retrieves key records from the cache whenever possible.
+ * @param	dkim	the DKIM verification context.
+ * @param	sig		the signature which requires a key.
+ * @param	buf		a buffer which will receive the NULL terminated key record.
+ * @param	size	the size of the buffer.
+ * @return	DKIM_STAT_OK on success, DKIM_STAT_NOKEY if the record doesn't exist, or DKIM_STAT_KEYFAIL if the lookup failed.
+ */
+DKIM_STAT dkim_cache_lookup(DKIM *dkim, DKIM_SIGINFO *sig, uchr_t *buf, size_t size) {
+
+	int_t length;
+	DKIM_STAT status;
+	uint32_t ttl = 0;
+	uint64_t hash;
+	bool_t found = false;
+	dkim_cache_slot_t *slot;
+	uchr_t *selector, *domain;
+	uchr_t key[CHECKERS_CACHE_KEY_LENGTH];
+	chr_t name[NS_MAXDNAME];
+
+	if (!buf || size < 2 || !(selector = dkim_sig_getselector_d(sig)) || !(domain = dkim_sig_getdomain_d(sig))) {
+		return DKIM_STAT_KEYFAIL;
+	}
+	else if ((length = snprintf(name, NS_MAXDNAME, "%s.%s.%s", selector, DKIM_DNSKEYNAME, domain)) <= 0 ||
+		length >= NS_MAXDNAME) {
+		return DKIM_STAT_KEYFAIL;
+	}
+
+	// If the key can't be calculated, fall back to a plain lookup.
+	else if (!dkim_cache_key(name, length, key)) {
+		return dkim_cache_query(name, buf, size, &ttl);
+	}
+
+	hash = *((uint64_t *)key);
+	slot = slotted_lock(records.table, hash);
+
+	if (slot->expiration > time(NULL) && slot->length < size && !memcmp(slot->key, key, CHECKERS_CACHE_KEY_LENGTH)) {
+		mm_copy(buf, slot->record, slot->length);
+		buf[slot->length] = '\0';
+		found = true;
+	}
+
+	slotted_unlock(records.table, hash);
+
+	if (found) {
+		stats_increment_by_name("provider.dkim.cache.hits");
+		return DKIM_STAT_OK;
+	}
+
+	stats_increment_by_name("provider.dkim.cache.misses");
+
+	if ((status = dkim_cache_query(name, buf, size, &ttl)) == DKIM_STAT_OK) {
+		dkim_cache_set(key, (chr_t *)buf, ns_length_get((chr_t *)buf), ttl);
+	}
+
+	return status;
+}
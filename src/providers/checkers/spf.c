@@ -74,6 +74,11 @@ bool_t spf_start(void) {
 		pool_set_obj(spf_pool, i, object);
 	}
 
+	if (!spf_cache_start()) {
+		log_pedantic("Could not initialize the SPF outcome cache.");
+		return false;
+	}
+
 	return true;
 }
 
@@ -85,6 +90,8 @@ void spf_stop(void) {
 
 	SPF_server_t *object;
 
+	spf_cache_stop();
+
 	// Destroy the objects.
 	for (uint32_t i = 0; i < magma.iface.spf.pool.connections; i++) {
 
@@ -103,6 +110,8 @@ void spf_stop(void) {
 
 /**
  * @brief	Validate an smtp request via spf.
+ * @note	Outcomes are cached using the connection address, the HELO value, and the MAIL FROM domain, so a sender which delivers
+ * 			a series of messages is only checked once. Errors aren't cached.
  * @param	ip			an ip address object containing the ip address of the connection to be checked.
  * @param	helo		a managed string containing the client supplied HELO request value.
  * @param	mailfrom	a managed string containing the client supplied MAIL FROM request value.
@@ -111,9 +120,12 @@ void spf_stop(void) {
  */
 int_t spf_check(void *ip, stringer_t *helo, stringer_t *mailfrom) {
 
+	int_t result;
 	uint32_t item;
 	placer_t domain;
 	ip_t *addr = ip;
+	bool_t cacheable = false;
+	uchr_t key[CHECKERS_CACHE_KEY_LENGTH];
 #ifdef MAGMA_SPF_DEBUG
 	SPF_reason_t reason = SPF_REASON_NONE;
 #endif
@@ -131,6 +143,11 @@ int_t spf_check(void *ip, stringer_t *helo, stringer_t *mailfrom) {
 		return -1;
 	}
 
+	// See whether the same sender was checked recently.
+	else if ((cacheable = spf_cache_key(addr, helo, &domain, key)) && spf_cache_get(key, &result)) {
+		return result;
+	}
+
 	else if (pool_pull(spf_pool, &item) != PL_RESERVED) {
 		stats_adjust_by_name("provider.spf.error", 1);
 		return -1;
@@ -173,6 +190,7 @@ int_t spf_check(void *ip, stringer_t *helo, stringer_t *mailfrom) {
 		// Indicates the domain being queried did not publish an SPF record.
 		if (error == SPF_E_NOT_SPF) {
 			stats_adjust_by_name("provider.spf.missing", 1);
+			if (cacheable) spf_cache_set(key, -1, "provider.spf.missing");
 		}
 		else {
 			log_pedantic("SPF query error. { domain = %.*s / error = %s }", st_length_int(&domain), st_char_get(&domain), SPF_strerror_d(error));
@@ -196,6 +214,7 @@ int_t spf_check(void *ip, stringer_t *helo, stringer_t *mailfrom) {
 		log_pedantic("SPF check passed. { result = PASS / reason = %s }", SPF_strreason_d(reason));
 #endif
 		stats_adjust_by_name("provider.spf.pass", 1);
+		if (cacheable) spf_cache_set(key, 1, "provider.spf.pass");
 		return 1;
 	}
 	else if (response == SPF_RESULT_NEUTRAL) {
@@ -203,6 +222,7 @@ int_t spf_check(void *ip, stringer_t *helo, stringer_t *mailfrom) {
 		log_pedantic("SPF check neutral. { result = NEUTRAL / reason = %s }", SPF_strreason_d(reason));
 #endif
 		stats_adjust_by_name("provider.spf.neutral", 1);
+		if (cacheable) spf_cache_set(key, -1, "provider.spf.neutral");
 		return -1;
 	}
 	else if (response == SPF_RESULT_FAIL) {
@@ -210,6 +230,7 @@ int_t spf_check(void *ip, stringer_t *helo, stringer_t *mailfrom) {
 		log_pedantic("SPF check failed. { result = FAILED / reason = %s }", SPF_strreason_d(reason));
 #endif
 		stats_adjust_by_name("provider.spf.fail", 1);
+		if (cacheable) spf_cache_set(key, -2, "provider.spf.fail");
 		return -2;
 	}
 
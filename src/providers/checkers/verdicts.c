@@ -0,0 +1,193 @@
+
+/**
+ * @file /magma/providers/checkers/verdicts.c
+ *
+ * @brief	A cache of the message parts which the virus scanner found to be clean, so the attachments shared by mass mailings,
+ * 			newsletters, and delivery retries aren't scanned again for every copy.
+ *
+ * @note	Each leaf MIME part is identified by the SHA-256 hash of its decoded body, and the headers describing its content and
+ * 			transfer encoding, and is only trusted while the signature database it was scanned against is still loaded. Reloading
+ * 			the signatures increments the generation number, which invalidates every entry at once. Only clean verdicts are cached;
+ * 			infected messages, heuristic matches, and scans which fail, are always rescanned.
+ */
+
+#include "magma.h"
+
+struct {
+	uint64_t generation; /* Incremented whenever the signature database is reloaded. */
+	slotted_t *table; /* The slot table, or NULL if the cache is disabled. */
+} verdicts = {
+	.generation = 1,
+	.table = NULL
+};
+
+/**
+ * @brief	Allocate the virus verdict cache.
+ * @note	If magma.iface.virus.cache is set to zero, the cache is disabled and every message is scanned in full.
+ * @return	true on success or false on failure.
+ */
+bool_t virus_cache_start(void) {
+
+	if (!magma.iface.virus.cache) {
+		return true;
+	}
+	else if (!(verdicts.table = slotted_alloc(magma.iface.virus.cache, sizeof(virus_cache_slot_t), false, NULL))) {
+		log_critical("Could not allocate memory for the virus verdict cache. { entries = %u }", magma.iface.virus.cache);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Free the virus verdict cache.
+ * @return	This function returns no value.
+ */
+void virus_cache_stop(void) {
+
+	slotted_t *table = verdicts.table;
+
+	if (!table) {
+		return;
+	}
+
+	verdicts.table = NULL;
+	slotted_free(table);
+
+	return;
+}
+
+/**
+ * @brief	Determine whether the virus verdict cache is active.
+ * @return	true if the cache is enabled, otherwise false.
+ */
+bool_t virus_cache_enabled(void) {
+
+	return verdicts.table ? true : false;
+}
+
+/**
+ * @brief	Get the current cache generation.
+ * @note	The generation should be read before a scan starts, so a verdict reached using signatures which were replaced
+ * 			while the scan was running isn't stored.
+ * @return	the current cache generation.
+ */
+uint64_t virus_cache_generation(void) {
+
+	return __sync_add_and_fetch(&(verdicts.generation), 0);
+}
+
+/**
+ * @brief	Invalidate every cached verdict.
+ * @note	This is called whenever a new signature database is loaded.
+ * @return	This function returns no value.
+ */
+void virus_cache_flush(void) {
+
+	__sync_add_and_fetch(&(verdicts.generation), 1);
+	stats_increment_by_name("provider.virus.cache.flushes");
+
+	return;
+}
+
+/**
+ * @brief	Calculate the key used to locate a message part in the cache.
+ * @note	The key covers the decoded content of the part along with its Content-Type and Content-Transfer-Encoding headers, since
+ * 			the scanner treats the same bytes differently depending on how they're labeled. A part which can't be decoded isn't
+ * 			given a key, so it's always scanned.
+ * @param	header		the header of the leaf MIME part.
+ * @param	body		the body of the leaf MIME part.
+ * @param	encoding	the MESSAGE_ENCODING value for the part's Content-Transfer-Encoding header.
+ * @param	output		a buffer of VIRUS_CACHE_HASH_LENGTH bytes which will receive the key.
+ * @return	true on success, or false if an error occurs.
+ */
+bool_t virus_cache_key(placer_t header, placer_t body, int_t encoding, uchr_t *output) {
+
+	bool_t result = false;
+	stringer_t *type = NULL, *transfer = NULL, *decoded = NULL, *labels = NULL, *combined = NULL, *hash = MANAGEDBUF(VIRUS_CACHE_HASH_LENGTH);
+
+	if (pl_empty(body)) {
+		return false;
+	}
+
+	type = mail_header_fetch_cleaned(&header, PLACER("Content-Type", 12));
+	transfer = mail_header_fetch_cleaned(&header, PLACER("Content-Transfer-Encoding", 25));
+
+	if (encoding == MESSAGE_ENCODING_BASE64) {
+		decoded = base64_decode((stringer_t *)&body, NULL);
+	}
+	else if (encoding == MESSAGE_ENCODING_QUOTED_PRINTABLE) {
+		decoded = qp_decode((stringer_t *)&body);
+	}
+	else {
+		decoded = st_dupe((stringer_t *)&body);
+	}
+
+	if (decoded && (labels = st_aprint("Content-Type: %.*s\r\nContent-Transfer-Encoding: %.*s\r\n\r\n", st_length_int(type),
+		st_char_get(type), st_length_int(transfer), st_char_get(transfer))) && (combined = st_merge("ss", labels, decoded)) &&
+		hash_sha256(combined, hash) && st_length_get(hash) == VIRUS_CACHE_HASH_LENGTH) {
+		mm_copy(output, st_data_get(hash), VIRUS_CACHE_HASH_LENGTH);
+		result = true;
+	}
+
+	st_cleanup(type, transfer, decoded, labels, combined);
+
+	return result;
+}
+
+/**
+ * @brief	Determine whether a message part is known to be clean.
+ * @param	key		the hash of the message part.
+ * @return	true if the part was found clean by the currently loaded signatures, otherwise false.
+ */
+bool_t virus_cache_get(uchr_t *key) {
+
+	bool_t result = false;
+	uint64_t hash;
+	virus_cache_slot_t *slot;
+	uint64_t generation = virus_cache_generation(), signatures = virus_sigs_loaded();
+
+	if (!verdicts.table) {
+		return false;
+	}
+
+	hash = *((uint64_t *)key);
+	slot = slotted_lock(verdicts.table, hash);
+
+	if (slot->generation == generation && slot->signatures == signatures && !memcmp(slot->key, key, VIRUS_CACHE_HASH_LENGTH)) {
+		result = true;
+	}
+
+	slotted_unlock(verdicts.table, hash);
+
+	stats_increment_by_name(result ? "provider.virus.cache.hits" : "provider.virus.cache.misses");
+
+	return result;
+}
+
+/**
+ * @brief	Record that a message part was found clean.
+ * @param	key			the hash of the message part.
+ * @param	generation	the cache generation read before the scan started.
+ * @return	This function returns no value.
+ */
+void virus_cache_set(uchr_t *key, uint64_t generation) {
+
+	uint64_t hash;
+	virus_cache_slot_t *slot;
+	uint64_t signatures = virus_sigs_loaded();
+
+	// If the signatures were reloaded during the scan, the verdict may already be stale.
+	if (!verdicts.table || generation != virus_cache_generation()) {
+		return;
+	}
+
+	hash = *((uint64_t *)key);
+	slot = slotted_lock(verdicts.table, hash);
+	slot->generation = generation;
+	slot->signatures = signatures;
+	mm_copy(slot->key, key, VIRUS_CACHE_HASH_LENGTH);
+	slotted_unlock(verdicts.table, hash);
+
+	return;
+}
@@ -17,8 +17,9 @@ bool_t lib_load_cache(void) {
 
 	symbol_t cache[] = {
 		M_BIND(memcached_add), M_BIND(memcached_append), M_BIND(memcached_behavior_set), M_BIND(memcached_cas), M_BIND(memcached_create),
-		M_BIND(memcached_decrement), M_BIND(memcached_decrement_with_initial), M_BIND(memcached_delete), M_BIND(memcached_flush),
-		M_BIND(memcached_free), M_BIND(memcached_get), M_BIND(memcached_increment),	M_BIND(memcached_increment_with_initial),
+		M_BIND(memcached_decrement), M_BIND(memcached_decrement_with_initial), M_BIND(memcached_delete), M_BIND(memcached_fetch),
+		M_BIND(memcached_flush), M_BIND(memcached_free), M_BIND(memcached_get), M_BIND(memcached_increment), M_BIND(memcached_increment_with_initial),
+		M_BIND(memcached_mget),
 		M_BIND(memcached_lib_version), M_BIND(memcached_prepend), M_BIND(memcached_replace), M_BIND(memcached_server_add_with_weight),
 		M_BIND(memcached_set), M_BIND(memcached_strerror)
 	};
@@ -94,7 +95,7 @@ bool_t cache_start(void) {
 		pool_set_obj(cache_pool, i, object);
 	}
 
-	return true;
+	return cache_near_start();
 }
 
 /**
@@ -105,6 +106,8 @@ void cache_stop(void) {
 
 	memcached_st *object;
 
+	cache_near_stop();
+
 	// Destroy the objects.
 	for (uint32_t i = 0; i < magma.iface.cache.pool.connections; i++) {
 		if ((object = pool_get_obj(cache_pool, i))) memcached_free_d(object);
@@ -126,6 +129,8 @@ void cache_flush(void) {
 	uint32_t pool;
 	memcached_return_t e;
 
+	cache_near_flush();
+
 	if ((pool_pull(cache_pool, &pool)) != PL_RESERVED) {
 		return;
 	}
@@ -139,6 +144,7 @@ void cache_flush(void) {
 
 /**
  * @brief	Retrieve data from memcached by key.
+ * @note	If the near cache holds a recent copy of the data, it is returned without contacting memcached.
  * @param	key		a managed string containing a key to be passed to memcached.
  * @return	NULL on failure, or a pointer to a managed string containing the cached data on success.
  */
@@ -147,10 +153,14 @@ stringer_t * cache_get(stringer_t *key) {
 	void *data;
 	size_t length = 0;
 	uint32_t flags = 0, pool;
+	uint64_t token = cache_near_token();
 	stringer_t *result;
 	memcached_return_t error;
 
-	if (st_empty(key) || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
+	if ((result = cache_near_get(key))) {
+		return result;
+	}
+	else if (st_empty(key) || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
 		return NULL;
 	}
 	else if (!(data = memcached_get_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), &length, &flags, &error))) {
@@ -174,9 +184,95 @@ stringer_t * cache_get(stringer_t *key) {
 	result = st_import(data, length);
 	mm_free(data);
 
+	cache_near_set(key, result, token);
+
 	return result;
 }
 
+/**
+ * @brief	Retrieve several keys from memcached using a single request.
+ * @note	Keys held by the near cache are answered locally, and the remaining keys are fetched from memcached in a single batch.
+ * @param	count	the number of keys being retrieved.
+ * @param	keys	an array of managed strings containing the keys to be retrieved.
+ * @param	values	an array which will receive a managed string for each key found, or NULL for each key which couldn't be found.
+ * @return	the number of keys which were found.
+ */
+size_t cache_get_multi(size_t count, stringer_t **keys, stringer_t **values) {
+
+	uint32_t flags, pool;
+	memcached_return_t error;
+	uint64_t token = cache_near_token();
+	chr_t key[MEMCACHED_MAX_KEY], *data, **pending = NULL;
+	size_t length, klength, found = 0, missing = 0, *lengths = NULL, *indexes = NULL;
+
+	if (!count || !keys || !values) {
+		return 0;
+	}
+
+	mm_wipe(values, sizeof(stringer_t *) * count);
+
+	if (!(pending = mm_alloc(sizeof(chr_t *) * count)) || !(lengths = mm_alloc(sizeof(size_t) * count)) ||
+		!(indexes = mm_alloc(sizeof(size_t) * count))) {
+		log_pedantic("Unable to allocate memory for a multiple key cache request. { count = %zu }", count);
+		mm_cleanup(pending, lengths);
+		return 0;
+	}
+
+	// Answer what we can using the near cache, and queue the rest.
+	for (size_t i = 0; i < count; i++) {
+		if (st_empty(keys[i])) {
+			continue;
+		}
+		else if ((values[i] = cache_near_get(keys[i]))) {
+			found++;
+		}
+		else {
+			pending[missing] = st_char_get(keys[i]);
+			lengths[missing] = st_length_get(keys[i]);
+			indexes[missing++] = i;
+		}
+	}
+
+	if (missing && (pool_pull(cache_pool, &pool)) == PL_RESERVED) {
+
+		if ((error = memcached_mget_d(pool_get_obj(cache_pool, pool), (const char * const *)pending, lengths, missing)) != MEMCACHED_SUCCESS) {
+			log_info("An error occurred while trying to fetch %zu objects. {%s}", missing, memcached_strerror_d(pool_get_obj(cache_pool, pool), error));
+		}
+		else {
+
+			stats_increment_by_name("provider.cache.multi.requests");
+			stats_adjust_by_name("provider.cache.multi.keys", missing);
+
+			// The results must be drained, even if they aren't all needed, otherwise the next request on this connection will fail.
+			while ((data = memcached_fetch_d(pool_get_obj(cache_pool, pool), key, &klength, &length, &flags, &error))) {
+
+				for (size_t i = 0; length && i < missing; i++) {
+					if (!values[indexes[i]] && lengths[i] == klength && !memcmp(pending[i], key, klength) &&
+						(values[indexes[i]] = st_import(data, length))) {
+						cache_near_set(keys[indexes[i]], values[indexes[i]], token);
+						found++;
+						break;
+					}
+				}
+
+				mm_free(data);
+			}
+
+			if (error != MEMCACHED_END && error != MEMCACHED_SUCCESS && error != MEMCACHED_NOTFOUND) {
+				log_info("An error occurred while trying to fetch %zu objects. {%s}", missing, memcached_strerror_d(pool_get_obj(cache_pool, pool), error));
+			}
+		}
+
+		pool_release(cache_pool, pool);
+	}
+
+	mm_free(pending);
+	mm_free(lengths);
+	mm_free(indexes);
+
+	return found;
+}
+
 /**
  * @brief	Retrieve a 64 bit value from memcached by key.
  * @param	key		a managed string containing a key to be passed to memcached.
@@ -186,11 +282,18 @@ uint64_t cache_get_u64(stringer_t *key) {
 
 	void *data;
 	size_t length = 0;
-	uint64_t result = 0;
+	uint64_t result = 0, token = cache_near_token();
 	uint32_t flags = 0, pool;
+	stringer_t *near;
 	memcached_return_t error;
 
-	if (st_empty(key) || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
+	// The near cache holds the raw value, so it's checked using the same rules as the data returned by memcached.
+	if ((near = cache_near_get(key))) {
+		if (st_length_get(near) == sizeof(uint64_t)) result = *((uint64_t *)st_data_get(near));
+		st_free(near);
+		return result;
+	}
+	else if (st_empty(key) || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
 		return 0;
 	}
 	else if ((data = memcached_get_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), &length, &flags, &error)) == NULL) {
@@ -216,6 +319,7 @@ uint64_t cache_get_u64(stringer_t *key) {
 	}
 
 	pool_release(cache_pool, pool);
+	cache_near_set(key, PLACER(data, length), token);
 	mm_free(data);
 
 	return result;
@@ -239,9 +343,12 @@ int_t cache_set(stringer_t *key, stringer_t *object, time_t expiration) {
 	else if ((ret = memcached_set_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), st_char_get(object), st_length_get(object), expiration, 0)) != MEMCACHED_SUCCESS) {
 		log_info("Unable to store the %.*s object. {%s}", st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), ret));
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+	cache_near_broadcast();
 	return 1;
 }
 
@@ -263,9 +370,12 @@ int_t cache_set_u64(stringer_t *key, uint64_t value, time_t expiration) {
 	else if ((ret = memcached_set_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), (void *)&value, sizeof(uint64_t), expiration, 0)) != MEMCACHED_SUCCESS) {
 		log_info("Unable to store the %.*s object. {%s}", st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), ret));
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+	cache_near_broadcast();
 	return 1;
 }
 
@@ -286,9 +396,12 @@ int_t cache_add(stringer_t *key, stringer_t *object, time_t expiration) {
 	else if ((ret = memcached_add_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), st_char_get(object), st_length_get(object), expiration, 0)) != MEMCACHED_SUCCESS) {
 		log_info("Unable to store the %.*s object. {%s}", st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), ret));
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+	cache_near_broadcast();
 	return 1;
 }
 
@@ -308,9 +421,12 @@ int_t cache_silent_add(stringer_t *key, stringer_t *object, time_t expiration) {
 	}
 	else if ((ret = memcached_add_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), st_char_get(object), st_length_get(object), expiration, 0)) != MEMCACHED_SUCCESS) {
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+	cache_near_broadcast();
 	return 1;
 }
 
@@ -332,15 +448,19 @@ int_t cache_append(stringer_t *key, stringer_t *object, time_t expiration) {
 		if (val == MEMCACHED_NOTSTORED && (val = memcached_add_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), st_char_get(object), st_length_get(object), expiration, 0)) != MEMCACHED_SUCCESS) {
 			log_info("Unable to append to the %.*s object. {%s}", st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), val));
 			pool_release(cache_pool, pool);
+			cache_near_delete(key);
 			return 0;
 		}
 		else if (val != MEMCACHED_NOTSTORED) {
 			log_info("Unable to append to the %.*s object. {%s}",  st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), val));
 			pool_release(cache_pool, pool);
+			cache_near_delete(key);
 			return 0;
 		}
 	}
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+	cache_near_broadcast();
 	return 1;
 }
 
@@ -361,9 +481,12 @@ int_t cache_delete(stringer_t *key) {
 	else if ((val = memcached_delete_d(pool_get_obj(cache_pool, pool), st_char_get(key), st_length_get(key), 0)) != MEMCACHED_SUCCESS) {
 		log_info("Unable to delete the %.*s object. {%s}", st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), val));
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+	cache_near_broadcast();
 	return 1;
 }
 
@@ -381,10 +504,14 @@ int_t cache_delete(stringer_t *key) {
 uint64_t cache_increment(stringer_t *key, uint64_t offset, uint64_t initial, time_t expiration) {
 
 	uint32_t pool;
-	uint64_t output = initial;
+	uint64_t output = initial, token = cache_near_token();
 	memcached_return_t val;
 
-	if (st_empty(key) || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
+	// An offset of zero is used to read a counter, which the near cache may be able to answer.
+	if (!offset && cache_near_get_u64(key, &output)) {
+		return output;
+	}
+	else if (st_empty(key) || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
 		return 0;
 	}
 	// Try incrementing. If we can't, try creating the key.
@@ -394,10 +521,25 @@ uint64_t cache_increment(stringer_t *key, uint64_t offset, uint64_t initial, tim
 		log_pedantic("Unable to increment the %.*s object. { error = %s }", st_length_int(key), st_char_get(key),
 			memcached_strerror_d(pool_get_obj(cache_pool, pool), val));
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 
 	pool_release(cache_pool, pool);
+
+	// Only reads confirmed by memcached are stored, since the initial value is returned if a missing key couldn't be added. The
+	// totals returned by concurrent increments can arrive in any order, so an increment only invalidates the entry.
+	if (!offset && val == MEMCACHED_SUCCESS && output) {
+		cache_near_set_u64(key, output, token);
+	}
+	else {
+		cache_near_delete(key);
+	}
+
+	if (offset && val == MEMCACHED_SUCCESS) {
+		cache_near_broadcast();
+	}
+
 	return output;
 }
 
@@ -427,9 +569,16 @@ uint64_t cache_decrement(stringer_t *key, uint64_t offset, uint64_t initial, tim
 
 		log_pedantic("Unable to decrement the %.*s object. { error = %s }", st_length_int(key), st_char_get(key), memcached_strerror_d(pool_get_obj(cache_pool, pool), val));
 		pool_release(cache_pool, pool);
+		cache_near_delete(key);
 		return 0;
 	}
 
 	pool_release(cache_pool, pool);
+	cache_near_delete(key);
+
+	if (val == MEMCACHED_SUCCESS) {
+		cache_near_broadcast();
+	}
+
 	return output;
 }
@@ -14,6 +14,29 @@ typedef struct __attribute__ ((packed)) {
 	stringer_t *data;
 } serialization_t;
 
+// The memcached key used to broadcast near cache invalidations.
+#define CACHE_NEAR_BROADCAST_KEY "magma.cache.near.broadcast"
+
+enum {
+	CACHE_NEAR_EMPTY = 0,
+	CACHE_NEAR_DATA = 1,
+	CACHE_NEAR_COUNTER = 2
+};
+
+typedef struct {
+	uint32_t kind; /* Whether the slot is empty, or holds a data object or a counter value. */
+	uint64_t epoch; /* The near cache generation the slot was stored during. */
+	uint64_t version; /* The version assigned when the slot was last invalidated. Fills using an older token are refused. */
+	time_t expiration; /* When the slot should stop being trusted. */
+	stringer_t *key;
+	union {
+		stringer_t *data;
+		uint64_t value;
+	};
+} cache_near_slot_t;
+
+extern pool_t *cache_pool;
+
 /// cache.c
 int_t         cache_add(stringer_t *key, stringer_t *object, time_t expiration);
 int_t         cache_append(stringer_t *key, stringer_t *object, time_t expiration);
@@ -21,6 +44,7 @@ uint64_t      cache_decrement(stringer_t *key, uint64_t offset, uint64_t initial
 int_t         cache_delete(stringer_t *key);
 void          cache_flush(void);
 stringer_t *  cache_get(stringer_t *key);
+size_t        cache_get_multi(size_t count, stringer_t **keys, stringer_t **values);
 uint64_t      cache_get_u64(stringer_t *key);
 uint64_t      cache_increment(stringer_t *key, uint64_t offset, uint64_t initial, time_t expiration);
 int_t         cache_set(stringer_t *key, stringer_t *object, time_t expiration);
@@ -31,6 +55,22 @@ void          cache_stop(void);
 bool_t        lib_load_cache(void);
 const         char * lib_version_cache(void);
 
+/// near.c
+void                 cache_near_broadcast(void);
+void                 cache_near_clear(cache_near_slot_t *slot);
+void                 cache_near_delete(stringer_t *key);
+bool_t               cache_near_enabled(void);
+void                 cache_near_flush(void);
+stringer_t *         cache_near_get(stringer_t *key);
+bool_t               cache_near_get_u64(stringer_t *key, uint64_t *value);
+uint64_t             cache_near_hash(stringer_t *key);
+void                 cache_near_poll(void);
+void                 cache_near_set(stringer_t *key, stringer_t *data, uint64_t token);
+void                 cache_near_set_u64(stringer_t *key, uint64_t value, uint64_t token);
+bool_t               cache_near_start(void);
+void                 cache_near_stop(void);
+uint64_t             cache_near_token(void);
+
 //! Serialization
 bool_t serialize_sz (stringer_t **data, size_t number);
 bool_t serialize_ssz (stringer_t **data, ssize_t number);
@@ -0,0 +1,382 @@
+
+/**
+ * @file /magma/providers/consumers/near.c
+ *
+ * @brief	A bounded, in-process cache which sits in front of memcached, so values which are read repeatedly, like the object serial
+ * 			numbers, don't need a network round trip every time they are checked.
+ *
+ * @note	The near cache is a fixed size table, where each key maps to a single slot, so storing a key will replace whatever was held
+ * 			in its slot. Entries are only trusted for a short period of time. Changes made by this process update, or invalidate the
+ * 			relevant slot immediately, while changes made by other cluster nodes only become visible once the entry expires. If the
+ * 			broadcast option is enabled, every change is also announced by incrementing a shared counter in memcached, and any process
+ * 			which notices the counter has moved discards its entire near cache.
+ *
+ * 			Entries are filled using fill tokens, so a reader can't store a value it fetched before a concurrent write. A reader takes a
+ * 			token using cache_near_token() before contacting memcached, and passes it to cache_near_set() along with the result. Every
+ * 			invalidation stamps the affected slot with a fresh version from a global counter, and a flush records the version it
+ * 			happened at, so the store is refused if the slot was invalidated, or the cache was flushed, after the token was taken.
+ * 			Writers only need to call cache_near_delete() once memcached has confirmed, or rejected, the change.
+ */
+
+#include "magma.h"
+
+struct {
+	uint64_t epoch; /* The current cache generation. Entries stored during an earlier generation are considered stale. */
+	uint64_t version; /* The source of fill tokens, which is advanced by every invalidation. */
+	uint64_t flushed; /* The version at which the cache was last flushed. */
+	uint64_t shared; /* The value of the shared invalidation counter when it was last checked. */
+	time_t polled; /* When the shared invalidation counter was last checked. */
+	slotted_t *table; /* The slot table, or NULL if the near cache is disabled. */
+} near = {
+	.epoch = 1,
+	.version = 0,
+	.flushed = 0,
+	.shared = 0,
+	.polled = 0,
+	.table = NULL
+};
+
+/**
+ * @brief	Allocate the near cache table.
+ * @note	If either magma.iface.cache.near.entries or magma.iface.cache.near.timeout is set to zero, the near cache is disabled
+ * 			and every request is passed through to memcached.
+ * @return	true on success or false on failure.
+ */
+bool_t cache_near_start(void) {
+
+	if (!magma.iface.cache.near.entries || !magma.iface.cache.near.timeout) {
+		return true;
+	}
+	else if (!(near.table = slotted_alloc(magma.iface.cache.near.entries, sizeof(cache_near_slot_t), false, &cache_near_clear))) {
+		log_critical("Could not allocate memory for the near cache. { entries = %u }", magma.iface.cache.near.entries);
+		return false;
+	}
+
+	near.polled = time(NULL);
+
+	return true;
+}
+
+/**
+ * @brief	Free the near cache table and all of the entries it holds.
+ * @return	This function returns no value.
+ */
+void cache_near_stop(void) {
+
+	slotted_t *table = near.table;
+
+	if (!table) {
+		return;
+	}
+
+	near.table = NULL;
+	slotted_free(table);
+
+	return;
+}
+
+/**
+ * @brief	Determine whether the near cache is active.
+ * @return	true if the near cache is enabled, or false if requests are always passed through to memcached.
+ */
+bool_t cache_near_enabled(void) {
+
+	return near.table ? true : false;
+}
+
+/**
+ * @brief	Release the strings held by a near cache slot.
+ * @note	This is the clear function for the near cache slot table, and is called with the lock protecting the slot held.
+ * @param	slot	the slot being cleared.
+ * @return	This function returns no value.
+ */
+void cache_near_clear(cache_near_slot_t *slot) {
+
+	st_cleanup(slot->key);
+
+	if (slot->kind == CACHE_NEAR_DATA) {
+		st_cleanup(slot->data);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Discard every entry in the near cache.
+ * @note	The entries aren't released until their slots are reused, incrementing the generation is enough to make them invisible.
+ * @return	This function returns no value.
+ */
+void cache_near_flush(void) {
+
+	if (near.table) {
+		__sync_add_and_fetch(&(near.epoch), 1);
+		near.flushed = __sync_add_and_fetch(&(near.version), 1);
+		stats_increment_by_name("provider.cache.near.flushes");
+	}
+
+	return;
+}
+
+/**
+ * @brief	Check whether another process has announced a change using the shared invalidation counter, and if so flush the near cache.
+ * @note	The shared counter is checked at most once per second, by a single thread.
+ * @return	This function returns no value.
+ */
+void cache_near_poll(void) {
+
+	time_t now, polled;
+	uint32_t pool;
+	uint64_t value = 0;
+
+	if (!magma.iface.cache.near.broadcast || (now = time(NULL)) == (polled = near.polled) ||
+		!__sync_bool_compare_and_swap(&(near.polled), polled, now)) {
+		return;
+	}
+	else if ((pool_pull(cache_pool, &pool)) != PL_RESERVED) {
+		return;
+	}
+	else if (memcached_increment_with_initial_d(pool_get_obj(cache_pool, pool), CACHE_NEAR_BROADCAST_KEY, ns_length_get(CACHE_NEAR_BROADCAST_KEY),
+		0, 0, 0, &value) != MEMCACHED_SUCCESS) {
+		pool_release(cache_pool, pool);
+		return;
+	}
+
+	pool_release(cache_pool, pool);
+
+	if (value != near.shared) {
+		near.shared = value;
+		cache_near_flush();
+	}
+
+	return;
+}
+
+/**
+ * @brief	Announce a change to the other processes sharing the memcached servers, if broadcasting is enabled.
+ * @note	If the shared counter was only advanced by this process, the local near cache is left alone, since the caller is expected
+ * 			to have already updated the slot for the modified key.
+ * @return	This function returns no value.
+ */
+void cache_near_broadcast(void) {
+
+	uint32_t pool;
+	uint64_t value = 0, previous = near.shared;
+
+	if (!near.table || !magma.iface.cache.near.broadcast || (pool_pull(cache_pool, &pool)) != PL_RESERVED) {
+		return;
+	}
+	else if (memcached_increment_with_initial_d(pool_get_obj(cache_pool, pool), CACHE_NEAR_BROADCAST_KEY, ns_length_get(CACHE_NEAR_BROADCAST_KEY),
+		1, 1, 0, &value) != MEMCACHED_SUCCESS) {
+		log_pedantic("Unable to broadcast a near cache invalidation.");
+		pool_release(cache_pool, pool);
+		return;
+	}
+
+	pool_release(cache_pool, pool);
+
+	// If another process advanced the counter in the meantime, the next poll will notice and flush the near cache.
+	if (value == previous + 1) {
+		__sync_bool_compare_and_swap(&(near.shared), previous, value);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Calculate the hash which selects the near cache slot for a key.
+ * @param	key		a managed string containing the cache key.
+ * @return	the hash of the key.
+ */
+uint64_t cache_near_hash(stringer_t *key) {
+
+	return hash_murmur64(st_data_get(key), st_length_get(key));
+}
+
+/**
+ * @brief	Take a fill token, which must be passed to cache_near_set() or cache_near_set_u64() when storing a value fetched from memcached.
+ * @note	The token must be taken before the request is sent to memcached.
+ * @return	the current near cache version.
+ */
+uint64_t cache_near_token(void) {
+
+	return __sync_add_and_fetch(&(near.version), 0);
+}
+
+/**
+ * @brief	Retrieve a copy of the data cached for a key.
+ * @param	key		a managed string containing the cache key.
+ * @return	NULL if the key isn't in the near cache, or has expired, otherwise a managed string holding a copy of the cached data.
+ */
+stringer_t * cache_near_get(stringer_t *key) {
+
+	stringer_t *result = NULL;
+	cache_near_slot_t *slot;
+	uint64_t hash;
+
+	if (!near.table || st_empty(key)) {
+		return NULL;
+	}
+
+	cache_near_poll();
+	hash = cache_near_hash(key);
+	slot = slotted_lock(near.table, hash);
+
+	if (slot->kind == CACHE_NEAR_DATA && slot->epoch == near.epoch && slot->expiration > time(NULL) && !st_cmp_cs_eq(slot->key, key)) {
+		result = st_dupe(slot->data);
+	}
+
+	slotted_unlock(near.table, hash);
+
+	stats_increment_by_name(result ? "provider.cache.near.hits" : "provider.cache.near.misses");
+
+	return result;
+}
+
+/**
+ * @brief	Retrieve the counter value cached for a key.
+ * @param	key		a managed string containing the cache key.
+ * @param	value	a pointer to a 64 bit integer which will receive the counter value.
+ * @return	true if the value was found, or false if the key isn't in the near cache, or has expired.
+ */
+bool_t cache_near_get_u64(stringer_t *key, uint64_t *value) {
+
+	bool_t result = false;
+	cache_near_slot_t *slot;
+	uint64_t hash;
+
+	if (!near.table || st_empty(key)) {
+		return false;
+	}
+
+	cache_near_poll();
+	hash = cache_near_hash(key);
+	slot = slotted_lock(near.table, hash);
+
+	if (slot->kind == CACHE_NEAR_COUNTER && slot->epoch == near.epoch && slot->expiration > time(NULL) && !st_cmp_cs_eq(slot->key, key)) {
+		*value = slot->value;
+		result = true;
+	}
+
+	slotted_unlock(near.table, hash);
+
+	stats_increment_by_name(result ? "provider.cache.near.hits" : "provider.cache.near.misses");
+
+	return result;
+}
+
+/**
+ * @brief	Store a copy of the data associated with a key in the near cache.
+ * @param	key		a managed string containing the cache key.
+ * @param	data	a managed string containing the data returned by memcached.
+ * @param	token	the fill token taken before the data was requested from memcached.
+ * @return	This function returns no value.
+ */
+void cache_near_set(stringer_t *key, stringer_t *data, uint64_t token) {
+
+	cache_near_slot_t *slot;
+	uint64_t hash, version;
+	stringer_t *copy, *value;
+
+	if (!near.table || st_empty(key) || st_empty(data)) {
+		return;
+	}
+	else if (!(copy = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, key)) || !(value = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, data))) {
+		log_pedantic("Unable to copy the %.*s object into the near cache.", st_length_int(key), st_char_get(key));
+		st_cleanup(copy);
+		return;
+	}
+
+	hash = cache_near_hash(key);
+	slot = slotted_lock(near.table, hash);
+
+	if ((version = slot->version) > token || near.flushed > token) {
+		slotted_unlock(near.table, hash);
+		st_free(copy);
+		st_free(value);
+		return;
+	}
+
+	slotted_clear(near.table, slot);
+	slot->kind = CACHE_NEAR_DATA;
+	slot->version = version;
+	slot->epoch = near.epoch;
+	slot->expiration = time(NULL) + magma.iface.cache.near.timeout;
+	slot->key = copy;
+	slot->data = value;
+	slotted_unlock(near.table, hash);
+
+	return;
+}
+
+/**
+ * @brief	Store the counter value associated with a key in the near cache.
+ * @param	key		a managed string containing the cache key.
+ * @param	value	the counter value returned by memcached.
+ * @param	token	the fill token taken before the value was requested from memcached.
+ * @return	This function returns no value.
+ */
+void cache_near_set_u64(stringer_t *key, uint64_t value, uint64_t token) {
+
+	stringer_t *copy;
+	cache_near_slot_t *slot;
+	uint64_t hash, version;
+
+	if (!near.table || st_empty(key)) {
+		return;
+	}
+	else if (!(copy = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, key))) {
+		log_pedantic("Unable to copy the %.*s counter into the near cache.", st_length_int(key), st_char_get(key));
+		return;
+	}
+
+	hash = cache_near_hash(key);
+	slot = slotted_lock(near.table, hash);
+
+	if ((version = slot->version) > token || near.flushed > token) {
+		slotted_unlock(near.table, hash);
+		st_free(copy);
+		return;
+	}
+
+	slotted_clear(near.table, slot);
+	slot->kind = CACHE_NEAR_COUNTER;
+	slot->version = version;
+	slot->epoch = near.epoch;
+	slot->expiration = time(NULL) + magma.iface.cache.near.timeout;
+	slot->key = copy;
+	slot->value = value;
+	slotted_unlock(near.table, hash);
+
+	return;
+}
+
+/**
+ * @brief	Remove a key from the near cache, so the next request is passed through to memcached.
+ * @note	The slot is given a new version even if it holds a different key, so any fill of this key which is already in flight
+ * 			will be refused.
+ * @param	key		a managed string containing the cache key.
+ * @return	This function returns no value.
+ */
+void cache_near_delete(stringer_t *key) {
+
+	cache_near_slot_t *slot;
+	uint64_t hash, version;
+
+	if (!near.table || st_empty(key)) {
+		return;
+	}
+
+	hash = cache_near_hash(key);
+	slot = slotted_lock(near.table, hash);
+	version = __sync_add_and_fetch(&(near.version), 1);
+
+	if (slot->kind && !st_cmp_cs_eq(slot->key, key)) {
+		slotted_clear(near.table, slot);
+	}
+
+	slot->version = version;
+
+	slotted_unlock(near.table, hash);
+
+	return;
+}
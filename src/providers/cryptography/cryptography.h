@@ -24,6 +24,14 @@
 #define ECIES_CIPHER NID_aes_256_cbc
 #define ECIES_ENVELOPE NID_sha512
 
+// The number of session ticket keys kept in memory, and how often, in seconds, a shared ticket key file is checked for changes.
+#define TLS_TICKET_KEYS 3
+#define TLS_TICKET_FILE_CHECK 60
+
+// The directions of a connection whose record layer has been handed to the kernel.
+#define KTLS_TX 1
+#define KTLS_RX 2
+
 typedef enum {
 	ECIES_PRIVATE_HEX = 1,
 	ECIES_PRIVATE_BINARY = 2,
@@ -58,6 +66,12 @@ typedef struct __attribute__ ((packed)) {
 
 } scramble_head_t;
 
+typedef struct __attribute__ ((packed)) {
+	uchr_t name[16];
+	uchr_t hmac[32];
+	uchr_t aes[32];
+} tls_ticket_key_t;
+
 typedef void * digest_t;
 typedef void * cipher_t;
 typedef char * cryptex_t;
@@ -157,6 +171,7 @@ void *        tls_client_alloc(int_t sockd);
 int           tls_continue(TLS *tls, int result, int syserror);
 stringer_t *  tls_error(TLS *tls, int_t code, stringer_t *output);
 void          tls_free(TLS *tls);
+int           tls_pending(TLS *tls);
 int           tls_print(TLS *tls, const char *format, va_list args);
 int           tls_read(TLS *tls, void *buffer, int length, bool_t block);
 TLS *         tls_server_alloc(void *server, int sockd, int flags);
@@ -167,6 +182,21 @@ chr_t *       tls_suite(TLS *tls);
 chr_t *       tls_version(TLS *tls);
 int           tls_write(TLS *tls, const void *buffer, int length, bool_t block);
 
+/// tickets.c
+int      tls_tickets_callback(SSL *tls, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cipher, HMAC_CTX *hmac, int encrypt);
+bool_t   tls_tickets_enabled(void);
+bool_t   tls_tickets_load(chr_t *path);
+void     tls_tickets_refresh(void);
+bool_t   tls_tickets_rotate(void);
+bool_t   tls_tickets_start(void);
+void     tls_tickets_stop(void);
+
+/// ktls.c
+bool_t   ktls_available(void);
+void     ktls_close(TLS *tls, int sockd, int_t mode);
+int_t    ktls_enable(TLS *tls, int sockd);
+bool_t   ktls_prf(const EVP_MD *md, uchr_t *secret, size_t secret_len, chr_t *label, uchr_t *seed, size_t seed_len, uchr_t *output, size_t length);
+
 /// random.c
 bool_t        rand_start(void);
 bool_t        rand_thread_start(void);
@@ -0,0 +1,301 @@
+
+/**
+ * @file /magma/providers/cryptography/ktls.c
+ *
+ * @brief	Functions used to hand the TLS record layer of a connection over to the kernel, once OpenSSL has completed the handshake.
+ *
+ * @note	With kernel TLS the socket accepts, and returns, plain text, and the kernel handles the record encryption. The session keys
+ * 			are derived from the master secret using the TLS 1.2 PRF, so only TLS 1.2 connections using an AES-GCM cipher suite can be
+ * 			offloaded. Everything else, including systems without the tls kernel module, keeps using OpenSSL. Because the record sequence
+ * 			numbers are only exposed by the OpenSSL 1.0 structures, the offload is disabled when building against a newer release.
+ */
+
+#include "magma.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#endif
+#endif
+
+// Older C libraries don't define the socket options used to configure kernel TLS.
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+/**
+ * @brief	Expand a secret using the TLS 1.2 pseudo random function (RFC 5246, section 5).
+ * @param	md			the digest used by the negotiated cipher suite.
+ * @param	secret		the secret being expanded.
+ * @param	secret_len	the length of the secret, in bytes.
+ * @param	label		a null terminated string holding the label.
+ * @param	seed		the seed value, which is appended to the label.
+ * @param	seed_len	the length of the seed, in bytes.
+ * @param	output		a buffer to receive the expanded secret.
+ * @param	length		the number of bytes to generate.
+ * @return	true on success, or false on failure.
+ */
+bool_t ktls_prf(const EVP_MD *md, uchr_t *secret, size_t secret_len, chr_t *label, uchr_t *seed, size_t seed_len, uchr_t *output, size_t length) {
+
+	HMAC_CTX hmac;
+	bool_t result = true;
+	size_t label_len = ns_length_get(label);
+	uint_t a_len = 0, block_len = 0;
+	uchr_t a[EVP_MAX_MD_SIZE], block[EVP_MAX_MD_SIZE];
+
+	HMAC_CTX_init_d(&hmac);
+
+	// A(1) = HMAC(secret, label + seed)
+	if (!HMAC_Init_ex_d(&hmac, secret, secret_len, md, NULL) || !HMAC_Update_d(&hmac, (uchr_t *)label, label_len) ||
+		!HMAC_Update_d(&hmac, seed, seed_len) || !HMAC_Final_d(&hmac, a, &a_len)) {
+		result = false;
+	}
+
+	for (size_t position = 0; result && position < length; position += block_len) {
+
+		// P_hash = HMAC(secret, A(i) + label + seed) + ..., then A(i + 1) = HMAC(secret, A(i))
+		if (!HMAC_Init_ex_d(&hmac, secret, secret_len, md, NULL) || !HMAC_Update_d(&hmac, a, a_len) ||
+			!HMAC_Update_d(&hmac, (uchr_t *)label, label_len) || !HMAC_Update_d(&hmac, seed, seed_len) ||
+			!HMAC_Final_d(&hmac, block, &block_len) || !HMAC_Init_ex_d(&hmac, secret, secret_len, md, NULL) ||
+			!HMAC_Update_d(&hmac, a, a_len) || !HMAC_Final_d(&hmac, a, &a_len)) {
+			result = false;
+		}
+		else {
+			mm_copy(output + position, block, (length - position) < block_len ? (length - position) : block_len);
+		}
+	}
+
+	HMAC_CTX_cleanup_d(&hmac);
+	mm_wipe(block, sizeof(block));
+	mm_wipe(a, sizeof(a));
+
+	return result;
+}
+
+#if defined(TLS_TX) && defined(TLS_RX) && defined(TLS_CIPHER_AES_GCM_256) && OPENSSL_VERSION_NUMBER < 0x10100000L
+
+/**
+ * @brief	Determine whether connections can be offloaded to the kernel.
+ * @note	The kernel lists the upper layer protocols which can be attached to a TCP socket, and "tls" is only listed once the tls
+ * 			kernel module has been loaded.
+ * @return	true if this build supports kernel TLS and the kernel provides it, otherwise false.
+ */
+bool_t ktls_available(void) {
+
+	FILE *file;
+	bool_t result = false;
+	chr_t line[256];
+
+	if ((file = fopen("/proc/sys/net/ipv4/tcp_available_ulp", "r"))) {
+		result = (fgets(line, sizeof(line), file) && strstr(line, "tls"));
+		fclose(file);
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Install the negotiated record layer keys on a socket, so the kernel handles the encryption and decryption of application data.
+ * @note	This function must be called immediately after the handshake, before any application data has been exchanged. The receive side
+ * 			is only offloaded if OpenSSL isn't holding any buffered data.
+ * @param	tls		the TLS connection which completed the handshake.
+ * @param	sockd	the socket descriptor underlying the TLS connection.
+ * @return	a mask of KTLS_TX and KTLS_RX indicating which directions were offloaded, or 0 if the connection must keep using OpenSSL.
+ */
+int_t ktls_enable(TLS *tls, int sockd) {
+
+	int_t result = 0;
+	size_t key_len;
+	const EVP_MD *md;
+	const char *name;
+	const SSL_CIPHER *cipher;
+	uchr_t seed[SSL3_RANDOM_SIZE * 2], block[32 * 2 + 4 * 2];
+	uchr_t *client_key, *server_key, *client_salt, *server_salt;
+	union {
+		struct tls12_crypto_info_aes_gcm_128 aes128;
+		struct tls12_crypto_info_aes_gcm_256 aes256;
+	} info;
+
+	if (!tls || sockd < 0 || !tls->s3 || !tls->session || tls->version != TLS1_2_VERSION ||
+		!(cipher = SSL_get_current_cipher_d(tls)) || !(name = SSL_CIPHER_get_name_d(cipher))) {
+		stats_increment_by_name("provider.tls.kernel.fallback");
+		return 0;
+	}
+
+	// The AEAD cipher suites don't use MAC keys, so the key block only holds the write keys, and the implicit nonce salts.
+	else if (strstr(name, "AES128-GCM-SHA256")) {
+		key_len = 16;
+		md = EVP_sha256_d();
+	}
+	else if (strstr(name, "AES256-GCM-SHA384")) {
+		key_len = 32;
+		md = EVP_sha384_d();
+	}
+	else {
+		stats_increment_by_name("provider.tls.kernel.fallback");
+		return 0;
+	}
+
+	mm_copy(seed, tls->s3->server_random, SSL3_RANDOM_SIZE);
+	mm_copy(seed + SSL3_RANDOM_SIZE, tls->s3->client_random, SSL3_RANDOM_SIZE);
+
+	if (!ktls_prf(md, tls->session->master_key, tls->session->master_key_length, "key expansion", seed, sizeof(seed), block,
+		(key_len * 2) + 8)) {
+		log_pedantic("Unable to derive the TLS record layer keys. { error = %s }", ssl_error_string(MEMORYBUF(256), 256));
+		stats_increment_by_name("provider.tls.kernel.fallback");
+		mm_wipe(block, sizeof(block));
+		return 0;
+	}
+
+	client_key = block;
+	server_key = block + key_len;
+	client_salt = block + (key_len * 2);
+	server_salt = client_salt + 4;
+
+	// Attaching the upper layer protocol fails if the tls kernel module isn't available. Until a key is installed, the socket
+	// continues to behave normally, so falling back at this point is safe.
+	if (setsockopt(sockd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls"))) {
+		stats_increment_by_name("provider.tls.kernel.fallback");
+		mm_wipe(block, sizeof(block));
+		return 0;
+	}
+
+	// The explicit nonce only needs to be unique, so like OpenSSL, we start with the record sequence number.
+	mm_wipe(&info, sizeof(info));
+
+	if (key_len == 16) {
+		info.aes128.info.version = TLS_1_2_VERSION;
+		info.aes128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+		mm_copy(info.aes128.key, server_key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+		mm_copy(info.aes128.salt, server_salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+		mm_copy(info.aes128.iv, tls->s3->write_sequence, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+		mm_copy(info.aes128.rec_seq, tls->s3->write_sequence, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+	}
+	else {
+		info.aes256.info.version = TLS_1_2_VERSION;
+		info.aes256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+		mm_copy(info.aes256.key, server_key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+		mm_copy(info.aes256.salt, server_salt, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+		mm_copy(info.aes256.iv, tls->s3->write_sequence, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+		mm_copy(info.aes256.rec_seq, tls->s3->write_sequence, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+	}
+
+	if (!setsockopt(sockd, SOL_TLS, TLS_TX, &info, key_len == 16 ? sizeof(info.aes128) : sizeof(info.aes256))) {
+		result |= KTLS_TX;
+	}
+
+	// If OpenSSL has already read part of the next record, the kernel wouldn't be able to decrypt the stream.
+	if (!SSL_pending_d(tls) && !tls->s3->rbuf.left) {
+
+		mm_wipe(&info, sizeof(info));
+
+		if (key_len == 16) {
+			info.aes128.info.version = TLS_1_2_VERSION;
+			info.aes128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+			mm_copy(info.aes128.key, client_key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+			mm_copy(info.aes128.salt, client_salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+			mm_copy(info.aes128.iv, tls->s3->read_sequence, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+			mm_copy(info.aes128.rec_seq, tls->s3->read_sequence, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+		}
+		else {
+			info.aes256.info.version = TLS_1_2_VERSION;
+			info.aes256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+			mm_copy(info.aes256.key, client_key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+			mm_copy(info.aes256.salt, client_salt, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+			mm_copy(info.aes256.iv, tls->s3->read_sequence, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+			mm_copy(info.aes256.rec_seq, tls->s3->read_sequence, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+		}
+
+		if (!setsockopt(sockd, SOL_TLS, TLS_RX, &info, key_len == 16 ? sizeof(info.aes128) : sizeof(info.aes256))) {
+			result |= KTLS_RX;
+		}
+	}
+
+	mm_wipe(&info, sizeof(info));
+	mm_wipe(block, sizeof(block));
+
+	stats_increment_by_name(result ? "provider.tls.kernel.offloaded" : "provider.tls.kernel.fallback");
+
+	return result;
+}
+
+/**
+ * @brief	Send the close notify alert for a connection whose record layer has been offloaded to the kernel.
+ * @note	OpenSSL is told the shutdown already happened, because an alert generated by OpenSSL would be encrypted a second time.
+ * @param	tls		the TLS connection being shut down.
+ * @param	sockd	the socket descriptor underlying the TLS connection.
+ * @param	mode	the mask of directions which were offloaded by ktls_enable().
+ * @return	This function returns no value.
+ */
+void ktls_close(TLS *tls, int sockd, int_t mode) {
+
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	uchr_t alert[2] = { SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY };
+	chr_t control[CMSG_SPACE(sizeof(uchr_t))];
+
+	if ((mode & KTLS_TX) && sockd >= 0) {
+
+		mm_wipe(&msg, sizeof(msg));
+		mm_wipe(control, sizeof(control));
+
+		iov.iov_base = alert;
+		iov.iov_len = sizeof(alert);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		// The record type is passed along as ancillary data, otherwise the kernel would send the alert as application data.
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_TLS;
+		cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uchr_t));
+		*CMSG_DATA(cmsg) = SSL3_RT_ALERT;
+
+		sendmsg(sockd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+	}
+
+	if (tls && mode) {
+		SSL_set_shutdown_d(tls, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+	}
+
+	return;
+}
+
+#else
+
+/**
+ * @brief	Kernel TLS isn't supported by this build.
+ * @return	Always returns false.
+ */
+bool_t ktls_available(void) {
+
+	return false;
+}
+
+/**
+ * @brief	Kernel TLS isn't supported by this build, so connections always keep using OpenSSL.
+ * @return	Always returns 0.
+ */
+int_t ktls_enable(TLS *tls, int sockd) {
+
+	stats_increment_by_name("provider.tls.kernel.fallback");
+	return 0;
+}
+
+/**
+ * @brief	Kernel TLS isn't supported by this build, so there is nothing to shut down.
+ * @return	This function returns no value.
+ */
+void ktls_close(TLS *tls, int sockd, int_t mode) {
+
+	return;
+}
+
+#endif
@@ -0,0 +1,266 @@
+
+/**
+ * @file /magma/providers/cryptography/tickets.c
+ *
+ * @brief	Functions used to manage the keys which protect TLS session tickets (RFC 5077).
+ *
+ * @note	Session tickets let a client resume a TLS session without repeating the key exchange, and without the server keeping any
+ * 			per-session state. The ticket keys are held in secure memory, and are rotated periodically. The previous keys are kept
+ * 			around, so tickets issued shortly before a rotation can still be used. Alternatively, the keys can be loaded from a file,
+ * 			which allows every node in a cluster to accept the tickets issued by its peers.
+ */
+
+#include "magma.h"
+
+struct {
+	time_t checked; /* When the keys were last rotated, or when the key file was last checked for changes. */
+	time_t modified; /* The modification time of the key file when it was last loaded. */
+	uint_t count; /* The number of valid keys. */
+	tls_ticket_key_t *keys; /* The ticket keys, with the current encryption key first. */
+	pthread_rwlock_t lock;
+} tickets = {
+	.checked = 0,
+	.modified = 0,
+	.count = 0,
+	.keys = NULL
+};
+
+/**
+ * @brief	Generate a new random ticket key, and demote the current key so it can still be used to decrypt existing tickets.
+ * @note	The caller must hold the ticket key write lock.
+ * @return	true on success, or false on failure.
+ */
+bool_t tls_tickets_rotate(void) {
+
+	tls_ticket_key_t key;
+
+	if (RAND_bytes_d(key.name, sizeof(key.name)) != 1 || RAND_bytes_d(key.hmac, sizeof(key.hmac)) != 1 ||
+		RAND_bytes_d(key.aes, sizeof(key.aes)) != 1) {
+		log_pedantic("Unable to generate a new session ticket key. { error = %s }", ssl_error_string(MEMORYBUF(256), 256));
+		mm_wipe(&key, sizeof(tls_ticket_key_t));
+		return false;
+	}
+
+	memmove(tickets.keys + 1, tickets.keys, (TLS_TICKET_KEYS - 1) * sizeof(tls_ticket_key_t));
+	mm_copy(tickets.keys, &key, sizeof(tls_ticket_key_t));
+	mm_wipe(&key, sizeof(tls_ticket_key_t));
+
+	if (tickets.count < TLS_TICKET_KEYS) {
+		tickets.count++;
+	}
+
+	stats_increment_by_name("provider.tls.tickets.rotated");
+
+	return true;
+}
+
+/**
+ * @brief	Load the ticket keys from a file, if the file has changed since it was last loaded.
+ * @note	The caller must hold the ticket key write lock. The file holds up to TLS_TICKET_KEYS keys, each of which is made up of a 16
+ * 			byte name, a 32 byte HMAC secret and a 32 byte AES key. The first key is used to issue new tickets. If the file can't be
+ * 			loaded, the current keys are left as is.
+ * @param	path	the path of the file holding the ticket keys.
+ * @return	true on success, or false on failure.
+ */
+bool_t tls_tickets_load(chr_t *path) {
+
+	int fd;
+	ssize_t length;
+	struct stat info;
+	uchr_t *buffer;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		log_pedantic("Unable to open the session ticket key file. { path = %s / errno = %i }", path, errno);
+		return false;
+	}
+	else if (fstat(fd, &info)) {
+		log_pedantic("Unable to stat the session ticket key file. { path = %s / errno = %i }", path, errno);
+		close(fd);
+		return false;
+	}
+	// Nothing has changed since the last time we loaded the file.
+	else if (tickets.count && info.st_mtime == tickets.modified) {
+		close(fd);
+		return true;
+	}
+	else if (!(buffer = mm_sec_alloc(TLS_TICKET_KEYS * sizeof(tls_ticket_key_t) + 1))) {
+		log_pedantic("Unable to allocate a secure buffer for the session ticket keys.");
+		close(fd);
+		return false;
+	}
+
+	// We read one byte more than we can use, so oversized files are detected.
+	length = read(fd, buffer, TLS_TICKET_KEYS * sizeof(tls_ticket_key_t) + 1);
+	close(fd);
+
+	if (length <= 0 || length % sizeof(tls_ticket_key_t) || length > (ssize_t)(TLS_TICKET_KEYS * sizeof(tls_ticket_key_t))) {
+		log_pedantic("The session ticket key file must hold between 1 and %i keys of %zu bytes each. { path = %s / length = %zi }",
+			TLS_TICKET_KEYS, sizeof(tls_ticket_key_t), path, length);
+		mm_sec_free(buffer);
+		return false;
+	}
+
+	mm_wipe(tickets.keys, TLS_TICKET_KEYS * sizeof(tls_ticket_key_t));
+	mm_copy(tickets.keys, buffer, length);
+	tickets.count = length / sizeof(tls_ticket_key_t);
+	tickets.modified = info.st_mtime;
+	mm_sec_free(buffer);
+
+	stats_increment_by_name("provider.tls.tickets.rotated");
+
+	return true;
+}
+
+/**
+ * @brief	Rotate the ticket keys, or reload the key file, if the current keys are due to be refreshed.
+ * @return	This function returns no value.
+ */
+void tls_tickets_refresh(void) {
+
+	time_t now = time(NULL);
+	uint32_t interval = magma.iface.cryptography.tickets.file ? TLS_TICKET_FILE_CHECK : magma.iface.cryptography.tickets.rotate;
+
+	// Avoid taking the write lock unless the keys are actually due.
+	if (now - tickets.checked < interval) {
+		return;
+	}
+
+	rwlock_lock_write(&(tickets.lock));
+
+	if (now - tickets.checked >= interval) {
+
+		if (magma.iface.cryptography.tickets.file) {
+			tls_tickets_load(magma.iface.cryptography.tickets.file);
+		}
+		else {
+			tls_tickets_rotate();
+		}
+
+		tickets.checked = now;
+	}
+
+	rwlock_unlock(&(tickets.lock));
+
+	return;
+}
+
+/**
+ * @brief	The callback used by OpenSSL to set up the cipher and HMAC contexts used to protect a session ticket.
+ * @see		SSL_CTX_set_tlsext_ticket_key_cb()
+ * @param	tls			the TLS connection issuing, or presenting, the ticket.
+ * @param	name		the 16 byte key name stored inside the ticket.
+ * @param	iv			the initialization vector used to encrypt the ticket.
+ * @param	cipher		the cipher context to be initialized.
+ * @param	hmac		the HMAC context to be initialized.
+ * @param	encrypt		1 if a new ticket is being issued, or 0 if a ticket presented by the client is being decrypted.
+ * @return	-1 on error, 0 if the ticket key couldn't be found, 1 on success, or 2 if the ticket was decrypted using an old key, and
+ * 			should be replaced.
+ */
+int tls_tickets_callback(SSL *tls, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cipher, HMAC_CTX *hmac, int encrypt) {
+
+	int result = 0;
+
+	if (encrypt) {
+
+		tls_tickets_refresh();
+
+		if (RAND_bytes_d(iv, EVP_CIPHER_iv_length_d(EVP_aes_256_cbc_d())) != 1) {
+			return -1;
+		}
+
+		rwlock_lock_read(&(tickets.lock));
+
+		if (tickets.count) {
+			mm_copy(name, tickets.keys[0].name, sizeof(tickets.keys[0].name));
+			EVP_EncryptInit_ex_d(cipher, EVP_aes_256_cbc_d(), NULL, tickets.keys[0].aes, iv);
+			HMAC_Init_ex_d(hmac, tickets.keys[0].hmac, sizeof(tickets.keys[0].hmac), EVP_sha256_d(), NULL);
+			result = 1;
+		}
+
+		rwlock_unlock(&(tickets.lock));
+
+		return result ? 1 : -1;
+	}
+
+	rwlock_lock_read(&(tickets.lock));
+
+	for (uint_t i = 0; i < tickets.count && !result; i++) {
+		if (!memcmp(name, tickets.keys[i].name, sizeof(tickets.keys[i].name))) {
+			HMAC_Init_ex_d(hmac, tickets.keys[i].hmac, sizeof(tickets.keys[i].hmac), EVP_sha256_d(), NULL);
+			EVP_DecryptInit_ex_d(cipher, EVP_aes_256_cbc_d(), NULL, tickets.keys[i].aes, iv);
+			result = (i == 0 ? 1 : 2);
+		}
+	}
+
+	rwlock_unlock(&(tickets.lock));
+
+	return result;
+}
+
+/**
+ * @brief	Set up the session ticket keys shared by every TLS server context.
+ * @return	true on success, or false on failure.
+ */
+bool_t tls_tickets_start(void) {
+
+	bool_t result;
+
+	// Session tickets are disabled. The rotation interval only applies to generated keys, so a key file enables them on its own.
+	if (!magma.iface.cryptography.tickets.rotate && !magma.iface.cryptography.tickets.file) {
+		return true;
+	}
+	else if (rwlock_init(&(tickets.lock), NULL)) {
+		log_critical("Unable to initialize the session ticket key lock.");
+		return false;
+	}
+	else if (!(tickets.keys = mm_sec_alloc(TLS_TICKET_KEYS * sizeof(tls_ticket_key_t)))) {
+		log_critical("Unable to allocate secure memory for the session ticket keys.");
+		rwlock_destroy(&(tickets.lock));
+		return false;
+	}
+
+	mm_wipe(tickets.keys, TLS_TICKET_KEYS * sizeof(tls_ticket_key_t));
+
+	if (magma.iface.cryptography.tickets.file) {
+		result = tls_tickets_load(magma.iface.cryptography.tickets.file);
+	}
+	else {
+		result = tls_tickets_rotate();
+	}
+
+	if (!result) {
+		log_critical("Unable to set up the session ticket keys.");
+		tls_tickets_stop();
+		return false;
+	}
+
+	tickets.checked = time(NULL);
+
+	return true;
+}
+
+/**
+ * @brief	Destroy the session ticket keys.
+ * @return	This function returns no value.
+ */
+void tls_tickets_stop(void) {
+
+	if (tickets.keys) {
+		mm_wipe(tickets.keys, TLS_TICKET_KEYS * sizeof(tls_ticket_key_t));
+		mm_sec_free(tickets.keys);
+		rwlock_destroy(&(tickets.lock));
+		tickets.keys = NULL;
+		tickets.count = 0;
+	}
+
+	return;
+}
+
+/**
+ * @brief	Determine whether session tickets are available.
+ * @return	true if the session ticket keys have been set up, or false if session tickets are disabled.
+ */
+bool_t tls_tickets_enabled(void) {
+
+	return tickets.keys ? true : false;
+}
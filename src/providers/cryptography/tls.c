@@ -52,6 +52,14 @@ bool_t tls_server_create(void *server, uint_t security_level) {
 		ciphers = MAGMA_CIPHERS_HIGH;
 	}
 
+	// Session tickets are protected by the shared, rotating ticket keys, so they can be offered at every security level.
+	if (tls_tickets_enabled()) {
+		options &= ~SSL_OP_NO_TICKET;
+	}
+	else {
+		options |= SSL_OP_NO_TICKET;
+	}
+
 	// We use the generic SSLv23 method, which really means support SSLv2 and above, including TLSv1, TLSv1.1, etc, and then limit
 	// the actual protocols the SSL context will support using the options variable configured above, and the call to SSL_CTX_ctrl() below.
 	if (!(local->tls.context = SSL_CTX_new_d(SSLv23_server_method_d()))) {
@@ -108,6 +116,25 @@ bool_t tls_server_create(void *server, uint_t security_level) {
 	// Like the SSL_CTRL_SET_ECDH_AUTO, this function will no longer be needed when we switch to OpenSSL 1.1.0.
 	SSL_CTX_set_tmp_ecdh_callback_d(local->tls.context, ssl_ecdh_exchange_callback);
 
+	// Cache sessions on the server so returning clients can skip the key exchange. The cache is bounded, and OpenSSL evicts the
+	// oldest sessions once the limit is reached.
+	if (magma.iface.cryptography.sessions.cache) {
+		SSL_CTX_ctrl_d(local->tls.context, SSL_CTRL_SET_SESS_CACHE_MODE, SSL_SESS_CACHE_SERVER, NULL);
+		SSL_CTX_ctrl_d(local->tls.context, SSL_CTRL_SET_SESS_CACHE_SIZE, magma.iface.cryptography.sessions.cache, NULL);
+	}
+	else {
+		SSL_CTX_ctrl_d(local->tls.context, SSL_CTRL_SET_SESS_CACHE_MODE, SSL_SESS_CACHE_OFF, NULL);
+	}
+
+	// The timeout also controls the lifetime hint attached to session tickets.
+	SSL_CTX_set_timeout_d(local->tls.context, magma.iface.cryptography.sessions.timeout);
+
+	if (tls_tickets_enabled() && SSL_CTX_callback_ctrl_d(local->tls.context, SSL_CTRL_SET_TLSEXT_TICKET_KEY_CB,
+		(void (*)(void))tls_tickets_callback) != 1) {
+		log_critical("Could not configure the session ticket key callback.");
+		return false;
+	}
+
 	// We don't support authentication using client certificates, so we set the verify flag to NONE. This will prevent the server
 	// from sending a client certificate request.
 	SSL_CTX_set_verify_d(local->tls.context, SSL_VERIFY_NONE, NULL);
@@ -229,6 +256,14 @@ TLS * tls_server_alloc(void *server, int sockd, int flags) {
 		return NULL;
 	}
 
+	// Track how many handshakes were able to resume a previous session, using either the session cache or a session ticket.
+	if (SSL_ctrl_d(tls, SSL_CTRL_GET_SESSION_REUSED, 0, NULL)) {
+		stats_increment_by_name("provider.tls.sessions.resumed");
+	}
+	else {
+		stats_increment_by_name("provider.tls.sessions.full");
+	}
+
 	return tls;
 }
 
@@ -412,6 +447,25 @@ chr_t * tls_suite(TLS *tls) {
 	return suite;
  }
 
+/**
+ * @brief	Get the number of decrypted bytes buffered inside a TLS connection which are waiting to be read.
+ * @note	Buffered data won't trigger a readability event on the underlying socket, so callers who poll the socket descriptor
+ * 			should check this value first.
+ * @see		SSL_pending()
+ * @param	tls		the TLS connection to be checked.
+ * @return	the number of buffered bytes available, or 0 if there are none.
+ */
+int tls_pending(TLS *tls) {
+
+	int_t result = 0;
+
+	if (tls) {
+		result = SSL_pending_d(tls);
+	}
+
+	return result;
+}
+
 /**
  * @brief	Checks whether a TLS connection has been shut down or not.
  * @see		SSL_get_shutdown()
@@ -58,7 +58,23 @@
  */
 typedef char table_t;
 typedef char row_t;
-extern pool_t *sql_pool;
+extern pool_t *sql_pool, *sql_replica_pool;
+
+// The number of slots used to track when each user's data last changed. Users which share a slot are treated as a group.
+#define SQL_REPLICA_STAMPS 4096
+
+/***
+ * @typedef stmt_cursor_t
+ *
+ * A prepared statement whose result set is read from the server one row at a time, directly into the caller's result bindings,
+ * instead of being copied into a table_t first. The database connection is held until the cursor is closed.
+ */
+typedef struct {
+	bool_t pooled; /* Whether the connection was pulled from a pool by the cursor, and must be released when the cursor is closed. */
+	uint32_t connection; /* The connection the statement was executed on. */
+	uint64_t rows; /* The number of rows fetched so far. */
+	MYSQL_STMT *local; /* The statement handle, or NULL if the cursor isn't open. */
+} stmt_cursor_t;
 
 #define ISNULL(b) (my_bool *)&((my_bool){ b })
 
@@ -69,6 +85,7 @@ const    char * serv_charset_mysql(void);
 const    char * serv_schema_mysql(void);
 const    char * serv_type_mysql(void);
 const    char * serv_version_mysql(void);
+MYSQL *  sql_connect(const chr_t *host, uint32_t port, const chr_t *socket_path, bool_t silent);
 uint_t   sql_errno(MYSQL *mysql);
 const    chr_t * sql_error(MYSQL *mysql);
 MYSQL *  sql_open(bool_t silent);
@@ -90,6 +107,22 @@ MYSQL_RES *  sql_query_res_conn(stringer_t *query, uint32_t connection);
 int64_t      sql_write(stringer_t *query);
 int64_t      sql_write_conn(stringer_t *query, uint32_t connection);
 
+/// replica.c
+bool_t    sql_replica_classify(chr_t *query);
+void      sql_replica_check(void);
+void      sql_replica_failed(uint32_t connection);
+void      sql_replica_mark(MYSQL_STMT **group, chr_t *query);
+void      sql_replica_pin(void);
+bool_t    sql_replica_pull(MYSQL_STMT **group, uint64_t usernum, uint32_t *connection);
+void      sql_replica_stamp(uint64_t usernum);
+bool_t    sql_replica_start(void);
+void      sql_replica_stop(void);
+void      sql_replica_unpin(void);
+void      sql_replica_written(void);
+MYSQL *   sql_connection_handle(uint32_t connection);
+void      sql_connection_release(uint32_t connection);
+uint32_t  sql_connections(void);
+
 /// results.c
 uint64_t      res_bind_create(MYSQL_STMT *stmt, MYSQL_BIND **result);
 void          res_bind_free(MYSQL_STMT *stmt, MYSQL_BIND *binding, uint64_t number);
@@ -129,6 +162,8 @@ int64_t       stmt_exec_affected_conn(MYSQL_STMT **group, MYSQL_BIND *parameters
 bool_t        stmt_exec_conn(MYSQL_STMT **group, MYSQL_BIND *parameters, uint32_t connection);
 table_t *     stmt_get_result(MYSQL_STMT **group, MYSQL_BIND *parameters);
 table_t *     stmt_get_result_conn(MYSQL_STMT **group, MYSQL_BIND *parameters, uint32_t connection);
+table_t *     stmt_get_result_user(MYSQL_STMT **group, MYSQL_BIND *parameters, uint64_t usernum);
+int_t         stmt_fetch_next(stmt_cursor_t *cursor);
 uint64_t      stmt_insert(MYSQL_STMT **group, MYSQL_BIND *parameters);
 uint64_t      stmt_insert_conn(MYSQL_STMT **group, MYSQL_BIND *parameters, uint32_t connection);
 MYSQL_STMT *  stmt_open(MYSQL *mysql);
@@ -137,6 +172,10 @@ bool_t        stmt_rebuild(uint32_t connection);
 MYSQL_STMT *  stmt_reset(MYSQL_STMT **group, uint32_t connection);
 bool_t        stmt_start(void);
 void          stmt_stop(void);
+bool_t        stmt_stream(stmt_cursor_t *cursor, MYSQL_STMT **group, MYSQL_BIND *parameters, MYSQL_BIND *results);
+void          stmt_stream_close(stmt_cursor_t *cursor);
+bool_t        stmt_stream_conn(stmt_cursor_t *cursor, MYSQL_STMT **group, MYSQL_BIND *parameters, MYSQL_BIND *results, uint32_t connection);
+bool_t        stmt_stream_user(stmt_cursor_t *cursor, MYSQL_STMT **group, MYSQL_BIND *parameters, MYSQL_BIND *results, uint64_t usernum);
 
 /// transaction.c
 int64_t tran_commit(int64_t transaction);
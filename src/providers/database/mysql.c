@@ -190,6 +190,7 @@ const chr_t * sql_error(MYSQL *mysql) {
 void sql_stop(void) {
 
 	stmt_stop();
+	sql_replica_stop();
 
 	// Close the SQL connections.
 	for (uint32_t i = 0; i < magma.iface.database.pool.connections; i++) {
@@ -210,12 +211,26 @@ void sql_stop(void) {
 
 /**
  * @brief	Open up a new mysql connection to the configured database server.
- * @note	The reconnect option will automatically be set on all new mysql connections.
+ * @see		sql_connect()
  * @param	silent	if true, suppress logging of failure messages for this function.
  * @return	NULL on failure, or a pointer to a MSQL objection for the newly established connection on success.
  */
 MYSQL * sql_open(bool_t silent) {
 
+	return sql_connect(magma.iface.database.host, magma.iface.database.port, magma.iface.database.socket_path, silent);
+}
+
+/**
+ * @brief	Open up a new mysql connection to a specific database server, using the configured schema and credentials.
+ * @note	The reconnect option will automatically be set on all new mysql connections.
+ * @param	host			the host name of the database server.
+ * @param	port			the port used by the database server.
+ * @param	socket_path		the path of the UNIX socket used for local sessions, or NULL.
+ * @param	silent			if true, suppress logging of failure messages for this function.
+ * @return	NULL on failure, or a pointer to a MSQL objection for the newly established connection on success.
+ */
+MYSQL * sql_connect(const chr_t *host, uint32_t port, const chr_t *socket_path, bool_t silent) {
+
 	MYSQL *con, *holder;
 	my_bool recon = true;
 
@@ -250,8 +265,8 @@ MYSQL * sql_open(bool_t silent) {
 		return NULL;
 	}
 
-	else if (!(holder = mysql_real_connect_d(con, magma.iface.database.host, magma.iface.database.user, magma.iface.database.password,
-			magma.iface.database.schema, magma.iface.database.port, magma.iface.database.socket_path, 0))) {
+	else if (!(holder = mysql_real_connect_d(con, host, magma.iface.database.user, magma.iface.database.password,
+			magma.iface.database.schema, port, socket_path, 0))) {
 		if (!silent) log_critical("MySQL connect error. { error = %s }", sql_error(con));
 		mysql_close_d(con);
 		return NULL;
@@ -298,7 +313,7 @@ MYSQL * sql_open(bool_t silent) {
  * if (sql_ping(connection) < 0 || !stmt_rebuild(connection)) { log_error("Invalid database connection."; return; }
  * @endcode
  *
- * @param connection The specific connection inside the pool that should be used for the ping.
+ * @param connection The specific connection that should be used for the ping, which may be a primary or a read replica connection.
  * @return Returns 1 if the library performed an automatic reconnect, 0 if the connection is active, and -1 if the reconnect failed.
  **/
 int_t sql_ping(uint32_t connection) {
@@ -306,20 +321,20 @@ int_t sql_ping(uint32_t connection) {
 	uint64_t thread_id;
 
 	// Store the current thread ID.
-	thread_id = mysql_thread_id_d(pool_get_obj(sql_pool, connection));
+	thread_id = mysql_thread_id_d(sql_connection_handle(connection));
 
 	// Ping the connection.
-	if (mysql_ping_d(pool_get_obj(sql_pool, connection))) {
-		log_error("MySQL ping failed. Unable to reconnect with the server. { error = %s }", sql_error(pool_get_obj(sql_pool, connection)));
+	if (mysql_ping_d(sql_connection_handle(connection))) {
+		log_error("MySQL ping failed. Unable to reconnect with the server. { error = %s }", sql_error(sql_connection_handle(connection)));
 		return -1;
 	}
 
 	// And check whether the thread ID has changed. If it changes then we reconnected to the server and need to set the SQL mode again.
-	else if (mysql_thread_id_d(pool_get_obj(sql_pool, connection)) != thread_id) {
+	else if (mysql_thread_id_d(sql_connection_handle(connection)) != thread_id) {
 
-		if (mysql_real_query_d(pool_get_obj(sql_pool, connection), "SET SESSION sql_mode='ALLOW_INVALID_DATES'", 42)) {
+		if (mysql_real_query_d(sql_connection_handle(connection), "SET SESSION sql_mode='ALLOW_INVALID_DATES'", 42)) {
 			log_pedantic("An error occurred while attempting to set the SQL mode to allow invalid date values. { error = %s }",
-			sql_error(pool_get_obj(sql_pool, connection)));
+			sql_error(sql_connection_handle(connection)));
 		}
 
 		return 1;
@@ -376,6 +391,11 @@ bool_t sql_start(void) {
 		pool_set_obj(sql_pool, i, con);
 	}
 
+	if (!sql_replica_start()) {
+		sql_stop();
+		return false;
+	}
+
 	if (!stmt_start()) {
 		sql_stop();
 		return false;
@@ -0,0 +1,361 @@
+
+/**
+ * @file /magma/providers/database/replica.c
+ *
+ * @brief	Routes read only prepared statements to an optional pool of read replica connections.
+ *
+ * @note	Replica connections share the prepared statement groups with the primary pool. The primary connections use the identifiers
+ * 			0 through magma.iface.database.pool.connections - 1, and the replica connections follow them. A read is only sent to a
+ * 			replica if the statement is a plain SELECT, the calling thread isn't inside a transaction and hasn't written recently,
+ * 			the user being read hasn't changed recently, and the replica was caught up the last time its replication lag was checked.
+ * 			A read which fails on a replica is retried on the primary, and the replicas are bypassed until the next successful check.
+ */
+
+#include "magma.h"
+
+pool_t *sql_replica_pool = NULL;
+
+// The number of open transactions held by the current thread, and when the current thread last wrote to the database.
+static __thread uint32_t pinned = 0;
+static __thread time_t written = 0;
+
+struct {
+	bool_t healthy; /* Whether the replicas were caught up the last time they were checked. */
+	time_t checked; /* When the replication lag was last checked. */
+	uint32_t checking; /* Set while a thread is checking the replication lag. */
+	MYSQL *monitor; /* A dedicated replica connection used to check the replication lag. */
+	time_t stamps[SQL_REPLICA_STAMPS]; /* When the data belonging to a user last changed, hashed by user number. */
+} replica = {
+	.healthy = false,
+	.checked = 0,
+	.checking = 0,
+	.monitor = NULL
+};
+
+/**
+ * @brief	Determine whether a query only reads data, and can therefore be run against a replica.
+ * @param	query	a null-terminated string holding the SQL query.
+ * @return	true if the query is a plain SELECT statement, otherwise false.
+ */
+bool_t sql_replica_classify(chr_t *query) {
+
+	size_t length;
+
+	if (!query) {
+		return false;
+	}
+
+	while (chr_whitespace(*query)) {
+		query++;
+	}
+
+	length = ns_length_get(query);
+
+	// Locking reads have to run on the primary, where the locks are held.
+	if (length < 6 || st_cmp_ci_starts(PLACER(query, length), PLACER("SELECT", 6)) ||
+		st_search_ci(PLACER(query, length), PLACER("FOR UPDATE", 10), NULL) ||
+		st_search_ci(PLACER(query, length), PLACER("LOCK IN SHARE MODE", 18), NULL)) {
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Record whether a prepared statement group can be run against a replica.
+ * @note	Each statement group is allocated with one slot beyond the last connection, which holds the classification so it
+ * 			doesn't have to be looked up every time a statement is executed. The slot points back at the group if the query is
+ * 			a read, and is NULL otherwise.
+ * @param	group	the prepared statement group, which must hold sql_connections() + 1 slots.
+ * @param	query	a null-terminated string holding the SQL query used to prepare the group.
+ * @return	This function returns no value.
+ */
+void sql_replica_mark(MYSQL_STMT **group, chr_t *query) {
+
+	if (group) {
+		*(group + sql_connections()) = sql_replica_classify(query) ? (MYSQL_STMT *)group : NULL;
+	}
+
+	return;
+}
+
+/**
+ * @brief	Open the pool of read replica connections, if replicas are configured.
+ * @note	This function must be called after the primary pool is opened, and before the prepared statements are created.
+ * @return	true on success, or if replicas aren't configured, otherwise false.
+ */
+bool_t sql_replica_start(void) {
+
+	MYSQL *con;
+
+	if (ns_empty(magma.iface.database.replica.host) || !magma.iface.database.replica.connections) {
+		return true;
+	}
+	else if (!(sql_replica_pool = pool_alloc(magma.iface.database.replica.connections, magma.iface.database.pool.timeout))) {
+		log_critical("Could not allocate memory for the read replica connection pool.");
+		sql_replica_stop();
+		return false;
+	}
+
+	for (uint32_t i = 0; i < magma.iface.database.replica.connections; i++) {
+		if (!(con = sql_connect(magma.iface.database.replica.host, magma.iface.database.replica.port,
+			magma.iface.database.replica.socket_path, false))) {
+			sql_replica_stop();
+			return false;
+		}
+
+		pool_set_obj(sql_replica_pool, i, con);
+	}
+
+	if (!(replica.monitor = sql_connect(magma.iface.database.replica.host, magma.iface.database.replica.port,
+		magma.iface.database.replica.socket_path, false))) {
+		sql_replica_stop();
+		return false;
+	}
+
+	// The replicas aren't used until their replication lag has been checked.
+	replica.healthy = false;
+	replica.checked = 0;
+
+	return true;
+}
+
+/**
+ * @brief	Close the read replica connections and free the pool.
+ * @note	The prepared statements must be closed first.
+ * @return	This function returns no value.
+ */
+void sql_replica_stop(void) {
+
+	if (sql_replica_pool) {
+
+		for (uint32_t i = 0; i < magma.iface.database.replica.connections; i++) {
+			if (pool_get_obj(sql_replica_pool, i)) mysql_close_d(pool_get_obj(sql_replica_pool, i));
+		}
+
+		pool_free(sql_replica_pool);
+		sql_replica_pool = NULL;
+	}
+
+	if (replica.monitor) {
+		mysql_close_d(replica.monitor);
+		replica.monitor = NULL;
+	}
+
+	replica.healthy = false;
+
+	return;
+}
+
+/**
+ * @brief	Get the total number of database connections, including the read replica connections.
+ * @return	the number of connection identifiers which may be used with the prepared statement groups.
+ */
+uint32_t sql_connections(void) {
+
+	return magma.iface.database.pool.connections + (sql_replica_pool ? magma.iface.database.replica.connections : 0);
+}
+
+/**
+ * @brief	Get the handle for a connection identifier, which may refer to either a primary or a read replica connection.
+ * @param	connection	the connection identifier.
+ * @return	the MYSQL handle associated with the connection.
+ */
+MYSQL * sql_connection_handle(uint32_t connection) {
+
+	if (connection < magma.iface.database.pool.connections) {
+		return pool_get_obj(sql_pool, connection);
+	}
+
+	return pool_get_obj(sql_replica_pool, connection - magma.iface.database.pool.connections);
+}
+
+/**
+ * @brief	Return a connection to the pool it was pulled from.
+ * @param	connection	the connection identifier.
+ * @return	This function returns no value.
+ */
+void sql_connection_release(uint32_t connection) {
+
+	if (connection < magma.iface.database.pool.connections) {
+		pool_release(sql_pool, connection);
+	}
+	else {
+		pool_release(sql_replica_pool, connection - magma.iface.database.pool.connections);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Check how far the read replicas have fallen behind the primary server.
+ * @note	The check is run at most once per second, by a single thread, using a dedicated connection so it never waits on the
+ * 			pool. If replication is stopped, or the replica is further behind than magma.iface.database.replica.lag seconds, reads
+ * 			are sent to the primary until a later check succeeds. A server which doesn't report a replication status is assumed to
+ * 			be current.
+ * @return	This function returns no value.
+ */
+void sql_replica_check(void) {
+
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	MYSQL_FIELD *field;
+	bool_t healthy = false;
+	uint64_t lag = 0;
+	uint_t fields, column = UINT_MAX;
+	time_t now, checked;
+
+	if ((now = time(NULL)) == (checked = replica.checked) || !__sync_bool_compare_and_swap(&(replica.checked), checked, now)) {
+		return;
+	}
+	else if (__sync_lock_test_and_set(&(replica.checking), 1)) {
+		return;
+	}
+
+	// The reconnect option is set, so a query on a dropped connection will reconnect, allowing the replicas to fail back.
+	if (mysql_real_query_d(replica.monitor, "SHOW SLAVE STATUS", 17) || !(result = mysql_store_result_d(replica.monitor))) {
+		log_pedantic("Unable to check the read replica status. { error = %s }", sql_error(replica.monitor));
+		replica.healthy = false;
+		__sync_lock_release(&(replica.checking));
+		return;
+	}
+
+	if (!(row = mysql_fetch_row_d(result))) {
+		healthy = true;
+	}
+	else {
+
+		fields = mysql_num_fields_d(result);
+
+		for (uint_t i = 0; i < fields && (field = mysql_fetch_field_d(result)); i++) {
+			if (field->name && !st_cmp_ci_eq(NULLER(field->name), PLACER("Seconds_Behind_Master", 21))) {
+				column = i;
+			}
+		}
+
+		// A NULL value means the replication threads aren't running.
+		if (column != UINT_MAX && row[column] && uint64_conv_ns(row[column], &lag) && lag <= magma.iface.database.replica.lag) {
+			healthy = true;
+		}
+	}
+
+	mysql_free_result_d(result);
+
+	if (healthy != replica.healthy) {
+		log_info("The read replicas are %s. { lag = %lu }", healthy ? "available" : "unavailable, reads will be sent to the primary", lag);
+	}
+
+	replica.healthy = healthy;
+	__sync_lock_release(&(replica.checking));
+
+	return;
+}
+
+/**
+ * @brief	Record that a user's data has changed, so reads for that user are sent to the primary until the replicas catch up.
+ * @param	usernum		the numerical id of the user whose data changed.
+ * @return	This function returns no value.
+ */
+void sql_replica_stamp(uint64_t usernum) {
+
+	if (sql_replica_pool && usernum) {
+		replica.stamps[usernum % SQL_REPLICA_STAMPS] = time(NULL);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Record that the current thread wrote to the database, so its reads are sent to the primary until the replicas catch up.
+ * @return	This function returns no value.
+ */
+void sql_replica_written(void) {
+
+	if (sql_replica_pool) {
+		written = time(NULL);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Send every read made by the current thread to the primary, until the matching call to sql_replica_unpin().
+ * @note	This is used while a transaction is open.
+ * @return	This function returns no value.
+ */
+void sql_replica_pin(void) {
+
+	pinned++;
+	return;
+}
+
+/**
+ * @brief	Release a pin placed by sql_replica_pin(), and record the end of the transaction as a write.
+ * @return	This function returns no value.
+ */
+void sql_replica_unpin(void) {
+
+	if (pinned) {
+		pinned--;
+	}
+
+	sql_replica_written();
+
+	return;
+}
+
+/**
+ * @brief	Pull a read replica connection for a prepared statement, if the statement can safely be run against a replica.
+ * @param	group		the prepared statement which will be executed.
+ * @param	usernum		the numerical id of the user whose data is being read, or 0 if the read isn't tied to a user.
+ * @param	connection	a pointer to the connection identifier which will receive the replica connection.
+ * @return	true if a replica connection was pulled, or false if the statement should be run on the primary.
+ */
+bool_t sql_replica_pull(MYSQL_STMT **group, uint64_t usernum, uint32_t *connection) {
+
+	time_t now;
+	uint32_t item;
+
+	if (!sql_replica_pool || !group) {
+		return false;
+	}
+
+	sql_replica_check();
+	now = time(NULL);
+
+	if (!replica.healthy || pinned || (written + magma.iface.database.replica.window) >= now ||
+		(usernum && (replica.stamps[usernum % SQL_REPLICA_STAMPS] + magma.iface.database.replica.window) >= now)) {
+		stats_increment_by_name("provider.database.replica.primary");
+		return false;
+	}
+
+	// The statement was classified when its group was prepared.
+	if (*(group + sql_connections()) != (MYSQL_STMT *)group) {
+		return false;
+	}
+	else if (pool_pull(sql_replica_pool, &item) != PL_RESERVED) {
+		stats_increment_by_name("provider.database.replica.primary");
+		return false;
+	}
+
+	*connection = magma.iface.database.pool.connections + item;
+	stats_increment_by_name("provider.database.replica.reads");
+
+	return true;
+}
+
+/**
+ * @brief	Record that a read failed on a replica connection, so reads are sent to the primary until the next successful check.
+ * @param	connection	the replica connection identifier.
+ * @return	This function returns no value.
+ */
+void sql_replica_failed(uint32_t connection) {
+
+	log_pedantic("A read failed on a replica connection and will be retried on the primary. { connection = %u / error = %s }",
+		connection, sql_error(sql_connection_handle(connection)));
+
+	replica.healthy = false;
+	stats_increment_by_name("provider.database.replica.failovers");
+
+	return;
+}
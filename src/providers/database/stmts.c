@@ -94,7 +94,7 @@ void stmt_stop(void) {
 	// Free the prepared statements.
 	for (uint32_t i = 0; i < sizeof(queries) / sizeof(char *); i++) {
 		if ((local = (MYSQL_STMT **)*((MYSQL_STMT **)&(stmts.select_domains) + i))) {
-			for (uint32_t j = 0; j < magma.iface.database.pool.connections; j++) {
+			for (uint32_t j = 0; j < sql_connections(); j++) {
 				if (*(local + j))
 					stmt_close(*(local + j));
 			}
@@ -137,7 +137,8 @@ bool_t stmt_prepare(MYSQL_STMT *group, const char *query, unsigned long length)
 
 /**
  * @brief	Initialize the global array of mysql prepared statements.
- * @note	This function readies a copy of each prepared statement for every member of the global mysql connection pool.
+ * @note	This function readies a copy of each prepared statement for every member of the global mysql connection pool, and
+ * 			every member of the read replica pool, if it's enabled.
  * @return	true on success or false on failure.
  */
 bool_t stmt_start(void) {
@@ -155,16 +156,18 @@ bool_t stmt_start(void) {
 
 	for (uint32_t i = 0; i < sizeof(queries) / sizeof(char *); i++) {
 
-		if (!(local = mm_alloc(magma.iface.database.pool.connections * sizeof(MYSQL_STMT *)))) {
+		// The extra slot at the end of the group records whether the statement can be sent to a read replica.
+		if (!(local = mm_alloc((sql_connections() + 1) * sizeof(MYSQL_STMT *)))) {
 			log_critical("Could not allocate the prepared statement group.");
 			return false;
 		}
 
 		*((MYSQL_STMT **)&(stmts.select_domains) + i) = (MYSQL_STMT *)local;
+		sql_replica_mark(local, queries[i]);
 
-		for (uint32_t j = 0; j < magma.iface.database.pool.connections; j++) {
+		for (uint32_t j = 0; j < sql_connections(); j++) {
 
-			if (!(*(local + j) = stmt_open(pool_get_obj(sql_pool, j)))) {
+			if (!(*(local + j) = stmt_open(sql_connection_handle(j)))) {
 				log_critical("Unable to create the prepared statement structure.");
 				stmt_stop();
 				return false;
@@ -198,7 +201,7 @@ bool_t stmt_rebuild(uint32_t connection) {
 		if (local) {
 			stmt_close(*(local + connection));
 
-			if (!(*(local + connection) = stmt_open(pool_get_obj(sql_pool, connection)))) {
+			if (!(*(local + connection) = stmt_open(sql_connection_handle(connection)))) {
 				log_critical("Unable to create the prepared statement structure.");
 				return false;
 			}
@@ -316,6 +319,7 @@ bool_t stmt_exec(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 
 	result = stmt_exec_conn(group, parameters, connection);
 	pool_release(sql_pool, connection);
+	sql_replica_written();
 	return result;
 }
 
@@ -350,15 +354,42 @@ table_t * stmt_get_result_conn(MYSQL_STMT **group, MYSQL_BIND *parameters, uint3
 
 /**
  * @brief	Execute a prepared mysql statement and return the result.
+ * @see		stmt_get_result_user()
  * @param	group		the prepared mysql statement to be executed.
  * @param	parameters	the parameters to be passed with the query.
  * @return	the result of the query, or NULL on failure.
  */
 table_t * stmt_get_result(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 
+	return stmt_get_result_user(group, parameters, 0);
+}
+
+/**
+ * @brief	Execute a prepared mysql statement which reads data belonging to a user, and return the result.
+ * @note	Read only statements are sent to a read replica when one is available, unless the user's data changed recently.
+ * 			If the replica fails, the statement is retried on the primary.
+ * @param	group		the prepared mysql statement to be executed.
+ * @param	parameters	the parameters to be passed with the query.
+ * @param	usernum		the numerical id of the user whose data is being read, or 0 if the read isn't tied to a user.
+ * @return	the result of the query, or NULL on failure.
+ */
+table_t * stmt_get_result_user(MYSQL_STMT **group, MYSQL_BIND *parameters, uint64_t usernum) {
+
 	void *result;
 	uint32_t connection;
 
+	if (sql_replica_pull(group, usernum, &connection)) {
+
+		if ((result = stmt_get_result_conn(group, parameters, connection))) {
+			sql_connection_release(connection);
+			return result;
+		}
+
+		// The error is read from the connection, so it must be recorded before the connection is released to another thread.
+		sql_replica_failed(connection);
+		sql_connection_release(connection);
+	}
+
 	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
 		log_info("Unable to get an available connection for the query.");
 		return NULL;
@@ -418,6 +449,7 @@ uint64_t stmt_insert(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 
 	result = stmt_insert_conn(group, parameters, connection);
 	pool_release(sql_pool, connection);
+	sql_replica_written();
 	return result;
 }
 
@@ -501,5 +533,187 @@ int64_t stmt_exec_affected(MYSQL_STMT **group, MYSQL_BIND *parameters) {
 
 	affected = stmt_exec_affected_conn(group, parameters, connection);
 	pool_release(sql_pool, connection);
+	sql_replica_written();
 	return affected;
 }
+
+/**
+ * @brief	Execute a prepared mysql statement on a specified connection, and open a cursor which streams the result set.
+ * @note	Unlike stmt_get_result_conn(), the result set isn't copied into a table. Each call to stmt_fetch_next() reads a single
+ * 			row from the server directly into the result bindings supplied by the caller, so the memory needed is constant, no matter
+ * 			how many rows are returned. Every result binding must point at a buffer, and set its buffer_length. String columns
+ * 			must also provide a length pointer. The statement, and the connection, can't be used for anything else until the
+ * 			cursor is closed using stmt_stream_close().
+ * @param	cursor		a pointer to the cursor which will be opened.
+ * @param	group		the prepared mysql statement to be executed.
+ * @param	parameters	the parameters to be passed with the query.
+ * @param	results		the bindings which will receive the values of each row.
+ * @param	connection	the mysql connection identifier.
+ * @return	false on failure, or true on success.
+ */
+bool_t stmt_stream_conn(stmt_cursor_t *cursor, MYSQL_STMT **group, MYSQL_BIND *parameters, MYSQL_BIND *results, uint32_t connection) {
+
+	MYSQL_STMT *local;
+
+	if (!cursor || !results) {
+		log_pedantic("Passed a NULL parameter.");
+		return false;
+	}
+
+	mm_wipe(cursor, sizeof(stmt_cursor_t));
+
+	if (!(local = stmt_reset(group, connection))) {
+		log_info("Unable to reset the prepared statement.");
+		return false;
+	}
+
+	if (stmt_bind_param(local, parameters) == false) {
+		log_info("Unable to bind the parameters to the prepared statement.");
+		return false;
+	}
+
+	if (mysql_stmt_execute_d(local)) {
+		log_info("An error occurred while executing a prepared statement. { error = %s }", stmt_error(local));
+		return false;
+	}
+
+	if (mysql_stmt_bind_result_d(local, results)) {
+		log_info("Unable to bind the result buffers to the prepared statement. { error = %s }", stmt_error(local));
+		mysql_stmt_free_result_d(local);
+		return false;
+	}
+
+	cursor->connection = connection;
+	cursor->local = local;
+
+	return true;
+}
+
+/**
+ * @brief	Execute a prepared mysql statement, and open a cursor which streams the result set.
+ * @see		stmt_stream_user()
+ * @param	cursor		a pointer to the cursor which will be opened.
+ * @param	group		the prepared mysql statement to be executed.
+ * @param	parameters	the parameters to be passed with the query.
+ * @param	results		the bindings which will receive the values of each row.
+ * @return	false on failure, or true on success.
+ */
+bool_t stmt_stream(stmt_cursor_t *cursor, MYSQL_STMT **group, MYSQL_BIND *parameters, MYSQL_BIND *results) {
+
+	return stmt_stream_user(cursor, group, parameters, results, 0);
+}
+
+/**
+ * @brief	Execute a prepared mysql statement which reads data belonging to a user, and open a cursor which streams the result set.
+ * @see		stmt_stream_conn()
+ * @note	A connection is pulled from a pool, and held until the cursor is closed. Read only statements are sent to a read replica
+ * 			when one is available, unless the user's data changed recently. If the replica fails, the statement is retried on the
+ * 			primary. Errors which occur after the first row has been fetched can't be retried.
+ * @param	cursor		a pointer to the cursor which will be opened.
+ * @param	group		the prepared mysql statement to be executed.
+ * @param	parameters	the parameters to be passed with the query.
+ * @param	results		the bindings which will receive the values of each row.
+ * @param	usernum		the numerical id of the user whose data is being read, or 0 if the read isn't tied to a user.
+ * @return	false on failure, or true on success.
+ */
+bool_t stmt_stream_user(stmt_cursor_t *cursor, MYSQL_STMT **group, MYSQL_BIND *parameters, MYSQL_BIND *results, uint64_t usernum) {
+
+	uint32_t connection;
+
+	if (!cursor) {
+		log_pedantic("Passed a NULL parameter.");
+		return false;
+	}
+
+	// Closing a cursor which failed to open is harmless.
+	mm_wipe(cursor, sizeof(stmt_cursor_t));
+
+	if (sql_replica_pull(group, usernum, &connection)) {
+
+		if (stmt_stream_conn(cursor, group, parameters, results, connection)) {
+			cursor->pooled = true;
+			return true;
+		}
+
+		sql_replica_failed(connection);
+		sql_connection_release(connection);
+	}
+
+	if (pool_pull(sql_pool, &connection) != PL_RESERVED) {
+		log_info("Unable to get an available connection for the query.");
+		return false;
+	}
+
+	if (!stmt_stream_conn(cursor, group, parameters, results, connection)) {
+		pool_release(sql_pool, connection);
+		return false;
+	}
+
+	cursor->pooled = true;
+
+	return true;
+}
+
+/**
+ * @brief	Read the next row of a streaming result set into the caller's result bindings.
+ * @note	The result buffers are zeroed before each row is read, so NULL values are returned as zero, or as an empty string, the same
+ * 			way they are when the result is stored in a table. A value which doesn't fit inside its buffer is treated as an error.
+ * @param	cursor	the cursor returned by stmt_stream() or stmt_stream_conn().
+ * @return	1 if a row was fetched, 0 if there are no more rows, or -1 on error.
+ */
+int_t stmt_fetch_next(stmt_cursor_t *cursor) {
+
+	int_t ret;
+	MYSQL_BIND *binding;
+
+	if (!cursor || !cursor->local) {
+		log_pedantic("Attempted to fetch a row using a cursor which isn't open.");
+		return -1;
+	}
+
+	binding = cursor->local->bind;
+
+	for (uint_t i = 0; binding && i < cursor->local->field_count; i++) {
+		if ((binding + i)->buffer && (binding + i)->buffer_length) mm_wipe((binding + i)->buffer, (binding + i)->buffer_length);
+		if ((binding + i)->length) *((binding + i)->length) = 0;
+	}
+
+	if ((ret = mysql_stmt_fetch_d(cursor->local)) == MYSQL_NO_DATA) {
+		return 0;
+	}
+	else if (ret == MYSQL_DATA_TRUNCATED) {
+		log_info("Fetching the row failed because a value would need to be truncated in order to fit within the buffer provided. " \
+			"{ row = %lu }", cursor->rows);
+		return -1;
+	}
+	else if (ret) {
+		log_info("An error occurred while fetching a row. { row = %lu / error = %s }", cursor->rows, stmt_error(cursor->local));
+		return -1;
+	}
+
+	cursor->rows++;
+
+	return 1;
+}
+
+/**
+ * @brief	Close a streaming cursor, discarding any rows which haven't been read, and release the connection if the cursor pulled it.
+ * @param	cursor	the cursor being closed.
+ * @return	This function returns no value.
+ */
+void stmt_stream_close(stmt_cursor_t *cursor) {
+
+	if (!cursor || !cursor->local) {
+		return;
+	}
+
+	mysql_stmt_free_result_d(cursor->local);
+
+	if (cursor->pooled) {
+		sql_connection_release(cursor->connection);
+	}
+
+	mm_wipe(cursor, sizeof(stmt_cursor_t));
+
+	return;
+}
@@ -40,6 +40,9 @@ int64_t tran_start(void) {
 		return -1;
 	}
 
+	// While the transaction is open, reads made by this thread are sent to the primary.
+	sql_replica_pin();
+
 	return transaction;
 }
 
@@ -56,10 +59,12 @@ int64_t tran_rollback(int64_t transaction)  {
 	if ((result = sql_query_conn(PLACER(tran_commands[1].command, tran_commands[1].length), transaction))) {
 		log_info("An error occurred while committing the transaction. { mysql_real_query = %li / error = %s }", result, sql_error(pool_get_obj(sql_pool, transaction)));
 		pool_release(sql_pool, transaction);
+		sql_replica_unpin();
 		return result;
 	}
 
 	pool_release(sql_pool, transaction);
+	sql_replica_unpin();
 	return result;
 }
 
@@ -76,10 +81,12 @@ int64_t tran_commit(int64_t transaction)  {
 	if ((result = sql_query_conn(PLACER(tran_commands[2].command, tran_commands[2].length), transaction))) {
 		log_info("An error occurred while committing the transaction. { mysql_real_query = %li / error = %s }", result, sql_error(pool_get_obj(sql_pool, transaction)));
 		pool_release(sql_pool, transaction);
+		sql_replica_unpin();
 		return result;
 	}
 
 	pool_release(sql_pool, transaction);
+	sql_replica_unpin();
 	return result;
 }
 
@@ -3,6 +3,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <sys/mman.h>
 
 #include "dime/signet-resolver/cache.h"
 #include "dime/signet-resolver/dns.h"
@@ -22,18 +23,23 @@ static char *_cachefile = NULL;
 static char *_dime_dir = NULL;
 static uid_t _last_uid = 0;
 
+// The journal of changes made to the cache since the last snapshot was written.
+static int _journal_fd = -1;
+static size_t _journal_size = 0;
+static pthread_mutex_t _journal_lock = PTHREAD_MUTEX_INITIALIZER;
+
 // This is the global table that stores all the cache management functions for the different types of data supported by the object cache.
 cached_store_t cached_stores[cached_data_signet + 1] = {
-    { cached_data_unknown, "unknown", 0, NULL, PTHREAD_MUTEX_INITIALIZER, NULL, NULL, NULL, NULL, NULL },
-    { cached_data_drec, "DIME management records", 0, NULL, PTHREAD_MUTEX_INITIALIZER, &_destroy_dime_record_cb,
+    { cached_data_unknown, "unknown", 0, NULL, PTHREAD_RWLOCK_INITIALIZER, NULL, NULL, NULL, NULL, NULL },
+    { cached_data_drec, "DIME management records", 0, NULL, PTHREAD_RWLOCK_INITIALIZER, &_destroy_dime_record_cb,
       &_serialize_dime_record_cb, &_deserialize_dime_record_cb, &_dump_dime_record_cb, NULL },
-    { cached_data_dnskey, "DNSKEY records", 1, NULL, PTHREAD_MUTEX_INITIALIZER, &_destroy_dnskey_record_cb,
+    { cached_data_dnskey, "DNSKEY records", 1, NULL, PTHREAD_RWLOCK_INITIALIZER, &_destroy_dnskey_record_cb,
       &_serialize_dnskey_record_cb, &_deserialize_dnskey_record_cb, &_dump_dnskey_record_cb, &_clone_dnskey_record_cb },
-    { cached_data_ds, "DS records", 1, NULL, PTHREAD_MUTEX_INITIALIZER, &_destroy_ds_record_cb,
+    { cached_data_ds, "DS records", 1, NULL, PTHREAD_RWLOCK_INITIALIZER, &_destroy_ds_record_cb,
       &_serialize_ds_record_cb, &_deserialize_ds_record_cb, &_dump_ds_record_cb, NULL },
-    { cached_data_ocsp, "OCSP", 1, NULL, PTHREAD_MUTEX_INITIALIZER, &_destroy_ocsp_response_cb,
+    { cached_data_ocsp, "OCSP", 1, NULL, PTHREAD_RWLOCK_INITIALIZER, &_destroy_ocsp_response_cb,
       &_serialize_ocsp_response_cb, &_deserialize_ocsp_response_cb, &_dump_ocsp_response_cb, NULL },
-    { cached_data_signet, "signets", 0, NULL, PTHREAD_MUTEX_INITIALIZER, &_destroy_signet_cb,
+    { cached_data_signet, "signets", 0, NULL, PTHREAD_RWLOCK_INITIALIZER, &_destroy_signet_cb,
       &_serialize_signet_cb, &_deserialize_signet_cb, &_dump_signet_cb, NULL }
 };
 
@@ -217,6 +223,17 @@ int _set_cache_location(const char *path) {
         RET_ERROR_INT(ERR_NOMEM, "could not allocate space for cache filename");
     }
 
+    // The journal lives alongside the cache file, so it will be reopened at the new location.
+    pthread_mutex_lock(&_journal_lock);
+
+    if (_journal_fd >= 0) {
+        close(_journal_fd);
+        _journal_fd = -1;
+        _journal_size = 0;
+    }
+
+    pthread_mutex_unlock(&_journal_lock);
+
     _dbgprint(2, "Cache location set explicitly: %s\n", path);
 
     return 0;
@@ -266,6 +283,7 @@ cached_object_t *_create_cached_object(cached_data_type_t dtype, unsigned long t
     result->data = data;
     result->persists = persists;
     result->relaxed = relaxed;
+    result->refs = 1;
 
     return result;
 }
@@ -340,6 +358,10 @@ void _destroy_cache_entry(cached_object_t *entry) {
 
     // TODO: What should we do if there is a cached object being shadowed by this one?
 
+    if (entry->snapshot) {
+        _release_cache_snapshot(entry->snapshot);
+    }
+
     memset(entry, 0, sizeof(cached_object_t));
     free(entry);
 
@@ -347,15 +369,81 @@ void _destroy_cache_entry(cached_object_t *entry) {
 
 
 /**
- * @brief   Find a cached object in a cached store.
- * @param   oid a null-terminated string containing the unique name or identifier of the cached object.
+ * @brief   Release a reference to a cached object, and destroy the object once the last reference is gone.
+ * @note    A cached object holds one reference for as long as it is linked into its store, and readers hold another while
+ *              they're using it. An object which is evicted while it's still being read is only freed by its final reader.
+ * @param   object  a pointer to the cached object to be released.
+ */
+void _release_cached_object(cached_object_t *object) {
+
+    if (!object) {
+        return;
+    }
+
+    if (!__sync_sub_and_fetch(&(object->refs), 1)) {
+        _destroy_cache_entry(object);
+    }
+
+}
+
+
+/**
+ * @brief   Locate a cached object by its hashed id using the store's hash index.
+ * @note    The caller must hold the store lock. The object is returned even if it has expired.
+ * @param   hashid  the (already) hashed unique id of the object to be located in the cache.
+ * @param   store   a pointer to the cached store to be searched for the target object.
+ * @return  a pointer to the cached object, if found, or NULL if it isn't in the store.
+ */
+cached_object_t *_lookup_cached_object(const unsigned char *hashid, cached_store_t *store) {
+
+    cached_object_t *ptr = store->buckets[CACHE_BUCKET(hashid)];
+
+    while (ptr && memcmp(ptr->id, hashid, SHA_256_SIZE)) {
+        ptr = ptr->chain;
+    }
+
+    return ptr;
+}
+
+
+/**
+ * @brief   Link a cached object into the head of a store's linked list, and into its hash index.
+ * @note    The caller must hold the store lock exclusively. The store takes over the caller's reference to the object.
+ * @param   store   a pointer to the cached store that will hold the object.
+ * @param   object  a pointer to the cached object to be linked into the store.
+ */
+void _link_object(cached_store_t *store, cached_object_t *object) {
+
+    unsigned int bucket = CACHE_BUCKET(object->id);
+
+    object->prev = NULL;
+    object->next = store->head;
+
+    if (store->head) {
+        store->head->prev = object;
+    }
+
+    store->head = object;
+
+    object->chain = store->buckets[bucket];
+    store->buckets[bucket] = object;
+
+}
+
+
+/**
+ * @brief   Acquire a shared reference to a cached object by name.
+ * @note    Unlike _find_cached_object(), the object is never cloned. The object and its data are shared with the cache and
+ *              every other reader, so they must be treated as read-only, and released using _release_cached_object().
+ * @param   oid     a null-terminated string containing the unique name or identifier of the cached object.
  * @param   store   a pointer to the cached store to be searched for the target object.
  * @return  a pointer to the specified cached object, if found, or NULL on failure.
  */
-cached_object_t *_find_cached_object(const char *oid, cached_store_t *store) {
+cached_object_t *_acquire_cached_object(const char *oid, cached_store_t *store) {
 
     cached_object_t *ptr;
     unsigned char hashid[SHA_256_SIZE];
+    int res;
 
     if (!oid || !store) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
@@ -370,48 +458,57 @@ cached_object_t *_find_cached_object(const char *oid, cached_store_t *store) {
         RET_ERROR_PTR(ERR_UNSPEC, "could not compute SHA hash of cached object name");
     }
 
-    _lock_cache_store(store);
-    ptr = store->head;
+    _read_lock_cache_store(store);
 
-    while (ptr) {
+    // Stale objects are left for the next sweep, but they're never returned.
+    if ((ptr = _lookup_cached_object(hashid, store)) && (res = _is_object_expired(ptr, NULL))) {
 
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
-            continue;
+        if (res < 0) {
+            _clear_error_stack();
+        } else {
+            ptr = NULL;
         }
 
-        if (!memcmp(ptr->id, hashid, SHA_256_SIZE)) {
-            ptr = _clone_cached_object(ptr);
-            _unlock_cache_store(store);
+    }
 
-            if (!ptr) {
-                RET_ERROR_PTR(ERR_UNSPEC, "unable to create deep copy of cloned object");
-            }
+    // Deserializing an object that was loaded from the snapshot modifies it, which requires the exclusive lock.
+    if (ptr && ptr->snapshot) {
+        _unlock_cache_store(store);
+        _lock_cache_store(store);
 
-            return ptr;
+        if ((ptr = _lookup_cached_object(hashid, store)) && _materialize_cached_object(ptr) < 0) {
+            fprintf(stderr, "Error: cached object could not be deserialized (evicting)...\n");
+            dump_error_stack();
+            _clear_error_stack();
+            _unlink_object(ptr, 1, 0);
+            ptr = NULL;
         }
 
-        ptr = ptr->next;
+    }
+
+    if (ptr) {
+        __sync_add_and_fetch(&(ptr->refs), 1);
     }
 
     _unlock_cache_store(store);
 
-    return NULL;
+    return ptr;
 }
 
 
 /**
- * @brief   Find a cached object in a cached store using a custom comparator.
- * @note    This function is used when the simple unique object ID is not sufficient to identify an object.
- * @param   key a pointer to an object-specific key that will be passed to the custom comparison function.
+ * @brief   Acquire a shared reference to a cached object using a custom comparator.
+ * @see     _acquire_cached_object()
+ * @param   key     a pointer to an object-specific key that will be passed to the custom comparison function.
  * @param   store   a pointer to the cached store in which to search for the cached object.
  * @param   cmpfn   a custom comparison function that will compare the key value to the objects in the
  *                      specified cached store and determine whether the two objects match one another.
  * @return  a pointer to the found cached object on success, or NULL on failure.
  */
-cached_object_t *_find_cached_object_cmp(const void *key, cached_store_t *store, cached_store_comparator_t cmpfn) {
+cached_object_t *_acquire_cached_object_cmp(const void *key, cached_store_t *store, cached_store_comparator_t cmpfn) {
 
     cached_object_t *ptr;
+    int res;
 
     if (!key || !store || !cmpfn) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
@@ -421,25 +518,30 @@ cached_object_t *_find_cached_object_cmp(const void *key, cached_store_t *store,
         RET_ERROR_PTR(ERR_PERM, NULL);
     }
 
-    _lock_cache_store(store);
+    // Comparators inspect the object data, so anything still in the snapshot has to be deserialized first.
+    if (store->pending) {
+        _lock_cache_store(store);
+        _materialize_cached_store(store);
+        _unlock_cache_store(store);
+    }
+
+    _read_lock_cache_store(store);
     ptr = store->head;
 
+    // A custom comparator can't use the hash index, so the whole store is searched.
     while (ptr) {
 
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
-            continue;
-        }
-
         if (!cmpfn(ptr->data, key)) {
-            ptr = _clone_cached_object(ptr);
-            _unlock_cache_store(store);
 
-            if (!ptr) {
-                RET_ERROR_PTR(ERR_UNSPEC, "unable to create deep copy of cloned object");
+            if ((res = _is_object_expired(ptr, NULL)) < 0) {
+                _clear_error_stack();
+            }
+
+            if (res <= 0) {
+                __sync_add_and_fetch(&(ptr->refs), 1);
+                break;
             }
 
-            return ptr;
         }
 
         ptr = ptr->next;
@@ -447,7 +549,64 @@ cached_object_t *_find_cached_object_cmp(const void *key, cached_store_t *store,
 
     _unlock_cache_store(store);
 
-    return NULL;
+    return ptr;
+}
+
+
+/**
+ * @brief   Find a cached object in a cached store.
+ * @note    Objects in internal stores are returned directly. Otherwise the caller receives a deep copy of the object, which is
+ *              made after the store lock has been released, so concurrent lookups aren't held up by the copy.
+ * @param   oid a null-terminated string containing the unique name or identifier of the cached object.
+ * @param   store   a pointer to the cached store to be searched for the target object.
+ * @return  a pointer to the specified cached object, if found, or NULL on failure.
+ */
+cached_object_t *_find_cached_object(const char *oid, cached_store_t *store) {
+
+    cached_object_t *ptr, *result;
+
+    if (!(ptr = _acquire_cached_object(oid, store))) {
+        return NULL;
+    }
+
+    result = _clone_cached_object(ptr);
+
+    // An internal store returns the cached object itself, which the store keeps a reference to.
+    _release_cached_object(ptr);
+
+    if (!result) {
+        RET_ERROR_PTR(ERR_UNSPEC, "unable to create deep copy of cloned object");
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief   Find a cached object in a cached store using a custom comparator.
+ * @note    This function is used when the simple unique object ID is not sufficient to identify an object.
+ * @param   key a pointer to an object-specific key that will be passed to the custom comparison function.
+ * @param   store   a pointer to the cached store in which to search for the cached object.
+ * @param   cmpfn   a custom comparison function that will compare the key value to the objects in the
+ *                      specified cached store and determine whether the two objects match one another.
+ * @return  a pointer to the found cached object on success, or NULL on failure.
+ */
+cached_object_t *_find_cached_object_cmp(const void *key, cached_store_t *store, cached_store_comparator_t cmpfn) {
+
+    cached_object_t *ptr, *result;
+
+    if (!(ptr = _acquire_cached_object_cmp(key, store, cmpfn))) {
+        return NULL;
+    }
+
+    result = _clone_cached_object(ptr);
+    _release_cached_object(ptr);
+
+    if (!result) {
+        RET_ERROR_PTR(ERR_UNSPEC, "unable to create deep copy of cloned object");
+    }
+
+    return result;
 }
 
 
@@ -460,6 +619,7 @@ cached_object_t *_find_cached_object_cmp(const void *key, cached_store_t *store,
 int _cached_object_exists(const unsigned char *hashid, cached_store_t *store) {
 
     cached_object_t *ptr;
+    int result = 0;
 
     if (!store || !hashid) {
         RET_ERROR_INT(ERR_BAD_PARAM, NULL);
@@ -469,28 +629,18 @@ int _cached_object_exists(const unsigned char *hashid, cached_store_t *store) {
         RET_ERROR_INT(ERR_UNSPEC, "no permission to read cache contents");
     }
 
-    _lock_cache_store(store);
-    ptr = store->head;
-
-    // If the store is empty, don't worry; if not, see that we don't already exist.
-    while (ptr) {
-
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
-            continue;
-        }
-
-        if (!memcmp(ptr->id, hashid, SHA_256_SIZE)) {
-            _unlock_cache_store(store);
-            return 1;
-        }
+    _read_lock_cache_store(store);
 
-        ptr = ptr->next;
+    if ((ptr = _lookup_cached_object(hashid, store)) && (result = _is_object_expired(ptr, NULL)) < 0) {
+        _clear_error_stack();
     }
 
+    // An object that has gone stale, but hasn't been swept yet, doesn't count.
+    result = (ptr && result <= 0) ? 1 : 0;
+
     _unlock_cache_store(store);
 
-    return 0;
+    return result;
 }
 
 
@@ -515,28 +665,13 @@ int _cached_object_exists_cmp(const void *key, cached_store_t *store, cached_sto
         RET_ERROR_INT(ERR_UNSPEC, "no permission to read cache contents");
     }
 
-    _lock_cache_store(store);
-    ptr = store->head;
-
-    // If the store is empty, don't worry; if not, see that we don't already exist.
-    while (ptr) {
-
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
-            continue;
-        }
-
-        if (!cmpfn(ptr->data, key)) {
-            _unlock_cache_store(store);
-            return 1;
-        }
-
-        ptr = ptr->next;
+    if (!(ptr = _acquire_cached_object_cmp(key, store, cmpfn))) {
+        return get_last_error() ? -1 : 0;
     }
 
-    _unlock_cache_store(store);
+    _release_cached_object(ptr);
 
-    return 0;
+    return 1;
 }
 
 
@@ -555,9 +690,10 @@ int _cached_object_exists_cmp(const void *key, cached_store_t *store, cached_sto
  */
 cached_object_t *_add_cached_object(const char *id, cached_store_t *store, unsigned long ttl, time_t expiration, void *data, int persists, int relaxed) {
 
-    cached_object_t *ptr, *entry, *optr, *result;
+    cached_object_t *ptr, *entry, *result;
     void *odata;
     unsigned char hashid[SHA_256_SIZE];
+    time_t now;
 
     if (!id || !store) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
@@ -571,57 +707,31 @@ cached_object_t *_add_cached_object(const char *id, cached_store_t *store, unsig
         RET_ERROR_PTR(ERR_UNSPEC, "could not compute SHA hash of new cache entry");
     }
 
-    _lock_cache_store(store);
-    ptr = store->head;
-
-    // If the store is empty, don't worry; if not, see that we don't already exist.
-    while (ptr) {
-
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
-            continue;
-        }
-
-        if (!memcmp(ptr->id, hashid, SHA_256_SIZE)) {
-            _unlock_cache_store(store);
-            RET_ERROR_PTR_FMT(ERR_UNSPEC, "could not add cached object to store because object id already exists: %s", id);
-        }
-
-        ptr = ptr->next;
+    // Stale objects are swept out periodically by the writers, rather than by every lookup.
+    if (time(&now) != (time_t)-1 && (now - store->swept) >= CACHE_SWEEP_INTERVAL) {
+        _evict_stale_objects(store);
     }
 
-    // TODO: Can't we use _create_cached_object() here?
-    if (!(entry = malloc(sizeof(cached_object_t)))) {
-        PUSH_ERROR_SYSCALL("malloc");
+    _lock_cache_store(store);
+
+    // If the store already holds this id, it can only be replaced if it's stale.
+    if ((ptr = _lookup_cached_object(hashid, store)) && !_evict_if_stale(&ptr)) {
         _unlock_cache_store(store);
-        RET_ERROR_PTR(ERR_NOMEM, "could not allocate space for new cached object");
+        RET_ERROR_PTR_FMT(ERR_UNSPEC, "could not add cached object to store because object id already exists: %s", id);
     }
 
-    // Initialize the new object.
-    memset(entry, 0, sizeof(cached_object_t));
-
-    if (time(&(entry->timestamp)) == (time_t)-1) {
-        PUSH_ERROR_SYSCALL("time");
-        free(entry);
+    if (!(entry = _create_cached_object(store->dtype, ttl, expiration, data, persists, relaxed))) {
         _unlock_cache_store(store);
-        RET_ERROR_PTR(ERR_UNSPEC, "could not calculate timestamp for new cached object");
+        RET_ERROR_PTR(ERR_UNSPEC, "unable to create new cached object");
     }
 
     memcpy(entry->id, hashid, SHA_256_SIZE);
-    entry->dtype = store->dtype;
-    entry->ttl = ttl;
-    entry->expiration = expiration;
-    entry->data = data;
-    entry->persists = persists;
-    entry->relaxed = relaxed;
+    _link_object(store, entry);
 
-    // Prepend it to the beginning of the linked list.
-    optr = store->head;
-    store->head = entry;
-    entry->next = optr;
-
-    if (optr) {
-        optr->prev = entry;
+    if (persists && _journal_cached_object(entry, 0) < 0) {
+        fprintf(stderr, "Error: unable to journal new cached object:\n");
+        dump_error_stack();
+        _clear_error_stack();
     }
 
     result = _clone_cached_object(entry);
@@ -663,6 +773,7 @@ cached_object_t *_add_cached_object_forced(const char *id, cached_store_t *store
 
     cached_object_t *found, *newobj, *result;
     void *odata;
+    unsigned char hashid[SHA_256_SIZE];
 
     if (!id || !store) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
@@ -672,9 +783,14 @@ cached_object_t *_add_cached_object_forced(const char *id, cached_store_t *store
         RET_ERROR_PTR(ERR_PERM, NULL);
     }
 
-    // TODO: thread-safe code needs to be added here.
-    // If we find a clashing object, remove it.
-    if ((found = _find_cached_object(id, store))) {
+    if (_compute_sha_hash(256, (unsigned char *)id, strlen(id), hashid) < 0) {
+        RET_ERROR_PTR(ERR_UNSPEC, "could not compute SHA hash of new cache entry");
+    }
+
+    _lock_cache_store(store);
+
+    // If we find a clashing object, replace it while still holding the lock.
+    if ((found = _lookup_cached_object(hashid, store))) {
 
         if (_verbose >= 1) {
             _dbgprint(1, "Forcibly overriding existing conflicting entry in cache: ");
@@ -690,12 +806,13 @@ cached_object_t *_add_cached_object_forced(const char *id, cached_store_t *store
 
         // We create the new object to replace the old one.
         if (!(newobj = _create_cached_object(store->dtype, ttl, expiration, data, persists, relaxed))) {
-            _destroy_cache_entry(found);
+            _unlock_cache_store(store);
             RET_ERROR_PTR(ERR_UNSPEC, "unable to create new cached object");
         }
 
         // Call replace and make the old cache object our shadow.
         if (!_replace_object(found, newobj, 1)) {
+            _unlock_cache_store(store);
             _destroy_cache_entry(newobj);
             RET_ERROR_PTR(ERR_UNSPEC, "unable to replace entry in cache");
         }
@@ -709,8 +826,11 @@ cached_object_t *_add_cached_object_forced(const char *id, cached_store_t *store
             result->data = odata;
         }
 
+        _unlock_cache_store(store);
+
     } else {
         // Otherwise we still have to add it normally.
+        _unlock_cache_store(store);
         result = _add_cached_object(id, store, ttl, expiration, data, persists, relaxed);
     }
 
@@ -740,9 +860,10 @@ cached_object_t *_add_cached_object_forced(const char *id, cached_store_t *store
  */
 cached_object_t *_add_cached_object_cmp(const char *id, const void *key, cached_store_t *store, unsigned long ttl, time_t expiration, void *data, int persists, int relaxed, cached_store_comparator_t cmpfn) {
 
-    cached_object_t *ptr, *entry, *optr, *result;
+    cached_object_t *ptr, *entry, *result;
     void *odata;
     unsigned char hashid[SHA_256_SIZE];
+    time_t now;
 
     if (!id || !store || !cmpfn) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
@@ -756,27 +877,31 @@ cached_object_t *_add_cached_object_cmp(const char *id, const void *key, cached_
         RET_ERROR_PTR(ERR_UNSPEC, "could not compute SHA hash of new cache entry");
     }
 
+    // Stale objects are swept out periodically by the writers, rather than by every lookup.
+    if (time(&now) != (time_t)-1 && (now - store->swept) >= CACHE_SWEEP_INTERVAL) {
+        _evict_stale_objects(store);
+    }
+
     _lock_cache_store(store);
+    _materialize_cached_store(store);
     ptr = store->head;
 
     // If the store is empty, don't worry; if not, see that we don't already exist.
     while (ptr) {
 
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
+        // We don't want to have an entry that clashes in ID or that fails the comparator test, unless it's stale.
+        if (memcmp(ptr->id, hashid, SHA_256_SIZE) && cmpfn(ptr->data, key)) {
+            ptr = ptr->next;
             continue;
-        }
-
-        // We don't want to have an entry that clashes in ID or that fails the comparator test.
-        if (!memcmp(ptr->id, hashid, SHA_256_SIZE)) {
+        } else if (_evict_if_stale(&ptr)) {
+            continue;
+        } else if (!memcmp(ptr->id, hashid, SHA_256_SIZE)) {
             _unlock_cache_store(store);
             RET_ERROR_PTR(ERR_UNSPEC, "could not add cached object to store because object ID already exists");
-        } else if (!cmpfn(ptr->data, key)) {
-            _unlock_cache_store(store);
-            RET_ERROR_PTR(ERR_UNSPEC, "could not add cached object to store because a similar object already exists");
         }
 
-        ptr = ptr->next;
+        _unlock_cache_store(store);
+        RET_ERROR_PTR(ERR_UNSPEC, "could not add cached object to store because a similar object already exists");
     }
 
     if (!(entry = _create_cached_object(store->dtype, ttl, expiration, data, persists, relaxed))) {
@@ -786,14 +911,12 @@ cached_object_t *_add_cached_object_cmp(const char *id, const void *key, cached_
 
     // The only additional field that needs to be set for the cached object is the hashed id.
     memcpy(entry->id, hashid, SHA_256_SIZE);
+    _link_object(store, entry);
 
-    // Prepend it to the beginning of the linked list.
-    optr = store->head;
-    store->head = entry;
-    entry->next = optr;
-
-    if (optr) {
-        optr->prev = entry;
+    if (persists && _journal_cached_object(entry, 0) < 0) {
+        fprintf(stderr, "Error: unable to journal new cached object:\n");
+        dump_error_stack();
+        _clear_error_stack();
     }
 
     result = _clone_cached_object(entry);
@@ -836,8 +959,9 @@ cached_object_t *_add_cached_object_cmp_forced(const char *id, const void *key,
 
     cached_object_t *found, *newobj, *result;
     void *odata;
+    unsigned char hashid[SHA_256_SIZE];
 
-    if (!id || !store) {
+    if (!id || !store || !cmpfn) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
     }
 
@@ -845,9 +969,20 @@ cached_object_t *_add_cached_object_cmp_forced(const char *id, const void *key,
         RET_ERROR_PTR(ERR_PERM, NULL);
     }
 
-    // TODO: Needs to be made thread-safe.
-    // If we find a clashing object, remove it.
-    if ((found = _find_cached_object_cmp(key, store, cmpfn)) || (found = _find_cached_object(id, store))) {
+    if (_compute_sha_hash(256, (unsigned char *)id, strlen(id), hashid) < 0) {
+        RET_ERROR_PTR(ERR_UNSPEC, "could not compute SHA hash of new cache entry");
+    }
+
+    _lock_cache_store(store);
+    _materialize_cached_store(store);
+    found = store->head;
+
+    // If we find a clashing object, replace it while still holding the lock.
+    while (found && cmpfn(found->data, key)) {
+        found = found->next;
+    }
+
+    if (found || (found = _lookup_cached_object(hashid, store))) {
 
         if (_verbose >= 1) {
             _dbgprint(1, "Forcibly overriding existing conflicting entry in cache: ");
@@ -861,12 +996,13 @@ cached_object_t *_add_cached_object_cmp_forced(const char *id, const void *key,
 
         // We create the new object to replace the old one.
         if (!(newobj = _create_cached_object(store->dtype, ttl, expiration, data, persists, relaxed))) {
-            _destroy_cache_entry(found);
+            _unlock_cache_store(store);
             RET_ERROR_PTR(ERR_UNSPEC, "unable to create new cached object");
         }
 
         // Call replace and make the old cache object our shadow.
         if (!_replace_object(found, newobj, 1)) {
+            _unlock_cache_store(store);
             _destroy_cache_entry(newobj);
             RET_ERROR_PTR(ERR_UNSPEC, "unable to replace entry in cache");
         }
@@ -881,7 +1017,10 @@ cached_object_t *_add_cached_object_cmp_forced(const char *id, const void *key,
             result->data = odata;
         }
 
+        _unlock_cache_store(store);
+
     } else {
+        _unlock_cache_store(store);
         result = _add_cached_object_cmp(id, key, store, ttl, expiration, data, persists, relaxed, cmpfn);
     }
 
@@ -895,7 +1034,7 @@ cached_object_t *_add_cached_object_cmp_forced(const char *id, const void *key,
 
 /**
  * @brief   Remove an object from a cached store by name.
- * @note    The caller is still responsible for freeing the cached object and its underlying data.
+ * @note    The object is freed once any readers holding a reference to it have released it.
  * @param   oid the unique identifier of the cached object to be removed.
  * @param   store   a pointer to the cached store from which the specified object will be removed.
  * @return  1 if the object was successfully removed or 0 if it couldn't be found; -1 on general error.
@@ -918,32 +1057,27 @@ int _remove_cached_object(const char *oid, cached_store_t *store) {
     }
 
     _lock_cache_store(store);
-    ptr = store->head;
-
-    // If we find the cached object, cut it from the store's linked list.
-    while (ptr) {
-
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
-            continue;
-        }
 
-        if (!memcmp(ptr->id, hashid, SHA_256_SIZE)) {
-            _unlink_object(ptr, 1, 0);
-            _unlock_cache_store(store);
-            return 1;
-        }
+    // A stale object is removed all the same, but it isn't reported as found.
+    if (!(ptr = _lookup_cached_object(hashid, store)) || _evict_if_stale(&ptr)) {
+        _unlock_cache_store(store);
+        return 0;
+    }
 
-        ptr = ptr->next;
+    if (ptr->persists && _journal_cached_object(ptr, 1) < 0) {
+        fprintf(stderr, "Error: unable to journal removed cached object:\n");
+        dump_error_stack();
+        _clear_error_stack();
     }
 
+    _unlink_object(ptr, 1, 0);
     _unlock_cache_store(store);
 
-    return 0;
+    return 1;
 }
 /**
  * @brief   Remove an object from a cached store using a custom comparator function.
- * @note    The caller is still responsible for freeing the cached object and its underlying data.
+ * @note    The object is freed once any readers holding a reference to it have released it.
  * @param   key a pointer to an object-specific key that will be passed to the custom comparison function.
  * @param   store   a pointer to the cached store from which the specified object will be removed.
  * @param   cmpfn   a custom comparison function that will compare the key value to the objects in the
@@ -963,23 +1097,28 @@ int _remove_cached_object_cmp(const void *key, cached_store_t *store, cached_sto
     }
 
     _lock_cache_store(store);
+    _materialize_cached_store(store);
     ptr = store->head;
 
-    // If we find the cached object, cut it from the store's linked list and free its underlying data, and then itself.
+    // If we find the cached object, cut it from the store's linked list and release the store's reference to it.
     while (ptr) {
 
-        // As we go along, evict any stale items.
-        if (_evict_if_stale(&ptr)) {
+        if (cmpfn(ptr->data, key)) {
+            ptr = ptr->next;
+            continue;
+        } else if (_evict_if_stale(&ptr)) {
             continue;
         }
 
-        if (!cmpfn(ptr->data, key)) {
-            _unlink_object(ptr, 1, 0);
-            _unlock_cache_store(store);
-            return 1;
+        if (ptr->persists && _journal_cached_object(ptr, 1) < 0) {
+            fprintf(stderr, "Error: unable to journal removed cached object:\n");
+            dump_error_stack();
+            _clear_error_stack();
         }
 
-        ptr = ptr->next;
+        _unlink_object(ptr, 1, 0);
+        _unlock_cache_store(store);
+        return 1;
     }
 
     _unlock_cache_store(store);
@@ -1028,6 +1167,7 @@ cached_object_t *_clone_cached_object(const cached_object_t *obj) {
     result->expiration = obj->expiration;
     result->relaxed = obj->relaxed;
     result->persists = obj->persists;
+    result->refs = 1;
 
     // If the object has a clone routine, then use it. Otherwise, simulate it with serialize/deserialize.
     if (obj->data && store->clone) {
@@ -1080,7 +1220,7 @@ void _dump_cache(cached_data_type_t dtype, int do_data, int ephemeral) {
 
         fprintf(stderr, "Dumping data cached store of type: %s ...\n", cached_stores[i].description);
 
-        _lock_cache_store(&(cached_stores[i]));
+        _read_lock_cache_store(&(cached_stores[i]));
 
         if (!(ptr = cached_stores[i].head)) {
             fprintf(stderr, "- Skipped empty store.\n");
@@ -1121,7 +1261,7 @@ void _dump_cache(cached_data_type_t dtype, int do_data, int ephemeral) {
 
             expstr = ptr->expiration ? _get_chr_date(ptr->expiration, 1) : strdup("[none]");
             fprintf(stderr, "] ttl = %s, expiration = %s, data = %s, timestamp = %s, persist = %s",
-                    ttlstr, (expstr ? expstr : "[error]"), (ptr->data ? "yes" : "no"), (tstr ? tstr : "[unknown timestamp]"), (ptr->persists ? "yes" : "no"));
+                    ttlstr, (expstr ? expstr : "[error]"), (ptr->data ? "yes" : (ptr->snapshot ? "deferred" : "no")), (tstr ? tstr : "[unknown timestamp]"), (ptr->persists ? "yes" : "no"));
 
             if (ptr->relaxed) {
                 fprintf(stderr, " [RELAXED]");
@@ -1173,7 +1313,8 @@ void _dump_cache_data(FILE *fp, const cached_object_t *obj, int brief) {
         return;
     }
 
-    if (!store->dump) {
+    // Objects that haven't been deserialized from the snapshot yet have nothing to dump.
+    if (!store->dump || !obj->data) {
         return;
     }
 
@@ -1190,308 +1331,710 @@ void _dump_cache_data(FILE *fp, const cached_object_t *obj, int brief) {
 
 
 /**
- * @brief   Persist the entire contents of the cache to local storage.
- * @return  1 if the cache was loaded successfully, 0 if it was created, or -1 on general failure.
+ * @brief   Load the contents of the cache from local storage.
+ * @note    The snapshot is mapped into memory and only the record headers are read, so every object is linked into its
+ *              store without being deserialized. An object's data is deserialized the first time the object is accessed.
+ *              Any changes recorded in the journal since the snapshot was written are then replayed on top of it.
+ * @return  1 if the cache was loaded successfully, 0 if it was created, or -1 on general failure.
+ */
+int _load_cache_contents(void) {
+
+    cached_store_t *store;
+    cached_object_t *obj, *dupe;
+    cache_snapshot_t *snapshot;
+    struct stat sb;
+    char *cfile;
+    size_t offset = 0, count = 0;
+    int cfd;
+    uint32_t objlen;
+
+    if (!(_cache_flags & CACHE_PERM_LOAD)) {
+        RET_ERROR_INT(ERR_PERM, NULL);
+    }
+
+    // Get the name of the cache file to be opened for reading.
+    if (!(cfile = _get_cache_location())) {
+        RET_ERROR_INT(ERR_UNSPEC, "unable to open object cache file for reading");
+    }
+
+    if ((cfd = open(cfile, O_RDONLY)) < 0) {
+
+        _dbgprint(4, "Cache file was not found... creating.\n");
+
+        if ((cfd = creat(cfile, S_IRWXU)) < 0) {
+            PUSH_ERROR_SYSCALL("creat");
+            free(cfile);
+            RET_ERROR_INT(ERR_UNSPEC, "unable to create cache file");
+        }
+
+        close(cfd);
+        free(cfile);
+
+        // A journal can outlive its snapshot if we crashed before the first snapshot was written.
+        return _replay_cache_journal() < 0 ? -1 : 0;
+    }
+
+    free(cfile);
+
+    if (fstat(cfd, &sb) < 0) {
+        PUSH_ERROR_SYSCALL("fstat");
+        close(cfd);
+        RET_ERROR_INT(ERR_UNSPEC, "unable to determine the size of the cache file");
+    } else if (!sb.st_size) {
+        close(cfd);
+        return _replay_cache_journal() < 0 ? -1 : 1;
+    }
+
+    if (!(snapshot = malloc(sizeof(cache_snapshot_t)))) {
+        PUSH_ERROR_SYSCALL("malloc");
+        close(cfd);
+        RET_ERROR_INT(ERR_NOMEM, NULL);
+    }
+
+    // The mapping is private and writable, since the deserializers expect a buffer they are free to modify.
+    snapshot->length = sb.st_size;
+    snapshot->refs = 1;
+
+    if ((snapshot->map = mmap(NULL, snapshot->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, cfd, 0)) == MAP_FAILED) {
+        PUSH_ERROR_SYSCALL("mmap");
+        free(snapshot);
+        close(cfd);
+        RET_ERROR_INT(ERR_UNSPEC, "unable to map the cache file into memory");
+    }
+
+    // The mapping remains valid once the descriptor is closed.
+    close(cfd);
+
+    // The file consists of a sequence of object chunk lengths and data.
+    while (offset + sizeof(objlen) <= snapshot->length) {
+
+        memcpy(&objlen, snapshot->map + offset, sizeof(objlen));
+        offset += sizeof(objlen);
+
+        if (!objlen) {
+            continue;
+        } else if (objlen > snapshot->length - offset) {
+            fprintf(stderr, "Error: reached unexpected end of cache data file.\n");
+            break;
+        } else if (objlen <= CACHE_HEADER_SIZE) {
+            fprintf(stderr, "Error reading in cached object data; unexpected small entry size.\n");
+            offset += objlen;
+            continue;
+        }
+
+        if (!(obj = malloc(sizeof(cached_object_t)))) {
+            PUSH_ERROR_SYSCALL("malloc");
+            _release_cache_snapshot(snapshot);
+            RET_ERROR_INT(ERR_NOMEM, NULL);
+        }
+
+        // Copy the header information in from the file, and leave the data in the mapping until it's needed.
+        memset(obj, 0, sizeof(cached_object_t));
+        memcpy(obj, snapshot->map + offset, CACHE_HEADER_SIZE);
+        obj->image = snapshot->map + offset + CACHE_HEADER_SIZE;
+        obj->imagelen = objlen - CACHE_HEADER_SIZE;
+        offset += objlen;
+
+        // Make sure we're even able to handle this data type.
+        if (!(store = _get_cached_store_by_type(obj->dtype))) {
+            fprintf(stderr, "Error: read cached data of unrecognized type. Continuing...\n");
+            free(obj);
+            continue;
+        } else if (!store->deserialize) {
+            fprintf(stderr, "Error: cached object did not have a deserialization handler. Continuing...\n");
+            free(obj);
+            continue;
+        }
+
+        // Everything that was loaded from the cache is automatically persisted again.
+        obj->persists = 1;
+        obj->refs = 1;
+        obj->snapshot = snapshot;
+        __sync_add_and_fetch(&(snapshot->refs), 1);
+
+        // Finally store the object in the cache if it doesn't already exist, checking and inserting under the same lock.
+        _lock_cache_store(store);
+
+        if ((dupe = _lookup_cached_object(obj->id, store)) && !_evict_if_stale(&dupe)) {
+            _unlock_cache_store(store);
+            fprintf(stderr, "Error: deserialized cached object was a duplicate.\n");
+            _destroy_cache_entry(obj);
+            continue;
+        }
+
+        _link_object(store, obj);
+        store->pending++;
+        _unlock_cache_store(store);
+        count++;
+    }
+
+    _dbgprint(4, "Mapped %zu cached objects from the cache file.\n", count);
+
+    // Drop the reference held while loading, so the mapping is released once every object has been deserialized or evicted.
+    _release_cache_snapshot(snapshot);
+
+    if (_replay_cache_journal() < 0) {
+        RET_ERROR_INT(ERR_UNSPEC, "unable to replay the cache journal");
+    }
+
+    return 1;
+}
+
+
+/**
+ * @brief   Persist the entire contents of the cache to local storage.
+ * @note    The snapshot is written to a temporary file which then replaces the cache file, so a crash part way through
+ *              leaves the previous snapshot intact. Since the new snapshot includes every change, the journal is then
+ *              truncated. Every store is read locked for the duration, so the snapshot and journal can't disagree.
+ * @return  0 on success or -1 on failure.
+ */
+int _save_cache_contents(void) {
+
+    cached_object_t *ptr, *towrite;
+    char *cfile, *tfile = NULL;
+    size_t nstores = sizeof(cached_stores) / sizeof(cached_store_t);
+    int cfd, result = 0;
+
+    if (!(_cache_flags & CACHE_PERM_LOAD)) {
+        RET_ERROR_INT(ERR_PERM, NULL);
+    }
+
+    // Get the name of the cache file to be replaced, and the temporary file the snapshot will be written to first.
+    if (!(cfile = _get_cache_location())) {
+        RET_ERROR_INT(ERR_UNSPEC, "unable to determine cache file location");
+    } else if (!str_printf(&tfile, "%s.tmp", cfile)) {
+        free(cfile);
+        RET_ERROR_INT(ERR_NOMEM, "could not allocate space for temporary cache filename");
+    }
+
+    if ((cfd = open(tfile, (O_CREAT | O_TRUNC | O_WRONLY), (S_IRWXU))) < 0) {
+        PUSH_ERROR_SYSCALL("open");
+        PUSH_ERROR_FMT(ERR_UNSPEC, "unable to open object cache file for writing: %s", tfile);
+        free(cfile);
+        free(tfile);
+        return -1;
+    }
+
+    // The stores are always locked before the journal, matching the order used by the writers.
+    for(size_t i = 1; i < nstores; i++) {
+        _read_lock_cache_store(&(cached_stores[i]));
+    }
+
+    pthread_mutex_lock(&_journal_lock);
+
+    for(size_t i = 1; i < nstores && !result; i++) {
+        _dbgprint(4, "Persisting cache of type: %s ...\n", cached_stores[i].description);
+
+        if (!cached_stores[i].serialize) {
+            continue;
+        }
+
+        for (ptr = cached_stores[i].head; ptr && !result; ptr = ptr->next) {
+
+            // If we're shadowing a cached object, then the shadowed entry is the one that needs to be persisted.
+            towrite = ptr->shadow ? ptr->shadow : ptr;
+
+            // Only bother with the entries that need to be saved.
+            if (towrite->persists && _write_cache_record(cfd, towrite, 0) < 0) {
+                result = -1;
+            }
+
+        }
+
+    }
+
+    if (!result && fsync(cfd) < 0) {
+        PUSH_ERROR_SYSCALL("fsync");
+        result = -1;
+    }
+
+    close(cfd);
+
+    if (!result && rename(tfile, cfile) < 0) {
+        PUSH_ERROR_SYSCALL("rename");
+        result = -1;
+    }
+
+    // The journal can only be discarded once the rename itself is durable.
+    if (!result && _sync_cache_directory(cfile) < 0) {
+        result = -1;
+    }
+
+    // Everything in the journal is now part of the snapshot.
+    if (!result && _journal_fd >= 0) {
+
+        if (ftruncate(_journal_fd, 0) < 0) {
+            PUSH_ERROR_SYSCALL("ftruncate");
+            result = -1;
+        } else {
+            _journal_size = 0;
+        }
+
+    } else if (!result) {
+        free(cfile);
+
+        if ((cfile = _get_cache_journal_location()) && truncate(cfile, 0) < 0 && errno != ENOENT) {
+            PUSH_ERROR_SYSCALL("truncate");
+            result = -1;
+        }
+
+    }
+
+    pthread_mutex_unlock(&_journal_lock);
+
+    for(size_t i = 1; i < nstores; i++) {
+        _unlock_cache_store(&(cached_stores[i]));
+    }
+
+    if (result < 0) {
+        unlink(tfile);
+    }
+
+    free(cfile);
+    free(tfile);
+
+    if (result < 0) {
+        RET_ERROR_INT(ERR_UNSPEC, "error serializing cached data to file");
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief   Flush the directory holding a cache file, so a file that was just renamed into place survives a crash.
+ * @param   path    a null-terminated string containing the full pathname of the cache file.
+ * @return  0 on success or -1 on failure.
+ */
+int _sync_cache_directory(const char *path) {
+
+    char *dir, *slash;
+    int dfd;
+
+    if (!path) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
+    }
+
+    if (!(dir = strdup(path))) {
+        PUSH_ERROR_SYSCALL("strdup");
+        RET_ERROR_INT(ERR_NOMEM, NULL);
+    }
+
+    // The cache location is always a full pathname, so the directory is everything before the last slash.
+    if ((slash = strrchr(dir, '/'))) {
+        *(slash == dir ? slash + 1 : slash) = 0;
+    }
+
+    if ((dfd = open(dir, O_RDONLY | O_DIRECTORY)) < 0) {
+        PUSH_ERROR_SYSCALL("open");
+        PUSH_ERROR_FMT(ERR_UNSPEC, "unable to open cache directory: %s", dir);
+        free(dir);
+        return -1;
+    }
+
+    free(dir);
+
+    if (fsync(dfd) < 0) {
+        PUSH_ERROR_SYSCALL("fsync");
+        close(dfd);
+        RET_ERROR_INT(ERR_UNSPEC, "unable to flush the cache directory");
+    }
+
+    close(dfd);
+
+    return 0;
+}
+
+
+/**
+ * @brief   Write a new snapshot of the cache if enough changes have accumulated in the journal.
+ * @note    Changes to the cache are journaled as they are made, so callers that used to save the entire cache after every
+ *              change should call this function instead.
+ * @return  0 on success or -1 on failure.
+ */
+int _checkpoint_cache_contents(void) {
+
+    size_t size;
+
+    pthread_mutex_lock(&_journal_lock);
+    size = _journal_size;
+    pthread_mutex_unlock(&_journal_lock);
+
+    if (size < CACHE_JOURNAL_LIMIT) {
+        return 0;
+    }
+
+    return _save_cache_contents();
+}
+
+
+/**
+ * @brief   Get the full pathname of the cache journal.
+ * @return  NULL on failure, or a null-terminated string containing the filename of the cache journal on success.
+ * @free_using{free}
+ */
+char *_get_cache_journal_location(void) {
+
+    char *cfile, *result = NULL;
+
+    if (!(cfile = _get_cache_location())) {
+        RET_ERROR_PTR(ERR_UNSPEC, "unable to determine cache file location");
+    }
+
+    if (!str_printf(&result, "%s%s", cfile, CACHE_JOURNAL_SUFFIX)) {
+        free(cfile);
+        RET_ERROR_PTR(ERR_NOMEM, "could not allocate space for cache journal filename");
+    }
+
+    free(cfile);
+
+    return result;
+}
+
+
+/**
+ * @brief   Write a single cached object to a cache file, in the same record format used by the snapshot and the journal.
+ * @note    The record is assembled in memory and written with a single call, so an append to the journal is never interleaved
+ *              with another. If the object hasn't been deserialized yet, its serialized data is copied straight from the snapshot.
+ * @param   fd      the file descriptor the record will be written to.
+ * @param   object  a pointer to the cached object to be written.
+ * @param   flags   if CACHE_JOURNAL_REMOVE, only the header is written, to record the removal of the object.
+ * @return  the number of bytes written on success, or -1 on failure.
+ */
+int _write_cache_record(int fd, const cached_object_t *object, uint32_t flags) {
+
+    cached_store_t *store;
+    unsigned char *record;
+    void *cdata = NULL;
+    size_t clen = 0, rlen;
+    uint32_t objlen;
+
+    if (fd < 0 || !object) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
+    }
+
+    if (!(store = _get_cached_store_by_type(object->dtype))) {
+        RET_ERROR_INT(ERR_UNSPEC, "could not look up cached object store by type");
+    }
+
+    if (flags & CACHE_JOURNAL_REMOVE) {
+        clen = 0;
+    } else if (object->snapshot) {
+        clen = object->imagelen;
+    } else if (!store->serialize || !(cdata = store->serialize(object->data, &clen))) {
+        RET_ERROR_INT(ERR_UNSPEC, "error serializing cached data for storage");
+    }
+
+    objlen = (CACHE_HEADER_SIZE + clen) | flags;
+    rlen = sizeof(objlen) + CACHE_HEADER_SIZE + clen;
+
+    if (!(record = malloc(rlen))) {
+        PUSH_ERROR_SYSCALL("malloc");
+        free(cdata);
+        RET_ERROR_INT(ERR_NOMEM, NULL);
+    }
+
+    memcpy(record, &objlen, sizeof(objlen));
+    memcpy(record + sizeof(objlen), object, CACHE_HEADER_SIZE);
+
+    if (clen) {
+        memcpy(record + sizeof(objlen) + CACHE_HEADER_SIZE, (cdata ? cdata : object->image), clen);
+    }
+
+    free(cdata);
+
+    if ((size_t)write(fd, record, rlen) != rlen) {
+        PUSH_ERROR_SYSCALL("write");
+        free(record);
+        RET_ERROR_INT(ERR_UNSPEC, "error writing cached data to file");
+    }
+
+    free(record);
+
+    return rlen;
+}
+
+
+/**
+ * @brief   Append the addition or removal of a persistent cached object to the cache journal.
+ * @note    The caller should hold the store lock exclusively, so the journal records changes to the same object in order.
+ *              A failure is reported, but doesn't affect the in-memory cache.
+ * @param   object  a pointer to the cached object that was added or removed.
+ * @param   removed if set, record the removal of the object rather than its addition.
+ * @return  0 on success or -1 on failure.
  */
-int _load_cache_contents(void) {
+int _journal_cached_object(const cached_object_t *object, int removed) {
 
-    cached_store_t *store;
-    cached_object_t *obj;
-    void *cdata = NULL, *udata, *reall_res = NULL;
-    char *cfile;
-    char ttlstr[64], *tstr, *expstr;
-    unsigned char *uptr;
-    time_t now;
-    size_t clen = 0, chdr_size = 0;
-    ssize_t nread;
-    int cfd, res;
-    uint32_t objlen;
+    struct stat sb;
+    char *jfile;
+    int written;
 
-    if (!(_cache_flags & CACHE_PERM_LOAD)) {
-        RET_ERROR_INT(ERR_PERM, NULL);
+    if (!object) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
     }
 
-    // Get the name of the cache file to be opened for writing. It should be reset to empty, or created if it does not yet exist.
-    if (!(cfile = _get_cache_location())) {
-        RET_ERROR_INT(ERR_UNSPEC, "unable to open object cache file for reading");
+    if (!(_cache_flags & CACHE_PERM_SAVE)) {
+        return 0;
     }
 
-    // TODO: Make this thread-safe using file locking.
-    if ((cfd = open(cfile, O_RDONLY)) < 0) {
+    pthread_mutex_lock(&_journal_lock);
 
-        _dbgprint(4, "Cache file was not found... creating.\n");
+    if (_journal_fd < 0) {
 
-        if ((cfd = creat(cfile, S_IRWXU)) < 0) {
-            PUSH_ERROR_SYSCALL("creat");
-            free(cfile);
-            RET_ERROR_INT(ERR_UNSPEC, "unable to create cache file");
+        if (!(jfile = _get_cache_journal_location())) {
+            pthread_mutex_unlock(&_journal_lock);
+            RET_ERROR_INT(ERR_UNSPEC, "unable to determine cache journal location");
         }
 
-        close(cfd);
-        free(cfile);
-        return 0;
-    }
-    free(cfile);
-
-    // The file consists of a sequence of object chunk lengths and data.
-    while (1) {
+        if ((_journal_fd = open(jfile, (O_CREAT | O_WRONLY | O_APPEND), (S_IRWXU))) < 0) {
+            PUSH_ERROR_SYSCALL("open");
+            PUSH_ERROR_FMT(ERR_UNSPEC, "unable to open cache journal for writing: %s", jfile);
+            pthread_mutex_unlock(&_journal_lock);
+            free(jfile);
+            return -1;
+        }
 
-        if ((nread = read(cfd, &objlen, sizeof(objlen))) != sizeof(objlen)) {
-            close(cfd);
+        free(jfile);
+        _journal_size = (fstat(_journal_fd, &sb) < 0) ? 0 : sb.st_size;
+    }
 
-            if (cdata) {
-                free(cdata);
-            }
+    if ((written = _write_cache_record(_journal_fd, object, (removed ? CACHE_JOURNAL_REMOVE : 0))) < 0) {
+        pthread_mutex_unlock(&_journal_lock);
+        RET_ERROR_INT(ERR_UNSPEC, "unable to append to the cache journal");
+    }
 
-            if (nread) {
+    _journal_size += written;
 
-                if (nread < 0) {
-                    PUSH_ERROR_SYSCALL("read");
-                }
+    pthread_mutex_unlock(&_journal_lock);
 
-                RET_ERROR_INT(ERR_UNSPEC, "reached unexpected end of cache data file");
-            }
+    return 0;
+}
 
-            // We can only reach this by reading in 0 bytes (EOF).
-            return 1;
-        }
 
-        // If the objlen we read is 0, we skip forward to read the next length. This helps avoid the NULL pointer dereferencing,
-        // which occurrs if cdata has not yet been allocated. Perhaps we should throw an error. TODO
-        if(!objlen) {
-            continue;
-        }
+/**
+ * @brief   Replay the changes recorded in the cache journal since the last snapshot was written.
+ * @note    A journal record supersedes any object with the same id. If the last record was only partially written when we
+ *              crashed, it's discarded, and the journal is truncated so later records are appended after the last good one.
+ * @return  the number of records replayed on success, or -1 on failure.
+ */
+int _replay_cache_journal(void) {
 
-        if (objlen > clen) {
-            clen = objlen;
+    cached_store_t *store;
+    cached_object_t *obj, *existing;
+    struct stat sb;
+    unsigned char *jdata;
+    char *jfile;
+    size_t offset = 0, objlen;
+    ssize_t nread;
+    uint32_t rlen;
+    int jfd, result = 0;
 
-            if (!(reall_res = realloc(cdata, clen))) {
-                PUSH_ERROR_SYSCALL("realloc");
+    if (!(jfile = _get_cache_journal_location())) {
+        RET_ERROR_INT(ERR_UNSPEC, "unable to determine cache journal location");
+    }
 
-                if(cdata) {
-                    free(cdata);
-                }
+    if ((jfd = open(jfile, O_RDWR)) < 0) {
+        free(jfile);
+        return 0;
+    }
 
-                close(cfd);
-                RET_ERROR_INT(ERR_NOMEM, NULL);
-            }
+    free(jfile);
 
-            cdata = reall_res;
-            reall_res = NULL;
-        }
+    if (fstat(jfd, &sb) < 0) {
+        PUSH_ERROR_SYSCALL("fstat");
+        close(jfd);
+        RET_ERROR_INT(ERR_UNSPEC, "unable to determine the size of the cache journal");
+    } else if (!sb.st_size) {
+        close(jfd);
+        return 0;
+    }
 
-        memset(cdata, 0, objlen);
+    if (!(jdata = malloc(sb.st_size))) {
+        PUSH_ERROR_SYSCALL("malloc");
+        close(jfd);
+        RET_ERROR_INT(ERR_NOMEM, NULL);
+    }
 
-        if (read(cfd, cdata, objlen) != objlen) {
-            free(cdata);
-            close(cfd);
-            RET_ERROR_INT(ERR_UNSPEC, "unable to read contents of object cache");
-        }
+    if ((nread = read(jfd, jdata, sb.st_size)) != sb.st_size) {
+        PUSH_ERROR_SYSCALL("read");
+        free(jdata);
+        close(jfd);
+        RET_ERROR_INT(ERR_UNSPEC, "unable to read contents of cache journal");
+    }
 
-        obj = (cached_object_t *)cdata;
+    while (offset + sizeof(rlen) <= (size_t)sb.st_size) {
 
-        // Make sure we're even able to handle this data type.
-        if (!(store = _get_cached_store_by_type(obj->dtype))) {
-            fprintf(stderr, "Error: read cached data of unrecognized type. Continuing...\n");
-            continue;
-        } else if (!store->deserialize) {
-            fprintf(stderr, "Error: cached object did not have a deserialization handler. Continuing...\n");
-            continue;
-        }
+        memcpy(&rlen, jdata + offset, sizeof(rlen));
+        objlen = rlen & ~CACHE_JOURNAL_REMOVE;
 
-        // The cached header on disk is equivalent to the cached object structure minus the last 3 fields (data and linked list pointers).
-        if (!chdr_size) {
-            chdr_size = (size_t)&(obj->data) - (size_t)obj;
+        // A torn record is the last thing written before a crash.
+        if (objlen < CACHE_HEADER_SIZE || objlen > (size_t)sb.st_size - offset - sizeof(rlen)) {
+            break;
         }
 
-        // We must have read in at least the size of a cached object structure.
-        if (objlen < chdr_size) {
-            fprintf(stderr, "Error reading in cached object data; unexpected small entry size.\n");
-            continue;
-        }
+        offset += sizeof(rlen);
 
-        // Create a new cached object and copy the header information in from the file.
         if (!(obj = malloc(sizeof(cached_object_t)))) {
             PUSH_ERROR_SYSCALL("malloc");
-            free(cdata);
-            close(cfd);
+            free(jdata);
+            close(jfd);
             RET_ERROR_INT(ERR_NOMEM, NULL);
         }
 
         memset(obj, 0, sizeof(cached_object_t));
-        memcpy(obj, cdata, chdr_size);
-
-        // Everything that was loaded from the cache is automatically persisted again.
+        memcpy(obj, jdata + offset, CACHE_HEADER_SIZE);
         obj->persists = 1;
+        obj->refs = 1;
 
-        // Finally, attach the store-specific data to the cached object.
-        if (objlen >= chdr_size) {
-            uptr = (unsigned char *)cdata;
-            uptr += chdr_size;
-
-            if (!(udata = store->deserialize(uptr, (objlen - chdr_size)))) {
-                fprintf(stderr, "Error: cached object could not be deserialized (continuing)...\n");
-                dump_error_stack();
-                _clear_error_stack();
-                free(obj);
-                continue;
-            }
-
-            obj->data = udata;
+        if (!(store = _get_cached_store_by_type(obj->dtype)) || !store->deserialize) {
+            fprintf(stderr, "Error: journaled cached object was of an unrecognized type. Continuing...\n");
+            free(obj);
+            offset += objlen;
+            continue;
         }
 
-        // TODO: This should leverage _dump_cache() functionality.
-        tstr = _get_chr_date(obj->timestamp, 1);
-        memset(ttlstr, 0, sizeof(ttlstr));
-
-        if (time(&now) == (time_t)-1) {
-            perror("time");
-            fprintf(stderr, "Error: Could not get current time for TTL calculation.\n");
-            snprintf(ttlstr, sizeof(ttlstr), "error [original = %lu]", (unsigned long)obj->ttl);
-        } else {
-
-            if ((time_t)(obj->timestamp + obj->ttl) > now) {
-                snprintf(ttlstr, sizeof(ttlstr), "%lu seconds", (unsigned long)(obj->timestamp + obj->ttl - now));
-            } else {
-                snprintf(ttlstr, sizeof(ttlstr), "expired %lu seconds ago", (unsigned long)(now - (obj->timestamp + obj->ttl)));
-            }
-
+        // Additions carry their data, and the journal is bounded in size, so they're deserialized right away.
+        if (!(rlen & CACHE_JOURNAL_REMOVE) && !(obj->data = store->deserialize(jdata + offset + CACHE_HEADER_SIZE, objlen - CACHE_HEADER_SIZE))) {
+            fprintf(stderr, "Error: journaled cached object could not be deserialized (continuing)...\n");
+            dump_error_stack();
+            _clear_error_stack();
+            free(obj);
+            offset += objlen;
+            continue;
         }
 
-        if (_verbose >= 5) {
-            expstr = obj->expiration ? _get_chr_date(obj->expiration, 1) : strdup("[none]");
-            fprintf(stderr, "+++ type = %u, ttl = %s, expiration = %s, data = %s, timestamp = %s\n",
-                    (unsigned int)obj->dtype, ttlstr, (expstr ? expstr : "[error]"), (obj->data ? "yes" : "no"), (tstr ? tstr : "[unknown timestamp]"));
-            _dump_cache_data(stderr, obj, 0);
+        offset += objlen;
 
-            if (expstr) {
-                free(expstr);
-            }
+        _lock_cache_store(store);
 
+        if ((existing = _lookup_cached_object(obj->id, store))) {
+            _unlink_object(existing, 1, 0);
         }
 
-        if (tstr) {
-            free(tstr);
+        if (rlen & CACHE_JOURNAL_REMOVE) {
+            _unlock_cache_store(store);
+            free(obj);
+        } else {
+            _link_object(store, obj);
+            _unlock_cache_store(store);
         }
 
-        // Finally store the object in the cache if it doesn't already exist.
-        if ((res = _cached_object_exists(obj->id, store))) {
-            fprintf(stderr, "Error: deserialized cached object was a duplicate:\n");
-            _dump_cache_data(stderr, obj, 0);
-            _destroy_cache_entry(obj);
-            continue;
-        } else if (res < 0) {
-            fprintf(stderr, "Error: could not look up object in cache.\n");
-            dump_error_stack();
-            _clear_error_stack();
-            _destroy_cache_entry(obj);
-            continue;
-        }
+        result++;
+    }
 
-        // TODO: The locking block of code needs to be expanded to include the existence check.
-        _lock_cache_store(store);
+    // Discard the partial record, if there was one.
+    if (offset != (size_t)sb.st_size) {
+        fprintf(stderr, "Error: discarding a partially written record at the end of the cache journal.\n");
 
-        // Insert into the head of the list.
-        obj->next = store->head;
-        store->head = obj;
+        if (ftruncate(jfd, offset) < 0) {
+            PUSH_ERROR_SYSCALL("ftruncate");
+            free(jdata);
+            close(jfd);
+            RET_ERROR_INT(ERR_UNSPEC, "unable to truncate the cache journal");
+        }
 
-        _unlock_cache_store(store);
     }
 
-    if (cdata) {
-        free(cdata);
-    }
+    _dbgprint(4, "Replayed %d cached object changes from the cache journal.\n", result);
 
-    close(cfd);
+    free(jdata);
+    close(jfd);
 
-    return 1;
+    return result;
 }
 
+
 /**
- * @brief   Persist the entire contents of the cache to local storage.
+ * @brief   Deserialize the data of a cached object which was loaded from the snapshot.
+ * @note    The caller must hold the store lock exclusively.
+ * @param   object  a pointer to the cached object to be deserialized.
  * @return  0 on success or -1 on failure.
  */
-int _save_cache_contents(void) {
+int _materialize_cached_object(cached_object_t *object) {
 
-    cached_object_t *ptr, *towrite;
-    void *cdata;
-    char *cfile;
-    size_t clen, chdr_size = 0;
-    int cfd;
-    uint32_t objlen;
+    cached_store_t *store;
+    void *data;
 
-    if (!(_cache_flags & CACHE_PERM_LOAD)) {
-        RET_ERROR_INT(ERR_PERM, NULL);
+    if (!object) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
     }
 
-    // Get the name of the cache file to be opened for writing. It should be reset to empty, or created if it does not yet exist.
-    if (!(cfile = _get_cache_location())) {
-        RET_ERROR_INT(ERR_UNSPEC, "unable to determine cache file location");
+    if (!object->snapshot) {
+        return 0;
     }
 
-    if ((cfd = open(cfile, (O_CREAT | O_TRUNC | O_WRONLY), (S_IRWXU))) < 0) {
-        PUSH_ERROR_SYSCALL("open");
-        PUSH_ERROR_FMT(ERR_UNSPEC, "unable to open object cache file for writing: %s", cfile);
-        free(cfile);
-        return -1;
+    if (!(store = _get_cached_store_by_type(object->dtype))) {
+        RET_ERROR_INT(ERR_UNSPEC, "could not look up cached object store by type");
     }
-    free(cfile);
 
-    for(size_t i = 1; i < sizeof(cached_stores) / sizeof(cached_store_t); i++) {
-        _dbgprint(4, "Persisting cache of type: %s ...\n", cached_stores[i].description);
+    if (!(data = store->deserialize(object->image, object->imagelen))) {
+        RET_ERROR_INT(ERR_UNSPEC, "cached object could not be deserialized");
+    }
 
-        _lock_cache_store(&(cached_stores[i]));
+    object->data = data;
+    _release_cache_snapshot(object->snapshot);
+    object->snapshot = NULL;
+    object->image = NULL;
+    object->imagelen = 0;
 
-        ptr = cached_stores[i].head;
+    // Only linked objects are ever deserialized, and they're all counted.
+    store->pending--;
 
-        while (ptr) {
-            // If we're shadowing a cached object, then the shadowed entry is the one that needs to be persisted.
-            towrite = ptr->shadow ? ptr->shadow : ptr;
+    return 0;
+}
 
-            // Only bother with the entries that need to be saved.
-            if (!towrite->persists) {
-                ptr = ptr->next;
-                continue;
-            }
 
-            // The cached header on disk is equivalent to the cached object structure minus the last 3 fields (data and linked list pointers).
-            if (!chdr_size) {
-                chdr_size = (size_t)&(ptr->data) - (size_t)ptr;
-            }
+/**
+ * @brief   Deserialize every object in a cached store which is still waiting to be loaded from the snapshot.
+ * @note    The caller must hold the store lock exclusively. This is needed before a custom comparator can be run over the
+ *              store, since comparators inspect the object data. Objects that can't be deserialized are evicted.
+ * @param   store   a pointer to the cached store to be deserialized.
+ */
+void _materialize_cached_store(cached_store_t *store) {
 
-            if (cached_stores[i].serialize) {
+    cached_object_t *ptr;
 
-                if (!(cdata = cached_stores[i].serialize(towrite->data, &clen))) {
-                    fprintf(stderr, "Error serializing cached data for storage:\n");
-                    dump_error_stack();
-                    _clear_error_stack();
-                } else {
-                    objlen = chdr_size + clen;
-
-                    if ((size_t)write(cfd, &objlen, sizeof(objlen)) != sizeof(objlen)
-                        || (size_t)write(cfd, towrite, chdr_size) != chdr_size
-                        || (size_t)write(cfd, cdata, clen) != clen) {
-                        PUSH_ERROR_SYSCALL("write");
-                        _unlock_cache_store(&(cached_stores[i]));
-                        free(cdata);
-                        close(cfd);
-                        RET_ERROR_INT(ERR_UNSPEC, "error serializing cached data to file");
-                    }
-
-                    free(cdata);
-                }
+    if (!store || !store->pending) {
+        return;
+    }
 
-            }
+    ptr = store->head;
 
-            ptr = ptr->next;
+    while (ptr) {
+
+        if (ptr->snapshot && _materialize_cached_object(ptr) < 0) {
+            fprintf(stderr, "Error: cached object could not be deserialized (evicting)...\n");
+            dump_error_stack();
+            _clear_error_stack();
+            ptr = _unlink_object(ptr, 1, 0);
+            continue;
         }
 
-        _unlock_cache_store(&(cached_stores[i]));
+        ptr = ptr->next;
     }
 
-    close(cfd);
+}
+
+
+/**
+ * @brief   Release a reference to a cache snapshot mapping, and unmap it once the last reference is gone.
+ * @param   snapshot    a pointer to the cache snapshot to be released.
+ */
+void _release_cache_snapshot(cache_snapshot_t *snapshot) {
+
+    if (!snapshot) {
+        return;
+    }
+
+    if (!__sync_sub_and_fetch(&(snapshot->refs), 1)) {
+
+        if (munmap(snapshot->map, snapshot->length) < 0) {
+            perror("munmap");
+        }
+
+        free(snapshot);
+    }
 
-    return 0;
 }
 
 
@@ -2131,18 +2674,18 @@ int _is_object_expired(cached_object_t *obj, int *refresh) {
 
 
 /**
- * @brief   Unlink a cached object from its doubly linked list.
+ * @brief   Unlink a cached object from its doubly linked list, and from its store's hash index.
+ * @note    The caller must hold the store lock exclusively.
  * @param   object      a pointer to the cached object to be delinked.
- * @param   destroy     if set, deallocate the specified cached object after unlinking.
+ * @param   destroy     if set, release the store's reference to the cached object after unlinking.
  * @param   stale       if set, the cache removal was performed because of a stale entry.
  * @return  a pointer to the next cached object in the store, or NULL if at the end of the store.
  */
 cached_object_t *_unlink_object(cached_object_t *object, int destroy, int stale) {
 
     cached_store_t *store;
-    cached_object_t *next = NULL;
+    cached_object_t *next = NULL, **link;
 
-    // TODO: check the callers of this function and make sure they're operating in a thread-safe fashion.
     if (!object) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
     }
@@ -2165,6 +2708,22 @@ cached_object_t *_unlink_object(cached_object_t *object, int destroy, int stale)
         next = object->next;
     }
 
+    link = &(store->buckets[CACHE_BUCKET(object->id)]);
+
+    while (*link && *link != object) {
+        link = &((*link)->chain);
+    }
+
+    if (*link) {
+        *link = object->chain;
+    }
+
+    object->prev = object->next = object->chain = NULL;
+
+    if (object->snapshot) {
+        store->pending--;
+    }
+
     if (stale && (_verbose >= 4) && store) {
 
         if (store->dump) {
@@ -2176,20 +2735,9 @@ cached_object_t *_unlink_object(cached_object_t *object, int destroy, int stale)
 
     }
 
+    // Any readers still holding a reference will free the object when they release it.
     if (destroy) {
-
-        if (store->destructor) {
-            store->destructor(object->data);
-
-            if (get_last_error()) {
-                fprintf(stderr, "Cache destructor generated error(s):\n");
-                dump_error_stack();
-                _clear_error_stack();
-            }
-
-        }
-
-        free(object);
+        _release_cached_object(object);
     }
 
     return next;
@@ -2198,7 +2746,8 @@ cached_object_t *_unlink_object(cached_object_t *object, int destroy, int stale)
 
 /**
  * @brief   Replace one object in the cache with another.
- * @note    If shadow is not set, then the old cached object will be automatically destroyed.
+ * @note    The caller must hold the store lock exclusively. If shadow is not set, then the store's reference to the old
+ *              cached object will be released.
  *              Otherwise this function also makes the old cached object the new cached object's "shadow" data.
  * @param   oobj    a pointer to the old cached object to be replaced in its cached store with the new object.
  * @param   nobj    a pointer to the new cached object that will replace the old object in the cached store.
@@ -2208,8 +2757,8 @@ cached_object_t *_unlink_object(cached_object_t *object, int destroy, int stale)
 cached_object_t *_replace_object(cached_object_t *oobj, cached_object_t *nobj, int shadow) {
 
     cached_store_t *store;
+    cached_object_t **link;
 
-    // TODO: check the callers of this function and make sure they're operating in a thread-safe fashion.
     if (!oobj || !nobj) {
         RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
     }
@@ -2238,16 +2787,37 @@ cached_object_t *_replace_object(cached_object_t *oobj, cached_object_t *nobj, i
         oobj->next->prev = nobj;
     }
 
-    // Finally, the two must have matching ids.
+    // Finally, the two must have matching ids, which means they also share a hash bucket.
     memcpy(nobj->id, oobj->id, SHA_256_SIZE);
 
-    oobj->prev = oobj->next = NULL;
+    link = &(store->buckets[CACHE_BUCKET(oobj->id)]);
+
+    while (*link && *link != oobj) {
+        link = &((*link)->chain);
+    }
+
+    if (*link) {
+        *link = nobj;
+    }
+
+    nobj->chain = oobj->chain;
+    oobj->prev = oobj->next = oobj->chain = NULL;
+
+    if (oobj->snapshot) {
+        store->pending--;
+    }
+
+    if (nobj->persists && _journal_cached_object(nobj, 0) < 0) {
+        fprintf(stderr, "Error: unable to journal replacement cached object:\n");
+        dump_error_stack();
+        _clear_error_stack();
+    }
 
     if (shadow) {
         nobj->shadow = oobj;
     } else {
         nobj->shadow = NULL;
-        _destroy_cache_entry(oobj);
+        _release_cached_object(oobj);
     }
 
     return nobj;
@@ -2255,13 +2825,26 @@ cached_object_t *_replace_object(cached_object_t *oobj, cached_object_t *nobj, i
 
 
 /**
- * @brief   Lock a cached store for thread-safe processing.
+ * @brief   Lock a cached store exclusively, for callers that will modify the store or its objects.
  * @param   store   a pointer to the cached store to be locked.
  */
 void _lock_cache_store(cached_store_t *store) {
 
-    if (pthread_mutex_lock(&(store->lock))) {
-        perror("pthread_mutex_lock");
+    if (pthread_rwlock_wrlock(&(store->lock))) {
+        perror("pthread_rwlock_wrlock");
+    }
+
+}
+
+
+/**
+ * @brief   Lock a cached store for reading, which can be done by any number of callers at once.
+ * @param   store   a pointer to the cached store to be locked.
+ */
+void _read_lock_cache_store(cached_store_t *store) {
+
+    if (pthread_rwlock_rdlock(&(store->lock))) {
+        perror("pthread_rwlock_rdlock");
     }
 
 }
@@ -2273,8 +2856,8 @@ void _lock_cache_store(cached_store_t *store) {
  */
 void _unlock_cache_store(cached_store_t *store) {
 
-    if (pthread_mutex_unlock(&(store->lock))) {
-        perror("pthread_mutex_unlock");
+    if (pthread_rwlock_unlock(&(store->lock))) {
+        perror("pthread_rwlock_unlock");
     }
 
 }
@@ -2282,6 +2865,7 @@ void _unlock_cache_store(cached_store_t *store) {
 
 /**
  * @brief  Evict an item from the object cache if it is stale (has expired).
+ * @note   The caller must hold the store lock exclusively.
  * @return 1 if the object was evicted for being stale or 0 if it was not.
  */
 unsigned int _evict_if_stale(cached_object_t **objptr) {
@@ -2310,6 +2894,63 @@ unsigned int _evict_if_stale(cached_object_t **objptr) {
 }
 
 
+/**
+ * @brief   Evict every stale object from a cached store.
+ * @note    Lookups skip over stale objects without removing them, so they only need to share the store lock. The writers
+ *              call this function every CACHE_SWEEP_INTERVAL seconds, and long running callers can use _prune_cache_stores().
+ * @param   store   a pointer to the cached store to be swept.
+ * @return  the number of objects evicted from the store.
+ */
+int _evict_stale_objects(cached_store_t *store) {
+
+    cached_object_t *ptr;
+    int result = 0;
+    time_t now;
+
+    if (!store) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
+    }
+
+    _lock_cache_store(store);
+
+    if (time(&now) != (time_t)-1) {
+        store->swept = now;
+    }
+
+    ptr = store->head;
+
+    while (ptr) {
+
+        if (_evict_if_stale(&ptr)) {
+            result++;
+            continue;
+        }
+
+        ptr = ptr->next;
+    }
+
+    _unlock_cache_store(store);
+
+    return result;
+}
+
+
+/**
+ * @brief   Evict the stale objects from every cached store.
+ * @return  the total number of objects evicted from the cache.
+ */
+int _prune_cache_stores(void) {
+
+    int result = 0;
+
+    for(size_t i = 1; i < sizeof(cached_stores) / sizeof(cached_store_t); i++) {
+        result += _evict_stale_objects(&(cached_stores[i]));
+    }
+
+    return result;
+}
+
+
 /* Signet callback functions */
 
 /**
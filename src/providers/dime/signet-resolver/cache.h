@@ -2,6 +2,8 @@
 #define CACHE_H
 
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -21,6 +23,16 @@
 #define CACHE_PERM_ALL_FLAGS (CACHE_PERM_LOAD | CACHE_PERM_SAVE | CACHE_PERM_READ | CACHE_PERM_ADD | CACHE_PERM_DELETE)
 #define CACHE_PERM_DEFAULT   CACHE_PERM_ALL_FLAGS
 
+#define CACHE_STORE_BUCKETS  1024           ///< The number of hash buckets used to index each cached store by object id.
+#define CACHE_SWEEP_INTERVAL 60             ///< The minimum number of seconds between stale object sweeps of a cached store.
+
+#define CACHE_JOURNAL_SUFFIX ".journal"     ///< Appended to the cache filename to get the name of the cache journal.
+#define CACHE_JOURNAL_LIMIT  1048576        ///< The journal size, in bytes, at which a checkpoint writes a new snapshot.
+#define CACHE_JOURNAL_REMOVE 0x80000000     ///< Set in the length of a journal record to mark the removal of an object.
+
+// The ids are SHA-256 hashes, so their leading bytes are already uniformly distributed.
+#define CACHE_BUCKET(hashid) (((((unsigned int)(hashid)[0]) << 8) | (hashid)[1]) % CACHE_STORE_BUCKETS)
+
 
 typedef enum {
     cached_data_unknown = 0,
@@ -31,6 +43,12 @@ typedef enum {
     cached_data_signet = 5
 } cached_data_type_t;
 
+typedef struct {
+    unsigned char *map;                     ///< The memory mapped snapshot of the cache file.
+    size_t length;                          ///< The length of the mapping.
+    unsigned int refs;                      ///< The number of cached objects still waiting to be deserialized from the mapping.
+} cache_snapshot_t;
+
 typedef struct cached_object {
     time_t timestamp;                       ///< The UTC timestamp for when this object was cached. Used with ttl.
     unsigned char id[32];                   ///< The identifier of the cached item as a SHA-256 hash.
@@ -44,8 +62,17 @@ typedef struct cached_object {
     unsigned char persists;                 ///< Not everything in the cache should be persisted.
     struct cached_object *shadow;           ///< A saved copy of the "real" cache entry to be saved, if this cached
                                             ///< object is merely temporarily overriding it.
+    struct cached_object *chain;            ///< A pointer to the next cached object in the same hash bucket.
+    unsigned int refs;                      ///< The number of references held by readers, plus one held by the store
+                                            ///< while the object is linked into it. The object is freed at zero.
+    cache_snapshot_t *snapshot;             ///< If set, the data hasn't been deserialized from the snapshot yet.
+    unsigned char *image;                   ///< The serialized data inside the snapshot mapping.
+    size_t imagelen;                        ///< The length of the serialized data.
 } cached_object_t;
 
+// The header of each record in the cache file is the cached object structure, up to the data pointer.
+#define CACHE_HEADER_SIZE offsetof(cached_object_t, data)
+
 
 typedef struct {
     cached_data_type_t dtype;               ///< The type of data that will be stored within.
@@ -53,7 +80,7 @@ typedef struct {
     unsigned char internal;                 ///< Determines whether the cached store is for internal use only.
                                             ///< If it is, objects will not be cloned before being returned to the caller.
     cached_object_t *head;                  ///< A pointer to the head of the cached object list.
-    pthread_mutex_t lock;                   ///< For multi-threaded safe code.
+    pthread_rwlock_t lock;                  ///< Lookups share the lock; anything that modifies the store holds it exclusively.
     void (*destructor)(void *);             ///< A function pointer to a destructor used to free cached object data.
     void * (*serialize)(void *, size_t *);  ///< A function pointer to a routine used to serialize cached data.
     void * (*deserialize)(void *, size_t);  ///< A function pointer to a routine used to deserialize cached data.
@@ -61,6 +88,9 @@ typedef struct {
     void * (*clone)(void *);                ///< An optional pointer to a routine that can be used to clone data.
                                             ///<    If not specified, the serialize and deserialize routine will be used
                                             ///<    together to recreate the functionality of this function.
+    time_t swept;                           ///< The last time stale objects were evicted from the store.
+    size_t pending;                         ///< The number of linked objects still waiting to be deserialized.
+    cached_object_t *buckets[CACHE_STORE_BUCKETS]; ///< The cached objects, indexed by the leading bytes of their hashed ids.
 } cached_store_t;
 
 
@@ -79,6 +109,7 @@ extern cached_store_t cached_stores[];
 // Cache loading and saving.
 PUBLIC_FUNC_DECL(int,               load_cache_contents,          void);
 PUBLIC_FUNC_DECL(int,               save_cache_contents,          void);
+PUBLIC_FUNC_DECL(int,               checkpoint_cache_contents,    void);
 PUBLIC_FUNC_DECL(char *,            get_dime_dir_location,        const char *suffix);
 PUBLIC_FUNC_DECL(char *,            get_cache_location,           void);
 PUBLIC_FUNC_DECL(int,               set_cache_location,           const char *path);
@@ -100,6 +131,7 @@ PUBLIC_FUNC_DECL(cached_object_t *, add_cached_object_cmp_forced, const char *id
 PUBLIC_FUNC_DECL(int,               remove_cached_object,         const char *oid, cached_store_t *store);
 PUBLIC_FUNC_DECL(int,               remove_cached_object_cmp,     const void *key, cached_store_t *store, cached_store_comparator_t cmpfn);
 PUBLIC_FUNC_DECL(void,              destroy_cache_entry,          cached_object_t *entry);
+PUBLIC_FUNC_DECL(int,               prune_cache_stores,           void);
 
 // Other.
 PUBLIC_FUNC_DECL(void *,            get_cache_obj_data,           cached_object_t *object);
@@ -114,6 +146,21 @@ void              _dump_cache(cached_data_type_t dtype, int do_data, int ephemer
 void              _dump_cache_data(FILE *fp, const cached_object_t *obj, int brief);
 cached_object_t * _clone_cached_object(const cached_object_t *obj);
 
+// Shared, reference counted access to cached objects.
+cached_object_t * _acquire_cached_object(const char *oid, cached_store_t *store);
+cached_object_t * _acquire_cached_object_cmp(const void *key, cached_store_t *store, cached_store_comparator_t cmpfn);
+void              _release_cached_object(cached_object_t *object);
+
+// Lazy loading of the cache snapshot, and journaling of the changes made since it was written.
+int               _materialize_cached_object(cached_object_t *object);
+void              _materialize_cached_store(cached_store_t *store);
+void              _release_cache_snapshot(cache_snapshot_t *snapshot);
+int               _write_cache_record(int fd, const cached_object_t *object, uint32_t flags);
+int               _journal_cached_object(const cached_object_t *object, int removed);
+int               _replay_cache_journal(void);
+char *            _get_cache_journal_location(void);
+int               _sync_cache_directory(const char *path);
+
 // Helper functions for writing object data to the persistent cache.
 size_t            _mem_append_serialized(unsigned char **buf, size_t *blen, const unsigned char *data, size_t dlen);
 size_t            _mem_append_serialized_string(unsigned char **buf, size_t *blen, const char *string);
@@ -134,9 +181,16 @@ int               _is_object_expired(cached_object_t *obj, int *refresh);
 cached_object_t * _unlink_object(cached_object_t *object, int destroy, int stale);
 cached_object_t * _replace_object(cached_object_t *oobj, cached_object_t *nobj, int shadow);
 unsigned int      _evict_if_stale(cached_object_t **objptr);
+int               _evict_stale_objects(cached_store_t *store);
+int               _prune_cache_stores(void);
+
+// Maintenance of the cached store hash index.
+cached_object_t * _lookup_cached_object(const unsigned char *hashid, cached_store_t *store);
+void              _link_object(cached_store_t *store, cached_object_t *object);
 
 // Synchronization of the cache stores.
 void              _lock_cache_store(cached_store_t *store);
+void              _read_lock_cache_store(cached_store_t *store);
 void              _unlock_cache_store(cached_store_t *store);
 
 
@@ -57,6 +57,10 @@ int save_cache_contents(void) {
     PUBLIC_FUNC_IMPL(save_cache_contents, );
 }
 
+int checkpoint_cache_contents(void) {
+    PUBLIC_FUNC_IMPL(checkpoint_cache_contents, );
+}
+
 char *get_dime_dir_location(const char *suffix) {
     PUBLIC_FUNC_IMPL(get_dime_dir_location, suffix);
 }
@@ -72,3 +76,7 @@ int set_cache_location(const char *path) {
 int set_cache_permissions(unsigned long flags) {
     PUBLIC_FUNC_IMPL(set_cache_permissions, flags);
 }
+
+int prune_cache_stores(void) {
+    PUBLIC_FUNC_IMPL(prune_cache_stores, );
+}
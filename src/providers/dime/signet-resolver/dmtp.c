@@ -134,7 +134,7 @@ signet_t *_get_signet(const char *name, const char *fingerprint, int use_cache)
             return result;
         }
 
-        if (_save_cache_contents() < 0) {
+        if (_checkpoint_cache_contents() < 0) {
             fprintf(stderr, "Error: could not save cache contents.\n");
             dump_error_stack();
             _clear_error_stack();
@@ -10,6 +10,20 @@
 
 static int _dns_initialized = 0;
 
+static pthread_mutex_t _dns_queries_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _dns_queries_cond = PTHREAD_COND_INITIALIZER;
+static dns_query_t *_dns_queries = NULL;
+static pthread_cond_t _dns_pending_cond = PTHREAD_COND_INITIALIZER;
+static dns_query_t *_dns_pending = NULL, *_dns_pending_tail = NULL;
+static unsigned int _dns_pending_count = 0, _dns_workers = 0, _dns_workers_idle = 0;
+static struct sockaddr_in _dns_nameserver;
+static int _dns_nameserver_set = 0;
+static unsigned int _dns_nameserver_generation = 1;
+
+static pthread_key_t _dns_state_key;
+static pthread_once_t _dns_state_once = PTHREAD_ONCE_INIT;
+static int _dns_state_key_created = 0;
+
 
 /**
  * @brief   Append a DNS label in uncompressed, canonical format to a dynamic buffer.
@@ -570,7 +584,7 @@ int _load_dnskey_file(const char *filename) {
     memset(&cmp, 0, sizeof(cmp));
     cmp.label = (char *)".";
 
-    if (!_find_cached_object_cmp(&cmp, &(cached_stores[cached_data_dnskey]), &_dnskey_domain_comparator)) {
+    if (_cached_object_exists_cmp(&cmp, &(cached_stores[cached_data_dnskey]), &_dnskey_domain_comparator) <= 0) {
         RET_ERROR_INT(ERR_UNSPEC, "config file did not contain any root DNSKEY entries");
     }
 
@@ -858,14 +872,16 @@ ds_t *_add_ds_entry(const char *label, unsigned int keytag, unsigned char algori
 
 
 /**
- * @brief   Find a DNSKEY entry by its keytag value.
+ * @brief   Acquire a reference to a DNSKEY entry by its keytag value.
+ * @note    The DNSKEY store is internal, so the entry is shared with the cache. The caller must release it using
+ *              _release_cached_object() once it's finished with the DNSKEY record.
  * @param   tag     the semi-unique keytag value identifying the target DNSKEY entry.
  * @param   signer      a null-terminated string containing the name of the signing domain that owns the DNSKEY entry.
  * @param   force_lookup    if set, perform a live-lookup of any DNSKEY entry that could not be located by keytag;
  *                              otherwise, lookups will be restricted only to the object cache.
- * @return  a pointer to the specified DNSKEY record if it was found, or NULL on error or if it wasn't.
+ * @return  a pointer to the cached object holding the DNSKEY record if it was found, or NULL on error or if it wasn't.
  */
-dnskey_t *_get_dnskey_by_tag(unsigned int tag, const char *signer, int force_lookup) {
+cached_object_t *_acquire_dnskey_by_tag(unsigned int tag, const char *signer, int force_lookup) {
 
     dnskey_t cmp;
     cached_object_t *obj;
@@ -878,8 +894,8 @@ dnskey_t *_get_dnskey_by_tag(unsigned int tag, const char *signer, int force_loo
     cmp.label = (char *)signer; /* won't be deallocated */
     cmp.keytag = tag;
 
-    if ((obj = _find_cached_object_cmp(&cmp, &(cached_stores[cached_data_dnskey]), &_dnskey_tag_comparator))) {
-        return ((dnskey_t *)_get_cache_obj_data(obj));
+    if ((obj = _acquire_cached_object_cmp(&cmp, &(cached_stores[cached_data_dnskey]), &_dnskey_tag_comparator))) {
+        return obj;
     } else {
         _clear_error_stack();
     }
@@ -890,12 +906,13 @@ dnskey_t *_get_dnskey_by_tag(unsigned int tag, const char *signer, int force_loo
             _dbgprint(2, "Stopped lookup chain; hit root.\n");
         } else {
             _dbgprint(1, "Could not find key for signer [%s]... looking it up.\n", signer);
+            _prefetch_dns_chain(signer, 0);
             _lookup_dnskey(signer);
             _lookup_ds(signer);
             // Preemptive cleanup in case the error stack is set by _lookup_dnskey() or _lookup_ds().
             _clear_error_stack();
             _dbgprint(2, "Returned from forced lookup.\n");
-            return _get_dnskey_by_tag(tag, signer, 0);
+            return _acquire_dnskey_by_tag(tag, signer, 0);
         }
 
     }
@@ -905,11 +922,12 @@ dnskey_t *_get_dnskey_by_tag(unsigned int tag, const char *signer, int force_loo
 
 
 /**
- * @brief   Look up a DS record by its matching DNSKEY record.
+ * @brief   Acquire a reference to a DS record by its matching DNSKEY record.
+ * @note    The caller must release the returned object using _release_cached_object().
  * @param   key a pointer to the DNSKEY record that will be used to find the matching DS record.
- * @return  a pointer to the matching DS record on success or NULL on failure.
+ * @return  a pointer to the cached object holding the matching DS record on success or NULL on failure.
  */
-ds_t *_get_ds_by_dnskey(const dnskey_t *key) {
+cached_object_t *_acquire_ds_by_dnskey(const dnskey_t *key) {
 
     ds_t cmp;
     cached_object_t *obj;
@@ -942,8 +960,8 @@ ds_t *_get_ds_by_dnskey(const dnskey_t *key) {
         RET_ERROR_PTR(ERR_UNSPEC, "unable to compute SHA hash of DNSKEY");
     }
 
-    if ((obj = _find_cached_object_cmp(&cmp, &(cached_stores[cached_data_ds]), &_ds_comparator))) {
-        return ((ds_t *)_get_cache_obj_data(obj));
+    if ((obj = _acquire_cached_object_cmp(&cmp, &(cached_stores[cached_data_ds]), &_ds_comparator))) {
+        return obj;
     } else {
         _clear_error_stack();
     }
@@ -1199,12 +1217,14 @@ dnskey_t *_add_dnskey_entry(const char *label, const unsigned char *buf, size_t
 /**
  * @brief   Verify the signature provided by an RRSIG record.
  * @see     rsa_verify_record()
+ * @param   outkey  if not NULL, receives a reference to the cached object holding the signing DNSKEY, whenever the key is
+ *                      found, which the caller must release using _release_cached_object().
  * @return  1 if the RRSIG signature was correct for the RR data, 0 if it was not, or -1 on general error.
  */
-int _validate_rrsig_rr(const char *label, ns_msg *dhandle, unsigned short covered, const unsigned char *rdata, size_t rdlen, dnskey_t **outkey) {
+int _validate_rrsig_rr(const char *label, ns_msg *dhandle, unsigned short covered, const unsigned char *rdata, size_t rdlen, cached_object_t **outkey) {
 
     rrsig_rr_t *rrsig;
-    dnskey_t *signing_key;
+    cached_object_t *signing_obj;
     const unsigned char *strptr = rdata;
     char nbuf[MAXDNAME];
     char *inception_timestr, *expiration_timestr, *now_timestr;
@@ -1275,15 +1295,20 @@ int _validate_rrsig_rr(const char *label, ns_msg *dhandle, unsigned short covere
         _dump_buf_outer((unsigned char *)strptr, rdleft, 5, 1);
     }
 
-    if (!(signing_key = _get_dnskey_by_tag(ntohs(rrsig->key_tag), nbuf, 1))) {
+    if (!(signing_obj = _acquire_dnskey_by_tag(ntohs(rrsig->key_tag), nbuf, 1))) {
         RET_ERROR_INT_FMT(ERR_UNSPEC, "could not locate signing key %u for signing name: %s", ntohs(rrsig->key_tag), &(rrsig->signame));
     }
 
+    result = _rsa_verify_record(label, rrsig->algorithm, ((dnskey_t *)_get_cache_obj_data(signing_obj))->pubkey, rdata, strptr, rdleft, dhandle);
+
+    // The caller takes over our reference to the signing key, if it asked for it.
     if (outkey) {
-        *outkey = signing_key;
+        *outkey = signing_obj;
+    } else {
+        _release_cached_object(signing_obj);
     }
 
-    if ((result = _rsa_verify_record(label, rrsig->algorithm, signing_key->pubkey, rdata, strptr, rdleft, dhandle)) < 0) {
+    if (result < 0) {
         RET_ERROR_INT(ERR_UNSPEC, NULL);
     }
 
@@ -1305,18 +1330,573 @@ void _dump_dns_header(ns_msg *handle) {
 }
 
 
+/**
+ * @brief   Direct every upstream query to a specific name server, instead of those listed in the system resolver configuration.
+ * @note    Each thread's resolver state is reinitialized with the new configuration before it sends its next query.
+ * @param   addr    a pointer to the address of the name server to be queried, or NULL to restore the system configuration.
+ */
+void _set_resolver_nameserver(const struct sockaddr_in *addr) {
+
+    pthread_mutex_lock(&_dns_queries_lock);
+
+    if (addr) {
+        memcpy(&_dns_nameserver, addr, sizeof(_dns_nameserver));
+        _dns_nameserver_set = 1;
+    } else {
+        memset(&_dns_nameserver, 0, sizeof(_dns_nameserver));
+        _dns_nameserver_set = 0;
+    }
+
+    _dns_nameserver_generation++;
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+}
+
+
+/**
+ * @brief   Release the resolver state of a thread that is exiting.
+ * @param   state   a pointer to the thread's resolver state.
+ */
+void _destroy_resolver_state(void *state) {
+
+    dns_state_t *dstate = (dns_state_t *)state;
+
+    if (!dstate) {
+        return;
+    }
+
+    if (dstate->generation) {
+        res_nclose(&(dstate->state));
+    }
+
+    memset(dstate, 0, sizeof(dns_state_t));
+    free(dstate);
+
+}
+
+
+/**
+ * @brief   Create the key used to store the resolver state of each thread.
+ */
+static void _create_resolver_state_key(void) {
+
+    _dns_state_key_created = !pthread_key_create(&_dns_state_key, &_destroy_resolver_state);
+
+}
+
+
+/**
+ * @brief   Get the resolver state of the calling thread, which is initialized with res_ninit() the first time it is used.
+ * @note    The state is only reinitialized if the name server configuration has changed since it was last used, so threads
+ *              never share resolver sockets, and never pay for res_ninit() on every query.
+ * @return  a pointer to the calling thread's resolver state on success, or NULL on failure.
+ */
+res_state _get_resolver_state(void) {
+
+    dns_state_t *dstate;
+    struct sockaddr_in nameserver;
+    unsigned int generation;
+    int nameserver_set;
+
+    if (pthread_once(&_dns_state_once, &_create_resolver_state_key) || !_dns_state_key_created) {
+        RET_ERROR_PTR(ERR_UNSPEC, "unable to create resolver state key");
+    }
+
+    if (!(dstate = pthread_getspecific(_dns_state_key))) {
+
+        if (!(dstate = malloc(sizeof(dns_state_t)))) {
+            PUSH_ERROR_SYSCALL("malloc");
+            RET_ERROR_PTR(ERR_NOMEM, "could not allocate space for resolver state");
+        }
+
+        memset(dstate, 0, sizeof(dns_state_t));
+
+        if (pthread_setspecific(_dns_state_key, dstate)) {
+            free(dstate);
+            RET_ERROR_PTR(ERR_UNSPEC, "unable to store resolver state");
+        }
+
+    }
+
+    pthread_mutex_lock(&_dns_queries_lock);
+    generation = _dns_nameserver_generation;
+    nameserver_set = _dns_nameserver_set;
+    memcpy(&nameserver, &_dns_nameserver, sizeof(nameserver));
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+    if (dstate->generation == generation) {
+        return &(dstate->state);
+    }
+
+    if (dstate->generation) {
+        res_nclose(&(dstate->state));
+        dstate->generation = 0;
+    }
+
+    memset(&(dstate->state), 0, sizeof(dstate->state));
+
+    if (res_ninit(&(dstate->state)) < 0) {
+        RET_ERROR_PTR(ERR_UNSPEC, "unexpected error occurred in res_ninit()");
+    }
+
+    dstate->state.options |= RES_USE_DNSSEC;
+
+    if (nameserver_set) {
+        dstate->state.nsaddr_list[0] = nameserver;
+        dstate->state.nscount = 1;
+    }
+
+    dstate->generation = generation;
+
+    return &(dstate->state);
+}
+
+
+/**
+ * @brief   Find the in-flight (or recently completed) query for a label and record type, or register a new one.
+ * @note    If a new query is registered, the caller becomes its owner, and must resolve it with _resolve_dns_query(), since any
+ *              other thread asking the same question will wait on it. In either case the query must be released afterwards.
+ * @param   label   a null-terminated string containing the name to be queried.
+ * @param   type    the numerical type of the resource records being requested.
+ * @param   owner   a pointer to a value that will be set to 1 if the caller is the owner of a new query, or 0 otherwise.
+ * @return  a pointer to the matching query on success, or NULL on failure.
+ */
+dns_query_t *_claim_dns_query(const char *label, int type, int *owner) {
+
+    dns_query_t *query, **qptr, *expired, *stale = NULL;
+    time_t now;
+
+    if (!label || !owner) {
+        RET_ERROR_PTR(ERR_BAD_PARAM, NULL);
+    }
+
+    if (time(&now) == ((time_t)-1)) {
+        PUSH_ERROR_SYSCALL("time");
+        RET_ERROR_PTR(ERR_UNSPEC, "unable to get current time");
+    }
+
+    *owner = 0;
+    pthread_mutex_lock(&_dns_queries_lock);
+
+    for (qptr = &_dns_queries; (query = *qptr);) {
+
+        // Completed answers are only held briefly, so the expired ones are dropped as the table is searched.
+        if (query->done && query->expires <= now) {
+            *qptr = query->next;
+
+            if (!--query->refs) {
+                query->next = stale;
+                stale = query;
+            }
+
+            continue;
+        }
+
+        if (query->type == type && !strcasecmp(query->label, label)) {
+            query->refs++;
+            break;
+        }
+
+        qptr = &(query->next);
+    }
+
+    if (!query) {
+
+        if (!(query = malloc(sizeof(dns_query_t)))) {
+            PUSH_ERROR_SYSCALL("malloc");
+        } else {
+            memset(query, 0, sizeof(dns_query_t));
+
+            if (!(query->label = strdup(label))) {
+                PUSH_ERROR_SYSCALL("strdup");
+                free(query);
+                query = NULL;
+            } else {
+                query->type = type;
+                query->refs = 2;
+                query->next = _dns_queries;
+                _dns_queries = query;
+                *owner = 1;
+            }
+
+        }
+
+    }
+
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+    // The expired queries aren't referenced by any other thread, so they can be freed directly.
+    while ((expired = stale)) {
+        stale = stale->next;
+        free(expired->label);
+        memset(expired, 0, sizeof(dns_query_t));
+        free(expired);
+    }
+
+    if (!query) {
+        RET_ERROR_PTR(ERR_NOMEM, "could not allocate space for DNS query");
+    }
+
+    return query;
+}
+
+
+/**
+ * @brief   Send a registered query upstream, and wake any threads waiting on its answer.
+ * @note    Only answers, and authoritative denials (NXDOMAIN or NODATA), are held for DNS_QUERY_HOLD seconds. Any other failure
+ *              is handed to the threads already waiting on the query, and then dropped from the query table, so the next
+ *              thread to ask the same question sends a fresh query instead of inheriting a transient error.
+ * @param   query   a pointer to the query to be resolved, which must be owned by the caller.
+ */
+void _resolve_dns_query(dns_query_t *query) {
+
+    res_state state;
+    dns_query_t **qptr;
+    int nread, herr = 0;
+
+    if (!query) {
+        return;
+    }
+
+    if (!(state = _get_resolver_state())) {
+        _clear_error_stack();
+        nread = -1;
+        herr = NETDB_INTERNAL;
+    } else {
+        _dbgprint(3, "Sending DNS query for [%s], type %u\n", query->label, query->type);
+
+#ifdef RES_F_EDNS0ERR
+        // The state is reused, so an earlier failure mustn't leave EDNS0, and with it the DNSSEC OK bit, switched off.
+        state->_flags &= ~RES_F_EDNS0ERR;
+#endif
+
+        if ((nread = res_nquery(state, query->label, ns_c_in, query->type, query->answer, sizeof(query->answer))) < 0) {
+            herr = state->res_h_errno;
+        }
+
+    }
+
+    pthread_mutex_lock(&_dns_queries_lock);
+    query->nread = nread;
+    query->herr = herr;
+    query->expires = time(NULL) + DNS_QUERY_HOLD;
+    query->done = 1;
+
+    // Drop the table's reference to a failed query. The caller still holds its own, so the query can't be freed here.
+    if (nread < 0 && herr != HOST_NOT_FOUND && herr != NO_DATA) {
+
+        for (qptr = &_dns_queries; *qptr && *qptr != query; qptr = &((*qptr)->next));
+
+        if (*qptr) {
+            *qptr = query->next;
+            query->next = NULL;
+            query->refs--;
+        }
+
+    }
+
+    pthread_cond_broadcast(&_dns_queries_cond);
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+}
+
+
+/**
+ * @brief   Release a reference to a query, and free the query once the last reference is gone.
+ * @param   query   a pointer to the query to be released.
+ */
+void _release_dns_query(dns_query_t *query) {
+
+    unsigned int refs;
+
+    if (!query) {
+        return;
+    }
+
+    pthread_mutex_lock(&_dns_queries_lock);
+    refs = --query->refs;
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+    if (!refs) {
+        free(query->label);
+        memset(query, 0, sizeof(dns_query_t));
+        free(query);
+    }
+
+}
+
+
+/**
+ * @brief   Remove a query from the list of queries waiting for a prefetch thread.
+ * @note    This function must be called with the query table lock held. The reference held by the pending list passes to
+ *              the caller, which becomes responsible for resolving the query.
+ * @param   query   a pointer to the query to be removed, or NULL to remove the query at the head of the list.
+ * @return  a pointer to the removed query, or NULL if it wasn't waiting.
+ */
+static dns_query_t *_unqueue_dns_query(dns_query_t *query) {
+
+    dns_query_t **qptr, *prev = NULL;
+
+    for (qptr = &_dns_pending; *qptr && query && *qptr != query; qptr = &((*qptr)->pending)) {
+        prev = *qptr;
+    }
+
+    if (!(query = *qptr)) {
+        return NULL;
+    }
+
+    *qptr = query->pending;
+
+    if (_dns_pending_tail == query) {
+        _dns_pending_tail = prev;
+    }
+
+    query->pending = NULL;
+    query->queued = 0;
+    _dns_pending_count--;
+
+    return query;
+}
+
+
+/**
+ * @brief   Query a name server, sharing the answer with any other thread asking the same question at the same time.
+ * @note    This is a drop-in replacement for res_query(). If the same query is already in flight, or was answered within the
+ *              last DNS_QUERY_HOLD seconds, its answer is returned instead of sending another query upstream. A prefetched
+ *              query that is still waiting for a prefetch thread is taken over and sent by the calling thread.
+ * @param   label   a null-terminated string containing the name to be queried.
+ * @param   type    the numerical type of the resource records being requested.
+ * @param   answer  a pointer to a buffer that will receive the answer.
+ * @param   anslen  the size, in bytes, of the answer buffer.
+ * @return  the length of the answer on success, or -1 on failure, with h_errno set to the cause.
+ */
+int _dns_query(const char *label, int type, unsigned char *answer, size_t anslen) {
+
+    dns_query_t *query;
+    int owner, nread;
+
+    if (!label || !answer) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
+    }
+
+    if (!(query = _claim_dns_query(label, type, &owner))) {
+        RET_ERROR_INT(ERR_UNSPEC, "unable to register DNS query");
+    }
+
+    if (owner) {
+        _resolve_dns_query(query);
+    } else {
+        pthread_mutex_lock(&_dns_queries_lock);
+
+        // If the query is still waiting for a prefetch thread, there's no point in waiting with it.
+        if (query->queued && _unqueue_dns_query(query)) {
+            pthread_mutex_unlock(&_dns_queries_lock);
+            _dbgprint(3, "Taking over DNS prefetch for [%s], type %u\n", label, type);
+            _resolve_dns_query(query);
+            _release_dns_query(query);
+        } else {
+            _dbgprint(3, "Sharing DNS query for [%s], type %u\n", label, type);
+
+            while (!query->done) {
+                pthread_cond_wait(&_dns_queries_cond, &_dns_queries_lock);
+            }
+
+            pthread_mutex_unlock(&_dns_queries_lock);
+        }
+
+    }
+
+    if ((nread = query->nread) < 0) {
+        h_errno = query->herr;
+    } else {
+
+        if ((size_t)nread > anslen) {
+            nread = anslen;
+        }
+
+        memcpy(answer, query->answer, nread);
+    }
+
+    _release_dns_query(query);
+
+    return nread;
+}
+
+
+/**
+ * @brief   The entry point of a prefetch thread, which resolves queued queries until it has been idle for DNS_WORKER_IDLE seconds.
+ * @param   arg     this parameter is unused.
+ * @return  This function always returns NULL.
+ */
+void *_dns_query_worker(void *arg) {
+
+    dns_query_t *query;
+    struct timespec deadline;
+    int result = 0;
+
+    (void)arg;
+
+    pthread_mutex_lock(&_dns_queries_lock);
+
+    while (_dns_pending || result != ETIMEDOUT) {
+
+        if (!(query = _unqueue_dns_query(NULL))) {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += DNS_WORKER_IDLE;
+            _dns_workers_idle++;
+            result = pthread_cond_timedwait(&_dns_pending_cond, &_dns_queries_lock, &deadline);
+            _dns_workers_idle--;
+            continue;
+        }
+
+        pthread_mutex_unlock(&_dns_queries_lock);
+        _resolve_dns_query(query);
+        _release_dns_query(query);
+        pthread_mutex_lock(&_dns_queries_lock);
+        result = 0;
+    }
+
+    _dns_workers--;
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+    return NULL;
+}
+
+
+/**
+ * @brief   Queue a query to be resolved in the background, unless the same query is already in flight.
+ * @note    Queued queries are resolved by a pool of at most DNS_PREFETCH_WORKERS threads, which are started on demand.
+ * @param   label   a null-terminated string containing the name to be queried.
+ * @param   type    the numerical type of the resource records being requested.
+ * @return  -1 on failure, 0 if the query was already registered, or 1 if a new query was queued.
+ */
+int _prefetch_dns_query(const char *label, int type) {
+
+    dns_query_t *query;
+    pthread_attr_t attr;
+    pthread_t thread;
+    int owner, started = 0;
+
+    if (!(query = _claim_dns_query(label, type, &owner))) {
+        RET_ERROR_INT(ERR_UNSPEC, "unable to register DNS query");
+    } else if (!owner) {
+        _release_dns_query(query);
+        return 0;
+    }
+
+    // The pending list takes over our reference to the query.
+    pthread_mutex_lock(&_dns_queries_lock);
+    query->queued = 1;
+
+    if (_dns_pending_tail) {
+        _dns_pending_tail->pending = query;
+    } else {
+        _dns_pending = query;
+    }
+
+    _dns_pending_tail = query;
+    _dns_pending_count++;
+
+    if (_dns_pending_count > _dns_workers_idle && _dns_workers < DNS_PREFETCH_WORKERS && !pthread_attr_init(&attr)) {
+
+        if (!pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) && !pthread_create(&thread, &attr, &_dns_query_worker, NULL)) {
+            _dns_workers++;
+            started = 1;
+        }
+
+        pthread_attr_destroy(&attr);
+    }
+
+    // Other threads may already be waiting on this query, so if nothing will pick it up it has to be resolved here.
+    if (!started && !_dns_workers && _unqueue_dns_query(query)) {
+        pthread_mutex_unlock(&_dns_queries_lock);
+        _dbgprint(1, "Unable to launch DNS prefetch thread; resolving [%s], type %u in the foreground.\n", label, type);
+        _resolve_dns_query(query);
+        _release_dns_query(query);
+        return 1;
+    }
+
+    pthread_cond_signal(&_dns_pending_cond);
+    pthread_mutex_unlock(&_dns_queries_lock);
+
+    return 1;
+}
+
+
+/**
+ * @brief   Issue every query needed to validate a record at once, rather than one round trip at a time.
+ * @note    The DNSKEY and DS records of a name, and of each of its ancestors, are needed to validate a signed answer, and none
+ *              of the queries depend on one another, even though validation has to proceed in order. The queries are resolved
+ *              in the background, and the answers are picked up by _dns_query() as the validation code walks the chain. The
+ *              walk stops at the first zone with a DNSKEY in the resolver cache, since its chain was validated when it was added.
+ *              Labels starting with an underscore, like _dime and _dx, name records rather than zones, so they're skipped.
+ * @param   label   a null-terminated string containing the name at the bottom of the chain.
+ * @param   type    the numerical type of the record being validated, which is also prefetched, or 0 to only fetch the chain.
+ * @return  -1 on failure, or the number of queries that were queued.
+ */
+int _prefetch_dns_chain(const char *label, int type) {
+
+    dnskey_t cmp;
+    const char *name = label;
+    int result, started = 0;
+    size_t depth = 0;
+
+    if (!label) {
+        RET_ERROR_INT(ERR_BAD_PARAM, NULL);
+    }
+
+    if (type && (result = _prefetch_dns_query(label, type)) > 0) {
+        started += result;
+    }
+
+    while (name && !IS_ROOT_LABEL(name) && depth++ < DNS_PREFETCH_DEPTH) {
+
+        if (*name != '_') {
+            memset(&cmp, 0, sizeof(cmp));
+            cmp.label = (char *)name; /* won't be deallocated */
+
+            if (_cached_object_exists_cmp(&cmp, &(cached_stores[cached_data_dnskey]), &_dnskey_domain_comparator) > 0) {
+                _dbgprint(2, "Stopped DNS prefetch; found cached key for [%s].\n", name);
+                break;
+            }
+
+            if ((result = _prefetch_dns_query(name, T_DNSKEY)) > 0) {
+                started += result;
+            }
+
+            if ((result = _prefetch_dns_query(name, T_DS)) > 0) {
+                started += result;
+            }
+
+        }
+
+        if ((name = strchr(name, '.'))) {
+            name++;
+        }
+
+    }
+
+    // A failed prefetch only means the query will be sent when it's needed.
+    _clear_error_stack();
+    _dbgprint(2, "Queued %d DNS prefetch queries for [%s].\n", started, label);
+
+    return started;
+}
+
+
 // TODO: needs lots of cleanup. Needs to return values, for one.
 void *_lookup_dnskey(const char *label) {
 
     ns_msg handle;
     ns_rr rr;
-    dnskey_t *dnskey, *skey, **dptr, **allkeys = NULL;
+    dnskey_t *dnskey, **dptr, **allkeys = NULL;
+    cached_object_t *skey;
     unsigned char resbuf[4096];
     int nread;
     uint16_t nanswers, rrtype;
 
-    if ((nread = res_query(label, ns_c_in, T_DNSKEY, resbuf, sizeof(resbuf))) < 0) {
-        PUSH_ERROR_RESOLVER("res_query");
+    if ((nread = _dns_query(label, T_DNSKEY, resbuf, sizeof(resbuf))) < 0) {
+        PUSH_ERROR_RESOLVER("res_nquery");
         RET_ERROR_PTR(ERR_UNSPEC, "error occurred in sending DNSKEY record query");
     }
 
@@ -1384,6 +1964,8 @@ void *_lookup_dnskey(const char *label) {
 
 
         if (allkeys) {
+            skey = NULL;
+
             // The validation process works over the entire set of records.
             if (_validate_rrsig_rr(ns_rr_name(rr), &handle, T_DNSKEY, ns_rr_rdata(rr), ns_rr_rdlen(rr), &skey) < 0) {
                 fprintf(stderr, "Error: could not validate RRSIG over DNSKEY record:\n");
@@ -1392,9 +1974,9 @@ void *_lookup_dnskey(const char *label) {
             }
 
             // So once we get the first one it's just a matter of copying it over to the rest.
-            for (dptr = allkeys; *dptr; dptr++) {
+            for (dptr = allkeys; skey && *dptr; dptr++) {
                 // We ignore this potential error. Should we?
-                if (!((*dptr)->signkeys = _ptr_chain_add((*dptr)->signkeys, skey))) {
+                if (!((*dptr)->signkeys = _ptr_chain_add((*dptr)->signkeys, _get_cache_obj_data(skey)))) {
                     fprintf(stderr, "Error: could not add signing key to pointer chain.\n");
                     dump_error_stack();
                     _clear_error_stack();
@@ -1402,6 +1984,7 @@ void *_lookup_dnskey(const char *label) {
 
             }
 
+            _release_cached_object(skey);
         }
 
     }
@@ -1424,7 +2007,8 @@ void *_lookup_ds(const char *label) {
     ns_msg handle;
     ns_rr rr;
     ds_rr_t *dsr;
-    dnskey_t *dnskey, *skey;
+    dnskey_t *dnskey;
+    cached_object_t *dkobj, *skey;
     ds_t *ds, **dsptr, **allds = NULL;
     unsigned char resbuf[4096], hashbuf[64];
     int nread;
@@ -1437,8 +2021,8 @@ void *_lookup_ds(const char *label) {
 
     _dbgprint(1, "Looking up DS record for [%s]\n", label);
 
-    if ((nread = res_query(label, ns_c_in, T_DS, resbuf, sizeof(resbuf))) < 0) {
-        PUSH_ERROR_RESOLVER("res_query");
+    if ((nread = _dns_query(label, T_DS, resbuf, sizeof(resbuf))) < 0) {
+        PUSH_ERROR_RESOLVER("res_nquery");
         RET_ERROR_PTR(ERR_UNSPEC, "error occurred in sending DS record query");
     }
 
@@ -1518,7 +2102,8 @@ void *_lookup_ds(const char *label) {
         }
 
         // See if there is a DNSKEY entry that this DS record validates.
-        if ((dnskey = _get_dnskey_by_tag(ntohs(dsr->key_tag), ns_rr_name(rr), 0))) {
+        if ((dkobj = _acquire_dnskey_by_tag(ntohs(dsr->key_tag), ns_rr_name(rr), 0))) {
+            dnskey = (dnskey_t *)_get_cache_obj_data(dkobj);
             _compute_dnskey_sha_hash(dnskey, hsize, hashbuf);
 
             // Compare the hashed DNSKEY against the digest field that's 4 bytes into the DS RR.
@@ -1533,6 +2118,7 @@ void *_lookup_ds(const char *label) {
 
             }
 
+            _release_cached_object(dkobj);
         } else {
             fprintf(stderr, "XXXXXXXXXXXXX: we need to handle this\n");
         }
@@ -1558,6 +2144,8 @@ void *_lookup_ds(const char *label) {
 
 
         if (allds) {
+            skey = NULL;
+
             // The validation process works over the entire set of records.
             if (_validate_rrsig_rr(ns_rr_name(rr), &handle, T_DS, ns_rr_rdata(rr), ns_rr_rdlen(rr), &skey) < 0) {
                 fprintf(stderr, "Error: could not validate RRSIG over DS record:\n");
@@ -1566,9 +2154,9 @@ void *_lookup_ds(const char *label) {
             }
 
             // So once we get the first one it's just a matter of copying it over to the rest.
-            for (dsptr = allds; *dsptr; dsptr++) {
+            for (dsptr = allds; skey && *dsptr; dsptr++) {
                 // We ignore this error. Should we?
-                if (!((*dsptr)->signkeys = _ptr_chain_add((*dsptr)->signkeys, skey))) {
+                if (!((*dsptr)->signkeys = _ptr_chain_add((*dsptr)->signkeys, _get_cache_obj_data(skey)))) {
                     fprintf(stderr, "Error: could not add signing key to pointer chain.\n");
                     dump_error_stack();
                     _clear_error_stack();
@@ -1576,6 +2164,7 @@ void *_lookup_ds(const char *label) {
 
             }
 
+            _release_cached_object(skey);
         }
 
     }
@@ -1599,7 +2188,7 @@ char *_get_txt_record(const char *qstring, unsigned long *ttl, int *validated) {
 
     ns_msg handle;
     ns_rr rr;
-    dnskey_t *signing_key;
+    cached_object_t *signing_key;
     const unsigned char *strptr;
     unsigned char resbuf[4096];
     const char *lname;
@@ -1620,8 +2209,13 @@ char *_get_txt_record(const char *qstring, unsigned long *ttl, int *validated) {
         *validated = 0;
     }
 
-    if ((nread = res_query(qstring, ns_c_in, ns_t_txt, resbuf, sizeof(resbuf))) < 0) {
-        PUSH_ERROR_RESOLVER("res_query");
+    // Start the queries for the signing chain now, so they're answered by the time the record is validated.
+    if (_prefetch_dns_chain(qstring, ns_t_txt) < 0) {
+        _clear_error_stack();
+    }
+
+    if ((nread = _dns_query(qstring, ns_t_txt, resbuf, sizeof(resbuf))) < 0) {
+        PUSH_ERROR_RESOLVER("res_nquery");
         RET_ERROR_PTR(ERR_UNSPEC, "unable to send TXT record query");
     }
 
@@ -1684,6 +2278,7 @@ char *_get_txt_record(const char *qstring, unsigned long *ttl, int *validated) {
         // TODO: make sure the TXT record response is for the exact requested record (_dx.domain.com)
         if (rrtype == T_RRSIG) {
             // Either a validation failure or a general failure shoudl be considered a flat-out dnssec validation failure.
+            signing_key = NULL;
             vval = _validate_rrsig_rr(ns_rr_name(rr), &handle, ns_t_txt, strptr, rdleft, &signing_key);
 
             if (vval <= 0) {
@@ -1697,7 +2292,7 @@ char *_get_txt_record(const char *qstring, unsigned long *ttl, int *validated) {
 
             } else {
                 // There's a chance that our key was validated but the ultimate chain of custody still can't be completed.
-                if (_is_validated_key(signing_key)) {
+                if (_is_validated_key(_get_cache_obj_data(signing_key))) {
                     *validated = 1;
                 } else {
                     *validated = -1;
@@ -1706,6 +2301,8 @@ char *_get_txt_record(const char *qstring, unsigned long *ttl, int *validated) {
                 _fixup_dnskey_validation();
             }
 
+            _release_cached_object(signing_key);
+
         } else if (rrtype == ns_t_txt) {
 
             free(result);
@@ -1871,8 +2468,8 @@ mx_record_t **_get_mx_records(const char *qstring) {
 
     INITIALIZE_DNS();
 
-    if ((nread = res_query(qstring, ns_c_in, ns_t_mx, resbuf, sizeof(resbuf))) < 0) {
-        PUSH_ERROR_RESOLVER("res_query");
+    if ((nread = _dns_query(qstring, ns_t_mx, resbuf, sizeof(resbuf))) < 0) {
+        PUSH_ERROR_RESOLVER("res_nquery");
         RET_ERROR_PTR(ERR_UNSPEC, "error occurred in sending MX record query");
     }
 
@@ -2452,7 +3049,7 @@ void _fixup_ds_links(void) {
                 key = (dnskey_t *)ptr->data;
 
                 if (key && !key->dse) {
-                        key->dse = _get_ds_by_dnskey(key);
+                        key->dse = _acquire_ds_by_dnskey(key);
                         printf("XXX: dse was null, now = %lx [%s]\n", (unsigned long)key->dse, key->label);
                 } else { }
 
@@ -2475,6 +3072,7 @@ void _fixup_dnskey_validation(void) {
     int res;
 
     _lock_cache_store(store);
+    _materialize_cached_store(store);
     ptr = store->head;
 
     while (ptr) {
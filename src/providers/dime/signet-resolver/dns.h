@@ -11,12 +11,16 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <pthread.h>
 
 #include <openssl/ssl.h>
 #include <openssl/rsa.h>
 #include <openssl/err.h>
 #include "dime/common/error.h"
 
+// Declared by cache.h, which holds the DNSKEY and DS records looked up here.
+struct cached_object;
+
 // TODO: Does DNSKEY RR have "key revoked" bit?
 //       SEP bit indicates KSK vs. 0=ZSK?
 
@@ -26,6 +30,12 @@
 
 #define IS_ROOT_LABEL(lname) (!lname || !strlen(lname) || *lname == '.')
 
+#define DNS_ANSWER_SIZE    4096
+#define DNS_QUERY_HOLD     10                   /* Seconds a completed answer is kept so the rest of a validation chain can reuse it. */
+#define DNS_PREFETCH_DEPTH 8                    /* The maximum number of labels walked when prefetching a DNSSEC chain. */
+#define DNS_PREFETCH_WORKERS 4                  /* The maximum number of threads resolving prefetched queries in the background. */
+#define DNS_WORKER_IDLE    30                   /* Seconds an idle prefetch thread waits for more work before exiting. */
+
 
 
 #ifndef T_DNSKEY
@@ -123,6 +133,29 @@ typedef struct {
     char *name;
 } mx_record_t;
 
+typedef struct dns_query dns_query_t;
+
+/** An upstream query, which is shared by every thread asking the same question while it's in flight. */
+struct dns_query {
+    char *label;
+    int type;
+    int done;                       ///< Set once the answer (or failure) has been recorded.
+    int queued;                     ///< Set while the query is waiting for a prefetch thread to pick it up.
+    int nread;                      ///< The length of the answer, or -1 if the query failed.
+    int herr;                       ///< The resolver error code of a failed query.
+    unsigned int refs;              ///< One reference is held by the query table, and another by each thread using the query.
+    time_t expires;                 ///< When a completed query will be dropped from the query table.
+    unsigned char answer[DNS_ANSWER_SIZE];
+    dns_query_t *next;
+    dns_query_t *pending;           ///< The next query waiting for a prefetch thread.
+};
+
+/** The resolver state kept by each thread that sends queries upstream, so it's only initialized once. */
+typedef struct {
+    struct __res_state state;
+    unsigned int generation;        ///< The name server configuration the state was initialized with, or 0 if it hasn't been.
+} dns_state_t;
+
 
 
 // Public DNS interface.
@@ -130,15 +163,15 @@ PUBLIC_FUNC_DECL(int,            load_dnskey_file,        const char *filename);
 PUBLIC_FUNC_DECL(int,            is_validated_key,        dnskey_t *dk);
 
 PUBLIC_FUNC_DECL(int,            compute_dnskey_sha_hash, const dnskey_t *key, size_t nbits, unsigned char *outbuf);
-PUBLIC_FUNC_DECL(dnskey_t *,     get_dnskey_by_tag,       unsigned int tag, const char *signer, int force_lookup);
-PUBLIC_FUNC_DECL(ds_t *,         get_ds_by_dnskey,        const dnskey_t *key);
+PUBLIC_FUNC_DECL(struct cached_object *, acquire_dnskey_by_tag, unsigned int tag, const char *signer, int force_lookup);
+PUBLIC_FUNC_DECL(struct cached_object *, acquire_ds_by_dnskey,  const dnskey_t *key);
 PUBLIC_FUNC_DECL(unsigned int,   get_keytag,              const unsigned char *rdata, size_t rdlen);
 
 PUBLIC_FUNC_DECL(void,           destroy_dnskey,          dnskey_t *key);
 PUBLIC_FUNC_DECL(void,           destroy_ds,              ds_t *ds);
 
 PUBLIC_FUNC_DECL(int,            rsa_verify_record,       const char *label, unsigned char algorithm, RSA *pubkey, const unsigned char *rrsig, const unsigned char *sigbuf, size_t siglen, ns_msg *dhandle);
-PUBLIC_FUNC_DECL(int,            validate_rrsig_rr,       const char *label, ns_msg *dhandle, unsigned short covered, const unsigned char *rdata, size_t rdlen, dnskey_t **outkey);
+PUBLIC_FUNC_DECL(int,            validate_rrsig_rr,       const char *label, ns_msg *dhandle, unsigned short covered, const unsigned char *rdata, size_t rdlen, struct cached_object **outkey);
 PUBLIC_FUNC_DECL(void *,         lookup_dnskey,           const char *label);
 PUBLIC_FUNC_DECL(void *,         lookup_ds,               const char *label);
 PUBLIC_FUNC_DECL(char *,         get_txt_record,          const char *qstring, unsigned long *ttl, int *validated);
@@ -148,6 +181,17 @@ PUBLIC_FUNC_DECL(void,           free_mx_records,         mx_record_t **mxs);
 
 // Internal routines
 int        _initialize_resolver(void);
+void       _set_resolver_nameserver(const struct sockaddr_in *addr);
+res_state  _get_resolver_state(void);
+void       _destroy_resolver_state(void *state);
+
+int          _dns_query(const char *label, int type, unsigned char *answer, size_t anslen);
+dns_query_t *_claim_dns_query(const char *label, int type, int *owner);
+void         _resolve_dns_query(dns_query_t *query);
+void         _release_dns_query(dns_query_t *query);
+void *       _dns_query_worker(void *arg);
+int          _prefetch_dns_query(const char *label, int type);
+int          _prefetch_dns_chain(const char *label, int type);
 
 dnskey_t *_add_dnskey_entry(const char *label, const unsigned char *buf, size_t len, unsigned long ttl);
 dnskey_t *_add_dnskey_entry_rsa(const char *label, uint16_t flags, unsigned char algorithm, RSA *pubkey, unsigned int keytag, const unsigned char *rdata,
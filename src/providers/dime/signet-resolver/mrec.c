@@ -488,7 +488,8 @@ dime_record_t *_parse_dime_record(const char *txt, size_t len) {
  */
 dime_record_t *_get_dime_record(const char *domain, unsigned long *ttl, int use_cache) {
 
-    cached_object_t *cached, *newobj, *cloned;
+    cached_store_t *store = &(cached_stores[cached_data_drec]);
+    cached_object_t *cached, *shared, *newobj, *cloned;
     dime_record_t *result;
     char *qstr, *txtans;
     size_t qlen;
@@ -499,34 +500,40 @@ dime_record_t *_get_dime_record(const char *domain, unsigned long *ttl, int use_
     }
 
 // TODO: This needs cleanup. We should not be using any internal functions, if possible.
-    if (use_cache && (cached = _find_cached_object(domain, &(cached_stores[cached_data_drec])))) {
+    if (use_cache && (shared = _acquire_cached_object(domain, store))) {
 
         // In this case, we have a DIME management record with an expired TTL, but that has not yet reached
         // its absolute expiration date. The desired behavior is to fetch the requested record again,
         // returning all supplied data, except preserving the original expiration timestamp for security purposes.
-        if (!_is_object_expired(cached, &refresh) && refresh) {
+        if (!_is_object_expired(shared, &refresh) && refresh) {
             _dbgprint(1, "Attempting to refresh DIME record that exceeded TTL.\n");
 
             if ((result = _get_dime_record(domain, ttl, 0))) {
                 // Attach the old expiration to the new record.
-                result->expiry = cached->expiration;
+                result->expiry = shared->expiration;
 
                 // If for some reason we get a cache error, report it but return the old (original value).
-                if (!(newobj = _create_cached_object(cached_data_drec, (ttl ? *ttl : 0), cached->expiration, result, 1, 1))) {
+                if (!(newobj = _create_cached_object(cached_data_drec, (ttl ? *ttl : 0), shared->expiration, result, 1, 1))) {
                     fprintf(stderr, "Error: unable to refresh cached DIME management record entry.\n");
                     _destroy_dime_record(result);
-                    return ((dime_record_t *)_get_cache_obj_data(cached));
-                }
+                } else {
+                    _lock_cache_store(store);
+
+                    // Another caller may have refreshed or removed the record while we were fetching it.
+                    if (_lookup_cached_object(shared->id, store) != shared || !_replace_object(shared, newobj, 0)) {
+                        _unlock_cache_store(store);
+                        fprintf(stderr, "Error: unable to update cached DIME management record entry.\n");
+                        _destroy_cache_entry(newobj);
+                    } else {
+                        cached = _clone_cached_object(newobj);
+                        _unlock_cache_store(store);
+                        _release_cached_object(shared);
+                        _dbgprint(1, "Successfully refreshed DIME record; retaining old expiry.\n");
+                        return ((dime_record_t *)_get_cache_obj_data(cached));
+                    }
 
-                if (!_replace_object(cached, newobj, 0)) {
-                    fprintf(stderr, "Error: unable to update cached DIME management record entry.\n");
-                    _destroy_cache_entry(newobj);
-                    return ((dime_record_t *)_get_cache_obj_data(cached));
                 }
 
-                _dbgprint(1, "Successfully refreshed DIME record; retaining old expiry.\n");
-                // TODO: does this need to be wrapped?
-                return ((dime_record_t *)newobj->data);
             } else {
 
                 if (get_last_error()) {
@@ -541,7 +548,10 @@ dime_record_t *_get_dime_record(const char *domain, unsigned long *ttl, int use_
 
         }
 
+        // The caller owns the record it's handed, so it receives a copy of the shared one.
         _dbgprint(2, "Returning cached DIME record.\n");
+        cached = _clone_cached_object(shared);
+        _release_cached_object(shared);
         return ((dime_record_t *)_get_cache_obj_data(cached));
     } else if (use_cache && get_last_error()) {
         fprintf(stderr, "Error: could not lookup DIME record in cache.\n");
@@ -490,7 +490,8 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
         fprintf(stderr, "Error: unable to derive id string for x509 certificate.\n");
     } else {
 
-        if ((cached_ocsp = _find_cached_object(cidstr,  &(cached_stores[cached_data_ocsp])))) {
+        // The response is shared with the cache, so it's pinned until we're done with it, and evicted if it fails verification.
+        if ((cached_ocsp = _acquire_cached_object(cidstr, &(cached_stores[cached_data_ocsp])))) {
             response = (OCSP_RESPONSE *)cached_ocsp->data;
         } else if (get_last_error()) {
             fprintf(stderr, "Error: could not search object cache for OCSP response.\n");
@@ -507,13 +508,15 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
 
         if (!(basic = OCSP_response_get1_basic_d(response))) {
             PUSH_ERROR_OPENSSL();
-            _unlink_object(cached_ocsp, 1, 0);
+            _remove_cached_object(cidstr, &(cached_stores[cached_data_ocsp]));
+            _release_cached_object(cached_ocsp);
             RET_ERROR_INT(ERR_UNSPEC, "unable to inspect basic OCSP response details");
         }
 
         // Skip nonce check.
         if (!(store = _get_cert_store())) {
             OCSP_BASICRESP_free_d(basic);
+            _release_cached_object(cached_ocsp);
             RET_ERROR_INT(ERR_UNSPEC, "unable to verify OCSP response because of certificate store error");
         }
 
@@ -525,7 +528,8 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
 
             OCSP_BASICRESP_free_d(basic);
             X509_STORE_free_d(store);
-            _unlink_object(cached_ocsp, 1, 0);
+            _remove_cached_object(cidstr, &(cached_stores[cached_data_ocsp]));
+            _release_cached_object(cached_ocsp);
 
             if (ret < 0) {
                 RET_ERROR_INT(ERR_UNSPEC, "basic OCSP response verification failed");
@@ -543,7 +547,8 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
             }
 
             OCSP_BASICRESP_free_d(basic);
-            _unlink_object(cached_ocsp, 1, 0);
+            _remove_cached_object(cidstr, &(cached_stores[cached_data_ocsp]));
+            _release_cached_object(cached_ocsp);
 
             if (ret < 0) {
                 RET_ERROR_INT(ERR_UNSPEC, "basic OCSP response verification failed");
@@ -573,7 +578,8 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
             }
 
             OCSP_BASICRESP_free_d(basic);
-            _unlink_object(cached_ocsp, 1, 0);
+            _remove_cached_object(cidstr, &(cached_stores[cached_data_ocsp]));
+            _release_cached_object(cached_ocsp);
 
             if (ret < 0) {
                 RET_ERROR_INT(ERR_UNSPEC, "OCSP validity check failed");
@@ -583,6 +589,7 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
         }
 
         OCSP_BASICRESP_free_d(basic);
+        _release_cached_object(cached_ocsp);
 
         if (fallthrough) {
             *fallthrough = 0;
@@ -593,6 +600,10 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
         return 1;
     }
 
+    // A cached response that wasn't successful is ignored, and replaced by a fresh one.
+    _release_cached_object(cached_ocsp);
+    response = NULL;
+
     if ((!(ocspst = X509_get1_ocsp_d(cert))) || (!sk_num_d(CHECKED_STACK_OF(OPENSSL_STRING, ocspst)))) {
         // Could not get OCSP URI from certificate.
 
@@ -881,7 +892,7 @@ int _do_ocsp_validation(SSL *connection, int *fallthrough) {
 
     // TODO: memory leak with basic?
 
-    if (_save_cache_contents() < 0) {
+    if (_checkpoint_cache_contents() < 0) {
         fprintf(stderr, "Error: unable to save contents of cache to file.\n");
     }
 
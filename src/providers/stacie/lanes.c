@@ -0,0 +1,468 @@
+
+/**
+ * @file /magma/src/providers/stacie/lanes.c
+ *
+ * @brief	Derive the STACIE seed, master key, and password key values for several users at once, using a SHA-512 implementation
+ * 			which processes STACIE_LANES independent messages side by side.
+ *
+ * @note	The derivation of a single user is inherently serial, since every round depends on the output of the previous round, so
+ * 			the parallelism comes from working on different users at the same time. Each lane holds a single derivation, and the
+ * 			compression function is written so the lanes are always the innermost loop, which lets the compiler map the lanes
+ * 			onto vector registers. On x86-64 the compression function is compiled for AVX-512, AVX2, and the baseline instruction
+ * 			set, and the best version is selected at runtime. When a lane finishes, it's immediately refilled with the next
+ * 			pending derivation, so a user with a short password, and very large number of rounds, won't stall the other lanes.
+ * 			The results are identical to those produced by stacie_derive_seed() and stacie_derive_key().
+ */
+
+#include "magma.h"
+
+static const uint64_t stacie_lanes_k[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL,
+	0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+	0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL, 0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+	0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL, 0x983e5152ee66dfabULL,
+	0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+	0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL,
+	0x53380d139d95b3dfULL, 0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+	0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL, 0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+	0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL,
+	0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL, 0xca273eceea26619cULL,
+	0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+	0x113f9804bef90daeULL, 0x1b710b35131c471bULL, 0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+	0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static const uint64_t stacie_lanes_iv[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+#define STACIE_LANES_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+/**
+ * @brief	Reset a lane's hash state to the SHA-512 initial values.
+ * @param	state	the hash state for every lane.
+ * @param	lane	the lane being reset.
+ * @return	This function returns no value.
+ */
+void stacie_lanes_init(uint64_t state[8][STACIE_LANES], uint_t lane) {
+
+	for (int_t i = 0; i < 8; i++) {
+		state[i][lane] = stacie_lanes_iv[i];
+	}
+
+	return;
+}
+
+/**
+ * @brief	Store a lane's hash state as a big endian SHA-512 digest.
+ * @param	state	the hash state for every lane.
+ * @param	lane	the lane being read.
+ * @param	output	a buffer of STACIE_KEY_LENGTH bytes which will receive the digest.
+ * @return	This function returns no value.
+ */
+void stacie_lanes_digest(uint64_t state[8][STACIE_LANES], uint_t lane, uchr_t *output) {
+
+	for (int_t i = 0; i < 8; i++) {
+		for (int_t j = 0; j < 8; j++) {
+			output[(i * 8) + j] = (uchr_t)(state[i][lane] >> (56 - (j * 8)));
+		}
+	}
+
+	return;
+}
+
+/**
+ * @brief	Apply the SHA-512 compression function to a block of every lane.
+ * @note	Lanes without a derivation are compressed along with the others, and their results are ignored, since masking
+ * 			them out would cost more than it saves.
+ * @param	state	the hash state for every lane.
+ * @param	block	the next message block for every lane, as big endian words which have already been converted to host order.
+ * @return	This function returns no value.
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && (__GNUC__ >= 6) && !defined(__clang__)
+__attribute__ ((target_clones("avx512f", "avx2", "default")))
+#endif
+void stacie_lanes_compress(uint64_t state[8][STACIE_LANES], uint64_t block[16][STACIE_LANES]) {
+
+	uint64_t w[80][STACIE_LANES], v[8][STACIE_LANES], t1, t2;
+
+	for (int_t t = 0; t < 16; t++) {
+		for (int_t l = 0; l < STACIE_LANES; l++) {
+			w[t][l] = block[t][l];
+		}
+	}
+
+	for (int_t t = 16; t < 80; t++) {
+		for (int_t l = 0; l < STACIE_LANES; l++) {
+			w[t][l] = (STACIE_LANES_ROTR(w[t - 2][l], 19) ^ STACIE_LANES_ROTR(w[t - 2][l], 61) ^ (w[t - 2][l] >> 6)) + w[t - 7][l] +
+				(STACIE_LANES_ROTR(w[t - 15][l], 1) ^ STACIE_LANES_ROTR(w[t - 15][l], 8) ^ (w[t - 15][l] >> 7)) + w[t - 16][l];
+		}
+	}
+
+	for (int_t i = 0; i < 8; i++) {
+		for (int_t l = 0; l < STACIE_LANES; l++) {
+			v[i][l] = state[i][l];
+		}
+	}
+
+	for (int_t t = 0; t < 80; t++) {
+		for (int_t l = 0; l < STACIE_LANES; l++) {
+
+			t1 = v[7][l] + (STACIE_LANES_ROTR(v[4][l], 14) ^ STACIE_LANES_ROTR(v[4][l], 18) ^ STACIE_LANES_ROTR(v[4][l], 41)) +
+				((v[4][l] & v[5][l]) ^ (~v[4][l] & v[6][l])) + stacie_lanes_k[t] + w[t][l];
+			t2 = (STACIE_LANES_ROTR(v[0][l], 28) ^ STACIE_LANES_ROTR(v[0][l], 34) ^ STACIE_LANES_ROTR(v[0][l], 39)) +
+				((v[0][l] & v[1][l]) ^ (v[0][l] & v[2][l]) ^ (v[1][l] & v[2][l]));
+
+			v[7][l] = v[6][l];
+			v[6][l] = v[5][l];
+			v[5][l] = v[4][l];
+			v[4][l] = v[3][l] + t1;
+			v[3][l] = v[2][l];
+			v[2][l] = v[1][l];
+			v[1][l] = v[0][l];
+			v[0][l] = t1 + t2;
+		}
+	}
+
+	for (int_t i = 0; i < 8; i++) {
+		for (int_t l = 0; l < STACIE_LANES; l++) {
+			state[i][l] += v[i][l];
+		}
+	}
+
+	mm_wipe(w, sizeof(w));
+	mm_wipe(v, sizeof(v));
+
+	return;
+}
+
+/**
+ * @brief	Build the padded message for the next hash computed by a lane, unless it's computed over the repeated password.
+ * @note	The key derivation rounds only differ by the output of the previous round, and the round counter, so after the
+ * 			second round only those values are replaced.
+ * @param	lane	the lane being updated.
+ * @return	This function returns no value.
+ */
+void stacie_lanes_message(stacie_lane_t *lane) {
+
+	size_t length = 0;
+	uchr_t *base, *running;
+	stacie_job_t *job = lane->job;
+	size_t username_len = st_length_get(job->username), password_len = st_length_get(job->password);
+
+	lane->block = 0;
+	lane->finished = false;
+
+	if (lane->stage == STACIE_LANE_SEED_OUTER) {
+
+		for (int_t i = 0; i < STACIE_SALT_LENGTH; i++) {
+			lane->buffer[i] = *((uchr_t *)st_data_get(job->salt) + i) ^ 0x5c;
+		}
+
+		mm_copy(lane->buffer + STACIE_SALT_LENGTH, lane->inner, STACIE_KEY_LENGTH);
+		length = STACIE_SALT_LENGTH + STACIE_KEY_LENGTH;
+	}
+	else {
+
+		base = (lane->stage == STACIE_LANE_MASTER ? job->seed : job->master);
+		running = (lane->stage == STACIE_LANE_MASTER ? job->master : job->key);
+
+		// The message length and padding don't change after the second round.
+		if (lane->round >= 2) {
+			length = STACIE_KEY_LENGTH + STACIE_KEY_LENGTH + username_len + STACIE_SALT_LENGTH + password_len;
+			mm_copy(lane->buffer, running, STACIE_KEY_LENGTH);
+			lane->buffer[length] = (uchr_t)(lane->round >> 16);
+			lane->buffer[length + 1] = (uchr_t)(lane->round >> 8);
+			lane->buffer[length + 2] = (uchr_t)lane->round;
+			return;
+		}
+
+		// The output of the previous round isn't part of the first round.
+		if (lane->round) {
+			mm_copy(lane->buffer, running, STACIE_KEY_LENGTH);
+			length += STACIE_KEY_LENGTH;
+		}
+
+		mm_copy(lane->buffer + length, base, STACIE_KEY_LENGTH);
+		length += STACIE_KEY_LENGTH;
+		mm_copy(lane->buffer + length, st_data_get(job->username), username_len);
+		length += username_len;
+		mm_copy(lane->buffer + length, st_data_get(job->salt), STACIE_SALT_LENGTH);
+		length += STACIE_SALT_LENGTH;
+		mm_copy(lane->buffer + length, st_data_get(job->password), password_len);
+		length += password_len;
+
+		// The round counter is stored as a 24 bit big endian number.
+		lane->buffer[length++] = (uchr_t)(lane->round >> 16);
+		lane->buffer[length++] = (uchr_t)(lane->round >> 8);
+		lane->buffer[length++] = (uchr_t)lane->round;
+	}
+
+	// Add the padding, and the message length in bits.
+	lane->blocks = (length + 17 + 127) / 128;
+	mm_wipe(lane->buffer + length, (lane->blocks * 128) - length);
+	lane->buffer[length] = 0x80;
+
+	for (int_t i = 0; i < 8; i++) {
+		lane->buffer[(lane->blocks * 128) - 1 - i] = (uchr_t)(((uint64_t)length * 8) >> (i * 8));
+	}
+
+	return;
+}
+
+/**
+ * @brief	Produce the next message block for a lane.
+ * @note	The inner hash of the seed stage covers the password repeated once per round, which would need a very large buffer
+ * 			for short passwords, so the blocks are generated as they're needed.
+ * @param	lane	the lane being processed.
+ * @param	output	a buffer of 128 bytes which will receive the block.
+ * @return	This function returns no value.
+ */
+void stacie_lanes_block(stacie_lane_t *lane, uchr_t *output) {
+
+	size_t position = 0, chunk, index, length;
+	uchr_t *password;
+
+	if (lane->stage != STACIE_LANE_SEED_INNER) {
+		mm_copy(output, lane->buffer + (lane->block * 128), 128);
+		lane->finished = (++lane->block == lane->blocks);
+		return;
+	}
+
+	// The HMAC key is the salt, which is exactly one block long, so it's used without being hashed first.
+	if (!lane->block++) {
+		for (int_t i = 0; i < STACIE_SALT_LENGTH; i++) {
+			output[i] = *((uchr_t *)st_data_get(lane->job->salt) + i) ^ 0x36;
+		}
+		return;
+	}
+
+	password = st_data_get(lane->job->password);
+	length = st_length_get(lane->job->password);
+
+	while (position < 128 && lane->offset < lane->total) {
+		index = lane->offset % length;
+		chunk = 128 - position;
+
+		if (chunk > length - index) {
+			chunk = length - index;
+		}
+
+		if (chunk > lane->total - lane->offset) {
+			chunk = lane->total - lane->offset;
+		}
+
+		mm_copy(output + position, password + index, chunk);
+		position += chunk;
+		lane->offset += chunk;
+	}
+
+	if (position < 128 && !lane->marked) {
+		output[position++] = 0x80;
+		lane->marked = true;
+	}
+
+	if (position < 128) {
+		mm_wipe(output + position, 128 - position);
+	}
+
+	// The message length is only added once there's room for it after the padding marker.
+	if (lane->marked && position <= 112) {
+		for (int_t i = 0; i < 8; i++) {
+			output[127 - i] = (uchr_t)(((lane->total + STACIE_SALT_LENGTH) * 8) >> (i * 8));
+		}
+		lane->finished = true;
+	}
+
+	return;
+}
+
+/**
+ * @brief	Assign a derivation to an idle lane.
+ * @param	lane	the idle lane.
+ * @param	job		the derivation being assigned.
+ * @return	true if the derivation was assigned, or false if its inputs are invalid.
+ */
+bool_t stacie_lanes_start(stacie_lane_t *lane, stacie_job_t *job) {
+
+	size_t length;
+
+	if (!job || job->rounds < STACIE_KEY_ROUNDS_MIN || job->rounds > STACIE_KEY_ROUNDS_MAX || st_empty(job->username, job->password) ||
+		st_empty(job->salt) || st_length_get(job->salt) != STACIE_SALT_LENGTH) {
+		log_pedantic("A required parameter, needed to calculate the STACIE values, is missing or invalid.");
+		return false;
+	}
+
+	// The buffer must hold the longest message, which is any key derivation round after the first.
+	length = STACIE_KEY_LENGTH + STACIE_KEY_LENGTH + st_length_get(job->username) + STACIE_SALT_LENGTH + st_length_get(job->password) + 3;
+	if ((length = ((length + 17 + 127) / 128) * 128) < 256) {
+		length = 256;
+	}
+
+	if (!(lane->buffer = mm_alloc(length))) {
+		log_pedantic("Unable to allocate %zu bytes for the STACIE derivation.", length);
+		return false;
+	}
+
+	lane->job = job;
+	lane->size = length;
+	lane->stage = STACIE_LANE_SEED_INNER;
+	lane->round = 0;
+	lane->block = lane->blocks = 0;
+	lane->offset = 0;
+	lane->total = (uint64_t)job->rounds * st_length_get(job->password);
+	lane->marked = lane->finished = false;
+
+	return true;
+}
+
+/**
+ * @brief	Wipe a lane once its derivation is complete, or abandoned.
+ * @param	lane	the lane being released.
+ * @return	This function returns no value.
+ */
+void stacie_lanes_release(stacie_lane_t *lane) {
+
+	if (lane->buffer) {
+		mm_wipe(lane->buffer, lane->size);
+		mm_free(lane->buffer);
+	}
+
+	mm_wipe(lane, sizeof(stacie_lane_t));
+
+	return;
+}
+
+/**
+ * @brief	Process derivations until there aren't any left.
+ * @note	The next callback is used to fetch a pending derivation whenever a lane is idle, and should return NULL if none are
+ * 			waiting. The done callback is invoked once a derivation completes, or fails, and the lane is released before it's
+ * 			called, so the callback may free the derivation.
+ * @param	next	the function used to fetch pending derivations.
+ * @param	done	the function which is handed the completed derivations.
+ * @param	opaque	a pointer passed along to the callbacks.
+ * @return	true once every derivation has been processed, or false if processing was aborted because of a shutdown, in which
+ * 			case the derivations which were in progress are marked as failed.
+ */
+bool_t stacie_lanes_derive(stacie_job_t *(*next)(void *opaque), void (*done)(stacie_job_t *job, void *opaque), void *opaque) {
+
+	uint_t busy;
+	uchr_t data[128];
+	stacie_job_t *job;
+	uint64_t iterations = 0;
+	stacie_lane_t lanes[STACIE_LANES];
+	uint64_t state[8][STACIE_LANES], block[16][STACIE_LANES];
+
+	mm_wipe(lanes, sizeof(lanes));
+	mm_wipe(state, sizeof(state));
+	mm_wipe(block, sizeof(block));
+
+	do {
+
+		busy = 0;
+
+		for (uint_t l = 0; l < STACIE_LANES; l++) {
+
+			// Refill the idle lanes.
+			while (!lanes[l].job && (job = next(opaque))) {
+
+				if (!stacie_lanes_start(&lanes[l], job)) {
+					job->failed = true;
+					done(job, opaque);
+				}
+				else {
+					stacie_lanes_init(state, l);
+				}
+			}
+
+			if (lanes[l].job) {
+
+				stacie_lanes_block(&lanes[l], data);
+
+				for (int_t t = 0; t < 16; t++) {
+					block[t][l] = be64toh(*((uint64_t *)(data + (t * 8))));
+				}
+
+				busy++;
+			}
+		}
+
+		if (!busy) {
+			break;
+		}
+
+		stacie_lanes_compress(state, block);
+
+		for (uint_t l = 0; l < STACIE_LANES; l++) {
+
+			if (!lanes[l].job || !lanes[l].finished) {
+				continue;
+			}
+
+			job = lanes[l].job;
+
+			if (lanes[l].stage == STACIE_LANE_SEED_INNER) {
+				stacie_lanes_digest(state, l, lanes[l].inner);
+				lanes[l].stage = STACIE_LANE_SEED_OUTER;
+			}
+			else if (lanes[l].stage == STACIE_LANE_SEED_OUTER) {
+				stacie_lanes_digest(state, l, job->seed);
+				lanes[l].stage = STACIE_LANE_MASTER;
+				lanes[l].round = 0;
+			}
+			else if (lanes[l].stage == STACIE_LANE_MASTER && ++lanes[l].round < job->rounds) {
+				stacie_lanes_digest(state, l, job->master);
+			}
+			else if (lanes[l].stage == STACIE_LANE_MASTER) {
+				stacie_lanes_digest(state, l, job->master);
+				lanes[l].stage = STACIE_LANE_PASSWORD;
+				lanes[l].round = 0;
+			}
+			else if (lanes[l].stage == STACIE_LANE_PASSWORD && ++lanes[l].round < job->rounds) {
+				stacie_lanes_digest(state, l, job->key);
+			}
+			else {
+				stacie_lanes_digest(state, l, job->key);
+				stacie_lanes_release(&lanes[l]);
+				done(job, opaque);
+				continue;
+			}
+
+			stacie_lanes_message(&lanes[l]);
+			stacie_lanes_init(state, l);
+		}
+
+		// This status check is inside an ifdef conditional so the file can be compiled as a standalone module, and it
+		// checks whether the daemon is attempting a shutdown, so password processing doesn't block the termination logic.
+#ifdef MAGMA_ENGINE_STATUS_H
+		if ((++iterations % 100000) == 0 && !status()) {
+
+			log_pedantic("The STACIE multi-lane derivation has been aborted early by a system shutdown.");
+
+			for (uint_t l = 0; l < STACIE_LANES; l++) {
+				if ((job = lanes[l].job)) {
+					stacie_lanes_release(&lanes[l]);
+					job->failed = true;
+					done(job, opaque);
+				}
+			}
+
+			mm_wipe(data, sizeof(data));
+			mm_wipe(state, sizeof(state));
+			mm_wipe(block, sizeof(block));
+			return false;
+		}
+#endif
+
+	} while (true);
+
+	mm_wipe(data, sizeof(data));
+	mm_wipe(state, sizeof(state));
+	mm_wipe(block, sizeof(block));
+
+	return true;
+}
@@ -36,6 +36,48 @@
 #define STACIE_BLOCK_LENGTH		16
 #define STACIE_ENVELOPE_LENGTH	34
 
+// The number of derivations processed side by side by the multi-lane SHA-512 implementation. Eight lanes fill an AVX-512
+// register, and the compiler splits the lanes across narrower registers on processors without it.
+#define STACIE_LANES			8
+
+enum {
+	STACIE_LANE_SEED_INNER = 0,
+	STACIE_LANE_SEED_OUTER = 1,
+	STACIE_LANE_MASTER = 2,
+	STACIE_LANE_PASSWORD = 3
+};
+
+// A single derivation of the seed, master key, and password key values, processed by the multi-lane functions.
+typedef struct stacie_job_t {
+	uint32_t rounds;
+	stringer_t *username, *password, *salt;
+	uchr_t seed[STACIE_KEY_LENGTH], master[STACIE_KEY_LENGTH], key[STACIE_KEY_LENGTH];
+	bool_t done, failed;
+	struct stacie_job_t *next;
+} stacie_job_t;
+
+// The progress of the derivation assigned to a lane.
+typedef struct {
+	stacie_job_t *job;
+	int_t stage; /* Which of the hashes needed by the derivation is being computed. */
+	uint32_t round; /* The current round, during the key derivation stages. */
+	bool_t marked, finished; /* Whether the padding marker, and the message length, have been added to the current hash. */
+	uint64_t offset, total; /* How much of the repeated password has been hashed, and the total length, during the seed stage. */
+	size_t block, blocks, size; /* The next block, the number of blocks in the buffered message, and the size of the buffer. */
+	uchr_t *buffer; /* The padded message, for the hashes which aren't computed over the repeated password. */
+	uchr_t inner[STACIE_KEY_LENGTH];
+} stacie_lane_t;
+
+/// lanes.c
+void      stacie_lanes_block(stacie_lane_t *lane, uchr_t *output);
+void      stacie_lanes_compress(uint64_t state[8][STACIE_LANES], uint64_t block[16][STACIE_LANES]);
+bool_t    stacie_lanes_derive(stacie_job_t *(*next)(void *opaque), void (*done)(stacie_job_t *job, void *opaque), void *opaque);
+void      stacie_lanes_digest(uint64_t state[8][STACIE_LANES], uint_t lane, uchr_t *output);
+void      stacie_lanes_init(uint64_t state[8][STACIE_LANES], uint_t lane);
+void      stacie_lanes_message(stacie_lane_t *lane);
+void      stacie_lanes_release(stacie_lane_t *lane);
+bool_t    stacie_lanes_start(stacie_lane_t *lane, stacie_job_t *job);
+
 /// realms.c
 stringer_t *  stacie_realm_cipher(stringer_t *realm_key);
 stringer_t *  stacie_realm_key(stringer_t *master_key, stringer_t *realm,  stringer_t *salt, stringer_t *shard);
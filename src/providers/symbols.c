@@ -19,6 +19,8 @@ memcached_return_t (*memcached_server_add_with_weight_d)(memcached_st *ptr, cons
 memcached_return_t (*memcached_decrement_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value) = NULL;
 memcached_return_t (*memcached_increment_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value) = NULL;
 char * (*memcached_get_d)(memcached_st *ptr, const char *key, size_t key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error) = NULL;
+memcached_return_t (*memcached_mget_d)(memcached_st *ptr, const char * const *keys, const size_t *key_length, size_t number_of_keys) = NULL;
+char * (*memcached_fetch_d)(memcached_st *ptr, char *key, size_t *key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error) = NULL;
 memcached_return_t (*memcached_add_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
 memcached_return_t (*memcached_set_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
 memcached_return_t (*memcached_append_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags) = NULL;
@@ -50,6 +52,9 @@ cl_error_t (*cl_engine_set_num_d)(struct cl_engine *engine, enum cl_engine_field
 cl_error_t (*cl_engine_set_str_d)(struct cl_engine *engine, enum cl_engine_field field, const char *str) = NULL;
 cl_error_t (*cl_load_d)(const char *path, struct cl_engine *engine, unsigned int *signo, unsigned int dboptions) = NULL;
 cl_error_t (*cl_scandesc_d)(int desc, const char *filename, const char **virname, unsigned long int *scanned, const struct cl_engine *engine, struct cl_scan_options *scanoptions) = NULL;
+cl_fmap_t * (*cl_fmap_open_memory_d)(const void *start, size_t len) = NULL;
+void (*cl_fmap_close_d)(cl_fmap_t *map) = NULL;
+cl_error_t (*cl_scanmap_callback_d)(cl_fmap_t *map, const char *filename, const char **virname, unsigned long int *scanned, const struct cl_engine *engine, struct cl_scan_options *scanoptions, void *context) = NULL;
 
 //! DSPAM
 const char * (*dspam_version_d)(void) = NULL;
@@ -75,6 +80,9 @@ DKIM_STAT (*dkim_header_d)(DKIM *dkim, u_char *hdr, size_t len) = NULL;
 void (*dkim_mfree_d)(DKIM_LIB *libhandle, void *closure, void *ptr) = NULL;
 DKIM_STAT (*dkim_chunk_d)(DKIM *dkim, unsigned char *chunkp, size_t len) = NULL;
 DKIM_STAT (*dkim_getsighdrx_d)(DKIM *dkim, u_char *buf, size_t len, size_t initial) = NULL;
+unsigned char * (*dkim_sig_getdomain_d)(DKIM_SIGINFO *siginfo) = NULL;
+unsigned char * (*dkim_sig_getselector_d)(DKIM_SIGINFO *siginfo) = NULL;
+DKIM_STAT (*dkim_set_key_lookup_d)(DKIM_LIB *libopendkim, DKIM_STAT (*func)(DKIM *dkim, DKIM_SIGINFO *sig, u_char *buf, size_t len)) = NULL;
 int (*dkim_test_dns_put_d)(DKIM *dkim, int class, int type, int prec, u_char *name, u_char *data) = NULL;
 DKIM * (*dkim_verify_d)(DKIM_LIB *libhandle, const unsigned char *id, void *memclosure, DKIM_STAT *statp) = NULL;
 DKIM_LIB * (*dkim_init_d)(void *(*mallocf)(void *closure, size_t nbytes), void (*freef)(void *closure, void *p)) = NULL;
@@ -389,6 +397,8 @@ int (*DH_generate_parameters_ex_d)(DH *dh, int prime_len,int generator, BN_GENCB
 ECDSA_SIG * (*ECDSA_do_sign_d)(const unsigned char *dgst, int dgst_len, EC_KEY *eckey) = NULL;
 int (*X509_STORE_load_locations_d)(X509_STORE *ctx, const char *file, const char *path) = NULL;
 void (*SSL_CTX_set_verify_d)(SSL_CTX *ctx, int mode, int (*cb) (int, X509_STORE_CTX *)) = NULL;
+long (*SSL_CTX_set_timeout_d)(SSL_CTX *ctx, long t) = NULL;
+void (*SSL_set_shutdown_d)(SSL *ssl, int mode) = NULL;
 EC_POINT * (*EC_POINT_hex2point_d)(const EC_GROUP *, const char *, EC_POINT *, BN_CTX *) = NULL;
 int (*CRYPTO_set_locked_mem_functions_d)(void *(*m) (size_t), void (*free_func) (void *)) = NULL;
 int (*OCSP_REQ_CTX_add1_header_d)(OCSP_REQ_CTX *rctx, const char *name, const char *value) = NULL;
@@ -121,6 +121,8 @@ extern memcached_return_t (*memcached_server_add_with_weight_d)(memcached_st *pt
 extern memcached_return_t (*memcached_decrement_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value);
 extern memcached_return_t (*memcached_increment_d)(memcached_st *ptr, const char *key, size_t key_length, uint32_t offset, uint64_t *value);
 extern char * (*memcached_get_d)(memcached_st *ptr, const char *key, size_t key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error);
+extern memcached_return_t (*memcached_mget_d)(memcached_st *ptr, const char * const *keys, const size_t *key_length, size_t number_of_keys);
+extern char * (*memcached_fetch_d)(memcached_st *ptr, char *key, size_t *key_length, size_t *value_length, uint32_t *flags, memcached_return_t *error);
 extern memcached_return_t (*memcached_add_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags);
 extern memcached_return_t (*memcached_set_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags);
 extern memcached_return_t (*memcached_append_d)(memcached_st *ptr, const char *key, size_t key_length, const char *value, size_t value_length, time_t expiration, uint32_t flags);
@@ -152,6 +154,9 @@ extern cl_error_t (*cl_engine_set_num_d)(struct cl_engine *engine, enum cl_engin
 extern cl_error_t (*cl_engine_set_str_d)(struct cl_engine *engine, enum cl_engine_field field, const char *str);
 extern cl_error_t (*cl_load_d)(const char *path, struct cl_engine *engine, unsigned int *signo, unsigned int dboptions);
 extern cl_error_t (*cl_scandesc_d)(int desc, const char *filename, const char **virname, unsigned long int *scanned, const struct cl_engine *engine, struct cl_scan_options *scanoptions);
+extern cl_fmap_t * (*cl_fmap_open_memory_d)(const void *start, size_t len);
+extern void (*cl_fmap_close_d)(cl_fmap_t *map);
+extern cl_error_t (*cl_scanmap_callback_d)(cl_fmap_t *map, const char *filename, const char **virname, unsigned long int *scanned, const struct cl_engine *engine, struct cl_scan_options *scanoptions, void *context);
 
 //! DSPAM
 extern const char * (*dspam_version_d)(void);
@@ -179,6 +184,9 @@ extern DKIM_STAT (*dkim_header_d)(DKIM *dkim, u_char *hdr, size_t len);
 extern void (*dkim_mfree_d)(DKIM_LIB *libhandle, void *closure, void *ptr);
 extern DKIM_STAT (*dkim_chunk_d)(DKIM *dkim, unsigned char *chunkp, size_t len);
 extern DKIM_STAT (*dkim_getsighdrx_d)(DKIM *dkim, u_char *buf, size_t len, size_t initial);
+extern unsigned char * (*dkim_sig_getdomain_d)(DKIM_SIGINFO *siginfo);
+extern unsigned char * (*dkim_sig_getselector_d)(DKIM_SIGINFO *siginfo);
+extern DKIM_STAT (*dkim_set_key_lookup_d)(DKIM_LIB *libopendkim, DKIM_STAT (*func)(DKIM *dkim, DKIM_SIGINFO *sig, u_char *buf, size_t len));
 extern int (*dkim_test_dns_put_d)(DKIM *dkim, int class, int type, int prec, u_char *name, u_char *data);
 extern DKIM * (*dkim_verify_d)(DKIM_LIB *libhandle, const unsigned char *id, void *memclosure, DKIM_STAT *statp);
 extern DKIM_LIB * (*dkim_init_d)(void *(*mallocf)(void *closure, size_t nbytes), void (*freef)(void *closure, void *p));
@@ -493,6 +501,8 @@ extern int (*DH_generate_parameters_ex_d)(DH *dh, int prime_len,int generator, B
 extern ECDSA_SIG * (*ECDSA_do_sign_d)(const unsigned char *dgst, int dgst_len, EC_KEY *eckey);
 extern int (*X509_STORE_load_locations_d)(X509_STORE *ctx, const char *file, const char *path);
 extern void (*SSL_CTX_set_verify_d)(SSL_CTX *ctx, int mode, int (*cb) (int, X509_STORE_CTX *));
+extern long (*SSL_CTX_set_timeout_d)(SSL_CTX *ctx, long t);
+extern void (*SSL_set_shutdown_d)(SSL *ssl, int mode);
 extern EC_POINT * (*EC_POINT_hex2point_d)(const EC_GROUP *, const char *, EC_POINT *, BN_CTX *);
 extern int (*CRYPTO_set_locked_mem_functions_d)(void *(*m) (size_t), void (*free_func) (void *));
 extern int (*OCSP_REQ_CTX_add1_header_d)(OCSP_REQ_CTX *rctx, const char *name, const char *value);
@@ -700,6 +710,12 @@ extern const char * (*zlibVersion_d)(void);
 extern uLong (*compressBound_d)(uLong sourceLen);
 extern int (*uncompress_d)(Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen);
 extern int (*compress2_d)(Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen, int level);
+extern int (*deflateEnd_d)(z_streamp strm);
+extern int (*deflate_d)(z_streamp strm, int flush);
+extern int (*deflateInit2__d)(z_streamp strm, int level, int method, int windowBits, int memLevel, int strategy, const char *version, int stream_size);
+extern int (*inflateEnd_d)(z_streamp strm);
+extern int (*inflate_d)(z_streamp strm, int flush);
+extern int (*inflateInit2__d)(z_streamp strm, int windowBits, const char *version, int stream_size);
 
 #endif
 
@@ -30,7 +30,9 @@
 #define SELECT_USER_STORAGE_KEYS "SELECT signet, `key` FROM `Keys` WHERE usernum = ?"
 #define UPDATE_USER_STORAGE_KEYS "INSERT INTO `Keys` (usernum, signet, `key`) VALUES (?, ?, ?) ON DUPLICATE KEY UPDATE signet = ?, `key` = ?"
 #define UPDATE_USER_QUOTA_ADD "UPDATE Users SET size = size + ?, overquota = IF(size < quota, 0, 1) WHERE usernum = ?"
-#define UPDATE_USER_QUOTA_SUBTRACT "UPDATE Users SET size = size - ?, overquota = IF(size < quota, 0, 1) WHERE usernum = ?"
+#define UPDATE_USER_QUOTA_SUBTRACT "UPDATE Users SET size = size - ?, overquota = IF(size < quota, 0, 1), modseq = modseq + 1 WHERE usernum = ?"
+#define SELECT_USER_MODSEQ "SELECT modseq FROM Users WHERE usernum = ?"
+#define UPDATE_USER_MODSEQ "UPDATE Users SET modseq = LAST_INSERT_ID(modseq + 1) WHERE usernum = ?"
 
 // Mailbox Aliases
 #define SELECT_MAILBOX_ALIASES "SELECT Aliases.aliasnum, Mailboxes.address, Aliases.display, Aliases.selected, UNIX_TIMESTAMP(Aliases.created) from Mailboxes " \
@@ -54,15 +56,22 @@
 #define RENAME_FOLDER "UPDATE Folders SET foldername = ? WHERE foldernum = ? AND usernum = ? AND type = ?"
 
 // Messages table
-#define SELECT_MESSAGES "SELECT messagenum, foldernum, server, status, size, signum, sigkey, UNIX_TIMESTAMP(created) FROM Messages WHERE usernum = ? AND visible = 1 ORDER BY messagenum ASC"
+#define SELECT_MESSAGES "SELECT messagenum, foldernum, server, status, size, signum, sigkey, UNIX_TIMESTAMP(created), modseq FROM Messages WHERE usernum = ? AND visible = 1 ORDER BY messagenum ASC"
 #define UPDATE_MESSAGE_VISIBILITY "UPDATE Messages SET visible = 0 WHERE messagenum = ?"
-#define UPDATE_MESSAGE_FLAGS_ADD "UPDATE Messages SET status = (status | ?) WHERE usernum = ? AND foldernum = ? AND messagenum = ?"
-#define UPDATE_MESSAGE_FLAGS_REMOVE "UPDATE Messages SET status = ((status | ?) ^ ?) WHERE usernum = ? AND foldernum = ? AND messagenum = ?"
-#define UPDATE_MESSAGE_FLAGS_REPLACE  "UPDATE Messages SET status = (((status | ?) ^ ?) | ?) WHERE usernum = ? AND foldernum = ? AND messagenum = ?"
-#define UPDATE_MESSAGE_FOLDER "UPDATE Messages SET foldernum = ? WHERE messagenum = ? AND usernum = ? AND foldernum = ?"
-#define INSERT_MESSAGE "INSERT INTO Messages (usernum, foldernum, server, status, size, signum, sigkey, created) VALUES (?, ?, ?, ?, ?, ?, ?, NOW())"
-#define INSERT_MESSAGE_DUPLICATE "INSERT INTO Messages (usernum, foldernum, server, status, size, signum, sigkey, created) VALUES (?, ?, ?, ?, ?, ?, ?, FROM_UNIXTIME(?))"
+// The flag updates and bulk deletes are applied to batches of messages, so the number of placeholders in the IN clause must match
+// META_FLAGS_BATCH_SIZE and MAIL_REMOVE_BATCH_SIZE respectively.
+#define MESSAGE_BATCH_8 "?, ?, ?, ?, ?, ?, ?, ?"
+#define MESSAGE_BATCH_64 MESSAGE_BATCH_8 ", " MESSAGE_BATCH_8 ", " MESSAGE_BATCH_8 ", " MESSAGE_BATCH_8 ", " \
+	MESSAGE_BATCH_8 ", " MESSAGE_BATCH_8 ", " MESSAGE_BATCH_8 ", " MESSAGE_BATCH_8
+#define UPDATE_MESSAGE_FLAGS_ADD "UPDATE Messages SET modseq = IF(status = (status | ?), modseq, GREATEST(modseq, ?)), status = (status | ?) WHERE usernum = ? AND foldernum = ? AND modseq <= ? AND messagenum IN (" MESSAGE_BATCH_64 ")"
+#define UPDATE_MESSAGE_FLAGS_REMOVE "UPDATE Messages SET modseq = IF(status = ((status | ?) ^ ?), modseq, GREATEST(modseq, ?)), status = ((status | ?) ^ ?) WHERE usernum = ? AND foldernum = ? AND modseq <= ? AND messagenum IN (" MESSAGE_BATCH_64 ")"
+#define UPDATE_MESSAGE_FLAGS_REPLACE  "UPDATE Messages SET modseq = IF(status = (((status | ?) ^ ?) | ?), modseq, GREATEST(modseq, ?)), status = (((status | ?) ^ ?) | ?) WHERE usernum = ? AND foldernum = ? AND modseq <= ? AND messagenum IN (" MESSAGE_BATCH_64 ")"
+#define SELECT_MESSAGES_MODIFIED "SELECT messagenum FROM Messages WHERE usernum = ? AND foldernum = ? AND modseq > ? AND messagenum IN (" MESSAGE_BATCH_64 ") ORDER BY messagenum FOR UPDATE"
+#define UPDATE_MESSAGE_FOLDER "UPDATE Messages SET foldernum = ?, modseq = ? WHERE messagenum = ? AND usernum = ? AND foldernum = ?"
+#define INSERT_MESSAGE "INSERT INTO Messages (usernum, foldernum, server, status, size, signum, sigkey, modseq, created) VALUES (?, ?, ?, ?, ?, ?, ?, ?, NOW())"
+#define INSERT_MESSAGE_DUPLICATE "INSERT INTO Messages (usernum, foldernum, server, status, size, signum, sigkey, modseq, created) VALUES (?, ?, ?, ?, ?, ?, ?, ?, FROM_UNIXTIME(?))"
 #define DELETE_MESSAGE "DELETE FROM Messages WHERE messagenum = ? AND usernum = ?"
+#define DELETE_MESSAGES "DELETE FROM Messages WHERE usernum = ? AND messagenum IN (" MESSAGE_BATCH_64 ")"
 
 // Message Tags table
 #define SELECT_ALL_MESSAGE_TAGS "SELECT DISTINCT tag from Message_Tags LEFT JOIN Messages ON Message_Tags.messagenum = Messages.messagenum"
@@ -185,6 +194,8 @@
 											UPDATE_USER_STORAGE_KEYS, \
 											UPDATE_USER_QUOTA_ADD, \
 											UPDATE_USER_QUOTA_SUBTRACT, \
+											SELECT_USER_MODSEQ, \
+											UPDATE_USER_MODSEQ, \
 											SELECT_MAILBOX_ALIASES, \
 											SELECT_ALERTS, \
 											UPDATE_ALERTS_ACKNOWLEDGE, \
@@ -201,10 +212,12 @@
 											UPDATE_MESSAGE_FLAGS_ADD, \
 											UPDATE_MESSAGE_FLAGS_REMOVE, \
 											UPDATE_MESSAGE_FLAGS_REPLACE, \
+											SELECT_MESSAGES_MODIFIED, \
 											UPDATE_MESSAGE_FOLDER, \
 											INSERT_MESSAGE, \
 											INSERT_MESSAGE_DUPLICATE, \
 											DELETE_MESSAGE, \
+											DELETE_MESSAGES, \
 											SELECT_ALL_MESSAGE_TAGS, \
 											DELETE_MESSAGE_TAGS, \
 											SELECT_MESSAGE_TAGS, \
@@ -289,6 +302,8 @@
 											**update_user_storage_keys, \
 											**update_user_quota_add, \
 											**update_user_quota_subtract, \
+											**select_user_modseq, \
+											**update_user_modseq, \
 											**select_mailbox_aliases, \
 											**select_alerts, \
 											**update_alerts_acknowledge, \
@@ -305,10 +320,12 @@
 											**update_message_flags_add, \
 											**update_message_flags_remove, \
 											**update_message_flags_replace, \
+											**select_messages_modified, \
 											**update_message_folder, \
 											**insert_message, \
 											**insert_message_duplicate, \
 											**delete_message, \
+											**delete_messages, \
 											**select_all_message_tags, \
 											**delete_message_tags, \
 											**select_message_tags, \
@@ -61,6 +61,7 @@ void imap_requeue(connection_t *con) {
 void imap_process(connection_t *con) {
 
 	int_t state;
+	mm_arena_t *previous;
 	command_t *command, client = { .function = NULL };
 
 	// If the connection indicates an error occurred, or the socket was closed by the client we send the connection to the logout function.
@@ -80,8 +81,12 @@ void imap_process(connection_t *con) {
 		return;
 	}
 
-	// Parse the line into its tag and command elements.
-	if ((state = imap_command_parser(con)) < 0) {
+	// Parse the line into its tag and command elements. The parsed strings are allocated from the connection arena.
+	previous = mm_arena_attach(con_arena(con));
+	state = imap_command_parser(con);
+	mm_arena_attach(previous);
+
+	if (state < 0) {
 
 		// Try to be helpful about the parsing error.
 		if (state == -1) {
@@ -116,11 +121,12 @@ void imap_process(connection_t *con) {
 		con->command = command;
 		con->protocol.spins = 0;
 
-		if (command->function == &imap_logout) {
+		// The logout command destroys the connection, and the idle command suspends it, so neither should be requeued automatically.
+		if (command->function == &imap_logout || command->function == &imap_idle) {
 			enqueue(command->function, con);
 		}
 		else {
-			requeue(command->function, &imap_requeue, con);
+			requeue(&con_command, &imap_requeue, con);
 		}
 	}
 	else {
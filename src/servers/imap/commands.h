@@ -23,6 +23,7 @@ command_t imap_commands[] = {
 	{	.string = "APPEND", .length = 6, .function = &imap_append},
 	{	.string = "CREATE", .length = 6, .function = &imap_create},
 	{	.string = "DELETE", .length = 6, .function = &imap_delete},
+	{	.string = "ENABLE", .length = 6, .function = &imap_enable},
 	{	.string = "RENAME", .length = 6, .function = &imap_rename},
 	{	.string = "SEARCH", .length = 6, .function = &imap_search},
 	{	.string = "SELECT", .length = 6, .function = &imap_select},
@@ -30,6 +31,7 @@ command_t imap_commands[] = {
 	{	.string = "STATUS", .length = 6, .function = &imap_status},
 	{	.string = "EXAMINE", .length = 7, .function = &imap_examine},
 	{	.string = "EXPUNGE", .length = 7, .function = &imap_expunge},
+	{	.string = "COMPRESS", .length = 8, .function = &imap_compress},
 	{	.string = "STARTTLS", .length = 8, .function = &imap_starttls},
 	{	.string = "SUBSCRIBE", .length = 9, .function = &imap_subscribe},
 	{	.string = "CAPABILITY", .length = 10, .function = &imap_capability},
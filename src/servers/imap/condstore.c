@@ -0,0 +1,128 @@
+
+/**
+ * @file /magma/servers/imap/condstore.c
+ *
+ * @brief	Functions used to implement the IMAP CONDSTORE and QRESYNC extensions (RFC 7162).
+ *
+ * @note	Every message carries the modification sequence assigned the last time its flags changed, or it was stored/moved. The
+ * 			sequences are allocated from a per-user counter, so a client which remembers the highest value it has seen can
+ * 			resynchronize a folder by asking for the messages which changed since, instead of fetching the flags for every message.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Parse the optional parameter list supplied with the SELECT and EXAMINE commands.
+ * @note	A QRESYNC parameter is only accepted if the extension was previously turned on using the ENABLE command.
+ * @param	con				the client connection issuing the command.
+ * @param	parameters		the parenthesized list of select parameters.
+ * @param	uidvalidity		a pointer to receive the UIDVALIDITY value supplied with the QRESYNC parameter, or 0 if none was supplied.
+ * @param	modseq			a pointer to receive the modification sequence supplied with the QRESYNC parameter.
+ * @param	known			a pointer to receive the optional list of UIDs already known to the client, or NULL if none was supplied.
+ * @return	-1 if the parameters are invalid, or 1 on success.
+ */
+int_t imap_select_parameters(connection_t *con, imap_arguments_t *parameters, uint64_t *uidvalidity, uint64_t *modseq, stringer_t **known) {
+
+	stringer_t *item;
+	imap_arguments_t *qresync;
+	size_t number, length;
+
+	*uidvalidity = *modseq = 0;
+	*known = NULL;
+
+	if (!parameters) {
+		return 1;
+	}
+
+	number = ar_length_get(parameters);
+
+	for (size_t i = 0; i < number; i++) {
+
+		if (imap_get_type_ar(parameters, i) == IMAP_ARGUMENT_TYPE_ARRAY || !(item = imap_get_st_ar(parameters, i))) {
+			return -1;
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("CONDSTORE", 9))) {
+			con->imap.condstore = 1;
+		}
+
+		// The QRESYNC parameter must be followed by a list holding the UIDVALIDITY, the last known modification sequence, and the optional known UIDs.
+		// We ignore the optional sequence match data, since our UIDs are always in ascending sequence order.
+		else if (!st_cmp_ci_eq(item, PLACER("QRESYNC", 7)) && con->imap.qresync == 1 && i + 1 < number && imap_get_type_ar(parameters, i + 1) == IMAP_ARGUMENT_TYPE_ARRAY) {
+
+			if (!(qresync = imap_get_ar_ar(parameters, ++i)) || (length = ar_length_get(qresync)) < 2 || length > 4 ||
+				imap_get_type_ar(qresync, 0) == IMAP_ARGUMENT_TYPE_ARRAY || imap_get_type_ar(qresync, 1) == IMAP_ARGUMENT_TYPE_ARRAY ||
+				!uint64_conv_st(imap_get_st_ar(qresync, 0), uidvalidity) || !uint64_conv_st(imap_get_st_ar(qresync, 1), modseq) ||
+				!*uidvalidity || !*modseq) {
+				return -1;
+			}
+			else if (length >= 3 && imap_get_type_ar(qresync, 2) != IMAP_ARGUMENT_TYPE_ARRAY) {
+
+				if (imap_valid_sequence(imap_get_st_ar(qresync, 2)) != 1) {
+					return -1;
+				}
+
+				*known = imap_get_st_ar(qresync, 2);
+			}
+
+		}
+		else {
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief	Output the untagged responses a QRESYNC client needs to resynchronize the folder it just opened.
+ * @note	The UIDs which have vanished are reported first, followed by the flags for every message changed since the provided modification sequence.
+ * @param	con			the client connection issuing the SELECT or EXAMINE command.
+ * @param	folder		the status of the folder being opened.
+ * @param	modseq		the last modification sequence known to the client.
+ * @param	known		the list of UIDs known to the client, or NULL to check every UID assigned so far.
+ * @return	This function returns no value.
+ */
+void imap_select_resync(connection_t *con, imap_folder_status_t *folder, uint64_t modseq, stringer_t *known) {
+
+	inx_cursor_t *cursor;
+	meta_message_t *active;
+	stringer_t *vanished = NULL;
+	imap_fetch_response_t *response;
+	inx_t *changed = NULL, *duplicate = NULL;
+	imap_fetch_dataitems_t items = { .uid = 1, .flags = 1, .modseq = 1 };
+
+	meta_user_rlock(con->imap.user);
+
+	if (con->imap.user->messages) {
+		vanished = imap_range_vanished(con->imap.user->messages, folder->foldernum, known);
+		changed = imap_narrow_changed(con->imap.user->messages, folder->foldernum, modseq);
+	}
+
+	// Create a deep copy so we can unlock the mailbox before the responses are streamed out.
+	if (changed) {
+		duplicate = imap_duplicate_messages(changed);
+		inx_free(changed);
+	}
+
+	meta_user_unlock(con->imap.user);
+
+	if (vanished) {
+		con_print(con, "* VANISHED (EARLIER) %.*s\r\n", st_length_int(vanished), st_char_get(vanished));
+		st_free(vanished);
+	}
+
+	if (duplicate && (cursor = inx_cursor_alloc(duplicate))) {
+
+		while (status() && con_status(con) >= 0 && (active = inx_cursor_value_next(cursor))) {
+			response = imap_fetch_message(con, active, &items);
+			imap_fetch_response_print(con, active->sequencenum, response);
+			imap_fetch_response_free(response);
+		}
+
+		inx_cursor_free(cursor);
+	}
+
+	inx_cleanup(duplicate);
+
+	return;
+}
@@ -40,14 +40,57 @@ void imap_fetch_free_items(imap_fetch_dataitems_t *items) {
 	return;
 }
 
+/**
+ * @brief	Parse the list of modifiers which may follow the data items supplied to the FETCH command.
+ * @note	The CHANGEDSINCE and VANISHED modifiers are defined by the CONDSTORE and QRESYNC extensions (RFC 7162). Since the
+ * 			CHANGEDSINCE modifier requires the modification sequence of every message, it implies the MODSEQ data item.
+ * @param	array	the parenthetical list which followed the data items.
+ * @param	items	the data items structure which will be updated to reflect the modifiers.
+ * @return	-1 if the modifiers are invalid, 0 if the list doesn't contain modifiers, or 1 if the modifiers were parsed successfully.
+ */
+int_t imap_parse_modifiers(imap_arguments_t *array, imap_fetch_dataitems_t *items) {
+
+	stringer_t *item;
+	size_t number, increment = 0;
+
+	if (!array || !items || !(number = ar_length_get(array)) || imap_get_type_ar(array, 0) == IMAP_ARGUMENT_TYPE_ARRAY) {
+		return 0;
+	}
+
+	// A list of modifiers will always start with a modifier name, so anything else is assumed to be a body section.
+	else if (!(item = imap_get_st_ar(array, 0)) || (st_cmp_ci_eq(item, PLACER("CHANGEDSINCE", 12)) && st_cmp_ci_eq(item, PLACER("VANISHED", 8)))) {
+		return 0;
+	}
+
+	while (increment < number) {
+
+		if (imap_get_type_ar(array, increment) == IMAP_ARGUMENT_TYPE_ARRAY || !(item = imap_get_st_ar(array, increment++))) {
+			return -1;
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("CHANGEDSINCE", 12)) && increment < number && imap_get_type_ar(array, increment) != IMAP_ARGUMENT_TYPE_ARRAY &&
+			uint64_conv_st(imap_get_st_ar(array, increment++), &(items->changedsince)) && items->changedsince) {
+			items->modseq = 1;
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("VANISHED", 8))) {
+			items->vanished = 1;
+		}
+		else {
+			return -1;
+		}
+
+	}
+
+	return 1;
+}
+
 // This function is used with the fetch command to find out what dataitems need to be output.
 imap_fetch_dataitems_t * imap_parse_dataitems(imap_arguments_t *arguments) {
 
-	int_t type;
+	int_t type, modifiers;
 	stringer_t *item = NULL;
 	imap_arguments_t *array = NULL;
 	imap_fetch_dataitems_t *output;
-	size_t number, increment;
+	size_t number, increment, total;
 
 	if (!arguments) {
 		log_error("Sanity check failed, passed a NULL parameter.");
@@ -59,6 +102,19 @@ imap_fetch_dataitems_t * imap_parse_dataitems(imap_arguments_t *arguments) {
 		return NULL;
 	}
 
+	// A trailing parenthetical list may hold fetch modifiers, as opposed to a body section, so check for them before parsing the items.
+	if ((total = ar_length_get(arguments)) > 2 && imap_get_type_ar(arguments, total - 1) == IMAP_ARGUMENT_TYPE_ARRAY) {
+
+		if ((modifiers = imap_parse_modifiers(imap_get_ar_ar(arguments, total - 1), output)) < 0) {
+			imap_fetch_free_items(output);
+			return NULL;
+		}
+		else if (modifiers == 1) {
+			total--;
+		}
+
+	}
+
 	// If its a array, find the length.
 	if ((type = imap_get_type_ar(arguments, 1)) == IMAP_ARGUMENT_TYPE_ARRAY) {
 		array = imap_get_ar_ar(arguments, 1);
@@ -67,7 +123,7 @@ imap_fetch_dataitems_t * imap_parse_dataitems(imap_arguments_t *arguments) {
 	}
 	else {
 		array = arguments;
-		number = ar_length_get(array);
+		number = total;
 		increment = 1;
 	}
 
@@ -96,6 +152,9 @@ imap_fetch_dataitems_t * imap_parse_dataitems(imap_arguments_t *arguments) {
 		else if (!st_cmp_ci_eq(item, PLACER("FLAGS", 5))) {
 			output->flags = 1;
 		}
+		else if (!st_cmp_ci_eq(item, PLACER("MODSEQ", 6))) {
+			output->modseq = 1;
+		}
 		else if (!st_cmp_ci_eq(item, PLACER("INTERNALDATE", 12))) {
 			output->internaldate = 1;
 		}
@@ -1078,6 +1137,15 @@ imap_fetch_response_t * imap_fetch_message(connection_t *con, meta_message_t *me
 		output = imap_fetch_response_add(output, PLACER("FLAGS", 5), value);
 	}
 
+	// Process the modification sequence. Once a client has enabled CONDSTORE, it gets the modification sequence whenever the flags are sent.
+	if (items->modseq == 1 || (con->imap.condstore == 1 && (items->flags == 1 || meta->updated == 1))) {
+		if (!(value = st_aprint_opts(MANAGED_T | HEAP | CONTIGUOUS, "(%lu)", meta->modseq))) {
+			imap_fetch_response_free(output);
+			return NULL;
+		}
+		output = imap_fetch_response_add(output, PLACER("MODSEQ", 6), value);
+	}
+
 	// Process the internal date.
 	if (items->internaldate == 1) {
 		ctime = meta->created;
@@ -1421,3 +1489,45 @@ inx_t * imap_narrow_messages(inx_t *messages, uint64_t selected, stringer_t *ran
 
 	return output;
 }
+
+/**
+ * @brief	Narrow a collection of messages down to those which have been modified since a client supplied modification sequence.
+ * @note	The result is a shallow copy, so it must be freed before the session lock protecting the messages is released.
+ * @param	messages	the collection of messages to be narrowed.
+ * @param	selected	the numerical id of the currently selected folder.
+ * @param	modseq		the modification sequence supplied by the client. Only messages with a larger modification sequence are returned.
+ * @return	NULL if no messages have changed, or an error occurs, otherwise an index holding the modified messages.
+ */
+inx_t * imap_narrow_changed(inx_t *messages, uint64_t selected, uint64_t modseq) {
+
+	inx_t *output;
+	inx_cursor_t *cursor;
+	meta_message_t *active;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	if (!messages || !(output = inx_alloc(M_INX_LINKED, NULL))) {
+		return NULL;
+	}
+
+	if ((cursor = inx_cursor_alloc(messages))) {
+
+		while ((active = inx_cursor_value_next(cursor))) {
+
+			if (active->foldernum == selected && active->modseq > modseq) {
+				key.val.u64 = active->messagenum;
+				inx_append(output, key, active);
+			}
+
+		}
+
+		inx_cursor_free(cursor);
+	}
+
+	// If no nodes were returned.
+	if (!inx_count(output)) {
+		inx_free(output);
+		return NULL;
+	}
+
+	return output;
+}
@@ -63,3 +63,76 @@ imap_fetch_response_t * imap_fetch_response_add(imap_fetch_response_t *response,
 
 	return response;
 }
+
+/**
+ * @brief	Write an untagged FETCH response for a single message to the client.
+ * @note	The UID is always output first, followed by the size, because some clients expect them in that order.
+ * @param	con			the client connection which will receive the response.
+ * @param	sequencenum	the sequence number of the message being described.
+ * @param	response	the list of fetch items, and values, generated for the message.
+ * @return	This function returns no value.
+ */
+void imap_fetch_response_print(connection_t *con, uint64_t sequencenum, imap_fetch_response_t *response) {
+
+	int_t space = 0;
+	imap_fetch_response_t *iterate = response;
+
+	// Output the response.
+	con_print(con, "* %lu FETCH (", sequencenum);
+
+	// Output the UID first.
+	while (iterate != NULL) {
+
+		if (!st_cmp_cs_eq(iterate->key, PLACER("UID", 3))) {
+			con_write_st(con, iterate->key);
+			con_write_bl(con, " ", 1);
+			con_write_st(con, iterate->value);
+			iterate = NULL;
+			space = 1;
+		}
+		else {
+			iterate = (imap_fetch_response_t *)iterate->next;
+		}
+	}
+
+	// Now output the size, if it is present.
+	iterate = response;
+	while (iterate != NULL) {
+		if (!st_cmp_cs_eq(iterate->key, PLACER("RFC822.SIZE", 11))) {
+			if (space == 1) {
+				con_write_bl(con, " ", 1);
+			}
+			else {
+				space = 1;
+			}
+			con_write_st(con, iterate->key);
+			con_write_bl(con, " ", 1);
+			con_write_st(con, iterate->value);
+			iterate = NULL;
+		}
+		else {
+			iterate = (imap_fetch_response_t *)iterate->next;
+		}
+	}
+
+	// Output the rest of the items.
+	iterate = response;
+	while (iterate != NULL) {
+		if (st_cmp_cs_eq(iterate->key, PLACER("UID", 3)) && st_cmp_cs_eq(iterate->key, PLACER("RFC822.SIZE", 11))) {
+			if (space == 1) {
+				con_write_bl(con, " ", 1);
+			}
+			else {
+				space = 1;
+			}
+			con_write_st(con, iterate->key);
+			con_write_bl(con, " ", 1);
+			con_write_st(con, iterate->value);
+		}
+		iterate = (imap_fetch_response_t *)iterate->next;
+	}
+
+	con_write_bl(con, ")\r\n", 3);
+
+	return;
+}
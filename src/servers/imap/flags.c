@@ -109,8 +109,9 @@ uint32_t imap_flag_parse(void *ptr, int_t type) {
 	return flags;
 }
 
-void imap_update_flags(meta_user_t *user, inx_t *messages, uint64_t foldernum, int_t action, uint32_t flags) {
+bool_t imap_update_flags(meta_user_t *user, inx_t *messages, uint64_t foldernum, int_t action, uint32_t flags, meta_condition_t *condition) {
 
+	bool_t result;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
 
@@ -118,22 +119,27 @@ void imap_update_flags(meta_user_t *user, inx_t *messages, uint64_t foldernum, i
 
 	if (user == NULL || messages == NULL || foldernum == 0 || action == 0 || flags == 0) {
 		log_error("Sanity check failed, passed an invalid parameter.");
-		return;
+		return false;
 	}
 
-	// Update the database first.
+	// Update the database first. For a conditional update, the messages which were refused are removed from the collection.
 	if ((action & IMAP_FLAG_ADD) == IMAP_FLAG_ADD) {
-		meta_data_flags_add(messages, user->usernum, foldernum, flags);
+		result = meta_data_flags_add(messages, user->usernum, foldernum, flags, condition);
 	}
 	else if ((action & IMAP_FLAG_REMOVE) == IMAP_FLAG_REMOVE) {
-		meta_data_flags_remove(messages, user->usernum, foldernum, flags);
+		result = meta_data_flags_remove(messages, user->usernum, foldernum, flags, condition);
 	}
 	else if ((action & IMAP_FLAG_REPLACE) == IMAP_FLAG_REPLACE) {
-		meta_data_flags_replace(messages, user->usernum, foldernum, flags);
+		result = meta_data_flags_replace(messages, user->usernum, foldernum, flags, condition);
 	}
 	else {
 		log_error("Invalid flag update action.");
-		return;
+		return false;
+	}
+
+	// If the database update failed, we don't know which messages were changed, so the session data is left alone.
+	if (!result) {
+		return false;
 	}
 
 	// Update the messages structure.
@@ -155,5 +161,5 @@ void imap_update_flags(meta_user_t *user, inx_t *messages, uint64_t foldernum, i
 		inx_cursor_free(cursor);
 	}
 
-	return;
+	return true;
 }
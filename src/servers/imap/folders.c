@@ -413,8 +413,6 @@ int_t imap_folder_remove(uint64_t usernum, inx_t *folders, inx_t *messages, stri
 
 	placer_t fragment;
 	meta_folder_t *active;
-	inx_cursor_t *cursor;
-	meta_message_t *message;
 	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
 
 	if (!folders || !name || !usernum) {
@@ -440,19 +438,7 @@ int_t imap_folder_remove(uint64_t usernum, inx_t *folders, inx_t *messages, stri
 	}
 
 	// Delete all of the messages in this folder.
-	if ((cursor = inx_cursor_alloc(messages))) {
-
-		while ((message = inx_cursor_value_next(cursor))) {
-
-			if (message->foldernum == active->foldernum && mail_remove_message(usernum, message->messagenum, message->size, message->server)) {
-				key.val.u64 = message->messagenum;
-				inx_delete(messages, key);
-			}
-
-		}
-
-		inx_cursor_free(cursor);
-	}
+	imap_message_expunge_bulk(usernum, messages, active->foldernum, 0, NULL, NULL);
 
 	// If the folder has children, don't delete it.
 	if (!meta_folders_children(folders, active->foldernum)) {
@@ -710,6 +696,10 @@ int_t imap_folder_status(inx_t *folders, inx_t *messages, stringer_t *name, imap
 			if (message->foldernum == folder->foldernum) {
 				status->messages++;
 
+				if (message->modseq > status->highestmodseq) {
+					status->highestmodseq = message->modseq;
+				}
+
 				if ((message->status & MAIL_STATUS_RECENT) == MAIL_STATUS_RECENT) {
 					status->recent++;
 				}
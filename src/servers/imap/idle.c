@@ -0,0 +1,464 @@
+
+/**
+ * @file /magma/servers/imap/idle.c
+ *
+ * @brief	Functions used to implement the IMAP IDLE command (RFC 2177) without tying up a worker thread.
+ *
+ * @note	Sessions which issue the IDLE command are suspended and their socket descriptor is handed to a single monitor thread
+ * 			which waits on them using epoll. A session is queued for processing again when the client sends data, when the local
+ * 			notification hub announces a change to one of the user's objects, when the cached serial numbers need to be checked for
+ * 			changes made by other cluster nodes, or when the session expires.
+ */
+
+#include "magma.h"
+
+typedef struct {
+	connection_t *con;
+	notify_listener_t *listener;
+	uint32_t state, events;
+	time_t started, checked;
+} imap_idle_t;
+
+struct {
+	int epoll;
+	bool_t active;
+	pthread_t *thread;
+	pthread_mutex_t lock;
+	inx_t *sessions;
+} idlers = {
+	.epoll = -1,
+	.active = false,
+	.thread = NULL,
+	.sessions = NULL
+};
+
+/**
+ * @brief	Flag an idle session with one or more events and if the session is currently suspended, queue it for processing.
+ * @note	The caller must be holding the idle session lock.
+ * @param	idle	a pointer to the idle session that should be signaled.
+ * @param	events	a bitmask of the IMAP_IDLE_EVENT values to be recorded.
+ * @return	This function returns no value.
+ */
+void imap_idle_signal(imap_idle_t *idle, uint32_t events) {
+
+	idle->events |= events;
+
+	// If a worker already owns the session, it will notice the new events before suspending the session again.
+	if (idle->state == IMAP_IDLE_STATE_SUSPENDED) {
+		idle->state = IMAP_IDLE_STATE_ACTIVE;
+		enqueue(&imap_idle_wake, idle->con);
+	}
+
+	return;
+}
+
+/**
+ * @brief	The notification hub callback used to wake idle sessions when one of the user's objects is modified locally.
+ * @param	data		a pointer to the idle session which registered the listener.
+ * @param	usernum		the numerical id of the user whose object was modified.
+ * @param	object		the type of object that was modified.
+ * @return	This function returns no value.
+ */
+void imap_idle_listener(void *data, uint64_t usernum, uint64_t object) {
+
+	// Contacts, aliases and configuration changes aren't visible to IMAP clients.
+	if (object != OBJECT_USER && object != OBJECT_FOLDERS && object != OBJECT_MESSAGES) {
+		return;
+	}
+
+	mutex_lock(&idlers.lock);
+	imap_idle_signal(data, IMAP_IDLE_EVENT_NOTIFY);
+	mutex_unlock(&idlers.lock);
+
+	stats_increment_by_name("imap.idle.notified");
+
+	return;
+}
+
+/**
+ * @brief	Suspend an idle session by handing its socket descriptor over to the monitor thread.
+ * @note	The caller must own the session. If any events were recorded while the session was being processed, or the monitor is
+ * 			shutting down, the session is queued for processing again instead.
+ * @param	idle	a pointer to the idle session that should be suspended.
+ * @return	This function returns no value.
+ */
+void imap_idle_suspend(imap_idle_t *idle) {
+
+	struct epoll_event event;
+
+	mm_wipe(&event, sizeof(struct epoll_event));
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	event.data.fd = idle->con->network.sockd;
+
+	mutex_lock(&idlers.lock);
+
+	if (!idlers.active || !status()) {
+		idle->events |= IMAP_IDLE_EVENT_SHUTDOWN;
+	}
+
+	// The descriptor is registered using one shot mode, so it needs to be rearmed every time the session is suspended.
+	if (!idle->events && epoll_ctl(idlers.epoll, EPOLL_CTL_MOD, event.data.fd, &event) == -1 &&
+		(errno != ENOENT || epoll_ctl(idlers.epoll, EPOLL_CTL_ADD, event.data.fd, &event) == -1)) {
+		log_pedantic("Unable to suspend the idle session. { sockd = %i / error = %s }", event.data.fd, errno_string(errno, MEMORYBUF(1024), 1024));
+		idle->events |= IMAP_IDLE_EVENT_SHUTDOWN;
+	}
+
+	if (idle->events) {
+		enqueue(&imap_idle_wake, idle->con);
+	}
+	else {
+		idle->state = IMAP_IDLE_STATE_SUSPENDED;
+	}
+
+	mutex_unlock(&idlers.lock);
+
+	return;
+}
+
+/**
+ * @brief	Remove an idle session from the notification hub and the monitor, and then free it.
+ * @note	The caller must own the session.
+ * @param	idle	a pointer to the idle session being released.
+ * @return	This function returns no value.
+ */
+void imap_idle_release(imap_idle_t *idle) {
+
+	struct epoll_event event;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = idle->con->network.sockd };
+
+	// Once the listener has been removed, the hub will never signal the session again.
+	notify_unsubscribe(idle->listener);
+	idle->listener = NULL;
+
+	mutex_lock(&idlers.lock);
+
+	// Older kernels require a non-NULL event pointer, even though it's ignored.
+	mm_wipe(&event, sizeof(struct epoll_event));
+	epoll_ctl(idlers.epoll, EPOLL_CTL_DEL, idle->con->network.sockd, &event);
+	inx_delete(idlers.sessions, key);
+
+	mutex_unlock(&idlers.lock);
+
+	stats_decrement_by_name("imap.idle.sessions");
+
+	return;
+}
+
+/**
+ * @brief	Process the events recorded for an idle session, and then suspend it again, or end the IDLE command.
+ * @note	This function is executed by a worker thread after the monitor, or the notification hub, signals the session.
+ * @param	con		a pointer to the connection object of the idle session.
+ * @return	This function returns no value.
+ */
+void imap_idle_wake(connection_t *con) {
+
+	size_t length;
+	chr_t *line;
+	uint32_t events = 0;
+	imap_idle_t *idle;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = con->network.sockd };
+
+	mutex_lock(&idlers.lock);
+
+	if ((idle = inx_find(idlers.sessions, key))) {
+		events = idle->events;
+		idle->events = 0;
+	}
+
+	mutex_unlock(&idlers.lock);
+
+	if (!idle) {
+		log_pedantic("An idle session was queued for processing, but could not be found. { sockd = %i }", con->network.sockd);
+		imap_requeue(con);
+		return;
+	}
+
+	// The server is shutting down.
+	if ((events & IMAP_IDLE_EVENT_SHUTDOWN) == IMAP_IDLE_EVENT_SHUTDOWN) {
+		imap_idle_release(idle);
+		enqueue(&imap_logout, con);
+		return;
+	}
+
+	// RFC 3501 allows a server to disconnect clients after 30 minutes of inactivity, and RFC 2177 extends that to idle clients.
+	else if ((events & IMAP_IDLE_EVENT_EXPIRED) == IMAP_IDLE_EVENT_EXPIRED) {
+		imap_idle_release(idle);
+		con_write_bl(con, "* BYE The session has been idle for too long. Goodbye.\r\n", 56);
+		con_destroy(con);
+		return;
+	}
+
+	// Something changed, either locally or on another cluster node, so tell the client about the new mailbox state.
+	if ((events & (IMAP_IDLE_EVENT_NOTIFY | IMAP_IDLE_EVENT_CHECK)) && con->imap.selected != 0 && con->imap.user && imap_session_update(con) == 1) {
+		con_print(con, "* %lu EXISTS\r\n* %lu RECENT\r\n", con->imap.messages_total, con->imap.messages_recent);
+	}
+
+	if ((events & (IMAP_IDLE_EVENT_NOTIFY | IMAP_IDLE_EVENT_CHECK))) {
+		mutex_lock(&idlers.lock);
+		idle->checked = time(NULL);
+		mutex_unlock(&idlers.lock);
+	}
+
+	// The client sent data, which should be the DONE continuation. Since the socket is readable, this won't block for long.
+	if ((events & IMAP_IDLE_EVENT_READ) == IMAP_IDLE_EVENT_READ) {
+
+		imap_idle_release(idle);
+
+		if (con_read_line(con, true) < 0) {
+			enqueue(&imap_logout, con);
+			return;
+		}
+
+		// Ignore the line terminator.
+		line = pl_char_get(con->network.line);
+		length = pl_length_get(con->network.line);
+
+		while (length && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+			length--;
+		}
+
+		if (length == 4 && !st_cmp_ci_eq(PLACER(line, 4), PLACER("DONE", 4))) {
+			con_print(con, "%.*s OK IDLE Completed.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		}
+		else {
+			con_print(con, "%.*s BAD IDLE Terminated. Expected DONE.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+			con->protocol.violations++;
+		}
+
+		imap_requeue(con);
+		return;
+	}
+
+	// A failed write will leave the connection in an error state.
+	else if (con_status(con) < 0) {
+		imap_idle_release(idle);
+		enqueue(&imap_logout, con);
+		return;
+	}
+
+	imap_idle_suspend(idle);
+
+	return;
+}
+
+/**
+ * @brief	Respond to an IMAP IDLE command by suspending the session until the client sends DONE.
+ * @note	The command dispatcher doesn't requeue IDLE sessions, so every code path in here must either requeue or suspend the session.
+ * @param	con		a pointer to the connection object of the session issuing the command.
+ * @return	This function returns no value.
+ */
+void imap_idle(connection_t *con) {
+
+	imap_idle_t *idle;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = con->network.sockd };
+
+	if (con->imap.session_state != 1) {
+		con_print(con, "%.*s BAD The IDLE command is not available until you are authenticated.\r\n", st_length_int(con->imap.tag),
+			st_char_get(con->imap.tag));
+		imap_requeue(con);
+		return;
+	}
+	else if (con->imap.arguments) {
+		con_print(con, "%.*s BAD The IDLE command does not accept any arguments.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		imap_requeue(con);
+		return;
+	}
+	else if (!idlers.active || !(idle = mm_alloc(sizeof(imap_idle_t)))) {
+		con_print(con, "%.*s NO IDLE Failed. The server is unable to accept idle sessions right now.\r\n", st_length_int(con->imap.tag),
+			st_char_get(con->imap.tag));
+		imap_requeue(con);
+		return;
+	}
+
+	// Until the session is suspended, it remains active, so any events that arrive are simply recorded.
+	idle->con = con;
+	idle->state = IMAP_IDLE_STATE_ACTIVE;
+	idle->started = idle->checked = time(NULL);
+
+	mutex_lock(&idlers.lock);
+
+	if (!inx_insert(idlers.sessions, key, idle)) {
+		mutex_unlock(&idlers.lock);
+		con_print(con, "%.*s NO IDLE Failed. The server is unable to accept idle sessions right now.\r\n", st_length_int(con->imap.tag),
+			st_char_get(con->imap.tag));
+		mm_free(idle);
+		imap_requeue(con);
+		return;
+	}
+
+	mutex_unlock(&idlers.lock);
+	stats_increment_by_name("imap.idle.sessions");
+
+	// Without a listener we rely entirely on the periodic serial number check, which is slower, but still correct.
+	if (!(idle->listener = notify_subscribe(con->imap.usernum, &imap_idle_listener, idle))) {
+		log_pedantic("Unable to register the idle session with the notification hub. { usernum = %lu }", con->imap.usernum);
+	}
+
+	con_write_bl(con, "+ idling\r\n", 10);
+
+	// Report any changes which occurred before the client started idling.
+	if (con->imap.selected != 0 && con->imap.user && imap_session_update(con) == 1) {
+		con_print(con, "* %lu EXISTS\r\n* %lu RECENT\r\n", con->imap.messages_total, con->imap.messages_recent);
+	}
+
+	// If the client pipelined the DONE continuation, it may already be sitting in the connection buffer, the stream filters,
+	// or the TLS buffer, where the monitor won't see it.
+	if ((pl_length_get(con->network.line) && st_length_get(con->network.buffer) > pl_length_get(con->network.line)) ||
+		con_filter_pending(con) > 0 || tls_pending(con->network.tls) > 0) {
+		mutex_lock(&idlers.lock);
+		idle->events |= IMAP_IDLE_EVENT_READ;
+		mutex_unlock(&idlers.lock);
+	}
+
+	imap_idle_suspend(idle);
+
+	return;
+}
+
+/**
+ * @brief	The entry point for the idle monitor thread, which waits for suspended sessions to become readable, and periodically
+ * 			queues them for a serial number check, or expires them.
+ * @return	This function returns no value.
+ */
+void imap_idle_monitor(void) {
+
+	int count;
+	imap_idle_t *idle;
+	time_t now, last = 0;
+	inx_cursor_t *cursor;
+	struct epoll_event events[IMAP_IDLE_EVENTS_LIMIT];
+	multi_t key = { .type = M_TYPE_UINT64 };
+
+	thread_start();
+
+	while (idlers.active && status()) {
+
+		if ((count = epoll_wait(idlers.epoll, events, IMAP_IDLE_EVENTS_LIMIT, 1000)) == -1 && errno != EINTR) {
+			log_pedantic("The idle monitor was unable to wait for network events. { error = %s }", errno_string(errno, MEMORYBUF(1024), 1024));
+			sleep(1);
+		}
+
+		mutex_lock(&idlers.lock);
+
+		for (int i = 0; i < count; i++) {
+			key.val.u64 = events[i].data.fd;
+
+			if ((idle = inx_find(idlers.sessions, key))) {
+				imap_idle_signal(idle, IMAP_IDLE_EVENT_READ);
+			}
+		}
+
+		// Once a second, look for sessions which have expired, or which are due for a serial number check. Changes made by other cluster
+		// nodes aren't published by the local notification hub, so the cached serial numbers are the only way to detect them.
+		if ((now = time(NULL)) != last && (cursor = inx_cursor_alloc(idlers.sessions))) {
+
+			while ((idle = inx_cursor_value_next(cursor))) {
+
+				if (idle->state == IMAP_IDLE_STATE_SUSPENDED && difftime(now, idle->started) >= magma.imap.idle.timeout) {
+					imap_idle_signal(idle, IMAP_IDLE_EVENT_EXPIRED);
+				}
+				else if (idle->state == IMAP_IDLE_STATE_SUSPENDED && difftime(now, idle->checked) >= magma.imap.idle.interval) {
+					imap_idle_signal(idle, IMAP_IDLE_EVENT_CHECK);
+				}
+
+			}
+
+			inx_cursor_free(cursor);
+			last = now;
+		}
+
+		mutex_unlock(&idlers.lock);
+	}
+
+	// Queue every remaining session so they get logged out while the worker threads are still available.
+	mutex_lock(&idlers.lock);
+
+	if ((cursor = inx_cursor_alloc(idlers.sessions))) {
+
+		while ((idle = inx_cursor_value_next(cursor))) {
+			imap_idle_signal(idle, IMAP_IDLE_EVENT_SHUTDOWN);
+		}
+
+		inx_cursor_free(cursor);
+	}
+
+	mutex_unlock(&idlers.lock);
+
+	thread_stop();
+	pthread_exit(NULL);
+	return;
+}
+
+/**
+ * @brief	Initialize the idle session index and launch the idle monitor thread.
+ * @note	The monitor queues work for the worker threads, so it must be started after the thread pool, and stopped before it.
+ * @return	true on success or false on failure.
+ */
+bool_t imap_idle_start(void) {
+
+	if (mutex_init(&idlers.lock, NULL)) {
+		log_critical("Unable to initialize the idle session lock.");
+		return false;
+	}
+
+	// The index entries are freed automatically when the sessions are released.
+	else if (!(idlers.sessions = inx_alloc(M_INX_TREE | M_INX_LOCK_MANUAL, &mm_free))) {
+		log_critical("Unable to initialize the idle session index.");
+		return false;
+	}
+
+	else if ((idlers.epoll = epoll_create(IMAP_IDLE_EVENTS_LIMIT)) == -1) {
+		log_critical("The epoll_create() call returned an error. { error = %s }", errno_string(errno, MEMORYBUF(1024), 1024));
+		return false;
+	}
+
+	idlers.active = true;
+
+	if (!(idlers.thread = mm_alloc(sizeof(pthread_t))) || thread_launch(idlers.thread, &imap_idle_monitor, NULL)) {
+		log_critical("Unable to launch the idle monitor thread.");
+		mm_cleanup(idlers.thread);
+		idlers.thread = NULL;
+		idlers.active = false;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Stop the idle monitor thread, and wait for the worker threads to log out any remaining idle sessions.
+ * @return	This function returns no value.
+ */
+void imap_idle_stop(void) {
+
+	int_t counter = 0;
+
+	idlers.active = false;
+
+	if (idlers.thread) {
+		thread_join(*(idlers.thread));
+		mm_free(idlers.thread);
+		idlers.thread = NULL;
+	}
+
+	// The worker threads release the sessions that were queued by the monitor on its way out. Give them a few seconds.
+	while (idlers.sessions && inx_count(idlers.sessions) && counter++ < 1000) {
+		usleep(10000);
+	}
+
+	if (idlers.sessions && inx_count(idlers.sessions)) {
+		log_info("Unable to release all of the idle sessions before shutdown. { remaining = %lu }", inx_count(idlers.sessions));
+		return;
+	}
+
+	if (idlers.epoll != -1) {
+		close(idlers.epoll);
+		idlers.epoll = -1;
+	}
+
+	inx_cleanup(idlers.sessions);
+	idlers.sessions = NULL;
+	mutex_destroy(&idlers.lock);
+
+	return;
+}
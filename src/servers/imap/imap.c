@@ -45,6 +45,7 @@ void imap_starttls(connection_t *con) {
 	}
 
 	// Clear the input buffer. A shorthand session reset.
+	con_offload(con);
 	stats_increment_by_name("imap.connections.secure");
 	st_length_set(con->network.buffer, 0);
 	con->network.line = pl_null();
@@ -53,6 +54,50 @@ void imap_starttls(connection_t *con) {
 	return;
 }
 
+/**
+ * @brief	Enable compression for the remainder of the session, as described by RFC 4978.
+ * @note	The tagged response is sent uncompressed, and everything which follows it, in both directions, is compressed using the raw
+ * 			DEFLATE format. The compression filter sits below the protocol layer, and above the TLS layer, if the connection is secure.
+ * @param	con		a pointer to the client connection that issued the command.
+ * @return	This function returns no value.
+ */
+void imap_compress(connection_t *con) {
+
+	// Check for the right state.
+	if (con->imap.session_state != 1) {
+		con_print(con, "%.*s BAD The COMPRESS command is not available until you are authenticated.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
+	// Input validation. Requires a single string argument, and DEFLATE is the only algorithm we support.
+	else if (ar_length_get(con->imap.arguments) != 1 || imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY ||
+		st_cmp_ci_eq(imap_get_st_ar(con->imap.arguments, 0), PLACER("DEFLATE", 7))) {
+		con_print(con, "%.*s BAD The COMPRESS command requires the DEFLATE algorithm as an argument.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
+	else if (con->imap.compressed == 1) {
+		con_print(con, "%.*s NO [COMPRESSIONACTIVE] Compression is already active for this session.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
+	con_print(con, "%.*s OK DEFLATE active.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+
+	// Once the response has been sent, we can't fall back to an uncompressed session, so if the filter fails we have to drop the connection.
+	if (!con_deflate_start(con, magma.imap.compress.level, magma.imap.compress.window)) {
+		log_pedantic("Unable to start compressing the IMAP session.");
+		con->network.status = -1;
+		return;
+	}
+
+	// The client isn't allowed to send anything else until it sees our response, so any buffered data can be discarded.
+	st_length_set(con->network.buffer, 0);
+	con->network.line = pl_null();
+	con->imap.compressed = 1;
+
+	return;
+}
+
 /**
  * @brief	Respond to an invalid IMAP command from a client.
  *
@@ -678,7 +723,10 @@ void imap_status(connection_t *con) {
 
 	// Get the folder status.
 	meta_user_rlock(con->imap.user);
-	state = imap_folder_status(con->imap.user->folders, con->imap.user->messages, imap_get_st_ar(con->imap.arguments, 0), &status);
+	if ((state = imap_folder_status(con->imap.user->folders, con->imap.user->messages, imap_get_st_ar(con->imap.arguments, 0), &status)) == 1 &&
+		con->imap.user->modseq > status.highestmodseq) {
+		status.highestmodseq = con->imap.user->modseq;
+	}
 	meta_user_unlock(con->imap.user);
 
 	// Figure out what to output.
@@ -710,6 +758,11 @@ void imap_status(connection_t *con) {
 				snprintf(buffer, 128, "%sUIDVALIDITY %lu", (output == NULL ? "" : " "), status.foldernum);
 				output = st_append_opts(1024, output, NULLER(buffer));
 			}
+			else if (!st_cmp_ci_eq(imap_get_st_ar(values, i), PLACER("HIGHESTMODSEQ", 13))) {
+				snprintf(buffer, 128, "%sHIGHESTMODSEQ %lu", (output == NULL ? "" : " "), status.highestmodseq);
+				output = st_append_opts(1024, output, NULLER(buffer));
+				con->imap.condstore = 1;
+			}
 			// Unrecognized item requested.
 			else {
 				con_print(con, "%.*s BAD Invalid data item requested via the status command.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
@@ -803,6 +856,8 @@ void imap_examine(connection_t *con) {
 
 	int_t state;
 	chr_t buffer[128];
+	stringer_t *known;
+	uint64_t uidvalidity, modseq;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
 	imap_folder_status_t status;
@@ -813,12 +868,19 @@ void imap_examine(connection_t *con) {
 		return;
 	}
 
-	// Input validation. Requires one string argument, which cannot be NULL.
-	if (ar_length_get(con->imap.arguments) != 1 || imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY) {
+	// Input validation. Requires one string argument, which cannot be NULL, and an optional list of parameters.
+	if (ar_length_get(con->imap.arguments) < 1 || ar_length_get(con->imap.arguments) > 2 || imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY ||
+		(ar_length_get(con->imap.arguments) == 2 && imap_get_type_ar(con->imap.arguments, 1) != IMAP_ARGUMENT_TYPE_ARRAY)) {
 		con_print(con, "%.*s BAD The examine command requires a string argument.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		return;
 	}
 
+	// Parse the CONDSTORE and QRESYNC parameters.
+	else if (imap_select_parameters(con, ar_length_get(con->imap.arguments) == 2 ? imap_get_ar_ar(con->imap.arguments, 1) : NULL, &uidvalidity, &modseq, &known) != 1) {
+		con_print(con, "%.*s BAD Invalid parameters were provided to the examine command.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
 	// If a folder was previously selected, clear the recent flag before closing the mailbox.
 	if (con->imap.selected != 0 && con->imap.read_only == 0) {
 		meta_user_wlock(con->imap.user);
@@ -836,7 +898,10 @@ void imap_examine(connection_t *con) {
 
 	// Get the folder status.
 	meta_user_rlock(con->imap.user);
-	state = imap_folder_status(con->imap.user->folders, con->imap.user->messages, imap_get_st_ar(con->imap.arguments, 0), &status);
+	if ((state = imap_folder_status(con->imap.user->folders, con->imap.user->messages, imap_get_st_ar(con->imap.arguments, 0), &status)) == 1 &&
+		con->imap.user->modseq > status.highestmodseq) {
+		status.highestmodseq = con->imap.user->modseq;
+	}
 	meta_user_unlock(con->imap.user);
 
 	if (state == 1) {
@@ -848,10 +913,15 @@ void imap_examine(connection_t *con) {
 		// Some clients expect the flags line to come first.
 		con_print(con, "* FLAGS (\\Answered \\Flagged \\Deleted \\Seen \\Draft \\Recent)\r\n" \
 			"* OK [PERMANENTFLAGS (\\Answered \\Flagged \\Deleted \\Seen \\Draft)]\r\n" \
-			"* %lu EXISTS\r\n* %lu RECENT\r\n%s* OK [UIDVALIDITY %lu]\r\n* OK [UIDNEXT %lu]\r\n" \
-			"%.*s OK EXAMINE [READ-ONLY] Complete.\r\n",
-			status.messages, status.recent, (status.first != 0 ? buffer : ""), status.foldernum, status.uidnext,
-			st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+			"* %lu EXISTS\r\n* %lu RECENT\r\n%s* OK [UIDVALIDITY %lu]\r\n* OK [UIDNEXT %lu]\r\n* OK [HIGHESTMODSEQ %lu]\r\n",
+			status.messages, status.recent, (status.first != 0 ? buffer : ""), status.foldernum, status.uidnext, status.highestmodseq);
+
+		// If the client is resynchronizing the same folder it saw previously, output the changes it missed.
+		if (uidvalidity && uidvalidity == status.foldernum) {
+			imap_select_resync(con, &status, modseq, known);
+		}
+
+		con_print(con, "%.*s OK EXAMINE [READ-ONLY] Complete.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		con->imap.messages_total = status.messages;
 		con->imap.messages_recent = status.recent;
 		con->imap.selected = status.foldernum;
@@ -874,6 +944,8 @@ void imap_select(connection_t *con) {
 
 	int_t state;
 	chr_t buffer[128];
+	stringer_t *known;
+	uint64_t uidvalidity, modseq;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
 	imap_folder_status_t status;
@@ -885,13 +957,21 @@ void imap_select(connection_t *con) {
 		return;
 	}
 
-	// Input validation. Requires one string argument, which cannot be NULL.
-	if (ar_length_get(con->imap.arguments) != 1 || imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY) {
+	// Input validation. Requires one string argument, which cannot be NULL, and an optional list of parameters.
+	if (ar_length_get(con->imap.arguments) < 1 || ar_length_get(con->imap.arguments) > 2 || imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY ||
+		(ar_length_get(con->imap.arguments) == 2 && imap_get_type_ar(con->imap.arguments, 1) != IMAP_ARGUMENT_TYPE_ARRAY)) {
 
 		con_print(con, "%.*s BAD The select command requires a string argument.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		return;
 	}
 
+	// Parse the CONDSTORE and QRESYNC parameters.
+	else if (imap_select_parameters(con, ar_length_get(con->imap.arguments) == 2 ? imap_get_ar_ar(con->imap.arguments, 1) : NULL, &uidvalidity, &modseq, &known) != 1) {
+
+		con_print(con, "%.*s BAD Invalid parameters were provided to the select command.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
 	// If a folder was previously selected, clear the recent flag before closing the mailbox.
 	if (con->imap.selected != 0 && con->imap.read_only == 0) {
 		meta_user_wlock(con->imap.user);
@@ -913,7 +993,12 @@ void imap_select(connection_t *con) {
 	if ((state = imap_folder_status(con->imap.user->folders, con->imap.user->messages, imap_get_st_ar(con->imap.arguments, 0), &status)) == 1) {
 
 		// Now that this folder has been opened, remove the recent flag in the database.
-		meta_data_flags_remove(con->imap.user->messages, con->imap.user->usernum, status.foldernum, MAIL_STATUS_RECENT);
+		meta_data_flags_remove(con->imap.user->messages, con->imap.user->usernum, status.foldernum, MAIL_STATUS_RECENT, NULL);
+
+		// The folder may not hold the most recently modified message, so we report the highest value assigned to the user.
+		if (con->imap.user->modseq > status.highestmodseq) {
+			status.highestmodseq = con->imap.user->modseq;
+		}
 
 	}
 	meta_user_unlock(con->imap.user);
@@ -927,10 +1012,15 @@ void imap_select(connection_t *con) {
 		// Some clients expect the flags line to come first.
 		con_print(con, "* FLAGS (\\Answered \\Flagged \\Deleted \\Seen \\Draft \\Recent)\r\n" \
 			"* OK [PERMANENTFLAGS (\\Answered \\Flagged \\Deleted \\Seen \\Draft)]\r\n" \
-			"* %lu EXISTS\r\n* %lu RECENT\r\n%s* OK [UIDVALIDITY %lu]\r\n* OK [UIDNEXT %lu]\r\n" \
-			"%.*s OK SELECT [READ-WRITE] Complete.\r\n",
-			status.messages, status.recent, (status.first != 0 ? buffer : ""), status.foldernum, status.uidnext,
-			st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+			"* %lu EXISTS\r\n* %lu RECENT\r\n%s* OK [UIDVALIDITY %lu]\r\n* OK [UIDNEXT %lu]\r\n* OK [HIGHESTMODSEQ %lu]\r\n",
+			status.messages, status.recent, (status.first != 0 ? buffer : ""), status.foldernum, status.uidnext, status.highestmodseq);
+
+		// If the client is resynchronizing the same folder it saw previously, output the changes it missed.
+		if (uidvalidity && uidvalidity == status.foldernum) {
+			imap_select_resync(con, &status, modseq, known);
+		}
+
+		con_print(con, "%.*s OK SELECT [READ-WRITE] Complete.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		con->imap.messages_total = status.messages;
 		con->imap.messages_recent = status.recent;
 		con->imap.selected = status.foldernum;
@@ -954,9 +1044,14 @@ void imap_store(connection_t *con) {
 	int_t action;
 	uint32_t flags;
 	chr_t buffer[128];
+	size_t offset = 1;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
 	inx_t *messages, *duplicate;
+	stringer_t *modified = NULL;
+	imap_arguments_t *modifiers;
+	meta_condition_t condition = { .count = 0, .modified = NULL, .unchangedsince = 0 };
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
 
 	// Check for the right state.
 	if (con->imap.session_state != 1) {
@@ -972,20 +1067,30 @@ void imap_store(connection_t *con) {
 		return;
 	}
 
-	// Input validation. Requires three arguments.
-	else if (ar_length_get(con->imap.arguments) != 3|| imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY || imap_get_type_ar(con->imap.arguments, 1) == IMAP_ARGUMENT_TYPE_ARRAY) {
+	// Input validation. Requires three arguments, plus an optional list of modifiers after the sequence.
+	else if ((ar_length_get(con->imap.arguments) != 3 && ar_length_get(con->imap.arguments) != 4) || imap_get_type_ar(con->imap.arguments, 0) == IMAP_ARGUMENT_TYPE_ARRAY ||
+		(ar_length_get(con->imap.arguments) == 4 && imap_get_type_ar(con->imap.arguments, offset++) != IMAP_ARGUMENT_TYPE_ARRAY) ||
+		imap_get_type_ar(con->imap.arguments, offset) == IMAP_ARGUMENT_TYPE_ARRAY) {
 		con_print(con, "%.*s BAD The store command requires three arguments.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		return;
 	}
 
+	// The only modifier we support is UNCHANGEDSINCE, which is defined by the CONDSTORE extension.
+	else if (offset == 2 && (!(modifiers = imap_get_ar_ar(con->imap.arguments, 1)) || ar_length_get(modifiers) != 2 ||
+		imap_get_type_ar(modifiers, 0) == IMAP_ARGUMENT_TYPE_ARRAY || imap_get_type_ar(modifiers, 1) == IMAP_ARGUMENT_TYPE_ARRAY ||
+		st_cmp_ci_eq(imap_get_st_ar(modifiers, 0), PLACER("UNCHANGEDSINCE", 14)) || !uint64_conv_st(imap_get_st_ar(modifiers, 1), &(condition.unchangedsince)))) {
+		con_print(con, "%.*s BAD An invalid modifier was passed to the store command.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
 	// Determine whether we are replacing, removing, or adding.
-	else if ((action = imap_flag_action(imap_get_st_ar(con->imap.arguments, 1))) == 0) {
+	else if ((action = imap_flag_action(imap_get_st_ar(con->imap.arguments, offset))) == 0) {
 		con_print(con, "%.*s BAD An invalid data item parameter was passed to the store command.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		return;
 	}
 
 	// Parse the list of flags.
-	else if ((flags = imap_flag_parse(imap_get_ptr(con->imap.arguments, 2), imap_get_type_ar(con->imap.arguments, 2))) == 0) {
+	else if ((flags = imap_flag_parse(imap_get_ptr(con->imap.arguments, offset + 1), imap_get_type_ar(con->imap.arguments, offset + 1))) == 0) {
 		con_print(con, "%.*s BAD Unable to parse the list of flags provided to the store command.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		return;
 	}
@@ -1002,6 +1107,11 @@ void imap_store(connection_t *con) {
 		return;
 	}
 
+	// Using the UNCHANGEDSINCE modifier implicitly enables the CONDSTORE extension.
+	if (offset == 2) {
+		con->imap.condstore = 1;
+	}
+
 	meta_user_wlock(con->imap.user);
 
 	if (!con->imap.user || !con->imap.user->messages) {
@@ -1017,11 +1127,55 @@ void imap_store(connection_t *con) {
 		return;
 	}
 
+	// For a conditional store, the messages modified after the sequence provided by the client are left alone, and reported back as a failure.
+	// The comparison is made by the database, inside the update transaction, so a change made by another session can't slip through.
+	if (offset == 2 && !(condition.modified = mm_alloc(inx_count(messages) * sizeof(uint64_t)))) {
+		meta_user_unlock(con->imap.user);
+		inx_free(messages);
+		con_print(con, "%.*s NO Unable to perform the conditional store. Please try again later.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
 	/// LOW: Shouldn't we be checking for stale status info so the update doesn't make decisions based on incorrect status data? On the other
 	/// hand the actual IMAP logic is passed all the way through to the DB so even if the server ends up with incorrect status information, the database
 	/// should remain accurate.
 	// Perform the flag update. We use the shallow index copy so the updates are reflected in the central/shared session data.
-	imap_update_flags(con->imap.user, messages, con->imap.selected, action, flags);
+	if (!imap_update_flags(con->imap.user, messages, con->imap.selected, action, flags, offset == 2 ? &condition : NULL)) {
+		meta_user_unlock(con->imap.user);
+		inx_free(messages);
+		mm_cleanup(condition.modified);
+		con_print(con, "%.*s NO Unable to update the message flags. Please try again later.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
+	// The refused messages are reported using the same numbering scheme the client used for the sequence.
+	if (condition.count) {
+
+		for (size_t i = 0; !con->imap.uid && i < condition.count; i++) {
+			key.val.u64 = condition.modified[i];
+			condition.modified[i] = (active = inx_find(con->imap.user->messages, key)) ? active->sequencenum : 0;
+		}
+
+		modified = imap_range_build(condition.count, condition.modified);
+	}
+
+	mm_cleanup(condition.modified);
+
+	// If every message in the range was modified, there is nothing left to report.
+	if (!inx_count(messages)) {
+		meta_user_unlock(con->imap.user);
+		inx_free(messages);
+
+		if (modified) {
+			con_print(con, "%.*s OK [MODIFIED %.*s] Conditional STORE failed.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag),
+				st_length_int(modified), st_char_get(modified));
+			st_free(modified);
+		}
+		else {
+			con_print(con, "%.*s OK Store complete.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		}
+		return;
+	}
 
 	// If the serial number indicates no outside changes we can increment it without forcing a refresh.
 	if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
@@ -1041,18 +1195,29 @@ void imap_store(connection_t *con) {
 
 	meta_user_unlock(con->imap.user);
 
-	// Loop through and output each message.
-	if ((action & IMAP_FLAG_SILENT) != IMAP_FLAG_SILENT && (cursor = inx_cursor_alloc(duplicate))) {
+	// Loop through and output each message. Silent updates are still reported to CONDSTORE clients, since they need the new modification sequence.
+	if (((action & IMAP_FLAG_SILENT) != IMAP_FLAG_SILENT || con->imap.condstore == 1) && (cursor = inx_cursor_alloc(duplicate))) {
 
 			while ((active = inx_cursor_value_next(cursor))) {
 
-				if (con->imap.uid) {
+				if (con->imap.uid && con->imap.condstore) {
+					snprintf(buffer, 128, " UID %lu MODSEQ (%lu)", active->messagenum, active->modseq);
+				}
+				else if (con->imap.uid) {
 					snprintf(buffer, 128, " UID %lu", active->messagenum);
 				}
+				else if (con->imap.condstore) {
+					snprintf(buffer, 128, " MODSEQ (%lu)", active->modseq);
+				}
 				else {
 					buffer[0] = '\0';
 				}
 
+				if ((action & IMAP_FLAG_SILENT) == IMAP_FLAG_SILENT) {
+					con_print(con, "* %lu FETCH (%s)\r\n", active->sequencenum, buffer + 1);
+					continue;
+				}
+
 				con_print(con, "* %lu FETCH (FLAGS (%s%s%s%s%s%s%s%s%s%s%s)%s)\r\n", active->sequencenum,
 					(active->status & MAIL_STATUS_ANSWERED) != 0 ? "\\Answered" : "",
 					(active->status & MAIL_STATUS_ANSWERED) != 0 && (active->status & MAIL_STATUS_FLAGGED) != 0 ? " " : "",
@@ -1075,7 +1240,14 @@ void imap_store(connection_t *con) {
 
 	// The relevant folder status changed.
 	if (imap_session_update(con) == 1) {
-		con_print(con, "* %lu EXISTS\r\n* %lu RECENT\r\n%.*s OK Store complete.\r\n", con->imap.messages_total, con->imap.messages_recent, st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		con_print(con, "* %lu EXISTS\r\n* %lu RECENT\r\n", con->imap.messages_total, con->imap.messages_recent);
+	}
+
+	// Let the client know which messages were skipped because of the UNCHANGEDSINCE modifier.
+	if (modified) {
+		con_print(con, "%.*s OK [MODIFIED %.*s] Conditional STORE failed.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag),
+			st_length_int(modified), st_char_get(modified));
+		st_free(modified);
 	}
 	else {
 		con_print(con, "%.*s OK Store complete.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
@@ -1086,6 +1258,7 @@ void imap_store(connection_t *con) {
 
 void imap_close(connection_t *con) {
 
+	uint64_t modseq;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
 	int_t recent = 0, deleted = 0;
@@ -1149,19 +1322,17 @@ void imap_close(connection_t *con) {
 			return;
 		}
 
-		// When you close the folder, delete all the messages.
-		if ((cursor = inx_cursor_alloc(con->imap.user->messages))) {
-			while ((active = inx_cursor_value_next(cursor))) {
-				if (active->foldernum == con->imap.selected && (active->status & MAIL_STATUS_DELETED) == MAIL_STATUS_DELETED) {
-					imap_message_expunge(con, active);
-				}
-			}
-			inx_cursor_free(cursor);
-		}
+		// When you close the folder, delete all the messages. No untagged responses are sent, so we don't need the removed message numbers.
+		imap_message_expunge_bulk(con->imap.user->usernum, con->imap.user->messages, con->imap.selected, MAIL_STATUS_DELETED, NULL, NULL);
 
 		// Update all of the sequences at once.
 		meta_messages_update_sequences(con->imap.user->folders, con->imap.user->messages);
 
+		// The deletes advanced the modification sequence, so we refresh the value reported as the highest modification sequence.
+		if ((modseq = meta_data_fetch_modseq(con->imap.user->usernum))) {
+			con->imap.user->modseq = modseq;
+		}
+
 		// If the serial number indicates no outside changes we can increment it without forcing a refresh.
 		if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
 			con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
@@ -1199,7 +1370,11 @@ void imap_expunge(connection_t *con) {
 	int_t deleted = 0;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
-	uint64_t sequencenum, expunged = 0;
+	size_t length = 0;
+	int64_t expunged;
+	chr_t *responses;
+	stringer_t *vanished = NULL;
+	uint64_t modseq, *sequences = NULL, *uids = NULL;
 
 	// Check for the right state.
 	if (con->imap.session_state != 1) {
@@ -1254,22 +1429,37 @@ void imap_expunge(connection_t *con) {
 			return;
 		}
 
-		// Loop through and perform the deletes.
-		if ((cursor = inx_cursor_alloc(con->imap.user->messages))) {
-			while ((active = inx_cursor_value_next(cursor))) {
-				if (active->foldernum == con->imap.selected && (active->status & MAIL_STATUS_DELETED) == MAIL_STATUS_DELETED) {
-					sequencenum = active->sequencenum;
-					if (imap_message_expunge(con, active) != 0) {
-						con_print(con, "* %lu EXPUNGE\r\n", sequencenum - expunged++);
-					}
-				}
+		// Perform the deletes using a single transaction.
+		expunged = imap_message_expunge_bulk(con->imap.user->usernum, con->imap.user->messages, con->imap.selected, MAIL_STATUS_DELETED, &sequences, &uids);
+
+		// Clients which enabled QRESYNC are sent a single list of the expunged UIDs, instead of an EXPUNGE response for every message.
+		if (expunged > 0 && con->imap.qresync == 1 && (vanished = imap_range_build(expunged, uids))) {
+			con_print(con, "* VANISHED %.*s\r\n", st_length_int(vanished), st_char_get(vanished));
+			st_free(vanished);
+		}
+
+		// Otherwise the EXPUNGE responses are collected into a single buffer, so they can be written out with one call. Each response
+		// reduces the sequence numbers of the messages which follow it by one.
+		else if (expunged > 0 && con->imap.qresync != 1 && (responses = mm_alloc(expunged * 32))) {
+
+			for (int64_t i = 0; i < expunged; i++) {
+				length += snprintf(responses + length, (expunged * 32) - length, "* %lu EXPUNGE\r\n", sequences[i] - i);
 			}
-			inx_cursor_free(cursor);
+
+			con_write_bl(con, responses, length);
+			mm_free(responses);
 		}
 
+		mm_cleanup(sequences, uids);
+
 		// Update all of the sequences at once.
 		meta_messages_update_sequences(con->imap.user->folders, con->imap.user->messages);
 
+		// The deletes advanced the modification sequence, so we refresh the value reported as the highest modification sequence.
+		if ((modseq = meta_data_fetch_modseq(con->imap.user->usernum))) {
+			con->imap.user->modseq = modseq;
+		}
+
 		// If the serial number indicates no outside changes we can increment it without forcing a refresh.
 		if (con->imap.user->serials.messages == serial_get(OBJECT_MESSAGES, con->imap.user->usernum)) {
 			con->imap.messages_checkpoint = con->imap.user->serials.messages = serial_increment(OBJECT_MESSAGES, con->imap.user->usernum);
@@ -1546,12 +1736,12 @@ void imap_append(connection_t *con) {
 
 void imap_fetch(connection_t *con) {
 
-	int_t space = 0;
 	inx_cursor_t *cursor;
 	meta_message_t *active;
-	inx_t *messages, *duplicate;
+	stringer_t *vanished = NULL;
 	imap_fetch_dataitems_t *items;
-	imap_fetch_response_t *response, *iterate;
+	imap_fetch_response_t *response;
+	inx_t *messages = NULL, *duplicate, *changed;
 
 	// Check for the right state.
 	if (con->imap.session_state != 1) {
@@ -1581,6 +1771,19 @@ void imap_fetch(connection_t *con) {
 		return;
 	}
 
+	// The VANISHED modifier is only allowed if QRESYNC was enabled, and only makes sense for a UID FETCH with a CHANGEDSINCE modifier.
+	if (items->vanished == 1 && (con->imap.qresync == 0 || con->imap.uid == 0 || items->changedsince == 0)) {
+		con_print(con, "%.*s BAD The VANISHED modifier requires QRESYNC, and may only be used with the UID FETCH command and the CHANGEDSINCE modifier.\r\n",
+			st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		imap_fetch_free_items(items);
+		return;
+	}
+
+	// Asking for a modification sequence implicitly enables the CONDSTORE extension.
+	if (items->modseq == 1) {
+		con->imap.condstore = 1;
+	}
+
 	// If were going to be updating flags, get a write lock.
 	if (con->imap.read_only == 0 && (items->normal != NULL || items->rfc822 == 1 || items->rfc822_header == 1 || items->rfc822_text == 1)) {
 		meta_user_wlock(con->imap.user);
@@ -1589,9 +1792,27 @@ void imap_fetch(connection_t *con) {
 		meta_user_rlock(con->imap.user);
 	}
 
-	// Narrow by the sequence range provided.
-	if (con->imap.user->messages == NULL || (messages = imap_narrow_messages(con->imap.user->messages, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0), con->imap.uid)) == NULL) {
+	// Figure out which of the UIDs in the range no longer exist, so they can be reported ahead of the changes.
+	if (items->vanished == 1 && con->imap.user->messages != NULL) {
+		vanished = imap_range_vanished(con->imap.user->messages, con->imap.selected, imap_get_st_ar(con->imap.arguments, 0));
+	}
+
+	// Narrow by the sequence range provided, and if a modification sequence was provided, skip the messages which haven't changed since.
+	if (con->imap.user->messages != NULL && (messages = imap_narrow_messages(con->imap.user->messages, con->imap.selected,
+		imap_get_st_ar(con->imap.arguments, 0), con->imap.uid)) != NULL && items->changedsince != 0) {
+		changed = imap_narrow_changed(messages, con->imap.selected, items->changedsince);
+		inx_free(messages);
+		messages = changed;
+	}
+
+	if (messages == NULL) {
 		meta_user_unlock(con->imap.user);
+
+		if (vanished) {
+			con_print(con, "* VANISHED (EARLIER) %.*s\r\n", st_length_int(vanished), st_char_get(vanished));
+			st_free(vanished);
+		}
+
 		con_print(con, "%.*s OK Fetch complete. No messages were found matching the range provided.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 		imap_fetch_free_items(items);
 		return;
@@ -1599,7 +1820,7 @@ void imap_fetch(connection_t *con) {
 
 	// If RFC822, RFC822.TEXT or any BODY[] items are requested, add the seen flag.
 	if (con->imap.read_only == 0 && (items->normal != NULL || items->rfc822 == 1 || items->rfc822_text == 1)) {
-		meta_data_flags_add(messages, con->imap.user->usernum, con->imap.selected, MAIL_STATUS_SEEN);
+		meta_data_flags_add(messages, con->imap.user->usernum, con->imap.selected, MAIL_STATUS_SEEN, NULL);
 		if ((cursor = inx_cursor_alloc(messages))) {
 			while ((active = inx_cursor_value_next(cursor))) {
 				if ((active->status & MAIL_STATUS_SEEN) != MAIL_STATUS_SEEN) {
@@ -1631,72 +1852,20 @@ void imap_fetch(connection_t *con) {
 	inx_free(messages);
 	meta_user_unlock(con->imap.user);
 
+	// The vanished messages must be reported before any of the changes.
+	if (vanished) {
+		con_print(con, "* VANISHED (EARLIER) %.*s\r\n", st_length_int(vanished), st_char_get(vanished));
+		st_free(vanished);
+	}
+
 	// Loop through and output each message.
 	if ((cursor = inx_cursor_alloc(duplicate))) {
 		while (status() && con_status(con) >= 0 && (active = inx_cursor_value_next(cursor))) {
 
-			// Fetch the data.
-			iterate = response = imap_fetch_message(con, active, items);
-			space = 0;
-
-			// Output the response.
-			con_print(con, "* %lu FETCH (", active->sequencenum);
-
-			// Output the UID first.
-			while (iterate != NULL) {
-
-				if (!st_cmp_cs_eq(iterate->key, PLACER("UID", 3))) {
-					con_write_st(con, iterate->key);
-					con_write_bl(con, " ", 1);
-					con_write_st(con, iterate->value);
-					iterate = NULL;
-					space = 1;
-				}
-				else {
-					iterate = (imap_fetch_response_t *)iterate->next;
-				}
-			}
-
-			// Now output the size, if it is present.
-			iterate = response;
-			while (iterate != NULL) {
-				if (!st_cmp_cs_eq(iterate->key, PLACER("RFC822.SIZE", 11))) {
-					if (space == 1) {
-						con_write_bl(con, " ", 1);
-					}
-					else {
-						space = 1;
-					}
-					con_write_st(con, iterate->key);
-					con_write_bl(con, " ", 1);
-					con_write_st(con, iterate->value);
-					iterate = NULL;
-				}
-				else {
-					iterate = (imap_fetch_response_t *)iterate->next;
-				}
-			}
-
-			// Output the rest of the items.
-			iterate = response;
-			while (iterate != NULL) {
-				if (st_cmp_cs_eq(iterate->key, PLACER("UID", 3)) && st_cmp_cs_eq(iterate->key, PLACER("RFC822.SIZE", 11))) {
-					if (space == 1) {
-						con_write_bl(con, " ", 1);
-					}
-					else {
-						space = 1;
-					}
-					con_write_st(con, iterate->key);
-					con_write_bl(con, " ", 1);
-					con_write_st(con, iterate->value);
-				}
-				iterate = (imap_fetch_response_t *)iterate->next;
-			}
-
-			// Free the response and advance.
+			// Fetch the data, then output and free the response.
+			response = imap_fetch_message(con, active, items);
+			imap_fetch_response_print(con, active->sequencenum, response);
 			imap_fetch_response_free(response);
-			con_write_bl(con, ")\r\n", 3);
 		}
 
 		inx_cursor_free(cursor);
@@ -1711,6 +1880,8 @@ void imap_fetch(connection_t *con) {
 
 void imap_search(connection_t *con) {
 
+	bool_t modseq;
+	uint64_t highest = 0;
 	inx_t *messages = NULL;
 	inx_cursor_t *cursor = NULL;
 	meta_message_t *active = NULL;
@@ -1732,6 +1903,11 @@ void imap_search(connection_t *con) {
 		return;
 	}
 
+	// Searching by modification sequence implicitly enables the CONDSTORE extension.
+	if ((modseq = imap_search_modseq(con->imap.arguments, 0))) {
+		con->imap.condstore = 1;
+	}
+
 	// Perform the search. The internal search functions will lock the session as necessary.
 	messages = imap_search_messages(con);
 
@@ -1741,9 +1917,19 @@ void imap_search(connection_t *con) {
 		while ((active = inx_cursor_value_next(cursor))) {
 			st_sprint(buffer, " %lu", con->imap.uid ? active->messagenum : active->sequencenum);
 			st_append_opts(8192, output, buffer);
+
+			if (active->modseq > highest) {
+				highest = active->modseq;
+			}
 		}
 	}
 
+	// When the MODSEQ criterion is used, a non-empty result is followed by the highest modification sequence of the matching messages.
+	if (modseq && highest) {
+		st_sprint(buffer, " (MODSEQ %lu)", highest);
+		st_append_opts(8192, output, buffer);
+	}
+
 	// Append the blank line that follows the untagged result line.
 	st_append_opts(1024, output, PLACER("\r\n", 2));
 
@@ -1762,15 +1948,47 @@ void imap_search(connection_t *con) {
 	return;
 }
 
-void imap_idle(connection_t *con) {
+/**
+ * @brief	Turn on the optional extensions requested by the client, as described by RFC 5161.
+ * @note	We only support enabling the CONDSTORE and QRESYNC extensions (RFC 7162), and enabling QRESYNC implies CONDSTORE. Unrecognized
+ * 			extensions are silently ignored, as required, and are simply left out of the ENABLED response.
+ * @return	This function returns no value.
+ */
+void imap_enable(connection_t *con) {
+
+	size_t number;
+	stringer_t *item, *enabled = NULL;
 
+	// Check for the right state.
 	if (con->imap.session_state != 1) {
-		con_print(con, "%.*s BAD The IDLE command is not available until you are authenticated.\r\n", st_length_int(con->imap.tag),
-			st_char_get(con->imap.tag));
+		con_print(con, "%.*s BAD The ENABLE command is not available until you are authenticated.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
 	}
-	else {
-		con_print(con, "%.*s NO IDLE Failed. The IDLE command is not currently supported.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+
+	// Input validation. Requires at least one string argument.
+	else if (!con->imap.arguments || !(number = ar_length_get(con->imap.arguments))) {
+		con_print(con, "%.*s BAD The ENABLE command requires at least one argument.\r\n", st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+		return;
+	}
+
+	for (size_t i = 0; i < number; i++) {
+
+		if (imap_get_type_ar(con->imap.arguments, i) == IMAP_ARGUMENT_TYPE_ARRAY || !(item = imap_get_st_ar(con->imap.arguments, i))) {
+			continue;
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("CONDSTORE", 9)) && con->imap.condstore == 0) {
+			con->imap.condstore = 1;
+			enabled = st_append_opts(128, enabled, PLACER(" CONDSTORE", 10));
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("QRESYNC", 7)) && con->imap.qresync == 0) {
+			con->imap.qresync = con->imap.condstore = 1;
+			enabled = st_append_opts(128, enabled, PLACER(" QRESYNC", 8));
+		}
 	}
+
+	con_print(con, "* ENABLED%.*s\r\n%.*s OK Completed.\r\n", st_length_int(enabled), st_char_get(enabled), st_length_int(con->imap.tag), st_char_get(con->imap.tag));
+	st_cleanup(enabled);
+
 	return;
 }
 
@@ -1836,7 +2054,7 @@ void imap_capability(connection_t *con) {
 	}
 
 	// STARTTLS should only appear if the server instance has been configured with an TLS certificate. The connection must also be pre-authentication and unencrypted.
-	con_print(con, "* CAPABILITY IMAP4 IMAP4rev1%sLITERAL+ ID\r\n%.*s OK Completed.\r\n", con_secure(con) == 0 && con->imap.session_state == 0 ?
+	con_print(con, "* CAPABILITY IMAP4 IMAP4rev1%sLITERAL+ ID IDLE ENABLE CONDSTORE QRESYNC COMPRESS=DEFLATE\r\n%.*s OK Completed.\r\n", con_secure(con) == 0 && con->imap.session_state == 0 ?
 		" STARTTLS " : " ",	st_length_int(con->imap.tag), st_char_get(con->imap.tag));
 
 	return;
@@ -1855,7 +2073,7 @@ void imap_init(connection_t *con) {
 	con_reverse_enqueue(con);
 
 	// Introduce ourselves. Note the string below needs to stay in sync with the capability command.
-	con_print(con, "* OK [CAPABILITY IMAP4 IMAP4rev1%sLITERAL+ ID]%s%.*s%sMagma IMAP server v%s is ready.\r\n",
+	con_print(con, "* OK [CAPABILITY IMAP4 IMAP4rev1%sLITERAL+ ID IDLE ENABLE CONDSTORE QRESYNC COMPRESS=DEFLATE]%s%.*s%sMagma IMAP server v%s is ready.\r\n",
 		con_secure(con) == 0 ? " STARTTLS " : " ", st_length_get(con->server->domain) ? " " : "", st_length_int(con->server->domain),
 		st_char_get(con->server->domain), st_length_get(con->server->domain) ? " " : "", build_version());
 
@@ -34,15 +34,34 @@
 #define IMAP_FLAG_REMOVE 4
 #define IMAP_FLAG_REPLACE 8
 
+// IMAP Idle session states.
+#define IMAP_IDLE_STATE_ACTIVE 1
+#define IMAP_IDLE_STATE_SUSPENDED 2
+
+// IMAP Idle session events.
+#define IMAP_IDLE_EVENT_READ 1
+#define IMAP_IDLE_EVENT_NOTIFY 2
+#define IMAP_IDLE_EVENT_CHECK 4
+#define IMAP_IDLE_EVENT_EXPIRED 8
+#define IMAP_IDLE_EVENT_SHUTDOWN 16
+
+// The maximum number of network events returned by each call to epoll_wait().
+#define IMAP_IDLE_EVENTS_LIMIT 128
+
 /// commands.c
 int_t   imap_compare(const void *compare, const void *command);
 void    imap_process(connection_t *con);
 void    imap_requeue(connection_t *con);
 void    imap_sort(void);
 
+/// condstore.c
+int_t   imap_select_parameters(connection_t *con, imap_arguments_t *parameters, uint64_t *uidvalidity, uint64_t *modseq, stringer_t **known);
+void    imap_select_resync(connection_t *con, imap_folder_status_t *folder, uint64_t modseq, stringer_t *known);
+
 /// fetch_response.c
 imap_fetch_response_t *  imap_fetch_response_add(imap_fetch_response_t *response, stringer_t *key, stringer_t *value);
 void                     imap_fetch_response_free(imap_fetch_response_t *response);
+void                     imap_fetch_response_print(connection_t *con, uint64_t sequencenum, imap_fetch_response_t *response);
 
 /// fetch.c
 inx_t *                   imap_duplicate_messages(inx_t *messages);
@@ -61,15 +80,17 @@ stringer_t *              imap_fetch_return_header(connection_t *con, meta_messa
 mail_message_t *          imap_fetch_return_message(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
 mail_mime_t *             imap_fetch_return_mime(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
 stringer_t *              imap_fetch_return_text(connection_t *con, meta_message_t *meta, mail_message_t **message, stringer_t **header, imap_fetch_response_t *output);
+inx_t *                   imap_narrow_changed(inx_t *messages, uint64_t selected, uint64_t modseq);
 inx_t *                   imap_narrow_messages(inx_t *messages, uint64_t selected, stringer_t *range, int_t uid);
 imap_fetch_dataitems_t *  imap_parse_dataitems(imap_arguments_t *arguments);
+int_t                     imap_parse_modifiers(imap_arguments_t *array, imap_fetch_dataitems_t *items);
 int_t                     imap_valid_sequence(stringer_t *range);
 
 /// flags.c
 int_t      imap_flag_action(stringer_t *string);
 uint32_t   imap_flag_parse(void *ptr, int_t type);
 uint32_t   imap_get_flag(stringer_t *string);
-void       imap_update_flags(meta_user_t *user, inx_t *messages, uint64_t foldernum, int_t action, uint32_t flags);
+bool_t     imap_update_flags(meta_user_t *user, inx_t *messages, uint64_t foldernum, int_t action, uint32_t flags, meta_condition_t *condition);
 
 /// folders.c
 int_t         imap_count_folder_levels(stringer_t *name);
@@ -83,19 +104,28 @@ inx_t *       imap_narrow_folders(inx_t *folders, stringer_t *reference, stringe
 uint64_t      imap_next_folder_order(inx_t *folders, uint64_t parent);
 bool_t        imap_valid_folder_name(stringer_t *name);
 
+/// idle.c
+void     imap_idle(connection_t *con);
+void     imap_idle_listener(void *data, uint64_t usernum, uint64_t object);
+void     imap_idle_monitor(void);
+bool_t   imap_idle_start(void);
+void     imap_idle_stop(void);
+void     imap_idle_wake(connection_t *con);
+
 /// imap.c
 void   imap_append(connection_t *con);
 void   imap_capability(connection_t *con);
 void   imap_check(connection_t *con);
 void   imap_close(connection_t *con);
+void   imap_compress(connection_t *con);
 void   imap_copy(connection_t *con);
 void   imap_create(connection_t *con);
 void   imap_delete(connection_t *con);
+void   imap_enable(connection_t *con);
 void   imap_examine(connection_t *con);
 void   imap_expunge(connection_t *con);
 void   imap_fetch(connection_t *con);
 void   imap_id(connection_t *con);
-void   imap_idle(connection_t *con);
 void   imap_init(connection_t *con);
 void   imap_invalid(connection_t *con);
 void   imap_list(connection_t *con);
@@ -116,6 +146,7 @@ void   imap_unsubscribe(connection_t *con);
 int_t   imap_append_message(connection_t *con, meta_folder_t *folder, uint32_t flags, stringer_t *message, uint64_t *outnum);
 int_t   imap_message_copier(connection_t *con, meta_message_t *message, uint64_t target, uint64_t *outnum);
 int_t   imap_message_expunge(connection_t *con, meta_message_t *message);
+int64_t imap_message_expunge_bulk(uint64_t usernum, inx_t *messages, uint64_t foldernum, uint32_t flags, uint64_t **sequences, uint64_t **uids);
 
 /// output.c
 stringer_t *  imap_build_array(chr_t *format, ...);
@@ -142,6 +173,7 @@ int_t               imap_parse_qstring(stringer_t **output, chr_t **start, size_
 
 /// range.c
 stringer_t *  imap_range_build(size_t length, uint64_t *numbers);
+stringer_t *  imap_range_vanished(inx_t *messages, uint64_t selected, stringer_t *range);
 
 /// search.c
 int_t    imap_search_flag(uint32_t status, uint32_t flag, int_t has);
@@ -151,9 +183,11 @@ int_t    imap_search_messages_date(connection_t *con, meta_user_t *user, mail_me
 int_t    imap_search_messages_date_compare(stringer_t *one, stringer_t *two);
 int_t    imap_search_messages_header(connection_t *con, meta_user_t *user, mail_message_t **data, stringer_t **header, meta_message_t *active, stringer_t *field, stringer_t *value);
 int_t    imap_search_messages_inner(connection_t *con, meta_user_t *user, mail_message_t **message, stringer_t **header, meta_message_t *current, imap_arguments_t *array, unsigned recursion);
+int_t    imap_search_messages_modseq(meta_message_t *active, stringer_t *value);
 int_t    imap_search_messages_range(meta_message_t *active, stringer_t *range, int_t uid);
 int_t    imap_search_messages_size(meta_message_t *active, stringer_t *value, int_t expected);
 int_t    imap_search_messages_text(connection_t *con, meta_user_t *user, mail_message_t **data, meta_message_t *active, stringer_t *value);
+bool_t   imap_search_modseq(imap_arguments_t *array, unsigned recursion);
 
 /// sessions.c
 void    imap_session_destroy(connection_t *con);
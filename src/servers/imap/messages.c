@@ -26,7 +26,9 @@ int_t imap_append_message(connection_t *con, meta_folder_t *folder, uint32_t fla
 		return 0;
 	}
 
+	// The modification sequence assigned by the insert isn't returned, but the user's counter, read after the commit, is never smaller.
 	*outnum = new->messagenum = key.val.u64;
+	new->modseq = meta_data_fetch_modseq(con->imap.user->usernum);
 	new->status = flags;
 	new->foldernum = folder->foldernum;
 	new->created = time(NULL);
@@ -62,6 +64,76 @@ int_t imap_message_expunge(connection_t *con, meta_message_t *message) {
 	return 1;
 }
 
+/**
+ * @brief	Remove every message in a folder which has the specified flags set, using a single database transaction.
+ * @note	The message files are reclaimed in the background, so the caller can release the user lock without waiting on the file
+ * 			system. If the bulk removal fails, we fall back to removing the messages one at a time, so a single bad record doesn't block
+ * 			the rest. The caller is responsible for updating the message sequence numbers once this function returns.
+ * @param	usernum		the numerical id of the user that owns the messages.
+ * @param	messages	an inx holder containing the user's messages, which will have the removed messages deleted from it.
+ * @param	foldernum	the numerical id of the folder being expunged.
+ * @param	flags		a mask of the flags a message must have set to be removed, or 0 to remove every message in the folder.
+ * @param	sequences	an optional pointer to receive an array holding the sequence number of each removed message, which must be freed by the caller.
+ * @param	uids		an optional pointer to receive an array holding the UID of each removed message, which must be freed by the caller.
+ * @return	-1 on failure, or the number of messages removed.
+ */
+int64_t imap_message_expunge_bulk(uint64_t usernum, inx_t *messages, uint64_t foldernum, uint32_t flags, uint64_t **sequences, uint64_t **uids) {
+
+	uint64_t total;
+	inx_cursor_t *cursor;
+	size_t count = 0, expunged = 0;
+	meta_message_t *active, **targets;
+	multi_t key = { .type = M_TYPE_UINT64, .val.u64 = 0 };
+
+	if (sequences) *sequences = NULL;
+	if (uids) *uids = NULL;
+
+	if (!messages || !(total = inx_count(messages))) {
+		return 0;
+	}
+	else if (!(targets = mm_alloc(total * sizeof(meta_message_t *))) || (sequences && !(*sequences = mm_alloc(total * sizeof(uint64_t)))) ||
+		(uids && !(*uids = mm_alloc(total * sizeof(uint64_t))))) {
+		log_pedantic("Unable to allocate memory for the bulk expunge operation.");
+		if (sequences) mm_cleanup(*sequences);
+		if (uids) mm_cleanup(*uids);
+		mm_cleanup(targets);
+		return -1;
+	}
+
+	// The index is ordered by message number, so the targets end up sorted by UID, and sequence number.
+	if ((cursor = inx_cursor_alloc(messages))) {
+		while ((active = inx_cursor_value_next(cursor)) && count < total) {
+			if (active->foldernum == foldernum && (active->status & flags) == flags) {
+				targets[count++] = active;
+			}
+		}
+		inx_cursor_free(cursor);
+	}
+
+	if (count && !mail_remove_messages(usernum, targets, count)) {
+		for (size_t i = 0; i < count; i++) {
+			if (!mail_remove_message(usernum, targets[i]->messagenum, targets[i]->size, targets[i]->server)) {
+				targets[i] = NULL;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if ((active = targets[i])) {
+
+			if (sequences) (*sequences)[expunged] = active->sequencenum;
+			if (uids) (*uids)[expunged] = active->messagenum;
+			expunged++;
+
+			key.val.u64 = active->messagenum;
+			inx_delete(messages, key);
+		}
+	}
+
+	mm_free(targets);
+	return expunged;
+}
+
 int_t imap_message_copier(connection_t *con, meta_message_t *message, uint64_t target, uint64_t *outnum) {
 
 	uint32_t status;
@@ -85,6 +157,7 @@ int_t imap_message_copier(connection_t *con, meta_message_t *message, uint64_t t
 	}
 
 	*outnum = new->messagenum = key.val.u64;
+	new->modseq = meta_data_fetch_modseq(con->imap.user->usernum);
 	new->foldernum = target;
 
 	// Messages added to a folder should be distinguished by having the recent flag.
@@ -174,7 +174,7 @@ int_t imap_parse_astring(stringer_t **output, chr_t **start, size_t *length) {
 	}
 
 	// Create a stringer with the result.
-	if (!(result = st_import(*start, holder - *start))) {
+	if (!(result = st_import_opts(MANAGED_T | CONTIGUOUS | ARENA, *start, holder - *start))) {
 		log_pedantic("Unable to extract the atomic string.");
 		return -1;
 	}
@@ -217,7 +217,7 @@ int_t imap_parse_nstring(stringer_t **output, chr_t **start, size_t *length, chr
 	}
 
 	// Create a stringer with the result.
-	if (!(result = st_import(*start, holder - *start))) {
+	if (!(result = st_import_opts(MANAGED_T | CONTIGUOUS | ARENA, *start, holder - *start))) {
 		log_error("Unable to extract the nil string.");
 		return -1;
 	}
@@ -310,7 +310,7 @@ int_t imap_parse_qstring(stringer_t **output, chr_t **start, size_t *length) {
 	}
 
 	// Allocate a buffer for the output.
-	if (!(result = st_alloc(holder - *start))) {
+	if (!(result = st_alloc_opts(MANAGED_T | CONTIGUOUS | ARENA, holder - *start))) {
 		log_pedantic("Unable to allocate a buffer for the quoted string.");
 		return -1;
 	}
@@ -907,6 +907,9 @@ int_t imap_command_parser(connection_t *con) {
 		con->imap.arguments = NULL;
 	}
 
+	// With the previous command released, the temporaries it allocated from the connection arena can be reclaimed.
+	con_arena_reset(con);
+
 	// Debug info.
 	if (magma.log.imap) {
 		imap_command_log_safe(&con->network.line);
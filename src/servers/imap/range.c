@@ -66,3 +66,149 @@ stringer_t * imap_range_build(size_t length, uint64_t *numbers) {
 
 	return result;
 }
+
+/**
+ * @brief	Build a UID set describing which of the UIDs in a range no longer exist in the selected folder.
+ * @note	Expunged messages are removed from the database, so we can't tell which of the missing UIDs actually belonged to the folder.
+ * 			Instead we report every UID in the range which isn't currently in use, which RFC 7162 allows, since clients are required to
+ * 			ignore any vanished UIDs they don't recognize. This function relies on the messages being sorted by message number.
+ * @param	messages	the complete collection of the user's messages.
+ * @param	selected	the numerical id of the currently selected folder.
+ * @param	range		a UID set supplied by the client, or NULL to check every UID which has been assigned.
+ * @return	NULL if nothing vanished, or an error occurred, otherwise a managed string holding the vanished UIDs as a compressed UID set.
+ */
+stringer_t * imap_range_vanished(inx_t *messages, uint64_t selected, stringer_t *range) {
+
+	chr_t buffer[128];
+	inx_cursor_t *cursor;
+	meta_message_t *active;
+	stringer_t *result = NULL;
+	uint32_t commas = 1, parts;
+	placer_t sequence, start_token, end_token;
+	size_t count = 0, position, low, high;
+	uint64_t *uids, start, end, current, upper, next, highest = 0;
+
+	if (!messages || !(uids = mm_alloc((inx_count(messages) + 1) * sizeof(uint64_t)))) {
+		return NULL;
+	}
+
+	// Collect the UIDs currently in use by the selected folder, and the highest UID assigned to any folder.
+	if ((cursor = inx_cursor_alloc(messages))) {
+
+		while ((active = inx_cursor_value_next(cursor))) {
+
+			if (active->foldernum == selected) {
+				uids[count++] = active->messagenum;
+			}
+
+			if (active->messagenum > highest) {
+				highest = active->messagenum;
+			}
+
+		}
+
+		inx_cursor_free(cursor);
+	}
+
+	if (range) {
+		commas = tok_get_count_st(range, ',');
+	}
+
+	for (uint32_t i = 0; i < commas && highest; i++) {
+
+		// Without a range, we check every UID which has been assigned.
+		if (!range) {
+			start = 1;
+			end = highest;
+		}
+		else if (tok_get_st(range, ',', i, &sequence) < 0 || !(parts = tok_get_count_st(&sequence, ':')) ||
+			tok_get_st(&sequence, ':', 0, &start_token) < 0) {
+			log_pedantic("range parsing error = %.*s", st_length_int(range), st_char_get(range));
+			st_cleanup(result);
+			mm_free(uids);
+			return NULL;
+		}
+		else {
+
+			end_token = pl_null();
+
+			if (parts > 1) {
+				tok_get_st(&sequence, ':', 1, &end_token);
+			}
+
+			// An asterisk refers to the highest UID, and a missing end token means the range is a single UID.
+			if (*(pl_char_get(start_token)) == '*') {
+				start = highest;
+			}
+			else if (!uint64_conv_st(&start_token, &start)) {
+				log_pedantic("range parsing error = %.*s", st_length_int(range), st_char_get(range));
+				st_cleanup(result);
+				mm_free(uids);
+				return NULL;
+			}
+
+			if (pl_empty(end_token)) {
+				end = start;
+			}
+			else if (*(pl_char_get(end_token)) == '*') {
+				end = highest;
+			}
+			else if (!uint64_conv_st(&end_token, &end)) {
+				log_pedantic("range parsing error = %.*s", st_length_int(range), st_char_get(range));
+				st_cleanup(result);
+				mm_free(uids);
+				return NULL;
+			}
+
+			// If necessary, swap the values.
+			if (start > end) {
+				current = start;
+				start = end;
+				end = current;
+			}
+
+		}
+
+		// UIDs are never zero, and anything above the highest assigned UID can't have vanished.
+		if (!start) start = 1;
+		if (end > highest) end = highest;
+		if (start > end) continue;
+
+		// Use a binary search to find the first UID in use which falls inside the range.
+		for (low = 0, high = count; low < high;) {
+			position = low + ((high - low) / 2);
+			if (uids[position] < start) low = position + 1;
+			else high = position;
+		}
+
+		// Walk the UIDs in use, and record the gaps between them.
+		for (position = low, current = start; current <= end;) {
+
+			// The gap ends just before the next UID in use, or at the end of the range.
+			if (position < count && uids[position] <= end) {
+				upper = uids[position++];
+				next = upper + 1;
+				upper--;
+			}
+			else {
+				upper = end;
+				next = end + 1;
+			}
+
+			if (current <= upper) {
+
+				snprintf(buffer, 128, current == upper ? "%s%lu" : "%s%lu:%lu", result ? "," : "", current, upper);
+
+				if (!(result = st_append_opts(8192, result, NULLER(buffer)))) {
+					mm_free(uids);
+					return NULL;
+				}
+			}
+
+			current = next;
+		}
+	}
+
+	mm_free(uids);
+	return result;
+}
@@ -263,6 +263,69 @@ int_t imap_search_messages_size(meta_message_t *active, stringer_t *value, int_t
 	return -1;
 }
 
+int_t imap_search_messages_modseq(meta_message_t *active, stringer_t *value) {
+
+	uint64_t modseq;
+
+	if (active == NULL || uint64_conv_st(value, &modseq) != true) {
+		return -1;
+	}
+	else if (active->modseq >= modseq) {
+		return 1;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief	Determine whether a search program uses the MODSEQ criterion, which is defined by the CONDSTORE extension (RFC 7162).
+ * @note	The walk skips over the parameters of the other search keys, so a string like SUBJECT "MODSEQ" isn't mistaken for the criterion.
+ * @param	array		the search program, or one of its parenthesized lists.
+ * @param	recursion	the current recursion depth.
+ * @return	true if the search program uses the MODSEQ criterion, otherwise false.
+ */
+bool_t imap_search_modseq(imap_arguments_t *array, unsigned recursion) {
+
+	stringer_t *item;
+	unsigned number, increment = 0;
+	chr_t *parameters[] = { "BCC", "BEFORE", "BODY", "CC", "CHARSET", "FROM", "LARGER", "ON", "SENTBEFORE", "SENTON", "SENTSINCE", "SINCE",
+		"SMALLER", "SUBJECT", "TEXT", "TO", "UID" };
+
+	if (recursion >= IMAP_SEARCH_RECURSION_LIMIT || array == NULL) {
+		return false;
+	}
+
+	number = ar_length_get(array);
+
+	while (increment < number) {
+
+		if (imap_get_type_ar(array, increment) == IMAP_ARGUMENT_TYPE_ARRAY) {
+			if (imap_search_modseq(imap_get_ar_ar(array, increment++), recursion + 1)) {
+				return true;
+			}
+		}
+		else if ((item = imap_get_st_ar(array, increment++)) == NULL) {
+			continue;
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("MODSEQ", 6))) {
+			return true;
+		}
+		else if (!st_cmp_ci_eq(item, PLACER("HEADER", 6))) {
+			increment += 2;
+		}
+		else {
+			for (size_t i = 0; i < sizeof(parameters) / sizeof(chr_t *); i++) {
+				if (!st_cmp_ci_eq(item, NULLER(parameters[i]))) {
+					increment++;
+					break;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
 int_t imap_search_flag(uint32_t status, uint32_t flag, int_t has) {
 	if (has == 1 && (status & flag) == flag) {
 		return 1;
@@ -346,6 +409,7 @@ int_t imap_search_messages_range(meta_message_t *active, stringer_t *range, int_
 
 int_t imap_search_messages_inner(connection_t *con, meta_user_t *user, mail_message_t **message, stringer_t **header, meta_message_t *current, imap_arguments_t *array, unsigned recursion) {
 
+	uint64_t modseq;
 	stringer_t *item;
 	unsigned number, increment = 0;
 	int_t eval = 0, output = 0, not = 0, or = 0;
@@ -460,6 +524,24 @@ int_t imap_search_messages_inner(connection_t *con, meta_user_t *user, mail_mess
 			increment += 2;
 		}
 
+		// Modification sequence checks. The optional entry name and type refer to per flag metadata, which we don't track, so
+		// they're skipped, and the comparison is made against the modification sequence for the message as a whole.
+		else if (increment < number && !st_cmp_ci_eq(item, PLACER("MODSEQ", 6))) {
+
+			if (increment + 2 < number && imap_get_type_ar(array, increment) != IMAP_ARGUMENT_TYPE_ARRAY &&
+				imap_get_type_ar(array, increment + 1) != IMAP_ARGUMENT_TYPE_ARRAY && !uint64_conv_st(imap_get_st_ar(array, increment), &modseq)) {
+				increment += 2;
+			}
+
+			if (imap_get_type_ar(array, increment) != IMAP_ARGUMENT_TYPE_ARRAY) {
+				eval = imap_search_messages_modseq(current, imap_get_st_ar(array, increment++));
+			}
+			else {
+				eval = -1;
+				increment++;
+			}
+		}
+
 		// Body checks.
 		else if (increment < number && !st_cmp_ci_eq(item, PLACER("BODY", 4)) && imap_get_type_ar(array, increment) != IMAP_ARGUMENT_TYPE_ARRAY) {
 			eval = imap_search_messages_body(con, user, message, current, imap_get_st_ar(array, increment++));
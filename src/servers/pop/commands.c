@@ -44,6 +44,9 @@ void pop_process(connection_t *con) {
 
 	command_t *command, client = { .function = NULL };
 
+	// Reclaim the temporaries allocated by the previous command.
+	con_arena_reset(con);
+
 	if (con_read_line(con, true) < 0) {
 		con->command = NULL;
 		enqueue(&pop_quit, con);
@@ -73,7 +76,7 @@ void pop_process(connection_t *con) {
 			enqueue(command->function, con);
 		}
 		else {
-			requeue(command->function, &pop_requeue, con);
+			requeue(&con_command, &pop_requeue, con);
 		}
 	}
 	else {
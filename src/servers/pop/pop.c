@@ -39,6 +39,7 @@ void pop_starttls(connection_t *con) {
 		return;
 	}
 
+	con_offload(con);
 	stats_increment_by_name("pop.connections.secure");
 	st_length_set(con->network.buffer, 0);
 	con->network.line = pl_null();
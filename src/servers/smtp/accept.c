@@ -230,7 +230,12 @@ int_t smtp_accept_message(connection_t *con, smtp_inbound_prefs_t *prefs) {
 
 		// The message hasn't been scanned, or encountered an error during the last attempt, so rescan it now.
 		if (con->smtp.checked.virus == 0 || con->smtp.checked.virus == -1) {
-			con->smtp.checked.virus = state = virus_check(con->smtp.message->text);
+			state = virus_check(con->smtp.message->text);
+
+			// When the recipients are delivered in parallel, the shared result is only updated by smtp_fanout_prepare().
+			if (!con->smtp.fanout) {
+				con->smtp.checked.virus = state;
+			}
 		}
 		else {
 			state = con->smtp.checked.virus;
@@ -297,7 +302,7 @@ int_t smtp_accept_message(connection_t *con, smtp_inbound_prefs_t *prefs) {
 	if (!con->smtp.bypass && (prefs->mark == SMTP_MARK_NONE) && (prefs->dkim == 1) && (con->smtp.checked.dkim == 0 || con->smtp.checked.dkim == -2)) {
 
 		// This message hasn't been checked yet.
-		if (con->smtp.checked.dkim == 0) {
+		if (con->smtp.checked.dkim == 0 && !con->smtp.fanout) {
 			con->smtp.checked.dkim = dkim_signature_verify(con->smtp.message->id, con->smtp.message->text);
 		}
 
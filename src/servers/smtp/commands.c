@@ -49,6 +49,9 @@ void smtp_process(connection_t *con) {
 
 	command_t *command, client = { .function = NULL };
 
+	// Reclaim the temporaries allocated by the previous command.
+	con_arena_reset(con);
+
 	if (con_read_line(con, true) < 0) {
 		con->command = NULL;
 		enqueue(&smtp_quit, con);
@@ -79,7 +82,7 @@ void smtp_process(connection_t *con) {
 			enqueue(command->function, con);
 		}
 		else {
-			requeue(command->function, &smtp_requeue, con);
+			requeue(&con_command, &smtp_requeue, con);
 		}
 	}
 	else {
@@ -0,0 +1,650 @@
+
+/**
+ * @file /magma/servers/smtp/counters.c
+ *
+ * @brief	In-memory counters used to enforce the daily send and receive limits, and to track the per-user message totals, without
+ * 			querying the database for every message.
+ *
+ * @note	Each counter holds the number of messages counted during each of the last 24 hours. The hourly counts are shared with the
+ * 			other cluster nodes by incrementing a key on the cache servers for each hour, and a counter which isn't held in memory is
+ * 			seeded using those keys. Local increments are added to the cache servers, and the hourly counts are refreshed using the
+ * 			totals recorded by every node, once every magma.smtp.counters.interval seconds. The rows used by the Receiving and
+ * 			Transmitting tables, and the totals kept in the Log table, are written using batched statements at the same time. Since
+ * 			the counts are kept by hour, the daily limits cover the current hour and the 23 hours before it.
+ */
+
+#include "magma.h"
+
+struct {
+	bool_t enabled; /* Set while the counters are available. */
+	bool_t active; /* Set while the flush thread should keep running. */
+	pthread_t *thread;
+	inx_t *counters[SMTP_COUNTER_SHARDS];
+	pthread_mutex_t locks[SMTP_COUNTER_SHARDS];
+} counters = {
+	.enabled = false,
+	.active = false,
+	.thread = NULL
+};
+
+/**
+ * @brief	Determine whether the in-memory counters are active.
+ * @return	true if the counters are enabled, or false if the quota checks and statistics are handled using the database.
+ */
+bool_t smtp_counters_enabled(void) {
+
+	return counters.enabled;
+}
+
+/**
+ * @brief	Free a message counter.
+ * @param	counter		the counter being freed.
+ * @return	This function returns no value.
+ */
+void smtp_counter_free(smtp_counter_t *counter) {
+
+	if (counter) {
+		st_cleanup(counter->key, counter->subnet);
+		mm_free(counter);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Allocate an empty message counter.
+ * @param	kind		SMTP_COUNTER_RECEIVED or SMTP_COUNTER_SENT.
+ * @param	usernum		the numerical id of the user the counter belongs to.
+ * @param	subnet		the subnet for a received message counter, or NULL to count every message.
+ * @param	key			a managed string containing the cache key prefix used by the counter.
+ * @return	NULL on failure, or a pointer to the newly allocated counter on success.
+ */
+smtp_counter_t * smtp_counter_alloc(int_t kind, uint64_t usernum, stringer_t *subnet, stringer_t *key) {
+
+	smtp_counter_t *counter;
+
+	if (!(counter = mm_alloc(sizeof(smtp_counter_t)))) {
+		log_pedantic("Unable to allocate %zu bytes for a message counter.", sizeof(smtp_counter_t));
+		return NULL;
+	}
+	else if (!(counter->key = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, key)) ||
+		(subnet && !(counter->subnet = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, subnet)))) {
+		log_pedantic("Unable to copy the message counter key. { key = %.*s }", st_length_int(key), st_char_get(key));
+		smtp_counter_free(counter);
+		return NULL;
+	}
+
+	counter->kind = kind;
+	counter->usernum = usernum;
+
+	return counter;
+}
+
+/**
+ * @brief	Get the number of the current hour, counted from the epoch.
+ * @return	the current hour number.
+ */
+uint64_t smtp_counter_hour(void) {
+
+	return time(NULL) / 3600;
+}
+
+/**
+ * @brief	Load the hourly message counts recorded by every cluster node for a counter.
+ * @param	key		a managed string containing the cache key prefix used by the counter.
+ * @param	hour	the current hour number.
+ * @param	counts	an array which will receive the count for the current hour, followed by the counts for each of the preceding hours.
+ * @return	true if any counts were found, or false if the cache servers didn't return any values.
+ */
+bool_t smtp_counter_load(stringer_t *key, uint64_t hour, uint64_t counts[SMTP_COUNTER_HOURS]) {
+
+	size_t found = 0;
+	stringer_t *keys[SMTP_COUNTER_HOURS], *values[SMTP_COUNTER_HOURS];
+
+	mm_wipe(keys, sizeof(keys));
+	mm_wipe(values, sizeof(values));
+	mm_wipe(counts, sizeof(uint64_t) * SMTP_COUNTER_HOURS);
+
+	for (int_t i = 0; i < SMTP_COUNTER_HOURS; i++) {
+		if (!(keys[i] = st_aprint_opts(MANAGED_T | CONTIGUOUS | ARENA, "%.*s.%lu", st_length_int(key), st_char_get(key), hour - i))) {
+			log_pedantic("Unable to build the hourly message counter keys. { key = %.*s }", st_length_int(key), st_char_get(key));
+			for (int_t j = 0; j < i; j++) st_free(keys[j]);
+			return false;
+		}
+	}
+
+	// Memcached stores counters as decimal strings.
+	if (cache_get_multi(SMTP_COUNTER_HOURS, keys, values)) {
+		for (int_t i = 0; i < SMTP_COUNTER_HOURS; i++) {
+			if (values[i] && uint64_conv_st(values[i], &(counts[i]))) found++;
+			else counts[i] = 0;
+		}
+	}
+
+	for (int_t i = 0; i < SMTP_COUNTER_HOURS; i++) {
+		st_cleanup(values[i]);
+		st_free(keys[i]);
+	}
+
+	return found ? true : false;
+}
+
+/**
+ * @brief	Replace the hourly counts held by a counter with the counts recorded by every cluster node.
+ * @note	The caller must hold the lock protecting the counter. Local increments which haven't been added to the cache servers
+ * 			yet are added on top of the cluster wide counts.
+ * @param	counter		the counter being updated.
+ * @param	hour		the current hour number.
+ * @param	counts		the counts returned by smtp_counter_load().
+ * @return	This function returns no value.
+ */
+void smtp_counter_apply(smtp_counter_t *counter, uint64_t hour, uint64_t counts[SMTP_COUNTER_HOURS]) {
+
+	for (int_t i = 0; i < SMTP_COUNTER_HOURS; i++) {
+		counter->hours[(hour - i) % SMTP_COUNTER_HOURS].hour = hour - i;
+		counter->hours[(hour - i) % SMTP_COUNTER_HOURS].count = counts[i];
+	}
+
+	if (counter->pending.count && hour - counter->pending.hour < SMTP_COUNTER_HOURS) {
+		counter->hours[counter->pending.hour % SMTP_COUNTER_HOURS].count += counter->pending.count;
+	}
+
+	return;
+}
+
+/**
+ * @brief	Find a counter, creating it if necessary, and lock it.
+ * @note	A counter which isn't held in memory is seeded using the counts stored on the cache servers, without holding the lock.
+ * @param	kind		SMTP_COUNTER_RECEIVED or SMTP_COUNTER_SENT.
+ * @param	usernum		the numerical id of the user the counter belongs to.
+ * @param	subnet		the subnet for a received message counter, or NULL to count every message.
+ * @param	lock		a pointer which will receive the address of the lock protecting the counter.
+ * @return	NULL on failure, or a pointer to the counter, in which case the caller must release the lock.
+ */
+smtp_counter_t * smtp_counter_find(int_t kind, uint64_t usernum, stringer_t *subnet, pthread_mutex_t **lock) {
+
+	uint_t shard;
+	bool_t loaded;
+	uint64_t hour, counts[SMTP_COUNTER_HOURS];
+	smtp_counter_t *counter, *created;
+	stringer_t *key = MANAGEDBUF(256);
+	multi_t multi = { .type = M_TYPE_STRINGER, .val.st = NULL };
+
+	if (!counters.enabled || !usernum || (subnet && st_empty(subnet))) {
+		return NULL;
+	}
+	else if (st_sprint(key, "magma.smtp.%s.%lu%s%.*s", kind == SMTP_COUNTER_SENT ? "sent" : "received", usernum, subnet ? "." : "",
+		subnet ? st_length_int(subnet) : 0, subnet ? st_char_get(subnet) : "") <= 0) {
+		log_pedantic("Unable to build the message counter key. { usernum = %lu }", usernum);
+		return NULL;
+	}
+
+	shard = hash_murmur64(st_data_get(key), st_length_get(key)) % SMTP_COUNTER_SHARDS;
+	*lock = &(counters.locks[shard]);
+	multi.val.st = key;
+
+	mutex_lock(*lock);
+
+	if ((counter = inx_find(counters.counters[shard], multi))) {
+		counter->touched = time(NULL);
+		return counter;
+	}
+
+	mutex_unlock(*lock);
+
+	if (!(created = smtp_counter_alloc(kind, usernum, subnet, key))) {
+		return NULL;
+	}
+
+	hour = smtp_counter_hour();
+	loaded = smtp_counter_load(key, hour, counts);
+
+	mutex_lock(*lock);
+
+	// Another thread may have created the counter while we were waiting on the cache servers.
+	if ((counter = inx_find(counters.counters[shard], multi))) {
+		smtp_counter_free(created);
+	}
+	else if (!(multi.val.st = created->key) || !inx_insert(counters.counters[shard], multi, created)) {
+		log_pedantic("Unable to store the message counter. { key = %.*s }", st_length_int(key), st_char_get(key));
+		mutex_unlock(*lock);
+		smtp_counter_free(created);
+		return NULL;
+	}
+	else {
+		counter = created;
+		counter->synced = time(NULL);
+		if (loaded) smtp_counter_apply(counter, hour, counts);
+	}
+
+	counter->touched = time(NULL);
+
+	return counter;
+}
+
+/**
+ * @brief	Get the number of messages counted over the last day.
+ * @param	kind		SMTP_COUNTER_RECEIVED or SMTP_COUNTER_SENT.
+ * @param	usernum		the numerical id of the user.
+ * @param	subnet		the subnet for received messages, or NULL to count every message.
+ * @param	total		a pointer which will receive the number of messages counted during the current hour and the 23 hours before it.
+ * @return	true on success, or false if the counters are disabled or an error occurred.
+ */
+bool_t smtp_counter_get(int_t kind, uint64_t usernum, stringer_t *subnet, uint64_t *total) {
+
+	uint64_t hour;
+	pthread_mutex_t *lock;
+	smtp_counter_t *counter;
+
+	if (!total || !(counter = smtp_counter_find(kind, usernum, subnet, &lock))) {
+		return false;
+	}
+
+	*total = 0;
+	hour = smtp_counter_hour();
+
+	for (int_t i = 0; i < SMTP_COUNTER_HOURS; i++) {
+		if (counter->hours[i].hour <= hour && hour - counter->hours[i].hour < SMTP_COUNTER_HOURS) {
+			*total += counter->hours[i].count;
+		}
+	}
+
+	mutex_unlock(lock);
+
+	return true;
+}
+
+/**
+ * @brief	Count messages, and queue the matching database updates.
+ * @param	kind		SMTP_COUNTER_RECEIVED or SMTP_COUNTER_SENT.
+ * @param	usernum		the numerical id of the user.
+ * @param	subnet		the subnet for received messages, or NULL to count every message.
+ * @param	count		the number of messages to add to the counter.
+ * @param	rows		the number of rows to write to the Receiving or Transmitting table.
+ * @param	messages	the amount to add to the message total kept in the Log table.
+ * @param	bounces		the amount to add to the bounce total kept in the Log table.
+ * @return	true on success, or false if the counters are disabled or an error occurred.
+ */
+bool_t smtp_counter_add(int_t kind, uint64_t usernum, stringer_t *subnet, uint64_t count, uint64_t rows, uint64_t messages, uint64_t bounces) {
+
+	uint64_t hour;
+	pthread_mutex_t *lock;
+	smtp_counter_t *counter;
+
+	if (!(counter = smtp_counter_find(kind, usernum, subnet, &lock))) {
+		return false;
+	}
+
+	hour = smtp_counter_hour();
+
+	if (counter->hours[hour % SMTP_COUNTER_HOURS].hour != hour) {
+		counter->hours[hour % SMTP_COUNTER_HOURS].hour = hour;
+		counter->hours[hour % SMTP_COUNTER_HOURS].count = 0;
+	}
+
+	counter->hours[hour % SMTP_COUNTER_HOURS].count += count;
+
+	if (!counter->pending.count) {
+		counter->pending.hour = hour;
+	}
+
+	counter->pending.count += count;
+	counter->pending.rows += rows;
+	counter->pending.messages += messages;
+	counter->pending.bounces += bounces;
+
+	mutex_unlock(lock);
+
+	return true;
+}
+
+/**
+ * @brief	Build the values written to a table on behalf of a detached counter.
+ * @param	table		the SMTP_COUNTER_TABLE value for the table being written.
+ * @param	work		the changes detached from the counter.
+ * @param	output		a managed string which will receive the values for a single row.
+ * @return	the number of copies of the row which should be written, or 0 if the counter has nothing to write to the table.
+ */
+uint64_t smtp_counters_tuple(int_t table, smtp_counter_work_t *work, stringer_t *output) {
+
+	chr_t subnet[160];
+	smtp_counter_t *counter = work->counter;
+
+	switch (table) {
+		case (SMTP_COUNTER_TABLE_RECEIVING):
+			if (counter->kind != SMTP_COUNTER_RECEIVED || !counter->subnet || !work->rows || st_length_get(counter->subnet) > 64) {
+				return 0;
+			}
+			mysql_escape_string_d(subnet, st_char_get(counter->subnet), st_length_get(counter->subnet));
+			return st_sprint(output, "(%lu, '%s', NOW())", counter->usernum, subnet) > 0 ? work->rows : 0;
+		case (SMTP_COUNTER_TABLE_TRANSMITTING):
+			if (counter->kind != SMTP_COUNTER_SENT || !work->rows) {
+				return 0;
+			}
+			return st_sprint(output, "(%lu, NOW())", counter->usernum) > 0 ? work->rows : 0;
+		case (SMTP_COUNTER_TABLE_LOG_RECEIVED):
+			if (counter->kind != SMTP_COUNTER_RECEIVED || counter->subnet || (!work->messages && !work->bounces)) {
+				return 0;
+			}
+			return st_sprint(output, "SELECT %lu AS usernum, %lu AS messages, %lu AS bounces", counter->usernum, work->messages,
+				work->bounces) > 0 ? 1 : 0;
+		case (SMTP_COUNTER_TABLE_LOG_SENT):
+			if (counter->kind != SMTP_COUNTER_SENT || !work->messages) {
+				return 0;
+			}
+			return st_sprint(output, "SELECT %lu AS usernum, %lu AS messages", counter->usernum, work->messages) > 0 ? 1 : 0;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief	Return the changes which couldn't be written to a table, so they're retried during the next flush.
+ * @param	table		the SMTP_COUNTER_TABLE value for the table which couldn't be written.
+ * @param	work		the changes detached from the counter.
+ * @param	lock		the lock protecting the counter.
+ * @return	This function returns no value.
+ */
+void smtp_counters_restore(int_t table, smtp_counter_work_t *work, pthread_mutex_t *lock) {
+
+	mutex_lock(lock);
+
+	if (table == SMTP_COUNTER_TABLE_RECEIVING || table == SMTP_COUNTER_TABLE_TRANSMITTING) {
+		work->counter->pending.rows += work->rows;
+	}
+	else {
+		work->counter->pending.messages += work->messages;
+		work->counter->pending.bounces += work->bounces;
+	}
+
+	mutex_unlock(lock);
+
+	return;
+}
+
+/**
+ * @brief	Write the changes detached from a group of counters to a table, using multiple row statements.
+ * @note	Rows are only split into separate statements between counters, so a failed statement can be retried. The Log totals are
+ * 			updated by joining against the list of changes, so like the single row updates they replace, a user without a Log row
+ * 			is skipped rather than having one created. Each user has a single counter, so a user never appears in the list twice.
+ * @param	table		the SMTP_COUNTER_TABLE value for the table being written.
+ * @param	work		an array holding the changes detached from the counters.
+ * @param	items		the number of entries in the work array.
+ * @param	lock		the lock protecting the counters.
+ * @return	This function returns no value.
+ */
+void smtp_counters_write(int_t table, smtp_counter_work_t *work, size_t items, pthread_mutex_t *lock) {
+
+	uint64_t copies;
+	bool_t failed;
+	size_t start = 0, rows = 0;
+	chr_t *prefix = NULL, *separator = ", ", *suffix = NULL;
+	stringer_t *query = NULL, *tuple = MANAGEDBUF(256);
+
+	switch (table) {
+		case (SMTP_COUNTER_TABLE_RECEIVING):
+			prefix = "INSERT INTO Receiving (usernum, subnet, timestamp) VALUES ";
+			break;
+		case (SMTP_COUNTER_TABLE_TRANSMITTING):
+			prefix = "INSERT INTO Transmitting (usernum, timestamp) VALUES ";
+			break;
+		case (SMTP_COUNTER_TABLE_LOG_RECEIVED):
+			prefix = "UPDATE Log INNER JOIN (";
+			separator = " UNION ALL ";
+			suffix = ") AS Changes ON Log.usernum = Changes.usernum SET Log.lastreceived = NOW(), " \
+				"Log.totalreceived = Log.totalreceived + Changes.messages, Log.totalbounces = Log.totalbounces + Changes.bounces";
+			break;
+		case (SMTP_COUNTER_TABLE_LOG_SENT):
+			prefix = "UPDATE Log INNER JOIN (";
+			separator = " UNION ALL ";
+			suffix = ") AS Changes ON Log.usernum = Changes.usernum SET Log.lastsent = NOW(), Log.totalsent = Log.totalsent + Changes.messages";
+			break;
+		default:
+			log_pedantic("Invalid message counter table. { table = %i }", table);
+			return;
+	}
+
+	for (size_t i = 0; i < items; i++) {
+
+		failed = false;
+		copies = smtp_counters_tuple(table, &work[i], tuple);
+
+		for (uint64_t j = 0; !failed && j < copies; j++) {
+			if (!(query = st_append(query, rows++ ? NULLER(separator) : NULLER(prefix))) || !(query = st_append(query, tuple))) {
+				log_pedantic("Unable to build the message counter statement.");
+				failed = true;
+			}
+		}
+
+		// Execute the statement once it's large enough, or when the last counter has been added.
+		if (rows && (failed || rows >= SMTP_COUNTER_BATCH || i == items - 1)) {
+
+			if (failed || (suffix && !(query = st_append(query, NULLER(suffix)))) || sql_write(query) < 0) {
+				log_pedantic("Unable to write the message counters to the database. { rows = %zu }", rows);
+				stats_increment_by_name("smtp.counters.errors");
+				for (size_t k = start; k <= i; k++) {
+					if (smtp_counters_tuple(table, &work[k], tuple)) smtp_counters_restore(table, &work[k], lock);
+				}
+			}
+			else {
+				stats_adjust_by_name("smtp.counters.rows", rows);
+			}
+
+			st_cleanup(query);
+			query = NULL;
+			rows = 0;
+			start = i + 1;
+		}
+		else if (!rows) {
+			st_cleanup(query);
+			query = NULL;
+			start = i + 1;
+		}
+	}
+
+	st_cleanup(query);
+
+	return;
+}
+
+/**
+ * @brief	Add the local increments to the cache servers, refresh the counters using the counts recorded by every cluster node,
+ * 			write the pending database updates, and release the counters which haven't been used recently.
+ * @return	This function returns no value.
+ */
+void smtp_counters_flush(void) {
+
+	uint64_t hour, value, counts[SMTP_COUNTER_HOURS];
+	bool_t loaded;
+	size_t items, expired, total;
+	time_t now = time(NULL);
+	inx_cursor_t *cursor;
+	smtp_counter_t *counter;
+	smtp_counter_work_t *work;
+	stringer_t **stale, *key = MANAGEDBUF(320);
+	multi_t multi = { .type = M_TYPE_STRINGER, .val.st = NULL };
+
+	if (!counters.enabled) {
+		return;
+	}
+
+	hour = smtp_counter_hour();
+
+	for (int_t shard = 0; shard < SMTP_COUNTER_SHARDS; shard++) {
+
+		work = NULL;
+		stale = NULL;
+		items = expired = 0;
+		mutex_lock(&(counters.locks[shard]));
+
+		if (!(total = inx_count(counters.counters[shard]))) {
+			mutex_unlock(&(counters.locks[shard]));
+			continue;
+		}
+		else if (!(work = mm_alloc(sizeof(smtp_counter_work_t) * total)) || !(stale = mm_alloc(sizeof(stringer_t *) * total)) ||
+			!(cursor = inx_cursor_alloc(counters.counters[shard]))) {
+			log_pedantic("Unable to allocate memory for the message counter flush. { counters = %zu }", total);
+			mutex_unlock(&(counters.locks[shard]));
+			mm_cleanup(work, stale);
+			continue;
+		}
+
+		// Detach the changes made since the previous flush, and find the idle counters.
+		while ((counter = inx_cursor_value_next(cursor))) {
+
+			if (counter->pending.count || counter->pending.rows || counter->pending.messages || counter->pending.bounces ||
+				counter->touched >= counter->synced) {
+
+				work[items].counter = counter;
+				work[items].hour = counter->pending.hour;
+				work[items].count = counter->pending.count;
+				work[items].rows = counter->pending.rows;
+				work[items].messages = counter->pending.messages;
+				work[items].bounces = counter->pending.bounces;
+				mm_wipe(&(counter->pending), sizeof(counter->pending));
+				items++;
+			}
+			else if (now - counter->touched > magma.smtp.counters.idle && (stale[expired] = st_dupe(counter->key))) {
+				expired++;
+			}
+		}
+
+		inx_cursor_free(cursor);
+
+		for (size_t i = 0; i < expired; i++) {
+			multi.val.st = stale[i];
+			inx_delete(counters.counters[shard], multi);
+			st_free(stale[i]);
+		}
+
+		mutex_unlock(&(counters.locks[shard]));
+		mm_free(stale);
+
+		// The counters are only released by this thread, so they remain valid while the lock is released.
+		for (size_t i = 0; i < items; i++) {
+
+			counter = work[i].counter;
+			value = 0;
+
+			if (work[i].count && st_sprint(key, "%.*s.%lu", st_length_int(counter->key), st_char_get(counter->key), work[i].hour) > 0) {
+				value = cache_increment(key, work[i].count, work[i].count, (SMTP_COUNTER_HOURS + 1) * 3600);
+			}
+
+			loaded = smtp_counter_load(counter->key, hour, counts);
+
+			mutex_lock(&(counters.locks[shard]));
+
+			// If the increment failed, it's retried during the next flush.
+			if (work[i].count && !value) {
+				if (!counter->pending.count || counter->pending.hour > work[i].hour) counter->pending.hour = work[i].hour;
+				counter->pending.count += work[i].count;
+			}
+
+			if (loaded) {
+				smtp_counter_apply(counter, hour, counts);
+			}
+
+			counter->synced = time(NULL) + 1;
+			mutex_unlock(&(counters.locks[shard]));
+		}
+
+		smtp_counters_write(SMTP_COUNTER_TABLE_RECEIVING, work, items, &(counters.locks[shard]));
+		smtp_counters_write(SMTP_COUNTER_TABLE_TRANSMITTING, work, items, &(counters.locks[shard]));
+		smtp_counters_write(SMTP_COUNTER_TABLE_LOG_RECEIVED, work, items, &(counters.locks[shard]));
+		smtp_counters_write(SMTP_COUNTER_TABLE_LOG_SENT, work, items, &(counters.locks[shard]));
+
+		mm_free(work);
+	}
+
+	stats_increment_by_name("smtp.counters.flushes");
+
+	return;
+}
+
+/**
+ * @brief	The entry point for the thread which periodically flushes the message counters.
+ * @return	This function returns no value.
+ */
+void smtp_counters_flusher(void) {
+
+	time_t last = time(NULL);
+
+	thread_start();
+
+	while (counters.active && status()) {
+
+		sleep(1);
+
+		if (time(NULL) - last >= magma.smtp.counters.interval) {
+			smtp_counters_flush();
+			last = time(NULL);
+		}
+	}
+
+	thread_stop();
+	pthread_exit(NULL);
+	return;
+}
+
+/**
+ * @brief	Initialize the message counters and launch the thread which flushes them.
+ * @note	If magma.smtp.counters.interval is set to zero, the counters are disabled, and every quota check and statistics update is
+ * 			sent directly to the database.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_counters_start(void) {
+
+	if (!magma.smtp.counters.interval) {
+		return true;
+	}
+
+	for (int_t i = 0; i < SMTP_COUNTER_SHARDS; i++) {
+		if (!(counters.counters[i] = inx_alloc(M_INX_TREE | M_INX_LOCK_MANUAL, &smtp_counter_free))) {
+			log_critical("Unable to initialize the message counter index.");
+			smtp_counters_stop();
+			return false;
+		}
+
+		mutex_init(&(counters.locks[i]), NULL);
+	}
+
+	counters.enabled = counters.active = true;
+
+	if (!(counters.thread = mm_alloc(sizeof(pthread_t))) || thread_launch(counters.thread, &smtp_counters_flusher, NULL)) {
+		log_critical("Unable to launch the message counter thread.");
+		mm_cleanup(counters.thread);
+		counters.thread = NULL;
+		smtp_counters_stop();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Stop the flush thread, write any pending changes, and free the message counters.
+ * @return	This function returns no value.
+ */
+void smtp_counters_stop(void) {
+
+	counters.active = false;
+
+	if (counters.thread) {
+		thread_join(*(counters.thread));
+		mm_free(counters.thread);
+		counters.thread = NULL;
+	}
+
+	smtp_counters_flush();
+	counters.enabled = false;
+
+	for (int_t i = 0; i < SMTP_COUNTER_SHARDS; i++) {
+		if (counters.counters[i]) {
+			inx_free(counters.counters[i]);
+			counters.counters[i] = NULL;
+			mutex_destroy(&(counters.locks[i]));
+		}
+	}
+
+	return;
+}
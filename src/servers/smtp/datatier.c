@@ -100,9 +100,33 @@ stringer_t * smtp_fetch_autoreply(uint64_t autoreply, uint64_t usernum) {
 
 /**
  * @brief	Fetch a user's SMTP preferences for inbound mail.
+ * @note	This function first checks the inbound preferences cache, and falls back to the database.
+ * @param	address		a managed string containing the sanitized recipient address.
+ * @param	output		a pointer which will receive the inbound preferences for the recipient.
+ * @return	0 for success or < 0 for failures, and > 0 for account locks. @see smtp_fetch_inbound_data()
+ */
+int_t smtp_fetch_inbound(stringer_t *address, smtp_inbound_prefs_t **output) {
+
+	int_t state;
+
+	if (st_empty(address) || !output) {
+		return -3;
+	}
+	else if (smtp_inbound_cache_get(address, &state, output)) {
+		return state;
+	}
+
+	state = smtp_fetch_inbound_data(address, output);
+	smtp_inbound_cache_set(address, state, *output);
+
+	return state;
+}
+
+/**
+ * @brief	Load a user's SMTP preferences for inbound mail from the database.
  *
- * @param	cred a pointer to the credential object of a user with
- * @param	address
+ * @param	address		a managed string containing the sanitized recipient address.
+ * @param	output		a pointer which will receive the inbound preferences for the recipient.
  *
  * @return 0 for success or < 0 for failures, and > 0 for account locks.
  *
@@ -116,7 +140,7 @@ stringer_t * smtp_fetch_autoreply(uint64_t autoreply, uint64_t usernum) {
  * @retval  4: the account is locked due to suspicion of abuse violations. @see AUTH_LOCK_ABUSE
  * @retval  5: the account has been locked at the request of the user. @see AUTH_LOCK_USER
  */
-int_t smtp_fetch_inbound(stringer_t *address, smtp_inbound_prefs_t **output) {
+int_t smtp_fetch_inbound_data(stringer_t *address, smtp_inbound_prefs_t **output) {
 
 	row_t *row;
 	table_t *result;
@@ -367,6 +391,7 @@ table_t * smtp_fetch_rollmessages(uint64_t usernum) {
  * @brief	Update the receiving statistics and per-user log tables in the database for a successfully received smtp message.
  * @note	The Receiving table is updated with the subnet address from which the message was received;
  * 			the Log table for the user is updated to reflect the newly calculated totals of bounces or messages received.
+ * 			If the in-memory counters are enabled, the message is counted and the updates are written later in batches.
  * @param	con		the connection across which the smtp message was received.
  * @param	prefs	a pointer to the user's smtp inbound mail preferences.
  * @return	This function returns no value.
@@ -382,6 +407,27 @@ void smtp_update_receive_stats(connection_t *con, smtp_inbound_prefs_t *prefs) {
 		return;
 	}
 
+	if (!st_cmp_cs_eq(con->smtp.mailfrom, PLACER("<>", 2))) {
+		bounce = 1;
+
+		if (prefs->bounces == 0) {
+			message = 0;
+		}
+
+	}
+
+	// When the in-memory counters are enabled, the database updates are queued and written in batches.
+	if (smtp_counters_enabled()) {
+
+		if (!smtp_counter_add(SMTP_COUNTER_RECEIVED, prefs->usernum, NULL, 1, 0, message, bounce) ||
+			!smtp_counter_add(SMTP_COUNTER_RECEIVED, prefs->usernum, substr, 1, 1, 0, 0)) {
+			log_pedantic("Unable to update the receive counters. { usernum = %lu }", prefs->usernum);
+		}
+
+		st_free(substr);
+		return;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum
@@ -403,15 +449,6 @@ void smtp_update_receive_stats(connection_t *con, smtp_inbound_prefs_t *prefs) {
 
 	mm_wipe(parameters, sizeof(parameters));
 
-	if (!st_cmp_cs_eq(con->smtp.mailfrom, PLACER("<>", 2))) {
-		bounce = 1;
-
-		if (prefs->bounces == 0) {
-			message = 0;
-		}
-
-	}
-
 	// Received
 	parameters[0].buffer_type = MYSQL_TYPE_LONG;
 	parameters[0].buffer_length = sizeof(int32_t);
@@ -491,6 +528,7 @@ uint64_t smtp_insert_spamsig(smtp_inbound_prefs_t *prefs, uint64_t key, int_t co
  * @brief	Update the transmission and per-user log tables in the database for a successfully sent smtp message.
  * @note	The Transmitting table is updated with the timestamp of this transaction;
  * 			the Log table for the user is updated to reflect the newly calculated total for messages sent.
+ * 			If the in-memory counters are enabled, the messages are counted and the updates are written later in batches.
  * @param	con		a pointer to the connection object across which the smtp message was sent.
  * @param	prefs	a pointer to the user's smtp inbound mail preferences.
  * @return	This function returns no value.
@@ -499,6 +537,17 @@ void smtp_update_transmission_stats(connection_t *con) {
 
 	MYSQL_BIND parameters[2];
 
+	// When the in-memory counters are enabled, the database updates are queued and written in batches.
+	if (smtp_counters_enabled()) {
+
+		if (!smtp_counter_add(SMTP_COUNTER_SENT, con->smtp.out_prefs->usernum, NULL, con->smtp.num_recipients, con->smtp.num_recipients,
+			con->smtp.num_recipients, 0)) {
+			log_pedantic("Unable to update the transmit counter. { usernum = %lu }", con->smtp.out_prefs->usernum);
+		}
+
+		return;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum
@@ -537,15 +586,23 @@ void smtp_update_transmission_stats(connection_t *con) {
  * @brief	Check to see if a user's current mail send request would push them over their daily transmission quota.
  * @note	This check is performed by querying the database to see how many messages a user has sent in the past 24 hour period, and by
  * 			adding the current number of recipients of the pending email request to that number to see if their quota would be exceeded.
+ * 			If the in-memory counters are enabled, the number of messages sent is taken from the counter instead.
  * @param	con		a pointer to the connection object of the user attempting to send mail.
  * @return	-1 on error, 0 if the send operation is permitted, or 1 if the send operation would result in a daily send quota overage.
  */
 int_t smtp_check_transmit_quota(uint64_t usernum, size_t num_recipients, smtp_outbound_prefs_t *prefs) {
 
 	row_t *row;
+	uint64_t sent;
 	table_t *result;
 	MYSQL_BIND parameters[1];
 
+	// Use the in-memory counter if possible.
+	if (smtp_counter_get(SMTP_COUNTER_SENT, usernum, NULL, &sent)) {
+		prefs->sent_today = (uint32_t)sent;
+		return prefs->sent_today + num_recipients > prefs->daily_send_limit ? 1 : 0;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum
@@ -594,6 +651,7 @@ int_t smtp_check_transmit_quota(uint64_t usernum, size_t num_recipients, smtp_ou
 int_t smtp_fetch_authorization(stringer_t *username, stringer_t *verification, smtp_outbound_prefs_t **output) {
 
 	row_t *row;
+	uint64_t sent;
 	table_t *result;
 	MYSQL_BIND parameters[2];
 	stringer_t *encoded = NULL;
@@ -655,7 +713,12 @@ int_t smtp_fetch_authorization(stringer_t *username, stringer_t *verification, s
 	res_table_free(result);
 	*output = outbound;
 
-	// Now find out how many messages have been sent.
+	// Now find out how many messages have been sent, using the in-memory counter if possible.
+	if (smtp_counter_get(SMTP_COUNTER_SENT, outbound->usernum, NULL, &sent)) {
+		outbound->sent_today = (uint32_t)sent;
+		return 0;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Usernum
@@ -688,6 +751,7 @@ int_t smtp_fetch_authorization(stringer_t *username, stringer_t *verification, s
  * @note	The sum total of all emails received by the user over the past 24 hours is calculated from the database, and these checks are made:
  *			1. The amount of mail messages received in the past 24 hours by the user does not exceed their daily mail received quota.
  *			2. The messages received in the past 24 hours by the user from this subnet does not exceed the user's daily per-subnet received quota.
+ *			If the in-memory counters are enabled, the totals are taken from the counters instead.
  * @param	con		a pointer to the connection object over which the smtp message was received.
  * @param	prefs	a pointer to the user's smtp inbound mail preferences.
  * @return	0 if message receipt is permitted, 1 if the general daily receiving limit was exceeded, 2 if the sending subnet's transmission
@@ -697,7 +761,7 @@ int_t smtp_check_receive_quota(connection_t *con, smtp_inbound_prefs_t *prefs) {
 
 	row_t *row;
 	table_t *result;
-	uint64_t number;
+	uint64_t number, total;
 	stringer_t *substr;
 	MYSQL_BIND parameters[2];
 
@@ -706,6 +770,20 @@ int_t smtp_check_receive_quota(connection_t *con, smtp_inbound_prefs_t *prefs) {
 		return -1;
 	}
 
+	// Use the in-memory counters if possible.
+	if (smtp_counter_get(SMTP_COUNTER_RECEIVED, prefs->usernum, NULL, &total) && smtp_counter_get(SMTP_COUNTER_RECEIVED, prefs->usernum, substr, &number)) {
+		st_free(substr);
+
+		if (total >= prefs->daily_recv_limit) {
+			return 1;
+		}
+		else if (number >= prefs->daily_recv_limit_ip) {
+			return 2;
+		}
+
+		return 0;
+	}
+
 	mm_wipe(parameters, sizeof(parameters));
 
 	// Subnet
@@ -0,0 +1,199 @@
+
+/**
+ * @file /magma/servers/smtp/fanout.c
+ *
+ * @brief	Deliver an inbound message to its recipients in parallel, using the worker threads, so a message addressed to a large
+ * 			number of local mailboxes doesn't hold the connection for the sum of every delivery.
+ *
+ * @note	The thread which received the message queues up to magma.smtp.fanout - 1 helpers, and then delivers recipients itself
+ * 			until none are left. Helpers claim recipients from the same list, so if the worker threads are busy the delivering
+ * 			thread simply ends up doing all of the work, and it never waits on a helper which hasn't started. The virus scan and
+ * 			DKIM verification results are computed once, before the helpers are queued, and are read only while they run.
+ */
+
+#include "magma.h"
+
+/**
+ * @brief	Release a reference to a fan-out, and free it once the last reference is gone.
+ * @param	fanout	the fan-out being released.
+ * @return	This function returns no value.
+ */
+void smtp_fanout_release(smtp_fanout_t *fanout) {
+
+	uint32_t refs;
+
+	mutex_lock(&(fanout->lock));
+	refs = --fanout->refs;
+	mutex_unlock(&(fanout->lock));
+
+	if (!refs) {
+		mutex_destroy(&(fanout->lock));
+		sem_destroy(&(fanout->complete));
+		mm_free(fanout);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Deliver recipients until every recipient of the message has been claimed.
+ * @param	fanout	the fan-out being processed.
+ * @param	helper	true if the calling thread is a helper, rather than the thread which received the message.
+ * @return	the number of recipients delivered by the calling thread.
+ */
+uint32_t smtp_fanout_run(smtp_fanout_t *fanout, bool_t helper) {
+
+	bool_t wake;
+	uint32_t delivered = 0;
+	smtp_inbound_prefs_t *current;
+
+	do {
+
+		mutex_lock(&(fanout->lock));
+
+		if ((current = fanout->cursor)) {
+			fanout->cursor = (smtp_inbound_prefs_t *)current->next;
+			if (helper) fanout->active++;
+		}
+
+		mutex_unlock(&(fanout->lock));
+
+		if (current) {
+
+			current->outcome = smtp_accept_message(fanout->con, current);
+			delivered++;
+
+			// A helper must tell the delivering thread when it finishes the last outstanding recipient.
+			if (helper) {
+				mutex_lock(&(fanout->lock));
+				wake = (!--fanout->active && fanout->closed);
+				mutex_unlock(&(fanout->lock));
+
+				if (wake) {
+					sem_post(&(fanout->complete));
+				}
+			}
+		}
+
+	} while (current);
+
+	return delivered;
+}
+
+/**
+ * @brief	The worker thread entry point for a fan-out helper.
+ * @param	fanout	the fan-out being processed.
+ * @return	This function returns no value.
+ */
+void smtp_fanout_worker(smtp_fanout_t *fanout) {
+
+	uint32_t delivered;
+
+	if ((delivered = smtp_fanout_run(fanout, true))) {
+		stats_adjust_by_name("smtp.fanout.helpers", delivered);
+	}
+
+	smtp_fanout_release(fanout);
+
+	return;
+}
+
+/**
+ * @brief	Compute the message checks which are shared by every recipient, before the deliveries are spread across threads.
+ * @note	The results are computed here if any recipient would need them, even if the recipient would end up being rejected for
+ * 			another reason first, since they'd otherwise be computed by whichever thread reached them first.
+ * @param	con		the connection the message was received on.
+ * @return	This function returns no value.
+ */
+void smtp_fanout_prepare(connection_t *con) {
+
+	bool_t virus = false, dkim = false;
+
+	for (smtp_inbound_prefs_t *current = con->smtp.in_prefs; current; current = (smtp_inbound_prefs_t *)current->next) {
+		if (current->virus == 1 || current->phish == 1) virus = true;
+		if (current->dkim == 1) dkim = true;
+	}
+
+	if (virus && (con->smtp.checked.virus == 0 || con->smtp.checked.virus == -1)) {
+		con->smtp.checked.virus = virus_check(con->smtp.message->text);
+	}
+
+	if (dkim && !con->smtp.bypass && con->smtp.checked.dkim == 0) {
+		con->smtp.checked.dkim = dkim_signature_verify(con->smtp.message->id, con->smtp.message->text);
+	}
+
+	// Every recipient adds a received line which includes the reverse lookup, so wait for it here rather than in each helper.
+	con_reverse_check(con, 20);
+
+	return;
+}
+
+/**
+ * @brief	Deliver an inbound message to all of its recipients, and record the outcome for each recipient.
+ * @note	If the fan-out is disabled, the message only has a single recipient, or the helpers can't be set up, the recipients
+ * 			are delivered in turn by the calling thread.
+ * @param	con		the connection the message was received on.
+ * @return	This function returns no value.
+ */
+void smtp_fanout_deliver(connection_t *con) {
+
+	bool_t wait;
+	smtp_fanout_t *fanout = NULL;
+	uint32_t recipients = 0, helpers;
+
+	for (smtp_inbound_prefs_t *current = con->smtp.in_prefs; current; current = (smtp_inbound_prefs_t *)current->next) {
+		recipients++;
+	}
+
+	helpers = (magma.smtp.fanout < recipients ? magma.smtp.fanout : recipients);
+	helpers = (helpers ? helpers - 1 : 0);
+
+	if (helpers && (fanout = mm_alloc(sizeof(smtp_fanout_t)))) {
+
+		if (sem_init(&(fanout->complete), 0, 0)) {
+			mm_free(fanout);
+			fanout = NULL;
+		}
+		else if (mutex_init(&(fanout->lock), NULL)) {
+			sem_destroy(&(fanout->complete));
+			mm_free(fanout);
+			fanout = NULL;
+		}
+	}
+
+	if (!fanout) {
+		for (smtp_inbound_prefs_t *current = con->smtp.in_prefs; current; current = (smtp_inbound_prefs_t *)current->next) {
+			current->outcome = smtp_accept_message(con, current);
+		}
+		return;
+	}
+
+	smtp_fanout_prepare(con);
+
+	fanout->con = con;
+	fanout->cursor = con->smtp.in_prefs;
+	fanout->refs = helpers + 1;
+	con->smtp.fanout = true;
+
+	for (uint32_t i = 0; i < helpers; i++) {
+		enqueue(&smtp_fanout_worker, fanout);
+	}
+
+	stats_increment_by_name("smtp.fanout.messages");
+	smtp_fanout_run(fanout, false);
+
+	// Every recipient has been claimed, so only the helpers which are still delivering a recipient need to be waited on.
+	mutex_lock(&(fanout->lock));
+	fanout->closed = true;
+	wait = (fanout->active ? true : false);
+	mutex_unlock(&(fanout->lock));
+
+	if (wait) {
+		while (sem_wait(&(fanout->complete)) && errno == EINTR);
+	}
+
+	con->smtp.fanout = false;
+	smtp_fanout_release(fanout);
+
+	return;
+}
@@ -0,0 +1,235 @@
+
+/**
+ * @file /magma/servers/smtp/inbound.c
+ *
+ * @brief	A process wide cache of the preferences loaded for inbound SMTP recipients, so repeated deliveries to the same mailbox, and
+ * 			repeated attempts to deliver to addresses which don't exist, can be answered without querying the database.
+ *
+ * @note	The cache is a fixed size table, keyed by the sanitized recipient address, where each address maps to a single slot. A
+ * 			valid recipient is only trusted while the user and config serial numbers match the values recorded when the preferences
+ * 			were loaded, and for at most magma.smtp.inbound_cache.timeout seconds, which limits how stale the storage size and filters
+ * 			can become. Unknown, non-local and locked recipients are remembered for magma.smtp.inbound_cache.negative seconds, which
+ * 			lets dictionary attacks be rejected without touching the database. Server errors are never cached.
+ */
+
+#include "magma.h"
+
+struct {
+	slotted_t *table; /* The slot table, or NULL if the cache is disabled. */
+} inbound = {
+	.table = NULL
+};
+
+/**
+ * @brief	Allocate the inbound preferences cache.
+ * @note	If magma.smtp.inbound_cache.entries is set to zero, the cache is disabled and every lookup is sent to the database.
+ * @return	true on success or false on failure.
+ */
+bool_t smtp_inbound_cache_start(void) {
+
+	if (!magma.smtp.inbound_cache.entries) {
+		return true;
+	}
+	else if (!(inbound.table = slotted_alloc(magma.smtp.inbound_cache.entries, sizeof(smtp_inbound_slot_t), false, &smtp_inbound_cache_clear))) {
+		log_critical("Could not allocate memory for the inbound preferences cache. { entries = %u }", magma.smtp.inbound_cache.entries);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Free the inbound preferences cache and all of the entries it holds.
+ * @return	This function returns no value.
+ */
+void smtp_inbound_cache_stop(void) {
+
+	slotted_t *table = inbound.table;
+
+	if (!table) {
+		return;
+	}
+
+	inbound.table = NULL;
+	slotted_free(table);
+
+	return;
+}
+
+/**
+ * @brief	Determine whether the inbound preferences cache is active.
+ * @return	true if the cache is enabled, or false if every lookup is sent to the database.
+ */
+bool_t smtp_inbound_cache_enabled(void) {
+
+	return inbound.table ? true : false;
+}
+
+/**
+ * @brief	Release the address and preferences held by an inbound preferences cache slot.
+ * @note	This is the clear function for the inbound preferences slot table, and is called with the lock protecting the slot held.
+ * @param	slot	the slot being cleared.
+ * @return	This function returns no value.
+ */
+void smtp_inbound_cache_clear(smtp_inbound_slot_t *slot) {
+
+	st_cleanup(slot->key);
+
+	if (slot->prefs) {
+		smtp_free_inbound(slot->prefs);
+	}
+
+	return;
+}
+
+/**
+ * @brief	Calculate the hash which selects the inbound preferences cache slot for a recipient address.
+ * @param	address		a managed string containing the sanitized recipient address.
+ * @return	the hash of the address.
+ */
+uint64_t smtp_inbound_cache_hash(stringer_t *address) {
+
+	return hash_murmur64(st_data_get(address), st_length_get(address));
+}
+
+/**
+ * @brief	Retrieve the cached result of an inbound preferences lookup.
+ * @note	Cached preferences are discarded if the user or config serial numbers have changed since they were loaded.
+ * @param	address		a managed string containing the sanitized recipient address.
+ * @param	state		a pointer which will receive the value smtp_fetch_inbound() returned for the address.
+ * @param	output		a pointer which will receive a copy of the cached preferences, or NULL if the address was rejected.
+ * @return	true if the address was found in the cache, or false if the preferences must be loaded from the database.
+ */
+bool_t smtp_inbound_cache_get(stringer_t *address, int_t *state, smtp_inbound_prefs_t **output) {
+
+	bool_t found = false;
+	uint64_t usernum = 0, user = 0, config = 0;
+	smtp_inbound_prefs_t *copy = NULL;
+	smtp_inbound_slot_t *slot;
+	uint64_t hash;
+
+	if (!inbound.table || st_empty(address) || !state || !output) {
+		return false;
+	}
+
+	hash = smtp_inbound_cache_hash(address);
+	slot = slotted_lock(inbound.table, hash);
+
+	if (slot->key && slot->expiration > time(NULL) && !st_cmp_cs_eq(slot->key, address) && (!slot->prefs || (copy = smtp_dupe_inbound(slot->prefs)))) {
+		*state = slot->state;
+		usernum = copy ? copy->usernum : 0;
+		user = slot->user;
+		config = slot->config;
+		found = true;
+	}
+
+	slotted_unlock(inbound.table, hash);
+
+	if (!found) {
+		stats_increment_by_name("smtp.inbound.cache.misses");
+		return false;
+	}
+
+	// The serial numbers are checked after the lock is released, since checking them may require a request to the cache servers.
+	if (copy) {
+
+		serial_prefetch(usernum);
+
+		if (serial_get(OBJECT_USER, usernum) != user || serial_get(OBJECT_CONFIG, usernum) != config) {
+			smtp_free_inbound(copy);
+			smtp_inbound_cache_delete(address);
+			stats_increment_by_name("smtp.inbound.cache.misses");
+			return false;
+		}
+	}
+
+	*output = copy;
+	stats_increment_by_name(copy ? "smtp.inbound.cache.hits" : "smtp.inbound.cache.rejected");
+
+	return true;
+}
+
+/**
+ * @brief	Store the result of an inbound preferences lookup.
+ * @note	Server errors aren't cached. A copy of the preferences is stored, so the caller retains ownership of the original.
+ * @param	address		a managed string containing the sanitized recipient address.
+ * @param	state		the value returned by smtp_fetch_inbound() for the address.
+ * @param	prefs		the preferences loaded for the address, or NULL if the address was rejected.
+ * @return	This function returns no value.
+ */
+void smtp_inbound_cache_set(stringer_t *address, int_t state, smtp_inbound_prefs_t *prefs) {
+
+	time_t expiration;
+	uint64_t user = 0, config = 0;
+	stringer_t *key;
+	smtp_inbound_prefs_t *copy = NULL;
+	smtp_inbound_slot_t *slot;
+	uint64_t hash;
+
+	if (!inbound.table || st_empty(address) || state == -3 || (state == 0 && !prefs)) {
+		return;
+	}
+	else if (prefs) {
+
+		// The serial numbers are recorded before the copy is stored, so any later change invalidates the entry.
+		serial_prefetch(prefs->usernum);
+		user = serial_get(OBJECT_USER, prefs->usernum);
+		config = serial_get(OBJECT_CONFIG, prefs->usernum);
+		expiration = time(NULL) + magma.smtp.inbound_cache.timeout;
+
+		if (!magma.smtp.inbound_cache.timeout || !(copy = smtp_dupe_inbound(prefs))) {
+			return;
+		}
+	}
+	else if (!magma.smtp.inbound_cache.negative) {
+		return;
+	}
+	else {
+		expiration = time(NULL) + magma.smtp.inbound_cache.negative;
+	}
+
+	if (!(key = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, address))) {
+		log_pedantic("Unable to copy the %.*s recipient into the inbound preferences cache.", st_length_int(address), st_char_get(address));
+		if (copy) smtp_free_inbound(copy);
+		return;
+	}
+
+	hash = smtp_inbound_cache_hash(address);
+	slot = slotted_lock(inbound.table, hash);
+	slotted_clear(inbound.table, slot);
+	slot->key = key;
+	slot->state = state;
+	slot->expiration = expiration;
+	slot->user = user;
+	slot->config = config;
+	slot->prefs = copy;
+	slotted_unlock(inbound.table, hash);
+
+	return;
+}
+
+/**
+ * @brief	Remove a recipient address from the inbound preferences cache, so the next lookup is sent to the database.
+ * @param	address		a managed string containing the sanitized recipient address.
+ * @return	This function returns no value.
+ */
+void smtp_inbound_cache_delete(stringer_t *address) {
+
+	smtp_inbound_slot_t *slot;
+	uint64_t hash;
+
+	if (!inbound.table || st_empty(address)) {
+		return;
+	}
+
+	hash = smtp_inbound_cache_hash(address);
+	slot = slotted_lock(inbound.table, hash);
+
+	if (slot->key && !st_cmp_cs_eq(slot->key, address)) {
+		slotted_clear(inbound.table, slot);
+	}
+
+	slotted_unlock(inbound.table, hash);
+
+	return;
+}
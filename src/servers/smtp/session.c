@@ -241,6 +241,104 @@ void smtp_free_inbound(smtp_inbound_prefs_t *inbound) {
 	return;
 }
 
+/**
+ * @brief	Create a deep copy of a single SMTP inbound filter.
+ * @param	filter		a pointer to the SMTP inbound filter to be copied.
+ * @return	NULL on failure, or a pointer to the newly allocated copy of the filter on success.
+ */
+smtp_inbound_filter_t * smtp_dupe_filter(smtp_inbound_filter_t *filter) {
+
+	smtp_inbound_filter_t *result;
+
+	if (!filter || !(result = mm_alloc(sizeof(smtp_inbound_filter_t)))) {
+		log_pedantic("Unable to duplicate the inbound filter.");
+		return NULL;
+	}
+
+	mm_copy(result, filter, sizeof(smtp_inbound_filter_t));
+	result->field = result->label = result->expression = NULL;
+
+	if ((filter->field && !(result->field = st_dupe(filter->field))) || (filter->label && !(result->label = st_dupe(filter->label))) ||
+		(filter->expression && !(result->expression = st_dupe(filter->expression)))) {
+		log_pedantic("Unable to duplicate the inbound filter strings. { rulenum = %lu }", filter->rulenum);
+		smtp_list_free_filter(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief	Create a deep copy of a set of SMTP inbound mail preferences.
+ * @note	Only the preferences object passed in is copied, the copy is never linked to the other recipients in the list.
+ * @param	inbound		a pointer to the SMTP inbound mail preferences to be copied.
+ * @return	NULL on failure, or a pointer to the newly allocated copy of the inbound preferences on success.
+ */
+smtp_inbound_prefs_t * smtp_dupe_inbound(smtp_inbound_prefs_t *inbound) {
+
+	multi_t key;
+	inx_cursor_t *cursor;
+	stringer_t *signet = NULL;
+	smtp_inbound_filter_t *filter, *copy;
+	smtp_inbound_prefs_t *result;
+
+	if (!inbound || !(result = mm_alloc(sizeof(smtp_inbound_prefs_t)))) {
+		log_pedantic("Unable to duplicate the inbound preferences.");
+		return NULL;
+	}
+
+	mm_copy(result, inbound, sizeof(smtp_inbound_prefs_t));
+	result->rcptto = result->address = result->domain = result->forwarded = result->spamsig = NULL;
+	result->signet = NULL;
+	result->filters = NULL;
+	result->next = NULL;
+
+	if ((inbound->rcptto && !(result->rcptto = st_dupe(inbound->rcptto))) ||
+		(inbound->address && !(result->address = st_dupe_opts(MANAGED_T | CONTIGUOUS | HEAP, inbound->address))) ||
+		(inbound->domain && !(result->domain = st_dupe(inbound->domain))) ||
+		(inbound->forwarded && !(result->forwarded = st_dupe(inbound->forwarded))) ||
+		(inbound->spamsig && !(result->spamsig = st_dupe(inbound->spamsig)))) {
+		log_pedantic("Unable to duplicate the inbound preference strings. { usernum = %lu }", inbound->usernum);
+		smtp_free_inbound(result);
+		return NULL;
+	}
+
+	// The signet is copied using its serialized form.
+	if (inbound->signet && (!(signet = prime_get(inbound->signet, BINARY, NULL)) || !(result->signet = prime_set(signet, BINARY, NONE)))) {
+		log_pedantic("Unable to duplicate the inbound signet. { usernum = %lu }", inbound->usernum);
+		st_cleanup(signet);
+		smtp_free_inbound(result);
+		return NULL;
+	}
+
+	st_cleanup(signet);
+
+	if (inbound->filters) {
+
+		if (!(result->filters = inx_alloc(M_INX_LINKED, &smtp_list_free_filter)) || !(cursor = inx_cursor_alloc(inbound->filters))) {
+			log_pedantic("Unable to duplicate the inbound filters. { usernum = %lu }", inbound->usernum);
+			smtp_free_inbound(result);
+			return NULL;
+		}
+
+		while ((filter = inx_cursor_value_next(cursor))) {
+
+			key = inx_cursor_key_active(cursor);
+
+			if (!(copy = smtp_dupe_filter(filter)) || !inx_insert(result->filters, key, copy)) {
+				if (copy) smtp_list_free_filter(copy);
+				inx_cursor_free(cursor);
+				smtp_free_inbound(result);
+				return NULL;
+			}
+		}
+
+		inx_cursor_free(cursor);
+	}
+
+	return result;
+}
+
 /**
  * @brief	Free an SMTP inbound filter and its underlying data.
  * @param	filter		a pointer to the SMTP inbound filter to be destroyed.
@@ -35,6 +35,7 @@ void smtp_starttls(connection_t *con) {
 		return;
 	}
 
+	con_offload(con);
 	stats_increment_by_name("smtp.connections.secure");
 	st_length_set(con->network.buffer, 0);
 	con->network.line = pl_null();
@@ -1103,12 +1104,12 @@ void smtp_data_inbound(connection_t *con) {
 	smtp_inbound_prefs_t *current;
 	uint32_t perm_errors = 0, temp_errors = 0, delivered = 0, bounces = 0;
 
+	// Deliver the message, which records the outcome for each recipient.
+	smtp_fanout_deliver(con);
+
 	current = con->smtp.in_prefs;
 	while (current != NULL) {
 
-		// Process the message.
-		current->outcome = smtp_accept_message(con, current);
-
 		// Track the outcomes.
 		if (current->outcome == SMTP_OUTCOME_PERM_FAILURE) {
 			perm_errors++;
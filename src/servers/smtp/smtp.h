@@ -28,6 +28,24 @@ int_t   smtp_compare(const void *compare, const void *command);
 void    smtp_process(connection_t *con);
 void    smtp_sort(void);
 
+/// counters.c
+bool_t            smtp_counter_add(int_t kind, uint64_t usernum, stringer_t *subnet, uint64_t count, uint64_t rows, uint64_t messages, uint64_t bounces);
+smtp_counter_t *  smtp_counter_alloc(int_t kind, uint64_t usernum, stringer_t *subnet, stringer_t *key);
+void              smtp_counter_apply(smtp_counter_t *counter, uint64_t hour, uint64_t counts[SMTP_COUNTER_HOURS]);
+smtp_counter_t *  smtp_counter_find(int_t kind, uint64_t usernum, stringer_t *subnet, pthread_mutex_t **lock);
+void              smtp_counter_free(smtp_counter_t *counter);
+bool_t            smtp_counter_get(int_t kind, uint64_t usernum, stringer_t *subnet, uint64_t *total);
+uint64_t          smtp_counter_hour(void);
+bool_t            smtp_counter_load(stringer_t *key, uint64_t hour, uint64_t counts[SMTP_COUNTER_HOURS]);
+bool_t            smtp_counters_enabled(void);
+void              smtp_counters_flush(void);
+void              smtp_counters_flusher(void);
+void              smtp_counters_restore(int_t table, smtp_counter_work_t *work, pthread_mutex_t *lock);
+bool_t            smtp_counters_start(void);
+void              smtp_counters_stop(void);
+uint64_t          smtp_counters_tuple(int_t table, smtp_counter_work_t *work, stringer_t *output);
+void              smtp_counters_write(int_t table, smtp_counter_work_t *work, size_t items, pthread_mutex_t *lock);
+
 /// datatier.c
 int_t         smtp_check_authorized_from(uint64_t usernum, stringer_t *address);
 int_t         smtp_check_receive_quota(connection_t *con, smtp_inbound_prefs_t *prefs);
@@ -35,12 +53,20 @@ int_t         smtp_check_transmit_quota(uint64_t usernum, size_t num_recipients,
 int_t         smtp_fetch_authorization(stringer_t *username, stringer_t *verification, smtp_outbound_prefs_t **output);
 stringer_t *  smtp_fetch_autoreply(uint64_t autoreply, uint64_t usernum);
 int_t         smtp_fetch_inbound(stringer_t *address, smtp_inbound_prefs_t **output);
+int_t         smtp_fetch_inbound_data(stringer_t *address, smtp_inbound_prefs_t **output);
 table_t *     smtp_fetch_rollmessages(uint64_t usernum);
 int_t         smtp_get_action(chr_t *string, size_t length);
 uint64_t      smtp_insert_spamsig(smtp_inbound_prefs_t *prefs, uint64_t key, int_t code);
 void          smtp_update_receive_stats(connection_t *con, smtp_inbound_prefs_t *prefs);
 void          smtp_update_transmission_stats(connection_t *con);
 
+/// fanout.c
+void        smtp_fanout_deliver(connection_t *con);
+void        smtp_fanout_prepare(connection_t *con);
+void        smtp_fanout_release(smtp_fanout_t *fanout);
+uint32_t    smtp_fanout_run(smtp_fanout_t *fanout, bool_t helper);
+void        smtp_fanout_worker(smtp_fanout_t *fanout);
+
 /// smtp.c
 void   smtp_auth_login(connection_t *con);
 void   smtp_auth_plain(connection_t *con);
@@ -59,6 +85,16 @@ void   smtp_rset(connection_t *con);
 void   smtp_starttls(connection_t *con);
 void   submission_init(connection_t *con);
 
+/// inbound.c
+void                    smtp_inbound_cache_clear(smtp_inbound_slot_t *slot);
+void                    smtp_inbound_cache_delete(stringer_t *address);
+bool_t                  smtp_inbound_cache_enabled(void);
+bool_t                  smtp_inbound_cache_get(stringer_t *address, int_t *state, smtp_inbound_prefs_t **output);
+uint64_t                smtp_inbound_cache_hash(stringer_t *address);
+void                    smtp_inbound_cache_set(stringer_t *address, int_t state, smtp_inbound_prefs_t *prefs);
+bool_t                  smtp_inbound_cache_start(void);
+void                    smtp_inbound_cache_stop(void);
+
 /// parse.c
 stringer_t *  smtp_parse_auth(stringer_t *data);
 stringer_t *  smtp_parse_helo_domain(connection_t *con);
@@ -79,6 +115,8 @@ void    smtp_add_inbound(connection_t *con, smtp_inbound_prefs_t *inbound);
 void    smtp_add_outbound(connection_t *con, smtp_outbound_prefs_t *outbound);
 bool_t   smtp_add_recipient(connection_t *con, stringer_t *address);
 bool_t   smtp_check_duplicate_recipient(connection_t *con, uint64_t usernum);
+smtp_inbound_filter_t *  smtp_dupe_filter(smtp_inbound_filter_t *filter);
+smtp_inbound_prefs_t *   smtp_dupe_inbound(smtp_inbound_prefs_t *inbound);
 void    smtp_free_inbound(smtp_inbound_prefs_t *inbound);
 void    smtp_free_outbound(smtp_outbound_prefs_t *outbound);
 void    smtp_free_recipients(smtp_recipients_t *recipients);
@@ -1321,13 +1321,13 @@ void portal_endpoint_messages_flag(connection_t *con) {
 			// Update the database first.
 			switch (action) {
 			case (PORTAL_ENDPOINT_ACTION_ADD):
-				meta_data_flags_add(list, con->http.session->user->usernum, folder, bits);
+				meta_data_flags_add(list, con->http.session->user->usernum, folder, bits, NULL);
 				break;
 			case (PORTAL_ENDPOINT_ACTION_REMOVE):
-				meta_data_flags_remove(list, con->http.session->user->usernum, folder, bits);
+				meta_data_flags_remove(list, con->http.session->user->usernum, folder, bits, NULL);
 				break;
 			case (PORTAL_ENDPOINT_ACTION_REPLACE):
-				meta_data_flags_replace(list, con->http.session->user->usernum, folder, bits);
+				meta_data_flags_replace(list, con->http.session->user->usernum, folder, bits, NULL);
 				break;
 			}
 
@@ -1737,12 +1737,12 @@ void portal_endpoint_messages_tag(connection_t *con) {
 
 			/// LOW: We don't need to add the flag to every message. Just the ones that don't already have the flag.
 			if (action == PORTAL_ENDPOINT_ACTION_ADD || (action == PORTAL_ENDPOINT_ACTION_REPLACE && tag_count)) {
-				meta_data_flags_add(list, con->http.session->user->usernum, folder, MAIL_STATUS_TAGGED);
+				meta_data_flags_add(list, con->http.session->user->usernum, folder, MAIL_STATUS_TAGGED, NULL);
 			}
 			/// LOW: Like the line, were not checking whether the message even needs to have the flag removed. Were also not handling remove requests that result in a message having no tags.
 			// If were replacing the tags, and the replacement set of flags is empty, we can remove the flag.
 			else if (action == PORTAL_ENDPOINT_ACTION_REPLACE && !tag_count) {
-				meta_data_flags_remove(list, con->http.session->user->usernum, folder, MAIL_STATUS_TAGGED);
+				meta_data_flags_remove(list, con->http.session->user->usernum, folder, MAIL_STATUS_TAGGED, NULL);
 			}
 
 			while ((active = inx_cursor_value_next(cursor))) {